@@ -1,5 +1,7 @@
 # main cpp
 list(APPEND of_main_cc ${PROJECT_SOURCE_DIR}/oneflow/core/job/oneflow_worker.cpp)
+# standalone tools, not linked into oneflow_internal
+list(APPEND of_tool_cc ${PROJECT_SOURCE_DIR}/oneflow/core/record/ofrecord_index_tool.cpp)
 
 function(oneflow_add_executable)
   if (BUILD_CUDA)
@@ -46,7 +48,7 @@ endforeach()
 
 file(GLOB_RECURSE oneflow_all_src "${PROJECT_SOURCE_DIR}/oneflow/core/*.*" "${PROJECT_SOURCE_DIR}/oneflow/python/*.*"
  "${PROJECT_SOURCE_DIR}/oneflow/customized/*.*")
-if (WITH_XLA OR WITH_TENSORRT)
+if (WITH_XLA OR WITH_TENSORRT OR WITH_XRT_NATIVE)
   file(GLOB_RECURSE oneflow_xrt_src "${PROJECT_SOURCE_DIR}/oneflow/xrt/*.*")
   if (NOT WITH_XLA)
     file(GLOB_RECURSE xla_removing_src "${PROJECT_SOURCE_DIR}/oneflow/xrt/xla/*.*")
@@ -54,9 +56,13 @@ if (WITH_XLA OR WITH_TENSORRT)
   if (NOT WITH_TENSORRT)
     file(GLOB_RECURSE trt_removing_src "${PROJECT_SOURCE_DIR}/oneflow/xrt/tensorrt/*.*")
   endif ()
+  if (NOT WITH_XRT_NATIVE)
+    file(GLOB_RECURSE native_removing_src "${PROJECT_SOURCE_DIR}/oneflow/xrt/native/*.*")
+  endif ()
 
   list(APPEND xrt_removing_srcs ${xla_removing_src})
   list(APPEND xrt_removing_srcs ${trt_removing_src})
+  list(APPEND xrt_removing_srcs ${native_removing_src})
   # message(STATUS "removing_srcs: ${xrt_removing_srcs}")
   foreach (removing_file ${xrt_removing_srcs})
     list(REMOVE_ITEM oneflow_xrt_src ${removing_file})
@@ -126,7 +132,8 @@ foreach(oneflow_single_file ${oneflow_all_src})
     else()
       # not test file
       list(FIND of_main_cc ${oneflow_single_file} main_found)
-      if(${main_found} EQUAL -1) # not main entry
+      list(FIND of_tool_cc ${oneflow_single_file} tool_found)
+      if(${main_found} EQUAL -1 AND ${tool_found} EQUAL -1) # not main entry
         list(APPEND of_all_obj_cc ${oneflow_single_file})
       endif()
     endif()
@@ -332,6 +339,14 @@ foreach(cc ${of_main_cc})
   set_target_properties(${main_name} PROPERTIES RUNTIME_OUTPUT_DIRECTORY "${PROJECT_BINARY_DIR}/bin")
 endforeach()
 
+# build tools
+foreach(cc ${of_tool_cc})
+  get_filename_component(tool_name ${cc} NAME_WE)
+  oneflow_add_executable(${tool_name} ${cc})
+  target_link_libraries(${tool_name} ${of_libs} ${oneflow_third_party_libs})
+  set_target_properties(${tool_name} PROPERTIES RUNTIME_OUTPUT_DIRECTORY "${PROJECT_BINARY_DIR}/bin")
+endforeach()
+
 # build test
 if(BUILD_TESTING)
   if(NOT BUILD_CUDA)
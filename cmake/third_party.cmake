@@ -20,10 +20,11 @@ if (WITH_XLA)
   include(tensorflow)
 endif()
 
+if ((WITH_TENSORRT OR WITH_XRT_NATIVE) AND NOT WITH_XLA)
+  include(absl)
+endif()
+
 if (WITH_TENSORRT)
-  if (NOT WITH_XLA)
-    include(absl)
-  endif()
   include(tensorrt)
 endif()
 
@@ -209,10 +210,11 @@ if(WITH_XLA)
   list(APPEND oneflow_third_party_libs ${TENSORFLOW_XLA_LIBRARIES})
 endif()
 
+if((WITH_TENSORRT OR WITH_XRT_NATIVE) AND NOT WITH_XLA)
+  list(APPEND oneflow_third_party_libs ${ABSL_LIBRARIES})
+endif()
+
 if(WITH_TENSORRT)
-  if (NOT WITH_XLA)
-    list(APPEND oneflow_third_party_libs ${ABSL_LIBRARIES})
-  endif()
   list(APPEND oneflow_third_party_libs ${TENSORRT_LIBRARIES})
 endif()
 
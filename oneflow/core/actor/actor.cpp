@@ -59,6 +59,31 @@ void Actor::Init(const JobDesc* job_desc, const TaskProto& task_proto,
     ExecKernel ek;
     ek.kernel = ConstructKernel(job_desc_, node.kernel_conf(), device_ctx_.get());
     ek.bn_in_op2regst_desc_id = PbMap2HashMap(node.bn_in_op2regst_desc_id());
+    const auto& bn_in_op2lbi = ek.kernel->op_attribute().arg_signature().bn_in_op2lbi();
+    HashMap<int64_t, int64_t> regst_desc_id2regst_idx;
+    for (const auto& pair : ek.bn_in_op2regst_desc_id) {
+      auto regst_idx_it = regst_desc_id2regst_idx.find(pair.second);
+      if (regst_idx_it == regst_desc_id2regst_idx.end()) {
+        regst_idx_it = regst_desc_id2regst_idx.emplace(pair.second, ek.regst_desc_ids.size()).first;
+        ek.regst_desc_ids.push_back(pair.second);
+      }
+      BlobBinding binding;
+      binding.regst_idx = regst_idx_it->second;
+      auto lbi_it = bn_in_op2lbi.find(pair.first);
+      binding.lbi = lbi_it == bn_in_op2lbi.end() ? nullptr : &lbi_it->second;
+      binding.is_blob_index_resolved = false;
+      binding.blob_index = -1;
+      if (binding.lbi != nullptr && Global<RegstMgr>::Get()->HasRegstDescId(pair.second)) {
+        binding.blob_index = Global<RegstMgr>::Get()
+                                 ->RegstDesc4RegstDescId(pair.second)
+                                 .GetBlobIndexFromLbi(*binding.lbi);
+        binding.is_blob_index_resolved = true;
+      }
+      binding.blob = nullptr;
+      ek.bn_in_op2blob_binding_idx.emplace(pair.first, ek.blob_bindings.size());
+      ek.blob_bindings.push_back(binding);
+    }
+    ek.regsts.assign(ek.regst_desc_ids.size(), nullptr);
     exec_kernel_vec_.push_back(std::move(ek));
   }
 
@@ -352,7 +377,8 @@ int Actor::HandlerZombie(const ActorMsg& msg) {
 }
 
 void Actor::TryLogActEvent(const std::function<void()>& DoAct) const {
-  if (Global<RuntimeCtx>::Get()->is_experiment_phase() || NeedCollectActEvent()) {
+  if (Global<RuntimeCtx>::Get()->is_experiment_phase() || NeedCollectActEvent()
+      || Global<RuntimeCtx>::Get()->NeedCollectActEvent4OnlineTuning(act_id_)) {
     auto act_event = std::make_shared<ActEvent>();
     act_event->set_is_experiment_phase(Global<RuntimeCtx>::Get()->is_experiment_phase());
     act_event->set_actor_id(actor_id());
@@ -511,16 +537,38 @@ bool Actor::IsWriteReady() const {
 
 void Actor::AsyncLaunchKernel(const KernelCtx& kernel_ctx,
                               std::function<Regst*(int64_t)> Regst4RegstDescId) {
-  for (const ExecKernel& ek : exec_kernel_vec_) {
+  for (ExecKernel& ek : exec_kernel_vec_) {
+    for (BlobBinding& binding : ek.blob_bindings) { binding.blob = nullptr; }
+    std::fill(ek.regsts.begin(), ek.regsts.end(), nullptr);
+    // the Kernel interface names blobs by bn, the one hash lookup left maps it to its binding
     ek.kernel->Launch(kernel_ctx, [&](const std::string& bn_in_op) -> Blob* {
-      auto regst_desc_id_it = ek.bn_in_op2regst_desc_id.find(bn_in_op);
-      if (regst_desc_id_it == ek.bn_in_op2regst_desc_id.end()) { return nullptr; }
-      Regst* regst = GetNaiveOrInplaceCurWriteable(regst_desc_id_it->second);
-      if (regst == nullptr) { regst = GetNaiveOrInplaceCurReadable(regst_desc_id_it->second); }
-      if (regst == nullptr) { regst = Regst4RegstDescId(regst_desc_id_it->second); }
-      if (regst == nullptr) { return nullptr; }
-      const LogicalBlobId& lbi = ek.kernel->BnInOp2Lbi(bn_in_op);
-      return regst->GetBlobByLbi(lbi);
+      auto binding_idx_it = ek.bn_in_op2blob_binding_idx.find(bn_in_op);
+      if (binding_idx_it == ek.bn_in_op2blob_binding_idx.end()) { return nullptr; }
+      BlobBinding& binding = ek.blob_bindings[binding_idx_it->second];
+      if (binding.blob != nullptr) { return binding.blob; }
+      Regst*& regst = ek.regsts[binding.regst_idx];
+      if (regst == nullptr) {
+        const int64_t regst_desc_id = ek.regst_desc_ids[binding.regst_idx];
+        regst = GetNaiveOrInplaceCurWriteable(regst_desc_id);
+        if (regst == nullptr) { regst = GetNaiveOrInplaceCurReadable(regst_desc_id); }
+        if (regst == nullptr) { regst = Regst4RegstDescId(regst_desc_id); }
+        if (regst == nullptr) { return nullptr; }
+      }
+      if (!binding.is_blob_index_resolved) {
+        const LogicalBlobId& lbi =
+            binding.lbi == nullptr ? ek.kernel->BnInOp2Lbi(bn_in_op) : *binding.lbi;
+        binding.blob_index = regst->regst_desc()->GetBlobIndexFromLbi(lbi);
+        binding.is_blob_index_resolved = true;
+      }
+      if (binding.blob_index == -1) {
+        // packed or foreign lbi, rare enough to go through the hash map
+        const LogicalBlobId& lbi =
+            binding.lbi == nullptr ? ek.kernel->BnInOp2Lbi(bn_in_op) : *binding.lbi;
+        binding.blob = regst->GetBlobByLbi(lbi);
+      } else {
+        binding.blob = regst->GetBlobByIndex(binding.blob_index);
+      }
+      return binding.blob;
     });
   }
 }
@@ -53,9 +53,29 @@ class Actor {
   int64_t actor_id() const { return actor_id_; }
 
  protected:
+  // Where the blob of one bn_in_op lives, compiled in Init so that launching a kernel only maps
+  // the bn to its binding and indexes into vectors from there
+  struct BlobBinding {
+    // into ExecKernel::regst_desc_ids
+    int64_t regst_idx;
+    // nullptr if the bn has no lbi, BnInOp2Lbi reports it on use
+    const LogicalBlobId* lbi;
+    // from RtRegstDesc::GetBlobIndexFromLbi, in Init if the regst desc is known by then and on
+    // first use otherwise
+    bool is_blob_index_resolved;
+    int64_t blob_index;
+    // valid during one AsyncLaunchKernel only
+    Blob* blob;
+  };
   struct ExecKernel {
     std::unique_ptr<const Kernel> kernel;
     HashMap<std::string, int64_t> bn_in_op2regst_desc_id;
+    HashMap<std::string, int64_t> bn_in_op2blob_binding_idx;
+    std::vector<BlobBinding> blob_bindings;
+    // the distinct regsts of blob_bindings, looked up once per AsyncLaunchKernel
+    std::vector<int64_t> regst_desc_ids;
+    // valid during one AsyncLaunchKernel only
+    std::vector<Regst*> regsts;
   };
   using MsgHandler = int (Actor::*)(const ActorMsg&);
   enum class RegstNameType { kNaive = 0, kCustomized };
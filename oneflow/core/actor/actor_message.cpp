@@ -47,8 +47,10 @@ ActorMsg ActorMsg::BuildRegstMsgToConsumer(int64_t producer, int64_t consumer,
   if (Global<IDMgr>::Get()->MachineId4ActorId(consumer)
       == Global<MachineCtx>::Get()->this_machine_id()) {
     msg.regst_wrapper_.comm_net_token = nullptr;
+    msg.regst_wrapper_.comm_net_valid_byte_size = 0;
   } else {
     msg.regst_wrapper_.comm_net_token = regst_raw_ptr->comm_net_token();
+    msg.regst_wrapper_.comm_net_valid_byte_size = regst_raw_ptr->CommNetValidByteSize();
   }
   msg.regst_wrapper_.regst_status = regst_raw_ptr->status();
   msg.regst_wrapper_.has_sole_empty_tensor_in_sole_tensor_list =
@@ -64,6 +66,7 @@ ActorMsg ActorMsg::BuildRegstMsgToProducer(int64_t consumer, int64_t producer,
   msg.msg_type_ = ActorMsgType::kRegstMsg;
   msg.regst_wrapper_.regst = regst_raw_ptr;
   msg.regst_wrapper_.comm_net_token = nullptr;
+  msg.regst_wrapper_.comm_net_valid_byte_size = 0;
   // you can NOT access the regst ptr when multi nodes, because the address is in another machine
   msg.regst_wrapper_.has_sole_empty_tensor_in_sole_tensor_list = false;
   return msg;
@@ -131,6 +134,11 @@ bool ActorMsg::has_sole_empty_tensor_in_sole_tensor_list() const {
   return regst_wrapper_.has_sole_empty_tensor_in_sole_tensor_list;
 }
 
+size_t ActorMsg::comm_net_valid_byte_size() const {
+  CHECK_EQ(msg_type_, ActorMsgType::kRegstMsg);
+  return regst_wrapper_.comm_net_valid_byte_size;
+}
+
 int64_t ActorMsg::eord_regst_desc_id() const {
   CHECK_EQ(msg_type_, ActorMsgType::kEordMsg);
   return eord_regst_desc_id_;
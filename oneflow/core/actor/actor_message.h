@@ -55,6 +55,7 @@ class ActorMsg final {
   int64_t act_id() const;
   void* comm_net_token() const;
   bool has_sole_empty_tensor_in_sole_tensor_list() const;
+  size_t comm_net_valid_byte_size() const;
   int64_t eord_regst_desc_id() const;
 
   // Serialize
@@ -73,6 +74,7 @@ class ActorMsg final {
     void* comm_net_token;
     RegstStatus regst_status;
     bool has_sole_empty_tensor_in_sole_tensor_list;
+    size_t comm_net_valid_byte_size;
   };
 
   int64_t src_actor_id_;
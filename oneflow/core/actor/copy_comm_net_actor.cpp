@@ -72,6 +72,7 @@ bool CopyCommNetActor::NormalTryProcessReadableMsgFromOtherMachine(const ActorMs
   regst_ctx.act_id = msg.act_id();
   regst_ctx.has_sole_empty_tensor_in_sole_tensor_list =
       msg.has_sole_empty_tensor_in_sole_tensor_list();
+  regst_ctx.comm_net_valid_byte_size = msg.comm_net_valid_byte_size();
   CHECK(piece_id2regst_ctx_.emplace(msg.piece_id(), regst_ctx).second);
   return true;
 }
@@ -95,8 +96,14 @@ void CopyCommNetActor::Act() {
     tensor_view->set_shape(empty_shape);
   } else {
     void* writeable_token = writeable_regst->comm_net_token();
+    const size_t valid_byte_size = readable_it->second.comm_net_valid_byte_size;
     // Async
-    Global<CommNet>::Get()->Read(actor_read_id_, src_machine_id, readable_token, writeable_token);
+    Global<CommNet>::Get()->Read(actor_read_id_, src_machine_id, readable_token, writeable_token,
+                                 valid_byte_size);
+    // the received headers must describe exactly the bytes that were transferred
+    comm_net_device_ctx_->AddCallBack([writeable_regst, valid_byte_size]() {
+      CHECK_EQ(writeable_regst->CommNetValidByteSize(), valid_byte_size);
+    });
   }
 }
 
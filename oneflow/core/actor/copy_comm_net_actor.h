@@ -34,6 +34,7 @@ class CopyCommNetActor final : public Actor {
     int64_t producer;
     int64_t act_id;
     bool has_sole_empty_tensor_in_sole_tensor_list;
+    size_t comm_net_valid_byte_size;
   };
 
   void VirtualActorInit(const TaskProto&) override;
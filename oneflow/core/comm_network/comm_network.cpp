@@ -30,12 +30,13 @@ void CommNet::DeleteActorReadId(void* actor_read_id) {
   delete actor_read_ctx;
 }
 
-void CommNet::Read(void* actor_read_id, int64_t src_machine_id, void* src_token, void* dst_token) {
+void CommNet::Read(void* actor_read_id, int64_t src_machine_id, void* src_token, void* dst_token,
+                   size_t byte_size) {
   auto actor_read_ctx = static_cast<ActorReadContext*>(actor_read_id);
   ReadContext* read_ctx = new ReadContext;
   read_ctx->actor_read_ctx = actor_read_ctx;
-  auto do_read = [this, read_ctx, src_machine_id, src_token, dst_token]() {
-    DoRead(read_ctx, src_machine_id, src_token, dst_token);
+  auto do_read = [this, read_ctx, src_machine_id, src_token, dst_token, byte_size]() {
+    DoRead(read_ctx, src_machine_id, src_token, dst_token, byte_size);
   };
   AddWorkToStream(actor_read_id, do_read, true);
 }
@@ -42,11 +42,16 @@ class CommNet {
   virtual void* RegisterMemory(void* ptr, size_t byte_size) = 0;
   virtual void UnRegisterMemory(void* token) = 0;
   virtual void RegisterMemoryDone() = 0;
+  // the codec used when the registered memory is the source of a "Read", the first
+  // "raw_prefix_byte_size" bytes (blob headers) are never transformed lossily
+  virtual void SetMemoryCodec(void* token, CommNetCodec codec, size_t raw_prefix_byte_size) {}
 
   // Stream
   void* NewActorReadId();
   void DeleteActorReadId(void* actor_read_id);
-  void Read(void* actor_read_id, int64_t src_machine_id, void* src_token, void* dst_token);
+  // only the first "byte_size" bytes of the registered memory are transferred
+  void Read(void* actor_read_id, int64_t src_machine_id, void* src_token, void* dst_token,
+            size_t byte_size);
   void AddReadCallBack(void* actor_read_id, std::function<void()> callback);
   void ReadDone(void* read_id);
 
@@ -56,7 +61,8 @@ class CommNet {
  protected:
   CommNet(const Plan& plan);
 
-  virtual void DoRead(void* read_id, int64_t src_machine_id, void* src_token, void* dst_token) = 0;
+  virtual void DoRead(void* read_id, int64_t src_machine_id, void* src_token, void* dst_token,
+                      size_t byte_size) = 0;
   const HashSet<int64_t>& peer_machine_id() { return peer_machine_id_; }
 
   Channel<std::function<void()>> ready_cbs_;
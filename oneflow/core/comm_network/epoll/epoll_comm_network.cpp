@@ -71,6 +71,15 @@ uint16_t PullPort(int64_t machine_id) {
   return port;
 }
 
+bool IsAnyRegstEncoded(const Plan& plan) {
+  for (const TaskProto& task : plan.task()) {
+    for (const auto& pair : task.produced_regst_desc()) {
+      if (pair.second.comm_net_codec() != CommNetCodec::kNoCommNetCodec) { return true; }
+    }
+  }
+  return false;
+}
+
 }  // namespace
 
 EpollCommNet::~EpollCommNet() {
@@ -79,6 +88,16 @@ EpollCommNet::~EpollCommNet() {
     pollers_[i]->Stop();
   }
   OF_BARRIER();
+  codec_pool_.reset();
+  if (codec_stat_.raw_byte_size > 0) {
+    const double raw_mb = codec_stat_.raw_byte_size / 1e6;
+    LOG(INFO) << "CommNet codec sent " << raw_mb << " MB as "
+              << codec_stat_.encoded_byte_size / 1e6 << " MB, encode "
+              << raw_mb / (codec_stat_.encode_time / 1e9) << " MB/s";
+  }
+  if (codec_stat_.decode_time > 0) {
+    LOG(INFO) << "CommNet codec decode time " << codec_stat_.decode_time / 1e9 << " s";
+  }
   for (IOEventPoller* poller : pollers_) { delete poller; }
   for (auto& pair : sockfd2helper_) { delete pair.second; }
 }
@@ -102,12 +121,73 @@ SocketMemDesc* EpollCommNet::NewMemDesc(void* ptr, size_t byte_size) {
   SocketMemDesc* mem_desc = new SocketMemDesc;
   mem_desc->mem_ptr = ptr;
   mem_desc->byte_size = byte_size;
+  mem_desc->codec = CommNetCodec::kNoCommNetCodec;
+  mem_desc->raw_prefix_byte_size = 0;
   return mem_desc;
 }
 
+void EpollCommNet::SetMemoryCodec(void* token, CommNetCodec codec, size_t raw_prefix_byte_size) {
+  auto mem_desc = static_cast<SocketMemDesc*>(token);
+  mem_desc->codec = codec;
+  mem_desc->raw_prefix_byte_size = raw_prefix_byte_size;
+}
+
+void EpollCommNet::SendRequestReadMsg(int64_t dst_machine_id, const SocketMsg& msg) {
+  CHECK(msg.msg_type == SocketMsgType::kRequestRead);
+  auto mem_desc = static_cast<const SocketMemDesc*>(msg.request_read_msg.src_token);
+  if (mem_desc->codec == CommNetCodec::kNoCommNetCodec || msg.request_read_msg.byte_size == 0) {
+    SendSocketMsg(dst_machine_id, msg);
+    return;
+  }
+  CHECK(codec_pool_);
+  codec_pool_->AddWork([this, dst_machine_id, msg, mem_desc]() {
+    SocketMsg encoded_msg = msg;
+    RequestReadMsg* request = &encoded_msg.request_read_msg;
+    std::unique_ptr<SocketCodec> codec = NewSocketCodec(mem_desc->codec);
+    auto encoded = std::make_unique<std::vector<char>>();
+    const double start = GetCurTime();
+    const bool is_encoded =
+        codec->Encode(static_cast<const char*>(mem_desc->mem_ptr), request->byte_size,
+                      mem_desc->raw_prefix_byte_size, encoded.get());
+    codec_stat_.encode_time += static_cast<int64_t>(GetCurTime() - start);
+    codec_stat_.raw_byte_size += request->byte_size;
+    if (is_encoded) {
+      codec_stat_.encoded_byte_size += encoded->size();
+      request->codec = mem_desc->codec;
+      request->raw_prefix_byte_size = mem_desc->raw_prefix_byte_size;
+      request->encoded_byte_size = encoded->size();
+      request->encoded = encoded.release();
+    } else {
+      codec_stat_.encoded_byte_size += request->byte_size;
+    }
+    SendSocketMsg(dst_machine_id, encoded_msg);
+  });
+}
+
+void EpollCommNet::DecodeAndReadDone(const RequestReadMsg& msg, std::vector<char>* encoded) {
+  CHECK(codec_pool_);
+  codec_pool_->AddWork([this, msg, encoded]() {
+    std::unique_ptr<std::vector<char>> encoded_guard(encoded);
+    auto mem_desc = static_cast<const SocketMemDesc*>(msg.dst_token);
+    CHECK_LE(msg.byte_size, mem_desc->byte_size);
+    const double start = GetCurTime();
+    NewSocketCodec(msg.codec)->Decode(encoded->data(), encoded->size(), msg.raw_prefix_byte_size,
+                                      static_cast<char*>(mem_desc->mem_ptr), msg.byte_size);
+    codec_stat_.decode_time += static_cast<int64_t>(GetCurTime() - start);
+    ReadDone(msg.read_id);
+  });
+}
+
 EpollCommNet::EpollCommNet(const Plan& plan) : CommNetIf(plan) {
   pollers_.resize(Global<ResourceDesc, ForSession>::Get()->CommNetWorkerNum(), nullptr);
   for (size_t i = 0; i < pollers_.size(); ++i) { pollers_[i] = new IOEventPoller; }
+  // the plan holds the regsts of all the machines, so no codec msg is ever sent or received
+  // without a codec regst in it
+  if (IsAnyRegstEncoded(plan)) { codec_pool_.reset(new ThreadPool(pollers_.size())); }
+  codec_stat_.raw_byte_size = 0;
+  codec_stat_.encoded_byte_size = 0;
+  codec_stat_.encode_time = 0;
+  codec_stat_.decode_time = 0;
   InitSockets();
   for (IOEventPoller* poller : pollers_) { poller->Start(); }
 }
@@ -186,13 +266,15 @@ SocketHelper* EpollCommNet::GetSocketHelper(int64_t machine_id) {
   return sockfd2helper_.at(sockfd);
 }
 
-void EpollCommNet::DoRead(void* read_id, int64_t src_machine_id, void* src_token, void* dst_token) {
+void EpollCommNet::DoRead(void* read_id, int64_t src_machine_id, void* src_token, void* dst_token,
+                          size_t byte_size) {
   SocketMsg msg;
   msg.msg_type = SocketMsgType::kRequestWrite;
   msg.request_write_msg.src_token = src_token;
   msg.request_write_msg.dst_machine_id = Global<MachineCtx>::Get()->this_machine_id();
   msg.request_write_msg.dst_token = dst_token;
   msg.request_write_msg.read_id = read_id;
+  msg.request_write_msg.byte_size = byte_size;
   GetSocketHelper(src_machine_id)->AsyncWrite(msg);
 }
 
@@ -19,6 +19,8 @@ limitations under the License.
 #include "oneflow/core/comm_network/comm_network.h"
 #include "oneflow/core/comm_network/epoll/socket_helper.h"
 #include "oneflow/core/comm_network/epoll/socket_memory_desc.h"
+#include "oneflow/core/comm_network/epoll/socket_codec.h"
+#include "oneflow/core/thread/thread_pool.h"
 
 #ifdef PLATFORM_POSIX
 
@@ -32,9 +34,14 @@ class EpollCommNet final : public CommNetIf<SocketMemDesc> {
   static void Init(const Plan& plan) { Global<CommNet>::SetAllocated(new EpollCommNet(plan)); }
 
   void RegisterMemoryDone() override;
+  void SetMemoryCodec(void* token, CommNetCodec codec, size_t raw_prefix_byte_size) override;
 
   void SendActorMsg(int64_t dst_machine_id, const ActorMsg& msg) override;
   void SendSocketMsg(int64_t dst_machine_id, const SocketMsg& msg);
+  // source side: encodes the requested memory on the codec threads if it has a codec
+  void SendRequestReadMsg(int64_t dst_machine_id, const SocketMsg& msg);
+  // destination side: decodes the received body on the codec threads, then finishes the read
+  void DecodeAndReadDone(const RequestReadMsg& msg, std::vector<char>* encoded);
 
  private:
   SocketMemDesc* NewMemDesc(void* ptr, size_t byte_size) override;
@@ -42,9 +49,19 @@ class EpollCommNet final : public CommNetIf<SocketMemDesc> {
   EpollCommNet(const Plan& plan);
   void InitSockets();
   SocketHelper* GetSocketHelper(int64_t machine_id);
-  void DoRead(void* read_id, int64_t src_machine_id, void* src_token, void* dst_token) override;
+  void DoRead(void* read_id, int64_t src_machine_id, void* src_token, void* dst_token,
+              size_t byte_size) override;
+
+  struct CodecStat {
+    std::atomic<int64_t> raw_byte_size;
+    std::atomic<int64_t> encoded_byte_size;
+    std::atomic<int64_t> encode_time;
+    std::atomic<int64_t> decode_time;
+  };
 
   std::vector<IOEventPoller*> pollers_;
+  std::unique_ptr<ThreadPool> codec_pool_;
+  CodecStat codec_stat_;
   std::vector<int> machine_id2sockfd_;
   HashMap<int, SocketHelper*> sockfd2helper_;
 };
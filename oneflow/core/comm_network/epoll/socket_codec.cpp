@@ -0,0 +1,101 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/comm_network/epoll/socket_codec.h"
+#include "oneflow/core/common/auto_registration_factory.h"
+#include "oneflow/core/common/data_type.h"
+#include <zlib.h>
+
+namespace oneflow {
+
+namespace {
+
+class ZlibSocketCodec final : public SocketCodec {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ZlibSocketCodec);
+  ZlibSocketCodec() = default;
+  ~ZlibSocketCodec() override = default;
+
+  bool Encode(const char* src, size_t byte_size, size_t raw_prefix_byte_size,
+              std::vector<char>* encoded) const override {
+    uLongf encoded_byte_size = compressBound(byte_size);
+    encoded->resize(encoded_byte_size);
+    CHECK_EQ(compress2(reinterpret_cast<Bytef*>(encoded->data()), &encoded_byte_size,
+                       reinterpret_cast<const Bytef*>(src), byte_size, Z_BEST_SPEED),
+             Z_OK);
+    encoded->resize(encoded_byte_size);
+    return encoded_byte_size < byte_size;
+  }
+
+  void Decode(const char* encoded, size_t encoded_byte_size, size_t raw_prefix_byte_size,
+              char* dst, size_t byte_size) const override {
+    uLongf decoded_byte_size = byte_size;
+    CHECK_EQ(uncompress(reinterpret_cast<Bytef*>(dst), &decoded_byte_size,
+                        reinterpret_cast<const Bytef*>(encoded), encoded_byte_size),
+             Z_OK);
+    CHECK_EQ(decoded_byte_size, byte_size);
+  }
+};
+
+// [raw prefix][float16 x n][raw tail shorter than one float]
+class Float16SocketCodec final : public SocketCodec {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(Float16SocketCodec);
+  Float16SocketCodec() = default;
+  ~Float16SocketCodec() override = default;
+
+  bool Encode(const char* src, size_t byte_size, size_t raw_prefix_byte_size,
+              std::vector<char>* encoded) const override {
+    const size_t prefix = std::min(raw_prefix_byte_size, byte_size);
+    const size_t elem_cnt = (byte_size - prefix) / sizeof(float);
+    const size_t tail = byte_size - prefix - elem_cnt * sizeof(float);
+    if (elem_cnt == 0) { return false; }
+    encoded->resize(prefix + elem_cnt * sizeof(float16) + tail);
+    char* dst = encoded->data();
+    std::memcpy(dst, src, prefix);
+    const float* in = reinterpret_cast<const float*>(src + prefix);
+    float16* out = reinterpret_cast<float16*>(dst + prefix);
+    FOR_RANGE(size_t, i, 0, elem_cnt) { out[i] = static_cast<float16>(in[i]); }
+    std::memcpy(dst + prefix + elem_cnt * sizeof(float16), src + prefix + elem_cnt * sizeof(float),
+                tail);
+    return true;
+  }
+
+  void Decode(const char* encoded, size_t encoded_byte_size, size_t raw_prefix_byte_size,
+              char* dst, size_t byte_size) const override {
+    const size_t prefix = std::min(raw_prefix_byte_size, byte_size);
+    const size_t elem_cnt = (byte_size - prefix) / sizeof(float);
+    const size_t tail = byte_size - prefix - elem_cnt * sizeof(float);
+    CHECK_EQ(encoded_byte_size, prefix + elem_cnt * sizeof(float16) + tail);
+    std::memcpy(dst, encoded, prefix);
+    const float16* in = reinterpret_cast<const float16*>(encoded + prefix);
+    float* out = reinterpret_cast<float*>(dst + prefix);
+    FOR_RANGE(size_t, i, 0, elem_cnt) { out[i] = static_cast<float>(in[i]); }
+    std::memcpy(dst + prefix + elem_cnt * sizeof(float),
+                encoded + prefix + elem_cnt * sizeof(float16), tail);
+  }
+};
+
+REGISTER_CLASS(CommNetCodec::kZlibCommNetCodec, SocketCodec, ZlibSocketCodec);
+REGISTER_CLASS(CommNetCodec::kFloat16CommNetCodec, SocketCodec, Float16SocketCodec);
+
+}  // namespace
+
+std::unique_ptr<SocketCodec> NewSocketCodec(CommNetCodec codec) {
+  CHECK_NE(codec, CommNetCodec::kNoCommNetCodec);
+  return std::unique_ptr<SocketCodec>(NewObj<SocketCodec>(codec));
+}
+
+}  // namespace oneflow
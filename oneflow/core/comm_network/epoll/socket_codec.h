@@ -0,0 +1,41 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMM_NETWORK_EPOLL_SOCKET_CODEC_H_
+#define ONEFLOW_CORE_COMM_NETWORK_EPOLL_SOCKET_CODEC_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/register/register_desc.pb.h"
+
+namespace oneflow {
+
+class SocketCodec {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(SocketCodec);
+  SocketCodec() = default;
+  virtual ~SocketCodec() = default;
+
+  // returns false when the encoding saves no bytes, the raw memory is sent instead
+  virtual bool Encode(const char* src, size_t byte_size, size_t raw_prefix_byte_size,
+                      std::vector<char>* encoded) const = 0;
+  virtual void Decode(const char* encoded, size_t encoded_byte_size, size_t raw_prefix_byte_size,
+                      char* dst, size_t byte_size) const = 0;
+};
+
+std::unique_ptr<SocketCodec> NewSocketCodec(CommNetCodec codec);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMM_NETWORK_EPOLL_SOCKET_CODEC_H_
@@ -0,0 +1,115 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/comm_network/epoll/socket_codec.h"
+#include <chrono>
+#include <cstring>
+#include <random>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+double ElapsedMs(const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// activations or gradients, which zlib can hardly shrink
+std::vector<char> NormalFloats(int64_t byte_size) {
+  std::vector<float> values(byte_size / sizeof(float));
+  std::mt19937 gen(0);
+  std::normal_distribution<float> dis(0, 1);
+  for (float& value : values) { value = dis(gen); }
+  return std::vector<char>(reinterpret_cast<char*>(values.data()),
+                           reinterpret_cast<char*>(values.data() + values.size()));
+}
+
+// ids or masks with few distinct values
+std::vector<char> RepetitiveInts(int64_t byte_size) {
+  std::vector<int32_t> values(byte_size / sizeof(int32_t));
+  std::mt19937 gen(0);
+  for (int32_t& value : values) { value = gen() % 16; }
+  return std::vector<char>(reinterpret_cast<char*>(values.data()),
+                           reinterpret_cast<char*>(values.data() + values.size()));
+}
+
+void BenchmarkCodec(const std::string& payload_name, CommNetCodec codec,
+                    const std::vector<char>& src) {
+  const int64_t repeat = std::max<int64_t>(1, (64 << 20) / src.size());
+  const double raw_mb = static_cast<double>(src.size()) * repeat / 1e6;
+  std::vector<char> dst(src.size());
+  if (codec == CommNetCodec::kNoCommNetCodec) {
+    // what the raw path pays on top of the transfer is a copy at most
+    const auto start = std::chrono::steady_clock::now();
+    FOR_RANGE(int64_t, i, 0, repeat) { std::memcpy(dst.data(), src.data(), src.size()); }
+    LOG(INFO) << payload_name << " " << src.size() << " bytes, raw: copy "
+              << raw_mb / ElapsedMs(start) * 1000 << " MB/s";
+    return;
+  }
+  std::unique_ptr<SocketCodec> socket_codec = NewSocketCodec(codec);
+  std::vector<char> encoded;
+  bool is_encoded = false;
+  const auto encode_start = std::chrono::steady_clock::now();
+  FOR_RANGE(int64_t, i, 0, repeat) {
+    encoded.clear();
+    is_encoded = socket_codec->Encode(src.data(), src.size(), 0, &encoded);
+  }
+  const double encode_ms = ElapsedMs(encode_start);
+  if (!is_encoded) {
+    LOG(INFO) << payload_name << " " << src.size() << " bytes, " << CommNetCodec_Name(codec)
+              << ": not encoded, encode " << raw_mb / encode_ms * 1000 << " MB/s wasted";
+    return;
+  }
+  const auto decode_start = std::chrono::steady_clock::now();
+  FOR_RANGE(int64_t, i, 0, repeat) {
+    socket_codec->Decode(encoded.data(), encoded.size(), 0, dst.data(), dst.size());
+  }
+  const double decode_ms = ElapsedMs(decode_start);
+  const double ratio = static_cast<double>(encoded.size()) / src.size();
+  // the codec pays off when the link is slower than the saved bytes per coding time
+  const double break_even_mb_per_s = raw_mb * (1 - ratio) / ((encode_ms + decode_ms) / 1000);
+  LOG(INFO) << payload_name << " " << src.size() << " bytes, " << CommNetCodec_Name(codec)
+            << ": ratio " << ratio << ", encode "
+            << raw_mb / encode_ms * 1000 << " MB/s, decode " << raw_mb / decode_ms * 1000
+            << " MB/s, faster than raw below " << break_even_mb_per_s << " MB/s of link";
+}
+
+}  // namespace
+
+// not run by default, run it with
+// --gtest_also_run_disabled_tests --gtest_filter=SocketCodecBenchmark.*
+TEST(SocketCodecBenchmark, DISABLED_zlib_and_float16_vs_raw) {
+  for (const int64_t byte_size : {int64_t(64 << 10), int64_t(1 << 20), int64_t(16 << 20)}) {
+    const std::vector<char> floats = NormalFloats(byte_size);
+    const std::vector<char> ints = RepetitiveInts(byte_size);
+    for (const CommNetCodec codec :
+         {CommNetCodec::kNoCommNetCodec, CommNetCodec::kZlibCommNetCodec,
+          CommNetCodec::kFloat16CommNetCodec}) {
+      BenchmarkCodec("float", codec, floats);
+    }
+    // float16 only applies to float regsts
+    for (const CommNetCodec codec :
+         {CommNetCodec::kNoCommNetCodec, CommNetCodec::kZlibCommNetCodec}) {
+      BenchmarkCodec("int32", codec, ints);
+    }
+  }
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -0,0 +1,77 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/comm_network/epoll/socket_codec.h"
+
+namespace oneflow {
+
+namespace {
+
+std::vector<char> EncodeThenDecode(CommNetCodec codec, const std::vector<char>& src,
+                                   size_t raw_prefix_byte_size, size_t* encoded_byte_size) {
+  std::unique_ptr<SocketCodec> socket_codec = NewSocketCodec(codec);
+  std::vector<char> encoded;
+  CHECK(socket_codec->Encode(src.data(), src.size(), raw_prefix_byte_size, &encoded));
+  *encoded_byte_size = encoded.size();
+  std::vector<char> dst(src.size());
+  socket_codec->Decode(encoded.data(), encoded.size(), raw_prefix_byte_size, dst.data(),
+                       dst.size());
+  return dst;
+}
+
+}  // namespace
+
+TEST(SocketCodec, zlib_is_lossless) {
+  std::vector<int64_t> ids(4096);
+  FOR_RANGE(size_t, i, 0, ids.size()) { ids[i] = i % 17; }
+  std::vector<char> src(reinterpret_cast<char*>(ids.data()),
+                        reinterpret_cast<char*>(ids.data() + ids.size()));
+  size_t encoded_byte_size = 0;
+  ASSERT_TRUE(EncodeThenDecode(CommNetCodec::kZlibCommNetCodec, src, 0, &encoded_byte_size)
+              == src);
+  ASSERT_LT(encoded_byte_size, src.size());
+}
+
+TEST(SocketCodec, zlib_gives_up_on_incompressible_data) {
+  std::vector<char> src(4096);
+  uint32_t state = 1;
+  for (char& c : src) {
+    state = state * 1664525 + 1013904223;
+    c = static_cast<char>(state >> 24);
+  }
+  std::vector<char> encoded;
+  ASSERT_FALSE(NewSocketCodec(CommNetCodec::kZlibCommNetCodec)
+                   ->Encode(src.data(), src.size(), 0, &encoded));
+}
+
+TEST(SocketCodec, float16_keeps_prefix_and_tail) {
+  const size_t raw_prefix_byte_size = 16;
+  const size_t elem_cnt = 1000;
+  std::vector<char> src(raw_prefix_byte_size + elem_cnt * sizeof(float) + 3);
+  FOR_RANGE(size_t, i, 0, raw_prefix_byte_size) { src[i] = static_cast<char>(i + 1); }
+  float* data = reinterpret_cast<float*>(src.data() + raw_prefix_byte_size);
+  FOR_RANGE(size_t, i, 0, elem_cnt) { data[i] = 0.25f * i - 100.0f; }
+  src[src.size() - 1] = 7;
+  size_t encoded_byte_size = 0;
+  std::vector<char> dst = EncodeThenDecode(CommNetCodec::kFloat16CommNetCodec, src,
+                                           raw_prefix_byte_size, &encoded_byte_size);
+  ASSERT_EQ(encoded_byte_size, raw_prefix_byte_size + elem_cnt * 2 + 3);
+  ASSERT_TRUE(std::equal(src.begin(), src.begin() + raw_prefix_byte_size, dst.begin()));
+  ASSERT_TRUE(std::equal(src.end() - 3, src.end(), dst.end() - 3));
+  const float* decoded = reinterpret_cast<const float*>(dst.data() + raw_prefix_byte_size);
+  FOR_RANGE(size_t, i, 0, elem_cnt) { ASSERT_EQ(decoded[i], data[i]); }
+}
+
+}  // namespace oneflow
@@ -16,7 +16,8 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_COMM_NETWORK_EPOLL_SOCKET_MEMORY_DESC_H_
 #define ONEFLOW_CORE_COMM_NETWORK_EPOLL_SOCKET_MEMORY_DESC_H_
 
-#include "oneflow/core/comm_network/epoll/socket_memory_desc.h"
+#include "oneflow/core/common/platform.h"
+#include "oneflow/core/register/register_desc.pb.h"
 
 #ifdef PLATFORM_POSIX
 
@@ -25,6 +26,8 @@ namespace oneflow {
 struct SocketMemDesc {
   void* mem_ptr;
   size_t byte_size;
+  CommNetCodec codec;
+  size_t raw_prefix_byte_size;
 };
 
 }  // namespace oneflow
@@ -50,12 +50,20 @@ struct RequestWriteMsg {
   int64_t dst_machine_id;
   void* dst_token;
   void* read_id;
+  size_t byte_size;
 };
 
 struct RequestReadMsg {
   void* src_token;
   void* dst_token;
   void* read_id;
+  size_t byte_size;
+  // kNoCommNetCodec: the body is the raw src memory, otherwise "encoded_byte_size" bytes
+  // of "encoded", which lives on the sending machine and is released after it is written
+  CommNetCodec codec;
+  size_t raw_prefix_byte_size;
+  std::vector<char>* encoded;
+  size_t encoded_byte_size;
 };
 
 struct SocketMsg {
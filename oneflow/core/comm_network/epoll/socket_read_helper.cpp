@@ -23,12 +23,11 @@ limitations under the License.
 
 namespace oneflow {
 
-SocketReadHelper::~SocketReadHelper() {
-  // do nothing
-}
+SocketReadHelper::~SocketReadHelper() { delete encoded_buf_; }
 
 SocketReadHelper::SocketReadHelper(int sockfd) {
   sockfd_ = sockfd;
+  encoded_buf_ = nullptr;
   SwitchToMsgHeadReadHandle();
 }
 
@@ -82,7 +81,12 @@ void SocketReadHelper::SetStatusWhenMsgHeadDone() {
 
 void SocketReadHelper::SetStatusWhenMsgBodyDone() {
   if (cur_msg_.msg_type == SocketMsgType::kRequestRead) {
-    Global<EpollCommNet>::Get()->ReadDone(cur_msg_.request_read_msg.read_id);
+    if (cur_msg_.request_read_msg.codec == CommNetCodec::kNoCommNetCodec) {
+      Global<EpollCommNet>::Get()->ReadDone(cur_msg_.request_read_msg.read_id);
+    } else {
+      Global<EpollCommNet>::Get()->DecodeAndReadDone(cur_msg_.request_read_msg, encoded_buf_);
+      encoded_buf_ = nullptr;
+    }
   }
   SwitchToMsgHeadReadHandle();
 }
@@ -93,15 +97,28 @@ void SocketReadHelper::SetStatusWhenRequestWriteMsgHeadDone() {
   msg_to_send.request_read_msg.src_token = cur_msg_.request_write_msg.src_token;
   msg_to_send.request_read_msg.dst_token = cur_msg_.request_write_msg.dst_token;
   msg_to_send.request_read_msg.read_id = cur_msg_.request_write_msg.read_id;
-  Global<EpollCommNet>::Get()->SendSocketMsg(cur_msg_.request_write_msg.dst_machine_id,
-                                             msg_to_send);
+  msg_to_send.request_read_msg.byte_size = cur_msg_.request_write_msg.byte_size;
+  msg_to_send.request_read_msg.codec = CommNetCodec::kNoCommNetCodec;
+  msg_to_send.request_read_msg.raw_prefix_byte_size = 0;
+  msg_to_send.request_read_msg.encoded = nullptr;
+  msg_to_send.request_read_msg.encoded_byte_size = 0;
+  Global<EpollCommNet>::Get()->SendRequestReadMsg(cur_msg_.request_write_msg.dst_machine_id,
+                                                  msg_to_send);
   SwitchToMsgHeadReadHandle();
 }
 
 void SocketReadHelper::SetStatusWhenRequestReadMsgHeadDone() {
   auto mem_desc = static_cast<const SocketMemDesc*>(cur_msg_.request_read_msg.dst_token);
-  read_ptr_ = reinterpret_cast<char*>(mem_desc->mem_ptr);
-  read_size_ = mem_desc->byte_size;
+  CHECK_LE(cur_msg_.request_read_msg.byte_size, mem_desc->byte_size);
+  if (cur_msg_.request_read_msg.codec == CommNetCodec::kNoCommNetCodec) {
+    read_ptr_ = reinterpret_cast<char*>(mem_desc->mem_ptr);
+    read_size_ = cur_msg_.request_read_msg.byte_size;
+  } else {
+    CHECK(encoded_buf_ == nullptr);
+    encoded_buf_ = new std::vector<char>(cur_msg_.request_read_msg.encoded_byte_size);
+    read_ptr_ = encoded_buf_->data();
+    read_size_ = encoded_buf_->size();
+  }
   cur_read_handle_ = &SocketReadHelper::MsgBodyReadHandle;
 }
 
@@ -53,6 +53,7 @@ class SocketReadHelper final {
   bool (SocketReadHelper::*cur_read_handle_)();
   char* read_ptr_;
   size_t read_size_;
+  std::vector<char>* encoded_buf_;
 };
 
 }  // namespace oneflow
@@ -121,6 +121,10 @@ void SocketWriteHelper::SetStatusWhenMsgHeadDone() {
 }
 
 void SocketWriteHelper::SetStatusWhenMsgBodyDone() {
+  if (cur_msg_.msg_type == SocketMsgType::kRequestRead) {
+    delete cur_msg_.request_read_msg.encoded;
+    cur_msg_.request_read_msg.encoded = nullptr;
+  }
   cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
 }
 
@@ -131,8 +135,16 @@ void SocketWriteHelper::SetStatusWhenRequestWriteMsgHeadDone() {
 void SocketWriteHelper::SetStatusWhenRequestReadMsgHeadDone() {
   const void* src_token = cur_msg_.request_read_msg.src_token;
   auto src_mem_desc = static_cast<const SocketMemDesc*>(src_token);
-  write_ptr_ = reinterpret_cast<const char*>(src_mem_desc->mem_ptr);
-  write_size_ = src_mem_desc->byte_size;
+  CHECK_LE(cur_msg_.request_read_msg.byte_size, src_mem_desc->byte_size);
+  const std::vector<char>* encoded = cur_msg_.request_read_msg.encoded;
+  if (encoded == nullptr) {
+    write_ptr_ = reinterpret_cast<const char*>(src_mem_desc->mem_ptr);
+    write_size_ = cur_msg_.request_read_msg.byte_size;
+  } else {
+    CHECK_EQ(encoded->size(), cur_msg_.request_read_msg.encoded_byte_size);
+    write_ptr_ = encoded->data();
+    write_size_ = encoded->size();
+  }
   cur_write_handle_ = &SocketWriteHelper::MsgBodyWriteHandle;
 }
 
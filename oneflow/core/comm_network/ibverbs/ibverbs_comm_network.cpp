@@ -122,10 +122,10 @@ IBVerbsCommNet::IBVerbsCommNet(const Plan& plan)
 }
 
 void IBVerbsCommNet::DoRead(void* read_id, int64_t src_machine_id, void* src_token,
-                            void* dst_token) {
+                            void* dst_token, size_t byte_size) {
   qp_vec_.at(src_machine_id)
       ->PostReadRequest(token2mem_desc_.at(src_machine_id).at(src_token),
-                        *static_cast<const IBVerbsMemDesc*>(dst_token), read_id);
+                        *static_cast<const IBVerbsMemDesc*>(dst_token), byte_size, read_id);
 }
 
 void IBVerbsCommNet::PollCQ() {
@@ -120,16 +120,30 @@ void IBVerbsQP::PostAllRecvRequest() {
 }
 
 void IBVerbsQP::PostReadRequest(const IBVerbsMemDescProto& remote_mem,
-                                const IBVerbsMemDesc& local_mem, void* read_id) {
+                                const IBVerbsMemDesc& local_mem, size_t byte_size,
+                                void* read_id) {
   CHECK_EQ(remote_mem.mem_ptr_size(), local_mem.sge_vec().size());
+  // post only the leading blocks covering "byte_size", at least one so that ReadDone still fires
+  size_t sge_cnt = 0;
+  size_t covered_byte_size = 0;
+  while (sge_cnt == 0 || covered_byte_size < byte_size) {
+    CHECK_LT(sge_cnt, local_mem.sge_vec().size());
+    covered_byte_size += local_mem.sge_vec().at(sge_cnt).length;
+    sge_cnt += 1;
+  }
   WorkRequestId* wr_id = NewWorkRequestId();
-  wr_id->outstanding_sge_cnt = local_mem.sge_vec().size();
+  wr_id->outstanding_sge_cnt = sge_cnt;
   wr_id->read_id = read_id;
-  FOR_RANGE(size_t, i, 0, local_mem.sge_vec().size()) {
+  size_t remain_byte_size = byte_size;
+  FOR_RANGE(size_t, i, 0, sge_cnt) {
+    // ibv_post_send copies the scatter/gather list, so a truncated local copy is enough
+    ibv_sge sge = local_mem.sge_vec().at(i);
+    sge.length = std::min<size_t>(sge.length, remain_byte_size);
+    remain_byte_size -= sge.length;
     ibv_send_wr wr;
     wr.wr_id = reinterpret_cast<uint64_t>(wr_id);
     wr.next = nullptr;
-    wr.sg_list = const_cast<ibv_sge*>(&(local_mem.sge_vec().at(i)));
+    wr.sg_list = &sge;
     wr.num_sge = 1;
     wr.opcode = IBV_WR_RDMA_READ;
     wr.send_flags = 0;
@@ -63,7 +63,7 @@ class IBVerbsQP final {
   void PostAllRecvRequest();
 
   void PostReadRequest(const IBVerbsMemDescProto& remote_mem, const IBVerbsMemDesc& local_mem,
-                       void* read_id);
+                       size_t byte_size, void* read_id);
   void PostSendRequest(const ActorMsg& msg);
 
   void ReadDone(WorkRequestId*);
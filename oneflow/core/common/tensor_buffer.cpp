@@ -20,4 +20,80 @@ namespace oneflow {
 double TensorBuffer::growth_factor_ = 1.0;
 double TensorBuffer::shrink_threshold_ = 0.9;
 
+namespace {
+
+constexpr int64_t kNumSizeClassesPerPowerOfTwo = 4;
+// blocks range from 64 bytes, enough for a pooled shared_ptr control block, to 1 GiB
+constexpr int64_t kMinBlockSizeLog2 = 6;
+constexpr int64_t kMaxBlockSizeLog2 = 30;
+constexpr size_t kDefaultPoolCapacityMB = 1024;
+
+int64_t FloorLog2(size_t n) {
+  int64_t ret = 0;
+  while (n >>= 1) { ++ret; }
+  return ret;
+}
+
+}  // namespace
+
+TensorBufferPool* TensorBufferPool::Get() {
+  // never destroyed, TensorBuffers held by other static objects may be freed after exit
+  static TensorBufferPool* pool = new TensorBufferPool();
+  return pool;
+}
+
+TensorBufferPool::TensorBufferPool()
+    : cached_bytes_(0), allocate_cnt_(0), capacity_(kDefaultPoolCapacityMB << 20) {
+  const char* capacity_mb = std::getenv("ONEFLOW_TENSOR_BUFFER_POOL_CAPACITY_MB");
+  if (capacity_mb != nullptr) { capacity_ = std::stoull(capacity_mb) << 20; }
+  const int64_t num_size_classes =
+      (kMaxBlockSizeLog2 - kMinBlockSizeLog2 + 1) * kNumSizeClassesPerPowerOfTwo;
+  FOR_RANGE(int64_t, i, 0, num_size_classes) { size_classes_.emplace_back(new SizeClass()); }
+}
+
+size_t TensorBufferPool::GetBlockSize(size_t num_bytes) {
+  if (num_bytes <= (1ULL << kMinBlockSizeLog2)) { return 1ULL << kMinBlockSizeLog2; }
+  // num_bytes is in (base, 2 * base], round it up to a multiple of base / 4
+  const size_t base = 1ULL << FloorLog2(num_bytes - 1);
+  return RoundUp(num_bytes, base / kNumSizeClassesPerPowerOfTwo);
+}
+
+TensorBufferPool::SizeClass* TensorBufferPool::GetSizeClass(size_t block_size) {
+  const int64_t base_log2 = FloorLog2(block_size - 1);
+  if (base_log2 >= kMaxBlockSizeLog2) { return nullptr; }
+  const size_t base = 1ULL << base_log2;
+  const int64_t sub_class = (block_size - base) / (base / kNumSizeClassesPerPowerOfTwo) - 1;
+  const int64_t index =
+      (base_log2 + 1 - kMinBlockSizeLog2) * kNumSizeClassesPerPowerOfTwo + sub_class;
+  CHECK_EQ(GetBlockSize(block_size), block_size);
+  return size_classes_.at(index).get();
+}
+
+void* TensorBufferPool::Allocate(size_t block_size) {
+  ++allocate_cnt_;
+  SizeClass* size_class = GetSizeClass(block_size);
+  if (size_class != nullptr) {
+    std::unique_lock<std::mutex> lock(size_class->mutex);
+    if (!size_class->free_blocks.empty()) {
+      void* ptr = size_class->free_blocks.back();
+      size_class->free_blocks.pop_back();
+      cached_bytes_ -= block_size;
+      return ptr;
+    }
+  }
+  return MemoryAllocatorImpl::AllocateUnPinnedHostMem(block_size);
+}
+
+void TensorBufferPool::Deallocate(void* ptr, size_t block_size) {
+  if (ptr == nullptr) { return; }
+  SizeClass* size_class = GetSizeClass(block_size);
+  if (size_class != nullptr && cached_bytes_.load() + block_size <= capacity_) {
+    std::unique_lock<std::mutex> lock(size_class->mutex);
+    size_class->free_blocks.push_back(ptr);
+    cached_bytes_ += block_size;
+    return;
+  }
+  MemoryAllocatorImpl::DeallocateUnPinnedHostMem(ptr);
+}
+
 }  // namespace oneflow
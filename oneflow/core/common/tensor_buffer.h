@@ -28,10 +28,83 @@ inline void CheckTensorBufferDataType(DataType val) {
       << "TensorBuffer only support POD as internal data type.";
 }
 
+// Caches the host memory blocks of TensorBuffer by size class. A data pipeline allocates and
+// frees buffers of similar sizes for every sample, recycling them saves a malloc (and for large
+// images a mmap plus page faults) per sample. Freed blocks are kept until the cached bytes exceed
+// the capacity, which is read from ONEFLOW_TENSOR_BUFFER_POOL_CAPACITY_MB.
+class TensorBufferPool final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(TensorBufferPool);
+  ~TensorBufferPool() = delete;
+
+  static TensorBufferPool* Get();
+
+  // rounds num_bytes up to its size class, size classes are 4 per power of two
+  static size_t GetBlockSize(size_t num_bytes);
+
+  void* Allocate(size_t block_size);
+  void Deallocate(void* ptr, size_t block_size);
+
+  size_t capacity() const { return capacity_; }
+  size_t cached_bytes() const { return cached_bytes_.load(); }
+  // number of blocks handed out, either recycled or newly allocated
+  int64_t allocate_cnt() const { return allocate_cnt_.load(); }
+
+ private:
+  struct SizeClass {
+    std::mutex mutex;
+    std::vector<void*> free_blocks;
+  };
+
+  TensorBufferPool();
+  SizeClass* GetSizeClass(size_t block_size);
+
+  std::vector<std::unique_ptr<SizeClass>> size_classes_;
+  std::atomic<size_t> cached_bytes_;
+  std::atomic<int64_t> allocate_cnt_;
+  size_t capacity_;
+};
+
+template<typename T>
+struct TensorBufferPoolAllocator {
+  using value_type = T;
+
+  TensorBufferPoolAllocator() = default;
+  template<typename U>
+  TensorBufferPoolAllocator(const TensorBufferPoolAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(
+        TensorBufferPool::Get()->Allocate(TensorBufferPool::GetBlockSize(n * sizeof(T))));
+  }
+  void deallocate(T* ptr, size_t n) {
+    TensorBufferPool::Get()->Deallocate(ptr, TensorBufferPool::GetBlockSize(n * sizeof(T)));
+  }
+};
+
+template<typename T, typename U>
+bool operator==(const TensorBufferPoolAllocator<T>&, const TensorBufferPoolAllocator<U>&) {
+  return true;
+}
+
+template<typename T, typename U>
+bool operator!=(const TensorBufferPoolAllocator<T>&, const TensorBufferPoolAllocator<U>&) {
+  return false;
+}
+
+// the object and its shared_ptr control block share one recycled block of TensorBufferPool
+template<typename T, typename... Args>
+std::shared_ptr<T> MakePooledShared(Args&&... args) {
+  return std::allocate_shared<T>(TensorBufferPoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
 class TensorBuffer {
  public:
   struct Deleter {
-    void operator()(void* ptr) { MemoryAllocatorImpl::DeallocateUnPinnedHostMem(ptr); }
+    Deleter() : num_bytes(0) {}
+    explicit Deleter(size_t num_bytes) : num_bytes(num_bytes) {}
+    void operator()(void* ptr) { TensorBufferPool::Get()->Deallocate(ptr, num_bytes); }
+    size_t num_bytes;
   };
   typedef std::unique_ptr<void, Deleter> BufferType;
 
@@ -79,8 +152,8 @@ class TensorBuffer {
   void reserve(size_t new_num_bytes) {
     if (new_num_bytes <= num_bytes_) { return; }
     data_.reset();
-    data_.reset(MemoryAllocatorImpl::AllocateUnPinnedHostMem(new_num_bytes));
-    num_bytes_ = new_num_bytes;
+    num_bytes_ = TensorBufferPool::GetBlockSize(new_num_bytes);
+    data_ = BufferType(TensorBufferPool::Get()->Allocate(num_bytes_), Deleter(num_bytes_));
   }
 
   int64_t elem_cnt() const { return shape_.elem_cnt(); }
@@ -105,7 +178,9 @@ class TensorBuffer {
       new_num_bytes =
           std::max(new_num_bytes, RoundUp(num_bytes_ * growth_factor_, kTensorBufferAlignedSize));
       reserve(new_num_bytes);
-    } else if (new_num_bytes < num_bytes_ * shrink_threshold_) {
+    } else if (TensorBufferPool::GetBlockSize(new_num_bytes) < num_bytes_ * shrink_threshold_) {
+      // num_bytes_ is rounded up to a block size, so compare with the block of the new size,
+      // otherwise a size rounded up by more than the threshold reallocates on every Resize
       data_.reset();
       num_bytes_ = 0;
       reserve(new_num_bytes);
@@ -0,0 +1,78 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/tensor_buffer.h"
+
+namespace oneflow {
+
+namespace test {
+
+TEST(TensorBufferPool, block_size) {
+  ASSERT_EQ(TensorBufferPool::GetBlockSize(1), 64);
+  ASSERT_EQ(TensorBufferPool::GetBlockSize(64), 64);
+  ASSERT_EQ(TensorBufferPool::GetBlockSize(65), 80);
+  ASSERT_EQ(TensorBufferPool::GetBlockSize(1024), 1024);
+  ASSERT_EQ(TensorBufferPool::GetBlockSize(1025), 1280);
+  ASSERT_EQ(TensorBufferPool::GetBlockSize(1537), 1792);
+  ASSERT_EQ(TensorBufferPool::GetBlockSize(150 * 1024), 160 * 1024);
+}
+
+TEST(TensorBufferPool, recycle_block) {
+  void* data = nullptr;
+  {
+    TensorBuffer buffer;
+    buffer.Resize(Shape({224, 224, 3}), DataType::kUInt8);
+    data = buffer.mut_data();
+  }
+  TensorBuffer buffer;
+  buffer.Resize(Shape({3, 224, 224}), DataType::kUInt8);
+  ASSERT_EQ(buffer.mut_data(), data);
+}
+
+TEST(TensorBufferPool, resize_within_block) {
+  TensorBuffer buffer;
+  // 17 KiB is rounded up to a 20 KiB block, which is more than the shrink threshold
+  buffer.Resize(Shape({17 * 1024}), DataType::kChar);
+  ASSERT_EQ(buffer.capacity(), 20 * 1024);
+  const void* data = buffer.data();
+  const int64_t allocate_cnt = TensorBufferPool::Get()->allocate_cnt();
+  FOR_RANGE(int, i, 0, 8) {
+    buffer.Resize(Shape({17 * 1024}), DataType::kChar);
+    buffer.Resize(Shape({19 * 1024}), DataType::kChar);
+  }
+  ASSERT_EQ(TensorBufferPool::Get()->allocate_cnt(), allocate_cnt);
+  ASSERT_EQ(buffer.data(), data);
+  ASSERT_EQ(buffer.capacity(), 20 * 1024);
+  // a much smaller size still shrinks the buffer
+  buffer.Resize(Shape({1024}), DataType::kChar);
+  ASSERT_EQ(TensorBufferPool::Get()->allocate_cnt(), allocate_cnt + 1);
+  ASSERT_EQ(buffer.capacity(), 1024);
+}
+
+TEST(TensorBufferPool, pooled_shared_ptr) {
+  const TensorBuffer* first = nullptr;
+  {
+    std::shared_ptr<TensorBuffer> buffer = MakePooledShared<TensorBuffer>();
+    buffer->Resize(Shape({1000}), DataType::kChar);
+    first = buffer.get();
+  }
+  std::shared_ptr<TensorBuffer> buffer = MakePooledShared<TensorBuffer>();
+  ASSERT_EQ(buffer.get(), first);
+  ASSERT_EQ(buffer->elem_cnt(), 0);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
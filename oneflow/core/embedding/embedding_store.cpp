@@ -0,0 +1,433 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/embedding/embedding_store.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/common/platform.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/kernel/cpu_row_update_util.h"
+#include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/persistence/snapshot.h"
+
+#ifdef PLATFORM_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif  // PLATFORM_POSIX
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kInitialSpillFileRows = 1024;
+constexpr int64_t kNilSlot = -1;
+
+uint64_t SplitMix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+std::string ShardKey(const std::string& prefix, int64_t shard_id, const std::string& suffix) {
+  return JoinPath(prefix, "shard-" + std::to_string(shard_id) + "-" + suffix);
+}
+
+bool operator==(const EmbeddingStoreOptions& lhs, const EmbeddingStoreOptions& rhs) {
+  return lhs.name == rhs.name && lhs.embedding_dim == rhs.embedding_dim
+         && lhs.num_state_slots == rhs.num_state_slots && lhs.num_shards == rhs.num_shards
+         && lhs.cache_capacity == rhs.cache_capacity && lhs.storage_dir == rhs.storage_dir
+         && lhs.init_scale == rhs.init_scale && lhs.seed == rhs.seed;
+}
+
+#ifdef PLATFORM_POSIX
+
+// Fixed size rows in a scratch file that is mmap()ed and doubled when full. The file only backs
+// the cache and is removed with the store; snapshots are what persists.
+class SpillFile final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(SpillFile);
+  SpillFile(const std::string& path, int64_t row_bytes)
+      : path_(path), row_bytes_(row_bytes), num_rows_(0), capacity_(0), mapped_(nullptr) {
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    PCHECK(fd_ != -1) << "Fail to open embedding spill file " << path;
+  }
+  ~SpillFile() {
+    if (mapped_ != nullptr) { munmap(mapped_, capacity_ * row_bytes_); }
+    close(fd_);
+    unlink(path_.c_str());
+  }
+
+  char* Row(int64_t idx) { return mapped_ + idx * row_bytes_; }
+  int64_t AppendRow() {
+    if (num_rows_ == capacity_) { Reserve(std::max(capacity_ * 2, kInitialSpillFileRows)); }
+    return num_rows_++;
+  }
+
+ private:
+  void Reserve(int64_t capacity) {
+    if (mapped_ != nullptr) { PCHECK(munmap(mapped_, capacity_ * row_bytes_) == 0); }
+    PCHECK(ftruncate(fd_, capacity * row_bytes_) == 0) << "Fail to grow " << path_;
+    void* ptr = mmap(nullptr, capacity * row_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    PCHECK(ptr != MAP_FAILED) << "Fail to mmap " << path_;
+    mapped_ = static_cast<char*>(ptr);
+    capacity_ = capacity;
+  }
+
+  const std::string path_;
+  const int64_t row_bytes_;
+  int64_t num_rows_;
+  int64_t capacity_;
+  int fd_;
+  char* mapped_;
+};
+
+#else
+
+class SpillFile final {
+ public:
+  SpillFile(const std::string& path, int64_t row_bytes) { UNIMPLEMENTED(); }
+  char* Row(int64_t idx) { return nullptr; }
+  int64_t AppendRow() { return -1; }
+};
+
+#endif  // PLATFORM_POSIX
+
+}  // namespace
+
+class EmbeddingStoreShard final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(EmbeddingStoreShard);
+  EmbeddingStoreShard(const EmbeddingStoreOptions& options, int64_t shard_id)
+      : embedding_dim_(options.embedding_dim),
+        row_size_(options.embedding_dim * (1 + options.num_state_slots)),
+        init_scale_(options.init_scale),
+        seed_(SplitMix64(options.seed)),
+        capacity_(GetMaxVal<int64_t>()),
+        head_(kNilSlot),
+        tail_(kNilSlot),
+        num_rows_(0),
+        num_hits_(0),
+        num_misses_(0),
+        num_evictions_(0) {
+    if (options.storage_dir.empty() || options.cache_capacity <= 0) { return; }
+#ifdef PLATFORM_POSIX
+    const std::string dir = JoinPath(options.storage_dir, options.name);
+    LocalFS()->RecursivelyCreateDirIfNotExist(dir);
+    spill_file_.reset(new SpillFile(JoinPath(dir, "shard-" + std::to_string(shard_id)),
+                                    row_size_ * sizeof(float)));
+    capacity_ = std::max<int64_t>(
+        (options.cache_capacity + options.num_shards - 1) / options.num_shards, 1);
+#else
+    LOG(WARNING) << "embedding store " << options.name << " cannot spill rows on this platform, "
+                 << "all rows stay in host memory";
+#endif  // PLATFORM_POSIX
+  }
+  ~EmbeddingStoreShard() = default;
+
+  std::mutex* mutex() { return &mutex_; }
+
+  // the row of id, paged in or created as needed, valid until the next call
+  float* GetRow(int64_t id) {
+    bool created = false;
+    float* row = FindOrInsertRow(id, &created);
+    if (created) { InitRow(id, row); }
+    return row;
+  }
+
+  void PutRow(int64_t id, const float* row) {
+    bool created = false;
+    std::memcpy(FindOrInsertRow(id, &created), row, row_size_ * sizeof(float));
+  }
+
+  void ForEachStoredRow(const std::function<void(int64_t, const float*)>& Handler) {
+    for (const auto& pair : id2slot_) { Handler(pair.first, SlotRow(pair.second)); }
+    for (const auto& pair : id2spill_row_) {
+      if (id2slot_.find(pair.first) != id2slot_.end()) { continue; }
+      Handler(pair.first, reinterpret_cast<const float*>(spill_file_->Row(pair.second)));
+    }
+  }
+
+  void AddStats(EmbeddingStoreStats* stats) const {
+    stats->num_rows += num_rows_;
+    stats->num_cached_rows += id2slot_.size();
+    stats->num_hits += num_hits_;
+    stats->num_misses += num_misses_;
+    stats->num_evictions += num_evictions_;
+  }
+
+ private:
+  float* SlotRow(int64_t slot) { return cache_.data() + slot * row_size_; }
+
+  // *created tells whether the row is new to the store and still has to be filled
+  float* FindOrInsertRow(int64_t id, bool* created) {
+    auto it = id2slot_.find(id);
+    if (it != id2slot_.end()) {
+      num_hits_ += 1;
+      Unlink(it->second);
+      PushFront(it->second);
+      return SlotRow(it->second);
+    }
+    num_misses_ += 1;
+    const int64_t slot = AcquireSlot();
+    float* row = SlotRow(slot);
+    auto spill_it = id2spill_row_.find(id);
+    if (spill_it != id2spill_row_.end()) {
+      std::memcpy(row, spill_file_->Row(spill_it->second), row_size_ * sizeof(float));
+      *created = false;
+    } else {
+      num_rows_ += 1;
+      *created = true;
+    }
+    id2slot_.emplace(id, slot);
+    slot_ids_.at(slot) = id;
+    PushFront(slot);
+    return row;
+  }
+
+  // a never used slot while under capacity, the least recently used one written back otherwise
+  int64_t AcquireSlot() {
+    if (static_cast<int64_t>(slot_ids_.size()) < capacity_) {
+      const int64_t slot = slot_ids_.size();
+      slot_ids_.push_back(kNilSlot);
+      prev_.push_back(kNilSlot);
+      next_.push_back(kNilSlot);
+      cache_.resize(cache_.size() + row_size_);
+      return slot;
+    }
+    const int64_t slot = tail_;
+    CHECK_NE(slot, kNilSlot);
+    Unlink(slot);
+    const int64_t victim = slot_ids_.at(slot);
+    id2slot_.erase(victim);
+    auto spill_it = id2spill_row_.find(victim);
+    if (spill_it == id2spill_row_.end()) {
+      spill_it = id2spill_row_.emplace(victim, spill_file_->AppendRow()).first;
+    }
+    std::memcpy(spill_file_->Row(spill_it->second), SlotRow(slot), row_size_ * sizeof(float));
+    num_evictions_ += 1;
+    return slot;
+  }
+
+  void Unlink(int64_t slot) {
+    const int64_t prev = prev_.at(slot);
+    const int64_t next = next_.at(slot);
+    if (prev == kNilSlot) {
+      head_ = next;
+    } else {
+      next_.at(prev) = next;
+    }
+    if (next == kNilSlot) {
+      tail_ = prev;
+    } else {
+      prev_.at(next) = prev;
+    }
+  }
+
+  void PushFront(int64_t slot) {
+    prev_.at(slot) = kNilSlot;
+    next_.at(slot) = head_;
+    if (head_ != kNilSlot) { prev_.at(head_) = slot; }
+    head_ = slot;
+    if (tail_ == kNilSlot) { tail_ = slot; }
+  }
+
+  // a pure function of (seed, id), so that rows do not depend on the order ids show up in
+  void InitRow(int64_t id, float* row) const {
+    const uint64_t base = SplitMix64(seed_ ^ static_cast<uint64_t>(id));
+    FOR_RANGE(int64_t, i, 0, embedding_dim_) {
+      const float uniform = (SplitMix64(base + i) >> 40) * (1.0f / (1 << 24));
+      row[i] = (2 * uniform - 1) * init_scale_;
+    }
+    std::fill(row + embedding_dim_, row + row_size_, 0.f);
+  }
+
+  const int64_t embedding_dim_;
+  const int64_t row_size_;
+  const float init_scale_;
+  const uint64_t seed_;
+  int64_t capacity_;
+  std::mutex mutex_;
+
+  std::vector<float> cache_;
+  HashMap<int64_t, int64_t> id2slot_;
+  // id of the row held by every cache slot, and the LRU list through the slots
+  std::vector<int64_t> slot_ids_;
+  std::vector<int64_t> prev_;
+  std::vector<int64_t> next_;
+  int64_t head_;
+  int64_t tail_;
+
+  std::unique_ptr<SpillFile> spill_file_;
+  // every row ever spilled keeps its place in the spill file
+  HashMap<int64_t, int64_t> id2spill_row_;
+
+  int64_t num_rows_;
+  int64_t num_hits_;
+  int64_t num_misses_;
+  int64_t num_evictions_;
+};
+
+EmbeddingStore::EmbeddingStore(const EmbeddingStoreOptions& options) : options_(options) {
+  CHECK_GT(options.embedding_dim, 0);
+  CHECK_GE(options.num_state_slots, 0);
+  CHECK_GT(options.num_shards, 0);
+  FOR_RANGE(int64_t, i, 0, options.num_shards) {
+    shards_.emplace_back(new EmbeddingStoreShard(options, i));
+  }
+}
+
+EmbeddingStore::~EmbeddingStore() = default;
+
+EmbeddingStoreShard* EmbeddingStore::Shard4Id(int64_t id) const {
+  return shards_.at(SplitMix64(id) % shards_.size()).get();
+}
+
+void EmbeddingStore::ForEachRow(int64_t n, const int64_t* ids,
+                                const std::function<void(int64_t, float*)>& Handler) {
+  const int64_t num_shards = shards_.size();
+  std::vector<int64_t> shard_ids(n);
+  std::vector<int64_t> shard_offsets(num_shards + 1, 0);
+  FOR_RANGE(int64_t, i, 0, n) {
+    shard_ids.at(i) = SplitMix64(ids[i]) % num_shards;
+    shard_offsets.at(shard_ids.at(i) + 1) += 1;
+  }
+  FOR_RANGE(int64_t, shard_id, 0, num_shards) {
+    shard_offsets.at(shard_id + 1) += shard_offsets.at(shard_id);
+  }
+  std::vector<int64_t> order(n);
+  {
+    std::vector<int64_t> cursors(shard_offsets.begin(), shard_offsets.end() - 1);
+    FOR_RANGE(int64_t, i, 0, n) { order.at(cursors.at(shard_ids.at(i))++) = i; }
+  }
+  ParallelForEachRowRange(num_shards, n * row_size(), [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, shard_id, begin, end) {
+      EmbeddingStoreShard* shard = shards_.at(shard_id).get();
+      std::unique_lock<std::mutex> lock(*shard->mutex());
+      FOR_RANGE(int64_t, j, shard_offsets.at(shard_id), shard_offsets.at(shard_id + 1)) {
+        const int64_t i = order.at(j);
+        Handler(i, shard->GetRow(ids[i]));
+      }
+    }
+  });
+}
+
+void EmbeddingStore::Lookup(int64_t n, const int64_t* ids, float* out) {
+  const int64_t embedding_dim = options_.embedding_dim;
+  ForEachRow(n, ids, [&](int64_t i, float* row) {
+    std::copy(row, row + embedding_dim, out + i * embedding_dim);
+  });
+}
+
+void EmbeddingStore::Save(SnapshotWriter* writer, const std::string& prefix) {
+  const int64_t meta[2] = {static_cast<int64_t>(shards_.size()), row_size()};
+  writer->Write(JoinPath(prefix, "meta"), reinterpret_cast<const char*>(meta), sizeof(meta));
+  FOR_RANGE(int64_t, shard_id, 0, shards_.size()) {
+    EmbeddingStoreShard* shard = shards_.at(shard_id).get();
+    std::vector<int64_t> ids;
+    std::vector<float> rows;
+    {
+      std::unique_lock<std::mutex> lock(*shard->mutex());
+      shard->ForEachStoredRow([&](int64_t id, const float* row) {
+        ids.push_back(id);
+        rows.insert(rows.end(), row, row + row_size());
+      });
+    }
+    writer->Write(ShardKey(prefix, shard_id, "ids"), reinterpret_cast<const char*>(ids.data()),
+                  ids.size() * sizeof(int64_t));
+    writer->Write(ShardKey(prefix, shard_id, "rows"), reinterpret_cast<const char*>(rows.data()),
+                  rows.size() * sizeof(float));
+  }
+}
+
+void EmbeddingStore::Load(const SnapshotReader& reader, const std::string& prefix) {
+  int64_t meta[2];
+  reader.Read(JoinPath(prefix, "meta"), Shape({2}), DataType::kInt64, TensorSliceView(Shape({2})),
+              reinterpret_cast<char*>(meta));
+  CHECK_EQ(meta[1], row_size()) << "embedding store " << options_.name
+                                << " was saved with a different row size";
+  FOR_RANGE(int64_t, shard_id, 0, meta[0]) {
+    const std::string ids_key = ShardKey(prefix, shard_id, "ids");
+    const int64_t num_ids = reader.GetKeySizeInBytes(ids_key) / sizeof(int64_t);
+    if (num_ids == 0) { continue; }
+    const Shape ids_shape({num_ids});
+    const Shape rows_shape({num_ids, row_size()});
+    std::vector<int64_t> ids(num_ids);
+    std::vector<float> rows(num_ids * row_size());
+    reader.Read(ids_key, ids_shape, DataType::kInt64, TensorSliceView(ids_shape),
+                reinterpret_cast<char*>(ids.data()));
+    reader.Read(ShardKey(prefix, shard_id, "rows"), rows_shape, DataType::kFloat,
+                TensorSliceView(rows_shape), reinterpret_cast<char*>(rows.data()));
+    FOR_RANGE(int64_t, i, 0, num_ids) {
+      EmbeddingStoreShard* shard = Shard4Id(ids.at(i));
+      std::unique_lock<std::mutex> lock(*shard->mutex());
+      shard->PutRow(ids.at(i), rows.data() + i * row_size());
+    }
+  }
+}
+
+EmbeddingStoreStats EmbeddingStore::GetStats() {
+  EmbeddingStoreStats stats{};
+  for (const auto& shard : shards_) {
+    std::unique_lock<std::mutex> lock(*shard->mutex());
+    shard->AddStats(&stats);
+  }
+  return stats;
+}
+
+EmbeddingStoreMgr* EmbeddingStoreMgr::Get() {
+  // never destroyed, like the stores it owns, which live as long as the process
+  static EmbeddingStoreMgr* mgr = new EmbeddingStoreMgr();
+  return mgr;
+}
+
+EmbeddingStore* EmbeddingStoreMgr::GetOrCreate(const EmbeddingStoreOptions& options) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = name2store_.find(options.name);
+  if (it != name2store_.end()) {
+    CHECK(it->second->options() == options)
+        << "embedding store " << options.name << " is used with different options";
+    return it->second.get();
+  }
+  EmbeddingStore* store = new EmbeddingStore(options);
+  name2store_.emplace(options.name, std::unique_ptr<EmbeddingStore>(store));
+  auto pending_it = name2pending_snapshot_path_.find(options.name);
+  if (pending_it != name2pending_snapshot_path_.end()) {
+    store->Load(SnapshotReader(pending_it->second), SnapshotKeyPrefix(options.name));
+    name2pending_snapshot_path_.erase(pending_it);
+  }
+  return store;
+}
+
+void EmbeddingStoreMgr::SaveIfExists(const std::string& name, SnapshotWriter* writer) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = name2store_.find(name);
+  if (it == name2store_.end()) { return; }
+  it->second->Save(writer, SnapshotKeyPrefix(name));
+}
+
+void EmbeddingStoreMgr::LoadIfExists(const std::string& name, const std::string& snapshot_path) {
+  const SnapshotReader reader(snapshot_path);
+  if (!reader.HasKey(JoinPath(SnapshotKeyPrefix(name), "meta"))) { return; }
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = name2store_.find(name);
+  if (it == name2store_.end()) {
+    name2pending_snapshot_path_[name] = snapshot_path;
+  } else {
+    it->second->Load(reader, SnapshotKeyPrefix(name));
+  }
+}
+
+}  // namespace oneflow
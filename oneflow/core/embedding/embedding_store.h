@@ -0,0 +1,118 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EMBEDDING_EMBEDDING_STORE_H_
+#define ONEFLOW_CORE_EMBEDDING_EMBEDDING_STORE_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+class SnapshotReader;
+class SnapshotWriter;
+
+struct EmbeddingStoreOptions {
+  std::string name;
+  int64_t embedding_dim;
+  // floats of optimizer state kept after the embedding in every row, in units of embedding_dim
+  int64_t num_state_slots;
+  int64_t num_shards;
+  // rows kept in host memory over all shards, 0 for unbounded
+  int64_t cache_capacity;
+  // where evicted rows are spilled to; an empty dir makes the cache unbounded
+  std::string storage_dir;
+  // new embeddings are drawn from U(-init_scale, init_scale), state slots start at zero
+  float init_scale;
+  int64_t seed;
+};
+
+struct EmbeddingStoreStats {
+  int64_t num_rows;
+  int64_t num_cached_rows;
+  int64_t num_hits;
+  int64_t num_misses;
+  int64_t num_evictions;
+};
+
+class EmbeddingStoreShard;
+
+// An embedding table that can grow past host memory. Rows are created on first access and
+// spread over shards by id hash, each shard with its own lock. A shard keeps its hot rows in an
+// LRU cache in host memory and spills the least recently used ones to an mmap()ed file under
+// storage_dir, from where they are paged back in on the next access.
+//
+// A row is embedding_dim floats of embedding followed by num_state_slots * embedding_dim floats
+// of optimizer state, so that an update touches one contiguous row.
+class EmbeddingStore final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(EmbeddingStore);
+  explicit EmbeddingStore(const EmbeddingStoreOptions& options);
+  ~EmbeddingStore();
+
+  const EmbeddingStoreOptions& options() const { return options_; }
+  int64_t row_size() const { return options_.embedding_dim * (1 + options_.num_state_slots); }
+
+  // Calls Handler(i, row) for every ids[i] with the whole row of that id. ids must be unique.
+  // Shards are visited in parallel, rows of one shard one at a time under the shard lock, and
+  // the row pointer is only valid inside Handler.
+  void ForEachRow(int64_t n, const int64_t* ids,
+                  const std::function<void(int64_t, float*)>& Handler);
+  // out is n x embedding_dim
+  void Lookup(int64_t n, const int64_t* ids, float* out);
+
+  // every row, cached or spilled, under "<prefix>/shard-<i>-ids" and "<prefix>/shard-<i>-rows"
+  void Save(SnapshotWriter* writer, const std::string& prefix);
+  // rows saved with any number of shards; rows of ids already present are overwritten
+  void Load(const SnapshotReader& reader, const std::string& prefix);
+
+  EmbeddingStoreStats GetStats();
+
+ private:
+  EmbeddingStoreShard* Shard4Id(int64_t id) const;
+
+  const EmbeddingStoreOptions options_;
+  std::vector<std::unique_ptr<EmbeddingStoreShard>> shards_;
+};
+
+// Stores of this process by name, which is the name of the variable that stands for the store in
+// the job, so that model save and load can find them
+class EmbeddingStoreMgr final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(EmbeddingStoreMgr);
+  ~EmbeddingStoreMgr() = default;
+
+  static EmbeddingStoreMgr* Get();
+
+  // creates the store on first use and checks that later options agree with it
+  EmbeddingStore* GetOrCreate(const EmbeddingStoreOptions& options);
+  void SaveIfExists(const std::string& name, SnapshotWriter* writer);
+  // stores created later are loaded from snapshot_path on creation
+  void LoadIfExists(const std::string& name, const std::string& snapshot_path);
+
+  static std::string SnapshotKeyPrefix(const std::string& name) {
+    return name + "/embedding_store";
+  }
+
+ private:
+  EmbeddingStoreMgr() = default;
+
+  std::mutex mutex_;
+  HashMap<std::string, std::unique_ptr<EmbeddingStore>> name2store_;
+  HashMap<std::string, std::string> name2pending_snapshot_path_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EMBEDDING_EMBEDDING_STORE_H_
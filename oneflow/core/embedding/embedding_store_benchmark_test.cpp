@@ -0,0 +1,103 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/embedding/embedding_store.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <unistd.h>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+EmbeddingStoreOptions GetBenchmarkOptions(int64_t cache_capacity, const std::string& storage_dir) {
+  EmbeddingStoreOptions options;
+  options.name = "test";
+  options.embedding_dim = 16;
+  options.num_state_slots = 2;
+  options.num_shards = 4;
+  options.cache_capacity = cache_capacity;
+  options.storage_dir = storage_dir;
+  options.init_scale = 0.05;
+  options.seed = 7;
+  return options;
+}
+
+std::string MakeStorageDir() {
+  char dir[] = "/tmp/embedding_store_benchmark_XXXXXX";
+  CHECK(mkdtemp(dir) != nullptr);
+  return dir;
+}
+
+}  // namespace
+
+// not run by default, run it with
+// --gtest_also_run_disabled_tests --gtest_filter=EmbeddingStoreBenchmark.*
+TEST(EmbeddingStoreBenchmark, DISABLED_zipf) {
+  const int64_t num_ids = 1 << 20;
+  const int64_t batch_size = 1 << 14;
+  const int64_t num_batches = 64;
+  const std::string storage_dir = MakeStorageDir();
+  // ids drawn from a zipf(1.05) distribution by inverse transform over a precomputed cdf
+  std::vector<double> cdf(num_ids);
+  double sum = 0;
+  FOR_RANGE(int64_t, i, 0, num_ids) {
+    sum += 1.0 / std::pow(i + 1, 1.05);
+    cdf[i] = sum;
+  }
+  std::mt19937_64 gen(0);
+  std::uniform_real_distribution<double> dis(0, sum);
+  std::vector<std::vector<int64_t>> batches(num_batches);
+  for (auto& batch : batches) {
+    std::vector<int64_t> ids;
+    FOR_RANGE(int64_t, i, 0, batch_size) {
+      ids.push_back(std::lower_bound(cdf.begin(), cdf.end(), dis(gen)) - cdf.begin());
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    batch = ids;
+  }
+  for (const int64_t cache_capacity : {int64_t(0), int64_t(1 << 16), int64_t(1 << 14)}) {
+    EmbeddingStore store(
+        GetBenchmarkOptions(cache_capacity, cache_capacity > 0 ? storage_dir : ""));
+    std::vector<float> grad(16, 1e-3);
+    const auto start = std::chrono::steady_clock::now();
+    int64_t num_rows_visited = 0;
+    for (const auto& ids : batches) {
+      store.ForEachRow(ids.size(), ids.data(), [&](int64_t i, float* row) {
+        FOR_RANGE(int64_t, j, 0, 16) { row[j] -= grad[j]; }
+      });
+      num_rows_visited += ids.size();
+    }
+    const double ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start).count();
+    const EmbeddingStoreStats stats = store.GetStats();
+    ASSERT_EQ(stats.num_hits + stats.num_misses, num_rows_visited);
+    LOG(INFO) << "cache_capacity " << cache_capacity << ": " << stats.num_rows << " rows, hit rate "
+              << static_cast<double>(stats.num_hits) / num_rows_visited << ", "
+              << stats.num_evictions << " evictions, " << num_rows_visited / ms * 1000
+              << " rows/s";
+  }
+  ASSERT_EQ(rmdir((storage_dir + "/test").c_str()), 0);
+  ASSERT_EQ(rmdir(storage_dir.c_str()), 0);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -0,0 +1,111 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/embedding/embedding_store.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <unistd.h>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+EmbeddingStoreOptions GetTestOptions(int64_t cache_capacity, const std::string& storage_dir) {
+  EmbeddingStoreOptions options;
+  options.name = "test";
+  options.embedding_dim = 16;
+  options.num_state_slots = 2;
+  options.num_shards = 4;
+  options.cache_capacity = cache_capacity;
+  options.storage_dir = storage_dir;
+  options.init_scale = 0.05;
+  options.seed = 7;
+  return options;
+}
+
+std::string MakeStorageDir() {
+  char dir[] = "/tmp/embedding_store_test_XXXXXX";
+  CHECK(mkdtemp(dir) != nullptr);
+  return dir;
+}
+
+std::vector<int64_t> GenIds(int64_t begin, int64_t end) {
+  std::vector<int64_t> ids;
+  FOR_RANGE(int64_t, id, begin, end) { ids.push_back(id * 7919 + 3); }
+  return ids;
+}
+
+}  // namespace
+
+TEST(EmbeddingStore, lookup_is_deterministic) {
+  const std::vector<int64_t> ids = GenIds(0, 1000);
+  EmbeddingStore store0(GetTestOptions(0, ""));
+  EmbeddingStore store1(GetTestOptions(0, ""));
+  std::vector<float> out0(ids.size() * 16);
+  std::vector<float> out1(ids.size() * 16);
+  store0.Lookup(ids.size(), ids.data(), out0.data());
+  // the other store sees the ids in the reverse order
+  std::vector<int64_t> reversed(ids.rbegin(), ids.rend());
+  store1.Lookup(reversed.size(), reversed.data(), out1.data());
+  FOR_RANGE(size_t, i, 0, ids.size()) {
+    FOR_RANGE(int64_t, j, 0, 16) {
+      ASSERT_EQ(out0[i * 16 + j], out1[(ids.size() - 1 - i) * 16 + j]);
+      ASSERT_LE(std::abs(out0[i * 16 + j]), 0.05f);
+    }
+  }
+  store0.Lookup(ids.size(), ids.data(), out1.data());
+  ASSERT_EQ(out0, out1);
+  const EmbeddingStoreStats stats = store0.GetStats();
+  ASSERT_EQ(stats.num_rows, 1000);
+  ASSERT_EQ(stats.num_misses, 1000);
+  ASSERT_EQ(stats.num_hits, 1000);
+  ASSERT_EQ(stats.num_evictions, 0);
+}
+
+TEST(EmbeddingStore, updates_survive_eviction) {
+  const std::string storage_dir = MakeStorageDir();
+  {
+    EmbeddingStore store(GetTestOptions(64, storage_dir));
+    ASSERT_EQ(store.row_size(), 48);
+    const std::vector<int64_t> ids = GenIds(0, 1000);
+    store.ForEachRow(ids.size(), ids.data(), [&](int64_t i, float* row) {
+      FOR_RANGE(int64_t, j, 0, 48) { row[j] = ids[i] + j; }
+    });
+    EmbeddingStoreStats stats = store.GetStats();
+    ASSERT_EQ(stats.num_rows, 1000);
+    ASSERT_LE(stats.num_cached_rows, 64);
+    ASSERT_GE(stats.num_evictions, 1000 - 64);
+    // read everything back twice, paging rows in and out of the cache
+    FOR_RANGE(int, pass, 0, 2) {
+      store.ForEachRow(ids.size(), ids.data(), [&](int64_t i, float* row) {
+        FOR_RANGE(int64_t, j, 0, 48) { ASSERT_EQ(row[j], ids[i] + j); }
+      });
+    }
+    std::vector<float> out(ids.size() * 16);
+    store.Lookup(ids.size(), ids.data(), out.data());
+    FOR_RANGE(size_t, i, 0, ids.size()) {
+      FOR_RANGE(int64_t, j, 0, 16) { ASSERT_EQ(out[i * 16 + j], ids[i] + j); }
+    }
+  }
+  // the spill files are removed together with the store
+  ASSERT_EQ(rmdir((storage_dir + "/test").c_str()), 0);
+  ASSERT_EQ(rmdir(storage_dir.c_str()), 0);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -15,32 +15,165 @@ limitations under the License.
 */
 #include "oneflow/core/framework/op_kernel_infer_cache.h"
 #include "oneflow/core/framework/op_kernel.h"
+#include <mutex>
+#include <thread>
 #include "oneflow/core/operator/operator.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/profiler.h"
 
 namespace oneflow {
 
 namespace user_op {
 
+class OpKernelInferCache::Storage final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(Storage);
+  explicit Storage(size_t max_size) : max_size_(max_size) { CHECK_GT(max_size_, 0); }
+  ~Storage() { Reset(); }
+
+  size_t max_size() const { return max_size_; }
+
+  bool Contains(const KeyType& key) const {
+    return cached_key2value_.find(Wrap(&key)) != cached_key2value_.end();
+  }
+
+  // Moves the hit entry to the most recently used end.
+  ValueType Get(const KeyType& key) {
+    auto it = cached_key2value_.find(Wrap(&key));
+    CHECK(it != cached_key2value_.end());
+    key_storage_.splice(key_storage_.end(), key_storage_, it->second.key_iter);
+    return it->second.value;
+  }
+
+  // Returns the number of the evicted least recently used entries.
+  size_t Put(const KeyType& key, const ValueType& value) {
+    size_t evicted_num = 0;
+    while (cached_key2value_.size() >= max_size_) {
+      CHECK_EQ(cached_key2value_.erase(Wrap(key_storage_.front().get())), 1);
+      key_storage_.pop_front();
+      ++evicted_num;
+    }
+    key_storage_.emplace_back(new KeyType(key));
+    Entry entry{value, std::prev(key_storage_.end())};
+    CHECK(cached_key2value_.emplace(Wrap(key_storage_.back().get()), entry).second);
+    return evicted_num;
+  }
+
+  void Reset() {
+    CHECK_EQ(cached_key2value_.size(), key_storage_.size());
+    HashMap to_release_key2values;
+    KeyStorage to_release_key_storage;
+    std::swap(cached_key2value_, to_release_key2values);
+    std::swap(key_storage_, to_release_key_storage);
+    if (to_release_key2values.size() <= kReleaseInIndependentThreadThreshold) {
+      to_release_key2values.clear();
+      to_release_key_storage.clear();
+    } else {
+      std::thread(
+          [](HashMap&& cache, KeyStorage&& key_storage) {
+            cache.clear();
+            key_storage.clear();
+          },
+          std::move(to_release_key2values), std::move(to_release_key_storage))
+          .detach();
+    }
+  }
+
+ private:
+  struct Entry {
+    ValueType value;
+    KeyStorage::iterator key_iter;
+  };
+  using HashMap = std::unordered_map<HashEqTraitPtr<const KeyType>, Entry>;
+
+  static HashEqTraitPtr<const KeyType> Wrap(const KeyType* key) {
+    return HashEqTraitPtr<const KeyType>(key, std::hash<KeyType>()(*key));
+  }
+
+  HashMap cached_key2value_;
+  // The least recently used key is at the front.
+  KeyStorage key_storage_;
+  size_t max_size_;
+};
+
+namespace {
+
+constexpr size_t kMinStorageSweepSize = 64;
+
+}  // namespace
+
+// Storages are shared on a thread only, since a kernel always runs on the thread
+// where its actor is constructed. The key has no input shapes.
+std::shared_ptr<OpKernelInferCache::Storage> OpKernelInferCache::FindOrCreateThreadLocalStorage(
+    const KeyType& key, size_t max_size) {
+  thread_local HashMap<KeyType, std::weak_ptr<Storage>> key2storage;
+  // Drops the storages of the destroyed caches whenever the map doubles, which keeps the sweeps
+  // amortized constant per lookup.
+  thread_local size_t sweep_size = kMinStorageSweepSize;
+  if (key2storage.size() >= sweep_size) {
+    for (auto it = key2storage.begin(); it != key2storage.end();) {
+      if (it->second.expired()) {
+        it = key2storage.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    sweep_size = std::max(kMinStorageSweepSize, key2storage.size() * 2);
+  }
+  std::weak_ptr<Storage>* weak_storage = &key2storage[key];
+  std::shared_ptr<Storage> storage = weak_storage->lock();
+  if (storage) {
+    CHECK_EQ(storage->max_size(), max_size);
+  } else {
+    storage.reset(new Storage(max_size));
+    *weak_storage = storage;
+  }
+  return storage;
+}
+
+namespace {
+
+std::mutex* CollectedStatsMutex() {
+  static std::mutex mutex;
+  return &mutex;
+}
+
+HashMap<std::string, OpKernelInferCacheStats>* MutCollectedStats() {
+  static HashMap<std::string, OpKernelInferCacheStats> op_name2stats;
+  return &op_name2stats;
+}
+
+}  // namespace
+
 OpKernelInferCache::OpKernelInferCache(const KernelConf& kernel_conf, const JobDesc& job_desc) {
   const OperatorConf& op_conf = kernel_conf.op_attribute().op_conf();
   std::shared_ptr<Operator> op = ConstructOp(op_conf, &job_desc);
+  op_name_ = op_conf.name();
   cache_key_.job_desc = &job_desc;
   cache_key_.op_conf_sym = op->GetOpConfWithoutOpNameAndLbn();
-  cache_key_.ibn_idx2shape_sym.resize(op->input_bns().size());
   cache_key_.dtype_signature_sym = SymbolOf(kernel_conf.dtype_signature());
+  const ResourceDesc* resource_desc = Global<ResourceDesc, ForSession>::Get();
+  const size_t max_size = resource_desc->op_kernel_infer_cache_size();
+  if (resource_desc->enable_shared_op_kernel_infer_cache()) {
+    storage_ = FindOrCreateThreadLocalStorage(cache_key_, max_size);
+  } else {
+    storage_.reset(new Storage(max_size));
+  }
+  cache_key_.ibn_idx2shape_sym.resize(op->input_bns().size());
 }
 
-bool OpKernelInferCache::IsCacheHit() const {
-  size_t hash_value = std::hash<KeyType>()(cache_key_);
-  HashEqTraitPtr<const KeyType> ptr_wrapper(&cache_key_, hash_value);
-  return cached_key2value_.find(ptr_wrapper) != cached_key2value_.end();
+OpKernelInferCache::~OpKernelInferCache() {
+  // nobody takes the stats without a profiler
+  if (Global<Profiler>::Get() == nullptr) { return; }
+  if (stats_.hits > 0 || stats_.misses > 0) { CollectOpKernelInferCacheStats(op_name_, stats_); }
 }
 
-OpKernelInferCache::ValueType OpKernelInferCache::GetCacheValue() const {
-  size_t hash_value = std::hash<KeyType>()(cache_key_);
-  HashEqTraitPtr<const KeyType> ptr_wrapper(&cache_key_, hash_value);
-  CHECK(cached_key2value_.find(ptr_wrapper) != cached_key2value_.end());
-  return cached_key2value_.at(ptr_wrapper);
+bool OpKernelInferCache::IsCacheHit() const { return storage_->Contains(cache_key_); }
+
+OpKernelInferCache::ValueType OpKernelInferCache::GetCacheValue() {
+  ++stats_.hits;
+  return storage_->Get(cache_key_);
 }
 
 void OpKernelInferCache::UpdateCacheKey(KernelInferContext* ctx) {
@@ -57,7 +190,7 @@ void OpKernelInferCache::UpdateCacheKey(KernelInferContext* ctx) {
 }
 
 void OpKernelInferCache::UpdateCacheValue(KernelInferContext* ctx) {
-  if (cached_key2value_.size() >= max_size_) { Reset(); }
+  ++stats_.misses;
   auto* cache_value = new OpInferCacheValue();
   cache_value->obn_idx2shape_sym.resize(ctx->outputs().size());
   FOR_RANGE(int, i, 0, ctx->outputs().size()) {
@@ -68,30 +201,25 @@ void OpKernelInferCache::UpdateCacheValue(KernelInferContext* ctx) {
     out_shape_view.ToShape(&out_shape);
     cache_value->obn_idx2shape_sym.at(i).reset(out_shape);
   }
-  KeyType* new_key = new KeyType(cache_key_);
-  key_storage_.emplace_back(new_key);
-  size_t hash_value = std::hash<KeyType>()(cache_key_);
-  HashEqTraitPtr<const KeyType> ptr_wrapper(new_key, hash_value);
-  CHECK(cached_key2value_.emplace(ptr_wrapper, ValueType(cache_value)).second);
+  stats_.evictions += storage_->Put(cache_key_, ValueType(cache_value));
 }
 
-void OpKernelInferCache::Reset() {
-  CHECK_EQ(cached_key2value_.size(), key_storage_.size());
-  HashMap to_release_key2values;
-  KeyStorage to_release_key_storage;
-  std::swap(cached_key2value_, to_release_key2values);
-  std::swap(key_storage_, to_release_key_storage);
-  if (to_release_key2values.size() <= kReleaseInIndependentThreadThreshold) {
-    to_release_key2values.clear();
-    to_release_key_storage.clear();
-  } else {
-    std::thread(
-        [](HashMap&& cache, KeyStorage&& key_storage) {
-          cache.clear();
-          key_storage.clear();
-        },
-        std::move(to_release_key2values), std::move(to_release_key_storage));
-  }
+void OpKernelInferCache::Reset() { storage_->Reset(); }
+
+void CollectOpKernelInferCacheStats(const std::string& op_name,
+                                    const OpKernelInferCacheStats& stats) {
+  std::unique_lock<std::mutex> lock(*CollectedStatsMutex());
+  OpKernelInferCacheStats* collected = &(*MutCollectedStats())[op_name];
+  collected->hits += stats.hits;
+  collected->misses += stats.misses;
+  collected->evictions += stats.evictions;
+}
+
+HashMap<std::string, OpKernelInferCacheStats> TakeCollectedOpKernelInferCacheStats() {
+  std::unique_lock<std::mutex> lock(*CollectedStatsMutex());
+  HashMap<std::string, OpKernelInferCacheStats> op_name2stats;
+  std::swap(op_name2stats, *MutCollectedStats());
+  return op_name2stats;
 }
 
 }  // namespace user_op
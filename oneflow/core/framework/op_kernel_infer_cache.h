@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_FRAMEWORK_OP_KERNEL_INFER_CACHE_H_
 #define ONEFLOW_CORE_FRAMEWORK_OP_KERNEL_INFER_CACHE_H_
 
+#include <list>
+#include <memory>
+
 #include "oneflow/core/operator/op_infer_cache.h"
 #include "oneflow/core/common/hash_eq_trait_ptr.h"
 #include "oneflow/core/kernel/kernel.pb.h"
@@ -26,30 +29,49 @@ namespace user_op {
 
 class KernelInferContext;
 
+struct OpKernelInferCacheStats {
+  int64_t hits = 0;
+  int64_t misses = 0;
+  int64_t evictions = 0;
+};
+
 class OpKernelInferCache final {
  public:
   using KeyType = OpInferCacheKey;
   using ValueType = std::shared_ptr<const OpInferCacheValue>;
-  using HashMap = std::unordered_map<HashEqTraitPtr<const KeyType>, ValueType>;
   using KeyStorage = std::list<std::unique_ptr<KeyType>>;
   static constexpr size_t kReleaseInIndependentThreadThreshold = 4096;
 
   OpKernelInferCache(const KernelConf& kernel_conf, const JobDesc& job_desc);
-  ~OpKernelInferCache() = default;
+  ~OpKernelInferCache();
 
   bool IsCacheHit() const;
-  ValueType GetCacheValue() const;
+  ValueType GetCacheValue();
   void UpdateCacheKey(KernelInferContext* ctx);
   void UpdateCacheValue(KernelInferContext* ctx);
   void Reset();
 
+  const OpKernelInferCacheStats& stats() const { return stats_; }
+
  private:
+  // Cached values in LRU order, which is shared by the kernels running on the same
+  // thread with the same op conf and dtype signature if enable_shared_op_kernel_infer_cache.
+  class Storage;
+  static std::shared_ptr<Storage> FindOrCreateThreadLocalStorage(const KeyType& key,
+                                                                 size_t max_size);
+
+  std::string op_name_;
   KeyType cache_key_;
-  HashMap cached_key2value_;
-  KeyStorage key_storage_;
-  size_t max_size_;
+  std::shared_ptr<Storage> storage_;
+  OpKernelInferCacheStats stats_;
 };
 
+// The stats of the destroyed caches are accumulated by op name if there is a profiler, and taken
+// by it.
+void CollectOpKernelInferCacheStats(const std::string& op_name,
+                                    const OpKernelInferCacheStats& stats);
+HashMap<std::string, OpKernelInferCacheStats> TakeCollectedOpKernelInferCacheStats();
+
 }  // namespace user_op
 
 }  // namespace oneflow
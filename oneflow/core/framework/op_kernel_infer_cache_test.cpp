@@ -0,0 +1,234 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/op_kernel_infer_cache.h"
+#include "oneflow/core/framework/op_kernel.h"
+#include "oneflow/core/framework/user_op_conf.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/job_desc.h"
+
+namespace oneflow {
+
+namespace user_op {
+
+namespace test {
+
+namespace {
+
+void NewGlobals(bool enable_shared_op_kernel_infer_cache) {
+  EnvProto env_proto;
+  auto* machine = env_proto.add_machine();
+  machine->set_id(0);
+  machine->set_addr("127.0.0.1");
+  env_proto.set_ctrl_port(9527);
+  Resource resource;
+  resource.set_machine_num(1);
+  resource.set_cpu_device_num(1);
+  resource.set_gpu_device_num(0);
+  resource.set_op_kernel_infer_cache_size(2);
+  resource.set_enable_shared_op_kernel_infer_cache(enable_shared_op_kernel_infer_cache);
+  Global<EnvDesc>::New(env_proto);
+  Global<ResourceDesc, ForSession>::New(resource);
+}
+
+void DeleteGlobals() {
+  Global<ResourceDesc, ForSession>::Delete();
+  Global<EnvDesc>::Delete();
+}
+
+JobConfigProto PredictJobConf() {
+  JobConfigProto job_conf;
+  job_conf.set_job_name("op_kernel_infer_cache_test");
+  job_conf.mutable_predict_conf();
+  return job_conf;
+}
+
+KernelConf ReluKernelConf(const std::string& op_name) {
+  KernelConf kernel_conf;
+  *kernel_conf.mutable_op_attribute()->mutable_op_conf() = UserOpConfWrapperBuilder(op_name)
+                                                               .Op("relu")
+                                                               .Input("in", "x/out_0")
+                                                               .Output("out")
+                                                               .Build()
+                                                               .op_conf();
+  return kernel_conf;
+}
+
+// the out shape of relu is the in shape, which is a 1-d shape of dim
+class FakeKernelInferContext final : public KernelInferContext {
+ public:
+  explicit FakeKernelInferContext(const KernelConf& kernel_conf)
+      : KernelInferContext(UserOpConfWrapper(kernel_conf.op_attribute().op_conf())),
+        inputs_({{"in", 0}}),
+        outputs_({{"out", 0}}) {}
+  ~FakeKernelInferContext() override = default;
+
+  void set_dim(int64_t dim) {
+    shape_ = Shape({dim});
+    shape_view_ = ShapeView(shape_);
+  }
+
+  const std::vector<std::pair<std::string, int32_t>>& inputs() const override { return inputs_; }
+  const std::vector<std::pair<std::string, int32_t>>& outputs() const override {
+    return outputs_;
+  }
+  const TensorDesc* TensorDesc4ArgNameAndIndex(const std::string&, int32_t) const override {
+    UNIMPLEMENTED();
+    return nullptr;
+  }
+  DeviceType device_type() const override { return DeviceType::kCPU; }
+  const ParallelContext& parallel_ctx() const override { return parallel_ctx_; }
+  DeviceCtx* device_ctx() override {
+    UNIMPLEMENTED();
+    return nullptr;
+  }
+  Tensor* Tensor4ArgNameAndIndex(const std::string&, int32_t) override {
+    UNIMPLEMENTED();
+    return nullptr;
+  }
+  const ShapeView& ShapeView4ArgNameAndIndex(const std::string&, int32_t) override {
+    return shape_view_;
+  }
+  MutShapeView* MutShapeView4ArgNameAndIndex(const std::string&, int32_t) override {
+    UNIMPLEMENTED();
+    return nullptr;
+  }
+
+ private:
+  std::vector<std::pair<std::string, int32_t>> inputs_;
+  std::vector<std::pair<std::string, int32_t>> outputs_;
+  ParallelContext parallel_ctx_;
+  Shape shape_;
+  ShapeView shape_view_;
+};
+
+// infers through the cache as the user kernel does, true on a hit
+bool Infer(OpKernelInferCache* cache, FakeKernelInferContext* ctx, int64_t dim) {
+  ctx->set_dim(dim);
+  cache->UpdateCacheKey(ctx);
+  if (cache->IsCacheHit()) {
+    CHECK(*cache->GetCacheValue()->obn_idx2shape_sym.at(0) == Shape({dim}));
+    return true;
+  }
+  cache->UpdateCacheValue(ctx);
+  return false;
+}
+
+// whether dim is cached, without changing the LRU order
+bool IsCached(OpKernelInferCache* cache, FakeKernelInferContext* ctx, int64_t dim) {
+  ctx->set_dim(dim);
+  cache->UpdateCacheKey(ctx);
+  return cache->IsCacheHit();
+}
+
+}  // namespace
+
+TEST(OpKernelInferCache, evict_least_recently_put) {
+  NewGlobals(false);
+  {
+    JobDesc job_desc(PredictJobConf(), 0);
+    const KernelConf kernel_conf = ReluKernelConf("relu");
+    OpKernelInferCache cache(kernel_conf, job_desc);
+    FakeKernelInferContext ctx(kernel_conf);
+    ASSERT_FALSE(Infer(&cache, &ctx, 1));
+    ASSERT_FALSE(Infer(&cache, &ctx, 2));
+    ASSERT_EQ(cache.stats().evictions, 0);
+    // the cache holds 2 values, so 3 evicts 1 which is put first
+    ASSERT_FALSE(Infer(&cache, &ctx, 3));
+    ASSERT_EQ(cache.stats().evictions, 1);
+    ASSERT_FALSE(IsCached(&cache, &ctx, 1));
+    ASSERT_TRUE(IsCached(&cache, &ctx, 2));
+    ASSERT_TRUE(IsCached(&cache, &ctx, 3));
+    ASSERT_FALSE(Infer(&cache, &ctx, 4));
+    ASSERT_EQ(cache.stats().evictions, 2);
+    ASSERT_FALSE(IsCached(&cache, &ctx, 2));
+    ASSERT_EQ(cache.stats().hits, 0);
+    ASSERT_EQ(cache.stats().misses, 4);
+  }
+  DeleteGlobals();
+}
+
+TEST(OpKernelInferCache, promote_on_hit) {
+  NewGlobals(false);
+  {
+    JobDesc job_desc(PredictJobConf(), 0);
+    const KernelConf kernel_conf = ReluKernelConf("relu");
+    OpKernelInferCache cache(kernel_conf, job_desc);
+    FakeKernelInferContext ctx(kernel_conf);
+    ASSERT_FALSE(Infer(&cache, &ctx, 1));
+    ASSERT_FALSE(Infer(&cache, &ctx, 2));
+    // the hit makes 1 the most recently used, so 3 evicts 2
+    ASSERT_TRUE(Infer(&cache, &ctx, 1));
+    ASSERT_FALSE(Infer(&cache, &ctx, 3));
+    ASSERT_TRUE(IsCached(&cache, &ctx, 1));
+    ASSERT_FALSE(IsCached(&cache, &ctx, 2));
+    ASSERT_TRUE(IsCached(&cache, &ctx, 3));
+    ASSERT_EQ(cache.stats().hits, 1);
+    ASSERT_EQ(cache.stats().misses, 3);
+    ASSERT_EQ(cache.stats().evictions, 1);
+  }
+  DeleteGlobals();
+}
+
+TEST(OpKernelInferCache, shared_storage) {
+  NewGlobals(true);
+  {
+    JobDesc job_desc(PredictJobConf(), 0);
+    // the key has no op name, so the kernels of relu0 and relu1 share one storage
+    const KernelConf kernel_conf0 = ReluKernelConf("relu0");
+    const KernelConf kernel_conf1 = ReluKernelConf("relu1");
+    FakeKernelInferContext ctx0(kernel_conf0);
+    FakeKernelInferContext ctx1(kernel_conf1);
+    {
+      OpKernelInferCache cache0(kernel_conf0, job_desc);
+      OpKernelInferCache cache1(kernel_conf1, job_desc);
+      ASSERT_FALSE(Infer(&cache0, &ctx0, 1));
+      ASSERT_FALSE(Infer(&cache1, &ctx1, 2));
+      ASSERT_TRUE(Infer(&cache1, &ctx1, 1));
+      ASSERT_FALSE(Infer(&cache0, &ctx0, 3));
+      // 1 is promoted by the hit of cache1, so the put of cache0 evicts 2
+      ASSERT_EQ(cache0.stats().evictions, 1);
+      ASSERT_TRUE(IsCached(&cache1, &ctx1, 1));
+      ASSERT_FALSE(IsCached(&cache1, &ctx1, 2));
+    }
+    // the storage is released with the last cache using it
+    OpKernelInferCache cache(kernel_conf0, job_desc);
+    ASSERT_FALSE(IsCached(&cache, &ctx0, 1));
+  }
+  DeleteGlobals();
+}
+
+TEST(OpKernelInferCache, unshared_storage) {
+  NewGlobals(false);
+  {
+    JobDesc job_desc(PredictJobConf(), 0);
+    const KernelConf kernel_conf0 = ReluKernelConf("relu0");
+    const KernelConf kernel_conf1 = ReluKernelConf("relu1");
+    FakeKernelInferContext ctx0(kernel_conf0);
+    FakeKernelInferContext ctx1(kernel_conf1);
+    OpKernelInferCache cache0(kernel_conf0, job_desc);
+    OpKernelInferCache cache1(kernel_conf1, job_desc);
+    ASSERT_FALSE(Infer(&cache0, &ctx0, 1));
+    ASSERT_FALSE(Infer(&cache1, &ctx1, 1));
+  }
+  DeleteGlobals();
+}
+
+}  // namespace test
+
+}  // namespace user_op
+
+}  // namespace oneflow
@@ -20,12 +20,18 @@ namespace oneflow {
 
 namespace user_op {
 
-Tensor::Tensor(Blob* blob) {
+Tensor::Tensor(Blob* blob) { Reset(blob); }
+
+void Tensor::Reset(Blob* blob) {
   dptr_ = blob->ForceMutDptr();
   shape_ = blob->shape();
   blob_access_checker_ = blob->blob_access_checker();
   if (blob->ForceMutShapeView()) {
-    mut_shape_.reset(new MutShapeView(*blob->ForceMutShapeView()));
+    if (mut_shape_) {
+      *mut_shape_ = *blob->ForceMutShapeView();
+    } else {
+      mut_shape_.reset(new MutShapeView(*blob->ForceMutShapeView()));
+    }
   } else {
     mut_shape_.reset();
   }
@@ -35,6 +35,8 @@ class Tensor final {
   Tensor(Tensor&& rhs) { *this = std::move(rhs); }
   void CopyWithoutData(const Tensor& rhs);
   Tensor& operator=(Tensor&& rhs);
+  // rebinds to blob, reusing the mut_shape_ allocation when possible
+  void Reset(Blob* blob);
 
   const ShapeView& shape() const { return shape_; }
   MutShapeView* mut_shape() {
@@ -127,6 +127,9 @@ class Graph {
   void AddAllocatedNode(NodeType*);
   void AddAllocatedEdge(EdgeType*);
   void DeleteNode(NodeType*);
+  // disconnects and frees the edges, or the nodes together with all their edges
+  void DeleteEdges(const HashSet<EdgeType*>& edges);
+  void DeleteNodes(const HashSet<NodeType*>& nodes);
 
   // ToDot
   template<typename StreamT>
@@ -272,6 +275,31 @@ void Graph<NodeType, EdgeType>::DeleteNode(NodeType* node) {
       nodes_, [node](const std::unique_ptr<NodeType>& node_ptr) { return node_ptr.get() == node; });
 }
 
+template<typename NodeType, typename EdgeType>
+void Graph<NodeType, EdgeType>::DeleteEdges(const HashSet<EdgeType*>& edges) {
+  if (edges.empty()) { return; }
+  for (EdgeType* edge : edges) { DisConnect(edge); }
+  Erase<std::vector<std::unique_ptr<EdgeType>>>(
+      edges_, [&](const std::unique_ptr<EdgeType>& edge_ptr) {
+        return edges.find(edge_ptr.get()) != edges.end();
+      });
+}
+
+template<typename NodeType, typename EdgeType>
+void Graph<NodeType, EdgeType>::DeleteNodes(const HashSet<NodeType*>& nodes) {
+  if (nodes.empty()) { return; }
+  HashSet<EdgeType*> edges;
+  for (NodeType* node : nodes) {
+    edges.insert(node->in_edges().begin(), node->in_edges().end());
+    edges.insert(node->out_edges().begin(), node->out_edges().end());
+  }
+  DeleteEdges(edges);
+  Erase<std::vector<std::unique_ptr<NodeType>>>(
+      nodes_, [&](const std::unique_ptr<NodeType>& node_ptr) {
+        return nodes.find(node_ptr.get()) != nodes.end();
+      });
+}
+
 template<typename NodeType, typename EdgeType>
 template<typename StreamT>
 void Graph<NodeType, EdgeType>::ToDotWithStream(StreamT& out_stream) const {
@@ -45,6 +45,74 @@ void UpdateJobParallelViewConf(
   for (const auto& obn : op_node.op().output_bns()) { Update(obn); }
 }
 
+// All of an op node its consumers are inferred from, to tell whether they have to be inferred
+// again after the node is
+class OpNodeOutputSignature final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(OpNodeOutputSignature);
+  explicit OpNodeOutputSignature(const OpNode& op_node) {
+    const Shape* time_shape = op_node.out_blob_time_shape();
+    if (time_shape != nullptr) { time_shape_.reset(new Shape(*time_shape)); }
+    for (const std::string& obn : op_node.op().output_bns()) {
+      const LogicalBlobId& lbi = op_node.op().BnInOp2Lbi(obn);
+      lbis_.push_back(lbi);
+      blob_descs_.emplace_back(new BlobDesc(op_node.LogicalBlobDesc4Lbi(lbi)));
+      sbp_parallels_.push_back(op_node.SbpParallel4Lbi(lbi));
+      batch_axes_.push_back(*CHECK_JUST(op_node.BatchAxis4Lbi(lbi)));
+      mirrored_parallels_.push_back(*CHECK_JUST(op_node.op().OptMirroredParallel4BnInOp(obn)));
+    }
+  }
+  ~OpNodeOutputSignature() = default;
+
+  bool operator==(const OpNodeOutputSignature& rhs) const {
+    if ((time_shape_ == nullptr) != (rhs.time_shape_ == nullptr)) { return false; }
+    if (time_shape_ != nullptr && *time_shape_ != *rhs.time_shape_) { return false; }
+    if (lbis_ != rhs.lbis_) { return false; }
+    FOR_RANGE(int64_t, i, 0, lbis_.size()) {
+      if (!(*blob_descs_.at(i) == *rhs.blob_descs_.at(i))) { return false; }
+      if (sbp_parallels_.at(i) != rhs.sbp_parallels_.at(i)) { return false; }
+      if (!PbMd().Equals(batch_axes_.at(i), rhs.batch_axes_.at(i))) { return false; }
+      if (!PbMd().Equals(mirrored_parallels_.at(i), rhs.mirrored_parallels_.at(i))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  std::unique_ptr<Shape> time_shape_;
+  std::vector<LogicalBlobId> lbis_;
+  std::vector<std::unique_ptr<BlobDesc>> blob_descs_;
+  std::vector<SbpParallel> sbp_parallels_;
+  std::vector<OptInt64> batch_axes_;
+  std::vector<OptMirroredParallel> mirrored_parallels_;
+};
+
+template<typename T>
+void InsertOpNamesOfChangedEntries(const PbMap<std::string, T>& old_map,
+                                   const PbMap<std::string, T>& new_map,
+                                   const std::function<bool(const T&, const T&)>& IsEqual,
+                                   HashSet<std::string>* op_names) {
+  for (const auto& pair : new_map) {
+    const auto& it = old_map.find(pair.first);
+    if (it == old_map.end() || !IsEqual(it->second, pair.second)) { op_names->insert(pair.first); }
+  }
+  for (const auto& pair : old_map) {
+    if (new_map.find(pair.first) == new_map.end()) { op_names->insert(pair.first); }
+  }
+}
+
+template<typename T>
+void CopyEntry(const PbMap<std::string, T>& from, const std::string& key,
+               PbMap<std::string, T>* to) {
+  const auto& it = from.find(key);
+  if (it == from.end()) {
+    to->erase(key);
+  } else {
+    (*to)[key] = it->second;
+  }
+}
+
 }  // namespace
 
 std::string OpEdge::VisualStr() const {
@@ -332,6 +400,7 @@ void OpNode::InferBlobParallelDesc() {
 }
 
 void OpNode::InitLbi2SourceNode() {
+  lbi2source_node_.clear();
   for (OpEdge* edge : in_edges()) {
     for (const LogicalBlobId& lbi : edge->lbis()) {
       CHECK(lbi2source_node_.emplace(lbi, edge->src_node()).second);
@@ -368,6 +437,16 @@ void OpNode::InitLbi2SbpParallel() {
   Update(op().output_bns());
 }
 
+void OpNode::ResetInferredStates() {
+  op_ = ConstructOp(op_->op_conf(), parallel_desc_.device_type(), &GlobalJobDesc());
+  obn2blob_parallel_desc_.clear();
+  out_blob_time_shape_.reset();
+  bn2parallel_id2blob_desc_.clear();
+  lbi2logical_blob_desc_.clear();
+  input_blob_fastest_time_shape_.reset();
+  lbi2sbp_parallel_.clear();
+}
+
 Maybe<OpGraph> OpGraph::New(const Job& job) {
   const auto& op_graph = std::make_shared<OpGraph>();
   JUST(op_graph->Init(job));
@@ -391,6 +470,160 @@ Maybe<void> OpGraph::Init(const Job& job) {
   return Maybe<void>::Ok();
 }
 
+Maybe<void> OpGraph::Update(const JobBuilder& job_builder) {
+  const Job& job = job_builder.job();
+  HashSet<std::string> touched_op_names(job_builder.touched_op_names());
+  bool is_identical_sbp_oba_pairs_changed = false;
+  if (job_builder.is_helper_touched()
+      && !PbMd().Equals(job.helper().identical_sbp_oba_pairs(), identical_sbp_oba_pairs_)) {
+    // sbp passed on between identical sbp op blob args may reach any op
+    is_identical_sbp_oba_pairs_changed = true;
+    for (const auto& pair : op_name2op_node_) { touched_op_names.insert(pair.first); }
+    for (const auto& op_conf : job.net().op()) { touched_op_names.insert(op_conf.name()); }
+  }
+  if (job_builder.is_job_parallel_view_conf_touched()) {
+    const JobParallelViewConf& conf = job.job_parallel_view_conf();
+    InsertOpNamesOfChangedEntries<SbpSignature>(
+        job_parallel_view_conf_.op_name2sbp_signature_conf(), conf.op_name2sbp_signature_conf(),
+        [](const SbpSignature& lhs, const SbpSignature& rhs) { return PbMd().Equals(lhs, rhs); },
+        &touched_op_names);
+    InsertOpNamesOfChangedEntries<bool>(job_parallel_view_conf_.op_name2is_mirrored_parallel_view(),
+                                        conf.op_name2is_mirrored_parallel_view(),
+                                        [](bool lhs, bool rhs) { return lhs == rhs; },
+                                        &touched_op_names);
+  }
+  if (touched_op_names.empty()) { return Maybe<void>::Ok(); }
+  if (is_identical_sbp_oba_pairs_changed) {
+    InitJobParallelViewConf(job);
+  } else {
+    auto* inferred_sbp_conf = inferred_job_parallel_view_conf_.mutable_op_name2sbp_signature_conf();
+    auto* inferred_mirrored_conf =
+        inferred_job_parallel_view_conf_.mutable_op_name2is_mirrored_parallel_view();
+    for (const std::string& op_name : touched_op_names) {
+      CopyEntry(job.job_parallel_view_conf().op_name2sbp_signature_conf(), op_name,
+                inferred_sbp_conf);
+      CopyEntry(job.job_parallel_view_conf().op_name2is_mirrored_parallel_view(), op_name,
+                inferred_mirrored_conf);
+    }
+    job_parallel_view_conf_ = job.job_parallel_view_conf();
+  }
+  // nodes of touched ops are built again, remembering what their consumers saw of them
+  HashMap<std::string, std::unique_ptr<OpNodeOutputSignature>> op_name2old_output_signature;
+  HashSet<OpNode*> removing_nodes;
+  for (const std::string& op_name : touched_op_names) {
+    const auto& it = op_name2op_node_.find(op_name);
+    if (it == op_name2op_node_.end()) { continue; }
+    op_name2old_output_signature[op_name].reset(new OpNodeOutputSignature(*it->second));
+    removing_nodes.insert(it->second);
+    op_name2op_node_.erase(it);
+  }
+  DeleteNodes(removing_nodes);
+  HashSet<OpNode*> new_nodes;
+  {
+    auto ParallelConf4OpName = MakeGetterParallelConf4OpName(job.placement());
+    op_names_.clear();
+    for (const auto& op_conf : job.net().op()) {
+      op_names_.push_back(op_conf.name());
+      if (touched_op_names.count(op_conf.name()) == 0) { continue; }
+      OpNode* node = new OpNode(ParallelDesc(*ParallelConf4OpName(op_conf.name())), op_conf);
+      AddAllocatedNode(node);
+      CHECK(op_name2op_node_.emplace(op_conf.name(), node).second)
+          << "op_name: " << op_conf.name();
+      new_nodes.insert(node);
+    }
+  }
+  CHECK_EQ(op_name2op_node_.size(), op_names_.size());
+  producer_op_name2ctrl_consumer_op_names_.clear();
+  InitProducerOpName2CtrlConsumerOpNames(job);
+  // the new nodes and the consumers of touched ops get their in edges connected again
+  HashSet<OpNode*> reconnecting_nodes(new_nodes);
+  {
+    HashSet<OpEdge*> removing_edges;
+    ForEachNode([&](OpNode* op_node) {
+      if (new_nodes.count(op_node) > 0) { return; }
+      for (const std::string& ibn : op_node->op().input_bns()) {
+        if (touched_op_names.count(op_node->op().BnInOp2Lbi(ibn).op_name()) > 0) {
+          reconnecting_nodes.insert(op_node);
+          removing_edges.insert(op_node->in_edges().begin(), op_node->in_edges().end());
+          break;
+        }
+      }
+    });
+    DeleteEdges(removing_edges);
+  }
+  ConnectInEdges([&](const std::function<void(OpNode*)>& Handler) {
+    for (OpNode* op_node : reconnecting_nodes) { Handler(op_node); }
+  });
+  for (OpNode* op_node : reconnecting_nodes) { op_node->InitLbi2SourceNode(); }
+  CheckIsDAG();
+  // inference goes downstream from the new nodes as long as outputs keep changing
+  HashSet<OpNode*> inferring_nodes(new_nodes);
+  HashSet<OpNode*> inferred_nodes;
+  JUST(TopoForEachNodeWithErrorCaptured([&](OpNode* op_node) -> Maybe<void> {
+    if (inferring_nodes.count(op_node) == 0) { return Maybe<void>::Ok(); }
+    std::unique_ptr<OpNodeOutputSignature> old_output_signature;
+    if (new_nodes.count(op_node) > 0) {
+      const auto& it = op_name2old_output_signature.find(op_node->op().op_name());
+      if (it != op_name2old_output_signature.end()) {
+        old_output_signature = std::move(it->second);
+      }
+    } else {
+      old_output_signature.reset(new OpNodeOutputSignature(*op_node));
+      op_node->ResetInferredStates();
+    }
+    InferOpNodeTimeShape(op_node);
+    JUST(InferOpNodeSignatureAndLogicalBlobDesc(op_node));
+    inferred_nodes.insert(op_node);
+    if (!old_output_signature || !(*old_output_signature == OpNodeOutputSignature(*op_node))) {
+      op_node->ForEachNodeOnOutEdge([&](OpNode* consumer) { inferring_nodes.insert(consumer); });
+    }
+    return Maybe<void>::Ok();
+  }));
+  HashSet<OpEdge*> edges;
+  for (const auto* nodes : {&reconnecting_nodes, &inferred_nodes}) {
+    for (OpNode* op_node : *nodes) {
+      edges.insert(op_node->in_edges().begin(), op_node->in_edges().end());
+      edges.insert(op_node->out_edges().begin(), op_node->out_edges().end());
+    }
+  }
+  for (OpEdge* edge : edges) { edge->InitDistributeHierarchyInfo(); }
+  InferBlobLastUsed();
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> OpGraph::CheckSameAs(const OpGraph& other) const {
+  CHECK_OR_RETURN(op_names_ == other.op_names_) << "op names differ";
+  CHECK_OR_RETURN(producer_op_name2ctrl_consumer_op_names_
+                  == other.producer_op_name2ctrl_consumer_op_names_)
+      << "ctrl edges differ";
+  auto InLbns4OpNode = [](const OpNode* op_node) {
+    HashSet<std::string> in_lbns;
+    for (const OpEdge* edge : op_node->in_edges()) {
+      for (const LogicalBlobId& lbi : edge->lbis()) {
+        in_lbns.insert(edge->src_node()->op().op_name() + ":" + GenLogicalBlobName(lbi));
+      }
+    }
+    return in_lbns;
+  };
+  for (const std::string& op_name : op_names_) {
+    const OpNode* op_node = op_name2op_node_.at(op_name);
+    const OpNode* other_op_node = other.op_name2op_node_.at(op_name);
+    CHECK_OR_RETURN(PbMd().Equals(op_node->op().op_conf(), other_op_node->op().op_conf()))
+        << "op_conf of " << op_name << " differs";
+    CHECK_OR_RETURN(op_node->parallel_desc() == other_op_node->parallel_desc())
+        << "parallel_desc of " << op_name << " differs";
+    CHECK_OR_RETURN(InLbns4OpNode(op_node) == InLbns4OpNode(other_op_node))
+        << "in edges of " << op_name << " differ";
+    CHECK_OR_RETURN(op_node->out_edges().size() == other_op_node->out_edges().size())
+        << "out edges of " << op_name << " differ";
+    CHECK_OR_RETURN(PbMd().Equals(op_node->sbp_signature(), other_op_node->sbp_signature()))
+        << "sbp signature of " << op_name << " differs";
+    CHECK_OR_RETURN(OpNodeOutputSignature(*op_node) == OpNodeOutputSignature(*other_op_node))
+        << "inferred outputs of " << op_name << " differ";
+  }
+  return Maybe<void>::Ok();
+}
+
 void OpGraph::CheckIsDAG() const {
   CHECK(!FindFirstNontrivialSCC());
   auto ForEachIn = [&](OpNode* node, const std::function<void(OpNode*)>& Handler) {
@@ -412,6 +645,11 @@ void OpGraph::InitNodes(const Job& job) {
 }
 
 void OpGraph::InitEdges() {
+  ConnectInEdges([&](const std::function<void(OpNode*)>& Handler) { ForEachNode(Handler); });
+}
+
+void OpGraph::ConnectInEdges(
+    const std::function<void(const std::function<void(OpNode*)>&)>& ForEachConsumer) {
   HashMap<LogicalBlobId, OpNode*> lbi2producer;
   HashMap<std::string, std::shared_ptr<HashMap<LogicalBlobId, std::string>>>
       producer_op_name2lbi2obn;
@@ -424,7 +662,7 @@ void OpGraph::InitEdges() {
       CHECK(lbi2obn->emplace(lbi, obn).second);
     }
   });
-  ForEachNode([&](OpNode* op_node) {
+  ForEachConsumer([&](OpNode* op_node) {
     HashMap<std::string, HashSet<LogicalBlobId>> producer_op_name2lbis;
     std::shared_ptr<HashMap<LogicalBlobId, std::vector<std::string>>> consumer_lbi2ibns(
         new HashMap<LogicalBlobId, std::vector<std::string>>);
@@ -468,17 +706,19 @@ void OpGraph::InferBlobLastUsed() const {
 }
 
 void OpGraph::InferTimeShape() const {
-  TopoForEachNode([&](OpNode* op_node) {
-    ParallelContext parallel_ctx;
-    parallel_ctx.set_parallel_id(0);
-    parallel_ctx.set_parallel_num(op_node->parallel_desc().parallel_num());
-    auto GetInputBlobTimeShape = [&](const std::string& bn_in_op) {
-      return op_node->GetInputBlobTimeShape(bn_in_op);
-    };
-    op_node->InitInputBlobFastestTimeShape();
-    CHECK_JUST(op_node->op().InferOutputBlobTimeShapeIf(GetInputBlobTimeShape, &parallel_ctx,
-                                                        op_node->mut_out_blob_time_shape()));
-  });
+  TopoForEachNode([&](OpNode* op_node) { InferOpNodeTimeShape(op_node); });
+}
+
+void OpGraph::InferOpNodeTimeShape(OpNode* op_node) const {
+  ParallelContext parallel_ctx;
+  parallel_ctx.set_parallel_id(0);
+  parallel_ctx.set_parallel_num(op_node->parallel_desc().parallel_num());
+  auto GetInputBlobTimeShape = [&](const std::string& bn_in_op) {
+    return op_node->GetInputBlobTimeShape(bn_in_op);
+  };
+  op_node->InitInputBlobFastestTimeShape();
+  CHECK_JUST(op_node->op().InferOutputBlobTimeShapeIf(GetInputBlobTimeShape, &parallel_ctx,
+                                                      op_node->mut_out_blob_time_shape()));
 }
 
 void OpGraph::InferOpNodeSbpSignature(OpNode* op_node, const SbpSignature& sbp_sig_conf) const {
@@ -560,59 +800,71 @@ const OpNode* OpGraph::OpNode4OpName(const std::string& op_name) const {
   return op_node_it->second;
 }
 
-Maybe<void> OpGraph::InferLogicalBlobDesc(const Job& job) const {
-  JobParallelViewConf job_parallel_view_conf(job.job_parallel_view_conf());
-  HashMap<OpBlobArg, std::vector<OpBlobArg>> oba2sbp_identical_obas;
-  for (const auto& pair : job.helper().identical_sbp_oba_pairs().pair()) {
-    oba2sbp_identical_obas[pair.first()].push_back(pair.second());
-    oba2sbp_identical_obas[pair.second()].push_back(pair.first());
+void OpGraph::InitJobParallelViewConf(const Job& job) {
+  job_parallel_view_conf_ = job.job_parallel_view_conf();
+  inferred_job_parallel_view_conf_ = job.job_parallel_view_conf();
+  identical_sbp_oba_pairs_ = job.helper().identical_sbp_oba_pairs();
+  oba2sbp_identical_obas_.clear();
+  for (const auto& pair : identical_sbp_oba_pairs_.pair()) {
+    oba2sbp_identical_obas_[pair.first()].push_back(pair.second());
+    oba2sbp_identical_obas_[pair.second()].push_back(pair.first());
   }
+}
+
+Maybe<void> OpGraph::InferLogicalBlobDesc(const Job& job) {
+  InitJobParallelViewConf(job);
   JUST(TopoForEachNodeWithErrorCaptured([&](OpNode* op_node) -> Maybe<void> {
-    // Infer ParallelSignature
-    JUST(op_node->mut_op()->InferParallelSignatureIf());
-    // Infer batch_axis
-    const auto& BatchAxis4Ibn = [&](const std::string& ibn) -> Maybe<const OptInt64*> {
-      const auto& lbi = op_node->op().BnInOp2Lbi(ibn);
-      const auto* producer = op_node->MutSrcNode4InputLbi(lbi);
-      CHECK_NOTNULL_OR_RETURN(producer);
-      return producer->op().BatchAxis4BnInOp(*JUST(producer->op().obn4lbi(lbi)));
-    };
-    const auto& LogicalBlobDesc4Ibn = [&](const std::string& ibn) -> const BlobDesc& {
-      const auto& ibns = op_node->op().input_bns();
-      CHECK(std::find(ibns.begin(), ibns.end(), ibn) != ibns.end());
-      return op_node->LogicalBlobDesc4Lbi(op_node->op().BnInOp2Lbi(ibn));
-    };
-    JUST(op_node->mut_op()->InferBatchAxisIf(LogicalBlobDesc4Ibn, BatchAxis4Ibn));
-    // Infer mirrored_signature
-    bool is_mirrored_conf = false;
-    {
-      const auto& op_name2is_mirrored = job_parallel_view_conf.op_name2is_mirrored_parallel_view();
-      const auto& iter = op_name2is_mirrored.find(op_node->op().op_name());
-      if (iter != op_name2is_mirrored.end()) { is_mirrored_conf = iter->second; }
-    }
-    JUST(InferOpNodeMirroredSignature(op_node, is_mirrored_conf));
-    // Infer sbp_signature
-    SbpSignature sbp_sig_conf;
-    {
-      const auto& op_name2sbp_sig_conf = job_parallel_view_conf.op_name2sbp_signature_conf();
-      const auto& iter = op_name2sbp_sig_conf.find(op_node->op().op_name());
-      if (iter != op_name2sbp_sig_conf.end()) { sbp_sig_conf = iter->second; }
-    }
-    InferOpNodeSbpSignature(op_node, sbp_sig_conf);
-    op_node->InferBlobParallelDesc();
-    UpdateJobParallelViewConf(*op_node, oba2sbp_identical_obas, &job_parallel_view_conf);
-    // Infer logical_blob_desc
-    JUST(InferOpNodeLogicalBlobDesc(op_node));
-    // Fill logical blob_desc signature.
-    JUST(op_node->mut_op()->FillLogicalBlobDescSignature(
-        [&](const std::string& bn_in_op) -> Maybe<const BlobDesc*> {
-          return &op_node->LogicalBlobDesc4Lbi(op_node->op().BnInOp2Lbi(bn_in_op));
-        }));
-    return Maybe<void>::Ok();
+    return InferOpNodeSignatureAndLogicalBlobDesc(op_node);
   }));
   return Maybe<void>::Ok();
 }
 
+Maybe<void> OpGraph::InferOpNodeSignatureAndLogicalBlobDesc(OpNode* op_node) {
+  // Infer ParallelSignature
+  JUST(op_node->mut_op()->InferParallelSignatureIf());
+  // Infer batch_axis
+  const auto& BatchAxis4Ibn = [&](const std::string& ibn) -> Maybe<const OptInt64*> {
+    const auto& lbi = op_node->op().BnInOp2Lbi(ibn);
+    const auto* producer = op_node->MutSrcNode4InputLbi(lbi);
+    CHECK_NOTNULL_OR_RETURN(producer);
+    return producer->op().BatchAxis4BnInOp(*JUST(producer->op().obn4lbi(lbi)));
+  };
+  const auto& LogicalBlobDesc4Ibn = [&](const std::string& ibn) -> const BlobDesc& {
+    const auto& ibns = op_node->op().input_bns();
+    CHECK(std::find(ibns.begin(), ibns.end(), ibn) != ibns.end());
+    return op_node->LogicalBlobDesc4Lbi(op_node->op().BnInOp2Lbi(ibn));
+  };
+  JUST(op_node->mut_op()->InferBatchAxisIf(LogicalBlobDesc4Ibn, BatchAxis4Ibn));
+  // Infer mirrored_signature
+  bool is_mirrored_conf = false;
+  {
+    const auto& op_name2is_mirrored =
+        inferred_job_parallel_view_conf_.op_name2is_mirrored_parallel_view();
+    const auto& iter = op_name2is_mirrored.find(op_node->op().op_name());
+    if (iter != op_name2is_mirrored.end()) { is_mirrored_conf = iter->second; }
+  }
+  JUST(InferOpNodeMirroredSignature(op_node, is_mirrored_conf));
+  // Infer sbp_signature
+  SbpSignature sbp_sig_conf;
+  {
+    const auto& op_name2sbp_sig_conf =
+        inferred_job_parallel_view_conf_.op_name2sbp_signature_conf();
+    const auto& iter = op_name2sbp_sig_conf.find(op_node->op().op_name());
+    if (iter != op_name2sbp_sig_conf.end()) { sbp_sig_conf = iter->second; }
+  }
+  InferOpNodeSbpSignature(op_node, sbp_sig_conf);
+  op_node->InferBlobParallelDesc();
+  UpdateJobParallelViewConf(*op_node, oba2sbp_identical_obas_, &inferred_job_parallel_view_conf_);
+  // Infer logical_blob_desc
+  JUST(InferOpNodeLogicalBlobDesc(op_node));
+  // Fill logical blob_desc signature.
+  JUST(op_node->mut_op()->FillLogicalBlobDescSignature(
+      [&](const std::string& bn_in_op) -> Maybe<const BlobDesc*> {
+        return &op_node->LogicalBlobDesc4Lbi(op_node->op().BnInOp2Lbi(bn_in_op));
+      }));
+  return Maybe<void>::Ok();
+}
+
 BalancedSplitter OpGraph::GetBalancedSplitter(const std::string& op_name,
                                               const LogicalBlobId& lbi) const {
   OpNode* op_node = op_name2op_node_.at(GetOpNameKey(op_name, lbi));
@@ -27,6 +27,7 @@ namespace oneflow {
 
 class OpEdge;
 class OpGraph;
+class JobBuilder;
 
 class OpNode final : public Node<OpNode, OpEdge> {
  public:
@@ -89,6 +90,8 @@ class OpNode final : public Node<OpNode, OpEdge> {
   void InitInputBlobFastestTimeShape();
   void InitLbi2SbpParallel();
   void InitLbi2MirroredParallel();
+  // a fresh op and nothing inferred, keeping the node and its edges
+  void ResetInferredStates();
 
   ParallelDesc parallel_desc_;
   HashMap<std::string, ParallelDesc> obn2blob_parallel_desc_;
@@ -172,18 +175,30 @@ class OpGraph final : public Graph<OpNode, OpEdge> {
   void DumpBatchAxisLbi(Job* job) const;
 
   Maybe<void> Init(const Job& job);
+  // Brings the graph in line with job_builder.job() after ops were added, removed or changed
+  // through job_builder. Only the nodes of those ops are rebuilt, and only they and the nodes
+  // downstream of them whose inputs turn out to change are inferred again.
+  Maybe<void> Update(const JobBuilder& job_builder);
+  // Fails at the first node, edge, sbp signature or inferred output of an op that differs
+  // between the two graphs, to check an updated graph against one built from the job again
+  Maybe<void> CheckSameAs(const OpGraph& other) const;
 
  private:
   void InitNodes(const Job& job);
   void InitEdges();
+  void ConnectInEdges(
+      const std::function<void(const std::function<void(OpNode*)>&)>& ForEachConsumer);
   void InitProducerOpName2CtrlConsumerOpNames(const Job& job);
+  void InitJobParallelViewConf(const Job& job);
   void CheckIsDAG() const;
   void InferBlobLastUsed() const;
   void InferTimeShape() const;
+  void InferOpNodeTimeShape(OpNode* op_node) const;
   void InferOpNodeSbpSignature(OpNode* op_node, const SbpSignature& sbp_sig_conf) const;
   Maybe<void> InferOpNodeMirroredSignature(OpNode* op_node, bool is_mirrored_conf) const;
   Maybe<void> InferOpNodeLogicalBlobDesc(OpNode* op_node) const;
-  Maybe<void> InferLogicalBlobDesc(const Job& job) const;
+  Maybe<void> InferOpNodeSignatureAndLogicalBlobDesc(OpNode* op_node);
+  Maybe<void> InferLogicalBlobDesc(const Job& job);
   bool IsBatchAxisBlob(const std::string& op_name, const LogicalBlobId& lbi) const;
   std::string GetOpNameKey(const std::string& op_name, const LogicalBlobId& lbi) const;
   LogicalBlobId GetLogicalBlobIdKey(const std::string& op_name, const LogicalBlobId& lbi) const;
@@ -194,6 +209,13 @@ class OpGraph final : public Graph<OpNode, OpEdge> {
   HashMap<std::string, OpNode*> op_name2op_node_;
   std::list<std::string> op_names_;
   HashMap<std::string, HashSet<std::string>> producer_op_name2ctrl_consumer_op_names_;
+
+  // job_parallel_view_conf of the job as of the last Init or Update, and the one inference reads,
+  // into which the sbp of inferred op blob args is passed on to their identical sbp pairs
+  JobParallelViewConf job_parallel_view_conf_;
+  JobParallelViewConf inferred_job_parallel_view_conf_;
+  OpBlobArgPairs identical_sbp_oba_pairs_;
+  HashMap<OpBlobArg, std::vector<OpBlobArg>> oba2sbp_identical_obas_;
 };
 
 }  // namespace oneflow
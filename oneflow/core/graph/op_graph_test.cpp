@@ -0,0 +1,169 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/graph/op_graph.h"
+#include "oneflow/core/framework/user_op_conf.h"
+#include "oneflow/core/job/job_builder.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/resource_desc.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+void NewGlobals() {
+  EnvProto env_proto;
+  auto* machine = env_proto.add_machine();
+  machine->set_id(0);
+  machine->set_addr("127.0.0.1");
+  env_proto.set_ctrl_port(9527);
+  Resource resource;
+  resource.set_machine_num(1);
+  resource.set_cpu_device_num(1);
+  resource.set_gpu_device_num(0);
+  Global<EnvDesc>::New(env_proto);
+  Global<ResourceDesc, ForSession>::New(resource);
+}
+
+void DeleteGlobals() {
+  Global<ResourceDesc, ForSession>::Delete();
+  Global<EnvDesc>::Delete();
+}
+
+JobConfigProto PredictJobConf() {
+  JobConfigProto job_conf;
+  job_conf.set_job_name("op_graph_test");
+  job_conf.mutable_predict_conf();
+  return job_conf;
+}
+
+ParallelConf CpuParallelConf() {
+  ParallelConf parallel_conf;
+  parallel_conf.set_device_tag("cpu");
+  parallel_conf.add_device_name("0:0");
+  return parallel_conf;
+}
+
+OperatorConf Constant(const std::string& op_name, const Shape& shape) {
+  return user_op::UserOpConfWrapperBuilder(op_name)
+      .Op("constant")
+      .Attr<double>("floating_value", 1)
+      .Attr<int64_t>("integer_value", 0)
+      .Attr<bool>("is_floating_value", true)
+      .Attr<DataType>("dtype", DataType::kFloat)
+      .Attr<Shape>("shape", shape)
+      .Output("out")
+      .Build()
+      .op_conf();
+}
+
+OperatorConf Relu(const std::string& op_name, const std::string& in) {
+  return user_op::UserOpConfWrapperBuilder(op_name)
+      .Op("relu")
+      .Input("in", in)
+      .Output("out")
+      .Build()
+      .op_conf();
+}
+
+OperatorConf Add(const std::string& op_name, const std::string& x, const std::string& y) {
+  return user_op::UserOpConfWrapperBuilder(op_name)
+      .Op("add_n")
+      .Input("in", x)
+      .Input("in", y)
+      .Output("out")
+      .Build()
+      .op_conf();
+}
+
+// x -> relu0 -> relu1 -> relu2, and y -> relu3
+Job ReluChainJob() {
+  Job job;
+  JobBuilder job_builder(&job);
+  job_builder.AddOps(CpuParallelConf(),
+                     {Constant("x", Shape({4, 8})), Relu("relu0", "x/out_0"),
+                      Relu("relu1", "relu0/out_0"), Relu("relu2", "relu1/out_0"),
+                      Constant("y", Shape({4, 8})), Relu("relu3", "y/out_0")});
+  return job;
+}
+
+// applies Edit through a JobBuilder, updates op_graph and checks it against a graph built anew
+void TestUpdate(Job* job, OpGraph* op_graph, const std::function<void(JobBuilder*)>& Edit) {
+  JobBuilder job_builder(job);
+  Edit(&job_builder);
+  ASSERT_TRUE(op_graph->Update(job_builder).IsOk());
+  const OpGraph rebuilt_op_graph(*job);
+  const Maybe<void> is_same = op_graph->CheckSameAs(rebuilt_op_graph);
+  ASSERT_TRUE(is_same.IsOk()) << is_same.GetSerializedError();
+}
+
+}  // namespace
+
+TEST(OpGraph, update) {
+  NewGlobals();
+  {
+    GlobalJobDescScope scope(PredictJobConf(), 0);
+    Job job = ReluChainJob();
+    OpGraph op_graph(job);
+    // a consumer of two existing blobs
+    TestUpdate(&job, &op_graph, [](JobBuilder* job_builder) {
+      job_builder->AddOps(CpuParallelConf(), {Add("add", "relu2/out_0", "relu3/out_0")});
+    });
+    // a changed shape has to reach all the way down to add
+    TestUpdate(&job, &op_graph, [](JobBuilder* job_builder) {
+      job_builder->MutOpsOnlyOnce({Constant("x", Shape({4, 8, 1}))});
+      job_builder->MutOpsOnlyOnce({Constant("y", Shape({4, 8, 1}))});
+    });
+    ASSERT_EQ(op_graph.GetLogicalBlobDesc(GenLogicalBlobId("add/out_0")).shape(),
+              Shape({4, 8, 1}));
+    // a consumer moved to another producer
+    TestUpdate(&job, &op_graph, [](JobBuilder* job_builder) {
+      job_builder->MutOpsOnlyOnce({Relu("relu2", "relu0/out_0")});
+    });
+    // a ctrl edge only
+    TestUpdate(&job, &op_graph, [](JobBuilder* job_builder) {
+      OperatorConf relu3 = job_builder->OpConf4OpName("relu3");
+      relu3.add_ctrl_in_op_name("relu1");
+      job_builder->MutOpsOnlyOnce({relu3});
+    });
+    // removed ops
+    TestUpdate(&job, &op_graph, [](JobBuilder* job_builder) {
+      job_builder->DelOps(std::vector<std::string>{"add", "relu2"});
+    });
+    ASSERT_EQ(op_graph.node_num(), 5);
+  }
+  DeleteGlobals();
+}
+
+TEST(OpGraph, check_same_as) {
+  NewGlobals();
+  {
+    GlobalJobDescScope scope(PredictJobConf(), 0);
+    Job job = ReluChainJob();
+    const OpGraph op_graph(job);
+    ASSERT_TRUE(op_graph.CheckSameAs(OpGraph(job)).IsOk());
+    // an edit the graph was not updated for is caught
+    JobBuilder job_builder(&job);
+    job_builder.MutOpsOnlyOnce({Constant("y", Shape({2, 8}))});
+    ASSERT_FALSE(op_graph.CheckSameAs(OpGraph(job)).IsOk());
+  }
+  DeleteGlobals();
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -0,0 +1,167 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/act_event_profile.h"
+#include "oneflow/core/job/job_desc.h"
+#include "oneflow/core/actor/act_event_logger.h"
+#include "oneflow/core/persistence/persistent_out_stream.h"
+#include "oneflow/core/common/protobuf.h"
+#include <iomanip>
+#include <sstream>
+
+namespace oneflow {
+
+REGISTER_FUNCTION_CONFIG_DEF()
+    .String("act_event_profile_dir", "",
+            "directory of act event profiles keyed by plan fingerprint, register_num is improved "
+            "from a matching profile without an experiment run")
+    .Bool("enable_online_regst_num_tuning", false,
+          "profile the first acts of the normal run and save them to act_event_profile_dir, the "
+          "next launch widens register_num of the bottleneck regsts from that profile")
+    .Int64("online_regst_num_tuning_act_num", 32, "acts per actor profiled by the online tuning")
+    .String("__act_event_profile_fingerprint__", "", "set by the compiler");
+
+namespace {
+
+const char* const kFingerprintFlagName = "__act_event_profile_fingerprint__";
+
+uint64_t Fnv1aHash(const std::string& str) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : str) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+void ParseActEventsOfJob(const Plan& plan, int64_t job_id, const std::string& act_event_filepath,
+                         std::list<std::unique_ptr<ActEvent>>* act_events) {
+  HashSet<int64_t> actor_ids;
+  for (const TaskProto& task : plan.task()) {
+    if (task.job_id() == job_id) { actor_ids.insert(task.task_id()); }
+  }
+  ParseActEvents(act_event_filepath, act_events);
+  act_events->remove_if([&](const std::unique_ptr<ActEvent>& act_event) {
+    return actor_ids.find(act_event->actor_id()) == actor_ids.end();
+  });
+}
+
+void WriteActEventProfile(const std::list<std::unique_ptr<ActEvent>>& act_events,
+                          const std::string& profile_path) {
+  LocalFS()->RecursivelyCreateDirIfNotExist(Dirname(profile_path));
+  PersistentOutStream out_stream(LocalFS(), profile_path);
+  for (const auto& act_event : act_events) { out_stream << *act_event; }
+  LOG(INFO) << "save " << act_events.size() << " act events to " << profile_path;
+}
+
+}  // namespace
+
+std::string ActEventProfileFingerprint(const Plan& naive_plan) {
+  std::vector<const TaskProto*> tasks;
+  for (const TaskProto& task : naive_plan.task()) { tasks.push_back(&task); }
+  std::sort(tasks.begin(), tasks.end(), [](const TaskProto* lhs, const TaskProto* rhs) {
+    return lhs->task_id() < rhs->task_id();
+  });
+  std::ostringstream canonical;
+  for (const TaskProto* task : tasks) {
+    canonical << task->task_id() << ":" << task->task_type() << ":" << task->machine_id() << ":"
+              << task->thrd_id() << "[";
+    for (const ExecNodeProto& exec_node : task->exec_sequence().exec_node()) {
+      canonical << exec_node.kernel_conf().op_attribute().op_conf().name() << ",";
+    }
+    std::map<std::string, const RegstDescProto*> name2regst_desc;
+    for (const auto& pair : task->produced_regst_desc()) {
+      name2regst_desc.emplace(pair.first, &pair.second);
+    }
+    for (const auto& pair : name2regst_desc) {
+      canonical << pair.first << "=" << pair.second->regst_desc_id() << ">";
+      for (int64_t consumer : pair.second->consumer_task_id()) { canonical << consumer << ","; }
+    }
+    canonical << "]";
+  }
+  std::ostringstream fingerprint;
+  fingerprint << std::hex << std::setw(16) << std::setfill('0') << Fnv1aHash(canonical.str());
+  return fingerprint.str();
+}
+
+std::string ActEventProfilePath(const std::string& profile_dir, const std::string& fingerprint) {
+  return JoinPath(profile_dir, "act_event_profile_" + fingerprint + ".bin");
+}
+
+void SetActEventProfileFingerprint(const std::string& fingerprint, Plan* plan) {
+  for (auto& pair : *plan->mutable_job_confs()->mutable_job_id2job_conf()) {
+    (*pair.second.mutable_flag_name2flag_value())[kFingerprintFlagName].set_at_string(
+        fingerprint);
+  }
+}
+
+std::string GetActEventProfileFingerprint(const JobConfigProto& job_conf) {
+  const auto& iter = job_conf.flag_name2flag_value().find(kFingerprintFlagName);
+  if (iter == job_conf.flag_name2flag_value().end()) { return ""; }
+  return iter->second.at_string();
+}
+
+void SaveActEventProfile(const Plan& plan, int64_t job_id, const std::string& act_event_filepath,
+                         const std::string& profile_path) {
+  std::list<std::unique_ptr<ActEvent>> act_events;
+  ParseActEventsOfJob(plan, job_id, act_event_filepath, &act_events);
+  WriteActEventProfile(act_events, profile_path);
+}
+
+double CalcAchievedII(const std::list<std::unique_ptr<ActEvent>>& act_events) {
+  HashMap<int64_t, std::vector<double>> actor_id2start_times;
+  for (const auto& act_event : act_events) {
+    actor_id2start_times[act_event->actor_id()].push_back(act_event->start_time());
+  }
+  double achieved_ii = 0;
+  for (auto& pair : actor_id2start_times) {
+    std::vector<double>& start_times = pair.second;
+    if (start_times.size() < 2) { continue; }
+    std::sort(start_times.begin(), start_times.end());
+    achieved_ii = std::max(achieved_ii, (start_times.back() - start_times.front())
+                                            / (start_times.size() - 1));
+  }
+  return achieved_ii;
+}
+
+int64_t OnlineRegstNumTuningActNum(const Plan& plan) {
+  int64_t act_num = 0;
+  for (const auto& pair : plan.job_confs().job_id2job_conf()) {
+    JobDesc job_desc(pair.second, pair.first);
+    if (!job_desc.Bool("enable_online_regst_num_tuning")) { continue; }
+    CHECK(!job_desc.String("act_event_profile_dir").empty())
+        << "enable_online_regst_num_tuning requires act_event_profile_dir";
+    act_num = std::max(act_num, job_desc.Int64("online_regst_num_tuning_act_num"));
+  }
+  return act_num;
+}
+
+void SaveOnlineRegstNumTuningProfiles(const Plan& plan, const std::string& act_event_filepath) {
+  for (const auto& pair : plan.job_confs().job_id2job_conf()) {
+    JobDesc job_desc(pair.second, pair.first);
+    if (!job_desc.Bool("enable_online_regst_num_tuning")) { continue; }
+    const std::string fingerprint = GetActEventProfileFingerprint(pair.second);
+    CHECK(!fingerprint.empty());
+    const std::string profile_path =
+        ActEventProfilePath(job_desc.String("act_event_profile_dir"), fingerprint);
+    std::list<std::unique_ptr<ActEvent>> act_events;
+    ParseActEventsOfJob(plan, pair.first, act_event_filepath, &act_events);
+    LOG(INFO) << "job " << job_desc.job_name() << " achieved initiation interval "
+              << CalcAchievedII(act_events) / 1e6 << " ms";
+    WriteActEventProfile(act_events, profile_path);
+  }
+}
+
+}  // namespace oneflow
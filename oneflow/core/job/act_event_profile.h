@@ -0,0 +1,48 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_ACT_EVENT_PROFILE_H_
+#define ONEFLOW_CORE_JOB_ACT_EVENT_PROFILE_H_
+
+#include "oneflow/core/job/plan.pb.h"
+#include "oneflow/core/actor/act_event.pb.h"
+
+namespace oneflow {
+
+// An act event profile is the act events of one job saved under a fingerprint of its naive
+// plan, so that a later launch of the same job can improve register_num from it directly
+// instead of running an experiment runtime first.
+
+std::string ActEventProfileFingerprint(const Plan& naive_plan);
+std::string ActEventProfilePath(const std::string& profile_dir, const std::string& fingerprint);
+
+// the fingerprint travels with the job conf so that the merged runtime plan still knows it
+void SetActEventProfileFingerprint(const std::string& fingerprint, Plan* plan);
+std::string GetActEventProfileFingerprint(const JobConfigProto& job_conf);
+
+void SaveActEventProfile(const Plan& plan, int64_t job_id, const std::string& act_event_filepath,
+                         const std::string& profile_path);
+
+// mean interval between two consecutive acts of the slowest actor
+double CalcAchievedII(const std::list<std::unique_ptr<ActEvent>>& act_events);
+
+// number of acts per actor logged by a normal runtime for online register_num tuning, 0 if off
+int64_t OnlineRegstNumTuningActNum(const Plan& plan);
+// saves the profiles of jobs with online register_num tuning and reports their achieved ii
+void SaveOnlineRegstNumTuningProfiles(const Plan& plan, const std::string& act_event_filepath);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_ACT_EVENT_PROFILE_H_
@@ -0,0 +1,55 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/act_event_profile.h"
+
+namespace oneflow {
+
+namespace {
+
+void AddActEvent(int64_t actor_id, double start_time,
+                 std::list<std::unique_ptr<ActEvent>>* act_events) {
+  auto act_event = std::make_unique<ActEvent>();
+  act_event->set_actor_id(actor_id);
+  act_event->set_start_time(start_time);
+  act_events->emplace_back(std::move(act_event));
+}
+
+}  // namespace
+
+TEST(ActEventProfile, achieved_ii_is_set_by_the_slowest_actor) {
+  std::list<std::unique_ptr<ActEvent>> act_events;
+  FOR_RANGE(int64_t, i, 0, 5) { AddActEvent(0, 10.0 * i, &act_events); }
+  FOR_RANGE(int64_t, i, 0, 5) { AddActEvent(1, 3.0 + 20.0 * (4 - i), &act_events); }
+  AddActEvent(2, 1000.0, &act_events);
+  ASSERT_DOUBLE_EQ(CalcAchievedII(act_events), 20.0);
+}
+
+TEST(ActEventProfile, fingerprint_ignores_task_order) {
+  Plan plan;
+  FOR_RANGE(int64_t, i, 0, 3) {
+    TaskProto* task = plan.add_task();
+    task->set_task_id(i);
+    task->set_machine_id(0);
+    task->set_thrd_id(i);
+  }
+  Plan reversed_plan;
+  for (int64_t i = 2; i >= 0; --i) { *reversed_plan.add_task() = plan.task(i); }
+  ASSERT_EQ(ActEventProfileFingerprint(plan), ActEventProfileFingerprint(reversed_plan));
+  plan.mutable_task(1)->set_thrd_id(7);
+  ASSERT_NE(ActEventProfileFingerprint(plan), ActEventProfileFingerprint(reversed_plan));
+}
+
+}  // namespace oneflow
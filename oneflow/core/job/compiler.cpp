@@ -15,12 +15,21 @@ limitations under the License.
 */
 #include "oneflow/core/job/compiler.h"
 #include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/plan_util.h"
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/graph/op_graph.h"
 #include "oneflow/core/job_rewriter/job_completer.h"
 
 namespace oneflow {
 
+REGISTER_FUNCTION_CONFIG_DEF()
+    .String("comm_net_lossless_codec", "",
+            "lossless codec of model diff regsts sent over the epoll comm net: \"\" or \"zlib\"")
+    .Bool("enable_comm_net_float16_cast", false,
+          "send model diff regsts of float blobs over the epoll comm net as float16 (lossy)")
+    .Int64("comm_net_codec_min_byte_size", 64 * 1024,
+           "regsts smaller than this are always sent over the comm net uncompressed");
+
 void Compiler::GenNetTopo(Plan* plan) const {
   HashMap<int64_t, int64_t> rid2mid;
   HashMap<int64_t, int64_t> tid2mid;
@@ -95,6 +104,7 @@ void Compiler::Compile(Job* job, Plan* plan, bool need_job_complete) const {
   // TODO: update method for fw bw split
   // if (job_desc.IsTrain()) { task_gph->AddReduceNoBwForwardNodeOverlapingCtrlEdges(); }
 
+  const int64_t first_task_idx = plan->task_size();
   task_gph->ForEachNode([&](TaskNode* task_node) {
     if (task_node->IsMeaningLess()) { return; }
     task_node->ToProto(plan->mutable_task()->Add());
@@ -103,6 +113,7 @@ void Compiler::Compile(Job* job, Plan* plan, bool need_job_complete) const {
     auto* job_id2job_conf = plan->mutable_job_confs()->mutable_job_id2job_conf();
     (*job_id2job_conf)[GlobalJobDesc().job_id()] = GlobalJobDesc().job_conf();
   }
+  PlanUtil::SetCommNetCodec(job_desc, first_task_idx, plan);
   // TODO: fix .dot generate
   // GenNetTopo(plan);
   Global<OpGraph>::Delete();
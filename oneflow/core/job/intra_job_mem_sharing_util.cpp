@@ -18,8 +18,13 @@ limitations under the License.
 #include "oneflow/core/common/str_util.h"
 #include "oneflow/core/common/shape.h"
 #include "oneflow/core/job/id_manager.h"
+#include "oneflow/core/job/mem_block_local_search.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/register/runtime_register_desc.h"
 #include "oneflow/core/thread/thread_pool.h"
+#include <map>
 
 namespace oneflow {
 
@@ -27,6 +32,7 @@ enum MemAllocAlgoType {
   kMemSizeFirstAlgo = 0,
   kMutualExclusionFirstAlgo = 1,
   kTimeLineAlgo = 2,
+  kLocalSearchAlgo = 3,
 };
 
 }  // namespace oneflow
@@ -584,6 +590,64 @@ void MemReusedAlgorithm_TimeLineAlgo(
   result->mem_block_size = bfc_allocator.buffer_size();
 }
 
+void GenMemReuseIntervals(const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
+                          const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline,
+                          std::vector<RegstDescProto*>* regst_descs,
+                          std::vector<MemReuseInterval>* intervals) {
+  CHECK_EQ(alloc_regsts_timeline.size(), free_regsts_timeline.size());
+  HashMap<RegstDescProto*, int64_t> regst_desc2free_index;
+  for (int64_t i = 0; i < free_regsts_timeline.size(); ++i) {
+    for (RegstDescProto* regst_desc : free_regsts_timeline.at(i)) {
+      CHECK(regst_desc2free_index.emplace(regst_desc, i).second);
+    }
+  }
+  HashMap<RegstDescProto*, int64_t> regst_desc2alloc_index;
+  regst_descs->clear();
+  for (int64_t i = 0; i < alloc_regsts_timeline.size(); ++i) {
+    for (RegstDescProto* regst_desc : alloc_regsts_timeline.at(i)) {
+      CHECK(regst_desc2alloc_index.emplace(regst_desc, i).second);
+      regst_descs->push_back(regst_desc);
+    }
+  }
+  // HashSet iteration order is not stable, keep the search reproducible
+  std::sort(regst_descs->begin(), regst_descs->end(),
+            [](const RegstDescProto* lhs, const RegstDescProto* rhs) {
+              return lhs->regst_desc_id() < rhs->regst_desc_id();
+            });
+  intervals->clear();
+  for (RegstDescProto* regst_desc : *regst_descs) {
+    intervals->push_back(MemReuseInterval{RtRegstDesc(*regst_desc).TotalMainByteSize4AllRegst(),
+                                          regst_desc2alloc_index.at(regst_desc),
+                                          regst_desc2free_index.at(regst_desc)});
+  }
+}
+
+int64_t MemSizeLowerBound(const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
+                          const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline) {
+  std::vector<RegstDescProto*> regst_descs;
+  std::vector<MemReuseInterval> intervals;
+  GenMemReuseIntervals(alloc_regsts_timeline, free_regsts_timeline, &regst_descs, &intervals);
+  return oneflow::MemSizeLowerBound(intervals);
+}
+
+void MemReusedAlgorithm_LocalSearchAlgo(
+    const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
+    const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline, MemBlockResultInfo* result) {
+  std::vector<RegstDescProto*> regst_descs;
+  std::vector<MemReuseInterval> intervals;
+  GenMemReuseIntervals(alloc_regsts_timeline, free_regsts_timeline, &regst_descs, &intervals);
+  const int64_t max_iterations =
+      GlobalJobDesc().job_conf().memory_allocation_algorithm_conf().local_search_max_iterations();
+  std::vector<int64_t> offsets;
+  const int64_t mem_block_size = LocalSearchMemBlockOffsets(intervals, max_iterations, &offsets);
+  HashMap<RegstDescProto*, int64_t>* regst_desc2offset = &(result->regst_desc2offset);
+  regst_desc2offset->clear();
+  FOR_RANGE(int64_t, i, 0, regst_descs.size()) {
+    CHECK(regst_desc2offset->emplace(regst_descs.at(i), offsets.at(i)).second);
+  }
+  result->mem_block_size = std::max<int64_t>(mem_block_size, 1);
+}
+
 void SelectAlgorithmGenMemBlockOffset4Regsts(
     MemAllocAlgoType algo_id, const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
     const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline,
@@ -601,6 +665,9 @@ void SelectAlgorithmGenMemBlockOffset4Regsts(
     case kTimeLineAlgo:
       MemReusedAlgorithm_TimeLineAlgo(alloc_regsts_timeline, free_regsts_timeline, result);
       break;
+    case kLocalSearchAlgo:
+      MemReusedAlgorithm_LocalSearchAlgo(alloc_regsts_timeline, free_regsts_timeline, result);
+      break;
     default: UNIMPLEMENTED();
   }
   CHECK_GT(result->mem_block_size, 0);
@@ -614,6 +681,7 @@ int64_t CountMemAllocAlgoNum() {
   if (mem_alloc_algo_conf.use_mem_size_first_algo()) { ++ret; }
   if (mem_alloc_algo_conf.use_mutual_exclusion_first_algo()) { ++ret; }
   if (mem_alloc_algo_conf.use_time_line_algo()) { ++ret; }
+  if (mem_alloc_algo_conf.use_local_search_algo()) { ++ret; }
   CHECK_GE(ret, 0);
   return ret;
 }
@@ -631,6 +699,41 @@ void InitAlgo2Result(HashMap<MemAllocAlgoType, MemBlockResultInfo>* algo2result)
   if (mem_alloc_algo_conf.use_time_line_algo()) {
     CHECK(algo2result->emplace(kTimeLineAlgo, MemBlockResultInfo()).second);
   }
+  if (mem_alloc_algo_conf.use_local_search_algo()) {
+    CHECK(algo2result->emplace(kLocalSearchAlgo, MemBlockResultInfo()).second);
+  }
+}
+
+std::string MemAllocAlgoName(MemAllocAlgoType algo_id) {
+  switch (algo_id) {
+    case kMemSizeFirstAlgo: return "mem_size_first";
+    case kMutualExclusionFirstAlgo: return "mutual_exclusion_first";
+    case kTimeLineAlgo: return "time_line";
+    case kLocalSearchAlgo: return "local_search";
+    default: UNIMPLEMENTED();
+  }
+  return "";
+}
+
+void LogMemBlockReuseReport(const MemBlockReuseReport& report) {
+  std::map<std::pair<int64_t, int64_t>, std::pair<int64_t, int64_t>> device2size_and_lower_bound;
+  for (const MemBlockReuseInfo& info : report.mem_block()) {
+    auto* size_and_lower_bound =
+        &device2size_and_lower_bound[std::make_pair(info.machine_id(), info.device_id())];
+    size_and_lower_bound->first += info.mem_size();
+    size_and_lower_bound->second += info.mem_size_lower_bound();
+  }
+  for (const auto& pair : device2size_and_lower_bound) {
+    const std::string device =
+        pair.first.second == -1 ? "host" : "device " + std::to_string(pair.first.second);
+    LOG(INFO) << "job " << report.job_id() << " machine " << pair.first.first << " " << device
+              << " reused mem " << pair.second.first / 1048576.0 << " MB, lower bound "
+              << pair.second.second / 1048576.0 << " MB";
+  }
+  if (Global<ResourceDesc, ForSession>::Get()->enable_debug_mode()) {
+    TeePersistentLogStream::Create("mem_block_reuse_report_" + std::to_string(report.job_id()))
+        ->Write(report);
+  }
 }
 
 }  // namespace
@@ -691,15 +794,32 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(Plan* plan,
   }
 
   // step 3: choose best one for each mem chain and set offset for inplace consumer regst
+  MemBlockReuseReport report;
+  report.set_job_id(GlobalJobDesc().job_id());
   for (const auto& pair : mem_chain2algo2result) {
     const MemBlockResultInfo* best_result = nullptr;
+    MemAllocAlgoType best_algo_id = kMemSizeFirstAlgo;
     for (const auto& algo_result_pair : pair.second) {
       if (!best_result || algo_result_pair.second.mem_block_size < best_result->mem_block_size) {
         best_result = &algo_result_pair.second;
+        best_algo_id = algo_result_pair.first;
       }
     }
     CHECK(best_result != nullptr);
     int64_t mem_block_id = Global<IDMgr>::Get()->NewMemBlockId();
+    {
+      const RegstDescProto* regst_desc = best_result->regst_desc2offset.begin()->first;
+      MemBlockReuseInfo* info = report.mutable_mem_block()->Add();
+      info->set_mem_block_id(mem_block_id);
+      info->set_machine_id(mem_chain2sorted_tasks.at(pair.first).front()->machine_id());
+      if (regst_desc->mem_case().has_device_cuda_mem()) {
+        info->set_device_id(regst_desc->mem_case().device_cuda_mem().device_id());
+      }
+      info->set_algo(MemAllocAlgoName(best_algo_id));
+      info->set_mem_size(best_result->mem_block_size);
+      info->set_mem_size_lower_bound(MemSizeLowerBound(mem_chain2task2alloc_regsts.at(pair.first),
+                                                       mem_chain2task2free_regsts.at(pair.first)));
+    }
     CHECK_EQ(mem_chain2mem_reused_regsts.at(pair.first).size(),
              (best_result->regst_desc2offset.size()
               + mem_chain2consumer2inplaced_regst.at(pair.first).size()));
@@ -720,6 +840,7 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(Plan* plan,
       consumer_regst_desc->set_mem_block_offset(inplaced_regst_desc->mem_block_offset());
     }
   }
+  LogMemBlockReuseReport(report);
 }
 
 }  // namespace oneflow
@@ -920,18 +920,25 @@ Maybe<void> LazyJobBuildAndInferCtx::Complete() {
   if (GlobalJobDesc().Bool("__is_user_function__")) {
     JUST(DoPass("CompleteOfrecordDecoder"));
     JUST(DoPass("SetDefaultVariableConf"));
+    JUST(DoPass("FoldBatchNormPass"));
+    JUST(DoPass("ConstantFoldingPass"));
     JUST(DoPass("AutoMixedPrecision"));
+    JUST(DoPass("CancelTransposeReshapeCastPass"));
     JUST(DoPass("TieUpChainHeadersUnReachableFromAnyVariableOps"));
     JUST(DoPass("NonDistributedOptimizerPass"));
     JUST(DoPass("AutoTrainStep"));
     JUST(DoPass("AutoLearningRate"));
+    JUST(DoPass("GlobalSbpSearchPass"));
     JUST(DoPass("GenerateBackwardAndOptimizerOpConfs"));
+    JUST(DoPass("EmbeddingStoreOptimizerPass"));
+    JUST(DoPass("ActivationRecomputationPass"));
     JUST(DoPass("PruneCastToStaticShapeOpsPass"));
     JUST(DoPass("IndexedSlicesOptimizerRewritePass"));
     JUST(DoPass("SplitSparseSoftmaxCrossEntropyOpPass"));
     JUST(DoPass("DoParallelCastBeforeWideningTypeCast"));
     JUST(DoPass("AddLbiDiffWatcherOpConfs"));
     JUST(DoPass("PruneParallelCastOpsPass"));
+    JUST(DoPass("FuseElementwiseOpsPass"));
     JUST(DoPass("DumpVariableInfoPass"));
   }
   JUST(DoPass("DumpTimeShapeAndBlobParallelConfPass"));
@@ -949,6 +956,7 @@ Maybe<void> EagerJobBuildAndInferCtx::Complete() {
   JUST(DoPass("AutoTrainStep"));
   JUST(DoPass("AutoLearningRate"));
   JUST(DoPass("GenerateBackwardAndOptimizerOpConfs"));
+  JUST(DoPass("EmbeddingStoreOptimizerPass"));
   JUST(DoPass("AddLbiDiffWatcherOpConfs"));
   JUST(EagerRunOps(job(), &executed_op_names_, &ForeignCallback::EagerInterpretCompletedOp));
   return Maybe<void>::Ok();
@@ -34,7 +34,8 @@ std::function<const ParallelConf*(const std::string&)> MakeGetterParallelConf4Op
   };
 }
 
-JobBuilder::JobBuilder(Job* job) : job_(job) {
+JobBuilder::JobBuilder(Job* job)
+    : job_(job), is_helper_touched_(false), is_job_parallel_view_conf_touched_(false) {
   FOR_RANGE(int32_t, i, 0, job->net().op_size()) {
     CHECK(op_name2op_conf_.emplace(job->net().op(i).name(), job->mutable_net()->mutable_op(i))
               .second);
@@ -68,6 +69,7 @@ JobBuilder::JobBuilder(Job* job) : job_(job) {
 OperatorConf* JobBuilder::MutableOpConf4OpName(const std::string& op_name) {
   const auto& it = op_name2op_conf_.find(op_name);
   CHECK(it != op_name2op_conf_.end());
+  touched_op_names_.insert(op_name);
   return it->second;
 }
 
@@ -94,6 +96,7 @@ void JobBuilder::AddOps(const ParallelConf& parallel_conf,
     placemnt_group->mutable_op_set()->add_op_name(op_conf.name());
     CHECK(op_name2parallel_conf_.emplace(op_conf.name(), placemnt_group->mutable_parallel_conf())
               .second);
+    touched_op_names_.insert(op_conf.name());
   }
 }
 
@@ -110,6 +113,7 @@ PlacementGroup* JobBuilder::FindPlacementGroup(const std::string& op_name) const
 void JobBuilder::MutParallelConfOnlyOnce(const std::string& op_name,
                                          const ParallelConf& parallel_conf) {
   CHECK(modified_parallel_conf_op_names_.emplace(op_name).second);
+  touched_op_names_.insert(op_name);
   PlacementGroup* placement_group = FindPlacementGroup(op_name);
   {
     auto* const op_names = placement_group->mutable_op_set()->mutable_op_name();
@@ -126,6 +130,7 @@ void JobBuilder::RemoveOpByName(const std::string& op_name) {
 }
 
 void JobBuilder::RemoveOpByName(const std::unordered_set<std::string>& removing_names) {
+  touched_op_names_.insert(removing_names.begin(), removing_names.end());
   // Update net
   DLNetConf net = job_->net();
   job_->mutable_net()->clear_op();
@@ -191,6 +196,7 @@ void JobBuilder::MutOpsOnlyOnce(const std::vector<OperatorConf>& op_confs) {
   for (const auto& op_conf : op_confs) {
     CHECK(modified_op_conf_op_names_.emplace(op_conf.name()).second);
     op_name2op_conf_.at(op_conf.name())->CopyFrom(op_conf);
+    touched_op_names_.insert(op_conf.name());
   }
 }
 
@@ -234,16 +240,19 @@ void JobBuilder::AddParallelConf4OpName(const std::string& op_name,
     group->mutable_op_set()->add_op_name(op_name);
     *(group->mutable_parallel_conf()) = parallel_conf;
     op_name2parallel_conf_[op_name] = group->mutable_parallel_conf();
+    touched_op_names_.insert(op_name);
   }
 }
 
 SbpParallel* JobBuilder::MutSbpParallel4Oba(const OpBlobArg& oba) const {
+  is_job_parallel_view_conf_touched_ = true;
   auto* sbp_sig = &(
       *job_->mutable_job_parallel_view_conf()->mutable_op_name2sbp_signature_conf())[oba.op_name()];
   return &(*sbp_sig->mutable_bn_in_op2sbp_parallel())[oba.bn_in_op()];
 }
 
 void JobBuilder::BindIdenticalSbpOpBlobArgPair(const OpBlobArg& first, const OpBlobArg& second) {
+  is_helper_touched_ = true;
   auto* pair = job_->mutable_helper()->mutable_identical_sbp_oba_pairs()->mutable_pair()->Add();
   *pair->mutable_first() = first;
   *pair->mutable_second() = second;
@@ -257,6 +266,7 @@ const SbpSignature& JobBuilder::SbpSignature4OpName(const std::string& op_name)
 
 void JobBuilder::AddSbpSignature4OpName(const std::string& op_name,
                                         const SbpSignature& sbp_signature) {
+  touched_op_names_.insert(op_name);
   const auto& it = op_name2sbp_signature_conf_.find(op_name);
   if (it != op_name2sbp_signature_conf_.end()) {
     *(it->second) = sbp_signature;
@@ -37,11 +37,21 @@ class JobBuilder final {
   ~JobBuilder() = default;
 
   const Job& job() const { return *job_; }
-  JobHelperConf* mutable_helper() { return job_->mutable_helper(); }
+  JobHelperConf* mutable_helper() {
+    is_helper_touched_ = true;
+    return job_->mutable_helper();
+  }
   JobParallelViewConf* mutable_job_parallel_view_conf() {
+    is_job_parallel_view_conf_touched_ = true;
     return job_->mutable_job_parallel_view_conf();
   }
 
+  // ops added, removed or changed through this builder, so that an OpGraph of the job can be
+  // updated instead of built again
+  const HashSet<std::string>& touched_op_names() const { return touched_op_names_; }
+  bool is_helper_touched() const { return is_helper_touched_; }
+  bool is_job_parallel_view_conf_touched() const { return is_job_parallel_view_conf_touched_; }
+
   const OperatorConf& OpConf4OpName(const std::string& op_name) const;
   OperatorConf* MutableOpConf4OpName(const std::string& op_name);
 
@@ -87,6 +97,10 @@ class JobBuilder final {
   HashMap<std::string, SbpSignature*> op_name2sbp_signature_conf_;
   HashMap<std::string, OpTimeShape*> op_name2time_shapes_;
   HashMap<std::string, OptInt64*> lbn2batch_axis_;
+
+  HashSet<std::string> touched_op_names_;
+  bool is_helper_touched_;
+  mutable bool is_job_parallel_view_conf_touched_;
 };
 
 }  // namespace oneflow
@@ -0,0 +1,163 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/mem_block_local_search.h"
+#include <numeric>
+#include <random>
+
+namespace oneflow {
+
+int64_t MemSizeLowerBound(const std::vector<MemReuseInterval>& intervals) {
+  int64_t num_steps = 0;
+  for (const MemReuseInterval& interval : intervals) {
+    CHECK_LE(interval.alloc_index, interval.free_index);
+    num_steps = std::max(num_steps, interval.free_index + 2);
+  }
+  std::vector<int64_t> size_delta(num_steps, 0);
+  for (const MemReuseInterval& interval : intervals) {
+    size_delta.at(interval.alloc_index) += interval.size;
+    size_delta.at(interval.free_index + 1) -= interval.size;
+  }
+  int64_t alive_size = 0;
+  int64_t lower_bound = 0;
+  for (int64_t delta : size_delta) {
+    alive_size += delta;
+    lower_bound = std::max(lower_bound, alive_size);
+  }
+  return lower_bound;
+}
+
+BestFitPlacer::BestFitPlacer(const std::vector<MemReuseInterval>& intervals)
+    : intervals_(intervals), conflicts_(intervals.size()) {
+  std::vector<int64_t> by_alloc_index(intervals.size());
+  std::iota(by_alloc_index.begin(), by_alloc_index.end(), 0);
+  std::sort(by_alloc_index.begin(), by_alloc_index.end(), [&](int64_t lhs, int64_t rhs) {
+    return intervals.at(lhs).alloc_index < intervals.at(rhs).alloc_index;
+  });
+  FOR_RANGE(int64_t, i, 0, by_alloc_index.size()) {
+    const MemReuseInterval& lhs = intervals.at(by_alloc_index.at(i));
+    FOR_RANGE(int64_t, j, i + 1, by_alloc_index.size()) {
+      const MemReuseInterval& rhs = intervals.at(by_alloc_index.at(j));
+      if (rhs.alloc_index > lhs.free_index) { break; }
+      conflicts_.at(by_alloc_index.at(i)).push_back(by_alloc_index.at(j));
+      conflicts_.at(by_alloc_index.at(j)).push_back(by_alloc_index.at(i));
+    }
+  }
+}
+
+int64_t BestFitPlacer::Place(const std::vector<int64_t>& order,
+                             std::vector<int64_t>* offsets) const {
+  offsets->assign(intervals_.size(), -1);
+  int64_t mem_block_size = 0;
+  std::vector<std::pair<int64_t, int64_t>> occupied;
+  for (int64_t interval : order) {
+    const int64_t size = intervals_.at(interval).size;
+    occupied.clear();
+    for (int64_t conflict : conflicts_.at(interval)) {
+      const int64_t offset = offsets->at(conflict);
+      if (offset == -1) { continue; }
+      occupied.emplace_back(offset, offset + intervals_.at(conflict).size);
+    }
+    std::sort(occupied.begin(), occupied.end());
+    int64_t best_offset = -1;
+    int64_t best_gap = GetMaxVal<int64_t>();
+    int64_t top = 0;
+    for (const auto& range : occupied) {
+      const int64_t gap = range.first - top;
+      if (gap >= size && gap < best_gap) {
+        best_gap = gap;
+        best_offset = top;
+      }
+      top = std::max(top, range.second);
+    }
+    if (best_offset == -1) { best_offset = top; }
+    offsets->at(interval) = best_offset;
+    mem_block_size = std::max(mem_block_size, best_offset + size);
+  }
+  return mem_block_size;
+}
+
+void BestFitPlacer::GetPeakIntervals(const std::vector<int64_t>& offsets, int64_t mem_block_size,
+                                     std::vector<int64_t>* peak_intervals) const {
+  peak_intervals->clear();
+  FOR_RANGE(int64_t, i, 0, intervals_.size()) {
+    if (offsets.at(i) + intervals_.at(i).size == mem_block_size) { peak_intervals->push_back(i); }
+  }
+}
+
+int64_t LocalSearchMemBlockOffsets(const std::vector<MemReuseInterval>& intervals,
+                                   int64_t max_iterations, std::vector<int64_t>* offsets) {
+  const int64_t lower_bound = MemSizeLowerBound(intervals);
+  const BestFitPlacer placer(intervals);
+  auto SortedOrder = [&](const std::function<double(const MemReuseInterval&)>& Key) {
+    std::vector<int64_t> order(intervals.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int64_t lhs, int64_t rhs) {
+      return Key(intervals.at(lhs)) > Key(intervals.at(rhs));
+    });
+    return order;
+  };
+  std::vector<int64_t> best_order;
+  std::vector<int64_t> best_offsets;
+  int64_t best_size = GetMaxVal<int64_t>();
+  std::vector<int64_t> cur_offsets;
+  auto TryOrder = [&](const std::vector<int64_t>& order) {
+    const int64_t size = placer.Place(order, &cur_offsets);
+    if (size < best_size) {
+      best_size = size;
+      best_order = order;
+      best_offsets = cur_offsets;
+    }
+    return size;
+  };
+  TryOrder(SortedOrder([](const MemReuseInterval& interval) { return interval.size; }));
+  TryOrder(SortedOrder([](const MemReuseInterval& interval) {
+    return static_cast<double>(interval.size) * (interval.free_index - interval.alloc_index + 1);
+  }));
+  TryOrder(SortedOrder([](const MemReuseInterval& interval) {
+    return interval.free_index - interval.alloc_index;
+  }));
+  // perturb the order, moving an interval on the peak ahead or swapping two, and keep any order
+  // that is no worse so the search can walk across plateaus
+  std::mt19937 gen(intervals.size());
+  std::vector<int64_t> cur_order = best_order;
+  std::vector<int64_t> search_offsets = best_offsets;
+  int64_t cur_size = best_size;
+  std::vector<int64_t> peak_intervals;
+  std::vector<int64_t> order;
+  for (int64_t iter = 0; iter < max_iterations && intervals.size() > 1 && best_size > lower_bound;
+       ++iter) {
+    order = cur_order;
+    if (gen() % 2 == 0) {
+      placer.GetPeakIntervals(search_offsets, cur_size, &peak_intervals);
+      const int64_t interval = peak_intervals.at(gen() % peak_intervals.size());
+      auto it = std::find(order.begin(), order.end(), interval);
+      const int64_t pos = gen() % (it - order.begin() + 1);
+      std::rotate(order.begin() + pos, it, it + 1);
+    } else {
+      std::swap(order.at(gen() % order.size()), order.at(gen() % order.size()));
+    }
+    const int64_t size = TryOrder(order);
+    if (size <= cur_size) {
+      cur_order.swap(order);
+      search_offsets.swap(cur_offsets);
+      cur_size = size;
+    }
+  }
+  offsets->swap(best_offsets);
+  return best_size;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,61 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_MEM_BLOCK_LOCAL_SEARCH_H_
+#define ONEFLOW_CORE_JOB_MEM_BLOCK_LOCAL_SEARCH_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// a mem reused regst of `size` bytes, alive from the time step it is allocated to the time step
+// it is freed, both inclusive
+struct MemReuseInterval {
+  int64_t size;
+  int64_t alloc_index;
+  int64_t free_index;
+};
+
+// no offset assignment fits in less than the bytes alive at the busiest time step
+int64_t MemSizeLowerBound(const std::vector<MemReuseInterval>& intervals);
+
+class BestFitPlacer final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(BestFitPlacer);
+  explicit BestFitPlacer(const std::vector<MemReuseInterval>& intervals);
+  ~BestFitPlacer() = default;
+
+  // places intervals in order, each into the tightest gap left by the conflicting intervals
+  // already placed, or on top of them if no gap fits; returns the mem block size
+  int64_t Place(const std::vector<int64_t>& order, std::vector<int64_t>* offsets) const;
+
+  // intervals ending at the top of the mem block, moving one of them is the way down
+  void GetPeakIntervals(const std::vector<int64_t>& offsets, int64_t mem_block_size,
+                        std::vector<int64_t>* peak_intervals) const;
+
+ private:
+  const std::vector<MemReuseInterval>& intervals_;
+  std::vector<std::vector<int64_t>> conflicts_;
+};
+
+// seeds the placement with a few sorted orders, then perturbs the best order for at most
+// max_iterations steps or until the lower bound is reached; the result only depends on the
+// intervals and max_iterations. Returns the mem block size
+int64_t LocalSearchMemBlockOffsets(const std::vector<MemReuseInterval>& intervals,
+                                   int64_t max_iterations, std::vector<int64_t>* offsets);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_MEM_BLOCK_LOCAL_SEARCH_H_
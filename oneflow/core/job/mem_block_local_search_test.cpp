@@ -0,0 +1,120 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/mem_block_local_search.h"
+#include <random>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+std::vector<MemReuseInterval> RandomIntervals(int64_t num_intervals, int64_t num_steps,
+                                              int64_t seed) {
+  std::mt19937 gen(seed);
+  std::vector<MemReuseInterval> intervals;
+  FOR_RANGE(int64_t, i, 0, num_intervals) {
+    const int64_t alloc_index = gen() % num_steps;
+    const int64_t free_index = alloc_index + gen() % (num_steps - alloc_index);
+    intervals.push_back(MemReuseInterval{static_cast<int64_t>(gen() % 4096 + 1) * 512,
+                                         alloc_index, free_index});
+  }
+  return intervals;
+}
+
+void CheckNoOverlap(const std::vector<MemReuseInterval>& intervals,
+                    const std::vector<int64_t>& offsets, int64_t mem_block_size) {
+  ASSERT_EQ(offsets.size(), intervals.size());
+  FOR_RANGE(int64_t, i, 0, intervals.size()) {
+    ASSERT_GE(offsets.at(i), 0);
+    ASSERT_LE(offsets.at(i) + intervals.at(i).size, mem_block_size);
+    FOR_RANGE(int64_t, j, 0, i) {
+      const MemReuseInterval& lhs = intervals.at(i);
+      const MemReuseInterval& rhs = intervals.at(j);
+      if (lhs.free_index < rhs.alloc_index || rhs.free_index < lhs.alloc_index) { continue; }
+      ASSERT_TRUE(offsets.at(i) + lhs.size <= offsets.at(j)
+                  || offsets.at(j) + rhs.size <= offsets.at(i))
+          << i << " overlaps " << j;
+    }
+  }
+}
+
+}  // namespace
+
+TEST(MemBlockLocalSearch, lower_bound) {
+  ASSERT_EQ(MemSizeLowerBound({}), 0);
+  // a regst freed at a time step is still alive with the ones allocated at the same step
+  ASSERT_EQ(MemSizeLowerBound({{100, 0, 1}, {50, 1, 2}}), 150);
+  ASSERT_EQ(MemSizeLowerBound({{100, 0, 0}, {50, 1, 2}, {70, 2, 3}}), 120);
+  ASSERT_EQ(MemSizeLowerBound({{10, 0, 4}, {20, 1, 1}, {30, 3, 3}, {5, 2, 4}}), 45);
+}
+
+TEST(MemBlockLocalSearch, best_fit_placer) {
+  // a and c conflict with b only, so c fits the gap a leaves below b
+  const std::vector<MemReuseInterval> intervals = {{100, 0, 1}, {60, 1, 3}, {80, 3, 4}};
+  const BestFitPlacer placer(intervals);
+  std::vector<int64_t> offsets;
+  ASSERT_EQ(placer.Place({0, 1, 2}, &offsets), 160);
+  ASSERT_EQ(offsets, std::vector<int64_t>({0, 100, 0}));
+  std::vector<int64_t> peak_intervals;
+  placer.GetPeakIntervals(offsets, 160, &peak_intervals);
+  ASSERT_EQ(peak_intervals, std::vector<int64_t>({1}));
+  // placing b first leaves no gap below it
+  ASSERT_EQ(placer.Place({1, 0, 2}, &offsets), 160);
+  ASSERT_EQ(offsets, std::vector<int64_t>({60, 0, 60}));
+}
+
+TEST(MemBlockLocalSearch, best_fit_placer_tightest_gap) {
+  // 0 and 2 leave gaps of 100 and 40 bytes below 1 and 3, the 30 bytes of 4 take the tighter one
+  const std::vector<MemReuseInterval> intervals = {
+      {100, 0, 0}, {50, 0, 2}, {40, 0, 0}, {20, 0, 2}, {30, 1, 2}};
+  const BestFitPlacer placer(intervals);
+  std::vector<int64_t> offsets;
+  ASSERT_EQ(placer.Place({0, 1, 2, 3, 4}, &offsets), 210);
+  ASSERT_EQ(offsets.at(4), 150);
+  CheckNoOverlap(intervals, offsets, 210);
+}
+
+TEST(MemBlockLocalSearch, random_intervals) {
+  FOR_RANGE(int64_t, seed, 0, 4) {
+    const std::vector<MemReuseInterval> intervals = RandomIntervals(64, 32, seed);
+    const int64_t lower_bound = MemSizeLowerBound(intervals);
+    std::vector<int64_t> seed_offsets;
+    const int64_t seed_size = LocalSearchMemBlockOffsets(intervals, 0, &seed_offsets);
+    CheckNoOverlap(intervals, seed_offsets, seed_size);
+    std::vector<int64_t> offsets;
+    const int64_t size = LocalSearchMemBlockOffsets(intervals, 200, &offsets);
+    CheckNoOverlap(intervals, offsets, size);
+    ASSERT_GE(size, lower_bound);
+    ASSERT_LE(size, seed_size);
+    // the search does not depend on timing, the same budget gives the same offsets
+    std::vector<int64_t> rerun_offsets;
+    ASSERT_EQ(LocalSearchMemBlockOffsets(intervals, 200, &rerun_offsets), size);
+    ASSERT_EQ(rerun_offsets, offsets);
+  }
+}
+
+TEST(MemBlockLocalSearch, stop_at_lower_bound) {
+  // disjoint lifetimes can share offset 0, the seeds already reach the bound
+  const std::vector<MemReuseInterval> intervals = {{64, 0, 0}, {128, 1, 1}, {32, 2, 2}};
+  std::vector<int64_t> offsets;
+  ASSERT_EQ(LocalSearchMemBlockOffsets(intervals, 1000000000, &offsets), 128);
+  ASSERT_EQ(offsets, std::vector<int64_t>({0, 0, 0}));
+}
+
+}  // namespace test
+
+}  // namespace oneflow
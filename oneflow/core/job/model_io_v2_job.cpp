@@ -16,6 +16,8 @@ limitations under the License.
 #include "oneflow/core/job/model_io_v2_job.h"
 #include "oneflow/core/operator/interface_op_util.h"
 #include "oneflow/core/common/buffer_manager.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
 
 namespace oneflow {
 
@@ -137,8 +139,9 @@ void MakeModelLoadJob(
   const OperatorConf foreign_input_op_conf = GenForeignInputOpConf(job_name, 65536);
   job_builder.AddOps(master_parallel_conf, {foreign_input_op_conf, tick_op_conf});
   if (var_op_name2op_conf.empty()) { return; }
-  std::string prev_post_model_load_tick_lbn = GenLogicalBlobName(
-      foreign_input_op_conf.name(), foreign_input_op_conf.foreign_input_conf().out());
+  // each load op only reads its own slice, so they all hang on the path and run concurrently
+  const std::string path_lbn = GenLogicalBlobName(foreign_input_op_conf.name(),
+                                                  foreign_input_op_conf.foreign_input_conf().out());
   for (const auto& pair : var_op_name2op_conf) {
     const auto& var_op_name = pair.first;
     const OperatorConf& variable_op_conf = pair.second;
@@ -150,15 +153,12 @@ void MakeModelLoadJob(
     OperatorConf model_load_op_conf{};
     model_load_op_conf.set_name("System-ModelLoad-" + var_op_name);
     ModelLoadV2OpConf* model_load_conf = model_load_op_conf.mutable_model_load_v2_conf();
-    model_load_conf->set_path(GenLogicalBlobName(foreign_input_op_conf.name(),
-                                                 foreign_input_op_conf.foreign_input_conf().out()));
+    model_load_conf->set_path(path_lbn);
     model_load_conf->set_ref(GetVariableLbn(new_var_op_conf));
     *model_load_conf->mutable_variable_op_name() = var_op_name;
     *model_load_conf->mutable_original_variable_conf() = origin_variable_conf;
     *model_load_conf->mutable_out() = "out";
-    *model_load_conf->mutable_tick() = prev_post_model_load_tick_lbn;
-    prev_post_model_load_tick_lbn =
-        GenLogicalBlobName(model_load_op_conf.name(), model_load_conf->out());
+    *model_load_conf->mutable_tick() = path_lbn;
     job_builder.AddOps(variable_op_parallel_conf, {new_var_op_conf, model_load_op_conf});
   }
 }
@@ -177,6 +177,8 @@ void MakeModelSaveJob(
   const OperatorConf foreign_input_op_conf = GenForeignInputOpConf(job_name, 65536);
   job_builder.AddOps(master_parallel_conf, {foreign_input_op_conf, tick_op_conf});
   if (var_op_name2op_conf.empty()) { return; }
+  const bool async = Global<ResourceDesc, ForSession>::Get()->enable_async_checkpoint();
+  const bool sharded = Global<ResourceDesc, ForSession>::Get()->enable_sharded_checkpoint();
   std::string prev_post_model_save_tick_lbn = GenLogicalBlobName(
       foreign_input_op_conf.name(), foreign_input_op_conf.foreign_input_conf().out());
   for (const auto& pair : var_op_name2op_conf) {
@@ -196,6 +198,11 @@ void MakeModelSaveJob(
     *model_save_conf->mutable_out() = "out";
     *model_save_conf->mutable_variable_op_name() = var_op_name;
     *model_save_conf->mutable_original_variable_conf() = variable_conf;
+    if (async) {
+      model_save_conf->set_async(true);
+      model_save_conf->set_snapshot_var_num(var_op_name2op_conf.size());
+    }
+    model_save_conf->set_sharded(sharded);
     prev_post_model_save_tick_lbn =
         GenLogicalBlobName(model_save_op_conf.name(), model_save_conf->out());
     job_builder.AddOps(parallel_blob_conf.parallel_conf(), {new_var_op_conf, model_save_op_conf});
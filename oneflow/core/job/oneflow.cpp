@@ -29,6 +29,7 @@ limitations under the License.
 #include "oneflow/core/job/available_memory_desc.pb.h"
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/actor/act_event_logger.h"
+#include "oneflow/core/job/act_event_profile.h"
 #include "oneflow/core/job/oneflow.h"
 #include "oneflow/core/job/model_io_v2_job.h"
 #include "oneflow/core/job/model_io_job.h"
@@ -284,14 +285,35 @@ void GenCollectiveBoxingPlan(Job* job, Plan* plan) {
   }
 }
 
+bool BroadcastActEventProfileHit(int64_t job_id, bool hit) {
+  const std::string key = "ActEventProfileHit/" + std::to_string(job_id);
+  if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
+    Global<CtrlClient>::Get()->PushKVT(key, static_cast<int32_t>(hit));
+  } else {
+    int32_t master_hit = 0;
+    Global<CtrlClient>::Get()->PullKVT(key, &master_hit);
+    hit = (master_hit != 0);
+  }
+  OF_BARRIER();
+  if (Global<MachineCtx>::Get()->IsThisMachineMaster()) { Global<CtrlClient>::Get()->ClearKV(key); }
+  return hit;
+}
+
 Maybe<void> CompileCurJobOnMaster(Job* job, Plan* improved_plan, bool need_job_complete) {
   const JobDesc& job_desc = GlobalJobDesc();
+  const std::string& profile_dir = job_desc.String("act_event_profile_dir");
   Plan naive_plan;
   Plan complete_plan;
+  std::string profile_path;
   double start = GetCurTime();
   if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
     Compiler().Compile(job, &naive_plan, need_job_complete);
     LOG(INFO) << "compile time: " << GetCurTime() - start;
+    if (!profile_dir.empty()) {
+      const std::string fingerprint = ActEventProfileFingerprint(naive_plan);
+      SetActEventProfileFingerprint(fingerprint, &naive_plan);
+      profile_path = ActEventProfilePath(profile_dir, fingerprint);
+    }
     complete_plan =
         *JUST(Improver().GenAndInferMemBlockIdOnly(*Global<AvailableMemDesc>::Get(), naive_plan));
     if (Global<ResourceDesc, ForSession>::Get()->enable_debug_mode()) {
@@ -300,7 +322,20 @@ Maybe<void> CompileCurJobOnMaster(Job* job, Plan* improved_plan, bool need_job_c
     }
     LOG(INFO) << "push_pull_plan:" << GetCurTime() - start;
   }
-  if (job_desc.enable_experiment_run()) {
+  bool improve_from_profile = false;
+  if (!profile_dir.empty()) {
+    improve_from_profile = BroadcastActEventProfileHit(
+        job_desc.job_id(), !profile_path.empty() && LocalFS()->FileExists(profile_path));
+  }
+  if (improve_from_profile) {
+    // a previous launch of the same plan left its act events, no experiment run is needed
+    if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
+      LOG(INFO) << "improve register num from act event profile " << profile_path;
+      *improved_plan =
+          *JUST(Improver().Improve(*Global<AvailableMemDesc>::Get(), naive_plan, profile_path));
+      TeePersistentLogStream::Create("improved_plan")->Write(*improved_plan);
+    }
+  } else if (job_desc.enable_experiment_run()) {
     if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
       PushPlan("complete_plan", complete_plan);
     } else {
@@ -313,9 +348,13 @@ Maybe<void> CompileCurJobOnMaster(Job* job, Plan* improved_plan, bool need_job_c
     if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
       TeePersistentLogStream::Create("available_mem_desc")->Write(*Global<AvailableMemDesc>::Get());
       CHECK_GT(Global<AvailableMemDesc>::Get()->machine_amd_size(), 0);
-      *improved_plan = *JUST(Improver().Improve(
-          *Global<AvailableMemDesc>::Get(), naive_plan,
-          JoinPath(FLAGS_log_dir, ActEventLogger::experiment_act_event_bin_filename())));
+      const std::string act_event_filepath =
+          JoinPath(FLAGS_log_dir, ActEventLogger::experiment_act_event_bin_filename());
+      *improved_plan = *JUST(
+          Improver().Improve(*Global<AvailableMemDesc>::Get(), naive_plan, act_event_filepath));
+      if (!profile_path.empty()) {
+        SaveActEventProfile(naive_plan, job_desc.job_id(), act_event_filepath, profile_path);
+      }
       OF_BARRIER();
       TeePersistentLogStream::Create("improved_plan")->Write(*improved_plan);
     }
@@ -982,6 +1021,10 @@ Maybe<void> Oneflow::Init(const oneflow::JobSet& job_set) {
 Oneflow::~Oneflow() {
   if (Global<MachineCtx>::Get()->IsThisMachineMaster()) { runtime_buffers_scope_.reset(); }
   runtime_.reset();
+  if (Global<MachineCtx>::Get()->IsThisMachineMaster() && OnlineRegstNumTuningActNum(plan_) > 0) {
+    SaveOnlineRegstNumTuningProfiles(
+        plan_, JoinPath(FLAGS_log_dir, ActEventLogger::act_event_bin_filename()));
+  }
   if (Global<Profiler>::Get() != nullptr) {
     Global<Profiler>::Get()->Profile(
         plan_, JoinPath(FLAGS_log_dir, ActEventLogger::act_event_bin_filename()));
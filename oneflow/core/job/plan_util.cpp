@@ -55,6 +55,48 @@ std::vector<std::vector<std::string>> GenNodeRank(const Plan& plan) {
   return ret;
 }
 
+bool IsAllBlobsFloat(const DataRegstDesc& data_regst_desc) {
+  for (const LbiBlobDescPair& pair : data_regst_desc.lbi2blob_desc()) {
+    if (pair.blob_desc().body().data_type() != DataType::kFloat) { return false; }
+  }
+  return data_regst_desc.lbi2blob_desc_size() > 0;
+}
+
+int64_t BodyByteSize(const DataRegstDesc& data_regst_desc) {
+  int64_t byte_size = 0;
+  for (const LbiBlobDescPair& pair : data_regst_desc.lbi2blob_desc()) {
+    const TensorPodProto& body = pair.blob_desc().body();
+    byte_size += Shape(body.shape()).elem_cnt() * GetSizeOfDataType(body.data_type());
+  }
+  return byte_size;
+}
+
+// the blobs consumed as model_diff, model_diff_indices or model_diff_values by model updates and
+// gradient regularizations, boxing keeps their lbis on the way from the backward ops
+HashSet<LogicalBlobId> ModelDiffLbis(const Plan& plan, int64_t first_task_idx) {
+  HashSet<LogicalBlobId> model_diff_lbis;
+  FOR_RANGE(int64_t, i, first_task_idx, plan.task_size()) {
+    for (const ExecNodeProto& exec_node : plan.task(i).exec_sequence().exec_node()) {
+      const OpAttribute& op_attribute = exec_node.kernel_conf().op_attribute();
+      const auto& bn_in_op2lbi = op_attribute.arg_signature().bn_in_op2lbi();
+      for (const std::string& ibn : op_attribute.input_bns()) {
+        if (ibn.find("model_diff") != 0) { continue; }
+        const auto& lbi_it = bn_in_op2lbi.find(ibn);
+        if (lbi_it != bn_in_op2lbi.end()) { model_diff_lbis.insert(lbi_it->second); }
+      }
+    }
+  }
+  return model_diff_lbis;
+}
+
+bool IsModelDiffRegst(const HashSet<LogicalBlobId>& model_diff_lbis,
+                      const DataRegstDesc& data_regst_desc) {
+  for (const LbiBlobDescPair& pair : data_regst_desc.lbi2blob_desc()) {
+    if (model_diff_lbis.find(pair.lbi()) == model_diff_lbis.end()) { return false; }
+  }
+  return data_regst_desc.lbi2blob_desc_size() > 0;
+}
+
 }  // namespace
 
 RegstDescProto* PlanUtil::GetSoleProducedDataRegst(TaskProto* task_proto) {
@@ -330,4 +372,38 @@ void PlanUtil::ToDotFile(const Plan& plan, const std::string& filepath) {
   log_stream << "}\n";
 }
 
+void PlanUtil::SetCommNetCodec(const JobDesc& job_desc, int64_t first_task_idx, Plan* plan) {
+  const std::string& lossless_codec = job_desc.String("comm_net_lossless_codec");
+  CommNetCodec default_codec = CommNetCodec::kNoCommNetCodec;
+  if (lossless_codec == "zlib") {
+    default_codec = CommNetCodec::kZlibCommNetCodec;
+  } else {
+    CHECK(lossless_codec.empty()) << "unknown comm_net_lossless_codec: " << lossless_codec;
+  }
+  const bool enable_float16_cast = job_desc.Bool("enable_comm_net_float16_cast");
+  const int64_t min_byte_size = job_desc.Int64("comm_net_codec_min_byte_size");
+  if (default_codec == CommNetCodec::kNoCommNetCodec && !enable_float16_cast) { return; }
+  const HashSet<LogicalBlobId> model_diff_lbis = ModelDiffLbis(*plan, first_task_idx);
+  FOR_RANGE(int64_t, i, first_task_idx, plan->task_size()) {
+    TaskProto& task = *plan->mutable_task(i);
+    // only the producer side of a comm net transfer encodes, copy_comm_net outputs are local
+    if (task.task_type() == TaskType::kCopyCommNet) { continue; }
+    for (auto& pair : *task.mutable_produced_regst_desc()) {
+      RegstDescProto* regst = &pair.second;
+      if (!regst->mem_case().has_host_mem()) { continue; }
+      if (!regst->mem_case().host_mem().used_by_network()) { continue; }
+      if (!regst->regst_desc_type().has_data_regst_desc()) { continue; }
+      const DataRegstDesc& data_regst_desc = regst->regst_desc_type().data_regst_desc();
+      // the codecs trade precision or latency for bandwidth, which only pays off for gradients
+      if (!IsModelDiffRegst(model_diff_lbis, data_regst_desc)) { continue; }
+      if (BodyByteSize(data_regst_desc) < min_byte_size) { continue; }
+      if (enable_float16_cast && IsAllBlobsFloat(data_regst_desc)) {
+        regst->set_comm_net_codec(CommNetCodec::kFloat16CommNetCodec);
+      } else {
+        regst->set_comm_net_codec(default_codec);
+      }
+    }
+  }
+}
+
 }  // namespace oneflow
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <functional>
 #include "oneflow/core/job/plan.pb.h"
+#include "oneflow/core/job/job_desc.h"
 
 namespace oneflow {
 
@@ -26,6 +27,9 @@ struct PlanUtil {
   static std::function<const TaskProto*(int64_t)> MakeGetterTaskProto4TaskId(const Plan& plan);
   static void CleanUselessMemBlockAndCheckValid(Plan* plan);
   static void ToDotFile(const Plan& plan, const std::string& filepath);
+  // sets the comm net codec of the model diff regsts produced by the tasks from first_task_idx,
+  // activations and models are always sent uncompressed
+  static void SetCommNetCodec(const JobDesc& job_desc, int64_t first_task_idx, Plan* plan);
 };
 
 }  // namespace oneflow
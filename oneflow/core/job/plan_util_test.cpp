@@ -0,0 +1,143 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/plan_util.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/resource_desc.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+void NewGlobals() {
+  EnvProto env_proto;
+  auto* machine = env_proto.add_machine();
+  machine->set_id(0);
+  machine->set_addr("127.0.0.1");
+  env_proto.set_ctrl_port(9527);
+  Resource resource;
+  resource.set_machine_num(1);
+  resource.set_cpu_device_num(1);
+  resource.set_gpu_device_num(0);
+  Global<EnvDesc>::New(env_proto);
+  Global<ResourceDesc, ForSession>::New(resource);
+}
+
+void DeleteGlobals() {
+  Global<ResourceDesc, ForSession>::Delete();
+  Global<EnvDesc>::Delete();
+}
+
+JobConfigProto CodecJobConf(const std::string& lossless_codec, bool enable_float16_cast) {
+  JobConfigProto job_conf;
+  job_conf.set_job_name("comm_net_codec_test");
+  job_conf.mutable_predict_conf();
+  auto* flag_name2flag_value = job_conf.mutable_flag_name2flag_value();
+  (*flag_name2flag_value)["comm_net_lossless_codec"].set_at_string(lossless_codec);
+  (*flag_name2flag_value)["enable_comm_net_float16_cast"].set_at_bool(enable_float16_cast);
+  (*flag_name2flag_value)["comm_net_codec_min_byte_size"].set_at_int64(1024);
+  return job_conf;
+}
+
+// a task producing the blob op_name/blob_name of elem_cnt floats for the comm net
+TaskProto* AddProducerTask(Plan* plan, const std::string& op_name, const std::string& blob_name,
+                           int64_t elem_cnt) {
+  TaskProto* task = plan->add_task();
+  task->set_task_type(TaskType::kNormalForward);
+  task->set_task_id(plan->task_size());
+  RegstDescProto* regst = &(*task->mutable_produced_regst_desc())["out"];
+  regst->set_regst_desc_id(task->task_id());
+  regst->mutable_mem_case()->mutable_host_mem()->set_used_by_network(true);
+  LbiBlobDescPair* pair =
+      regst->mutable_regst_desc_type()->mutable_data_regst_desc()->add_lbi2blob_desc();
+  pair->mutable_lbi()->set_op_name(op_name);
+  pair->mutable_lbi()->set_blob_name(blob_name);
+  TensorPodProto* body = pair->mutable_blob_desc()->mutable_body();
+  body->mutable_shape()->add_dim(elem_cnt);
+  body->set_data_type(DataType::kFloat);
+  return task;
+}
+
+// a model update of model/out consuming its diff grad/dx
+void AddModelUpdateTask(Plan* plan) {
+  TaskProto* task = plan->add_task();
+  task->set_task_type(TaskType::kNormalMdUpdt);
+  task->set_task_id(plan->task_size());
+  OpAttribute* op_attribute =
+      task->mutable_exec_sequence()->add_exec_node()->mutable_kernel_conf()->mutable_op_attribute();
+  op_attribute->add_input_bns("model_diff");
+  op_attribute->add_input_bns("model");
+  auto* bn_in_op2lbi = op_attribute->mutable_arg_signature()->mutable_bn_in_op2lbi();
+  (*bn_in_op2lbi)["model_diff"].set_op_name("grad");
+  (*bn_in_op2lbi)["model_diff"].set_blob_name("dx");
+  (*bn_in_op2lbi)["model"].set_op_name("model");
+  (*bn_in_op2lbi)["model"].set_blob_name("out");
+}
+
+CommNetCodec CommNetCodec4Task(const Plan& plan, int64_t task_idx) {
+  return plan.task(task_idx).produced_regst_desc().at("out").comm_net_codec();
+}
+
+// tasks 0 to 2 produce an activation, a model and its model diff for the model update of task 3
+Plan NewTrainPlan() {
+  Plan plan;
+  AddProducerTask(&plan, "relu", "out", 4096);
+  AddProducerTask(&plan, "model", "out", 4096);
+  AddProducerTask(&plan, "grad", "dx", 4096);
+  AddModelUpdateTask(&plan);
+  return plan;
+}
+
+}  // namespace
+
+TEST(PlanUtil, comm_net_codec_only_for_model_diff) {
+  NewGlobals();
+  JobDesc job_desc(CodecJobConf("zlib", false), 0);
+  Plan plan = NewTrainPlan();
+  PlanUtil::SetCommNetCodec(job_desc, 0, &plan);
+  ASSERT_EQ(CommNetCodec4Task(plan, 0), CommNetCodec::kNoCommNetCodec);
+  ASSERT_EQ(CommNetCodec4Task(plan, 1), CommNetCodec::kNoCommNetCodec);
+  ASSERT_EQ(CommNetCodec4Task(plan, 2), CommNetCodec::kZlibCommNetCodec);
+  DeleteGlobals();
+}
+
+TEST(PlanUtil, comm_net_float16_cast_only_for_model_diff) {
+  NewGlobals();
+  JobDesc job_desc(CodecJobConf("", true), 0);
+  Plan plan = NewTrainPlan();
+  PlanUtil::SetCommNetCodec(job_desc, 0, &plan);
+  ASSERT_EQ(CommNetCodec4Task(plan, 0), CommNetCodec::kNoCommNetCodec);
+  ASSERT_EQ(CommNetCodec4Task(plan, 1), CommNetCodec::kNoCommNetCodec);
+  ASSERT_EQ(CommNetCodec4Task(plan, 2), CommNetCodec::kFloat16CommNetCodec);
+  DeleteGlobals();
+}
+
+TEST(PlanUtil, comm_net_codec_skips_small_regsts) {
+  NewGlobals();
+  JobDesc job_desc(CodecJobConf("zlib", true), 0);
+  Plan plan;
+  // 16 floats are below the 1024 bytes of comm_net_codec_min_byte_size
+  AddProducerTask(&plan, "grad", "dx", 16);
+  AddModelUpdateTask(&plan);
+  PlanUtil::SetCommNetCodec(job_desc, 0, &plan);
+  ASSERT_EQ(CommNetCodec4Task(plan, 0), CommNetCodec::kNoCommNetCodec);
+  DeleteGlobals();
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -18,6 +18,7 @@ limitations under the License.
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/common/str_util.h"
 #include "oneflow/core/actor/act_event_logger.h"
+#include "oneflow/core/framework/op_kernel_infer_cache.h"
 
 namespace oneflow {
 
@@ -108,6 +109,22 @@ void Profiler::Profile(const Plan& plan, const std::string& act_event_filepath)
                << " bottleneck_score:" << std::to_string(pair.second.CalcBottleNeckScore())
                << " type:" << TaskType_Name(task_id2task_type.at(pair.first)) << "\n";
   }
+
+  // Shape inference cache of the user op kernels on this machine, the most missed first.
+  using InferCacheStatsPair = std::pair<std::string, user_op::OpKernelInferCacheStats>;
+  const auto op_name2infer_cache_stats = user_op::TakeCollectedOpKernelInferCacheStats();
+  std::vector<InferCacheStatsPair> infer_cache_stats_vec(op_name2infer_cache_stats.begin(),
+                                                         op_name2infer_cache_stats.end());
+  std::sort(infer_cache_stats_vec.begin(), infer_cache_stats_vec.end(),
+            [](const InferCacheStatsPair& lhs, const InferCacheStatsPair& rhs) {
+              return lhs.second.misses > rhs.second.misses;
+            });
+  for (const InferCacheStatsPair& pair : infer_cache_stats_vec) {
+    log_stream << "op_name:" << pair.first
+               << " infer_cache_hits:" << std::to_string(pair.second.hits)
+               << " infer_cache_misses:" << std::to_string(pair.second.misses)
+               << " infer_cache_evictions:" << std::to_string(pair.second.evictions) << "\n";
+  }
 }
 
 }  // namespace oneflow
@@ -39,6 +39,17 @@ class ResourceDesc final {
   int32_t GpuDeviceNum() const { return resource_.gpu_device_num(); }
   int32_t MemZoneNum() const { return GpuDeviceNum() + 1; }
   int32_t MaxMdSaveWorkerNum() const { return resource_.max_mdsave_worker_num(); }
+  bool enable_async_checkpoint() const { return resource_.enable_async_checkpoint(); }
+  int32_t AsyncCheckpointWriterNum() const { return resource_.async_checkpoint_writer_num(); }
+  int64_t AsyncCheckpointMaxStagingBytes() const {
+    return resource_.async_checkpoint_max_staging_mbyte() * 1024 * 1024;
+  }
+  bool enable_sharded_checkpoint() const { return resource_.enable_sharded_checkpoint(); }
+  bool enable_vm_loop_run_worker() const { return resource_.enable_vm_loop_run_worker(); }
+  size_t op_kernel_infer_cache_size() const { return resource_.op_kernel_infer_cache_size(); }
+  bool enable_shared_op_kernel_infer_cache() const {
+    return resource_.enable_shared_op_kernel_infer_cache();
+  }
   size_t reserved_host_mem_byte() const { return resource_.reserved_host_mem_mbyte() * kMB; }
   size_t reserved_device_mem_byte() const { return resource_.reserved_device_mem_mbyte() * kMB; }
   bool use_rdma() const { return resource_.use_rdma(); }
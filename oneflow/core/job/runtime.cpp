@@ -24,6 +24,7 @@ limitations under the License.
 #include "oneflow/core/job/runtime_job_descs.h"
 #include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/core/actor/act_event_logger.h"
+#include "oneflow/core/job/act_event_profile.h"
 #include "oneflow/core/graph/task_node.h"
 #include "oneflow/core/device/cuda_util.h"
 #include "oneflow/core/memory/memory_allocator.h"
@@ -105,9 +106,11 @@ Runtime::~Runtime() {
 }
 
 void Runtime::NewAllGlobal(const Plan& plan, size_t total_piece_num, bool is_experiment_phase) {
-  Global<RuntimeCtx>::New(total_piece_num, is_experiment_phase);
+  const int64_t online_tuning_act_num =
+      is_experiment_phase ? 0 : OnlineRegstNumTuningActNum(plan);
+  Global<RuntimeCtx>::New(total_piece_num, is_experiment_phase, online_tuning_act_num);
   if (Global<MachineCtx>::Get()->IsThisMachineMaster()
-      && Global<RuntimeCtx>::Get()->NeedCollectActEvent()) {
+      && (Global<RuntimeCtx>::Get()->NeedCollectActEvent() || online_tuning_act_num > 0)) {
     Global<ActEventLogger>::New(is_experiment_phase);
   }
   if (Global<ResourceDesc, ForSession>::Get()->TotalMachineNum() > 1) {
@@ -31,9 +31,11 @@ void RuntimeCtx::WaitUntilCntEqualZero(const std::string& name) {
   counters_.at(name)->WaitUntilCntEqualZero();
 }
 
-RuntimeCtx::RuntimeCtx(int64_t total_piece_num, bool is_experiment_phase) {
+RuntimeCtx::RuntimeCtx(int64_t total_piece_num, bool is_experiment_phase,
+                       int64_t online_tuning_act_num) {
   total_piece_num_ = total_piece_num;
   is_experiment_phase_ = is_experiment_phase;
+  online_tuning_act_num_ = online_tuning_act_num;
 }
 
 }  // namespace oneflow
@@ -35,6 +35,10 @@ class RuntimeCtx final {
   bool NeedCollectActEvent() const {
     return is_experiment_phase_ || Global<const ProfilerConf>::Get()->collect_act_event();
   }
+  // online register_num tuning logs only the first acts of each actor of a normal run
+  bool NeedCollectActEvent4OnlineTuning(int64_t act_id) const {
+    return act_id < online_tuning_act_num_;
+  }
 
   void NewCounter(const std::string& name, int64_t val);
   void DecreaseCounter(const std::string& name);
@@ -42,10 +46,11 @@ class RuntimeCtx final {
 
  private:
   friend class Global<RuntimeCtx>;
-  RuntimeCtx(int64_t total_piece_num, bool is_experiment_phase);
+  RuntimeCtx(int64_t total_piece_num, bool is_experiment_phase, int64_t online_tuning_act_num);
 
   int64_t total_piece_num_;
   bool is_experiment_phase_;
+  int64_t online_tuning_act_num_;
   HashMap<std::string, std::unique_ptr<BlockingCounter>> counters_;
 };
 
@@ -24,6 +24,7 @@ limitations under the License.
 #include "oneflow/core/job/id_manager.h"
 #include "oneflow/core/job/profiler.h"
 #include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/persistence/async_snapshot_writer.h"
 #include "oneflow/core/common/buffer_manager.h"
 #include "oneflow/core/job/foreign_job_instance.h"
 #include "oneflow/core/job/inter_user_job_info.pb.h"
@@ -81,6 +82,11 @@ Maybe<void> SessionGlobalObjectsScope::Init(const ConfigProto& config_proto) {
       && Global<const ProfilerConf>::Get()->collect_act_event()) {
     Global<Profiler>::New();
   }
+  if (Global<ResourceDesc, ForSession>::Get()->enable_async_checkpoint()) {
+    Global<AsyncSnapshotWriter>::New(
+        SnapshotFS(), Global<ResourceDesc, ForSession>::Get()->AsyncCheckpointWriterNum(),
+        Global<ResourceDesc, ForSession>::Get()->AsyncCheckpointMaxStagingBytes());
+  }
   PushAvailableMemDescOfThisMachine();
   if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
     Global<AvailableMemDesc>::New();
@@ -109,6 +115,8 @@ SessionGlobalObjectsScope::~SessionGlobalObjectsScope() {
     Global<AvailableMemDesc>::Delete();
   }
   if (Global<Profiler>::Get() != nullptr) { Global<Profiler>::Delete(); }
+  // waits for the snapshots still being written in background
+  if (Global<AsyncSnapshotWriter>::Get() != nullptr) { Global<AsyncSnapshotWriter>::Delete(); }
   Global<IDMgr>::Delete();
   Global<const ProfilerConf>::Delete();
   Global<const IOConf>::Delete();
@@ -0,0 +1,306 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+#include "oneflow/core/job_rewriter/activation_recomputation_plan.h"
+#include "oneflow/core/framework/config_def.h"
+#include "oneflow/core/common/str_util.h"
+
+namespace oneflow {
+
+namespace {
+
+REGISTER_FUNCTION_CONFIG_DEF()
+    .Bool("enable_activation_recomputation", false,
+          "drop forward activations needed by backward and recompute them in front of their "
+          "backward consumers")
+    .String("activation_recomputation_checkpoint_op_names", "",
+            "comma separated ops whose outputs are kept for backward; chosen within "
+            "activation_recomputation_memory_budget_mb if empty")
+    .Int64("activation_recomputation_memory_budget_mb", 0,
+           "per device budget of activations kept for backward, 0 for the least memory");
+
+const std::string kRecomputeOpNameSuffix = "-recompute";
+
+bool IsRecomputable(const OpNode& op_node) {
+  // random and stateful ops are not deterministic under a second run
+  static const HashSet<std::string> non_deterministic_op_type_names = {
+      "random_mask_like", "generate_random_batch_permutation_indices", "TestRandomSource"};
+  const Operator& op = op_node.op();
+  if (!op.op_conf().has_user_conf()) { return false; }
+  if (op.input_bns().empty()) { return false; }
+  if (non_deterministic_op_type_names.find(op.op_conf().user_conf().op_type_name())
+      != non_deterministic_op_type_names.end()) {
+    return false;
+  }
+  for (const auto& ibn : op.input_bns()) {
+    if (op.InputBlobModifier4Ibn(ibn).is_mutable()) { return false; }
+  }
+  for (const auto& obn : op.output_bns()) {
+    if (CHECK_JUST(op.OptMirroredParallel4BnInOp(obn))->has_mirrored_parallel()) { return false; }
+  }
+  return true;
+}
+
+double PerDeviceBytes4Lbi(const OpNode& op_node, const LogicalBlobId& lbi) {
+  const BlobDesc& blob_desc = op_node.LogicalBlobDesc4Lbi(lbi);
+  double bytes = static_cast<double>(blob_desc.shape().elem_cnt())
+                 * GetSizeOfDataType(blob_desc.data_type());
+  if (op_node.SbpParallel4Lbi(lbi).has_split_parallel()) {
+    bytes /= op_node.parallel_desc().parallel_num();
+  }
+  return bytes;
+}
+
+double ElemCnt4BnInOp(const OpNode& op_node, const std::string& bn_in_op) {
+  return op_node.LogicalBlobDesc4Lbi(op_node.op().BnInOp2Lbi(bn_in_op)).shape().elem_cnt();
+}
+
+// a rough estimate: matmul and conv by multiply-adds, everything else by elements touched
+double EstimateFlops(const OpNode& op_node) {
+  const Operator& op = op_node.op();
+  const std::string& op_type_name = op.op_conf().user_conf().op_type_name();
+  if (op_type_name == "matmul" || op_type_name == "batch_matmul") {
+    const double out_elem_cnt = ElemCnt4BnInOp(op_node, "out_0");
+    const Shape& out_shape = op_node.LogicalBlobDesc4Lbi(op.BnInOp2Lbi("out_0")).shape();
+    const double batch = out_shape.Count(0, out_shape.NumAxes() - 2);
+    // (batch * m * k) * (batch * k * n) / (batch * m * n) == batch * k * k
+    const double k = std::sqrt(ElemCnt4BnInOp(op_node, "a_0") * ElemCnt4BnInOp(op_node, "b_0")
+                               / out_elem_cnt / batch);
+    return 2 * out_elem_cnt * k;
+  }
+  if (op_type_name == "conv1d" || op_type_name == "conv2d" || op_type_name == "conv3d") {
+    const Shape& weight_shape = op_node.LogicalBlobDesc4Lbi(op.BnInOp2Lbi("weight_0")).shape();
+    return 2 * ElemCnt4BnInOp(op_node, "out_0") * weight_shape.Count(1);
+  }
+  double elem_cnt = 0;
+  for (const auto& ibn : op.input_bns()) { elem_cnt += ElemCnt4BnInOp(op_node, ibn); }
+  for (const auto& obn : op.output_bns()) { elem_cnt += ElemCnt4BnInOp(op_node, obn); }
+  return elem_cnt;
+}
+
+std::string RecomputeLbn(const LogicalBlobId& lbi) {
+  return GenLogicalBlobName(lbi.op_name() + kRecomputeOpNameSuffix, lbi.blob_name());
+}
+
+class ActivationRecomputationPass final : public OpGraphPass {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ActivationRecomputationPass);
+  ActivationRecomputationPass() = default;
+  ~ActivationRecomputationPass() override = default;
+  bool IsEnabled() const override {
+    return GlobalJobDesc().IsTrain() && GlobalJobDesc().Bool("enable_activation_recomputation");
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+};
+
+Maybe<void> ActivationRecomputationPass::Apply(const OpGraph& op_graph,
+                                               JobBuilder* job_builder) const {
+  // forward ops are the loss ops and their ascendants, every other op runs in backward
+  HashSet<const OpNode*> forward_op_nodes;
+  {
+    HashSet<std::string> loss_op_names;
+    for (const std::string& loss_lbn : GlobalJobDesc().job_conf().train_conf().loss_lbn()) {
+      loss_op_names.insert(GenLogicalBlobId(loss_lbn).op_name());
+    }
+    std::list<OpNode*> loss_op_nodes;
+    op_graph.ForEachNode([&](OpNode* op_node) {
+      if (loss_op_names.find(op_node->op().op_name()) != loss_op_names.end()) {
+        loss_op_nodes.push_back(op_node);
+      }
+    });
+    op_graph.BfsForEachNode(
+        loss_op_nodes, &OpNode::ForEachNodeOnInEdge,
+        [&](OpNode* op_node) { forward_op_nodes.insert(op_node); });
+  }
+  auto IsForward = [&](const OpNode* op_node) {
+    return forward_op_nodes.find(op_node) != forward_op_nodes.end();
+  };
+  // activations kept alive until backward, in forward topo order
+  std::vector<SavedActivation> saved_activations;
+  std::vector<const OpNode*> saved_op_nodes;
+  HashMap<const OpNode*, std::vector<const OpEdge*>> op_node2backward_out_edges;
+  op_graph.TopoForEachNode([&](OpNode* op_node) {
+    if (!IsForward(op_node)) { return; }
+    HashSet<LogicalBlobId> saved_lbis;
+    for (const OpEdge* out_edge : op_node->out_edges()) {
+      if (IsForward(out_edge->dst_node())) { continue; }
+      op_node2backward_out_edges[op_node].push_back(out_edge);
+      saved_lbis.insert(out_edge->lbis().begin(), out_edge->lbis().end());
+    }
+    if (saved_lbis.empty()) { return; }
+    double bytes = 0;
+    for (const LogicalBlobId& lbi : saved_lbis) { bytes += PerDeviceBytes4Lbi(*op_node, lbi); }
+    const bool is_recomputable = IsRecomputable(*op_node);
+    saved_activations.push_back(
+        SavedActivation{bytes, is_recomputable ? EstimateFlops(*op_node) : 0, is_recomputable});
+    saved_op_nodes.push_back(op_node);
+  });
+  HashSet<const OpNode*> checkpoints;
+  const std::string& checkpoint_op_names =
+      GlobalJobDesc().String("activation_recomputation_checkpoint_op_names");
+  if (checkpoint_op_names.empty()) {
+    const double budget_bytes =
+        GlobalJobDesc().Int64("activation_recomputation_memory_budget_mb") * 1024.0 * 1024.0;
+    const std::vector<bool> is_checkpoint =
+        SelectRecomputationCheckpoints(saved_activations, budget_bytes);
+    FOR_RANGE(int64_t, i, 0, saved_op_nodes.size()) {
+      if (is_checkpoint.at(i)) { checkpoints.insert(saved_op_nodes.at(i)); }
+    }
+  } else {
+    std::vector<std::string> op_names;
+    Split(checkpoint_op_names, ",", [&](std::string&& op_name) {
+      if (!op_name.empty()) { op_names.push_back(op_name); }
+    });
+    for (const std::string& op_name : op_names) {
+      const OpNode* op_node = op_graph.OpNode4OpName(op_name);
+      CHECK_NOTNULL_OR_RETURN(op_node)
+          << "activation recomputation checkpoint op " << op_name << " not found";
+      checkpoints.insert(op_node);
+    }
+  }
+  auto IsDropped = [&](const OpNode* op_node) {
+    return IsForward(op_node) && IsRecomputable(*op_node)
+           && checkpoints.find(op_node) == checkpoints.end();
+  };
+  // clone dropped ops, recursively up to checkpoints and non-recomputable ops
+  HashMap<const OpNode*, OperatorConf> op_node2recompute_op_conf;
+  std::vector<const OpNode*> recomputed_op_nodes;
+  std::function<void(const OpNode*)> Recompute;
+  Recompute = [&](const OpNode* op_node) {
+    if (op_node2recompute_op_conf.find(op_node) != op_node2recompute_op_conf.end()) { return; }
+    OperatorConf op_conf = op_node->op().op_conf();
+    op_conf.set_name(op_conf.name() + kRecomputeOpNameSuffix);
+    PbMessage* op_type_conf = MutableMessageInPbMessage(&op_conf, op_conf.op_type_case());
+    for (const auto& ibn : op_node->op().input_bns()) {
+      const OpNode& producer = op_node->SrcNode4Ibn(ibn);
+      if (!IsDropped(&producer)) { continue; }
+      Recompute(&producer);
+      ReplaceInputLbnInOpCustomizedConf(op_type_conf, ibn,
+                                        GetInputLbnInOpCustomizedConf(*op_type_conf, ibn),
+                                        RecomputeLbn(op_node->op().BnInOp2Lbi(ibn)));
+    }
+    for (auto& pair : *op_conf.mutable_user_conf()->mutable_output()) {
+      for (std::string& lbn : *pair.second.mutable_s()) {
+        lbn = RecomputeLbn(GenLogicalBlobId(lbn));
+      }
+    }
+    op_node2recompute_op_conf.emplace(op_node, op_conf);
+    recomputed_op_nodes.push_back(op_node);
+  };
+  // backward ops consume the recomputed activations instead
+  HashMap<std::string, OperatorConf> backward_op_name2op_conf;
+  HashMap<const OpNode*, HashSet<OpNode*>> op_node2backward_consumers;
+  double dropped_bytes = 0;
+  FOR_RANGE(int64_t, i, 0, saved_op_nodes.size()) {
+    const OpNode* saved_op_node = saved_op_nodes.at(i);
+    if (!IsDropped(saved_op_node)) { continue; }
+    Recompute(saved_op_node);
+    dropped_bytes += saved_activations.at(i).bytes;
+    for (const OpEdge* out_edge : op_node2backward_out_edges.at(saved_op_node)) {
+      OpNode* consumer = out_edge->dst_node();
+      op_node2backward_consumers[saved_op_node].insert(consumer);
+      const std::string& consumer_op_name = consumer->op().op_name();
+      if (backward_op_name2op_conf.find(consumer_op_name) == backward_op_name2op_conf.end()) {
+        backward_op_name2op_conf.emplace(consumer_op_name, consumer->op().op_conf());
+      }
+      OperatorConf* op_conf = &backward_op_name2op_conf.at(consumer_op_name);
+      PbMessage* op_type_conf = MutableMessageInPbMessage(op_conf, op_conf->op_type_case());
+      for (const LogicalBlobId& lbi : out_edge->lbis()) {
+        for (const std::string& ibn : out_edge->lbi2ibns().at(lbi)) {
+          ReplaceInputLbnInOpCustomizedConf(op_type_conf, ibn,
+                                            GetInputLbnInOpCustomizedConf(*op_type_conf, ibn),
+                                            RecomputeLbn(lbi));
+        }
+      }
+    }
+  }
+  if (recomputed_op_nodes.empty()) { return Maybe<void>::Ok(); }
+  // backward consumers of every recomputed op and of the recomputed ops depending on it;
+  // recomputed_op_nodes is ordered producers first
+  for (auto iter = recomputed_op_nodes.rbegin(); iter != recomputed_op_nodes.rend(); ++iter) {
+    const OpNode* op_node = *iter;
+    HashSet<OpNode*>* consumers = &op_node2backward_consumers[op_node];
+    op_node->ForEachNodeOnOutEdge([&](OpNode* out_node) {
+      if (op_node2recompute_op_conf.find(out_node) == op_node2recompute_op_conf.end()) { return; }
+      const auto& out_consumers = op_node2backward_consumers[out_node];
+      consumers->insert(out_consumers.begin(), out_consumers.end());
+    });
+  }
+  // hold the recomputation back until the backward ops feeding its consumers have run, unless
+  // one of them depends on the recomputation itself
+  int64_t triggered_cnt = 0;
+  for (const OpNode* op_node : recomputed_op_nodes) {
+    bool is_root = true;
+    for (const auto& ibn : op_node->op().input_bns()) {
+      if (IsDropped(&op_node->SrcNode4Ibn(ibn))) { is_root = false; }
+    }
+    if (!is_root) { continue; }
+    const HashSet<OpNode*>& consumers = op_node2backward_consumers.at(op_node);
+    HashSet<const OpNode*> consumers_and_descendants;
+    {
+      const std::list<OpNode*> starts(consumers.begin(), consumers.end());
+      op_graph.BfsForEachNode(starts, &OpNode::ForEachNodeOnOutEdge,
+                              [&](OpNode* node) { consumers_and_descendants.insert(node); });
+    }
+    HashSet<std::string> trigger_op_names;
+    for (const OpNode* consumer : consumers) {
+      consumer->ForEachNodeOnInEdge([&](OpNode* in_node) {
+        if (IsForward(in_node)) { return; }
+        if (consumers_and_descendants.find(in_node) != consumers_and_descendants.end()) { return; }
+        if (*in_node->out_blob_time_shape() != *op_node->out_blob_time_shape()) { return; }
+        trigger_op_names.insert(in_node->op().op_name());
+      });
+    }
+    OperatorConf* op_conf = &op_node2recompute_op_conf.at(op_node);
+    for (const std::string& op_name : trigger_op_names) { op_conf->add_ctrl_in_op_name(op_name); }
+    if (!trigger_op_names.empty()) { triggered_cnt += 1; }
+  }
+  double extra_flops = 0;
+  double forward_flops = 0;
+  for (const OpNode* op_node : forward_op_nodes) {
+    if (op_node->op().op_conf().has_user_conf()) { forward_flops += EstimateFlops(*op_node); }
+  }
+  for (const OpNode* op_node : recomputed_op_nodes) {
+    extra_flops += EstimateFlops(*op_node);
+    job_builder->AddOps(op_node->parallel_desc().parallel_conf(),
+                        {op_node2recompute_op_conf.at(op_node)});
+    job_builder->AddSbpSignature4OpName(op_node2recompute_op_conf.at(op_node).name(),
+                                        op_node->sbp_signature());
+  }
+  std::vector<OperatorConf> backward_op_confs;
+  for (const auto& pair : backward_op_name2op_conf) { backward_op_confs.push_back(pair.second); }
+  job_builder->MutOpsOnlyOnce(backward_op_confs);
+  std::vector<bool> is_checkpoint(saved_op_nodes.size());
+  FOR_RANGE(int64_t, i, 0, saved_op_nodes.size()) {
+    is_checkpoint.at(i) = checkpoints.find(saved_op_nodes.at(i)) != checkpoints.end();
+  }
+  const RecomputationEstimate estimate = EstimateRecomputation(saved_activations, is_checkpoint);
+  double saved_bytes = 0;
+  for (const SavedActivation& saved : saved_activations) { saved_bytes += saved.bytes; }
+  LOG(INFO) << "activation recomputation drops " << dropped_bytes / 1024 / 1024
+            << " MB per device by recomputing " << recomputed_op_nodes.size() << " ops ("
+            << triggered_cnt << " held back until backward); estimated peak of activations kept "
+            << "for backward " << saved_bytes / 1024 / 1024 << " MB -> "
+            << estimate.peak_bytes / 1024 / 1024 << " MB, extra forward flops " << extra_flops
+            << " (" << (forward_flops > 0 ? 100 * extra_flops / forward_flops : 0) << "%)";
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("ActivationRecomputationPass", ActivationRecomputationPass);
+
+}  // namespace oneflow
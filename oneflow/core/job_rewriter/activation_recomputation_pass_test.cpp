@@ -0,0 +1,185 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+#include "oneflow/core/framework/user_op_conf.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/resource_desc.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+void NewGlobals() {
+  EnvProto env_proto;
+  auto* machine = env_proto.add_machine();
+  machine->set_id(0);
+  machine->set_addr("127.0.0.1");
+  env_proto.set_ctrl_port(9527);
+  Resource resource;
+  resource.set_machine_num(1);
+  resource.set_cpu_device_num(1);
+  resource.set_gpu_device_num(0);
+  Global<EnvDesc>::New(env_proto);
+  Global<ResourceDesc, ForSession>::New(resource);
+}
+
+void DeleteGlobals() {
+  Global<ResourceDesc, ForSession>::Delete();
+  Global<EnvDesc>::Delete();
+}
+
+JobConfigProto TrainJobConf(const std::string& checkpoint_op_names) {
+  JobConfigProto job_conf;
+  job_conf.set_job_name("activation_recomputation_test");
+  job_conf.mutable_train_conf()->add_loss_lbn("loss/out_0");
+  auto* flag_name2flag_value = job_conf.mutable_flag_name2flag_value();
+  (*flag_name2flag_value)["enable_activation_recomputation"].set_at_bool(true);
+  (*flag_name2flag_value)["activation_recomputation_checkpoint_op_names"].set_at_string(
+      checkpoint_op_names);
+  return job_conf;
+}
+
+OperatorConf Constant(const std::string& op_name) {
+  return user_op::UserOpConfWrapperBuilder(op_name)
+      .Op("constant")
+      .Attr<double>("floating_value", 1)
+      .Attr<int64_t>("integer_value", 0)
+      .Attr<bool>("is_floating_value", true)
+      .Attr<DataType>("dtype", DataType::kFloat)
+      .Attr<Shape>("shape", Shape({4, 8}))
+      .Output("out")
+      .Build()
+      .op_conf();
+}
+
+OperatorConf Relu(const std::string& op_name, const std::string& in) {
+  return user_op::UserOpConfWrapperBuilder(op_name)
+      .Op("relu")
+      .Input("in", in)
+      .Output("out")
+      .Build()
+      .op_conf();
+}
+
+OperatorConf ReluGrad(const std::string& op_name, const std::string& y, const std::string& dy) {
+  return user_op::UserOpConfWrapperBuilder(op_name)
+      .Op("relu_grad")
+      .Input("y", y)
+      .Input("dy", dy)
+      .Output("dx")
+      .Build()
+      .op_conf();
+}
+
+// x -> relu0 -> ... -> relu{depth - 1} -> loss in forward, and the relu_grad of every reluN
+// consuming reluN/out_0 in backward
+Job ReluChainJob(int64_t depth) {
+  Job job;
+  JobBuilder job_builder(&job);
+  ParallelConf parallel_conf;
+  parallel_conf.set_device_tag("cpu");
+  parallel_conf.add_device_name("0:0");
+  std::vector<OperatorConf> op_confs;
+  op_confs.push_back(Constant("x"));
+  std::string lbn = "x/out_0";
+  FOR_RANGE(int64_t, i, 0, depth) {
+    op_confs.push_back(Relu("relu" + std::to_string(i), lbn));
+    lbn = "relu" + std::to_string(i) + "/out_0";
+  }
+  op_confs.push_back(Relu("loss", lbn));
+  op_confs.push_back(Constant("dy"));
+  std::string dy_lbn = "dy/out_0";
+  for (int64_t i = depth - 1; i >= 0; --i) {
+    const std::string relu_name = "relu" + std::to_string(i);
+    op_confs.push_back(ReluGrad(relu_name + "_grad", relu_name + "/out_0", dy_lbn));
+    dy_lbn = relu_name + "_grad/dx_0";
+  }
+  job_builder.AddOps(parallel_conf, op_confs);
+  return job;
+}
+
+const OperatorConf* FindOpConf(const Job& job, const std::string& op_name) {
+  for (const OperatorConf& op_conf : job.net().op()) {
+    if (op_conf.name() == op_name) { return &op_conf; }
+  }
+  return nullptr;
+}
+
+std::string InputLbn(const Job& job, const std::string& op_name, const std::string& arg_name) {
+  const OperatorConf* op_conf = FindOpConf(job, op_name);
+  CHECK_NOTNULL(op_conf);
+  return op_conf->user_conf().input().at(arg_name).s(0);
+}
+
+Maybe<void> ApplyPass(const std::string& checkpoint_op_names, Job* job) {
+  GlobalJobDescScope scope(TrainJobConf(checkpoint_op_names), 0);
+  return FunctionPass("ActivationRecomputationPass")(job);
+}
+
+}  // namespace
+
+TEST(ActivationRecomputationPass, checkpoint_op_names) {
+  NewGlobals();
+  Job job = ReluChainJob(2);
+  ASSERT_TRUE(ApplyPass("relu1", &job).IsOk());
+  // relu0 is recomputed from x for its backward consumer, relu1 is kept
+  ASSERT_EQ(FindOpConf(job, "relu1-recompute"), nullptr);
+  ASSERT_EQ(InputLbn(job, "relu0-recompute", "in"), "x/out_0");
+  ASSERT_EQ(InputLbn(job, "relu0_grad", "y"), "relu0-recompute/out_0");
+  ASSERT_EQ(InputLbn(job, "relu1_grad", "y"), "relu1/out_0");
+  ASSERT_EQ(InputLbn(job, "relu1", "in"), "relu0/out_0");
+  // the recomputation waits for the backward op feeding relu0_grad
+  const auto& ctrl_in_op_names = FindOpConf(job, "relu0-recompute")->ctrl_in_op_name();
+  ASSERT_EQ(ctrl_in_op_names.size(), 1);
+  ASSERT_EQ(ctrl_in_op_names.Get(0), "relu1_grad");
+  // the rewritten job is still a valid graph
+  {
+    GlobalJobDescScope scope(TrainJobConf("relu1"), 0);
+    OpGraph op_graph;
+    ASSERT_TRUE(op_graph.Init(job).IsOk());
+  }
+  DeleteGlobals();
+}
+
+TEST(ActivationRecomputationPass, unknown_checkpoint_op_name) {
+  NewGlobals();
+  Job job = ReluChainJob(2);
+  const Job origin_job = job;
+  ASSERT_FALSE(ApplyPass("relu1,no_such_op", &job).IsOk());
+  ASSERT_EQ(job.net().op_size(), origin_job.net().op_size());
+  DeleteGlobals();
+}
+
+TEST(ActivationRecomputationPass, least_memory_checkpoints) {
+  NewGlobals();
+  Job job = ReluChainJob(4);
+  // four activations of 128 bytes, keeping only relu2 bounds the peak to 384 bytes
+  ASSERT_TRUE(ApplyPass("", &job).IsOk());
+  ASSERT_EQ(FindOpConf(job, "relu2-recompute"), nullptr);
+  ASSERT_EQ(InputLbn(job, "relu0-recompute", "in"), "x/out_0");
+  ASSERT_EQ(InputLbn(job, "relu1-recompute", "in"), "relu0-recompute/out_0");
+  ASSERT_EQ(InputLbn(job, "relu3-recompute", "in"), "relu2/out_0");
+  ASSERT_EQ(InputLbn(job, "relu1_grad", "y"), "relu1-recompute/out_0");
+  ASSERT_EQ(InputLbn(job, "relu2_grad", "y"), "relu2/out_0");
+  ASSERT_EQ(InputLbn(job, "relu3_grad", "y"), "relu3-recompute/out_0");
+  DeleteGlobals();
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -0,0 +1,93 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/activation_recomputation_plan.h"
+
+namespace oneflow {
+
+namespace {
+
+std::vector<bool> CheckpointsWithSegmentLimit(
+    const std::vector<SavedActivation>& saved_activations, double segment_limit) {
+  std::vector<bool> is_checkpoint(saved_activations.size(), false);
+  double segment_bytes = 0;
+  FOR_RANGE(int64_t, i, 0, saved_activations.size()) {
+    const SavedActivation& saved = saved_activations.at(i);
+    if (!saved.is_recomputable) {
+      segment_bytes = 0;
+    } else if (segment_bytes + saved.bytes > segment_limit) {
+      is_checkpoint.at(i) = true;
+      segment_bytes = 0;
+    } else {
+      segment_bytes += saved.bytes;
+    }
+  }
+  return is_checkpoint;
+}
+
+}  // namespace
+
+RecomputationEstimate EstimateRecomputation(const std::vector<SavedActivation>& saved_activations,
+                                            const std::vector<bool>& is_checkpoint) {
+  CHECK_EQ(saved_activations.size(), is_checkpoint.size());
+  RecomputationEstimate estimate{0, 0};
+  double segment_bytes = 0;
+  double max_segment_bytes = 0;
+  FOR_RANGE(int64_t, i, 0, saved_activations.size()) {
+    const SavedActivation& saved = saved_activations.at(i);
+    if (!saved.is_recomputable || is_checkpoint.at(i)) {
+      estimate.peak_bytes += saved.bytes;
+      max_segment_bytes = std::max(max_segment_bytes, segment_bytes);
+      segment_bytes = 0;
+    } else {
+      segment_bytes += saved.bytes;
+      estimate.extra_flops += saved.flops;
+    }
+  }
+  estimate.peak_bytes += std::max(max_segment_bytes, segment_bytes);
+  return estimate;
+}
+
+std::vector<bool> SelectRecomputationCheckpoints(
+    const std::vector<SavedActivation>& saved_activations, double budget_bytes) {
+  const std::vector<bool> all_saved(saved_activations.size(), true);
+  double total_bytes = 0;
+  for (const SavedActivation& saved : saved_activations) { total_bytes += saved.bytes; }
+  if (total_bytes <= budget_bytes) { return all_saved; }
+  std::vector<bool> best_checkpoints = all_saved;
+  RecomputationEstimate best = EstimateRecomputation(saved_activations, all_saved);
+  bool is_best_within_budget = false;
+  for (double segment_limit = total_bytes; segment_limit >= 1; segment_limit /= 2) {
+    std::vector<bool> checkpoints = CheckpointsWithSegmentLimit(saved_activations, segment_limit);
+    const RecomputationEstimate estimate = EstimateRecomputation(saved_activations, checkpoints);
+    const bool is_within_budget = budget_bytes > 0 && estimate.peak_bytes <= budget_bytes;
+    bool is_better = false;
+    if (is_within_budget != is_best_within_budget) {
+      is_better = is_within_budget;
+    } else if (is_within_budget) {
+      is_better = estimate.extra_flops < best.extra_flops;
+    } else {
+      is_better = estimate.peak_bytes < best.peak_bytes;
+    }
+    if (is_better) {
+      best_checkpoints.swap(checkpoints);
+      best = estimate;
+      is_best_within_budget = is_within_budget;
+    }
+  }
+  return best_checkpoints;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,48 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_REWRITER_ACTIVATION_RECOMPUTATION_PLAN_H_
+#define ONEFLOW_CORE_JOB_REWRITER_ACTIVATION_RECOMPUTATION_PLAN_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// the activations of a forward op kept alive until backward
+struct SavedActivation {
+  double bytes;
+  double flops;
+  bool is_recomputable;
+};
+
+struct RecomputationEstimate {
+  double peak_bytes;
+  double extra_flops;
+};
+
+// peak memory of activations kept for backward when each segment between checkpoints is
+// recomputed just before its backward ops run; saved_activations are in forward topo order and
+// is_checkpoint is indexed like them
+RecomputationEstimate EstimateRecomputation(const std::vector<SavedActivation>& saved_activations,
+                                            const std::vector<bool>& is_checkpoint);
+
+// the checkpoints with the fewest recomputed flops within budget_bytes, or the least memory if
+// none fits
+std::vector<bool> SelectRecomputationCheckpoints(
+    const std::vector<SavedActivation>& saved_activations, double budget_bytes);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_REWRITER_ACTIVATION_RECOMPUTATION_PLAN_H_
@@ -0,0 +1,78 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/activation_recomputation_plan.h"
+
+namespace oneflow {
+
+namespace {
+
+// a chain of num recomputable activations of 100 bytes and 1 flop each
+std::vector<SavedActivation> UniformChain(int64_t num) {
+  return std::vector<SavedActivation>(num, SavedActivation{100, 1, true});
+}
+
+}  // namespace
+
+TEST(ActivationRecomputation, estimate) {
+  const std::vector<SavedActivation> saved_activations = {
+      {100, 1, true}, {50, 2, true}, {200, 0, false}, {30, 3, true}, {40, 4, true}};
+  // the two segments around the non-recomputable one are recomputed one at a time
+  RecomputationEstimate estimate =
+      EstimateRecomputation(saved_activations, {false, false, false, false, false});
+  ASSERT_DOUBLE_EQ(estimate.peak_bytes, 200 + 150);
+  ASSERT_DOUBLE_EQ(estimate.extra_flops, 10);
+  estimate = EstimateRecomputation(saved_activations, {false, true, false, false, false});
+  ASSERT_DOUBLE_EQ(estimate.peak_bytes, 50 + 200 + 100);
+  ASSERT_DOUBLE_EQ(estimate.extra_flops, 8);
+  estimate = EstimateRecomputation(saved_activations, {true, true, true, true, true});
+  ASSERT_DOUBLE_EQ(estimate.peak_bytes, 420);
+  ASSERT_DOUBLE_EQ(estimate.extra_flops, 0);
+}
+
+TEST(ActivationRecomputation, keep_all_within_budget) {
+  const std::vector<bool> is_checkpoint = SelectRecomputationCheckpoints(UniformChain(8), 800);
+  ASSERT_EQ(is_checkpoint, std::vector<bool>(8, true));
+}
+
+TEST(ActivationRecomputation, least_memory_without_budget) {
+  const std::vector<SavedActivation> saved_activations = UniformChain(8);
+  const std::vector<bool> is_checkpoint = SelectRecomputationCheckpoints(saved_activations, 0);
+  ASSERT_EQ(is_checkpoint,
+            std::vector<bool>({false, false, true, false, false, true, false, false}));
+  ASSERT_DOUBLE_EQ(EstimateRecomputation(saved_activations, is_checkpoint).peak_bytes, 400);
+}
+
+TEST(ActivationRecomputation, fewest_flops_within_budget) {
+  const std::vector<SavedActivation> saved_activations = UniformChain(8);
+  // every other activation is kept, which recomputes the least among the plans of 500 bytes
+  const std::vector<bool> is_checkpoint = SelectRecomputationCheckpoints(saved_activations, 500);
+  ASSERT_EQ(is_checkpoint,
+            std::vector<bool>({false, true, false, true, false, true, false, true}));
+  const RecomputationEstimate estimate = EstimateRecomputation(saved_activations, is_checkpoint);
+  ASSERT_DOUBLE_EQ(estimate.peak_bytes, 500);
+  ASSERT_DOUBLE_EQ(estimate.extra_flops, 4);
+}
+
+TEST(ActivationRecomputation, non_recomputable_splits_segments) {
+  std::vector<SavedActivation> saved_activations = UniformChain(4);
+  saved_activations.insert(saved_activations.begin() + 2, SavedActivation{100, 0, false});
+  // the non-recomputable activation already bounds both segments to 200 bytes
+  const std::vector<bool> is_checkpoint = SelectRecomputationCheckpoints(saved_activations, 0);
+  ASSERT_DOUBLE_EQ(EstimateRecomputation(saved_activations, is_checkpoint).peak_bytes, 300);
+  ASSERT_EQ(is_checkpoint, std::vector<bool>(5, false));
+}
+
+}  // namespace oneflow
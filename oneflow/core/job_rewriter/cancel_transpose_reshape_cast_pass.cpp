@@ -0,0 +1,175 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/inference_graph_rewriter.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+// casting from `from` to `to` and back gives every value of `from`
+bool IsLosslessCast(DataType from, DataType to) {
+  if (from == to) { return true; }
+  static const HashMap<int, HashSet<int>> from2lossless_tos = {
+      {DataType::kInt8,
+       {DataType::kInt32, DataType::kInt64, DataType::kFloat16, DataType::kFloat,
+        DataType::kDouble}},
+      {DataType::kUInt8,
+       {DataType::kInt32, DataType::kInt64, DataType::kFloat16, DataType::kFloat,
+        DataType::kDouble}},
+      {DataType::kInt32, {DataType::kInt64, DataType::kDouble}},
+      {DataType::kFloat16, {DataType::kFloat, DataType::kDouble}},
+      {DataType::kFloat, {DataType::kDouble}},
+  };
+  const auto it = from2lossless_tos.find(from);
+  return it != from2lossless_tos.end() && it->second.find(to) != it->second.end();
+}
+
+bool IsIdentityPerm(const std::vector<int32_t>& perm) {
+  FOR_RANGE(int32_t, i, 0, perm.size()) {
+    if (perm.at(i) != i) { return false; }
+  }
+  return true;
+}
+
+struct CancellableOp {
+  std::string ibn;
+  std::string obn;
+};
+
+const HashMap<std::string, CancellableOp>& OpTypeName2CancellableOp() {
+  static const HashMap<std::string, CancellableOp> op_type_name2cancellable_op = {
+      {"transpose", {"input_0", "output_0"}},
+      {"reshape", {"in_0", "out_0"}},
+      {"cast", {"in_0", "out_0"}},
+  };
+  return op_type_name2cancellable_op;
+}
+
+// transpose(transpose(x)), reshape(reshape(x)) and cast(cast(x)) through a lossless cast are
+// computed from x directly, and those ending up as identities are removed; ops left without
+// readers afterwards are removed too
+class CancelTransposeReshapeCastPass final : public OpGraphPass {
+ public:
+  CancelTransposeReshapeCastPass() = default;
+  ~CancelTransposeReshapeCastPass() override = default;
+  bool IsEnabled() const override { return IsInferenceGraphOptimizationEnabled(); }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+};
+
+Maybe<void> CancelTransposeReshapeCastPass::Apply(const OpGraph& op_graph,
+                                                  JobBuilder* job_builder) const {
+  InferenceGraphRewriter rewriter(op_graph);
+  HashMap<LogicalBlobId, int64_t> lbi2num_readers;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ibn : op_node->op().input_bns()) {
+      lbi2num_readers[op_node->op().BnInOp2Lbi(ibn)] += 1;
+    }
+  });
+  const auto BlobDesc4Lbi = [&](const LogicalBlobId& lbi) -> const BlobDesc& {
+    return op_graph.OpNode4OpName(lbi.op_name())->LogicalBlobDesc4Lbi(lbi);
+  };
+  // the output of a removed op and the blob it equals
+  HashMap<LogicalBlobId, LogicalBlobId> removed_lbi2src_lbi;
+  // a kept cancellable op and the blob it is computed from after the rewrite
+  HashMap<std::string, LogicalBlobId> op_name2src_lbi;
+  HashMap<std::string, std::vector<int32_t>> op_name2perm;
+  std::vector<const OpNode*> kept_nodes;
+  op_graph.TopoForEachNode([&](const OpNode* op_node) {
+    const OperatorConf& op_conf = op_node->op().op_conf();
+    if (!op_conf.has_user_conf()) { return; }
+    const std::string& op_type_name = op_conf.user_conf().op_type_name();
+    const auto cancellable_it = OpTypeName2CancellableOp().find(op_type_name);
+    if (cancellable_it == OpTypeName2CancellableOp().end()) { return; }
+    if (rewriter.IsCtrlConnected(op_node)) { return; }
+    const LogicalBlobId& in_lbi = op_node->op().BnInOp2Lbi(cancellable_it->second.ibn);
+    const LogicalBlobId& out_lbi = op_node->op().BnInOp2Lbi(cancellable_it->second.obn);
+    const auto removed_it = removed_lbi2src_lbi.find(in_lbi);
+    const LogicalBlobId cur_in_lbi = removed_it == removed_lbi2src_lbi.end() ? in_lbi
+                                                                              : removed_it->second;
+    const OpNode* producer = op_graph.OpNode4OpName(cur_in_lbi.op_name());
+    const auto producer_src_it = op_name2src_lbi.find(producer->op().op_name());
+    const bool is_chained =
+        producer_src_it != op_name2src_lbi.end()
+        && IsUserOpWithTypeName(producer->op().op_conf(), op_type_name)
+        && producer->parallel_desc() == op_node->parallel_desc();
+    const BlobDesc& out_desc = op_node->LogicalBlobDesc4Lbi(out_lbi);
+    LogicalBlobId src_lbi = cur_in_lbi;
+    std::vector<int32_t> perm;
+    bool is_identity = false;
+    if (op_type_name == "transpose") {
+      perm = user_op::UserOpConfWrapper(op_conf).attr<std::vector<int32_t>>("perm");
+      if (is_chained) {
+        // output[i] = input[perm[i]] = src[producer_perm[perm[i]]]
+        const std::vector<int32_t>& producer_perm = op_name2perm.at(producer->op().op_name());
+        for (int32_t& axis : perm) { axis = producer_perm.at(axis); }
+        src_lbi = producer_src_it->second;
+      }
+      is_identity = IsIdentityPerm(perm);
+    } else if (op_type_name == "reshape") {
+      if (out_desc.is_dynamic() || BlobDesc4Lbi(cur_in_lbi).is_dynamic()) { return; }
+      if (is_chained) { src_lbi = producer_src_it->second; }
+      is_identity = BlobDesc4Lbi(src_lbi).shape() == out_desc.shape();
+    } else if (op_type_name == "cast") {
+      if (is_chained
+          && IsLosslessCast(BlobDesc4Lbi(producer_src_it->second).data_type(),
+                            BlobDesc4Lbi(cur_in_lbi).data_type())) {
+        src_lbi = producer_src_it->second;
+      }
+      is_identity = BlobDesc4Lbi(src_lbi).data_type() == out_desc.data_type();
+    } else {
+      UNIMPLEMENTED();
+    }
+    lbi2num_readers[cur_in_lbi] -= 1;
+    if (is_identity) {
+      removed_lbi2src_lbi.emplace(out_lbi, src_lbi);
+      rewriter.RedirectConsumers(op_node, out_lbi, GenLogicalBlobName(src_lbi));
+      lbi2num_readers[src_lbi] += lbi2num_readers[out_lbi];
+      lbi2num_readers[out_lbi] = 0;
+      rewriter.DelOp(op_node);
+      return;
+    }
+    lbi2num_readers[src_lbi] += 1;
+    if (src_lbi != cur_in_lbi) {
+      rewriter.ResetInputLbn(op_node, cancellable_it->second.ibn, GenLogicalBlobName(src_lbi));
+      if (op_type_name == "transpose") {
+        auto* perm_val = (*rewriter.MutOpConf(op_node)->mutable_user_conf()->mutable_attr())["perm"]
+                             .mutable_at_list_int32();
+        perm_val->clear_val();
+        for (int32_t axis : perm) { perm_val->add_val(axis); }
+      }
+    }
+    op_name2src_lbi.emplace(op_node->op().op_name(), src_lbi);
+    op_name2perm.emplace(op_node->op().op_name(), perm);
+    kept_nodes.push_back(op_node);
+  });
+  for (auto it = kept_nodes.rbegin(); it != kept_nodes.rend(); ++it) {
+    const OpNode* op_node = *it;
+    if (op_node->out_edges().empty()) { continue; }
+    const LogicalBlobId& out_lbi = op_node->op().BnInOp2Lbi(op_node->op().SoleObn());
+    if (lbi2num_readers.at(out_lbi) > 0) { continue; }
+    lbi2num_readers[op_name2src_lbi.at(op_node->op().op_name())] -= 1;
+    rewriter.DelOp(op_node);
+  }
+  rewriter.Commit("CancelTransposeReshapeCastPass", job_builder);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("CancelTransposeReshapeCastPass", CancelTransposeReshapeCastPass);
+
+}  // namespace oneflow
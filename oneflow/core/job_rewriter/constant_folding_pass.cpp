@@ -0,0 +1,208 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cmath>
+#include "oneflow/core/job_rewriter/inference_graph_rewriter.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+// The only blobs known at compile time are the uniform fills of constant ops; variables are
+// loaded at runtime, so a subgraph fed by them is left to the kernels.
+
+// integers beyond 2^53 are not exact in double
+const double kMaxExactInteger = 9007199254740992.0;
+
+bool ConvertToDataType(double value, DataType data_type, double* converted) {
+  if (!std::isfinite(value)) { return false; }
+  switch (data_type) {
+    case DataType::kFloat: *converted = static_cast<float>(value); break;
+    case DataType::kDouble: *converted = value; break;
+    case DataType::kInt32:
+      *converted = std::trunc(value);
+      if (std::abs(*converted) > GetMaxVal<int32_t>()) { return false; }
+      break;
+    case DataType::kInt64:
+      *converted = std::trunc(value);
+      if (std::abs(*converted) > kMaxExactInteger) { return false; }
+      break;
+    default: return false;
+  }
+  return std::isfinite(*converted);
+}
+
+const HashSet<std::string>& ValuePreservingOpTypeNames() {
+  static const HashSet<std::string> op_type_names = {"cast",        "reshape", "identity",
+                                                     "expand_dims", "squeeze", "transpose"};
+  return op_type_names;
+}
+
+// float results are evaluated in double and rounded once, which equals the float kernels for
+// + - * / and sqrt and is within an ulp of them for the transcendental functions
+const HashMap<std::string, std::function<double(double)>>& UnaryMathOpTypeName2Fn() {
+  static const HashMap<std::string, std::function<double(double)>> op_type_name2fn = {
+      {"abs", [](double x) { return std::abs(x); }},
+      {"ceil", [](double x) { return std::ceil(x); }},
+      {"exp", [](double x) { return std::exp(x); }},
+      {"floor", [](double x) { return std::floor(x); }},
+      {"log", [](double x) { return std::log(x); }},
+      {"negative", [](double x) { return -x; }},
+      {"reciprocal", [](double x) { return 1.0 / x; }},
+      {"rsqrt", [](double x) { return 1.0 / std::sqrt(x); }},
+      {"sigmoid_v2", [](double x) { return 1.0 / (1.0 + std::exp(-x)); }},
+      {"sqrt", [](double x) { return std::sqrt(x); }},
+      {"square", [](double x) { return x * x; }},
+      {"tanh_v2", [](double x) { return std::tanh(x); }},
+  };
+  return op_type_name2fn;
+}
+
+const HashMap<std::string, std::function<double(double, double)>>& BinaryOpTypeName2Fn() {
+  static const HashMap<std::string, std::function<double(double, double)>> op_type_name2fn = {
+      {"broadcast_add", [](double x, double y) { return x + y; }},
+      {"broadcast_sub", [](double x, double y) { return x - y; }},
+      {"broadcast_mul", [](double x, double y) { return x * y; }},
+      {"broadcast_div", [](double x, double y) { return x / y; }},
+      {"broadcast_maximum", [](double x, double y) { return std::max(x, y); }},
+      {"broadcast_minimum", [](double x, double y) { return std::min(x, y); }},
+  };
+  return op_type_name2fn;
+}
+
+bool EvalFoldableOp(const OpNode* op_node, const HashMap<LogicalBlobId, double>& lbi2value,
+                    double* value) {
+  const OperatorConf& op_conf = op_node->op().op_conf();
+  if (!op_conf.has_user_conf()) { return false; }
+  const std::string& op_type_name = op_conf.user_conf().op_type_name();
+  const auto Value4Ibn = [&](const std::string& ibn) {
+    return lbi2value.at(op_node->op().BnInOp2Lbi(ibn));
+  };
+  const DataType data_type =
+      op_node->LogicalBlobDesc4Lbi(op_node->op().BnInOp2Lbi(op_node->op().SoleObn())).data_type();
+  if (ValuePreservingOpTypeNames().find(op_type_name) != ValuePreservingOpTypeNames().end()) {
+    *value = Value4Ibn(op_node->op().SoleIbn());
+    return true;
+  }
+  if (op_type_name == "scalar_add" || op_type_name == "scalar_mul") {
+    user_op::UserOpConfWrapper op(op_conf);
+    double operand = op.attr<bool>("has_float_operand")
+                         ? op.attr<double>("float_operand")
+                         : static_cast<double>(op.attr<int64_t>("int_operand"));
+    // the kernels take the operand in the data type of the blob
+    if (!ConvertToDataType(operand, data_type, &operand)) { return false; }
+    const double in = Value4Ibn("in_0");
+    *value = op_type_name == "scalar_add" ? in + operand : in * operand;
+    return true;
+  }
+  const auto unary_it = UnaryMathOpTypeName2Fn().find(op_type_name);
+  if (unary_it != UnaryMathOpTypeName2Fn().end()) {
+    *value = unary_it->second(Value4Ibn("x_0"));
+    return true;
+  }
+  const auto binary_it = BinaryOpTypeName2Fn().find(op_type_name);
+  if (binary_it != BinaryOpTypeName2Fn().end()) {
+    *value = binary_it->second(Value4Ibn("x_0"), Value4Ibn("y_0"));
+    return true;
+  }
+  return false;
+}
+
+class ConstantFoldingPass final : public OpGraphPass {
+ public:
+  ConstantFoldingPass() = default;
+  ~ConstantFoldingPass() override = default;
+  bool IsEnabled() const override { return IsInferenceGraphOptimizationEnabled(); }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+};
+
+Maybe<void> ConstantFoldingPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+  InferenceGraphRewriter rewriter(op_graph);
+  HashMap<LogicalBlobId, double> lbi2value;
+  std::vector<const OpNode*> constant_nodes;
+  std::vector<const OpNode*> folded_nodes;
+  HashSet<const OpNode*> folded_node_set;
+  op_graph.TopoForEachNode([&](const OpNode* op_node) {
+    const Operator& op = op_node->op();
+    if (rewriter.IsCtrlConnected(op_node)) { return; }
+    if (op.output_bns().size() != 1) { return; }
+    if (CHECK_JUST(op.OptMirroredParallel4BnInOp(op.SoleObn()))->has_mirrored_parallel()) {
+      return;
+    }
+    const LogicalBlobId& out_lbi = op.BnInOp2Lbi(op.SoleObn());
+    const BlobDesc& out_desc = op_node->LogicalBlobDesc4Lbi(out_lbi);
+    if (out_desc.is_dynamic()) { return; }
+    double value = 0;
+    if (IsUserOpWithTypeName(op.op_conf(), "constant")) {
+      user_op::UserOpConfWrapper constant(op.op_conf());
+      value = constant.attr<bool>("is_floating_value")
+                  ? constant.attr<double>("floating_value")
+                  : static_cast<double>(constant.attr<int64_t>("integer_value"));
+      if (!ConvertToDataType(value, out_desc.data_type(), &value)) { return; }
+      lbi2value.emplace(out_lbi, value);
+      constant_nodes.push_back(op_node);
+      return;
+    }
+    if (op.input_bns().empty()) { return; }
+    for (const std::string& ibn : op.input_bns()) {
+      if (lbi2value.find(op.BnInOp2Lbi(ibn)) == lbi2value.end()) { return; }
+    }
+    if (!EvalFoldableOp(op_node, lbi2value, &value)) { return; }
+    if (!ConvertToDataType(value, out_desc.data_type(), &value)) { return; }
+    lbi2value.emplace(out_lbi, value);
+    folded_nodes.push_back(op_node);
+    folded_node_set.insert(op_node);
+  });
+  const auto IsReadOnlyByFoldedNodes = [&](const OpNode* op_node) {
+    for (const OpEdge* out_edge : op_node->out_edges()) {
+      if (folded_node_set.find(out_edge->dst_node()) == folded_node_set.end()) { return false; }
+    }
+    return true;
+  };
+  for (const OpNode* op_node : folded_nodes) {
+    if (!IsReadOnlyByFoldedNodes(op_node)) {
+      const LogicalBlobId& out_lbi = op_node->op().BnInOp2Lbi(op_node->op().SoleObn());
+      const BlobDesc& out_desc = op_node->LogicalBlobDesc4Lbi(out_lbi);
+      const double value = lbi2value.at(out_lbi);
+      const bool is_floating_value = IsFloatingDataType(out_desc.data_type());
+      const auto constant_op =
+          user_op::UserOpConfWrapperBuilder(op_node->op().op_name() + "-constant_folded")
+              .Op("constant")
+              .Output("out")
+              .Attr("floating_value", is_floating_value ? value : 0.0)
+              .Attr("integer_value", is_floating_value ? 0 : static_cast<int64_t>(value))
+              .Attr("is_floating_value", is_floating_value)
+              .Attr("dtype", out_desc.data_type())
+              .Attr("shape", out_desc.shape())
+              .Build();
+      rewriter.AddOps(op_node->parallel_desc().parallel_conf(), {constant_op.op_conf()});
+      rewriter.RedirectConsumers(op_node, out_lbi, constant_op.output("out", 0));
+    }
+    rewriter.DelOp(op_node);
+  }
+  for (const OpNode* op_node : constant_nodes) {
+    if (op_node->out_edges().empty()) { continue; }
+    if (IsReadOnlyByFoldedNodes(op_node)) { rewriter.DelOp(op_node); }
+  }
+  rewriter.Commit("ConstantFoldingPass", job_builder);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("ConstantFoldingPass", ConstantFoldingPass);
+
+}  // namespace oneflow
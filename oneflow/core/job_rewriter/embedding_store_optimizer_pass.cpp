@@ -0,0 +1,88 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+bool HasInputBn(const Operator& op, const std::string& bn) {
+  return std::find(op.input_bns().begin(), op.input_bns().end(), bn) != op.input_bns().end();
+}
+
+// the model update op generated for the shadow variable of an embedding store
+Maybe<const OpNode*> ShadowModelUpdateOpNode(const OpGraph& op_graph,
+                                             const LogicalBlobId& shadow_lbi) {
+  const OpNode* shadow_node = op_graph.OpNode4OpName(shadow_lbi.op_name());
+  CHECK_NOTNULL_OR_RETURN(shadow_node) << "embedding store shadow " << shadow_lbi.op_name();
+  const OpNode* model_update_op_node = nullptr;
+  for (const OpEdge* out_edge : shadow_node->out_edges()) {
+    const Operator& op = out_edge->dst_node()->op();
+    if (HasInputBn(op, "model") && op.BnInOp2Lbi("model") == shadow_lbi
+        && HasInputBn(op, "learning_rate") && HasInputBn(op, "train_step")) {
+      model_update_op_node = out_edge->dst_node();
+    }
+  }
+  CHECK_NOTNULL_OR_RETURN(model_update_op_node)
+      << "no model update op found for embedding store shadow " << shadow_lbi.op_name();
+  return model_update_op_node;
+}
+
+// embedding_store_update ops are the grad of embedding_store_lookup and come before the
+// optimizer ops, so they are given the learning rate and train step of the model update op of
+// their shadow variable here, which follow the learning rate schedule of the job
+class EmbeddingStoreOptimizerPass final : public OpGraphPass {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(EmbeddingStoreOptimizerPass);
+  EmbeddingStoreOptimizerPass() = default;
+  ~EmbeddingStoreOptimizerPass() override = default;
+  bool IsEnabled() const override { return GlobalJobDesc().IsTrain(); }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+};
+
+Maybe<void> EmbeddingStoreOptimizerPass::Apply(const OpGraph& op_graph,
+                                               JobBuilder* job_builder) const {
+  std::vector<const OpNode*> update_op_nodes;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    const OperatorConf& op_conf = op_node->op().op_conf();
+    if (op_conf.has_user_conf() && op_conf.user_conf().op_type_name() == "embedding_store_update") {
+      update_op_nodes.push_back(op_node);
+    }
+  });
+  std::vector<OperatorConf> update_op_confs;
+  for (const OpNode* update_op_node : update_op_nodes) {
+    const user_op::UserOpConfWrapper update_op(update_op_node->op().op_conf());
+    if (update_op.has_input("learning_rate", 0)) { continue; }
+    const OpNode* model_update_op_node =
+        JUST(ShadowModelUpdateOpNode(op_graph, GenLogicalBlobId(update_op.input("shadow", 0))));
+    const Operator& model_update_op = model_update_op_node->op();
+    OperatorConf update_op_conf(update_op.op_conf());
+    auto* input = update_op_conf.mutable_user_conf()->mutable_input();
+    (*input)["learning_rate"].add_s(
+        GenLogicalBlobName(model_update_op.BnInOp2Lbi("learning_rate")));
+    (*input)["train_step"].add_s(GenLogicalBlobName(model_update_op.BnInOp2Lbi("train_step")));
+    update_op_confs.push_back(update_op_conf);
+  }
+  job_builder->MutOpsOnlyOnce(update_op_confs);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("EmbeddingStoreOptimizerPass", EmbeddingStoreOptimizerPass);
+
+}  // namespace oneflow
@@ -0,0 +1,187 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/inference_graph_rewriter.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+bool IsConvOp(const OperatorConf& op_conf) {
+  return IsUserOpWithTypeName(op_conf, "conv1d") || IsUserOpWithTypeName(op_conf, "conv2d")
+         || IsUserOpWithTypeName(op_conf, "conv3d");
+}
+
+// a conv or matmul whose output channels a batch norm can be folded into by scaling its weight
+struct FoldableOp {
+  std::string weight_ibn;
+  int32_t weight_channel_axis;
+  int32_t out_channel_axis;
+};
+
+bool GetFoldableOp(const OpNode* op_node, FoldableOp* foldable_op) {
+  const OperatorConf& op_conf = op_node->op().op_conf();
+  const BlobDesc& out_desc = op_node->LogicalBlobDesc4Lbi(op_node->op().BnInOp2Lbi("out_0"));
+  if (IsConvOp(op_conf)) {
+    const user_op::UserOpConfWrapper conv(op_conf);
+    foldable_op->weight_ibn = "weight_0";
+    foldable_op->weight_channel_axis = 0;
+    foldable_op->out_channel_axis = conv.attr<std::string>("data_format") == "channels_first"
+                                        ? 1
+                                        : out_desc.shape().NumAxes() - 1;
+    return true;
+  }
+  if (IsUserOpWithTypeName(op_conf, "matmul")) {
+    // out = a * b, the output channels are the columns of b
+    const user_op::UserOpConfWrapper matmul(op_conf);
+    foldable_op->weight_ibn = "b_0";
+    foldable_op->weight_channel_axis = matmul.attr<bool>("transpose_b") ? 0 : 1;
+    foldable_op->out_channel_axis = 1;
+    return true;
+  }
+  return false;
+}
+
+// the sole reader of the sole output of producer is consumer
+bool IsSoleConsumer(const OpNode* producer, const OpNode* consumer) {
+  if (producer->op().output_bns().size() != 1) { return false; }
+  if (producer->out_edges().size() != 1) { return false; }
+  const OpEdge* out_edge = *producer->out_edges().begin();
+  if (out_edge->dst_node() != consumer) { return false; }
+  return out_edge->lbi2ibns().size() == 1 && out_edge->lbi2ibns().begin()->second.size() == 1;
+}
+
+// conv or matmul -> [bias_add] -> normalization(training=false) is rewritten into
+//   conv or matmul(folded_weight) -> bias_add(folded_bias)
+// where a fold_batch_norm_params op computes folded_weight = weight * scale and
+// folded_bias = (bias - moving_mean) * scale + beta with scale = gamma / sqrt(moving_variance +
+// epsilon). It folds once per generation of the variables instead of on every iteration.
+class FoldBatchNormPass final : public OpGraphPass {
+ public:
+  FoldBatchNormPass() = default;
+  ~FoldBatchNormPass() override = default;
+  bool IsEnabled() const override { return IsInferenceGraphOptimizationEnabled(); }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+
+ private:
+  void TryFold(const OpNode* bn_node, InferenceGraphRewriter* rewriter) const;
+};
+
+void FoldBatchNormPass::TryFold(const OpNode* bn_node, InferenceGraphRewriter* rewriter) const {
+  const OperatorConf& bn_op_conf = bn_node->op().op_conf();
+  if (!IsUserOpWithTypeName(bn_op_conf, "normalization")) { return; }
+  user_op::UserOpConfWrapper bn(bn_op_conf);
+  if (bn.attr<bool>("training")) { return; }
+  if (bn.has_output("mean", 0) || bn.has_output("inv_variance", 0)) { return; }
+  const OpNode* bias_add_node = nullptr;
+  const OpNode* weighted_node = &bn_node->SrcNode4Ibn("x_0");
+  if (IsUserOpWithTypeName(weighted_node->op().op_conf(), "bias_add")) {
+    bias_add_node = weighted_node;
+    weighted_node = &bias_add_node->SrcNode4Ibn("a_0");
+  }
+  FoldableOp foldable_op;
+  if (!GetFoldableOp(weighted_node, &foldable_op)) { return; }
+  // the unnormalized activation must not be observed by anyone else
+  if (!IsSoleConsumer(weighted_node, bias_add_node != nullptr ? bias_add_node : bn_node)) {
+    return;
+  }
+  if (bias_add_node != nullptr && !IsSoleConsumer(bias_add_node, bn_node)) { return; }
+  for (const OpNode* op_node : {bn_node, weighted_node, bias_add_node}) {
+    if (op_node == nullptr) { continue; }
+    if (rewriter->IsCtrlConnected(op_node)) { return; }
+    if (!(op_node->parallel_desc() == weighted_node->parallel_desc())) { return; }
+  }
+  const user_op::UserOpConfWrapper weighted(weighted_node->op().op_conf());
+  const BlobDesc& out_desc =
+      weighted_node->LogicalBlobDesc4Lbi(weighted_node->op().BnInOp2Lbi("out_0"));
+  const LogicalBlobId& weight_lbi = weighted_node->op().BnInOp2Lbi(foldable_op.weight_ibn);
+  const BlobDesc& weight_desc = weighted_node->LogicalBlobDesc4Lbi(weight_lbi);
+  const int32_t channel_axis = foldable_op.out_channel_axis;
+  if (bn.attr<int32_t>("axis") != channel_axis) { return; }
+  const bool has_bias = weighted.has_input("bias", 0);
+  if (bias_add_node != nullptr) {
+    if (has_bias) { return; }
+    user_op::UserOpConfWrapper bias_add(bias_add_node->op().op_conf());
+    if (bias_add.attr<int32_t>("axis") != channel_axis) { return; }
+  }
+  const DataType data_type = out_desc.data_type();
+  if (data_type != DataType::kFloat && data_type != DataType::kDouble) { return; }
+  for (const std::string& ibn : {"moving_mean_0", "moving_variance_0", "gamma_0", "beta_0"}) {
+    if (bn_node->LogicalBlobDesc4Lbi(bn_node->op().BnInOp2Lbi(ibn)).data_type() != data_type) {
+      return;
+    }
+  }
+  if (weight_desc.data_type() != data_type) { return; }
+
+  std::string bias_lbn;
+  if (has_bias) {
+    bias_lbn = weighted.input("bias", 0);
+  } else if (bias_add_node != nullptr) {
+    bias_lbn = user_op::UserOpConfWrapper(bias_add_node->op().op_conf()).input("b", 0);
+  }
+  const std::string prefix = bn.op_name() + "-fold_";
+  std::vector<OperatorConf> op_confs;
+  user_op::UserOpConfWrapperBuilder fold_builder(prefix + "params");
+  fold_builder.Op("fold_batch_norm_params").Input("weight", GenLogicalBlobName(weight_lbi));
+  if (!bias_lbn.empty()) { fold_builder.Input("bias", bias_lbn); }
+  const auto fold = fold_builder.Input("moving_mean", bn.input("moving_mean", 0))
+                        .Input("moving_variance", bn.input("moving_variance", 0))
+                        .Input("gamma", bn.input("gamma", 0))
+                        .Input("beta", bn.input("beta", 0))
+                        .Output("folded_weight")
+                        .Output("folded_bias")
+                        .Attr("weight_channel_axis", foldable_op.weight_channel_axis)
+                        .Attr("epsilon", bn.attr<float>("epsilon"))
+                        .Build();
+  op_confs.push_back(fold.op_conf());
+  const std::string folded_bias_lbn = fold.output("folded_bias", 0);
+
+  rewriter->ResetInputLbn(weighted_node, foldable_op.weight_ibn, fold.output("folded_weight", 0));
+  std::string out_lbn;
+  if (has_bias) {
+    rewriter->ResetInputLbn(weighted_node, "bias_0", folded_bias_lbn);
+    out_lbn = weighted.output("out", 0);
+  } else if (bias_add_node != nullptr) {
+    rewriter->ResetInputLbn(bias_add_node, "b_0", folded_bias_lbn);
+    out_lbn = GenLogicalBlobName(bias_add_node->op().BnInOp2Lbi("out_0"));
+  } else {
+    const auto bias_add = user_op::UserOpConfWrapperBuilder(prefix + "bias_add")
+                              .Op("bias_add")
+                              .Input("a", weighted.output("out", 0))
+                              .Input("b", folded_bias_lbn)
+                              .Output("out")
+                              .Attr("axis", channel_axis)
+                              .Build();
+    op_confs.push_back(bias_add.op_conf());
+    out_lbn = bias_add.output("out", 0);
+  }
+  rewriter->AddOps(weighted_node->parallel_desc().parallel_conf(), op_confs);
+  rewriter->RedirectConsumers(bn_node, bn_node->op().BnInOp2Lbi("y_0"), out_lbn);
+  rewriter->DelOp(bn_node);
+}
+
+Maybe<void> FoldBatchNormPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+  InferenceGraphRewriter rewriter(op_graph);
+  op_graph.TopoForEachNode([&](const OpNode* op_node) { TryFold(op_node, &rewriter); });
+  rewriter.Commit("FoldBatchNormPass", job_builder);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("FoldBatchNormPass", FoldBatchNormPass);
+
+}  // namespace oneflow
@@ -0,0 +1,264 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+#include "oneflow/core/framework/user_op_conf.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/resource_desc.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+void NewGlobals() {
+  EnvProto env_proto;
+  auto* machine = env_proto.add_machine();
+  machine->set_id(0);
+  machine->set_addr("127.0.0.1");
+  env_proto.set_ctrl_port(9527);
+  Resource resource;
+  resource.set_machine_num(1);
+  resource.set_cpu_device_num(1);
+  resource.set_gpu_device_num(0);
+  Global<EnvDesc>::New(env_proto);
+  Global<ResourceDesc, ForSession>::New(resource);
+}
+
+void DeleteGlobals() {
+  Global<ResourceDesc, ForSession>::Delete();
+  Global<EnvDesc>::Delete();
+}
+
+JobConfigProto PredictJobConf() {
+  JobConfigProto job_conf;
+  job_conf.set_job_name("fold_batch_norm_test");
+  job_conf.mutable_predict_conf();
+  (*job_conf.mutable_flag_name2flag_value())["enable_inference_graph_optimization"].set_at_bool(
+      true);
+  return job_conf;
+}
+
+OperatorConf Constant(const std::string& op_name, const Shape& shape) {
+  return user_op::UserOpConfWrapperBuilder(op_name)
+      .Op("constant")
+      .Attr<double>("floating_value", 1)
+      .Attr<int64_t>("integer_value", 0)
+      .Attr<bool>("is_floating_value", true)
+      .Attr<DataType>("dtype", DataType::kFloat)
+      .Attr<Shape>("shape", shape)
+      .Output("out")
+      .Build()
+      .op_conf();
+}
+
+OperatorConf Conv2d(const std::string& op_name, const std::string& in, const std::string& weight,
+                    int32_t filters) {
+  return user_op::UserOpConfWrapperBuilder(op_name)
+      .Op("conv2d")
+      .Input("in", in)
+      .Input("weight", weight)
+      .Output("out")
+      .Attr<int32_t>("filters", filters)
+      .Attr<std::vector<int32_t>>("padding_before", {1, 1})
+      .Attr<std::string>("data_format", "channels_first")
+      .Attr<std::vector<int32_t>>("kernel_size", {3, 3})
+      .Attr<std::vector<int32_t>>("strides", {1, 1})
+      .Attr<std::vector<int32_t>>("dilation_rate", {1, 1})
+      .Attr<int32_t>("groups", 1)
+      .Build()
+      .op_conf();
+}
+
+OperatorConf Matmul(const std::string& op_name, const std::string& a, const std::string& b,
+                    bool transpose_b) {
+  return user_op::UserOpConfWrapperBuilder(op_name)
+      .Op("matmul")
+      .Input("a", a)
+      .Input("b", b)
+      .Output("out")
+      .Attr<bool>("transpose_a", false)
+      .Attr<bool>("transpose_b", transpose_b)
+      .Build()
+      .op_conf();
+}
+
+OperatorConf BiasAdd(const std::string& op_name, const std::string& a, const std::string& b) {
+  return user_op::UserOpConfWrapperBuilder(op_name)
+      .Op("bias_add")
+      .Input("a", a)
+      .Input("b", b)
+      .Output("out")
+      .Attr<int32_t>("axis", 1)
+      .Build()
+      .op_conf();
+}
+
+OperatorConf Relu(const std::string& op_name, const std::string& in) {
+  return user_op::UserOpConfWrapperBuilder(op_name)
+      .Op("relu")
+      .Input("in", in)
+      .Output("out")
+      .Build()
+      .op_conf();
+}
+
+// an inference batch norm over axis 1 of x reading the constants name-{moving_mean, ...}
+std::vector<OperatorConf> BatchNorm(const std::string& op_name, const std::string& x,
+                                    int64_t num_channels) {
+  std::vector<OperatorConf> op_confs;
+  for (const std::string& param : {"moving_mean", "moving_variance", "gamma", "beta"}) {
+    op_confs.push_back(Constant(op_name + "-" + param, Shape({num_channels})));
+  }
+  op_confs.push_back(user_op::UserOpConfWrapperBuilder(op_name)
+                         .Op("normalization")
+                         .Input("x", x)
+                         .Input("moving_mean", op_name + "-moving_mean/out_0")
+                         .Input("moving_variance", op_name + "-moving_variance/out_0")
+                         .Input("gamma", op_name + "-gamma/out_0")
+                         .Input("beta", op_name + "-beta/out_0")
+                         .Output("y")
+                         .Attr<int32_t>("axis", 1)
+                         .Attr<float>("epsilon", 1e-5)
+                         .Attr<bool>("training", false)
+                         .Attr<float>("momentum", 0.99)
+                         .Build()
+                         .op_conf());
+  return op_confs;
+}
+
+Job NewJob(const std::vector<OperatorConf>& op_confs) {
+  Job job;
+  JobBuilder job_builder(&job);
+  ParallelConf parallel_conf;
+  parallel_conf.set_device_tag("cpu");
+  parallel_conf.add_device_name("0:0");
+  job_builder.AddOps(parallel_conf, op_confs);
+  return job;
+}
+
+const OperatorConf* FindOpConf(const Job& job, const std::string& op_name) {
+  for (const OperatorConf& op_conf : job.net().op()) {
+    if (op_conf.name() == op_name) { return &op_conf; }
+  }
+  return nullptr;
+}
+
+std::string InputLbn(const Job& job, const std::string& op_name, const std::string& arg_name) {
+  const OperatorConf* op_conf = FindOpConf(job, op_name);
+  CHECK_NOTNULL(op_conf);
+  const auto& input = op_conf->user_conf().input();
+  if (input.find(arg_name) == input.end()) { return ""; }
+  return input.at(arg_name).s(0);
+}
+
+void ApplyPassAndCheckGraph(Job* job) {
+  GlobalJobDescScope scope(PredictJobConf(), 0);
+  ASSERT_TRUE(FunctionPass("FoldBatchNormPass")(job).IsOk());
+  OpGraph op_graph;
+  ASSERT_TRUE(op_graph.Init(*job).IsOk());
+}
+
+}  // namespace
+
+TEST(FoldBatchNormPass, conv) {
+  NewGlobals();
+  std::vector<OperatorConf> op_confs = {Constant("x", Shape({2, 3, 8, 8})),
+                                        Constant("weight", Shape({4, 3, 3, 3})),
+                                        Conv2d("conv", "x/out_0", "weight/out_0", 4)};
+  for (const OperatorConf& op_conf : BatchNorm("bn", "conv/out_0", 4)) {
+    op_confs.push_back(op_conf);
+  }
+  op_confs.push_back(Relu("relu", "bn/y_0"));
+  Job job = NewJob(op_confs);
+  ApplyPassAndCheckGraph(&job);
+  ASSERT_EQ(FindOpConf(job, "bn"), nullptr);
+  // the conv reads the folded weight and a bias_add adds the folded bias
+  ASSERT_EQ(InputLbn(job, "bn-fold_params", "weight"), "weight/out_0");
+  ASSERT_EQ(InputLbn(job, "bn-fold_params", "bias"), "");
+  ASSERT_EQ(InputLbn(job, "bn-fold_params", "moving_variance"), "bn-moving_variance/out_0");
+  ASSERT_EQ(InputLbn(job, "conv", "weight"), "bn-fold_params/folded_weight_0");
+  ASSERT_EQ(InputLbn(job, "bn-fold_bias_add", "a"), "conv/out_0");
+  ASSERT_EQ(InputLbn(job, "bn-fold_bias_add", "b"), "bn-fold_params/folded_bias_0");
+  ASSERT_EQ(InputLbn(job, "relu", "in"), "bn-fold_bias_add/out_0");
+  DeleteGlobals();
+}
+
+TEST(FoldBatchNormPass, conv_bias_add) {
+  NewGlobals();
+  std::vector<OperatorConf> op_confs = {
+      Constant("x", Shape({2, 3, 8, 8})), Constant("weight", Shape({4, 3, 3, 3})),
+      Constant("bias", Shape({4})), Conv2d("conv", "x/out_0", "weight/out_0", 4),
+      BiasAdd("bias_add", "conv/out_0", "bias/out_0")};
+  for (const OperatorConf& op_conf : BatchNorm("bn", "bias_add/out_0", 4)) {
+    op_confs.push_back(op_conf);
+  }
+  op_confs.push_back(Relu("relu", "bn/y_0"));
+  Job job = NewJob(op_confs);
+  ApplyPassAndCheckGraph(&job);
+  ASSERT_EQ(FindOpConf(job, "bn"), nullptr);
+  // the existing bias_add adds the folded bias, which takes the bias into account
+  ASSERT_EQ(InputLbn(job, "bn-fold_params", "bias"), "bias/out_0");
+  ASSERT_EQ(InputLbn(job, "conv", "weight"), "bn-fold_params/folded_weight_0");
+  ASSERT_EQ(InputLbn(job, "bias_add", "b"), "bn-fold_params/folded_bias_0");
+  ASSERT_EQ(FindOpConf(job, "bn-fold_bias_add"), nullptr);
+  ASSERT_EQ(InputLbn(job, "relu", "in"), "bias_add/out_0");
+  DeleteGlobals();
+}
+
+TEST(FoldBatchNormPass, matmul) {
+  NewGlobals();
+  std::vector<OperatorConf> op_confs = {Constant("x", Shape({4, 6})),
+                                        Constant("weight", Shape({5, 6})),
+                                        Matmul("matmul", "x/out_0", "weight/out_0", true)};
+  for (const OperatorConf& op_conf : BatchNorm("bn", "matmul/out_0", 5)) {
+    op_confs.push_back(op_conf);
+  }
+  op_confs.push_back(Relu("relu", "bn/y_0"));
+  Job job = NewJob(op_confs);
+  ApplyPassAndCheckGraph(&job);
+  ASSERT_EQ(FindOpConf(job, "bn"), nullptr);
+  // the output channels are the rows of the transposed b
+  const user_op::UserOpConfWrapper fold(*FindOpConf(job, "bn-fold_params"));
+  ASSERT_EQ(fold.attr<int32_t>("weight_channel_axis"), 0);
+  ASSERT_EQ(InputLbn(job, "matmul", "b"), "bn-fold_params/folded_weight_0");
+  ASSERT_EQ(InputLbn(job, "matmul", "a"), "x/out_0");
+  ASSERT_EQ(InputLbn(job, "relu", "in"), "bn-fold_bias_add/out_0");
+  DeleteGlobals();
+}
+
+TEST(FoldBatchNormPass, observed_activation) {
+  NewGlobals();
+  std::vector<OperatorConf> op_confs = {Constant("x", Shape({2, 3, 8, 8})),
+                                        Constant("weight", Shape({4, 3, 3, 3})),
+                                        Conv2d("conv", "x/out_0", "weight/out_0", 4)};
+  for (const OperatorConf& op_conf : BatchNorm("bn", "conv/out_0", 4)) {
+    op_confs.push_back(op_conf);
+  }
+  // the unnormalized conv output is read by another op, so it has to stay as it is
+  op_confs.push_back(Relu("relu", "conv/out_0"));
+  Job job = NewJob(op_confs);
+  const int64_t num_ops = job.net().op_size();
+  ApplyPassAndCheckGraph(&job);
+  ASSERT_EQ(job.net().op_size(), num_ops);
+  ASSERT_NE(FindOpConf(job, "bn"), nullptr);
+  ASSERT_EQ(InputLbn(job, "conv", "weight"), "weight/out_0");
+  DeleteGlobals();
+}
+
+}  // namespace test
+
+}  // namespace oneflow
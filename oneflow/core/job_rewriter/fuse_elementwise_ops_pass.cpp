@@ -0,0 +1,341 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/config_def.h"
+#include "oneflow/customized/utils/fused_elementwise_program.h"
+
+namespace oneflow {
+
+namespace {
+
+REGISTER_FUNCTION_CONFIG_DEF().Bool(
+    "enable_fuse_elementwise_ops", false,
+    "replace chains of elementwise and broadcast ops on cpu with one fused_elementwise op");
+
+const size_t kMaxNumFusedOps = 64;
+const std::string kFusedElementwiseOpNameSuffix = "-fused_elementwise";
+
+struct FusedGroup {
+  // topologically ordered, the root producing the output of the group is the last one
+  std::vector<const OpNode*> members;
+  HashSet<const OpNode*> member_set;
+};
+
+class FuseElementwiseOpsPass final : public OpGraphPass {
+ public:
+  FuseElementwiseOpsPass() = default;
+  ~FuseElementwiseOpsPass() override = default;
+  bool IsEnabled() const override { return GlobalJobDesc().Bool("enable_fuse_elementwise_ops"); }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+};
+
+const LogicalBlobId& OutLbi(const OpNode* op_node,
+                            const HashMap<const OpNode*, FusibleElementwiseOp>& node2fusible_op) {
+  return op_node->op().BnInOp2Lbi(node2fusible_op.at(op_node).obn);
+}
+
+// the axis of out an operand of a fused op starts at, which is numpy broadcasting aligning the
+// trailing axes except for the bias of bias_add
+int32_t InAxisOffset4Operand(const OpNode* op_node, const std::string& ibn) {
+  const OperatorConf& op_conf = op_node->op().op_conf();
+  if (op_conf.user_conf().op_type_name() == "bias_add" && ibn == "b_0") {
+    return user_op::UserOpConfWrapper(op_conf).attr<int32_t>("axis");
+  }
+  const Operator& op = op_node->op();
+  const Shape& out_shape = op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(op.SoleObn())).shape();
+  return out_shape.NumAxes() - op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(ibn)).shape().NumAxes();
+}
+
+bool IsBroadcastableTo(const Shape& operand_shape, int32_t in_axis_offset, const Shape& out_shape) {
+  if (in_axis_offset < 0 || in_axis_offset + operand_shape.NumAxes() > out_shape.NumAxes()) {
+    return false;
+  }
+  FOR_RANGE(int64_t, axis, 0, operand_shape.NumAxes()) {
+    const int64_t dim = operand_shape.At(axis);
+    if (dim != 1 && dim != out_shape.At(in_axis_offset + axis)) { return false; }
+  }
+  return true;
+}
+
+// whether the operands of a member have the sbp the fused op gets for them when its output has
+// out_sbp_parallel, under partial sum the program decides which operands may be partial
+bool IsOperandSbpFusible(const OpNode* op_node, const FusibleElementwiseOp& fusible_op,
+                         const SbpParallel& out_sbp_parallel) {
+  for (const std::string& ibn : fusible_op.ibns) {
+    const SbpParallel& in_sbp_parallel = op_node->SbpParallel4BnInOp(ibn);
+    if (out_sbp_parallel.has_split_parallel()) {
+      const Shape& in_shape = op_node->LogicalBlobDesc4Lbi(op_node->op().BnInOp2Lbi(ibn)).shape();
+      const int64_t in_axis =
+          out_sbp_parallel.split_parallel().axis() - InAxisOffset4Operand(op_node, ibn);
+      if (in_axis >= 0 && in_axis < in_shape.NumAxes() && in_shape.At(in_axis) != 1) {
+        if (!in_sbp_parallel.has_split_parallel()) { return false; }
+        if (in_sbp_parallel.split_parallel().axis() != in_axis) { return false; }
+      } else if (!in_sbp_parallel.has_broadcast_parallel()) {
+        return false;
+      }
+    } else if (out_sbp_parallel.has_broadcast_parallel()) {
+      if (!in_sbp_parallel.has_broadcast_parallel()) { return false; }
+    } else if (in_sbp_parallel.has_split_parallel()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// operands of the group members produced outside of the group, with the axis of out they start at
+void ForEachGroupInput(
+    const FusedGroup& group, const HashMap<const OpNode*, FusibleElementwiseOp>& node2fusible_op,
+    const std::function<void(const OpNode*, const std::string&, int32_t)>& Handler) {
+  for (const OpNode* member : group.members) {
+    for (const std::string& ibn : node2fusible_op.at(member).ibns) {
+      if (group.member_set.find(&member->SrcNode4Ibn(ibn)) != group.member_set.end()) { continue; }
+      Handler(member, ibn, InAxisOffset4Operand(member, ibn));
+    }
+  }
+}
+
+// the program evaluating the members of a group, its inputs are the operands from outside of the
+// group named by Lbn4Operand and told apart by the axis of out they start at and by whether the
+// member reads them as partial sum
+void BuildFusedProgram(const FusedGroup& group,
+                       const HashMap<const OpNode*, FusibleElementwiseOp>& node2fusible_op,
+                       const std::function<std::string(const std::string&)>& Lbn4Operand,
+                       FusedElementwiseProgram* program, std::vector<std::string>* in_lbns,
+                       std::vector<int32_t>* in_axis_offsets,
+                       std::vector<bool>* is_partial_sum_input) {
+  const auto In4Operand = [&](const OpNode* member, const std::string& ibn) {
+    return std::make_tuple(Lbn4Operand(GenLogicalBlobName(member->op().BnInOp2Lbi(ibn))),
+                           InAxisOffset4Operand(member, ibn),
+                           member->SbpParallel4BnInOp(ibn).has_partial_sum_parallel());
+  };
+  std::map<std::tuple<std::string, int32_t, bool>, int32_t> in2register;
+  ForEachGroupInput(group, node2fusible_op,
+                    [&](const OpNode* member, const std::string& ibn, int32_t in_axis_offset) {
+                      const auto in = In4Operand(member, ibn);
+                      if (in2register.find(in) != in2register.end()) { return; }
+                      in2register.emplace(in, in_lbns->size());
+                      in_lbns->push_back(std::get<0>(in));
+                      in_axis_offsets->push_back(std::get<1>(in));
+                      is_partial_sum_input->push_back(std::get<2>(in));
+                    });
+  program->num_inputs = in_lbns->size();
+  program->instructions.clear();
+  HashMap<const OpNode*, int32_t> member2register;
+  for (const OpNode* member : group.members) {
+    const FusibleElementwiseOp& fusible_op = node2fusible_op.at(member);
+    FusedElementwiseInstruction instruction = fusible_op.instruction;
+    for (const std::string& ibn : fusible_op.ibns) {
+      const OpNode* producer = &member->SrcNode4Ibn(ibn);
+      if (group.member_set.find(producer) != group.member_set.end()) {
+        instruction.operands.push_back(member2register.at(producer));
+      } else {
+        instruction.operands.push_back(in2register.at(In4Operand(member, ibn)));
+      }
+    }
+    member2register.emplace(member, program->num_inputs + program->instructions.size());
+    program->instructions.push_back(instruction);
+  }
+}
+
+Maybe<void> FuseElementwiseOpsPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  std::vector<const OpNode*> topo_nodes;
+  HashMap<const OpNode*, int64_t> node2topo_order;
+  HashMap<const OpNode*, FusibleElementwiseOp> node2fusible_op;
+  op_graph.TopoForEachNode([&](const OpNode* op_node) {
+    node2topo_order.emplace(op_node, topo_nodes.size());
+    topo_nodes.push_back(op_node);
+    const Operator& op = op_node->op();
+    FusibleElementwiseOp fusible_op;
+    if (!GetFusibleElementwiseOp(op.op_conf(), &fusible_op)) { return; }
+    if (op_node->parallel_desc().device_type() != DeviceType::kCPU) { return; }
+    if (!op.op_conf().ctrl_in_op_name().empty()) { return; }
+    if (ctrl_in_op_names.find(op.op_name()) != ctrl_in_op_names.end()) { return; }
+    const BlobDesc& out_desc = op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(fusible_op.obn));
+    if (out_desc.is_dynamic()) { return; }
+    if (out_desc.data_type() != DataType::kFloat && out_desc.data_type() != DataType::kDouble) {
+      return;
+    }
+    if (CHECK_JUST(op.OptMirroredParallel4BnInOp(fusible_op.obn))->has_mirrored_parallel()) {
+      return;
+    }
+    for (const std::string& ibn : fusible_op.ibns) {
+      const BlobDesc& in_desc = op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(ibn));
+      if (in_desc.is_dynamic() || in_desc.data_type() != out_desc.data_type()) { return; }
+    }
+    node2fusible_op.emplace(op_node, fusible_op);
+  });
+
+  // Groups grow from their root towards the inputs. An op joins when it has the shape, sbp and
+  // placement of the root and all its consumers are in the group already, so nothing outside
+  // reads an intermediate result and no cycle can be formed through the fused op. The chosen sbp
+  // signatures of the members have to be the one of the fused op, so that fusing adds no boxing.
+  HashSet<const OpNode*> grouped_nodes;
+  std::vector<FusedGroup> groups;
+  for (auto it = topo_nodes.rbegin(); it != topo_nodes.rend(); ++it) {
+    const OpNode* root = *it;
+    if (node2fusible_op.find(root) == node2fusible_op.end()) { continue; }
+    if (grouped_nodes.find(root) != grouped_nodes.end()) { continue; }
+    const LogicalBlobId& root_out_lbi = OutLbi(root, node2fusible_op);
+    const Shape& shape = root->LogicalBlobDesc4Lbi(root_out_lbi).shape();
+    const SbpParallel& sbp_parallel = root->SbpParallel4Lbi(root_out_lbi);
+    if (!IsOperandSbpFusible(root, node2fusible_op.at(root), sbp_parallel)) { continue; }
+    FusedGroup group;
+    group.members.push_back(root);
+    group.member_set.insert(root);
+    const auto CanJoin = [&](const OpNode* op_node) {
+      if (group.member_set.find(op_node) != group.member_set.end()) { return false; }
+      if (grouped_nodes.find(op_node) != grouped_nodes.end()) { return false; }
+      if (node2fusible_op.find(op_node) == node2fusible_op.end()) { return false; }
+      if (!(op_node->parallel_desc() == root->parallel_desc())) { return false; }
+      const LogicalBlobId& out_lbi = OutLbi(op_node, node2fusible_op);
+      if (!(op_node->LogicalBlobDesc4Lbi(out_lbi).shape() == shape)) { return false; }
+      if (!(op_node->SbpParallel4Lbi(out_lbi) == sbp_parallel)) { return false; }
+      if (!IsOperandSbpFusible(op_node, node2fusible_op.at(op_node), sbp_parallel)) {
+        return false;
+      }
+      for (const OpEdge* out_edge : op_node->out_edges()) {
+        const OpNode* consumer = out_edge->dst_node();
+        if (group.member_set.find(consumer) == group.member_set.end()) { return false; }
+        // the fused op passes the intermediate result on without boxing
+        for (const std::string& ibn : out_edge->lbi2ibns().at(out_lbi)) {
+          if (!(consumer->SbpParallel4BnInOp(ibn) == sbp_parallel)) { return false; }
+        }
+      }
+      return true;
+    };
+    bool is_grown = true;
+    while (is_grown && group.members.size() < kMaxNumFusedOps) {
+      is_grown = false;
+      for (size_t i = 0; i < group.members.size() && group.members.size() < kMaxNumFusedOps;
+           ++i) {
+        const OpNode* member = group.members.at(i);
+        for (const std::string& ibn : node2fusible_op.at(member).ibns) {
+          const OpNode* producer = &member->SrcNode4Ibn(ibn);
+          if (!CanJoin(producer)) { continue; }
+          group.members.push_back(producer);
+          group.member_set.insert(producer);
+          is_grown = true;
+          if (group.members.size() >= kMaxNumFusedOps) { break; }
+        }
+      }
+    }
+    if (group.members.size() < 2) { continue; }
+    std::sort(group.members.begin(), group.members.end(),
+              [&](const OpNode* lhs, const OpNode* rhs) {
+                return node2topo_order.at(lhs) < node2topo_order.at(rhs);
+              });
+    bool is_broadcastable = true;
+    ForEachGroupInput(group, node2fusible_op,
+                      [&](const OpNode* member, const std::string& ibn, int32_t in_axis_offset) {
+                        const Shape& operand_shape =
+                            member->LogicalBlobDesc4Lbi(member->op().BnInOp2Lbi(ibn)).shape();
+                        if (!IsBroadcastableTo(operand_shape, in_axis_offset, shape)) {
+                          is_broadcastable = false;
+                        }
+                      });
+    if (!is_broadcastable) { continue; }
+    if (sbp_parallel.has_partial_sum_parallel()) {
+      FusedElementwiseProgram program;
+      std::vector<std::string> in_lbns;
+      std::vector<int32_t> in_axis_offsets;
+      std::vector<bool> is_partial_sum_input;
+      BuildFusedProgram(
+          group, node2fusible_op, [](const std::string& lbn) { return lbn; }, &program, &in_lbns,
+          &in_axis_offsets, &is_partial_sum_input);
+      bool has_partial_sum_signature = false;
+      ForEachPartialSumInputs(program, [&](const std::vector<bool>& signature_partial_sum_input) {
+        if (signature_partial_sum_input == is_partial_sum_input) {
+          has_partial_sum_signature = true;
+        }
+      });
+      if (!has_partial_sum_signature) { continue; }
+    }
+    grouped_nodes.insert(group.members.begin(), group.members.end());
+    groups.push_back(std::move(group));
+  }
+
+  // the output of a group root is read from its fused op, including by other fused ops
+  HashMap<std::string, std::string> root_out_lbn2fused_out_lbn;
+  for (const FusedGroup& group : groups) {
+    const OpNode* root = group.members.back();
+    root_out_lbn2fused_out_lbn.emplace(
+        GenLogicalBlobName(OutLbi(root, node2fusible_op)),
+        GenLogicalBlobName(root->op().op_name() + kFusedElementwiseOpNameSuffix, "out_0"));
+  }
+  const auto Fused4Lbn = [&](const std::string& lbn) {
+    const auto it = root_out_lbn2fused_out_lbn.find(lbn);
+    return it == root_out_lbn2fused_out_lbn.end() ? lbn : it->second;
+  };
+
+  HashMap<std::string, OperatorConf> consumer_op_name2op_conf;
+  for (const FusedGroup& group : groups) {
+    const OpNode* root = group.members.back();
+    FusedElementwiseProgram program;
+    std::vector<std::string> in_lbns;
+    std::vector<int32_t> in_axis_offsets;
+    std::vector<bool> is_partial_sum_input;
+    BuildFusedProgram(group, node2fusible_op, Fused4Lbn, &program, &in_lbns, &in_axis_offsets,
+                      &is_partial_sum_input);
+    auto builder =
+        user_op::UserOpConfWrapperBuilder(root->op().op_name() + kFusedElementwiseOpNameSuffix);
+    builder.Op("fused_elementwise");
+    for (const std::string& in_lbn : in_lbns) { builder.Input("in", in_lbn); }
+    const auto fused_op = builder.Output("out")
+                              .Attr("program", SerializeFusedElementwiseProgram(program))
+                              .Attr("in_axis_offsets", in_axis_offsets)
+                              .Build();
+    job_builder->AddOps(root->parallel_desc().parallel_conf(), {fused_op.op_conf()});
+
+    const LogicalBlobId& root_out_lbi = OutLbi(root, node2fusible_op);
+    for (const OpEdge* out_edge : root->out_edges()) {
+      const OpNode* consumer = out_edge->dst_node();
+      if (grouped_nodes.find(consumer) != grouped_nodes.end()) { continue; }
+      const std::string& consumer_op_name = consumer->op().op_name();
+      if (consumer_op_name2op_conf.find(consumer_op_name) == consumer_op_name2op_conf.end()) {
+        consumer_op_name2op_conf[consumer_op_name] = consumer->op().op_conf();
+      }
+      OperatorConf& consumer_op_conf = consumer_op_name2op_conf.at(consumer_op_name);
+      PbMessage* conf =
+          MutableMessageInPbMessage(&consumer_op_conf, consumer_op_conf.op_type_case());
+      for (const std::string& ibn : out_edge->lbi2ibns().at(root_out_lbi)) {
+        ReplaceInputLbnInOpCustomizedConf(conf, ibn, GenLogicalBlobName(root_out_lbi),
+                                          fused_op.output("out", 0));
+      }
+    }
+  }
+  for (const auto& pair : consumer_op_name2op_conf) { job_builder->MutOpsOnlyOnce({pair.second}); }
+  std::vector<std::string> grouped_op_names;
+  for (const OpNode* op_node : grouped_nodes) {
+    grouped_op_names.push_back(op_node->op().op_name());
+  }
+  job_builder->DelOps(grouped_op_names);
+  LOG(INFO) << "FuseElementwiseOpsPass: fused " << grouped_nodes.size() << " ops into "
+            << groups.size() << " fused_elementwise ops";
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("FuseElementwiseOpsPass", FuseElementwiseOpsPass);
+
+}  // namespace oneflow
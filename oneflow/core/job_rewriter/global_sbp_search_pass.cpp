@@ -0,0 +1,256 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+#include "oneflow/core/job_rewriter/sbp_signature_search.h"
+#include "oneflow/core/framework/config_def.h"
+#include "oneflow/core/job/sbp_parallel.h"
+
+namespace oneflow {
+
+namespace {
+
+REGISTER_FUNCTION_CONFIG_DEF().Bool(
+    "enable_global_sbp_search", false,
+    "choose sbp signatures by minimizing estimated boxing, compute and memory cost over the "
+    "whole graph instead of op by op");
+
+// relative prices of a byte moved between devices, touched by a kernel and kept in memory
+constexpr double kCommCostPerByte = 1.0;
+constexpr double kComputeCostPerByte = 0.05;
+constexpr double kMemoryCostPerByte = 0.01;
+// boxing into partial sum from anything else is not supported by the sub task graph builders
+constexpr double kInfeasibleCost = 1e30;
+
+double LogicalBlobBytes(const BlobDesc& blob_desc) {
+  return static_cast<double>(blob_desc.shape().elem_cnt())
+         * GetSizeOfDataType(blob_desc.data_type());
+}
+
+// bytes moved between devices per iteration, modeled after the boxing the sub task graph
+// builders would choose: ring all-reduce/reduce-scatter/all-gather/all2all within a placement,
+// slice boxing between placements
+double BoxingBytes(const SbpParallel& src_sbp, const ParallelDesc& src_pd,
+                   const SbpParallel& dst_sbp, const ParallelDesc& dst_pd, double bytes,
+                   bool is_partial_sum_dst_free) {
+  if (dst_sbp.has_partial_sum_parallel() && !src_sbp.has_partial_sum_parallel()) {
+    return is_partial_sum_dst_free ? 0 : kInfeasibleCost;
+  }
+  const double src_num = src_pd.parallel_num();
+  const double dst_num = dst_pd.parallel_num();
+  if (src_pd.Equals(dst_pd)) {
+    if (src_num == 1 || src_sbp == dst_sbp) { return 0; }
+    if (src_sbp.has_partial_sum_parallel()) {
+      if (dst_sbp.has_broadcast_parallel()) { return 2 * (src_num - 1) * bytes; }
+      CHECK(dst_sbp.has_split_parallel());
+      return (src_num - 1) * bytes;
+    }
+    if (src_sbp.has_split_parallel()) {
+      if (dst_sbp.has_broadcast_parallel()) { return (src_num - 1) * bytes; }
+      CHECK(dst_sbp.has_split_parallel());
+      return (src_num - 1) / src_num * bytes;
+    }
+    // slicing a broadcast blob is local
+    return 0;
+  }
+  const double src_bytes = src_sbp.has_partial_sum_parallel() ? src_num * bytes : bytes;
+  const double dst_bytes = dst_sbp.has_broadcast_parallel() ? dst_num * bytes : bytes;
+  return std::max(src_bytes, dst_bytes);
+}
+
+double PerDeviceBytes(const SbpParallel& sbp, const ParallelDesc& pd, double bytes) {
+  return sbp.has_split_parallel() ? bytes / pd.parallel_num() : bytes;
+}
+
+bool IsSbpSignatureApplicable(const OpNode& op_node, const SbpSignature& sbp_signature) {
+  for (const auto& pair : sbp_signature.bn_in_op2sbp_parallel()) {
+    if (!pair.second.has_split_parallel()) { continue; }
+    const Shape& shape = op_node.LogicalBlobDesc4Lbi(op_node.op().BnInOp2Lbi(pair.first)).shape();
+    const int64_t axis = pair.second.split_parallel().axis();
+    if (axis >= shape.NumAxes() || shape.At(axis) < op_node.parallel_desc().parallel_num()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IsSbpSignatureFixed(const OpNode& op_node, const HashSet<std::string>& identical_op_names) {
+  if (op_node.parallel_desc().parallel_num() == 1) { return true; }
+  if (identical_op_names.find(op_node.op().op_name()) != identical_op_names.end()) { return true; }
+  for (const auto& obn : op_node.op().output_bns()) {
+    if (CHECK_JUST(op_node.op().OptMirroredParallel4BnInOp(obn))->has_mirrored_parallel()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Maybe<void> GetCandidateSbpSignatures(const OpNode& op_node, const SbpSignature& sbp_sig_conf,
+                                      std::vector<SbpSignature>* candidates) {
+  const SbpSignature& current = op_node.sbp_signature();
+  candidates->push_back(current);
+  SbpSignatureList sbp_sig_list;
+  JUST(op_node.op().GetSbpSignaturesIf(
+      [&](const std::string& ibn) -> Maybe<const BlobDesc*> {
+        return &op_node.LogicalBlobDesc4Lbi(op_node.op().BnInOp2Lbi(ibn));
+      },
+      op_node.parallel_desc(), &sbp_sig_list));
+  SbpSignatureList filtered_sbp_sig_list;
+  FilterSbpSignatureList(sbp_sig_list, sbp_sig_conf, &filtered_sbp_sig_list);
+  for (const SbpSignature& sbp_signature : filtered_sbp_sig_list.sbp_signature()) {
+    if (sbp_signature == current) { continue; }
+    if (!IsSbpSignatureApplicable(op_node, sbp_signature)) { continue; }
+    candidates->push_back(sbp_signature);
+  }
+  return Maybe<void>::Ok();
+}
+
+double NodeCost(const OpNode& op_node, const SbpSignature& sbp_signature) {
+  auto PerDeviceBytes4BnInOp = [&](const std::string& bn) -> double {
+    const BlobDesc& blob_desc = op_node.LogicalBlobDesc4Lbi(op_node.op().BnInOp2Lbi(bn));
+    return PerDeviceBytes(sbp_signature.bn_in_op2sbp_parallel().at(bn), op_node.parallel_desc(),
+                          LogicalBlobBytes(blob_desc));
+  };
+  double cost = 0;
+  for (const auto& ibn : op_node.op().input_bns()) {
+    cost += kComputeCostPerByte * PerDeviceBytes4BnInOp(ibn);
+  }
+  for (const auto& obn : op_node.op().output_bns()) {
+    cost += (kComputeCostPerByte + kMemoryCostPerByte) * PerDeviceBytes4BnInOp(obn);
+  }
+  return cost;
+}
+
+double EdgeBoxingBytes(const OpEdge& op_edge, const SbpSignature& src_sbp_signature,
+                       const SbpSignature& dst_sbp_signature, bool is_train) {
+  const OpNode& src = *op_edge.src_node();
+  const OpNode& dst = *op_edge.dst_node();
+  double boxing_bytes = 0;
+  for (const LogicalBlobId& lbi : op_edge.lbis()) {
+    const double bytes = LogicalBlobBytes(src.LogicalBlobDesc4Lbi(lbi));
+    const SbpParallel& src_sbp =
+        src_sbp_signature.bn_in_op2sbp_parallel().at(op_edge.lbi2obn().at(lbi));
+    for (const std::string& ibn : op_edge.lbi2ibns().at(lbi)) {
+      const SbpParallel& dst_sbp = dst_sbp_signature.bn_in_op2sbp_parallel().at(ibn);
+      boxing_bytes += BoxingBytes(src_sbp, src.parallel_desc(), dst_sbp, dst.parallel_desc(),
+                                  bytes, false);
+      if (is_train) {
+        // the diff flows back with dual sbp; a partial sum diff is accumulated locally
+        boxing_bytes += BoxingBytes(GetDualSbpParallel(dst_sbp), dst.parallel_desc(),
+                                    GetDualSbpParallel(src_sbp), src.parallel_desc(), bytes, true);
+      }
+    }
+  }
+  return boxing_bytes;
+}
+
+struct EdgeBoxing {
+  int64_t src;
+  int64_t dst;
+  // indexed like the edge costs of SbpSignatureSearchProblem::AddEdge
+  std::vector<double> bytes;
+};
+
+double TotalBoxingBytes(const std::vector<EdgeBoxing>& edge_boxings,
+                        const std::vector<std::vector<SbpSignature>>& id2candidates,
+                        const std::vector<int64_t>& node2choice) {
+  double total_bytes = 0;
+  for (const EdgeBoxing& edge_boxing : edge_boxings) {
+    const int64_t dst_num_candidates = id2candidates.at(edge_boxing.dst).size();
+    total_bytes += edge_boxing.bytes.at(node2choice.at(edge_boxing.src) * dst_num_candidates
+                                        + node2choice.at(edge_boxing.dst));
+  }
+  return total_bytes;
+}
+
+class GlobalSbpSearchPass final : public OpGraphPass {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(GlobalSbpSearchPass);
+  GlobalSbpSearchPass() = default;
+  ~GlobalSbpSearchPass() override = default;
+  bool IsEnabled() const override { return GlobalJobDesc().Bool("enable_global_sbp_search"); }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+};
+
+Maybe<void> GlobalSbpSearchPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+  const bool is_train = GlobalJobDesc().IsTrain();
+  const auto& op_name2sbp_sig_conf =
+      job_builder->job().job_parallel_view_conf().op_name2sbp_signature_conf();
+  HashSet<std::string> identical_op_names;
+  for (const auto& pair : job_builder->job().helper().identical_sbp_oba_pairs().pair()) {
+    identical_op_names.insert(pair.first().op_name());
+    identical_op_names.insert(pair.second().op_name());
+  }
+  SbpSignatureSearchProblem problem;
+  HashMap<const OpNode*, int64_t> op_node2id;
+  std::vector<const OpNode*> id2op_node;
+  std::vector<std::vector<SbpSignature>> id2candidates;
+  JUST(op_graph.TopoForEachNodeWithErrorCaptured([&](OpNode* op_node) -> Maybe<void> {
+    std::vector<SbpSignature> candidates;
+    if (IsSbpSignatureFixed(*op_node, identical_op_names)) {
+      candidates.push_back(op_node->sbp_signature());
+    } else {
+      SbpSignature sbp_sig_conf;
+      const auto& iter = op_name2sbp_sig_conf.find(op_node->op().op_name());
+      if (iter != op_name2sbp_sig_conf.end()) { sbp_sig_conf = iter->second; }
+      JUST(GetCandidateSbpSignatures(*op_node, sbp_sig_conf, &candidates));
+    }
+    std::vector<double> candidate_costs;
+    for (const SbpSignature& candidate : candidates) {
+      candidate_costs.push_back(NodeCost(*op_node, candidate));
+    }
+    op_node2id.emplace(op_node, problem.AddNode(candidate_costs));
+    id2op_node.push_back(op_node);
+    id2candidates.push_back(std::move(candidates));
+    return Maybe<void>::Ok();
+  }));
+  std::vector<EdgeBoxing> edge_boxings;
+  op_graph.ForEachEdge([&](OpEdge* op_edge) {
+    const int64_t src = op_node2id.at(op_edge->src_node());
+    const int64_t dst = op_node2id.at(op_edge->dst_node());
+    EdgeBoxing edge_boxing{src, dst, {}};
+    std::vector<double> costs;
+    for (const SbpSignature& src_candidate : id2candidates.at(src)) {
+      for (const SbpSignature& dst_candidate : id2candidates.at(dst)) {
+        const double bytes = EdgeBoxingBytes(*op_edge, src_candidate, dst_candidate, is_train);
+        edge_boxing.bytes.push_back(bytes);
+        costs.push_back(kCommCostPerByte * bytes);
+      }
+    }
+    problem.AddEdge(src, dst, costs);
+    edge_boxings.push_back(std::move(edge_boxing));
+  });
+  // candidate 0 is always the signature the op by op inference picked
+  const std::vector<int64_t> greedy_node2choice(problem.num_nodes(), 0);
+  const std::vector<int64_t> node2choice = problem.Solve(greedy_node2choice);
+  int64_t changed_cnt = 0;
+  FOR_RANGE(int64_t, id, 0, problem.num_nodes()) {
+    if (node2choice.at(id) == 0) { continue; }
+    job_builder->AddSbpSignature4OpName(id2op_node.at(id)->op().op_name(),
+                                        id2candidates.at(id).at(node2choice.at(id)));
+    changed_cnt += 1;
+  }
+  LOG(INFO) << "global sbp search changed " << changed_cnt << " sbp signatures, boxing bytes "
+            << TotalBoxingBytes(edge_boxings, id2candidates, greedy_node2choice) << " -> "
+            << TotalBoxingBytes(edge_boxings, id2candidates, node2choice) << ", estimated cost "
+            << problem.Cost(greedy_node2choice) << " -> " << problem.Cost(node2choice);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("GlobalSbpSearchPass", GlobalSbpSearchPass);
+
+}  // namespace oneflow
@@ -0,0 +1,111 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/inference_graph_rewriter.h"
+#include "oneflow/core/framework/config_def.h"
+
+namespace oneflow {
+
+namespace {
+
+REGISTER_FUNCTION_CONFIG_DEF().Bool(
+    "enable_inference_graph_optimization", false,
+    "fold batch normalization into convolution, fold constant subgraphs and cancel adjacent "
+    "transpose/reshape/cast ops in predict jobs");
+
+}  // namespace
+
+bool IsInferenceGraphOptimizationEnabled() {
+  return !GlobalJobDesc().IsTrain() && GlobalJobDesc().Bool("enable_inference_graph_optimization");
+}
+
+bool IsUserOpWithTypeName(const OperatorConf& op_conf, const std::string& op_type_name) {
+  return op_conf.has_user_conf() && op_conf.user_conf().op_type_name() == op_type_name;
+}
+
+InferenceGraphRewriter::InferenceGraphRewriter(const OpGraph& op_graph)
+    : op_graph_(op_graph), num_added_ops_(0), deleted_out_bytes_(0) {
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names_.insert(ctrl_in_op_name);
+    }
+  });
+}
+
+bool InferenceGraphRewriter::IsCtrlConnected(const OpNode* op_node) const {
+  const OperatorConf& op_conf = op_node->op().op_conf();
+  return !op_conf.ctrl_in_op_name().empty()
+         || ctrl_in_op_names_.find(op_conf.name()) != ctrl_in_op_names_.end();
+}
+
+OperatorConf* InferenceGraphRewriter::MutOpConf(const OpNode* op_node) {
+  const std::string& op_name = op_node->op().op_name();
+  auto it = op_name2mut_op_conf_.find(op_name);
+  if (it == op_name2mut_op_conf_.end()) {
+    it = op_name2mut_op_conf_.emplace(op_name, op_node->op().op_conf()).first;
+  }
+  return &it->second;
+}
+
+void InferenceGraphRewriter::ResetInputLbn(const OpNode* consumer, const std::string& ibn,
+                                           const std::string& new_lbn) {
+  OperatorConf* op_conf = MutOpConf(consumer);
+  PbMessage* conf = MutableMessageInPbMessage(op_conf, op_conf->op_type_case());
+  const std::string old_lbn = GetInputLbnInOpCustomizedConf(*conf, ibn);
+  ReplaceInputLbnInOpCustomizedConf(conf, ibn, old_lbn, new_lbn);
+}
+
+void InferenceGraphRewriter::RedirectConsumers(const OpNode* producer, const LogicalBlobId& lbi,
+                                               const std::string& new_lbn) {
+  for (const OpEdge* out_edge : producer->out_edges()) {
+    const auto it = out_edge->lbi2ibns().find(lbi);
+    if (it == out_edge->lbi2ibns().end()) { continue; }
+    for (const std::string& ibn : it->second) { ResetInputLbn(out_edge->dst_node(), ibn, new_lbn); }
+  }
+}
+
+void InferenceGraphRewriter::AddOps(const ParallelConf& parallel_conf,
+                                    const std::vector<OperatorConf>& op_confs) {
+  added_ops_.emplace_back(parallel_conf, op_confs);
+  num_added_ops_ += op_confs.size();
+}
+
+void InferenceGraphRewriter::DelOp(const OpNode* op_node) {
+  CHECK(!IsCtrlConnected(op_node));
+  if (!deleted_op_names_.insert(op_node->op().op_name()).second) { return; }
+  for (const std::string& obn : op_node->op().output_bns()) {
+    const BlobDesc& blob_desc = op_node->LogicalBlobDesc4Lbi(op_node->op().BnInOp2Lbi(obn));
+    deleted_out_bytes_ += blob_desc.shape().elem_cnt() * GetSizeOfDataType(blob_desc.data_type());
+  }
+}
+
+void InferenceGraphRewriter::Commit(const std::string& pass_name, JobBuilder* job_builder) const {
+  for (const auto& pair : added_ops_) { job_builder->AddOps(pair.first, pair.second); }
+  for (const auto& pair : op_name2mut_op_conf_) {
+    if (IsDeleted(pair.first)) { continue; }
+    job_builder->MutOpsOnlyOnce({pair.second});
+  }
+  if (!deleted_op_names_.empty()) {
+    job_builder->DelOps(
+        std::vector<std::string>(deleted_op_names_.begin(), deleted_op_names_.end()));
+  }
+  const int64_t num_ops = op_graph_.node_num();
+  const int64_t num_deleted_ops = deleted_op_names_.size();
+  LOG(INFO) << pass_name << ": removed " << num_deleted_ops << " ops and added " << num_added_ops_
+            << ", " << num_ops << " -> " << num_ops - num_deleted_ops + num_added_ops_
+            << " ops; removed ops wrote " << deleted_out_bytes_ << " bytes per iteration";
+}
+
+}  // namespace oneflow
@@ -0,0 +1,62 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_REWRITER_INFERENCE_GRAPH_REWRITER_H_
+#define ONEFLOW_CORE_JOB_REWRITER_INFERENCE_GRAPH_REWRITER_H_
+
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+
+namespace oneflow {
+
+bool IsInferenceGraphOptimizationEnabled();
+
+bool IsUserOpWithTypeName(const OperatorConf& op_conf, const std::string& op_type_name);
+
+// Collects the op conf edits of one inference graph optimization pass, so that an op is mutated
+// only once however many rewrites touch it, and reports what the pass took away from the graph
+class InferenceGraphRewriter final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(InferenceGraphRewriter);
+  explicit InferenceGraphRewriter(const OpGraph& op_graph);
+  ~InferenceGraphRewriter() = default;
+
+  // ops ordered by control edges are left as they are
+  bool IsCtrlConnected(const OpNode* op_node) const;
+  bool IsDeleted(const std::string& op_name) const {
+    return deleted_op_names_.find(op_name) != deleted_op_names_.end();
+  }
+
+  OperatorConf* MutOpConf(const OpNode* op_node);
+  void ResetInputLbn(const OpNode* consumer, const std::string& ibn, const std::string& new_lbn);
+  void RedirectConsumers(const OpNode* producer, const LogicalBlobId& lbi,
+                         const std::string& new_lbn);
+  void AddOps(const ParallelConf& parallel_conf, const std::vector<OperatorConf>& op_confs);
+  void DelOp(const OpNode* op_node);
+
+  void Commit(const std::string& pass_name, JobBuilder* job_builder) const;
+
+ private:
+  const OpGraph& op_graph_;
+  HashSet<std::string> ctrl_in_op_names_;
+  HashMap<std::string, OperatorConf> op_name2mut_op_conf_;
+  std::vector<std::pair<ParallelConf, std::vector<OperatorConf>>> added_ops_;
+  HashSet<std::string> deleted_op_names_;
+  int64_t num_added_ops_;
+  int64_t deleted_out_bytes_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_REWRITER_INFERENCE_GRAPH_REWRITER_H_
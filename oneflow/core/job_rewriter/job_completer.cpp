@@ -19,6 +19,8 @@ limitations under the License.
 #include "oneflow/core/job_rewriter/autotick.h"
 #include "oneflow/core/job_rewriter/add_keep_header_only_op_conf.h"
 #include "oneflow/core/job/job_desc.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
 #include "oneflow/core/job_rewriter/group_boxing_by_dst_parallel.h"
 #include "oneflow/core/framework/config_def.h"
 #include "oneflow/core/job_rewriter/xrt_compilation.h"
@@ -43,11 +45,14 @@ void WithOpGraphAndMutJob(Job* job, const std::function<void(const OpGraph&, Job
   Handler(op_graph, job);
 }
 
-void WithOpGraphAndMutJobBuilder(Job* job,
+void WithOpGraphAndMutJobBuilder(Job* job, OpGraph* op_graph,
                                  const std::function<void(const OpGraph&, JobBuilder*)>& Handler) {
-  OpGraph op_graph(*job);
   JobBuilder job_builder(job);
-  Handler(op_graph, &job_builder);
+  Handler(*op_graph, &job_builder);
+  CHECK_JUST(op_graph->Update(job_builder));
+  if (Global<ResourceDesc, ForSession>::Get()->enable_debug_mode()) {
+    CHECK_JUST(op_graph->CheckSameAs(OpGraph(*job)));
+  }
 }
 
 void SetCtrlInOpName4VariableOp(const OpGraph& op_graph, JobBuilder* job_builder) {
@@ -92,28 +97,35 @@ void SetCtrlInOpName4VariableOp(const OpGraph& op_graph, JobBuilder* job_builder
 
 void JobCompleter::Complete(Job* job) const {
   FunctionPass("DumpTimeShapeAndBlobParallelConfPass")(job);
-  WithOpGraphAndMutJobBuilder(job, &GroupBoxingByDstParallel);
+  // One graph is kept up to date through the passes below, only inferring again what they touch.
+  // They all edit the job through a JobBuilder only, which is what Update relies on; the function
+  // passes run by JobBuildAndInferCtx::Complete still build their own graph, since several of them
+  // write the Job directly.
+  OpGraph op_graph(*job);
+  WithOpGraphAndMutJobBuilder(job, &op_graph, &GroupBoxingByDstParallel);
   if (GlobalJobDesc().enable_keep_header_only()) {
-    WithOpGraphAndMutJobBuilder(job, &AddKeepHeaderOnlyOp);
+    WithOpGraphAndMutJobBuilder(job, &op_graph, &AddKeepHeaderOnlyOp);
   }
-  WithOpGraphAndMutJobBuilder(job, &SetCtrlInOpName4VariableOp);
+  WithOpGraphAndMutJobBuilder(job, &op_graph, &SetCtrlInOpName4VariableOp);
   // complete tick ops
-  WithOpGraphAndMutJobBuilder(job, &AutoSourceTick);
-  WithOpGraphAndMutJobBuilder(job, &AddTickForTimeShape);
-  WithOpGraphAndMutJobBuilder(job, &AutoSinkTick);
+  WithOpGraphAndMutJobBuilder(job, &op_graph, &AutoSourceTick);
+  WithOpGraphAndMutJobBuilder(job, &op_graph, &AddTickForTimeShape);
+  WithOpGraphAndMutJobBuilder(job, &op_graph, &AutoSinkTick);
   AddGlobalTotalJobCriticalSection(*job);
-  WithOpGraphAndMutJobBuilder(job, &AddGlobalInputCriticalSections);
-  WithOpGraphAndMutJobBuilder(job, &AddGlobalOutputCriticalSections);
-  FunctionPass("DumpTimeShapeAndBlobParallelConfPass")(job);
+  WithOpGraphAndMutJobBuilder(job, &op_graph, &AddGlobalInputCriticalSections);
+  WithOpGraphAndMutJobBuilder(job, &op_graph, &AddGlobalOutputCriticalSections);
+  CHECK_JUST(FunctionPass("DumpTimeShapeAndBlobParallelConfPass").Apply(op_graph, job));
   if (XrtCompilationEnabled(GlobalJobDesc())) {
 #ifdef OF_WITH_XRT
     WithOpGraphAndMutJob(job, &RebuildXrtCompiledJob);
+    CheckOpGraph(OpGraph(*job));
+    return;
 #else
-    LOG(WARNING) << "It will not use XLA or TensorRT since WITH_XLA or "
-                    "WITH_TENSORRT was not enabled when compiling the project.";
+    LOG(WARNING) << "It will not use XLA, TensorRT or the native engine since WITH_XLA, "
+                    "WITH_TENSORRT or WITH_XRT_NATIVE was not enabled when compiling the project.";
 #endif  // OF_WITH_XRT
   }
-  CheckOpGraph(OpGraph(*job));
+  CheckOpGraph(op_graph);
 }
 
 }  // namespace oneflow
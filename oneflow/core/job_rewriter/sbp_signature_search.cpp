@@ -0,0 +1,301 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/sbp_signature_search.h"
+#include <numeric>
+
+namespace oneflow {
+
+namespace {
+
+// an eliminated degree-two node whose folded edge would exceed this stays in the core
+constexpr int64_t kMaxFoldedEdgeSize = 1 << 16;
+constexpr int32_t kMaxLocalSearchSweeps = 64;
+
+struct Elimination {
+  int64_t node;
+  int64_t lhs;
+  int64_t rhs;  // -1 if the node was a leaf folded into lhs alone
+  // best choice of node, indexed by lhs_choice * num_candidates(rhs) + rhs_choice
+  std::vector<int64_t> argmin;
+};
+
+class SearchGraph final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(SearchGraph);
+  explicit SearchGraph(const std::vector<std::vector<double>>& node2candidate_costs)
+      : node2candidate_costs_(node2candidate_costs),
+        node2neighbor2edge_id_(node2candidate_costs.size()),
+        is_eliminated_(node2candidate_costs.size(), false) {}
+  ~SearchGraph() = default;
+
+  void AddEdge(int64_t src, int64_t dst, const std::vector<double>& costs);
+  void EliminateAll(std::vector<Elimination>* eliminations);
+  double CoreCost(const std::vector<int64_t>& node2choice) const;
+  void LocalSearch(std::vector<int64_t>* node2choice) const;
+  std::vector<int64_t> GreedyChoice() const;
+  int64_t num_candidates(int64_t node) const { return node2candidate_costs_.at(node).size(); }
+
+ private:
+  struct Edge {
+    int64_t src;
+    int64_t dst;
+    std::vector<double> costs;
+  };
+
+  double EdgeCost(int64_t edge_id, int64_t node, int64_t node_choice,
+                  int64_t neighbor_choice) const;
+  double LocalCost(int64_t node, int64_t choice, const std::vector<int64_t>& node2choice) const;
+  void RemoveEdge(int64_t edge_id);
+  void EliminateLeaf(int64_t node, std::vector<Elimination>* eliminations);
+  bool TryEliminateSeries(int64_t node, std::vector<Elimination>* eliminations);
+
+  std::vector<std::vector<double>> node2candidate_costs_;
+  std::vector<HashMap<int64_t, int64_t>> node2neighbor2edge_id_;
+  std::vector<bool> is_eliminated_;
+  std::vector<Edge> edges_;
+};
+
+void SearchGraph::AddEdge(int64_t src, int64_t dst, const std::vector<double>& costs) {
+  CHECK_NE(src, dst);
+  const int64_t num_dst_candidates = num_candidates(dst);
+  CHECK_EQ(costs.size(), num_candidates(src) * num_dst_candidates);
+  const auto& iter = node2neighbor2edge_id_.at(src).find(dst);
+  if (iter == node2neighbor2edge_id_.at(src).end()) {
+    node2neighbor2edge_id_.at(src).emplace(dst, edges_.size());
+    node2neighbor2edge_id_.at(dst).emplace(src, edges_.size());
+    edges_.push_back(Edge{src, dst, costs});
+    return;
+  }
+  // parallel edges are merged into one
+  Edge* edge = &edges_.at(iter->second);
+  FOR_RANGE(int64_t, i, 0, num_candidates(src)) {
+    FOR_RANGE(int64_t, j, 0, num_dst_candidates) {
+      const double cost = costs.at(i * num_dst_candidates + j);
+      if (edge->src == src) {
+        edge->costs.at(i * num_dst_candidates + j) += cost;
+      } else {
+        edge->costs.at(j * num_candidates(src) + i) += cost;
+      }
+    }
+  }
+}
+
+double SearchGraph::EdgeCost(int64_t edge_id, int64_t node, int64_t node_choice,
+                             int64_t neighbor_choice) const {
+  const Edge& edge = edges_.at(edge_id);
+  if (edge.src == node) {
+    return edge.costs.at(node_choice * num_candidates(edge.dst) + neighbor_choice);
+  } else {
+    return edge.costs.at(neighbor_choice * num_candidates(node) + node_choice);
+  }
+}
+
+double SearchGraph::LocalCost(int64_t node, int64_t choice,
+                              const std::vector<int64_t>& node2choice) const {
+  double cost = node2candidate_costs_.at(node).at(choice);
+  for (const auto& pair : node2neighbor2edge_id_.at(node)) {
+    cost += EdgeCost(pair.second, node, choice, node2choice.at(pair.first));
+  }
+  return cost;
+}
+
+void SearchGraph::RemoveEdge(int64_t edge_id) {
+  const Edge& edge = edges_.at(edge_id);
+  CHECK_EQ(node2neighbor2edge_id_.at(edge.src).erase(edge.dst), 1);
+  CHECK_EQ(node2neighbor2edge_id_.at(edge.dst).erase(edge.src), 1);
+}
+
+void SearchGraph::EliminateLeaf(int64_t node, std::vector<Elimination>* eliminations) {
+  const int64_t neighbor = node2neighbor2edge_id_.at(node).begin()->first;
+  const int64_t edge_id = node2neighbor2edge_id_.at(node).begin()->second;
+  Elimination elimination{node, neighbor, -1, std::vector<int64_t>(num_candidates(neighbor))};
+  FOR_RANGE(int64_t, neighbor_choice, 0, num_candidates(neighbor)) {
+    double min_cost = std::numeric_limits<double>::infinity();
+    int64_t argmin = 0;
+    FOR_RANGE(int64_t, choice, 0, num_candidates(node)) {
+      const double cost = node2candidate_costs_.at(node).at(choice)
+                          + EdgeCost(edge_id, node, choice, neighbor_choice);
+      if (cost < min_cost) {
+        min_cost = cost;
+        argmin = choice;
+      }
+    }
+    node2candidate_costs_.at(neighbor).at(neighbor_choice) += min_cost;
+    elimination.argmin.at(neighbor_choice) = argmin;
+  }
+  RemoveEdge(edge_id);
+  is_eliminated_.at(node) = true;
+  eliminations->push_back(std::move(elimination));
+}
+
+bool SearchGraph::TryEliminateSeries(int64_t node, std::vector<Elimination>* eliminations) {
+  auto iter = node2neighbor2edge_id_.at(node).begin();
+  const int64_t lhs = iter->first;
+  const int64_t lhs_edge_id = iter->second;
+  ++iter;
+  const int64_t rhs = iter->first;
+  const int64_t rhs_edge_id = iter->second;
+  const int64_t num_lhs_candidates = num_candidates(lhs);
+  const int64_t num_rhs_candidates = num_candidates(rhs);
+  if (num_lhs_candidates * num_rhs_candidates > kMaxFoldedEdgeSize) { return false; }
+  std::vector<double> folded_costs(num_lhs_candidates * num_rhs_candidates);
+  Elimination elimination{node, lhs, rhs, std::vector<int64_t>(folded_costs.size())};
+  FOR_RANGE(int64_t, lhs_choice, 0, num_lhs_candidates) {
+    FOR_RANGE(int64_t, rhs_choice, 0, num_rhs_candidates) {
+      double min_cost = std::numeric_limits<double>::infinity();
+      int64_t argmin = 0;
+      FOR_RANGE(int64_t, choice, 0, num_candidates(node)) {
+        const double cost = node2candidate_costs_.at(node).at(choice)
+                            + EdgeCost(lhs_edge_id, node, choice, lhs_choice)
+                            + EdgeCost(rhs_edge_id, node, choice, rhs_choice);
+        if (cost < min_cost) {
+          min_cost = cost;
+          argmin = choice;
+        }
+      }
+      folded_costs.at(lhs_choice * num_rhs_candidates + rhs_choice) = min_cost;
+      elimination.argmin.at(lhs_choice * num_rhs_candidates + rhs_choice) = argmin;
+    }
+  }
+  RemoveEdge(lhs_edge_id);
+  RemoveEdge(rhs_edge_id);
+  is_eliminated_.at(node) = true;
+  eliminations->push_back(std::move(elimination));
+  AddEdge(lhs, rhs, folded_costs);
+  return true;
+}
+
+void SearchGraph::EliminateAll(std::vector<Elimination>* eliminations) {
+  std::vector<int64_t> pending_nodes(node2candidate_costs_.size());
+  std::iota(pending_nodes.begin(), pending_nodes.end(), 0);
+  std::reverse(pending_nodes.begin(), pending_nodes.end());
+  while (!pending_nodes.empty()) {
+    const int64_t node = pending_nodes.back();
+    pending_nodes.pop_back();
+    if (is_eliminated_.at(node)) { continue; }
+    std::vector<int64_t> neighbors;
+    for (const auto& pair : node2neighbor2edge_id_.at(node)) { neighbors.push_back(pair.first); }
+    if (neighbors.size() == 1) {
+      EliminateLeaf(node, eliminations);
+    } else if (neighbors.size() == 2) {
+      if (!TryEliminateSeries(node, eliminations)) { continue; }
+    } else {
+      continue;
+    }
+    // degrees of the neighbours may have dropped
+    for (int64_t neighbor : neighbors) { pending_nodes.push_back(neighbor); }
+  }
+}
+
+double SearchGraph::CoreCost(const std::vector<int64_t>& node2choice) const {
+  double cost = 0;
+  FOR_RANGE(int64_t, node, 0, node2candidate_costs_.size()) {
+    if (is_eliminated_.at(node)) { continue; }
+    cost += node2candidate_costs_.at(node).at(node2choice.at(node));
+    for (const auto& pair : node2neighbor2edge_id_.at(node)) {
+      // count each edge once
+      if (pair.first < node) { continue; }
+      cost += EdgeCost(pair.second, node, node2choice.at(node), node2choice.at(pair.first));
+    }
+  }
+  return cost;
+}
+
+void SearchGraph::LocalSearch(std::vector<int64_t>* node2choice) const {
+  FOR_RANGE(int32_t, sweep, 0, kMaxLocalSearchSweeps) {
+    bool is_changed = false;
+    FOR_RANGE(int64_t, node, 0, node2candidate_costs_.size()) {
+      if (is_eliminated_.at(node)) { continue; }
+      int64_t* choice = &node2choice->at(node);
+      double min_cost = LocalCost(node, *choice, *node2choice);
+      FOR_RANGE(int64_t, candidate, 0, num_candidates(node)) {
+        const double cost = LocalCost(node, candidate, *node2choice);
+        if (cost < min_cost) {
+          min_cost = cost;
+          *choice = candidate;
+          is_changed = true;
+        }
+      }
+    }
+    if (!is_changed) { break; }
+  }
+}
+
+std::vector<int64_t> SearchGraph::GreedyChoice() const {
+  std::vector<int64_t> node2choice(node2candidate_costs_.size());
+  FOR_RANGE(int64_t, node, 0, node2candidate_costs_.size()) {
+    const auto& costs = node2candidate_costs_.at(node);
+    node2choice.at(node) = std::min_element(costs.begin(), costs.end()) - costs.begin();
+  }
+  return node2choice;
+}
+
+}  // namespace
+
+int64_t SbpSignatureSearchProblem::AddNode(const std::vector<double>& candidate_costs) {
+  CHECK_GT(candidate_costs.size(), 0);
+  node2candidate_costs_.push_back(candidate_costs);
+  return node2candidate_costs_.size() - 1;
+}
+
+void SbpSignatureSearchProblem::AddEdge(int64_t src, int64_t dst,
+                                        const std::vector<double>& costs) {
+  CHECK_NE(src, dst);
+  CHECK_EQ(costs.size(), num_candidates(src) * num_candidates(dst));
+  edges_.push_back(Edge{src, dst, costs});
+}
+
+double SbpSignatureSearchProblem::Cost(const std::vector<int64_t>& node2choice) const {
+  CHECK_EQ(node2choice.size(), num_nodes());
+  double cost = 0;
+  FOR_RANGE(int64_t, node, 0, num_nodes()) {
+    cost += node2candidate_costs_.at(node).at(node2choice.at(node));
+  }
+  for (const Edge& edge : edges_) {
+    cost += edge.costs.at(node2choice.at(edge.src) * num_candidates(edge.dst)
+                          + node2choice.at(edge.dst));
+  }
+  return cost;
+}
+
+std::vector<int64_t> SbpSignatureSearchProblem::Solve(
+    const std::vector<int64_t>& initial_node2choice) const {
+  CHECK_EQ(initial_node2choice.size(), num_nodes());
+  SearchGraph graph(node2candidate_costs_);
+  for (const Edge& edge : edges_) { graph.AddEdge(edge.src, edge.dst, edge.costs); }
+  std::vector<Elimination> eliminations;
+  graph.EliminateAll(&eliminations);
+  std::vector<int64_t> node2choice = initial_node2choice;
+  graph.LocalSearch(&node2choice);
+  {
+    std::vector<int64_t> greedy_node2choice = graph.GreedyChoice();
+    graph.LocalSearch(&greedy_node2choice);
+    if (graph.CoreCost(greedy_node2choice) < graph.CoreCost(node2choice)) {
+      node2choice.swap(greedy_node2choice);
+    }
+  }
+  for (auto iter = eliminations.rbegin(); iter != eliminations.rend(); ++iter) {
+    int64_t index = node2choice.at(iter->lhs);
+    if (iter->rhs != -1) {
+      index = index * graph.num_candidates(iter->rhs) + node2choice.at(iter->rhs);
+    }
+    node2choice.at(iter->node) = iter->argmin.at(index);
+  }
+  if (Cost(node2choice) < Cost(initial_node2choice)) { return node2choice; }
+  return initial_node2choice;
+}
+
+}  // namespace oneflow
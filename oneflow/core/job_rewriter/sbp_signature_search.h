@@ -0,0 +1,55 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_REWRITER_SBP_SIGNATURE_SEARCH_H_
+#define ONEFLOW_CORE_JOB_REWRITER_SBP_SIGNATURE_SEARCH_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// Picks one candidate per node so that the sum of node costs and edge costs is minimal.
+// Nodes of degree one and two are eliminated exactly, which solves chains, trees and
+// series-parallel graphs optimally; whatever core remains is refined by local search.
+class SbpSignatureSearchProblem final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(SbpSignatureSearchProblem);
+  SbpSignatureSearchProblem() = default;
+  ~SbpSignatureSearchProblem() = default;
+
+  int64_t AddNode(const std::vector<double>& candidate_costs);
+  // costs[i * num_candidates(dst) + j] is the cost of src choosing i and dst choosing j
+  void AddEdge(int64_t src, int64_t dst, const std::vector<double>& costs);
+
+  int64_t num_nodes() const { return node2candidate_costs_.size(); }
+  int64_t num_candidates(int64_t node) const { return node2candidate_costs_.at(node).size(); }
+  double Cost(const std::vector<int64_t>& node2choice) const;
+  // never returns a choice more costly than initial_node2choice
+  std::vector<int64_t> Solve(const std::vector<int64_t>& initial_node2choice) const;
+
+ private:
+  struct Edge {
+    int64_t src;
+    int64_t dst;
+    std::vector<double> costs;
+  };
+
+  std::vector<std::vector<double>> node2candidate_costs_;
+  std::vector<Edge> edges_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_REWRITER_SBP_SIGNATURE_SEARCH_H_
@@ -0,0 +1,122 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/sbp_signature_search.h"
+
+namespace oneflow {
+
+namespace {
+
+std::vector<double> RandomCosts(int64_t size, std::mt19937* gen) {
+  std::uniform_int_distribution<int32_t> dis(0, 100);
+  std::vector<double> costs(size);
+  for (double& cost : costs) { cost = dis(*gen); }
+  return costs;
+}
+
+void AddRandomNodes(int64_t num_nodes, SbpSignatureSearchProblem* problem, std::mt19937* gen) {
+  std::uniform_int_distribution<int64_t> dis(1, 4);
+  FOR_RANGE(int64_t, i, 0, num_nodes) { problem->AddNode(RandomCosts(dis(*gen), gen)); }
+}
+
+void AddRandomEdge(int64_t src, int64_t dst, SbpSignatureSearchProblem* problem,
+                   std::mt19937* gen) {
+  problem->AddEdge(src, dst,
+                   RandomCosts(problem->num_candidates(src) * problem->num_candidates(dst), gen));
+}
+
+double BruteForceMinCost(const SbpSignatureSearchProblem& problem) {
+  std::vector<int64_t> node2choice(problem.num_nodes(), 0);
+  double min_cost = problem.Cost(node2choice);
+  while (true) {
+    int64_t node = 0;
+    while (node < problem.num_nodes()
+           && ++node2choice.at(node) == problem.num_candidates(node)) {
+      node2choice.at(node++) = 0;
+    }
+    if (node == problem.num_nodes()) { break; }
+    min_cost = std::min(min_cost, problem.Cost(node2choice));
+  }
+  return min_cost;
+}
+
+}  // namespace
+
+TEST(SbpSignatureSearchProblem, chain_is_optimal) {
+  std::mt19937 gen(0);
+  FOR_RANGE(int32_t, trial, 0, 16) {
+    SbpSignatureSearchProblem problem;
+    AddRandomNodes(8, &problem, &gen);
+    FOR_RANGE(int64_t, i, 1, problem.num_nodes()) { AddRandomEdge(i - 1, i, &problem, &gen); }
+    const auto& node2choice = problem.Solve(std::vector<int64_t>(problem.num_nodes(), 0));
+    ASSERT_DOUBLE_EQ(problem.Cost(node2choice), BruteForceMinCost(problem));
+  }
+}
+
+TEST(SbpSignatureSearchProblem, tree_with_parallel_edges_is_optimal) {
+  std::mt19937 gen(1);
+  FOR_RANGE(int32_t, trial, 0, 16) {
+    SbpSignatureSearchProblem problem;
+    AddRandomNodes(9, &problem, &gen);
+    FOR_RANGE(int64_t, i, 1, problem.num_nodes()) {
+      const int64_t parent = std::uniform_int_distribution<int64_t>(0, i - 1)(gen);
+      AddRandomEdge(parent, i, &problem, &gen);
+      if (i % 3 == 0) { AddRandomEdge(i, parent, &problem, &gen); }
+    }
+    const auto& node2choice = problem.Solve(std::vector<int64_t>(problem.num_nodes(), 0));
+    ASSERT_DOUBLE_EQ(problem.Cost(node2choice), BruteForceMinCost(problem));
+  }
+}
+
+TEST(SbpSignatureSearchProblem, diamond_is_optimal) {
+  std::mt19937 gen(2);
+  FOR_RANGE(int32_t, trial, 0, 16) {
+    SbpSignatureSearchProblem problem;
+    AddRandomNodes(8, &problem, &gen);
+    // residual blocks: 0 -> {1, 2} -> 3 -> {4, 5} -> 6 -> 7
+    AddRandomEdge(0, 1, &problem, &gen);
+    AddRandomEdge(0, 2, &problem, &gen);
+    AddRandomEdge(1, 3, &problem, &gen);
+    AddRandomEdge(2, 3, &problem, &gen);
+    AddRandomEdge(3, 4, &problem, &gen);
+    AddRandomEdge(3, 5, &problem, &gen);
+    AddRandomEdge(4, 6, &problem, &gen);
+    AddRandomEdge(5, 6, &problem, &gen);
+    AddRandomEdge(3, 6, &problem, &gen);
+    AddRandomEdge(6, 7, &problem, &gen);
+    const auto& node2choice = problem.Solve(std::vector<int64_t>(problem.num_nodes(), 0));
+    ASSERT_DOUBLE_EQ(problem.Cost(node2choice), BruteForceMinCost(problem));
+  }
+}
+
+TEST(SbpSignatureSearchProblem, dense_graph_is_not_worse_than_initial_choice) {
+  std::mt19937 gen(3);
+  FOR_RANGE(int32_t, trial, 0, 16) {
+    SbpSignatureSearchProblem problem;
+    AddRandomNodes(8, &problem, &gen);
+    FOR_RANGE(int64_t, i, 0, problem.num_nodes()) {
+      FOR_RANGE(int64_t, j, i + 1, problem.num_nodes()) { AddRandomEdge(i, j, &problem, &gen); }
+    }
+    std::vector<int64_t> initial_node2choice(problem.num_nodes());
+    FOR_RANGE(int64_t, i, 0, problem.num_nodes()) {
+      initial_node2choice.at(i) = problem.num_candidates(i) - 1;
+    }
+    const auto& node2choice = problem.Solve(initial_node2choice);
+    ASSERT_LE(problem.Cost(node2choice), problem.Cost(initial_node2choice));
+    ASSERT_GE(problem.Cost(node2choice), BruteForceMinCost(problem));
+  }
+}
+
+}  // namespace oneflow
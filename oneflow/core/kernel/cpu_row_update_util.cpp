@@ -0,0 +1,158 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/cpu_row_update_util.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OF_ROW_UPDATE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace oneflow {
+
+namespace {
+
+// elements each thread should get before splitting a row update is worth it
+constexpr int64_t kMinElemCntPerRowRange = 1 << 14;
+
+bool CpuSupportsAvx2() {
+  static const bool supported = []() {
+#ifdef OF_ROW_UPDATE_X86_SIMD
+    __builtin_cpu_init();
+    return static_cast<bool>(__builtin_cpu_supports("avx2"));
+#else
+    return false;
+#endif
+  }();
+  return supported;
+}
+
+template<typename T>
+void LazyAdamUpdateRowScalar(int64_t n, T beta1, T beta2, T epsilon, T lr, const T* diff,
+                             T* model, T* m, T* v) {
+  for (int64_t i = 0; i < n; ++i) {
+    const T new_m = beta1 * m[i] + (1 - beta1) * diff[i];
+    const T new_v = beta2 * v[i] + (1 - beta2) * diff[i] * diff[i];
+    m[i] = new_m;
+    v[i] = new_v;
+    model[i] = model[i] - lr * new_m / (std::sqrt(new_v) + epsilon);
+  }
+}
+
+#ifdef OF_ROW_UPDATE_X86_SIMD
+
+// same operation order as the scalar loop and no fma, so the results are bitwise identical
+__attribute__((target("avx2"))) void LazyAdamUpdateRowAvx2(int64_t n, float beta1, float beta2,
+                                                           float epsilon, float lr,
+                                                           const float* diff, float* model,
+                                                           float* m, float* v) {
+  const __m256 beta1_v = _mm256_set1_ps(beta1);
+  const __m256 one_minus_beta1_v = _mm256_set1_ps(1 - beta1);
+  const __m256 beta2_v = _mm256_set1_ps(beta2);
+  const __m256 one_minus_beta2_v = _mm256_set1_ps(1 - beta2);
+  const __m256 epsilon_v = _mm256_set1_ps(epsilon);
+  const __m256 lr_v = _mm256_set1_ps(lr);
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 diff_v = _mm256_loadu_ps(diff + i);
+    const __m256 new_m = _mm256_add_ps(_mm256_mul_ps(beta1_v, _mm256_loadu_ps(m + i)),
+                                       _mm256_mul_ps(one_minus_beta1_v, diff_v));
+    const __m256 new_v =
+        _mm256_add_ps(_mm256_mul_ps(beta2_v, _mm256_loadu_ps(v + i)),
+                      _mm256_mul_ps(_mm256_mul_ps(one_minus_beta2_v, diff_v), diff_v));
+    _mm256_storeu_ps(m + i, new_m);
+    _mm256_storeu_ps(v + i, new_v);
+    const __m256 step = _mm256_div_ps(_mm256_mul_ps(lr_v, new_m),
+                                      _mm256_add_ps(_mm256_sqrt_ps(new_v), epsilon_v));
+    _mm256_storeu_ps(model + i, _mm256_sub_ps(_mm256_loadu_ps(model + i), step));
+  }
+  LazyAdamUpdateRowScalar<float>(n - i, beta1, beta2, epsilon, lr, diff + i, model + i, m + i,
+                                 v + i);
+}
+
+__attribute__((target("avx2"))) void LazyAdamUpdateRowAvx2(int64_t n, double beta1,
+                                                           double beta2, double epsilon,
+                                                           double lr, const double* diff,
+                                                           double* model, double* m, double* v) {
+  const __m256d beta1_v = _mm256_set1_pd(beta1);
+  const __m256d one_minus_beta1_v = _mm256_set1_pd(1 - beta1);
+  const __m256d beta2_v = _mm256_set1_pd(beta2);
+  const __m256d one_minus_beta2_v = _mm256_set1_pd(1 - beta2);
+  const __m256d epsilon_v = _mm256_set1_pd(epsilon);
+  const __m256d lr_v = _mm256_set1_pd(lr);
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m256d diff_v = _mm256_loadu_pd(diff + i);
+    const __m256d new_m = _mm256_add_pd(_mm256_mul_pd(beta1_v, _mm256_loadu_pd(m + i)),
+                                        _mm256_mul_pd(one_minus_beta1_v, diff_v));
+    const __m256d new_v =
+        _mm256_add_pd(_mm256_mul_pd(beta2_v, _mm256_loadu_pd(v + i)),
+                      _mm256_mul_pd(_mm256_mul_pd(one_minus_beta2_v, diff_v), diff_v));
+    _mm256_storeu_pd(m + i, new_m);
+    _mm256_storeu_pd(v + i, new_v);
+    const __m256d step = _mm256_div_pd(_mm256_mul_pd(lr_v, new_m),
+                                       _mm256_add_pd(_mm256_sqrt_pd(new_v), epsilon_v));
+    _mm256_storeu_pd(model + i, _mm256_sub_pd(_mm256_loadu_pd(model + i), step));
+  }
+  LazyAdamUpdateRowScalar<double>(n - i, beta1, beta2, epsilon, lr, diff + i, model + i, m + i,
+                                  v + i);
+}
+
+#endif  // OF_ROW_UPDATE_X86_SIMD
+
+}  // namespace
+
+void ParallelForEachRowRange(int64_t num_rows, int64_t elem_cnt,
+                             const std::function<void(int64_t, int64_t)>& Handler) {
+  int64_t num_ranges = 1;
+  if (Global<ThreadPool>::Get() != nullptr) {
+    num_ranges = std::min<int64_t>(Global<ThreadPool>::Get()->thread_num(),
+                                   elem_cnt / kMinElemCntPerRowRange);
+    num_ranges = std::min(num_ranges, num_rows);
+  }
+  if (num_ranges <= 1) {
+    if (num_rows > 0) { Handler(0, num_rows); }
+    return;
+  }
+  BalancedSplitter bs(num_rows, num_ranges);
+  MultiThreadLoop(num_ranges, [&](size_t range_id) {
+    const Range range = bs.At(range_id);
+    Handler(range.begin(), range.end());
+  });
+}
+
+template<typename T>
+void LazyAdamUpdateRow(int64_t n, T beta1, T beta2, T epsilon, T lr, const T* diff, T* model, T* m,
+                       T* v) {
+#ifdef OF_ROW_UPDATE_X86_SIMD
+  if (CpuSupportsAvx2()) {
+    LazyAdamUpdateRowAvx2(n, beta1, beta2, epsilon, lr, diff, model, m, v);
+    return;
+  }
+#endif
+  LazyAdamUpdateRowScalar<T>(n, beta1, beta2, epsilon, lr, diff, model, m, v);
+}
+
+template void LazyAdamUpdateRow<float>(int64_t n, float beta1, float beta2, float epsilon,
+                                       float lr, const float* diff, float* model, float* m,
+                                       float* v);
+template void LazyAdamUpdateRow<double>(int64_t n, double beta1, double beta2, double epsilon,
+                                        double lr, const double* diff, double* model, double* m,
+                                        double* v);
+
+}  // namespace oneflow
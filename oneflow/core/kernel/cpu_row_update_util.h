@@ -0,0 +1,66 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_CPU_ROW_UPDATE_UTIL_H_
+#define ONEFLOW_CORE_KERNEL_CPU_ROW_UPDATE_UTIL_H_
+
+#include "oneflow/core/common/util.h"
+#include <cmath>
+
+namespace oneflow {
+
+// Calls Handler(row_begin, row_end) on disjoint ranges covering [0, num_rows). The ranges run in
+// parallel on the thread pool when elem_cnt, the number of elements all rows touch in total, is
+// large enough to pay for the dispatch; otherwise Handler(0, num_rows) runs on the caller.
+void ParallelForEachRowRange(int64_t num_rows, int64_t elem_cnt,
+                             const std::function<void(int64_t, int64_t)>& Handler);
+
+// m = beta1 * m + (1 - beta1) * diff, v = beta2 * v + (1 - beta2) * diff^2,
+// model -= lr * m / (sqrt(v) + epsilon) over one contiguous row of n elements
+template<typename T>
+void LazyAdamUpdateRow(int64_t n, T beta1, T beta2, T epsilon, T lr, const T* diff, T* model, T* m,
+                       T* v);
+
+// lr * sqrt(1 - beta2^t) / (1 - beta1^t), the bias corrected learning rate of step t counting
+// from 1, which lazy_adam computes from its beta1_t and beta2_t variables
+template<typename T>
+inline T LazyAdamBiasCorrectedLearningRate(T lr, T beta1, T beta2, int64_t t) {
+  return static_cast<T>(lr * std::sqrt(1 - std::pow(beta2, t)) / (1 - std::pow(beta1, t)));
+}
+
+// momentum = beta * momentum - lr * diff, model += momentum
+template<typename T>
+inline void MomentumUpdateRow(int64_t n, T beta, T lr, const T* diff, T* model, T* momentum) {
+  for (int64_t i = 0; i < n; ++i) {
+    const T next_momentum = beta * momentum[i] - lr * diff[i];
+    momentum[i] = next_momentum;
+    model[i] = model[i] + next_momentum;
+  }
+}
+
+// y += alpha * x
+template<typename T>
+inline void AxpyRow(int64_t n, T alpha, const T* x, T* y) {
+  for (int64_t i = 0; i < n; ++i) { y[i] += alpha * x[i]; }
+}
+
+template<typename T>
+inline void AddRow(int64_t n, const T* x, T* y) {
+  for (int64_t i = 0; i < n; ++i) { y[i] += x[i]; }
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_CPU_ROW_UPDATE_UTIL_H_
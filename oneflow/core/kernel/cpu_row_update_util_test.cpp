@@ -0,0 +1,239 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/cpu_row_update_util.h"
+#include "oneflow/core/kernel/indexed_slices_lazy_adam_model_update_kernel_util.h"
+#include "oneflow/core/kernel/indexed_slices_momentum_model_update_kernel_util.h"
+#include "oneflow/core/kernel/indexed_slices_naive_model_update_kernel_util.h"
+#include "oneflow/core/kernel/unsorted_segment_sum_kernel_util.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include <chrono>
+#include <numeric>
+#include <random>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+constexpr int64_t kNumRows = 4096;
+constexpr int64_t kLowerBound = 1000;
+constexpr int64_t kUpperBound = kLowerBound + kNumRows;
+
+// the element-wise loop IndexedSlicesLazyAdamMdUpdateKernelUtil<kCPU> used before
+void NaiveLazyAdamUpdate(float beta1, float beta2, float epsilon, int64_t feature_size,
+                         int32_t num_unique_instance, float learning_rate,
+                         const int64_t* indices, const float* values, float* model, float* m,
+                         float* v) {
+  const int64_t n = num_unique_instance * feature_size;
+  for (int64_t i = 0; i < n; ++i) {
+    const int64_t instance_id = indices[i / feature_size];
+    if (instance_id >= kLowerBound && instance_id < kUpperBound) {
+      const float diff = values[i];
+      const int64_t model_idx = (instance_id - kLowerBound) * feature_size + i % feature_size;
+      const float new_m = beta1 * m[model_idx] + (1 - beta1) * diff;
+      const float new_v = beta2 * v[model_idx] + (1 - beta2) * diff * diff;
+      m[model_idx] = new_m;
+      v[model_idx] = new_v;
+      model[model_idx] = model[model_idx] - learning_rate * new_m / (std::sqrt(new_v) + epsilon);
+    }
+  }
+}
+
+// the per element segment sum, summing in input order
+void NaiveSegmentSum(const int64_t* segment_ids, const float* data, int64_t num_segment_ids,
+                     int64_t num_segments, int64_t inner_dim_size, float* out) {
+  FOR_RANGE(int64_t, i, 0, num_segment_ids * inner_dim_size) {
+    const int64_t idx = segment_ids[i / inner_dim_size];
+    out[idx * inner_dim_size + i % inner_dim_size] += data[i];
+  }
+}
+
+template<typename F>
+double AverageMicroseconds(int32_t repeat, const F& f) {
+  auto start = std::chrono::steady_clock::now();
+  FOR_RANGE(int32_t, i, 0, repeat) { f(); }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() / repeat;
+}
+
+std::vector<float> GenValues(int64_t n, uint32_t seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> dis(-1.f, 1.f);
+  std::vector<float> values(n);
+  for (float& value : values) { value = dis(gen); }
+  return values;
+}
+
+// unique instance ids, a quarter of which fall outside [kLowerBound, kUpperBound)
+std::vector<int64_t> GenUniqueIndices(int64_t n) {
+  std::vector<int64_t> indices(kNumRows + kNumRows / 3);
+  std::iota(indices.begin(), indices.end(), kLowerBound);
+  std::shuffle(indices.begin(), indices.end(), std::mt19937(n));
+  indices.resize(n);
+  return indices;
+}
+
+void TestLazyAdam(int64_t feature_size) {
+  const int32_t num_unique = kNumRows;
+  const std::vector<int64_t> indices = GenUniqueIndices(num_unique);
+  const std::vector<float> values = GenValues(num_unique * feature_size, 1);
+  std::vector<float> expected_model = GenValues(kNumRows * feature_size, 2);
+  std::vector<float> expected_m = GenValues(kNumRows * feature_size, 3);
+  std::vector<float> expected_v(kNumRows * feature_size, 0.5f);
+  std::vector<float> model = expected_model;
+  std::vector<float> m = expected_m;
+  std::vector<float> v = expected_v;
+  const float learning_rate = 0.01f;
+  const int64_t train_step = 0;
+  auto Naive = [&]() {
+    NaiveLazyAdamUpdate(0.9f, 0.999f, 1e-8f, feature_size, num_unique, learning_rate,
+                        indices.data(), values.data(), expected_model.data(), expected_m.data(),
+                        expected_v.data());
+  };
+  auto RowWise = [&]() {
+    IndexedSlicesLazyAdamMdUpdateKernelUtil<DeviceType::kCPU, float, int64_t, int32_t>::Update(
+        nullptr, 0.9f, 0.999f, 1e-8f, num_unique, feature_size, kLowerBound, kUpperBound,
+        &num_unique, &train_step, &learning_rate, indices.data(), values.data(), model.data(),
+        m.data(), v.data());
+  };
+  Naive();
+  RowWise();
+  ASSERT_EQ(model, expected_model);
+  ASSERT_EQ(m, expected_m);
+  ASSERT_EQ(v, expected_v);
+
+  const int32_t repeat = 20;
+  const double naive_us = AverageMicroseconds(repeat, Naive);
+  const double row_wise_us = AverageMicroseconds(repeat, RowWise);
+  LOG(INFO) << "lazy_adam rows " << num_unique << " dim " << feature_size << ": element-wise "
+            << naive_us << "us, row-wise " << row_wise_us << "us";
+}
+
+void TestMomentum(int64_t feature_size) {
+  const int32_t num_unique = kNumRows;
+  const std::vector<int64_t> indices = GenUniqueIndices(num_unique);
+  const std::vector<float> values = GenValues(num_unique * feature_size, 1);
+  std::vector<float> expected_model = GenValues(kNumRows * feature_size, 2);
+  std::vector<float> expected_momentum = GenValues(kNumRows * feature_size, 3);
+  std::vector<float> model = expected_model;
+  std::vector<float> momentum = expected_momentum;
+  const float learning_rate = 0.01f;
+  const int64_t train_step = 0;
+  FOR_RANGE(int64_t, i, 0, num_unique * feature_size) {
+    const int64_t instance_id = indices[i / feature_size];
+    if (instance_id < kLowerBound || instance_id >= kUpperBound) { continue; }
+    const int64_t model_idx = (instance_id - kLowerBound) * feature_size + i % feature_size;
+    const float next_momentum = 0.9f * expected_momentum[model_idx] - learning_rate * values[i];
+    expected_momentum[model_idx] = next_momentum;
+    expected_model[model_idx] = expected_model[model_idx] + next_momentum;
+  }
+  IndexedSlicesMomentumMdUpdateKernelUtil<DeviceType::kCPU, float, int64_t, int32_t>::Update(
+      nullptr, 0.9f, num_unique, feature_size, kLowerBound, kUpperBound, &num_unique, &train_step,
+      &learning_rate, indices.data(), values.data(), model.data(), momentum.data());
+  ASSERT_EQ(model, expected_model);
+  ASSERT_EQ(momentum, expected_momentum);
+}
+
+void TestSegmentSum(int64_t inner_dim_size) {
+  const int64_t num_segment_ids = kNumRows * 4;
+  std::vector<int64_t> segment_ids(num_segment_ids);
+  std::mt19937 gen(inner_dim_size);
+  for (int64_t& id : segment_ids) { id = gen() % kNumRows; }
+  const std::vector<float> data = GenValues(num_segment_ids * inner_dim_size, 1);
+  std::vector<float> expected(kNumRows * inner_dim_size, 0.f);
+  std::vector<float> out(kNumRows * inner_dim_size, 0.f);
+  auto Naive = [&]() {
+    NaiveSegmentSum(segment_ids.data(), data.data(), num_segment_ids, kNumRows, inner_dim_size,
+                    expected.data());
+  };
+  auto RowWise = [&]() {
+    UnsortedSegmentSumKernelUtil<DeviceType::kCPU, float, int64_t>::UnsortedSegmentSum(
+        nullptr, segment_ids.data(), data.data(), num_segment_ids, kNumRows, 1, inner_dim_size, 0,
+        out.data());
+  };
+  Naive();
+  RowWise();
+  ASSERT_EQ(out, expected);
+
+  const int32_t repeat = 20;
+  const double naive_us = AverageMicroseconds(repeat, Naive);
+  const double row_wise_us = AverageMicroseconds(repeat, RowWise);
+  LOG(INFO) << "unsorted_segment_sum ids " << num_segment_ids << " dim " << inner_dim_size
+            << ": element-wise " << naive_us << "us, row-wise " << row_wise_us << "us";
+}
+
+}  // namespace
+
+TEST(CpuRowUpdateUtil, indexed_slices_lazy_adam) {
+  Global<ThreadPool>::New(4);
+  for (int64_t feature_size = 8; feature_size <= 512; feature_size *= 2) {
+    TestLazyAdam(feature_size);
+  }
+  TestLazyAdam(13);
+  Global<ThreadPool>::Delete();
+}
+
+TEST(CpuRowUpdateUtil, lazy_adam_bias_correction) {
+  const float learning_rate = 0.01f;
+  const float beta1 = 0.9f;
+  const float beta2 = 0.999f;
+  // beta1_t and beta2_t as the lazy_adam model update keeps them, multiplied once per step
+  float beta1_t = beta1;
+  float beta2_t = beta2;
+  FOR_RANGE(int64_t, t, 1, 100) {
+    const float expected = learning_rate * std::sqrt(1 - beta2_t) / (1 - beta1_t);
+    ASSERT_NEAR(LazyAdamBiasCorrectedLearningRate(learning_rate, beta1, beta2, t), expected,
+                expected * 1e-4);
+    beta1_t *= beta1;
+    beta2_t *= beta2;
+  }
+}
+
+TEST(CpuRowUpdateUtil, indexed_slices_momentum) {
+  Global<ThreadPool>::New(4);
+  TestMomentum(8);
+  TestMomentum(129);
+  Global<ThreadPool>::Delete();
+}
+
+TEST(CpuRowUpdateUtil, indexed_slices_naive) {
+  const std::vector<int64_t> indices{kLowerBound + 3, kLowerBound + 1, kLowerBound + 3, 7};
+  const std::vector<float> values = GenValues(indices.size() * 5, 1);
+  std::vector<float> model(kNumRows * 5, 1.f);
+  std::vector<float> expected = model;
+  FOR_RANGE(int64_t, i, 0, indices.size() * 5) {
+    const int64_t row = indices[i / 5] - kLowerBound;
+    if (row >= 0 && row < kNumRows) { expected[row * 5 + i % 5] -= values[i] * 0.1f; }
+  }
+  const float learning_rate = 0.1f;
+  IndexedSlicesNaiveMdUpdateKernelUtil<DeviceType::kCPU, float, int64_t>::Update(
+      nullptr, indices.data(), values.data(), &learning_rate, indices.size(), kNumRows, 5,
+      kLowerBound, model.data());
+  ASSERT_EQ(model, expected);
+}
+
+TEST(CpuRowUpdateUtil, unsorted_segment_sum) {
+  Global<ThreadPool>::New(4);
+  for (int64_t inner_dim_size = 8; inner_dim_size <= 512; inner_dim_size *= 4) {
+    TestSegmentSum(inner_dim_size);
+  }
+  Global<ThreadPool>::Delete();
+}
+
+}  // namespace test
+
+}  // namespace oneflow
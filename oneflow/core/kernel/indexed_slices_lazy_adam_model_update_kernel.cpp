@@ -17,6 +17,7 @@ limitations under the License.
 #include "oneflow/core/kernel/kernel_context.h"
 #include "oneflow/core/kernel/indexed_slices_reduce_sum_kernel_util.h"
 #include "oneflow/core/kernel/indexed_slices_lazy_adam_model_update_kernel_util.h"
+#include "oneflow/core/kernel/variable_generation.h"
 
 namespace oneflow {
 
@@ -70,6 +71,7 @@ void IndexedSlicesLazyAdamMdUpdateKernel<device_type, T, K>::ForwardDataContent(
                         train_step_ptr, local_learning_rate_ptr, unique_diff_indices->dptr<K>(),
                         unique_diff_values->dptr<T>(), BnInOp2Blob("model")->mut_dptr<T>(),
                         BnInOp2Blob("m")->mut_dptr<T>(), BnInOp2Blob("v")->mut_dptr<T>());
+  IncreaseVariableGeneration();
 }
 
 #define MAKE_INDEXED_SLICES_LAZY_ADAM_MODEL_UPDATE_KERNEL_ENTRY(device_type_v, data_type_pair,     \
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/indexed_slices_lazy_adam_model_update_kernel_util.h"
+#include "oneflow/core/kernel/cpu_row_update_util.h"
 
 namespace oneflow {
 
@@ -24,19 +25,18 @@ struct IndexedSlicesLazyAdamMdUpdateKernelUtil<DeviceType::kCPU, T, K, IDX> {
                      const IDX* num_unique_instance, const int64_t* train_step,
                      const float* learning_rate, const K* indices, const T* values, T* model, T* m,
                      T* v) {
-    const int64_t n = *num_unique_instance * feature_size;
-    for (int64_t i = 0; i < n; ++i) {
-      const K instance_id = indices[i / feature_size];
-      if (instance_id >= lower_bound && instance_id < upper_bound) {
-        const T diff = values[i];
-        const K model_idx = (instance_id - lower_bound) * feature_size + i % feature_size;
-        const T new_m = beta1 * m[model_idx] + (1 - beta1) * diff;
-        const T new_v = beta2 * v[model_idx] + (1 - beta2) * diff * diff;
-        m[model_idx] = new_m;
-        v[model_idx] = new_v;
-        model[model_idx] = model[model_idx] - *learning_rate * new_m / (std::sqrt(new_v) + epsilon);
+    // indices are unique, so every row of model, m and v is updated by at most one range
+    const int64_t num_rows = *num_unique_instance;
+    const T lr = *learning_rate;
+    ParallelForEachRowRange(num_rows, num_rows * feature_size, [&](int64_t begin, int64_t end) {
+      FOR_RANGE(int64_t, row, begin, end) {
+        const K instance_id = indices[row];
+        if (instance_id < lower_bound || instance_id >= upper_bound) { continue; }
+        const int64_t offset = (instance_id - lower_bound) * feature_size;
+        LazyAdamUpdateRow<T>(feature_size, beta1, beta2, epsilon, lr, values + row * feature_size,
+                             model + offset, m + offset, v + offset);
       }
-    }
+    });
   }
   static void ComputeLocalLearningRate(DeviceCtx* ctx, T beta1, T beta2, const int64_t* train_step,
                                        const float* learning_rate, float* local_learning_rate) {
@@ -17,6 +17,7 @@ limitations under the License.
 #include "oneflow/core/kernel/kernel_context.h"
 #include "oneflow/core/kernel/indexed_slices_reduce_sum_kernel_util.h"
 #include "oneflow/core/kernel/indexed_slices_momentum_model_update_kernel_util.h"
+#include "oneflow/core/kernel/variable_generation.h"
 
 namespace oneflow {
 
@@ -65,6 +66,7 @@ void IndexedSlicesMomentumMdUpdateKernel<device_type, T, K>::ForwardDataContent(
                         learning_rate_ptr, unique_diff_indices->dptr<K>(),
                         unique_diff_values->dptr<T>(), BnInOp2Blob("model")->mut_dptr<T>(),
                         BnInOp2Blob("momentum")->mut_dptr<T>());
+  IncreaseVariableGeneration();
 }
 
 #define MAKE_INDEXED_SLICES_MOMENTUM_MODEL_UPDATE_KERNEL_ENTRY(device_type_v, data_type_pair,     \
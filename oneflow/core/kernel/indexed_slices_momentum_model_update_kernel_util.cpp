@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/indexed_slices_momentum_model_update_kernel_util.h"
+#include "oneflow/core/kernel/cpu_row_update_util.h"
 
 namespace oneflow {
 
@@ -23,7 +24,18 @@ struct IndexedSlicesMomentumMdUpdateKernelUtil<DeviceType::kCPU, T, K, IDX> {
                      int64_t lower_bound, int64_t upper_bound, const IDX* num_unique_instance,
                      const int64_t* train_step, const float* learning_rate, const K* indices,
                      const T* values, T* model, T* momentum) {
-    UNIMPLEMENTED();
+    // indices are unique, so every row of model and momentum is updated by at most one range
+    const int64_t num_rows = *num_unique_instance;
+    const T lr = *learning_rate;
+    ParallelForEachRowRange(num_rows, num_rows * feature_size, [&](int64_t begin, int64_t end) {
+      FOR_RANGE(int64_t, row, begin, end) {
+        const K instance_id = indices[row];
+        if (instance_id < lower_bound || instance_id >= upper_bound) { continue; }
+        const int64_t offset = (instance_id - lower_bound) * feature_size;
+        MomentumUpdateRow<T>(feature_size, beta, lr, values + row * feature_size, model + offset,
+                             momentum + offset);
+      }
+    });
   }
 };
 
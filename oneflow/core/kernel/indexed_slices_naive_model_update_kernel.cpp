@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/kernel/kernel.h"
 #include "oneflow/core/kernel/indexed_slices_naive_model_update_kernel_util.h"
+#include "oneflow/core/kernel/variable_generation.h"
 
 namespace oneflow {
 
@@ -50,6 +51,7 @@ void IndexedSlicesNaiveMdUpdateKernel<device_type, T, K>::ForwardDataContent(
       ctx.device_ctx, indices->dptr<K>(), values->dptr<T>(), learning_rate->dptr<float>(),
       indices->shape().elem_cnt(), model->shape().At(0), model->shape().Count(1), offset,
       model->mut_dptr<T>());
+  IncreaseVariableGeneration();
 }
 
 #define MAKE_INDEXED_SLICES_NAIVE_MODEL_UPDATE_KERNEL_ENTRY(device_type_v, data_type_pair,         \
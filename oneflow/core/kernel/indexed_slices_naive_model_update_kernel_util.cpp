@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/indexed_slices_naive_model_update_kernel_util.h"
+#include "oneflow/core/kernel/cpu_row_update_util.h"
 
 namespace oneflow {
 
@@ -29,16 +30,19 @@ void IndexedSlicesNaiveMdUpdateKernelUtil<DeviceType::kCPU, T, K>::Update(
     DeviceCtx* ctx, const K* indices, const T* values, const float* learning_rate,
     int64_t num_indices, int64_t num_features, int64_t feature_size, int64_t feature_id_offset,
     T* model) {
-  FOR_RANGE(int64_t, i, 0, num_indices) {
-    const K feature_id = indices[i];
-    CHECK_GE(feature_id, 0);
-    const K local_feature_id = feature_id - feature_id_offset;
-    if (local_feature_id >= 0 && local_feature_id < num_features) {
-      const T* from = values + i * feature_size;
-      T* to = model + local_feature_id * feature_size;
-      for (int64_t j = 0; j < feature_size; ++j) { to[j] -= from[j] * (*learning_rate); }
-    }
-  }
+  FOR_RANGE(int64_t, i, 0, num_indices) { CHECK_GE(indices[i], 0); }
+  const T alpha = -*learning_rate;
+  // indices may repeat, so each range owns a range of model rows and applies the updates to
+  // them in input order, which keeps the result identical to a sequential loop
+  ParallelForEachRowRange(
+      num_features, num_indices * feature_size, [&](int64_t begin, int64_t end) {
+        FOR_RANGE(int64_t, i, 0, num_indices) {
+          const int64_t local_feature_id = indices[i] - feature_id_offset;
+          if (local_feature_id < begin || local_feature_id >= end) { continue; }
+          AxpyRow<T>(feature_size, alpha, values + i * feature_size,
+                     model + local_feature_id * feature_size);
+        }
+      });
 }
 #define INITIATE_INDEXED_SLICES_NAIVE_MODEL_UPDATE_KERNEL_UTIL_GPU(in_type_pair, index_type_pair) \
   template struct IndexedSlicesNaiveMdUpdateKernelUtil<                                           \
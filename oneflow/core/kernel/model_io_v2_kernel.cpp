@@ -17,6 +17,9 @@ limitations under the License.
 #include "oneflow/core/register/tensor_slice_copier.h"
 #include "oneflow/core/device/cpu_device_context.h"
 #include "oneflow/core/job/machine_context.h"
+#include "oneflow/core/embedding/embedding_store.h"
+#include "oneflow/core/persistence/async_snapshot_writer.h"
+#include "oneflow/core/kernel/variable_generation.h"
 
 namespace oneflow {
 
@@ -142,6 +145,41 @@ void HostSliceCopy(Blob* dst, const TensorSliceView& dst_slice, const Blob* src,
   copier.Copy(&cpu_device_ctx, *host_memory_copier, dst, src);
 }
 
+std::string GetSavePartKey(const std::string& var_lbn, const int64_t parallel_id,
+                           const int64_t parallel_num, const bool sharded) {
+  return sharded ? GetSnapshotShardKey(var_lbn, parallel_id, parallel_num)
+                 : GetTmpPartKey(var_lbn, parallel_id, parallel_num);
+}
+
+std::string GetAsyncPartDoneKey(const std::string& snapshot_path, const std::string& part_key) {
+  return "AsyncSnapshotPartDone-" + JoinPath(snapshot_path, part_key);
+}
+
+std::vector<TensorSliceView> GetPartSlices(const KernelConf& kernel_conf) {
+  std::vector<TensorSliceView> part_slices;
+  FOR_RANGE(int64_t, i, 0, kernel_conf.model_io_v2_conf().parallel_ctx().parallel_num()) {
+    part_slices.push_back(GetPartSlice(kernel_conf, i));
+  }
+  return part_slices;
+}
+
+void MergeTmpParts(const std::string& snapshot_path, const std::string& var_lbn,
+                   const std::vector<TensorSliceView>& part_slices, Blob* total_blob) {
+  Shape logical_blob_shape;
+  total_blob->shape().ToShape(&logical_blob_shape);
+  const TensorSliceView total_slice(logical_blob_shape);
+  const int64_t parallel_num = part_slices.size();
+  SnapshotReader reader(snapshot_path);
+  FOR_RANGE(int64_t, i, 0, parallel_num) {
+    const TensorSliceView& part_slice = part_slices.at(i);
+    const std::string part_key = GetTmpPartKey(var_lbn, i, parallel_num);
+    OnDemandHostBlob part_blob(part_slice.shape(), total_blob->data_type());
+    reader.Read(part_key, part_blob.blob());
+    HostSliceCopy(total_blob, total_slice, part_blob.blob(), part_slice);
+    SnapshotFS()->RecursivelyDeleteDir(Dirname(JoinPath(snapshot_path, part_key)));
+  }
+}
+
 template<DeviceType device_type>
 class AutoSyncBlobAccessor final {
  public:
@@ -202,6 +240,7 @@ class ModelInitV2Kernel final : public KernelIf<device_type> {
   void Forward(const KernelCtx& ctx,
                std::function<Blob*(const std::string&)> BnInOp2Blob) const override {
     ForwardDataContent(ctx, BnInOp2Blob);
+    IncreaseVariableGeneration();
   }
   void ForwardDataContent(const KernelCtx& ctx,
                           std::function<Blob*(const std::string&)> BnInOp2Blob) const override {
@@ -285,6 +324,7 @@ class ModelLoadV2Kernel final : public KernelIf<device_type> {
   void Forward(const KernelCtx& ctx,
                std::function<Blob*(const std::string&)> BnInOp2Blob) const override {
     ForwardDataContent(ctx, BnInOp2Blob);
+    IncreaseVariableGeneration();
   }
   void ForwardDataContent(const KernelCtx& ctx,
                           std::function<Blob*(const std::string&)> BnInOp2Blob) const override {
@@ -300,6 +340,7 @@ class ModelLoadV2Kernel final : public KernelIf<device_type> {
     const std::string snapshot_path = SyncReadStringFromBlob<device_type>(ctx.device_ctx, path);
     SnapshotReader reader(snapshot_path);
     reader.Read(var_lbn, logical_blob_shape, slice, ref_accessor.host_blob());
+    EmbeddingStoreMgr::Get()->LoadIfExists(conf.variable_op_name(), snapshot_path);
   }
 };
 
@@ -332,31 +373,93 @@ class ModelSaveV2Kernel final : public KernelIf<device_type> {
     if (is_broadcast && parallel_ctx.parallel_id() != 0) { return; }
     const std::string snapshot_path =
         SyncReadStringFromBlob<device_type>(ctx.device_ctx, path_blob);
-    AutoSyncBlobAccessor<device_type> in_accessor(ctx.device_ctx, in_blob, true, false);
-    SnapshotWriter writer(snapshot_path);
     const std::string var_lbn =
         GenLogicalBlobName(conf.variable_op_name(), original_variable_conf.out());
-    const std::string key = is_broadcast ? var_lbn : GetTmpPartKey(var_lbn, parallel_ctx);
+    if (conf.async()) {
+      AsyncForwardDataContent(ctx, in_blob, snapshot_path, var_lbn, is_broadcast);
+      return;
+    }
+    AutoSyncBlobAccessor<device_type> in_accessor(ctx.device_ctx, in_blob, true, false);
+    SnapshotWriter writer(snapshot_path);
+    const int64_t parallel_num = parallel_ctx.parallel_num();
+    const std::string key =
+        is_broadcast
+            ? var_lbn
+            : GetSavePartKey(var_lbn, parallel_ctx.parallel_id(), parallel_num, conf.sharded());
     writer.Write(key, in_accessor.host_blob());
-    if (!is_broadcast) {
-      const int64_t parallel_num = parallel_ctx.parallel_num();
+    if (is_broadcast) { EmbeddingStoreMgr::Get()->SaveIfExists(conf.variable_op_name(), &writer); }
+    if (!is_broadcast && conf.sharded()) {
+      if (parallel_ctx.parallel_id() != 0) { return; }
+      writer.WriteManifest(var_lbn, logical_blob_shape, data_type,
+                           GetPartSlices(this->kernel_conf()));
+    } else if (!is_broadcast) {
       Global<CtrlClient>::Get()->Barrier(
           snapshot_path + "-" + var_lbn + "-Counter-" + std::to_string(*counter_), parallel_num);
       if (parallel_ctx.parallel_id() != 0) { return; }
-      TensorSliceView total_slice(logical_blob_shape);
       OnDemandHostBlob total_blob(logical_blob_shape, data_type);
-      SnapshotReader reader(snapshot_path);
-      FOR_RANGE(int64_t, i, 0, parallel_num) {
-        const TensorSliceView part_slice = GetPartSlice(this->kernel_conf(), i);
-        const std::string part_key = GetTmpPartKey(var_lbn, i, parallel_num);
-        OnDemandHostBlob part_blob(part_slice.shape(), data_type);
-        reader.Read(part_key, part_blob.blob());
-        HostSliceCopy(total_blob.blob(), total_slice, part_blob.blob(), part_slice);
-        SnapshotFS()->RecursivelyDeleteDir(Dirname(JoinPath(snapshot_path, part_key)));
-      }
+      MergeTmpParts(snapshot_path, var_lbn, GetPartSlices(this->kernel_conf()), total_blob.blob());
       writer.Write(var_lbn, total_blob.blob());
     }
   }
+  // Copies the variable into a host staging buffer and leaves the file writing to
+  // AsyncSnapshotWriter, the variable may be updated again as soon as this returns.
+  void AsyncForwardDataContent(const KernelCtx& ctx, const Blob* in_blob,
+                               const std::string& snapshot_path, const std::string& var_lbn,
+                               const bool is_broadcast) const {
+    const ModelSaveV2OpConf& conf = this->op_conf().model_save_v2_conf();
+    const ParallelContext& parallel_ctx = this->kernel_conf().model_io_v2_conf().parallel_ctx();
+    AsyncSnapshotWriter* async_writer = Global<AsyncSnapshotWriter>::Get();
+    CHECK_NOTNULL(async_writer);
+    // blocks this save while earlier ones still hold too many staged bytes
+    async_writer->ReserveStagingBytes(in_blob->ByteSizeOfBlobBody());
+    std::shared_ptr<std::vector<char>> staged(new std::vector<char>(in_blob->ByteSizeOfBlobBody()));
+    SyncCopyToHost<device_type>(ctx.device_ctx, in_blob->dptr(), staged->data(), staged->size());
+    SnapshotWriter writer(snapshot_path);
+    const int64_t var_num = conf.snapshot_var_num();
+    auto FinishVariable = [async_writer, snapshot_path, var_num]() {
+      async_writer->FinishVariable(snapshot_path, var_num);
+    };
+    if (is_broadcast) {
+      EmbeddingStoreMgr::Get()->SaveIfExists(conf.variable_op_name(), &writer);
+      async_writer->Write(snapshot_path, var_lbn, staged, FinishVariable);
+      return;
+    }
+    const bool sharded = conf.sharded();
+    const std::string part_key = GetSavePartKey(var_lbn, parallel_ctx.parallel_id(),
+                                                parallel_ctx.parallel_num(), sharded);
+    const std::string part_done_key = GetAsyncPartDoneKey(snapshot_path, part_key);
+    async_writer->Write(snapshot_path, part_key, staged, [part_done_key]() {
+      Global<CtrlClient>::Get()->PushKVT(part_done_key, 1);
+    });
+    if (parallel_ctx.parallel_id() != 0) { return; }
+    // the merge or the manifest may outlive the runtime, so they must not refer to the kernel
+    const Shape logical_blob_shape(conf.original_variable_conf().shape());
+    const DataType data_type = conf.original_variable_conf().data_type();
+    const std::vector<TensorSliceView> part_slices = GetPartSlices(this->kernel_conf());
+    async_writer->Schedule([=]() {
+      const int64_t parallel_num = part_slices.size();
+      FOR_RANGE(int64_t, i, 0, parallel_num) {
+        const std::string part_done_key_i =
+            GetAsyncPartDoneKey(snapshot_path, GetSavePartKey(var_lbn, i, parallel_num, sharded));
+        std::string unused;
+        Global<CtrlClient>::Get()->PullKV(part_done_key_i, &unused);
+        Global<CtrlClient>::Get()->ClearKV(part_done_key_i);
+      }
+      if (sharded) {
+        SnapshotWriter writer(snapshot_path);
+        writer.WriteManifest(var_lbn, logical_blob_shape, data_type, part_slices);
+        FinishVariable();
+        return;
+      }
+      OnDemandHostBlob total_blob(logical_blob_shape, data_type);
+      MergeTmpParts(snapshot_path, var_lbn, part_slices, total_blob.blob());
+      const char* total_dptr = total_blob.blob()->dptr<char>();
+      async_writer->ReserveStagingBytes(total_blob.blob()->ByteSizeOfBlobBody());
+      std::shared_ptr<std::vector<char>> merged(new std::vector<char>(
+          total_dptr, total_dptr + total_blob.blob()->ByteSizeOfBlobBody()));
+      async_writer->Write(snapshot_path, var_lbn, merged, FinishVariable);
+    });
+  }
   std::unique_ptr<int64_t> counter_;
 };
 
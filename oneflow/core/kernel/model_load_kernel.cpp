@@ -14,6 +14,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/kernel.h"
+#include "oneflow/core/kernel/variable_generation.h"
+#include "oneflow/core/embedding/embedding_store.h"
 #include "oneflow/core/common/str_util.h"
 #include <iostream>
 
@@ -45,6 +47,7 @@ class ModelLoadKernel final : public KernelIf<DeviceType::kCPU> {
   void Forward(const KernelCtx& ctx,
                std::function<Blob*(const std::string&)> BnInOp2Blob) const override {
     ForwardDataContent(ctx, BnInOp2Blob);
+    IncreaseVariableGeneration();
   }
   void ForwardDataContent(const KernelCtx& ctx,
                           std::function<Blob*(const std::string&)> BnInOp2Blob) const override {
@@ -69,6 +72,7 @@ class ModelLoadKernel final : public KernelIf<DeviceType::kCPU> {
                                                          original_variable_conf.initializer(),
                                                          random_seed_gen(), out_i);
       }
+      EmbeddingStoreMgr::Get()->LoadIfExists(conf.variable_op_name(i), path);
     }
   }
 };
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/kernel.h"
+#include "oneflow/core/embedding/embedding_store.h"
 
 namespace oneflow {
 
@@ -41,6 +42,7 @@ void ModelSaveKernel::ForwardDataContent(
   FOR_RANGE(int64_t, i, 0, conf.in_size()) {
     const Blob* in_i = BnInOp2Blob(GenRepeatedBn("in", i));
     writer.Write(conf.key(i), in_i);
+    EmbeddingStoreMgr::Get()->SaveIfExists(GenLogicalBlobId(conf.key(i)).op_name(), &writer);
   }
   writer.Close();
 }
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/normal_model_update_kernel.h"
+#include "oneflow/core/kernel/variable_generation.h"
 
 namespace oneflow {
 
@@ -30,6 +31,7 @@ void NormalMdUpdateKernel<device_type, T>::ForwardDataContent(
   const int64_t* train_step_ptr = BnInOp2Blob("train_step")->dptr<int64_t>();
   const float* learning_rate_ptr = BnInOp2Blob("learning_rate")->dptr<float>();
   UpdateModel(ctx.device_ctx, weight_decay_, train_step_ptr, learning_rate_ptr, BnInOp2Blob);
+  IncreaseVariableGeneration();
 }
 
 #define INSTANTIATE_KERNEL(device_type, data_type_pair) \
@@ -14,9 +14,319 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/unique_kernel_util.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/thread/thread_pool.h"
 
 namespace oneflow {
 
+namespace {
+
+// inputs shorter than this are deduplicated on the calling thread
+constexpr int64_t kParallelUniqueMinN = 1 << 14;
+constexpr int64_t kMaxNumUniqueParts = 64;
+constexpr int64_t kMinUniqueHashTableCapacity = 16;
+// integral keys of batches at least this large are deduplicated by sorting, since the hash
+// table no longer fits in any cache; ONEFLOW_CPU_UNIQUE_SORT_THRESHOLD overrides it
+constexpr int64_t kDefaultSortBasedUniqueMinN = 1 << 24;
+
+template<typename KEY, typename IDX>
+struct UniqueSlot {
+  int64_t first_pos;  // -1 for an empty hash table slot
+  KEY key;
+  IDX count;
+  IDX idx;
+};
+
+template<typename KEY>
+struct UniqueSortEntry {
+  KEY key;
+  int64_t pos;
+};
+
+template<typename KEY>
+bool operator<(const UniqueSortEntry<KEY>& lhs, const UniqueSortEntry<KEY>& rhs) {
+  return lhs.key < rhs.key || (lhs.key == rhs.key && lhs.pos < rhs.pos);
+}
+
+int64_t GetUniqueHashTableCapacity(int64_t n) {
+  int64_t capacity = kMinUniqueHashTableCapacity;
+  while (capacity < 2 * n) { capacity *= 2; }
+  return capacity;
+}
+
+int64_t GetSortBasedUniqueMinN() {
+  const char* threshold = std::getenv("ONEFLOW_CPU_UNIQUE_SORT_THRESHOLD");
+  if (threshold != nullptr) { return std::stoll(threshold); }
+  return kDefaultSortBasedUniqueMinN;
+}
+
+int64_t GetNumUniqueParts(int64_t n) {
+  if (n < kParallelUniqueMinN || Global<ThreadPool>::Get() == nullptr) { return 1; }
+  const int64_t thread_num = Global<ThreadPool>::Get()->thread_num();
+  int64_t num_parts = 1;
+  while (num_parts * 2 <= std::min(thread_num, kMaxNumUniqueParts)) { num_parts *= 2; }
+  return num_parts;
+}
+
+void ForEachUniquePart(int64_t num_parts, const std::function<void(int64_t)>& Handler) {
+  if (num_parts == 1) {
+    Handler(0);
+  } else {
+    MultiThreadLoop(num_parts, [&](size_t part_id) { Handler(part_id); });
+  }
+}
+
+template<typename KEY>
+uint64_t HashUniqueKey(KEY key) {
+  uint64_t h = 0;
+  // +0.0 and -0.0 compare equal, so they must hash equal too
+  if (key != static_cast<KEY>(0)) { std::memcpy(&h, &key, sizeof(KEY)); }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+template<typename KEY, typename IDX>
+class CpuUniqueWorkspace final {
+ public:
+  CpuUniqueWorkspace(int64_t n, void* ptr, int64_t size) {
+    CHECK_LE(SizeInBytes(n), size);
+    char* base = reinterpret_cast<char*>(ptr);
+    slot_of_ = reinterpret_cast<int64_t*>(base);
+    buf_ = base + SlotOfSize(n);
+  }
+  ~CpuUniqueWorkspace() = default;
+
+  static int64_t SizeInBytes(int64_t n) {
+    return SlotOfSize(n) + std::max(HashTableSize(n) + PartPosSize(n), SortBuffersSize(n));
+  }
+
+  // for every input position, the slot that holds its key
+  int64_t* slot_of() const { return slot_of_; }
+  UniqueSlot<KEY, IDX>* hash_table() const { return reinterpret_cast<UniqueSlot<KEY, IDX>*>(buf_); }
+  // the input positions grouped by the table region their keys hash to
+  int64_t* part_pos(int64_t n) const {
+    return reinterpret_cast<int64_t*>(buf_ + HashTableSize(n));
+  }
+  UniqueSortEntry<KEY>* sort_buf(int64_t n, int64_t i) const {
+    return reinterpret_cast<UniqueSortEntry<KEY>*>(buf_ + i * SortEntriesSize(n));
+  }
+  UniqueSlot<KEY, IDX>* sort_groups(int64_t n) const {
+    return reinterpret_cast<UniqueSlot<KEY, IDX>*>(buf_ + 2 * SortEntriesSize(n));
+  }
+
+ private:
+  static int64_t SlotOfSize(int64_t n) { return GetCudaAlignedSize(n * sizeof(int64_t)); }
+  static int64_t HashTableSize(int64_t n) {
+    return GetCudaAlignedSize(GetUniqueHashTableCapacity(n) * sizeof(UniqueSlot<KEY, IDX>));
+  }
+  static int64_t PartPosSize(int64_t n) { return GetCudaAlignedSize(n * sizeof(int64_t)); }
+  static int64_t SortEntriesSize(int64_t n) {
+    return GetCudaAlignedSize(n * sizeof(UniqueSortEntry<KEY>));
+  }
+  static int64_t SortBuffersSize(int64_t n) {
+    if (!std::is_integral<KEY>::value) { return 0; }
+    return 2 * SortEntriesSize(n) + GetCudaAlignedSize(n * sizeof(UniqueSlot<KEY, IDX>));
+  }
+
+  int64_t* slot_of_;
+  char* buf_;
+};
+
+// Inserts in[i] into the region of region_size slots at region_begin, probing from its home
+// slot and wrapping inside the region. Returns false if the region becomes more than half full.
+template<typename KEY, typename IDX>
+bool InsertUniqueKey(const KEY* in, int64_t i, int64_t home, int64_t region_begin,
+                     int64_t region_size, UniqueSlot<KEY, IDX>* table, int64_t* num_used,
+                     int64_t* slot_of) {
+  const KEY key = in[i];
+  UniqueSlot<KEY, IDX>* region = table + region_begin;
+  int64_t offset = home - region_begin;
+  while (true) {
+    UniqueSlot<KEY, IDX>* slot = region + offset;
+    if (slot->first_pos == -1) {
+      slot->first_pos = i;
+      slot->key = key;
+      slot->count = 1;
+      *num_used += 1;
+      if (*num_used * 2 > region_size) { return false; }
+      break;
+    } else if (slot->key == key) {
+      slot->count += 1;
+      break;
+    }
+    offset = (offset + 1) & (region_size - 1);
+  }
+  slot_of[i] = region_begin + offset;
+  return true;
+}
+
+// Partitions the positions by the region of their home slot in one pass over the input, so that
+// every part only visits its own keys. Each input chunk counts its keys per part, then scatters
+// their positions to part_pos in increasing order, which keeps the first occurrence of a key the
+// first one inserted. The home slots are kept in slot_of until the parts overwrite them.
+template<typename KEY>
+void PartitionUniqueKeys(int64_t n, const KEY* in, int64_t capacity, int64_t num_parts,
+                         int64_t* slot_of, int64_t* part_pos, int64_t* part_begin) {
+  const int64_t region_size = capacity / num_parts;
+  BalancedSplitter bs(n, num_parts);
+  // chunk_part_offset[chunk_id * num_parts + part_id], a count and then a scatter offset
+  std::vector<int64_t> chunk_part_offset(num_parts * num_parts, 0);
+  ForEachUniquePart(num_parts, [&](int64_t chunk_id) {
+    int64_t* part_cnt = chunk_part_offset.data() + chunk_id * num_parts;
+    FOR_RANGE(int64_t, i, bs.At(chunk_id).begin(), bs.At(chunk_id).end()) {
+      const int64_t home = HashUniqueKey(in[i]) & (capacity - 1);
+      slot_of[i] = home;
+      part_cnt[home / region_size] += 1;
+    }
+  });
+  int64_t offset = 0;
+  FOR_RANGE(int64_t, part_id, 0, num_parts) {
+    part_begin[part_id] = offset;
+    FOR_RANGE(int64_t, chunk_id, 0, num_parts) {
+      const int64_t cnt = chunk_part_offset.at(chunk_id * num_parts + part_id);
+      chunk_part_offset.at(chunk_id * num_parts + part_id) = offset;
+      offset += cnt;
+    }
+  }
+  part_begin[num_parts] = offset;
+  ForEachUniquePart(num_parts, [&](int64_t chunk_id) {
+    int64_t* part_offset = chunk_part_offset.data() + chunk_id * num_parts;
+    FOR_RANGE(int64_t, i, bs.At(chunk_id).begin(), bs.At(chunk_id).end()) {
+      part_pos[part_offset[slot_of[i] / region_size]++] = i;
+    }
+  });
+}
+
+// Every part owns one region of the table and inserts the keys partitioned to it. Returns
+// false if a region overflows, in which case the caller retries with a single part.
+template<typename KEY, typename IDX>
+bool BuildUniqueHashTableParts(int64_t n, const KEY* in, int64_t capacity, int64_t num_parts,
+                               UniqueSlot<KEY, IDX>* table, int64_t* slot_of,
+                               int64_t* part_pos) {
+  int64_t part_begin[kMaxNumUniqueParts + 1];
+  PartitionUniqueKeys(n, in, capacity, num_parts, slot_of, part_pos, part_begin);
+  const int64_t region_size = capacity / num_parts;
+  std::atomic<bool> overflowed(false);
+  ForEachUniquePart(num_parts, [&](int64_t part_id) {
+    const int64_t region_begin = part_id * region_size;
+    FOR_RANGE(int64_t, i, 0, region_size) { table[region_begin + i].first_pos = -1; }
+    int64_t num_used = 0;
+    FOR_RANGE(int64_t, j, part_begin[part_id], part_begin[part_id + 1]) {
+      const int64_t i = part_pos[j];
+      if (!InsertUniqueKey(in, i, slot_of[i], region_begin, region_size, table, &num_used,
+                           slot_of)) {
+        overflowed = true;
+        return;
+      }
+    }
+  });
+  return !overflowed;
+}
+
+template<typename KEY, typename IDX>
+void BuildUniqueHashTable(int64_t n, const KEY* in, int64_t num_parts,
+                          UniqueSlot<KEY, IDX>* table, int64_t* slot_of, int64_t* part_pos) {
+  const int64_t capacity = GetUniqueHashTableCapacity(n);
+  num_parts = std::min(num_parts, capacity / kMinUniqueHashTableCapacity);
+  if (num_parts > 1
+      && BuildUniqueHashTableParts(n, in, capacity, num_parts, table, slot_of, part_pos)) {
+    return;
+  }
+  FOR_RANGE(int64_t, i, 0, capacity) { table[i].first_pos = -1; }
+  int64_t num_used = 0;
+  FOR_RANGE(int64_t, i, 0, n) {
+    const int64_t home = HashUniqueKey(in[i]) & (capacity - 1);
+    CHECK(InsertUniqueKey(in, i, home, 0, capacity, table, &num_used, slot_of));
+  }
+}
+
+// Sorts (key, position) pairs and turns every run of equal keys into one group slot
+template<typename KEY, typename IDX>
+void BuildUniqueSortedGroups(int64_t n, const KEY* in, int64_t num_parts,
+                             const CpuUniqueWorkspace<KEY, IDX>& ws) {
+  UniqueSortEntry<KEY>* src = ws.sort_buf(n, 0);
+  UniqueSortEntry<KEY>* dst = ws.sort_buf(n, 1);
+  BalancedSplitter bs(n, num_parts);
+  ForEachUniquePart(num_parts, [&](int64_t part_id) {
+    const Range range = bs.At(part_id);
+    FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+      src[i].key = in[i];
+      src[i].pos = i;
+    }
+    std::sort(src + range.begin(), src + range.end());
+  });
+  for (int64_t width = 1; width < num_parts; width *= 2) {
+    ForEachUniquePart(num_parts / (width * 2), [&](int64_t merge_id) {
+      const int64_t begin = bs.At(merge_id * width * 2).begin();
+      const int64_t mid = bs.At(merge_id * width * 2 + width).begin();
+      const int64_t end = bs.At(merge_id * width * 2 + width * 2 - 1).end();
+      std::merge(src + begin, src + mid, src + mid, src + end, dst + begin);
+    });
+    std::swap(src, dst);
+  }
+  UniqueSlot<KEY, IDX>* groups = ws.sort_groups(n);
+  int64_t* slot_of = ws.slot_of();
+  ForEachUniquePart(num_parts, [&](int64_t part_id) {
+    const Range range = bs.At(part_id);
+    if (range.size() == 0) { return; }
+    int64_t head = range.begin();
+    while (head > 0 && src[head - 1].key == src[head].key) { head -= 1; }
+    FOR_RANGE(int64_t, j, range.begin(), range.end()) {
+      if (src[j].key != src[head].key) { head = j; }
+      slot_of[src[j].pos] = head;
+      if (head != j) { continue; }
+      int64_t group_end = j + 1;
+      while (group_end < n && src[group_end].key == src[j].key) { group_end += 1; }
+      groups[j].first_pos = src[j].pos;
+      groups[j].key = src[j].key;
+      groups[j].count = group_end - j;
+    }
+  });
+}
+
+// Numbers the slots in the order their keys first occur in the input, which is exactly the
+// order a sequential scan would produce, then writes all outputs
+template<typename KEY, typename IDX>
+void WriteUniqueOutputs(int64_t n, int64_t num_parts, UniqueSlot<KEY, IDX>* slots,
+                        const int64_t* slot_of, IDX* num_unique, KEY* unique_out, IDX* idx_out,
+                        IDX* count) {
+  BalancedSplitter bs(n, num_parts);
+  int64_t part_offset[kMaxNumUniqueParts + 1];
+  part_offset[0] = 0;
+  ForEachUniquePart(num_parts, [&](int64_t part_id) {
+    int64_t num_first = 0;
+    FOR_RANGE(int64_t, i, bs.At(part_id).begin(), bs.At(part_id).end()) {
+      if (slots[slot_of[i]].first_pos == i) { num_first += 1; }
+    }
+    part_offset[part_id + 1] = num_first;
+  });
+  FOR_RANGE(int64_t, part_id, 0, num_parts) { part_offset[part_id + 1] += part_offset[part_id]; }
+  ForEachUniquePart(num_parts, [&](int64_t part_id) {
+    int64_t next_idx = part_offset[part_id];
+    FOR_RANGE(int64_t, i, bs.At(part_id).begin(), bs.At(part_id).end()) {
+      UniqueSlot<KEY, IDX>* slot = slots + slot_of[i];
+      if (slot->first_pos != i) { continue; }
+      slot->idx = next_idx;
+      unique_out[next_idx] = slot->key;
+      if (count != nullptr) { count[next_idx] = slot->count; }
+      next_idx += 1;
+    }
+  });
+  ForEachUniquePart(num_parts, [&](int64_t part_id) {
+    FOR_RANGE(int64_t, i, bs.At(part_id).begin(), bs.At(part_id).end()) {
+      idx_out[i] = slots[slot_of[i]].idx;
+    }
+  });
+  *num_unique = part_offset[num_parts];
+}
+
+}  // namespace
+
 template<typename KEY, typename IDX>
 struct UniqueKernelUtil<DeviceType::kCPU, KEY, IDX> {
   static void Unique(DeviceCtx* ctx, int64_t n, const KEY* in, IDX* num_unique, KEY* unique_out,
@@ -27,31 +337,31 @@ struct UniqueKernelUtil<DeviceType::kCPU, KEY, IDX> {
   static void UniqueWithCounts(DeviceCtx* ctx, int64_t n, const KEY* in, IDX* num_unique,
                                KEY* unique_out, IDX* idx_out, IDX* count, void* workspace,
                                int64_t workspace_size_in_bytes) {
-    HashMap<KEY, IDX> map;
-    FOR_RANGE(int64_t, i, 0, n) {
-      KEY in_i = in[i];
-      auto it = map.find(in_i);
-      if (it == map.end()) {
-        IDX idx = map.size();
-        if (count != nullptr) { count[idx] = 1; }
-        idx_out[i] = idx;
-        unique_out[idx] = in_i;
-        map[in_i] = idx;
-      } else {
-        IDX idx = it->second;
-        if (count != nullptr) { count[idx] += 1; }
-        idx_out[i] = idx;
-      }
+    if (n == 0) {
+      *num_unique = 0;
+      return;
+    }
+    CpuUniqueWorkspace<KEY, IDX> ws(n, workspace, workspace_size_in_bytes);
+    const int64_t num_parts = GetNumUniqueParts(n);
+    UniqueSlot<KEY, IDX>* slots = nullptr;
+    if (std::is_integral<KEY>::value && n >= GetSortBasedUniqueMinN()) {
+      BuildUniqueSortedGroups<KEY, IDX>(n, in, num_parts, ws);
+      slots = ws.sort_groups(n);
+    } else {
+      BuildUniqueHashTable<KEY, IDX>(n, in, num_parts, ws.hash_table(), ws.slot_of(),
+                                     ws.part_pos(n));
+      slots = ws.hash_table();
     }
-    *num_unique = map.size();
+    WriteUniqueOutputs<KEY, IDX>(n, num_parts, slots, ws.slot_of(), num_unique, unique_out, idx_out,
+                                 count);
   }
   static void GetUniqueWorkspaceSizeInBytes(DeviceCtx* ctx, int64_t n,
                                             int64_t* workspace_size_in_bytes) {
-    *workspace_size_in_bytes = 1;
+    *workspace_size_in_bytes = std::max<int64_t>(CpuUniqueWorkspace<KEY, IDX>::SizeInBytes(n), 1);
   }
   static void GetUniqueWithCountsWorkspaceSizeInBytes(DeviceCtx* ctx, int64_t n,
                                                       int64_t* workspace_size_in_bytes) {
-    *workspace_size_in_bytes = 1;
+    *workspace_size_in_bytes = std::max<int64_t>(CpuUniqueWorkspace<KEY, IDX>::SizeInBytes(n), 1);
   }
 };
 
@@ -0,0 +1,96 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/unique_kernel_util.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+template<typename KEY, typename IDX>
+void TestCpuUniqueWithCounts(const std::vector<KEY>& in) {
+  const int64_t n = in.size();
+  std::vector<KEY> expected_unique;
+  std::vector<IDX> expected_idx;
+  std::vector<IDX> expected_count;
+  HashMap<KEY, IDX> key2idx;
+  for (const KEY key : in) {
+    auto it = key2idx.find(key);
+    if (it == key2idx.end()) {
+      it = key2idx.emplace(key, expected_unique.size()).first;
+      expected_unique.push_back(key);
+      expected_count.push_back(0);
+    }
+    expected_idx.push_back(it->second);
+    expected_count.at(it->second) += 1;
+  }
+
+  int64_t workspace_size = 0;
+  UniqueKernelUtil<DeviceType::kCPU, KEY, IDX>::GetUniqueWithCountsWorkspaceSizeInBytes(
+      nullptr, n, &workspace_size);
+  std::vector<char> workspace(workspace_size);
+  IDX num_unique = -1;
+  std::vector<KEY> unique_out(n);
+  std::vector<IDX> idx_out(n);
+  std::vector<IDX> count(n);
+  UniqueKernelUtil<DeviceType::kCPU, KEY, IDX>::UniqueWithCounts(
+      nullptr, n, in.data(), &num_unique, unique_out.data(), idx_out.data(), count.data(),
+      workspace.data(), workspace_size);
+  ASSERT_EQ(num_unique, expected_unique.size());
+  unique_out.resize(num_unique);
+  count.resize(num_unique);
+  ASSERT_EQ(unique_out, expected_unique);
+  ASSERT_EQ(idx_out, expected_idx);
+  ASSERT_EQ(count, expected_count);
+}
+
+std::vector<int64_t> GenSparseIds(int64_t n, int64_t num_distinct) {
+  std::mt19937 gen(n);
+  std::uniform_int_distribution<int64_t> dis(0, num_distinct - 1);
+  std::vector<int64_t> ids(n);
+  for (int64_t& id : ids) { id = dis(gen) * 7919 - num_distinct; }
+  return ids;
+}
+
+}  // namespace
+
+TEST(UniqueKernelUtil, cpu_hash_sequential) {
+  TestCpuUniqueWithCounts<int64_t, int32_t>(GenSparseIds(1000, 100));
+  TestCpuUniqueWithCounts<float, int64_t>({1.5f, -0.0f, 2.f, 0.f, 1.5f, -3.f});
+}
+
+TEST(UniqueKernelUtil, cpu_hash_parallel) {
+  Global<ThreadPool>::New(4);
+  TestCpuUniqueWithCounts<int64_t, int32_t>(GenSparseIds(100000, 5000));
+  TestCpuUniqueWithCounts<int64_t, int64_t>(GenSparseIds(100000, 100000000));
+  TestCpuUniqueWithCounts<int64_t, int32_t>(std::vector<int64_t>(50000, 42));
+  Global<ThreadPool>::Delete();
+}
+
+TEST(UniqueKernelUtil, cpu_sort_parallel) {
+  Global<ThreadPool>::New(4);
+  setenv("ONEFLOW_CPU_UNIQUE_SORT_THRESHOLD", "1", 1);
+  TestCpuUniqueWithCounts<int64_t, int32_t>(GenSparseIds(100000, 5000));
+  TestCpuUniqueWithCounts<int32_t, int32_t>({3, 1, 3, 2, 1, 1});
+  unsetenv("ONEFLOW_CPU_UNIQUE_SORT_THRESHOLD");
+  Global<ThreadPool>::Delete();
+}
+
+}  // namespace test
+
+}  // namespace oneflow
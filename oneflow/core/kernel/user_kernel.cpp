@@ -43,6 +43,37 @@ void FillTensorDescWithBlob(const Blob* blob, user_op::TensorDesc* tensor_desc)
 
 using Arg2Tensor = HashMap<std::pair<std::string, int32_t>, std::unique_ptr<user_op::Tensor>>;
 using ArgVec = std::vector<std::pair<std::string, int32_t>>;
+template<typename T>
+using Bn7ArgPtrVec = std::vector<std::pair<std::string, std::unique_ptr<T>*>>;
+
+namespace {
+
+// bn strings are generated once here instead of on every act
+template<typename T>
+void InitBn7ArgPtrVec(HashMap<std::pair<std::string, int32_t>, std::unique_ptr<T>>* arg2ptr,
+                      Bn7ArgPtrVec<T>* bn7arg_ptr_vec) {
+  bn7arg_ptr_vec->clear();
+  bn7arg_ptr_vec->reserve(arg2ptr->size());
+  for (auto& pair : *arg2ptr) {
+    bn7arg_ptr_vec->emplace_back(GenRepeatedBn(pair.first.first, pair.first.second), &pair.second);
+  }
+}
+
+void UpdateTensorsWithBlobs(const Bn7ArgPtrVec<user_op::Tensor>& bn7tensor_ptr_vec,
+                            const std::function<Blob*(const std::string&)>& BnInOp2Blob) {
+  for (const auto& pair : bn7tensor_ptr_vec) {
+    Blob* blob = BnInOp2Blob(pair.first);
+    if (blob == nullptr) { continue; }
+    std::unique_ptr<user_op::Tensor>* arg_tensor_ptr = pair.second;
+    if (*arg_tensor_ptr) {
+      (*arg_tensor_ptr)->Reset(blob);
+    } else {
+      arg_tensor_ptr->reset(new user_op::Tensor(blob));
+    }
+  }
+}
+
+}  // namespace
 
 class UserKernelBaseContext {
  public:
@@ -163,6 +194,7 @@ class UserKernelOpInferContext : public user_op::InferContext {
     };
     InitArgs7TensorDesc7Sbp(op_conf.user_conf().input(), &inputs_);
     InitArgs7TensorDesc7Sbp(op_conf.user_conf().output(), &outputs_);
+    InitBn7ArgPtrVec(&arg2tensor_desc_, &bn7tensor_desc_ptr_vec_);
     parallel_ctx_.set_parallel_id(0);
     parallel_ctx_.set_parallel_num(1);
   }
@@ -201,10 +233,9 @@ class UserKernelOpInferContext : public user_op::InferContext {
   }
 
   void UpdateArg2TensorDesc(const std::function<Blob*(const std::string&)>& BnInOp2Blob) {
-    for (auto& pair : arg2tensor_desc_) {
-      const auto& arg_pair = pair.first;
-      std::unique_ptr<user_op::TensorDesc>* arg_tensor_desc_ptr = &pair.second;
-      Blob* blob = BnInOp2Blob(GenRepeatedBn(arg_pair.first, arg_pair.second));
+    for (const auto& pair : bn7tensor_desc_ptr_vec_) {
+      std::unique_ptr<user_op::TensorDesc>* arg_tensor_desc_ptr = pair.second;
+      Blob* blob = BnInOp2Blob(pair.first);
       CHECK_NOTNULL(blob);
       if (*arg_tensor_desc_ptr) {
         (*arg_tensor_desc_ptr)->mut_shape()->CheckNumAxesIdenticalAndAssign(blob->shape());
@@ -222,6 +253,7 @@ class UserKernelOpInferContext : public user_op::InferContext {
   ParallelContext parallel_ctx_;
   SbpSignature sbp_signature_;
   HashMap<std::pair<std::string, int32_t>, std::unique_ptr<user_op::TensorDesc>> arg2tensor_desc_;
+  Bn7ArgPtrVec<user_op::TensorDesc> bn7tensor_desc_ptr_vec_;
 };
 
 class UserKernelInferContext final : public user_op::KernelInferContext {
@@ -243,6 +275,7 @@ class UserKernelInferContext final : public user_op::KernelInferContext {
     };
     InitArg2Blob(kernel_conf.op_attribute().op_conf().user_conf().input());
     InitArg2Blob(kernel_conf.op_attribute().op_conf().user_conf().output());
+    InitBn7ArgPtrVec(&arg2tensor_, &bn7tensor_ptr_vec_);
 
     const auto* op_reg_val = user_op::UserOpRegistryMgr::Get().GetOpRegistryResult(
         kernel_conf.op_attribute().op_conf().user_conf().op_type_name());
@@ -285,17 +318,7 @@ class UserKernelInferContext final : public user_op::KernelInferContext {
   const user_op::TensorDescInferFn& GetOpInferFn() const override { return tensor_desc_infer_fn_; }
 
   void UpdateArg2Tensor(const std::function<Blob*(const std::string&)>& BnInOp2Blob) {
-    for (auto& pair : arg2tensor_) {
-      const auto& arg_pair = pair.first;
-      std::unique_ptr<user_op::Tensor>* arg_tensor_ptr = &pair.second;
-      Blob* blob = BnInOp2Blob(GenRepeatedBn(arg_pair.first, arg_pair.second));
-      if (blob == nullptr) { continue; }
-      if (*arg_tensor_ptr) {
-        *(arg_tensor_ptr->get()) = std::move(user_op::Tensor(blob));
-      } else {
-        arg_tensor_ptr->reset(new user_op::Tensor(blob));
-      }
-    }
+    UpdateTensorsWithBlobs(bn7tensor_ptr_vec_, BnInOp2Blob);
   }
 
  private:
@@ -304,6 +327,7 @@ class UserKernelInferContext final : public user_op::KernelInferContext {
   UserKernelOpInferContext op_infer_ctx_;
   user_op::TensorDescInferFn tensor_desc_infer_fn_;
   HashMap<std::pair<std::string, int32_t>, std::unique_ptr<user_op::Tensor>> arg2tensor_;
+  Bn7ArgPtrVec<user_op::Tensor> bn7tensor_ptr_vec_;
 };
 
 class UserKernelComputeContext final : public user_op::KernelComputeContext {
@@ -325,6 +349,7 @@ class UserKernelComputeContext final : public user_op::KernelComputeContext {
     InitInOrOut(kernel_conf.op_attribute().op_conf().user_conf().input());
     InitInOrOut(kernel_conf.op_attribute().op_conf().user_conf().output());
     arg2tensor_.emplace(std::make_pair("tmp_buffer", 0), std::unique_ptr<user_op::Tensor>());
+    InitBn7ArgPtrVec(&arg2tensor_, &bn7tensor_ptr_vec_);
   }
   ~UserKernelComputeContext() = default;
 
@@ -340,18 +365,8 @@ class UserKernelComputeContext final : public user_op::KernelComputeContext {
   }
   DeviceCtx* device_ctx() override { return device_ctx_; }
 
-  void UpdateTensorWithCorrBlob(std::function<Blob*(const std::string&)> BnInOp2Blob) {
-    for (auto& pair : arg2tensor_) {
-      const auto& arg_pair = pair.first;
-      std::unique_ptr<user_op::Tensor>* arg_tensor_ptr = &pair.second;
-      Blob* blob = BnInOp2Blob(GenRepeatedBn(arg_pair.first, arg_pair.second));
-      if (blob == nullptr) { continue; }
-      if (*arg_tensor_ptr) {
-        *(arg_tensor_ptr->get()) = std::move(user_op::Tensor(blob));
-      } else {
-        arg_tensor_ptr->reset(new user_op::Tensor(blob));
-      }
-    }
+  void UpdateTensorWithCorrBlob(const std::function<Blob*(const std::string&)>& BnInOp2Blob) {
+    UpdateTensorsWithBlobs(bn7tensor_ptr_vec_, BnInOp2Blob);
   }
 
   DeviceType device_type() const override { return base_ctx_.device_type(); }
@@ -364,6 +379,7 @@ class UserKernelComputeContext final : public user_op::KernelComputeContext {
  private:
   DeviceCtx* device_ctx_;
   Arg2Tensor arg2tensor_;
+  Bn7ArgPtrVec<user_op::Tensor> bn7tensor_ptr_vec_;
   UserKernelBaseContext base_ctx_;
 };
 
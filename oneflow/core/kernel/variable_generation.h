@@ -0,0 +1,31 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_VARIABLE_GENERATION_H_
+#define ONEFLOW_CORE_KERNEL_VARIABLE_GENERATION_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// The generation of the variable values, increased after model init, model load, assign or a
+// model update overwrote variables. Kernels caching values computed from variables recompute them
+// when it changes.
+int64_t VariableGeneration();
+void IncreaseVariableGeneration();
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_VARIABLE_GENERATION_H_
@@ -0,0 +1,128 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/async_snapshot_writer.h"
+#include "oneflow/core/control/ctrl_client.h"
+#include "oneflow/core/common/str_util.h"
+
+namespace oneflow {
+
+AsyncSnapshotWriter::AsyncSnapshotWriter(fs::FileSystem* fs, int32_t writer_num,
+                                         int64_t max_staging_bytes)
+    : fs_(fs),
+      max_staging_bytes_(max_staging_bytes),
+      staging_bytes_(0),
+      pending_cnt_(0),
+      writer_pool_(writer_num),
+      merge_pool_(1) {
+  CHECK_GT(writer_num, 0);
+  CHECK_GT(max_staging_bytes, 0);
+}
+
+AsyncSnapshotWriter::~AsyncSnapshotWriter() { WaitAllDone(); }
+
+void AsyncSnapshotWriter::ReserveStagingBytes(int64_t bytes) {
+  std::unique_lock<std::mutex> lock(staging_mutex_);
+  staging_cond_.wait(lock, [this, bytes]() {
+    return staging_bytes_ == 0 || staging_bytes_ + bytes <= max_staging_bytes_;
+  });
+  staging_bytes_ += bytes;
+}
+
+int64_t AsyncSnapshotWriter::staging_bytes() const {
+  std::unique_lock<std::mutex> lock(staging_mutex_);
+  return staging_bytes_;
+}
+
+void AsyncSnapshotWriter::ReleaseStagingBytes(int64_t bytes) {
+  std::unique_lock<std::mutex> lock(staging_mutex_);
+  staging_bytes_ -= bytes;
+  CHECK_GE(staging_bytes_, 0);
+  staging_cond_.notify_all();
+}
+
+void AsyncSnapshotWriter::Write(const std::string& root, const std::string& key,
+                                std::shared_ptr<const std::vector<char>> data,
+                                std::function<void()> Done) {
+  IncreasePending();
+  writer_pool_.AddWork([this, root, key, data, Done]() {
+    const std::string path = JoinPath(root, key);
+    CreateDirOnce(Dirname(path));
+    {
+      std::unique_ptr<fs::WritableFile> file;
+      fs_->NewWritableFile(path, &file);
+      file->Append(data->data(), data->size());
+      file->Close();
+    }
+    ReleaseStagingBytes(data->size());
+    if (Done) { Done(); }
+    DecreasePending();
+  });
+}
+
+void AsyncSnapshotWriter::Schedule(std::function<void()> work) {
+  IncreasePending();
+  merge_pool_.AddWork([this, work]() {
+    work();
+    DecreasePending();
+  });
+}
+
+void AsyncSnapshotWriter::FinishVariable(const std::string& root, int64_t var_num) {
+  const std::string count_key = "AsyncSnapshotFinishedVarCnt-" + root;
+  const int64_t finished_cnt = Global<CtrlClient>::Get()->IncreaseCount(count_key);
+  CHECK_LE(finished_cnt, var_num);
+  if (finished_cnt != var_num) { return; }
+  Global<CtrlClient>::Get()->EraseCount(count_key);
+  CommitSnapshot(root);
+}
+
+void AsyncSnapshotWriter::CommitSnapshot(const std::string& root) {
+  // readers take a snapshot as complete once snapshot_done exists, so it must appear atomically
+  const std::string tmp_done_path = JoinPath(root, ".snapshot_done.tmp");
+  {
+    std::unique_ptr<fs::WritableFile> file;
+    fs_->NewWritableFile(tmp_done_path, &file);
+    file->Close();
+  }
+  fs_->RenameFile(tmp_done_path, JoinPath(root, "snapshot_done"));
+}
+
+void AsyncSnapshotWriter::WaitAllDone() {
+  std::unique_lock<std::mutex> lock(pending_mutex_);
+  pending_cond_.wait(lock, [this]() { return pending_cnt_ == 0; });
+}
+
+void AsyncSnapshotWriter::IncreasePending() {
+  std::unique_lock<std::mutex> lock(pending_mutex_);
+  pending_cnt_ += 1;
+}
+
+void AsyncSnapshotWriter::DecreasePending() {
+  std::unique_lock<std::mutex> lock(pending_mutex_);
+  pending_cnt_ -= 1;
+  if (pending_cnt_ == 0) { pending_cond_.notify_all(); }
+}
+
+void AsyncSnapshotWriter::CreateDirOnce(const std::string& dir) {
+  // every file of a snapshot lives in a directory owned by a single writer, so directories are
+  // created locally without a control-plane round trip per file
+  std::unique_lock<std::mutex> lock(dir_mutex_);
+  if (created_dirs_.find(dir) != created_dirs_.end()) { return; }
+  fs_->RecursivelyCreateDirIfNotExist(dir);
+  created_dirs_.insert(dir);
+}
+
+}  // namespace oneflow
@@ -0,0 +1,77 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_PERSISTENCE_ASYNC_SNAPSHOT_WRITER_H_
+#define ONEFLOW_CORE_PERSISTENCE_ASYNC_SNAPSHOT_WRITER_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+
+// Writes host-staged snapshot files in the background, so that the model save job only has to
+// copy the variables out and training can go on while the files are being written.
+class AsyncSnapshotWriter final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(AsyncSnapshotWriter);
+  AsyncSnapshotWriter() = delete;
+  // at most max_staging_bytes of staged data are held until written, see ReserveStagingBytes
+  AsyncSnapshotWriter(fs::FileSystem* fs, int32_t writer_num, int64_t max_staging_bytes);
+  ~AsyncSnapshotWriter();
+
+  // blocks until bytes more can be staged without exceeding max_staging_bytes, unless nothing is
+  // staged at all, so that a save cannot pile up host copies of the variables faster than they
+  // are written; every data passed to Write has to be reserved first
+  void ReserveStagingBytes(int64_t bytes);
+  int64_t staging_bytes() const;
+  // writes data into root/key on the writer pool, releases its staging bytes and calls Done after
+  // the file is closed
+  void Write(const std::string& root, const std::string& key,
+             std::shared_ptr<const std::vector<char>> data, std::function<void()> Done);
+  // runs work which may wait on other writes, e.g. merging the parts of a split variable
+  void Schedule(std::function<void()> work);
+  // counts one finished variable of the snapshot at root, the var_num-th one among all the
+  // machines writes the snapshot_done marker
+  void FinishVariable(const std::string& root, int64_t var_num);
+  // writes the snapshot_done marker of root to a temp file and renames it, so that readers never
+  // see a snapshot_done which is still being written
+  void CommitSnapshot(const std::string& root);
+  void WaitAllDone();
+
+ private:
+  void IncreasePending();
+  void DecreasePending();
+  void CreateDirOnce(const std::string& dir);
+  void ReleaseStagingBytes(int64_t bytes);
+
+  fs::FileSystem* fs_;
+  const int64_t max_staging_bytes_;
+  mutable std::mutex staging_mutex_;
+  std::condition_variable staging_cond_;
+  int64_t staging_bytes_;
+  std::mutex pending_mutex_;
+  std::condition_variable pending_cond_;
+  int64_t pending_cnt_;
+  std::mutex dir_mutex_;
+  HashSet<std::string> created_dirs_;
+  // declared last so that the threads are joined before the members above are destroyed
+  ThreadPool writer_pool_;
+  ThreadPool merge_pool_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_PERSISTENCE_ASYNC_SNAPSHOT_WRITER_H_
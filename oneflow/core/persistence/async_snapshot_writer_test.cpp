@@ -0,0 +1,178 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/async_snapshot_writer.h"
+#include "oneflow/core/common/str_util.h"
+#include <stdlib.h>
+#include <atomic>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+std::string NewTmpDir() {
+  char tmpl[] = "/tmp/async_snapshot_writer_test_XXXXXX";
+  CHECK_NOTNULL(mkdtemp(tmpl));
+  return tmpl;
+}
+
+std::shared_ptr<const std::vector<char>> Bytes(int64_t size, char value) {
+  return std::make_shared<const std::vector<char>>(size, value);
+}
+
+std::vector<char> ReadAll(const std::string& path) {
+  std::vector<char> content(LocalFS()->GetFileSize(path));
+  std::unique_ptr<fs::RandomAccessFile> file;
+  LocalFS()->NewRandomAccessFile(path, &file);
+  if (!content.empty()) { file->Read(0, content.size(), content.data()); }
+  return content;
+}
+
+void WriteStaged(AsyncSnapshotWriter* writer, const std::string& root, const std::string& key,
+                 std::shared_ptr<const std::vector<char>> data, std::function<void()> Done) {
+  writer->ReserveStagingBytes(data->size());
+  writer->Write(root, key, data, Done);
+}
+
+}  // namespace
+
+TEST(AsyncSnapshotWriter, write_and_wait_all_done) {
+  const std::string root = NewTmpDir();
+  std::atomic<int64_t> done_cnt(0);
+  {
+    AsyncSnapshotWriter writer(LocalFS(), 4, 1 << 20);
+    FOR_RANGE(int64_t, i, 0, 32) {
+      const std::string key = "var" + std::to_string(i % 4) + "/part" + std::to_string(i);
+      const std::string path = JoinPath(root, key);
+      auto data = Bytes(i * 1000, 'a' + i % 26);
+      // Done runs once the file is closed, so it must already hold all the data
+      WriteStaged(&writer, root, key, data, [path, data, &done_cnt]() {
+        CHECK(ReadAll(path) == *data);
+        done_cnt += 1;
+      });
+    }
+    writer.WaitAllDone();
+    ASSERT_EQ(done_cnt, 32);
+    ASSERT_EQ(writer.staging_bytes(), 0);
+  }
+  FOR_RANGE(int64_t, i, 0, 32) {
+    const std::string path =
+        JoinPath(root, "var" + std::to_string(i % 4) + "/part" + std::to_string(i));
+    ASSERT_TRUE(ReadAll(path) == *Bytes(i * 1000, 'a' + i % 26));
+  }
+  LocalFS()->RecursivelyDeleteDir(root);
+}
+
+TEST(AsyncSnapshotWriter, schedule_waits_for_writes) {
+  const std::string root = NewTmpDir();
+  AsyncSnapshotWriter writer(LocalFS(), 2, 1 << 20);
+  std::mutex mutex;
+  std::condition_variable cond;
+  int64_t part_done_cnt = 0;
+  FOR_RANGE(int64_t, i, 0, 4) {
+    WriteStaged(&writer, root, "part" + std::to_string(i), Bytes(100, '0' + i),
+                [&mutex, &cond, &part_done_cnt]() {
+                  std::unique_lock<std::mutex> lock(mutex);
+                  part_done_cnt += 1;
+                  cond.notify_all();
+                });
+  }
+  // like the merge of a split variable, the scheduled work waits for the parts and writes more
+  writer.Schedule([&]() {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cond.wait(lock, [&part_done_cnt]() { return part_done_cnt == 4; });
+    }
+    std::shared_ptr<std::vector<char>> merged(new std::vector<char>());
+    FOR_RANGE(int64_t, i, 0, 4) {
+      const std::vector<char> part = ReadAll(JoinPath(root, "part" + std::to_string(i)));
+      merged->insert(merged->end(), part.begin(), part.end());
+    }
+    WriteStaged(&writer, root, "merged", merged, std::function<void()>());
+  });
+  // WaitAllDone also covers the write issued by the scheduled work
+  writer.WaitAllDone();
+  const std::vector<char> merged = ReadAll(JoinPath(root, "merged"));
+  ASSERT_EQ(merged.size(), 400);
+  FOR_RANGE(int64_t, i, 0, 400) { ASSERT_EQ(merged.at(i), '0' + i / 100); }
+  LocalFS()->RecursivelyDeleteDir(root);
+}
+
+TEST(AsyncSnapshotWriter, commit_snapshot) {
+  const std::string root = NewTmpDir();
+  AsyncSnapshotWriter writer(LocalFS(), 1, 1 << 20);
+  ASSERT_FALSE(LocalFS()->FileExists(JoinPath(root, "snapshot_done")));
+  writer.CommitSnapshot(root);
+  ASSERT_TRUE(LocalFS()->FileExists(JoinPath(root, "snapshot_done")));
+  ASSERT_FALSE(LocalFS()->FileExists(JoinPath(root, ".snapshot_done.tmp")));
+  // committing a snapshot saved again to the same path replaces the marker
+  writer.CommitSnapshot(root);
+  ASSERT_TRUE(LocalFS()->FileExists(JoinPath(root, "snapshot_done")));
+  ASSERT_FALSE(LocalFS()->FileExists(JoinPath(root, ".snapshot_done.tmp")));
+  LocalFS()->RecursivelyDeleteDir(root);
+}
+
+TEST(AsyncSnapshotWriter, commit_after_all_writes) {
+  const std::string root = NewTmpDir();
+  const int64_t var_num = 16;
+  AsyncSnapshotWriter writer(LocalFS(), 4, 1 << 20);
+  std::atomic<int64_t> finished_cnt(0);
+  std::atomic<bool> committed_early(false);
+  FOR_RANGE(int64_t, i, 0, var_num) {
+    WriteStaged(&writer, root, "var" + std::to_string(i), Bytes(4096, 'x'), [&]() {
+      // the same counting FinishVariable does through the control plane
+      if (LocalFS()->FileExists(JoinPath(root, "snapshot_done"))) { committed_early = true; }
+      if (++finished_cnt == var_num) { writer.CommitSnapshot(root); }
+    });
+  }
+  writer.WaitAllDone();
+  ASSERT_FALSE(committed_early);
+  ASSERT_TRUE(LocalFS()->FileExists(JoinPath(root, "snapshot_done")));
+  ASSERT_FALSE(LocalFS()->FileExists(JoinPath(root, ".snapshot_done.tmp")));
+  // every variable is complete once snapshot_done exists
+  FOR_RANGE(int64_t, i, 0, var_num) {
+    ASSERT_EQ(LocalFS()->GetFileSize(JoinPath(root, "var" + std::to_string(i))), 4096);
+  }
+  LocalFS()->RecursivelyDeleteDir(root);
+}
+
+TEST(AsyncSnapshotWriter, staging_bytes_bounded) {
+  const std::string root = NewTmpDir();
+  const int64_t max_staging_bytes = 1000;
+  AsyncSnapshotWriter writer(LocalFS(), 2, max_staging_bytes);
+  FOR_RANGE(int64_t, i, 0, 64) {
+    auto data = Bytes(300, 'y');
+    writer.ReserveStagingBytes(data->size());
+    ASSERT_LE(writer.staging_bytes(), max_staging_bytes);
+    writer.Write(root, "var" + std::to_string(i), data, std::function<void()>());
+  }
+  writer.WaitAllDone();
+  ASSERT_EQ(writer.staging_bytes(), 0);
+  // a buffer larger than the cap is still admitted when nothing else is staged
+  auto large = Bytes(4 * max_staging_bytes, 'z');
+  writer.ReserveStagingBytes(large->size());
+  ASSERT_EQ(writer.staging_bytes(), large->size());
+  writer.Write(root, "large", large, std::function<void()>());
+  writer.WaitAllDone();
+  ASSERT_EQ(writer.staging_bytes(), 0);
+  ASSERT_EQ(LocalFS()->GetFileSize(JoinPath(root, "large")), large->size());
+  LocalFS()->RecursivelyDeleteDir(root);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
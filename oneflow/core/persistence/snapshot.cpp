@@ -17,25 +17,149 @@ limitations under the License.
 #include "oneflow/core/common/str_util.h"
 #include "oneflow/core/persistence/persistent_in_stream.h"
 #include "oneflow/core/persistence/persistent_out_stream.h"
-#include "oneflow/core/register/tensor_slice_copier.h"
-#include "oneflow/core/device/cpu_device_context.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
 namespace {
 
+constexpr int64_t kMaxCoalescedReadByteSize = 8 * 1024 * 1024;
+// ranges are read with one pread when at least 1 / kMinCoalescedReadDensity of the bytes is used
+constexpr int64_t kMinCoalescedReadDensity = 4;
+
 std::string GenDataFilePath(const std::string& root, const std::string& key) {
   return JoinPath(root, key);
 }
 
+std::string GenManifestKey(const std::string& key) { return key + ".manifest"; }
+
+struct SliceReadRange {
+  int64_t src_offset;
+  int64_t dst_offset;
+  int64_t size;
+};
+
+void ReadRanges(const fs::RandomAccessFile* file, const std::vector<SliceReadRange>& ranges,
+                char* dst, std::vector<char>* buffer) {
+  if (ranges.empty()) { return; }
+  if (ranges.size() == 1) {
+    file->Read(ranges.front().src_offset, ranges.front().size, dst + ranges.front().dst_offset);
+    return;
+  }
+  const int64_t begin = ranges.front().src_offset;
+  buffer->resize(ranges.back().src_offset + ranges.back().size - begin);
+  file->Read(begin, buffer->size(), buffer->data());
+  for (const SliceReadRange& range : ranges) {
+    std::memcpy(dst + range.dst_offset, buffer->data() + range.src_offset - begin, range.size);
+  }
+}
+
+// reads the part of dst_slice covered by the file, which holds file_slice densely
+void ReadSliceFromFile(const std::string& path, const TensorSliceView& file_slice,
+                       DataType data_type, const TensorSliceView& dst_slice, char* dst) {
+  const size_t elem_size = GetSizeOfDataType(data_type);
+  CHECK_EQ(SnapshotFS()->GetFileSize(path), file_slice.shape().elem_cnt() * elem_size)
+      << "unexpected model snapshot size, path: " << path;
+  std::unique_ptr<fs::RandomAccessFile> file;
+  SnapshotFS()->NewRandomAccessFile(path, &file);
+  std::vector<SliceReadRange> coalesced;
+  int64_t coalesced_used_size = 0;
+  std::vector<char> buffer;
+  ForEachContiguousSliceRange(
+      file_slice, dst_slice, elem_size,
+      [&](int64_t src_offset, int64_t dst_offset, int64_t size) {
+        if (!coalesced.empty()) {
+          const int64_t span = src_offset + size - coalesced.front().src_offset;
+          if (span > kMaxCoalescedReadByteSize
+              || (coalesced_used_size + size) * kMinCoalescedReadDensity < span) {
+            ReadRanges(file.get(), coalesced, dst, &buffer);
+            coalesced.clear();
+            coalesced_used_size = 0;
+          }
+        }
+        coalesced.push_back(SliceReadRange{src_offset, dst_offset, size});
+        coalesced_used_size += size;
+      });
+  ReadRanges(file.get(), coalesced, dst, &buffer);
+}
+
 }  // namespace
 
+std::string GetSnapshotShardKey(const std::string& key, int64_t shard_id, int64_t shard_num) {
+  return key + ".shard-" + std::to_string(shard_id) + "-" + std::to_string(shard_num);
+}
+
+void ForEachContiguousSliceRange(const TensorSliceView& src_slice,
+                                 const TensorSliceView& dst_slice, size_t elem_size,
+                                 const std::function<void(int64_t, int64_t, int64_t)>& Handler) {
+  if (src_slice.NumAxes() == 0 && dst_slice.NumAxes() == 0) {
+    Handler(0, 0, elem_size);
+    return;
+  }
+  const TensorSliceView intersection = src_slice.Intersect(dst_slice);
+  if (intersection.IsEmpty()) { return; }
+  const int64_t num_axes = intersection.NumAxes();
+  const Shape& src_shape = src_slice.shape();
+  const Shape& dst_shape = dst_slice.shape();
+  const Shape& shape = intersection.shape();
+  // axes after contiguous_axis are whole in both src and dst, so each range spans them
+  int64_t contiguous_axis = num_axes - 1;
+  while (contiguous_axis > 0 && shape.At(contiguous_axis) == src_shape.At(contiguous_axis)
+         && shape.At(contiguous_axis) == dst_shape.At(contiguous_axis)) {
+    contiguous_axis -= 1;
+  }
+  const int64_t range_size = shape.Count(contiguous_axis) * elem_size;
+  std::vector<int64_t> src_stride(num_axes);
+  std::vector<int64_t> dst_stride(num_axes);
+  FOR_RANGE(int64_t, i, 0, num_axes) {
+    src_stride.at(i) = src_shape.Count(i + 1) * elem_size;
+    dst_stride.at(i) = dst_shape.Count(i + 1) * elem_size;
+  }
+  std::vector<int64_t> index(contiguous_axis + 1, 0);
+  const int64_t range_num = shape.Count(0, contiguous_axis);
+  FOR_RANGE(int64_t, range_id, 0, range_num) {
+    int64_t src_offset = 0;
+    int64_t dst_offset = 0;
+    FOR_RANGE(int64_t, i, 0, contiguous_axis + 1) {
+      const int64_t pos = intersection.At(i).begin() + index.at(i);
+      src_offset += (pos - src_slice.At(i).begin()) * src_stride.at(i);
+      dst_offset += (pos - dst_slice.At(i).begin()) * dst_stride.at(i);
+    }
+    Handler(src_offset, dst_offset, range_size);
+    for (int64_t i = contiguous_axis - 1; i >= 0; --i) {
+      index.at(i) += 1;
+      if (index.at(i) < shape.At(i)) { break; }
+      index.at(i) = 0;
+    }
+  }
+}
+
 SnapshotReader::SnapshotReader(const std::string& snapshot_root_path)
     : root_path_(snapshot_root_path) {}
 
 bool SnapshotReader::HasKey(const std::string& key) const {
   const std::string path = GenDataFilePath(root_path_, key);
-  return SnapshotFS()->FileExists(path);
+  return SnapshotFS()->FileExists(path)
+         || SnapshotFS()->FileExists(GenDataFilePath(root_path_, GenManifestKey(key)));
+}
+
+int64_t SnapshotReader::GetKeySizeInBytes(const std::string& key) const {
+  SnapshotManifestProto manifest;
+  if (TryReadManifest(key, &manifest)) {
+    return Shape(manifest.shape()).elem_cnt() * GetSizeOfDataType(manifest.data_type());
+  }
+  return SnapshotFS()->GetFileSize(GenDataFilePath(root_path_, key));
+}
+
+bool SnapshotReader::TryReadManifest(const std::string& key,
+                                     SnapshotManifestProto* manifest) const {
+  const std::string path = GenDataFilePath(root_path_, GenManifestKey(key));
+  if (!SnapshotFS()->FileExists(path)) { return false; }
+  std::string content(SnapshotFS()->GetFileSize(path), '\0');
+  PersistentInStream in_stream(SnapshotFS(), path);
+  in_stream.ReadFully(&content.front(), content.size());
+  CHECK(TxtString2PbMessage(content, manifest)) << "invalid snapshot manifest, path: " << path;
+  return true;
 }
 
 void SnapshotReader::Read(const std::string& key, Blob* blob) const {
@@ -48,24 +172,30 @@ void SnapshotReader::Read(const std::string& key, const Shape& logical_blob_shap
                           DataType data_type, const TensorSliceView& slice, char* dst) const {
   const TensorSliceView logical_blob_slice(logical_blob_shape);
   CHECK(logical_blob_slice.Contains(slice));
-  const std::string path = GenDataFilePath(root_path_, key);
-  const int64_t logical_blob_size = logical_blob_shape.elem_cnt() * GetSizeOfDataType(data_type);
-  CHECK_EQ(SnapshotFS()->GetFileSize(path), logical_blob_size)
-      << "unexpected model snapshot size, path: " << path;
-  if (slice.shape().Count(1) == logical_blob_shape.Count(1)) {
-    PersistentInStream in_stream(
-        SnapshotFS(), path,
-        slice.At(0).begin() * slice.shape().Count(1) * GetSizeOfDataType(data_type));
-    in_stream.ReadFully(dst, slice.shape().elem_cnt() * GetSizeOfDataType(data_type));
-  } else {
-    std::vector<char> buffer(logical_blob_size);
-    PersistentInStream in_stream(SnapshotFS(), path);
-    in_stream.ReadFully(buffer.data(), logical_blob_size);
-    TensorSliceCopier copier(slice, logical_blob_slice, data_type);
-    CpuDeviceCtx device_ctx;
-    std::unique_ptr<MemoryCopier> host_memory_copier(NewDefaultMemoryCopier(DeviceType::kCPU));
-    copier.Copy(&device_ctx, *host_memory_copier, dst, buffer.data());
+  SnapshotManifestProto manifest;
+  if (!TryReadManifest(key, &manifest)) {
+    ReadSliceFromFile(GenDataFilePath(root_path_, key), logical_blob_slice, data_type, slice, dst);
+    return;
+  }
+  CHECK(Shape(manifest.shape()) == logical_blob_shape)
+      << "unexpected model snapshot shape, key: " << key;
+  CHECK_EQ(manifest.data_type(), data_type) << "unexpected model snapshot data type, key: " << key;
+  std::vector<const SnapshotShardProto*> shards;
+  int64_t covered_elem_cnt = 0;
+  for (const SnapshotShardProto& shard : manifest.shard()) {
+    const TensorSliceView intersection = TensorSliceView(shard.slice()).Intersect(slice);
+    if (intersection.IsEmpty()) { continue; }
+    shards.push_back(&shard);
+    covered_elem_cnt += intersection.shape().elem_cnt();
   }
+  CHECK_EQ(covered_elem_cnt, slice.shape().elem_cnt())
+      << "model snapshot shards do not cover the slice, key: " << key;
+  if (shards.empty()) { return; }
+  // shards cover disjoint parts of dst, so they are read concurrently
+  MultiThreadLoop(shards.size(), [&](size_t i) {
+    ReadSliceFromFile(GenDataFilePath(root_path_, shards.at(i)->key()),
+                      TensorSliceView(shards.at(i)->slice()), data_type, slice, dst);
+  });
 }
 
 void SnapshotReader::Read(const std::string& key, const Shape& logical_blob_shape,
@@ -103,6 +233,21 @@ void SnapshotWriter::Write(const std::string& key, const Blob* blob) {
   Write(key, blob->dptr<char>(), blob->ByteSizeOfBlobBody());
 }
 
+void SnapshotWriter::WriteManifest(const std::string& key, const Shape& logical_blob_shape,
+                                   DataType data_type,
+                                   const std::vector<TensorSliceView>& shard_slices) {
+  SnapshotManifestProto manifest;
+  logical_blob_shape.ToProto(manifest.mutable_shape());
+  manifest.set_data_type(data_type);
+  FOR_RANGE(int64_t, i, 0, shard_slices.size()) {
+    SnapshotShardProto* shard = manifest.mutable_shard()->Add();
+    shard->set_key(GetSnapshotShardKey(key, i, shard_slices.size()));
+    shard_slices.at(i).ToProto(shard->mutable_slice());
+  }
+  const std::string content = PbMessage2TxtString(manifest);
+  Write(GenManifestKey(key), content.data(), content.size());
+}
+
 void SnapshotWriter::Close() {
   PersistentOutStream out_stream(SnapshotFS(), JoinPath(root_path_, "snapshot_done"));
 }
@@ -19,6 +19,7 @@ limitations under the License.
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/control/ctrl_client.h"
 #include "oneflow/core/register/tensor_slice_view.h"
+#include "oneflow/core/persistence/snapshot_manifest.pb.h"
 
 namespace oneflow {
 
@@ -37,9 +38,12 @@ class SnapshotReader final {
             Blob* blob) const;
   void Read(const std::string& key, Blob* blob) const;
   bool HasKey(const std::string& key) const;
+  int64_t GetKeySizeInBytes(const std::string& key) const;
   void Close();
 
  private:
+  bool TryReadManifest(const std::string& key, SnapshotManifestProto* manifest) const;
+
   const std::string root_path_;
 };
 
@@ -52,12 +56,24 @@ class SnapshotWriter final {
 
   void Write(const std::string& key, const char* data, size_t size);
   void Write(const std::string& key, const Blob* blob);
+  // makes key readable from the shards written by Write(GetSnapshotShardKey(key, i, n), ...)
+  void WriteManifest(const std::string& key, const Shape& logical_blob_shape, DataType data_type,
+                     const std::vector<TensorSliceView>& shard_slices);
   void Close();
 
  private:
   const std::string root_path_;
 };
 
+std::string GetSnapshotShardKey(const std::string& key, int64_t shard_id, int64_t shard_num);
+
+// Calls Handler(src_offset, dst_offset, size) in bytes for each contiguous range of the
+// intersection of src_slice and dst_slice, where both are laid out densely in row-major order.
+// Ranges come in increasing order of src_offset.
+void ForEachContiguousSliceRange(const TensorSliceView& src_slice,
+                                 const TensorSliceView& dst_slice, size_t elem_size,
+                                 const std::function<void(int64_t, int64_t, int64_t)>& Handler);
+
 }  // namespace oneflow
 
 #endif  // ONEFLOW_CORE_PERSISTENCE_SNAPSHOT_H_
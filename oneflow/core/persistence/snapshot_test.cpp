@@ -0,0 +1,189 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/snapshot.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/job/job_set.pb.h"
+#include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include <stdlib.h>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+std::vector<std::tuple<int64_t, int64_t, int64_t>> CollectRanges(const TensorSliceView& src,
+                                                                 const TensorSliceView& dst,
+                                                                 size_t elem_size) {
+  std::vector<std::tuple<int64_t, int64_t, int64_t>> ranges;
+  ForEachContiguousSliceRange(src, dst, elem_size,
+                              [&](int64_t src_offset, int64_t dst_offset, int64_t size) {
+                                ranges.emplace_back(src_offset, dst_offset, size);
+                              });
+  return ranges;
+}
+
+std::string NewTmpDir() {
+  char tmpl[] = "/tmp/snapshot_test_XXXXXX";
+  CHECK_NOTNULL(mkdtemp(tmpl));
+  return tmpl;
+}
+
+void WriteFile(const std::string& path, const char* data, size_t size) {
+  std::unique_ptr<fs::WritableFile> file;
+  LocalFS()->NewWritableFile(path, &file);
+  file->Append(data, size);
+  file->Close();
+}
+
+// saves the 4x6 float blob whose elements are their offsets as the shards of rows [0, 1) and
+// [1, 4), as SnapshotWriter::WriteManifest lays them out
+void WriteShardedBlob(const std::string& root, const std::string& key) {
+  const std::vector<TensorSliceView> shard_slices = {TensorSliceView({{0, 1}, {0, 6}}),
+                                                     TensorSliceView({{1, 4}, {0, 6}})};
+  SnapshotManifestProto manifest;
+  Shape({4, 6}).ToProto(manifest.mutable_shape());
+  manifest.set_data_type(DataType::kFloat);
+  int64_t offset = 0;
+  FOR_RANGE(int64_t, i, 0, shard_slices.size()) {
+    const std::string shard_key = GetSnapshotShardKey(key, i, shard_slices.size());
+    SnapshotShardProto* shard = manifest.mutable_shard()->Add();
+    shard->set_key(shard_key);
+    shard_slices.at(i).ToProto(shard->mutable_slice());
+    std::vector<float> data(shard_slices.at(i).shape().elem_cnt());
+    for (float& value : data) { value = offset++; }
+    WriteFile(JoinPath(root, shard_key), reinterpret_cast<const char*>(data.data()),
+              data.size() * sizeof(float));
+  }
+  const std::string content = PbMessage2TxtString(manifest);
+  WriteFile(JoinPath(root, key + ".manifest"), content.data(), content.size());
+}
+
+void NewGlobals() {
+  IOConf io_conf;
+  io_conf.mutable_data_fs_conf()->mutable_localfs_conf();
+  io_conf.mutable_snapshot_fs_conf()->mutable_localfs_conf();
+  Global<const IOConf>::New(io_conf);
+  Global<ThreadPool>::New(4);
+}
+
+void DeleteGlobals() {
+  Global<ThreadPool>::Delete();
+  Global<const IOConf>::Delete();
+}
+
+}  // namespace
+
+TEST(ForEachContiguousSliceRange, row_slice) {
+  const auto ranges =
+      CollectRanges(TensorSliceView({{0, 8}, {0, 4}}), TensorSliceView({{2, 6}, {0, 4}}), 4);
+  ASSERT_EQ(ranges.size(), 1);
+  ASSERT_EQ(ranges.at(0), std::make_tuple(2 * 4 * 4, 0, 4 * 4 * 4));
+}
+
+TEST(ForEachContiguousSliceRange, column_slice) {
+  const auto ranges =
+      CollectRanges(TensorSliceView({{0, 3}, {0, 8}}), TensorSliceView({{0, 3}, {4, 8}}), 1);
+  ASSERT_EQ(ranges.size(), 3);
+  FOR_RANGE(int64_t, i, 0, 3) { ASSERT_EQ(ranges.at(i), std::make_tuple(i * 8 + 4, i * 4, 4)); }
+}
+
+TEST(ForEachContiguousSliceRange, disjoint) {
+  const auto ranges =
+      CollectRanges(TensorSliceView({{0, 3}, {0, 4}}), TensorSliceView({{0, 3}, {4, 8}}), 1);
+  ASSERT_TRUE(ranges.empty());
+}
+
+TEST(ForEachContiguousSliceRange, shard_to_part) {
+  // logical blob 4x6x5, the shard holds rows [0, 4) x [2, 6) and the part rows [1, 3) x [0, 4)
+  const Shape logical_shape({4, 6, 5});
+  const TensorSliceView shard({{0, 4}, {2, 6}, {0, 5}});
+  const TensorSliceView part({{1, 3}, {0, 4}, {0, 5}});
+  auto LogicalOffset = [&](int64_t i, int64_t j, int64_t k) {
+    return (i * logical_shape.At(1) + j) * logical_shape.At(2) + k;
+  };
+  std::vector<int64_t> shard_data(shard.shape().elem_cnt());
+  FOR_RANGE(int64_t, i, 0, shard.shape().At(0)) {
+    FOR_RANGE(int64_t, j, 0, shard.shape().At(1)) {
+      FOR_RANGE(int64_t, k, 0, shard.shape().At(2)) {
+        shard_data.at((i * shard.shape().At(1) + j) * shard.shape().At(2) + k) =
+            LogicalOffset(i + shard.At(0).begin(), j + shard.At(1).begin(), k);
+      }
+    }
+  }
+  std::vector<int64_t> part_data(part.shape().elem_cnt(), -1);
+  const auto ranges = CollectRanges(shard, part, sizeof(int64_t));
+  ASSERT_EQ(ranges.size(), 2);
+  for (const auto& range : ranges) {
+    std::memcpy(reinterpret_cast<char*>(part_data.data()) + std::get<1>(range),
+                reinterpret_cast<const char*>(shard_data.data()) + std::get<0>(range),
+                std::get<2>(range));
+  }
+  FOR_RANGE(int64_t, i, 0, part.shape().At(0)) {
+    FOR_RANGE(int64_t, j, 0, part.shape().At(1)) {
+      FOR_RANGE(int64_t, k, 0, part.shape().At(2)) {
+        const int64_t logical_j = j + part.At(1).begin();
+        const int64_t expected = shard.At(1).begin() <= logical_j && logical_j < shard.At(1).end()
+                                     ? LogicalOffset(i + part.At(0).begin(), logical_j, k)
+                                     : -1;
+        ASSERT_EQ(part_data.at((i * part.shape().At(1) + j) * part.shape().At(2) + k), expected);
+      }
+    }
+  }
+}
+
+TEST(SnapshotReader, read_manifest) {
+  NewGlobals();
+  const std::string root = NewTmpDir();
+  WriteShardedBlob(root, "var");
+  SnapshotReader reader(root);
+  ASSERT_TRUE(reader.HasKey("var"));
+  ASSERT_FALSE(reader.HasKey("no_such_var"));
+  ASSERT_EQ(reader.GetKeySizeInBytes("var"), 4 * 6 * sizeof(float));
+  const Shape shape({4, 6});
+  std::vector<float> all(shape.elem_cnt(), -1);
+  reader.Read("var", shape, DataType::kFloat, TensorSliceView(shape),
+              reinterpret_cast<char*>(all.data()));
+  FOR_RANGE(int64_t, i, 0, all.size()) { ASSERT_EQ(all.at(i), i); }
+  // rows [0, 2) x columns [2, 5) are read from both shards
+  std::vector<float> part(2 * 3, -1);
+  reader.Read("var", shape, DataType::kFloat, TensorSliceView({{0, 2}, {2, 5}}),
+              reinterpret_cast<char*>(part.data()));
+  FOR_RANGE(int64_t, i, 0, 2) {
+    FOR_RANGE(int64_t, j, 0, 3) { ASSERT_EQ(part.at(i * 3 + j), i * 6 + j + 2); }
+  }
+  LocalFS()->RecursivelyDeleteDir(root);
+  DeleteGlobals();
+}
+
+TEST(SnapshotReader, read_empty_slice_of_manifest) {
+  NewGlobals();
+  const std::string root = NewTmpDir();
+  WriteShardedBlob(root, "var");
+  SnapshotReader reader(root);
+  // no shard intersects the slice of no rows past the last one, so nothing is read
+  std::vector<float> dst(1, -1);
+  reader.Read("var", Shape({4, 6}), DataType::kFloat, TensorSliceView({{4, 4}, {0, 6}}),
+              reinterpret_cast<char*>(dst.data()));
+  ASSERT_EQ(dst.at(0), -1);
+  LocalFS()->RecursivelyDeleteDir(root);
+  DeleteGlobals();
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -0,0 +1,191 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/record/ofrecord_index.h"
+#include "oneflow/core/common/platform.h"
+#include "oneflow/core/common/str_util.h"
+
+#ifdef PLATFORM_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // PLATFORM_POSIX
+
+namespace oneflow {
+
+namespace {
+
+constexpr uint64_t kOFRecordIndexMagic = 0x5844494345524f46;  // "OFRECIDX"
+constexpr int64_t kOFRecordIndexVersion = 1;
+constexpr int64_t kSizePrefixBytes = sizeof(int64_t);
+
+struct OFRecordIndexHeader {
+  uint64_t magic;
+  int64_t version;
+  int64_t alignment;
+  int64_t record_num;
+};
+
+// PersistentOutStream syncs directory creation through the CtrlClient, which the index tool and
+// the tests do not have, so the files are written through the FileSystem directly
+std::unique_ptr<fs::WritableFile> NewLocalWritableFile(fs::FileSystem* fs,
+                                                       const std::string& path) {
+  fs->RecursivelyCreateDirIfNotExist(Dirname(path));
+  std::unique_ptr<fs::WritableFile> file;
+  fs->NewWritableFile(path, &file);
+  return file;
+}
+
+}  // namespace
+
+void OFRecordIndex::Load(fs::FileSystem* fs, const std::string& index_path) {
+  std::unique_ptr<fs::RandomAccessFile> file;
+  fs->NewRandomAccessFile(index_path, &file);
+  const uint64_t file_size = fs->GetFileSize(index_path);
+  CHECK_GE(file_size, sizeof(OFRecordIndexHeader)) << index_path;
+  OFRecordIndexHeader header;
+  file->Read(0, sizeof(header), reinterpret_cast<char*>(&header));
+  CHECK_EQ(header.magic, kOFRecordIndexMagic) << index_path << " is not an OFRecord index";
+  CHECK_EQ(header.version, kOFRecordIndexVersion) << index_path;
+  CHECK_GT(header.alignment, 0);
+  CHECK_GE(header.record_num, 0);
+  CHECK_EQ(file_size, sizeof(header) + header.record_num * sizeof(OFRecordIndexEntry))
+      << index_path;
+  alignment_ = header.alignment;
+  entries_.resize(header.record_num);
+  if (header.record_num > 0) {
+    file->Read(sizeof(header), header.record_num * sizeof(OFRecordIndexEntry),
+               reinterpret_cast<char*>(entries_.data()));
+  }
+}
+
+void OFRecordIndex::Save(fs::FileSystem* fs, const std::string& index_path) const {
+  OFRecordIndexHeader header;
+  header.magic = kOFRecordIndexMagic;
+  header.version = kOFRecordIndexVersion;
+  header.alignment = alignment_;
+  header.record_num = entries_.size();
+  std::unique_ptr<fs::WritableFile> file = NewLocalWritableFile(fs, index_path);
+  file->Append(reinterpret_cast<const char*>(&header), sizeof(header));
+  file->Append(reinterpret_cast<const char*>(entries_.data()),
+               entries_.size() * sizeof(OFRecordIndexEntry));
+  file->Close();
+}
+
+void OFRecordIndex::Build(fs::FileSystem* fs, const std::string& part_path) {
+  std::unique_ptr<fs::RandomAccessFile> file;
+  fs->NewRandomAccessFile(part_path, &file);
+  const int64_t file_size = fs->GetFileSize(part_path);
+  alignment_ = 1;
+  entries_.clear();
+  int64_t offset = 0;
+  while (offset < file_size) {
+    CHECK_LE(offset + kSizePrefixBytes, file_size) << part_path << " is truncated";
+    OFRecordIndexEntry entry;
+    file->Read(offset, kSizePrefixBytes, reinterpret_cast<char*>(&entry.size));
+    entry.offset = offset + kSizePrefixBytes;
+    CHECK_GT(entry.size, 0);
+    CHECK_LE(entry.offset + entry.size, file_size) << part_path << " is truncated";
+    entries_.push_back(entry);
+    offset = entry.offset + entry.size;
+  }
+}
+
+void PackOFRecordPart(fs::FileSystem* fs, const std::string& src_part, const std::string& dst_part,
+                      int64_t alignment) {
+  CHECK_GT(alignment, 0);
+  OFRecordIndex src_index;
+  src_index.Build(fs, src_part);
+  std::unique_ptr<fs::RandomAccessFile> src_file;
+  fs->NewRandomAccessFile(src_part, &src_file);
+
+  OFRecordIndex dst_index;
+  dst_index.alignment_ = alignment;
+  dst_index.entries_.reserve(src_index.record_num());
+  std::unique_ptr<fs::WritableFile> dst_file = NewLocalWritableFile(fs, dst_part);
+  const std::vector<char> padding(alignment, 0);
+  std::vector<char> record;
+  int64_t offset = 0;
+  FOR_RANGE(int64_t, i, 0, src_index.record_num()) {
+    const OFRecordIndexEntry& src_entry = src_index.At(i);
+    const int64_t size_offset = RoundUp(offset + kSizePrefixBytes, alignment) - kSizePrefixBytes;
+    const int64_t padding_size = size_offset - offset;
+    dst_file->Append(padding.data(), padding_size);
+    dst_file->Append(reinterpret_cast<const char*>(&src_entry.size), kSizePrefixBytes);
+    record.resize(src_entry.size);
+    src_file->Read(src_entry.offset, src_entry.size, record.data());
+    dst_file->Append(record.data(), record.size());
+    OFRecordIndexEntry dst_entry;
+    dst_entry.offset = size_offset + kSizePrefixBytes;
+    dst_entry.size = src_entry.size;
+    dst_index.entries_.push_back(dst_entry);
+    offset = dst_entry.offset + dst_entry.size;
+  }
+  dst_file->Close();
+  dst_index.Save(fs, OFRecordIndex::IndexFilePath(dst_part));
+}
+
+IndexedOFRecordPart::IndexedOFRecordPart(fs::FileSystem* fs, const std::string& part_path,
+                                         bool random_access)
+    : mapped_(nullptr), mapped_size_(0) {
+  const std::string index_path = OFRecordIndex::IndexFilePath(part_path);
+  if (fs->FileExists(index_path)) {
+    index_.Load(fs, index_path);
+  } else {
+    LOG(WARNING) << index_path << " not found, scanning " << part_path;
+    index_.Build(fs, part_path);
+  }
+#ifdef PLATFORM_POSIX
+  if (fs == LocalFS()) {
+    const std::string translated_path = fs->TranslateName(part_path);
+    const int fd = open(translated_path.c_str(), O_RDONLY);
+    PCHECK(fd >= 0) << "Fail to open file " << part_path;
+    struct stat st;
+    PCHECK(fstat(fd, &st) == 0) << part_path;
+    mapped_size_ = st.st_size;
+    if (mapped_size_ > 0) {
+      void* ptr = mmap(nullptr, mapped_size_, PROT_READ, MAP_SHARED, fd, 0);
+      PCHECK(ptr != MAP_FAILED) << "Fail to mmap file " << part_path;
+      mapped_ = static_cast<char*>(ptr);
+      madvise(ptr, mapped_size_, random_access ? MADV_RANDOM : MADV_SEQUENTIAL);
+    }
+    close(fd);
+  }
+#endif  // PLATFORM_POSIX
+  if (mapped_ == nullptr) { fs->NewRandomAccessFile(part_path, &file_); }
+  if (record_num() > 0) {
+    const OFRecordIndexEntry& last = index_.At(record_num() - 1);
+    CHECK(file_ || last.offset + last.size <= static_cast<int64_t>(mapped_size_))
+        << part_path << " mismatches its index";
+  }
+}
+
+IndexedOFRecordPart::~IndexedOFRecordPart() {
+#ifdef PLATFORM_POSIX
+  if (mapped_ != nullptr) { munmap(mapped_, mapped_size_); }
+#endif  // PLATFORM_POSIX
+}
+
+void IndexedOFRecordPart::ReadRecord(int64_t idx, char* dst) const {
+  const OFRecordIndexEntry& entry = index_.At(idx);
+  if (mapped_ != nullptr) {
+    std::memcpy(dst, mapped_ + entry.offset, entry.size);
+  } else {
+    file_->Read(entry.offset, entry.size, dst);
+  }
+}
+
+}  // namespace oneflow
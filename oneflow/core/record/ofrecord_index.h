@@ -0,0 +1,90 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_RECORD_OFRECORD_INDEX_H_
+#define ONEFLOW_CORE_RECORD_OFRECORD_INDEX_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+
+struct OFRecordIndexEntry {
+  // offset of the serialized OFRecord in the part file, right after its int64 size prefix
+  int64_t offset;
+  int64_t size;
+};
+
+// Sidecar index of an OFRecord part file, stored as "<part>.index". It lists where every record
+// of the part lives, so records can be read in any order without scanning the part.
+//
+// Part files are either the plain length prefixed stream, or the packed layout written by
+// PackOFRecordPart, where each record is preceded by zero padding so that it starts at a
+// multiple of alignment(). Only the plain layout can still be read sequentially.
+class OFRecordIndex final {
+ public:
+  OFRecordIndex() : alignment_(1) {}
+  ~OFRecordIndex() = default;
+
+  static std::string IndexFilePath(const std::string& part_path) { return part_path + ".index"; }
+
+  void Load(fs::FileSystem* fs, const std::string& index_path);
+  void Save(fs::FileSystem* fs, const std::string& index_path) const;
+  // scans the size prefixes of a plain part file
+  void Build(fs::FileSystem* fs, const std::string& part_path);
+
+  int64_t alignment() const { return alignment_; }
+  int64_t record_num() const { return entries_.size(); }
+  const OFRecordIndexEntry& At(int64_t idx) const { return entries_.at(idx); }
+
+ private:
+  friend void PackOFRecordPart(fs::FileSystem*, const std::string&, const std::string&, int64_t);
+
+  int64_t alignment_;
+  std::vector<OFRecordIndexEntry> entries_;
+};
+
+// Rewrites src_part into the packed layout at dst_part and saves its index next to it
+void PackOFRecordPart(fs::FileSystem* fs, const std::string& src_part, const std::string& dst_part,
+                      int64_t alignment);
+
+// Random access to the records of one indexed part. The part is mmap()ed when it lives on the
+// local file system and read with pread() otherwise.
+class IndexedOFRecordPart final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(IndexedOFRecordPart);
+  // builds the index in memory if the part has no index file
+  IndexedOFRecordPart(fs::FileSystem* fs, const std::string& part_path, bool random_access);
+  ~IndexedOFRecordPart();
+
+  int64_t record_num() const { return index_.record_num(); }
+  int64_t RecordSize(int64_t idx) const { return index_.At(idx).size; }
+  // nullptr if the part is not mapped
+  const char* MappedRecord(int64_t idx) const {
+    return mapped_ == nullptr ? nullptr : mapped_ + index_.At(idx).offset;
+  }
+  // dst must hold RecordSize(idx) bytes
+  void ReadRecord(int64_t idx, char* dst) const;
+
+ private:
+  OFRecordIndex index_;
+  std::unique_ptr<fs::RandomAccessFile> file_;
+  char* mapped_;
+  size_t mapped_size_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_RECORD_OFRECORD_INDEX_H_
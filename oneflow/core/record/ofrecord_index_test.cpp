@@ -0,0 +1,96 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/record/ofrecord_index.h"
+#include "oneflow/core/common/str_util.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+std::vector<std::string> WriteTestPart(fs::FileSystem* fs, const std::string& part_path) {
+  std::vector<std::string> records;
+  std::unique_ptr<fs::WritableFile> file;
+  fs->NewWritableFile(part_path, &file);
+  FOR_RANGE(int64_t, i, 1, 20) {
+    records.push_back(std::string(i * 7, static_cast<char>('a' + i)));
+    const int64_t size = records.back().size();
+    file->Append(reinterpret_cast<const char*>(&size), sizeof(size));
+    file->Append(records.back().data(), records.back().size());
+  }
+  file->Close();
+  return records;
+}
+
+void CheckPart(fs::FileSystem* fs, const std::string& part_path,
+               const std::vector<std::string>& records) {
+  IndexedOFRecordPart part(fs, part_path, true);
+  ASSERT_EQ(part.record_num(), records.size());
+  FOR_RANGE(int64_t, i, 0, records.size()) {
+    ASSERT_EQ(part.RecordSize(i), records.at(i).size());
+    std::string record(part.RecordSize(i), '\0');
+    part.ReadRecord(i, &record.at(0));
+    ASSERT_EQ(record, records.at(i));
+    ASSERT_EQ(std::string(part.MappedRecord(i), part.RecordSize(i)), records.at(i));
+  }
+}
+
+}  // namespace
+
+TEST(OFRecordIndex, build_save_load) {
+  fs::FileSystem* fs = LocalFS();
+  const std::string dir = JoinPath("/tmp", "ofrecord_index_test_" + NewUniqueId());
+  fs->RecursivelyCreateDir(dir);
+  const std::string part_path = JoinPath(dir, "part-0");
+  const std::vector<std::string> records = WriteTestPart(fs, part_path);
+
+  // without an index file the part is scanned
+  CheckPart(fs, part_path, records);
+  OFRecordIndex index;
+  index.Build(fs, part_path);
+  index.Save(fs, OFRecordIndex::IndexFilePath(part_path));
+  OFRecordIndex loaded;
+  loaded.Load(fs, OFRecordIndex::IndexFilePath(part_path));
+  ASSERT_EQ(loaded.record_num(), records.size());
+  ASSERT_EQ(loaded.alignment(), 1);
+  FOR_RANGE(int64_t, i, 0, records.size()) {
+    ASSERT_EQ(loaded.At(i).offset, index.At(i).offset);
+    ASSERT_EQ(loaded.At(i).size, index.At(i).size);
+  }
+  CheckPart(fs, part_path, records);
+  fs->RecursivelyDeleteDir(dir);
+}
+
+TEST(OFRecordIndex, pack) {
+  fs::FileSystem* fs = LocalFS();
+  const std::string dir = JoinPath("/tmp", "ofrecord_index_test_" + NewUniqueId());
+  fs->RecursivelyCreateDir(dir);
+  const std::string part_path = JoinPath(dir, "part-0");
+  const std::string packed_path = JoinPath(dir, "packed-0");
+  const std::vector<std::string> records = WriteTestPart(fs, part_path);
+  PackOFRecordPart(fs, part_path, packed_path, 64);
+  OFRecordIndex index;
+  index.Load(fs, OFRecordIndex::IndexFilePath(packed_path));
+  ASSERT_EQ(index.alignment(), 64);
+  FOR_RANGE(int64_t, i, 0, index.record_num()) { ASSERT_EQ(index.At(i).offset % 64, 0); }
+  CheckPart(fs, packed_path, records);
+  fs->RecursivelyDeleteDir(dir);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
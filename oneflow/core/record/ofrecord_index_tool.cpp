@@ -0,0 +1,49 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/record/ofrecord_index.h"
+
+// Usage:
+//   ofrecord_index_tool part-00000 part-00001 ...
+//     writes part-xxxxx.index next to every part, the parts are left untouched
+//   ofrecord_index_tool --pack_dir=/data/packed --alignment=4096 part-00000 ...
+//     writes a copy of every part in the packed layout, plus its index, to pack_dir
+DEFINE_string(pack_dir, "", "write packed copies of the parts to this directory");
+DEFINE_int64(alignment, 8, "alignment of every record in the packed parts");
+
+int main(int argc, char* argv[]) {
+  using namespace oneflow;
+  gflags::SetUsageMessage("ofrecord_index_tool [--pack_dir=DIR --alignment=N] PART...");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  CHECK_GT(argc, 1) << gflags::ProgramUsage();
+  fs::FileSystem* fs = LocalFS();
+  if (!FLAGS_pack_dir.empty()) { fs->RecursivelyCreateDirIfNotExist(FLAGS_pack_dir); }
+  FOR_RANGE(int, i, 1, argc) {
+    const std::string part_path = argv[i];
+    if (FLAGS_pack_dir.empty()) {
+      OFRecordIndex index;
+      index.Build(fs, part_path);
+      index.Save(fs, OFRecordIndex::IndexFilePath(part_path));
+      LOG(INFO) << part_path << ": " << index.record_num() << " records indexed";
+    } else {
+      const std::string packed_path = JoinPath(FLAGS_pack_dir, Basename(part_path));
+      PackOFRecordPart(fs, part_path, packed_path, FLAGS_alignment);
+      LOG(INFO) << part_path << " packed to " << packed_path;
+    }
+  }
+  return 0;
+}
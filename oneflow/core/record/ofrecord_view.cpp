@@ -0,0 +1,345 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/record/ofrecord_view.h"
+
+namespace oneflow {
+
+namespace {
+
+enum WireType {
+  kVarint = 0,
+  kFixed64 = 1,
+  kLengthDelimited = 2,
+  kFixed32 = 5,
+};
+
+class WireReader final {
+ public:
+  WireReader(const char* data, size_t size)
+      : cur_(reinterpret_cast<const uint8_t*>(data)), end_(cur_ + size) {}
+  ~WireReader() = default;
+
+  bool eof() const { return cur_ == end_; }
+
+  bool ReadVarint(uint64_t* val) {
+    uint64_t ret = 0;
+    for (int shift = 0; shift < 64 && cur_ < end_; shift += 7) {
+      const uint8_t byte = *cur_++;
+      ret |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        *val = ret;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool ReadTag(uint32_t* field, int* wire_type) {
+    uint64_t tag = 0;
+    if (!ReadVarint(&tag)) { return false; }
+    *field = static_cast<uint32_t>(tag >> 3);
+    *wire_type = static_cast<int>(tag & 0x7);
+    return *field != 0;
+  }
+
+  // Returns the still encoded payload of a field, e.g. the varint bytes for kVarint
+  bool ReadRaw(int wire_type, const char** data, size_t* size) {
+    const uint8_t* begin = cur_;
+    switch (wire_type) {
+      case kVarint: {
+        uint64_t val = 0;
+        if (!ReadVarint(&val)) { return false; }
+        *data = reinterpret_cast<const char*>(begin);
+        *size = cur_ - begin;
+        return true;
+      }
+      case kFixed64: return ReadBytes(8, data, size);
+      case kFixed32: return ReadBytes(4, data, size);
+      case kLengthDelimited: {
+        uint64_t len = 0;
+        if (!ReadVarint(&len)) { return false; }
+        return ReadBytes(len, data, size);
+      }
+      // groups are never used by record.proto
+      default: return false;
+    }
+  }
+
+ private:
+  bool ReadBytes(uint64_t len, const char** data, size_t* size) {
+    if (len > static_cast<uint64_t>(end_ - cur_)) { return false; }
+    *data = reinterpret_cast<const char*>(cur_);
+    *size = len;
+    cur_ += len;
+    return true;
+  }
+
+  const uint8_t* cur_;
+  const uint8_t* end_;
+};
+
+int ElemWireType(FeatureView::KindCase kind_case) {
+  switch (kind_case) {
+    case FeatureView::kFloatList: return kFixed32;
+    case FeatureView::kDoubleList: return kFixed64;
+    case FeatureView::kInt32List:
+    case FeatureView::kInt64List: return kVarint;
+    default: UNIMPLEMENTED(); return -1;
+  }
+}
+
+// Calls Handler(run, run_size) for every run of encoded values of a numeric list. Packed and
+// unpacked encodings are both accepted, as the protobuf parser does.
+template<typename HandlerT>
+bool ForEachValueRun(FeatureView::KindCase kind_case, const char* data, size_t size,
+                     const HandlerT& Handler) {
+  const int elem_wire_type = ElemWireType(kind_case);
+  WireReader reader(data, size);
+  while (!reader.eof()) {
+    uint32_t field = 0;
+    int wire_type = 0;
+    const char* run = nullptr;
+    size_t run_size = 0;
+    if (!reader.ReadTag(&field, &wire_type)) { return false; }
+    if (!reader.ReadRaw(wire_type, &run, &run_size)) { return false; }
+    if (field != 1) { continue; }
+    if (wire_type != kLengthDelimited && wire_type != elem_wire_type) { return false; }
+    if (!Handler(run, run_size)) { return false; }
+  }
+  return true;
+}
+
+bool CountValues(FeatureView::KindCase kind_case, const char* run, size_t run_size,
+                 int64_t* cnt) {
+  const int elem_wire_type = ElemWireType(kind_case);
+  if (elem_wire_type == kVarint) {
+    if (run_size > 0 && (static_cast<uint8_t>(run[run_size - 1]) & 0x80) != 0) { return false; }
+    FOR_RANGE(size_t, i, 0, run_size) {
+      if ((static_cast<uint8_t>(run[i]) & 0x80) == 0) { *cnt += 1; }
+    }
+  } else {
+    const size_t elem_size = elem_wire_type == kFixed32 ? 4 : 8;
+    if (run_size % elem_size != 0) { return false; }
+    *cnt += run_size / elem_size;
+  }
+  return true;
+}
+
+// Fixed width values are stored little endian on the wire, the same as every host we build for,
+// so a run of them can be copied as is.
+template<typename Src, typename T>
+typename std::enable_if<std::is_same<Src, T>::value, int64_t>::type CopyFixedRun(
+    const char* run, size_t run_size, T* dst, int64_t max_cnt) {
+  const int64_t cnt = std::min<int64_t>(run_size / sizeof(Src), max_cnt);
+  std::memcpy(dst, run, cnt * sizeof(Src));
+  return cnt;
+}
+
+template<typename Src, typename T>
+typename std::enable_if<!std::is_same<Src, T>::value, int64_t>::type CopyFixedRun(
+    const char* run, size_t run_size, T* dst, int64_t max_cnt) {
+  const int64_t cnt = std::min<int64_t>(run_size / sizeof(Src), max_cnt);
+  FOR_RANGE(int64_t, i, 0, cnt) {
+    Src val;
+    std::memcpy(&val, run + i * sizeof(Src), sizeof(Src));
+    dst[i] = static_cast<T>(val);
+  }
+  return cnt;
+}
+
+template<typename Src, typename T>
+int64_t CopyVarintRun(const char* run, size_t run_size, T* dst, int64_t max_cnt) {
+  WireReader reader(run, run_size);
+  int64_t cnt = 0;
+  uint64_t val = 0;
+  while (cnt < max_cnt && !reader.eof()) {
+    CHECK(reader.ReadVarint(&val));
+    dst[cnt++] = static_cast<T>(static_cast<Src>(val));
+  }
+  return cnt;
+}
+
+template<typename T>
+int64_t CopyRun(FeatureView::KindCase kind_case, const char* run, size_t run_size, T* dst,
+                int64_t max_cnt) {
+  switch (kind_case) {
+    case FeatureView::kFloatList: return CopyFixedRun<float, T>(run, run_size, dst, max_cnt);
+    case FeatureView::kDoubleList: return CopyFixedRun<double, T>(run, run_size, dst, max_cnt);
+    case FeatureView::kInt32List: return CopyVarintRun<int32_t, T>(run, run_size, dst, max_cnt);
+    case FeatureView::kInt64List: return CopyVarintRun<int64_t, T>(run, run_size, dst, max_cnt);
+    default: UNIMPLEMENTED(); return 0;
+  }
+}
+
+bool ParseMapEntry(const char* data, size_t size, const char** key, size_t* key_size,
+                   const char** feature, size_t* feature_size) {
+  *key = nullptr;
+  *key_size = 0;
+  *feature = nullptr;
+  *feature_size = 0;
+  WireReader reader(data, size);
+  while (!reader.eof()) {
+    uint32_t field = 0;
+    int wire_type = 0;
+    const char* payload = nullptr;
+    size_t payload_size = 0;
+    if (!reader.ReadTag(&field, &wire_type)) { return false; }
+    if (!reader.ReadRaw(wire_type, &payload, &payload_size)) { return false; }
+    if (field != 1 && field != 2) { continue; }
+    if (wire_type != kLengthDelimited) { return false; }
+    if (field == 1) {
+      *key = payload;
+      *key_size = payload_size;
+    } else {
+      *feature = payload;
+      *feature_size = payload_size;
+    }
+  }
+  return true;
+}
+
+bool ParseFeature(const char* data, size_t size, FeatureView* view) {
+  FeatureView::KindCase kind_case = FeatureView::kKindNotSet;
+  const char* list = nullptr;
+  size_t list_size = 0;
+  WireReader reader(data, size);
+  while (!reader.eof()) {
+    uint32_t field = 0;
+    int wire_type = 0;
+    const char* payload = nullptr;
+    size_t payload_size = 0;
+    if (!reader.ReadTag(&field, &wire_type)) { return false; }
+    if (!reader.ReadRaw(wire_type, &payload, &payload_size)) { return false; }
+    if (field < FeatureView::kBytesList || field > FeatureView::kInt64List) { continue; }
+    if (wire_type != kLengthDelimited) { return false; }
+    // the last member of a oneof on the wire wins
+    kind_case = static_cast<FeatureView::KindCase>(field);
+    list = payload;
+    list_size = payload_size;
+  }
+  return view->Reset(kind_case, list, list_size);
+}
+
+}  // namespace
+
+bool FeatureView::Reset(KindCase kind_case, const char* data, size_t size) {
+  kind_case_ = kind_case;
+  data_ = data;
+  size_ = size;
+  value_size_ = 0;
+  if (kind_case == kKindNotSet) { return true; }
+  if (kind_case == kBytesList) {
+    WireReader reader(data, size);
+    while (!reader.eof()) {
+      uint32_t field = 0;
+      int wire_type = 0;
+      const char* value = nullptr;
+      size_t value_size = 0;
+      if (!reader.ReadTag(&field, &wire_type)) { return false; }
+      if (!reader.ReadRaw(wire_type, &value, &value_size)) { return false; }
+      if (field != 1) { continue; }
+      if (wire_type != kLengthDelimited) { return false; }
+      value_size_ += 1;
+    }
+    return true;
+  }
+  return ForEachValueRun(kind_case, data, size, [&](const char* run, size_t run_size) {
+    return CountValues(kind_case, run, run_size, &value_size_);
+  });
+}
+
+void FeatureView::GetBytesValue(int64_t idx, const char** data, size_t* size) const {
+  CHECK(has_bytes_list());
+  CHECK_GE(idx, 0);
+  CHECK_LT(idx, value_size_);
+  WireReader reader(data_, size_);
+  int64_t cur = 0;
+  while (!reader.eof()) {
+    uint32_t field = 0;
+    int wire_type = 0;
+    CHECK(reader.ReadTag(&field, &wire_type));
+    CHECK(reader.ReadRaw(wire_type, data, size));
+    if (field != 1) { continue; }
+    if (cur == idx) { return; }
+    cur += 1;
+  }
+  UNIMPLEMENTED();
+}
+
+template<typename T>
+void FeatureView::CopyValues(T* dst, int64_t cnt) const {
+  CHECK(kind_case_ != kKindNotSet && kind_case_ != kBytesList);
+  CHECK_LE(cnt, value_size_);
+  int64_t copied = 0;
+  CHECK(ForEachValueRun(kind_case_, data_, size_, [&](const char* run, size_t run_size) {
+    if (copied < cnt) { copied += CopyRun(kind_case_, run, run_size, dst + copied, cnt - copied); }
+    return true;
+  }));
+  CHECK_EQ(copied, cnt);
+}
+
+#define INSTANTIATE_FEATURE_VIEW_COPY_VALUES(T) \
+  template void FeatureView::CopyValues<T>(T*, int64_t) const;
+INSTANTIATE_FEATURE_VIEW_COPY_VALUES(char)
+INSTANTIATE_FEATURE_VIEW_COPY_VALUES(float)
+INSTANTIATE_FEATURE_VIEW_COPY_VALUES(double)
+INSTANTIATE_FEATURE_VIEW_COPY_VALUES(int8_t)
+INSTANTIATE_FEATURE_VIEW_COPY_VALUES(int32_t)
+INSTANTIATE_FEATURE_VIEW_COPY_VALUES(int64_t)
+INSTANTIATE_FEATURE_VIEW_COPY_VALUES(uint8_t)
+#undef INSTANTIATE_FEATURE_VIEW_COPY_VALUES
+
+bool OFRecordView::Parse(const char* data, size_t size) {
+  std::fill(found_.begin(), found_.end(), 0);
+  WireReader reader(data, size);
+  while (!reader.eof()) {
+    uint32_t field = 0;
+    int wire_type = 0;
+    const char* entry = nullptr;
+    size_t entry_size = 0;
+    if (!reader.ReadTag(&field, &wire_type)) { return false; }
+    if (!reader.ReadRaw(wire_type, &entry, &entry_size)) { return false; }
+    if (field != 1) { continue; }
+    if (wire_type != kLengthDelimited) { return false; }
+    const char* key = nullptr;
+    size_t key_size = 0;
+    const char* feature = nullptr;
+    size_t feature_size = 0;
+    if (!ParseMapEntry(entry, entry_size, &key, &key_size, &feature, &feature_size)) {
+      return false;
+    }
+    FOR_RANGE(size_t, i, 0, keys_.size()) {
+      const std::string& wanted = keys_.at(i);
+      if (wanted.size() != key_size
+          || (key_size > 0 && std::memcmp(wanted.data(), key, key_size) != 0)) {
+        continue;
+      }
+      // a repeated key replaces the earlier entry, as in a parsed protobuf map
+      if (!ParseFeature(feature, feature_size, &features_.at(i))) { return false; }
+      found_.at(i) = 1;
+    }
+  }
+  return true;
+}
+
+const FeatureView* OFRecordView::Find(const std::string& key) const {
+  FOR_RANGE(size_t, i, 0, keys_.size()) {
+    if (keys_.at(i) == key) { return FeatureAt(i); }
+  }
+  return nullptr;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,87 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_RECORD_OFRECORD_VIEW_H_
+#define ONEFLOW_CORE_RECORD_OFRECORD_VIEW_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// Read-only view of one Feature inside a serialized OFRecord. It points into the buffer the
+// record was scanned from and is only valid while that buffer is alive.
+class FeatureView final {
+ public:
+  // same numbering as the `kind` oneof of Feature in record.proto
+  enum KindCase {
+    kKindNotSet = 0,
+    kBytesList = 1,
+    kFloatList = 2,
+    kDoubleList = 3,
+    kInt32List = 4,
+    kInt64List = 5,
+  };
+
+  FeatureView() : kind_case_(kKindNotSet), data_(nullptr), size_(0), value_size_(0) {}
+  ~FeatureView() = default;
+
+  // data/size is the serialized XxxList message; returns false if it is malformed
+  bool Reset(KindCase kind_case, const char* data, size_t size);
+
+  KindCase kind_case() const { return kind_case_; }
+  bool has_bytes_list() const { return kind_case_ == kBytesList; }
+  int64_t value_size() const { return value_size_; }
+
+  // bytes_list only
+  void GetBytesValue(int64_t idx, const char** data, size_t* size) const;
+  // numeric lists only, converts the first cnt values to T
+  template<typename T>
+  void CopyValues(T* dst, int64_t cnt) const;
+
+ private:
+  KindCase kind_case_;
+  const char* data_;
+  size_t size_;
+  int64_t value_size_;
+};
+
+// Scans the wire format of a serialized OFRecord once and indexes only the requested keys.
+// Features of other keys are skipped without being decoded, and nothing is copied out of the
+// source buffer. `keys` must outlive the view.
+class OFRecordView final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(OFRecordView);
+  explicit OFRecordView(const std::vector<std::string>& keys)
+      : keys_(keys), features_(keys.size()), found_(keys.size()) {}
+  ~OFRecordView() = default;
+
+  // returns false if data is not a well formed OFRecord
+  bool Parse(const char* data, size_t size);
+
+  // nullptr if the record has no feature for keys[key_idx]
+  const FeatureView* FeatureAt(int64_t key_idx) const {
+    return found_.at(key_idx) ? &features_.at(key_idx) : nullptr;
+  }
+  const FeatureView* Find(const std::string& key) const;
+
+ private:
+  const std::vector<std::string>& keys_;
+  std::vector<FeatureView> features_;
+  std::vector<char> found_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_RECORD_OFRECORD_VIEW_H_
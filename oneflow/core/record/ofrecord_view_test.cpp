@@ -0,0 +1,102 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/record/ofrecord_view.h"
+#include "oneflow/core/record/record.pb.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+OFRecord NewTestRecord() {
+  OFRecord record;
+  auto* feature = record.mutable_feature();
+  (*feature)["image"].mutable_bytes_list()->add_value(std::string(1000, 'x'));
+  (*feature)["label"].mutable_int32_list()->add_value(-3);
+  (*feature)["label"].mutable_int32_list()->add_value(300);
+  (*feature)["bbox"].mutable_float_list()->add_value(0.5f);
+  (*feature)["bbox"].mutable_float_list()->add_value(1.25f);
+  (*feature)["id"].mutable_int64_list()->add_value(int64_t(1) << 40);
+  (*feature)["score"].mutable_double_list()->add_value(0.125);
+  (*feature)["empty"];
+  return record;
+}
+
+}  // namespace
+
+TEST(OFRecordView, index_requested_keys_only) {
+  const std::string serialized = NewTestRecord().SerializeAsString();
+  const std::vector<std::string> keys{"label", "missing", "bbox"};
+  OFRecordView view(keys);
+  ASSERT_TRUE(view.Parse(serialized.data(), serialized.size()));
+  ASSERT_EQ(view.FeatureAt(1), nullptr);
+  ASSERT_EQ(view.Find("image"), nullptr);
+
+  const FeatureView* label = view.FeatureAt(0);
+  ASSERT_NE(label, nullptr);
+  ASSERT_EQ(label->kind_case(), FeatureView::kInt32List);
+  ASSERT_EQ(label->value_size(), 2);
+  int64_t label_val[2];
+  label->CopyValues(label_val, 2);
+  ASSERT_EQ(label_val[0], -3);
+  ASSERT_EQ(label_val[1], 300);
+
+  const FeatureView* bbox = view.Find("bbox");
+  ASSERT_NE(bbox, nullptr);
+  ASSERT_EQ(bbox->kind_case(), FeatureView::kFloatList);
+  float bbox_val[2];
+  bbox->CopyValues(bbox_val, 2);
+  ASSERT_EQ(bbox_val[0], 0.5f);
+  ASSERT_EQ(bbox_val[1], 1.25f);
+}
+
+TEST(OFRecordView, all_kinds) {
+  const OFRecord record = NewTestRecord();
+  const std::string serialized = record.SerializeAsString();
+  const std::vector<std::string> keys{"image", "id", "score", "empty"};
+  OFRecordView view(keys);
+  ASSERT_TRUE(view.Parse(serialized.data(), serialized.size()));
+
+  const FeatureView* image = view.Find("image");
+  ASSERT_TRUE(image->has_bytes_list());
+  ASSERT_EQ(image->value_size(), 1);
+  const char* data = nullptr;
+  size_t size = 0;
+  image->GetBytesValue(0, &data, &size);
+  ASSERT_EQ(std::string(data, size), record.feature().at("image").bytes_list().value(0));
+  // points into the serialized buffer instead of a copy
+  ASSERT_TRUE(data >= serialized.data() && data + size <= serialized.data() + serialized.size());
+
+  int64_t id = 0;
+  view.Find("id")->CopyValues(&id, 1);
+  ASSERT_EQ(id, int64_t(1) << 40);
+  double score = 0;
+  view.Find("score")->CopyValues(&score, 1);
+  ASSERT_EQ(score, 0.125);
+  ASSERT_EQ(view.Find("empty")->kind_case(), FeatureView::kKindNotSet);
+}
+
+TEST(OFRecordView, malformed) {
+  const std::string serialized = NewTestRecord().SerializeAsString();
+  const std::vector<std::string> keys{"label"};
+  OFRecordView view(keys);
+  ASSERT_FALSE(view.Parse(serialized.data(), serialized.size() - 1));
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -30,6 +30,8 @@ Regst::Regst() {
   status_.max_col_id = 0;
   regst_desc_ = nullptr;
   comm_net_token_ = nullptr;
+  comm_net_mem_ptr_ = nullptr;
+  comm_net_mem_byte_size_ = 0;
 }
 
 Regst::~Regst() {
@@ -53,6 +55,23 @@ void Regst::set_regst_desc(const RtRegstDesc* regst_desc) {
   status_.regst_desc_id = regst_desc_->regst_desc_id();
 }
 
+size_t Regst::CommNetValidByteSize() const {
+  if (comm_net_token_ == nullptr) { return 0; }
+  size_t valid_byte_size = 0;
+  if (packed_blob_->header_ptr() == comm_net_mem_ptr_) {
+    valid_byte_size = packed_blob_->blob_desc().ByteSizeOfBlobHeader();
+  }
+  if (!regst_desc_->is_body_disabled()) {
+    for (const auto& pair : lbi2blob_) {
+      const Blob* blob = pair.second.get();
+      const size_t body_offset = static_cast<const char*>(blob->dptr()) - comm_net_mem_ptr_;
+      valid_byte_size = std::max(valid_byte_size, body_offset + blob->ByteSizeOfBlobBody());
+    }
+  }
+  CHECK_LE(valid_byte_size, comm_net_mem_byte_size_);
+  return valid_byte_size;
+}
+
 Blob* Regst::GetMutSoleBlob() {
   CHECK_EQ(GetBlobSize(), 1);
   return lbi2blob_.begin()->second.get();
@@ -49,6 +49,8 @@ class Regst final {
   const std::vector<int64_t>& consumers_actor_id() const;
   const RtRegstDesc* regst_desc() const { return regst_desc_; }
   Blob* GetBlobByLbi(const LogicalBlobId& lbi);
+  // index from RtRegstDesc::GetBlobIndexFromLbi, resolved without hashing the lbi
+  Blob* GetBlobByIndex(int64_t index) { return index2blob_.at(index); }
   const Blob* GetSoleBlob() const;
   Blob* GetMutSoleBlob();
   int64_t GetBlobSize() const { return lbi2blob_.size(); }
@@ -56,6 +58,9 @@ class Regst final {
   Blob* packed_blob() { return packed_blob_.get(); }
   bool IsMaxCol() const { return col_id() == max_col_id(); }
   void* comm_net_token() const { return comm_net_token_; }
+  // bytes of the network-registered memory actually holding data: headers plus the valid
+  // (dynamic) part of every body, laid out from the start of the regst's main memory
+  size_t CommNetValidByteSize() const;
 
   // Setters
   void set_piece_id(int64_t val) { status_.piece_id = val; }
@@ -70,9 +75,12 @@ class Regst final {
   void set_regst_desc(const RtRegstDesc* regst_desc);
 
   void* comm_net_token_;
+  const char* comm_net_mem_ptr_;
+  size_t comm_net_mem_byte_size_;
   RegstStatus status_;
   const RtRegstDesc* regst_desc_;
   HashMap<LogicalBlobId, std::unique_ptr<Blob>> lbi2blob_;
+  std::vector<Blob*> index2blob_;
   std::unique_ptr<Blob> packed_blob_;
 };
 
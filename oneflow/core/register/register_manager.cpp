@@ -103,6 +103,17 @@ void RegstMgr::NewRegsts(const RegstDescProto& regst_desc_proto,
         CheckBlobInRegstNotDisabled(regst_desc_proto);
         regst->comm_net_token_ = Global<CommNet>::Get()->RegisterMemory(
             main_mem_ptr, rt_regst_desc->MainByteSize4OneRegst());
+        regst->comm_net_mem_ptr_ = main_mem_ptr;
+        regst->comm_net_mem_byte_size_ = rt_regst_desc->MainByteSize4OneRegst();
+        if (regst_desc_proto.comm_net_codec() != CommNetCodec::kNoCommNetCodec) {
+          const size_t raw_prefix_byte_size =
+              rt_regst_desc->SeparatedHeaderByteSize4OneRegst() > 0
+                  ? 0
+                  : rt_regst_desc->packed_blob_desc()->ByteSizeOfBlobHeader();
+          Global<CommNet>::Get()->SetMemoryCodec(regst->comm_net_token_,
+                                                 regst_desc_proto.comm_net_codec(),
+                                                 raw_prefix_byte_size);
+        }
       }
       if (main_mem_ptr != nullptr) { main_mem_ptr += rt_regst_desc->MainByteSize4OneRegst(); }
       if (separated_header_mem_ptr != nullptr) {
@@ -146,6 +157,7 @@ void RegstMgr::NewBlobsInOneRegst(const std::vector<LbiBlobDescPair>& lbis, Regs
       cur_body_pointer = main_mem_ptr + packed_blob_desc->ByteSizeOfBlobHeader();
     }
   }
+  regst->index2blob_.resize(rt_regst_desc->blob_num(), nullptr);
   rt_regst_desc->ForEachBlobDescOffsetInOnRegst(
       lbis, [&](const LbiBlobDescPair& lbi, int64_t body_offset, int64_t header_offset) {
         const RtBlobDesc* blob_desc = rt_regst_desc->GetRtBlobDescFromLbi(lbi.lbi());
@@ -161,10 +173,15 @@ void RegstMgr::NewBlobsInOneRegst(const std::vector<LbiBlobDescPair>& lbis, Regs
                                                       cur_body_pointer + body_offset));
           InitNonPODTypeBlobIfNeed(Global<MemoryAllocator>::Get(), blob_ptr.get());
         }
+        regst->index2blob_.at(rt_regst_desc->GetBlobIndexFromLbi(lbi.lbi())) = blob_ptr.get();
         CHECK(regst->lbi2blob_.emplace(lbi.lbi(), std::move(blob_ptr)).second);
       });
 }
 
+bool RegstMgr::HasRegstDescId(int64_t regst_desc_id) const {
+  return regst_desc_id2rt_regst_desc_.find(regst_desc_id) != regst_desc_id2rt_regst_desc_.end();
+}
+
 const RtRegstDesc& RegstMgr::RegstDesc4RegstDescId(int64_t regst_desc_id) const {
   const auto& it = regst_desc_id2rt_regst_desc_.find(regst_desc_id);
   CHECK(it != regst_desc_id2rt_regst_desc_.end());
@@ -32,6 +32,7 @@ class RegstMgr final {
   ~RegstMgr() = default;
 
   void NewRegsts(const RegstDescProto& regst_desc_proto, std::function<void(Regst*)> OneRegstDone);
+  bool HasRegstDescId(int64_t regst_desc_id) const;
   const RtRegstDesc& RegstDesc4RegstDescId(int64_t regst_desc_id) const;
 
  private:
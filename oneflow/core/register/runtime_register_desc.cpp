@@ -30,6 +30,8 @@ RtRegstDesc::RtRegstDesc(const RegstDescProto& proto) {
     for (const LbiBlobDescPair& pair : data_regst_desc.lbi2blob_desc()) {
       auto blob_desc = std::make_unique<RtBlobDesc>(pair.blob_desc());
       CHECK(lbi2blob_desc_.emplace(pair.lbi(), std::move(blob_desc)).second);
+      const int64_t blob_index = lbi2blob_index_.size();
+      CHECK(lbi2blob_index_.emplace(pair.lbi(), blob_index).second);
     }
     packed_blob_desc_.reset(new RtBlobDesc(data_regst_desc.packed_blob_desc()));
     CHECK(data_regst_desc.has_time_shape());
@@ -49,6 +51,12 @@ const RtBlobDesc* RtRegstDesc::GetRtBlobDescFromLbi(const LogicalBlobId& lbi) co
   }
 }
 
+int64_t RtRegstDesc::GetBlobIndexFromLbi(const LogicalBlobId& lbi) const {
+  auto it = lbi2blob_index_.find(lbi);
+  if (it == lbi2blob_index_.end()) { return -1; }
+  return it->second;
+}
+
 size_t RtRegstDesc::TotalByteSize4AllRegst() const {
   return packed_blob_desc_->AlignedTotalByteSize() * register_num_;
 }
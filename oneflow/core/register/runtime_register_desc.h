@@ -38,6 +38,10 @@ class RtRegstDesc {
   const RegstDescTypeProto& regst_desc_type() const { return regst_desc_type_; }
 
   const RtBlobDesc* GetRtBlobDescFromLbi(const LogicalBlobId& lbi) const;
+  // position of the blob of lbi in a Regst, see Regst::GetBlobByIndex. -1 if lbi is not one of
+  // the blobs, e.g. the packed id
+  int64_t GetBlobIndexFromLbi(const LogicalBlobId& lbi) const;
+  int64_t blob_num() const { return lbi2blob_index_.size(); }
   const RtBlobDesc* packed_blob_desc() const { return packed_blob_desc_.get(); }
   size_t TotalByteSize4AllRegst() const;
   size_t TotalMainByteSize4AllRegst() const;
@@ -60,6 +64,7 @@ class RtRegstDesc {
   RegstDescTypeProto regst_desc_type_;
   MemoryCase mem_case_;
   HashMap<LogicalBlobId, std::unique_ptr<RtBlobDesc>> lbi2blob_desc_;
+  HashMap<LogicalBlobId, int64_t> lbi2blob_index_;
   std::unique_ptr<RtBlobDesc> packed_blob_desc_;
   std::unique_ptr<Shape> data_regst_time_shape_;
 };
@@ -20,12 +20,25 @@ namespace oneflow {
 OneflowVM::OneflowVM(const Resource& resource, int64_t this_machine_id)
     : vm_(ObjectMsgPtr<vm::VirtualMachine>::New(vm::MakeVmDesc(resource, this_machine_id).Get())) {
   OBJECT_MSG_LIST_UNSAFE_FOR_EACH_PTR(vm_->mut_thread_ctx_list(), thread_ctx) {
-    auto thread_pool = std::make_unique<ThreadPool>(1);
-    CHECK(thread_ctx2thread_pool_.emplace(thread_ctx, std::move(thread_pool)).second);
+    if (resource.enable_vm_loop_run_worker()) {
+      loop_run_workers_.emplace_back([thread_ctx]() { thread_ctx->LoopRun(); });
+    } else {
+      auto thread_pool = std::make_unique<ThreadPool>(1);
+      CHECK(thread_ctx2thread_pool_.emplace(thread_ctx, std::move(thread_pool)).second);
+    }
   }
 }
 
+OneflowVM::~OneflowVM() {
+  if (loop_run_workers_.empty()) { return; }
+  OBJECT_MSG_LIST_UNSAFE_FOR_EACH_PTR(vm_->mut_thread_ctx_list(), thread_ctx) {
+    thread_ctx->mut_pending_instruction_list()->Close();
+  }
+  for (auto& worker : loop_run_workers_) { worker.join(); }
+}
+
 void OneflowVM::TryReceiveAndRun() {
+  // LoopRun workers are woken up by the scheduler handing over instructions
   for (auto& pair : thread_ctx2thread_pool_) {
     vm::ThreadCtx* thread_ctx = pair.first;
     if (thread_ctx->mut_pending_instruction_list()->Empty()) { continue; }
@@ -19,6 +19,7 @@ limitations under the License.
 #include "oneflow/core/vm/interpret_type.h"
 #include "oneflow/core/vm/vm_desc.msg.h"
 #include "oneflow/core/vm/virtual_machine.msg.h"
+#include <thread>
 #include "oneflow/core/thread/thread_pool.h"
 
 namespace oneflow {
@@ -33,7 +34,7 @@ class OneflowVM final {
   OneflowVM(const OneflowVM&) = delete;
   OneflowVM(OneflowVM&&) = delete;
   OneflowVM(const Resource& resource, int64_t this_machine_id);
-  ~OneflowVM() = default;
+  ~OneflowVM();
 
   vm::VirtualMachine* mut_vm() { return vm_.Mutable(); }
   void TryReceiveAndRun();
@@ -41,6 +42,8 @@ class OneflowVM final {
  private:
   ObjectMsgPtr<vm::VirtualMachine> vm_;
   HashMap<vm::ThreadCtx*, std::unique_ptr<ThreadPool>> thread_ctx2thread_pool_;
+  // one persistent ThreadCtx::LoopRun worker per thread ctx if enable_vm_loop_run_worker
+  std::vector<std::thread> loop_run_workers_;
 };
 
 }  // namespace oneflow
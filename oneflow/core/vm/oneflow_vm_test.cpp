@@ -0,0 +1,103 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+// include sstream first to avoid some compiling error
+// caused by the following trick
+// reference: https://gcc.gnu.org/bugzilla/show_bug.cgi?id=65899
+#include <sstream>
+#include <chrono>
+#include <future>
+#include <thread>
+#include "oneflow/core/vm/oneflow_vm.h"
+#include "oneflow/core/vm/vm_util.h"
+#include "oneflow/core/vm/virtual_machine.msg.h"
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/job/resource.pb.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace test {
+
+namespace {
+
+using InstructionMsgList = OBJECT_MSG_LIST(InstructionMsg, instr_msg_link);
+
+Resource NewCpuResource(bool enable_vm_loop_run_worker) {
+  Resource resource;
+  resource.set_machine_num(1);
+  resource.set_cpu_device_num(1);
+  resource.set_enable_vm_loop_run_worker(enable_vm_loop_run_worker);
+  return resource;
+}
+
+// submits instr_num Nop instructions in batches and schedules until all of them are done
+void RunNopInstructions(OneflowVM* oneflow_vm, int64_t instr_num, int64_t batch_size) {
+  VirtualMachine* vm = oneflow_vm->mut_vm();
+  for (int64_t i = 0; i < instr_num; i += batch_size) {
+    InstructionMsgList list;
+    FOR_RANGE(int64_t, j, i, std::min(i + batch_size, instr_num)) {
+      list.EmplaceBack(NewInstruction("Nop"));
+    }
+    vm->Receive(&list);
+    vm->Schedule();
+    oneflow_vm->TryReceiveAndRun();
+  }
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+  while (!vm->Empty()) {
+    ASSERT_LT(std::chrono::steady_clock::now(), deadline) << "instructions never completed";
+    vm->Schedule();
+    oneflow_vm->TryReceiveAndRun();
+  }
+}
+
+// destroys the vm on a detached thread, false if that does not return because the workers never
+// exit
+bool DestroyInTime(std::unique_ptr<OneflowVM>* oneflow_vm) {
+  OneflowVM* vm = oneflow_vm->release();
+  auto destroyed = std::make_shared<std::promise<void>>();
+  std::thread([vm, destroyed]() {
+    delete vm;
+    destroyed->set_value();
+  }).detach();
+  return destroyed->get_future().wait_for(std::chrono::seconds(60)) == std::future_status::ready;
+}
+
+void TestRunAndDestroy(bool enable_vm_loop_run_worker) {
+  auto oneflow_vm = std::make_unique<OneflowVM>(NewCpuResource(enable_vm_loop_run_worker), 0);
+  RunNopInstructions(oneflow_vm.get(), 1000, 64);
+  ASSERT_TRUE(oneflow_vm->mut_vm()->Empty());
+  // the vm stays usable after all submitted instructions are done
+  RunNopInstructions(oneflow_vm.get(), 10, 1);
+  ASSERT_TRUE(oneflow_vm->mut_vm()->Empty());
+  ASSERT_TRUE(DestroyInTime(&oneflow_vm));
+}
+
+}  // namespace
+
+TEST(OneflowVM, loop_run_worker) { TestRunAndDestroy(true); }
+
+TEST(OneflowVM, thread_pool) { TestRunAndDestroy(false); }
+
+TEST(OneflowVM, destroy_idle_loop_run_worker) {
+  auto oneflow_vm = std::make_unique<OneflowVM>(NewCpuResource(true), 0);
+  // the workers are parked on empty pending instruction lists
+  ASSERT_TRUE(DestroyInTime(&oneflow_vm));
+}
+
+}  // namespace test
+
+}  // namespace vm
+}  // namespace oneflow
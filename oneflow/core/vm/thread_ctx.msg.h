@@ -37,6 +37,10 @@ OBJECT_MSG_BEGIN(ThreadCtx);
   OBJECT_MSG_DEFINE_LIST_HEAD(Stream, thread_ctx_stream_link, stream_list);
   OBJECT_MSG_DEFINE_CONDITION_LIST_HEAD(Instruction, pending_instruction_link,
                                         pending_instruction_list);
+  // instructions dispatched in the current scheduling tick, handed over to
+  // pending_instruction_list as one batch. only accessed by the scheduler thread
+  OBJECT_MSG_DEFINE_LIST_HEAD(Instruction, pending_instruction_link,
+                              dispatched_instruction_list);
 
   OF_PRIVATE ObjectMsgConditionListStatus ReceiveAndRun();
   OF_PUBLIC ObjectMsgConditionListStatus TryReceiveAndRun();
@@ -0,0 +1,89 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+// include sstream first to avoid some compiling error
+// caused by the following trick
+// reference: https://gcc.gnu.org/bugzilla/show_bug.cgi?id=65899
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include "oneflow/core/vm/vm_util.h"
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/vm/virtual_machine.msg.h"
+#include "oneflow/core/vm/vm_desc.msg.h"
+#include "oneflow/core/vm/test_util.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace test {
+
+namespace {
+
+using InstructionMsgList = OBJECT_MSG_LIST(InstructionMsg, instr_msg_link);
+
+// returns instructions per second
+double RunNopInstructions(bool loop_run_worker, int64_t instr_num) {
+  auto vm_desc = ObjectMsgPtr<VmDesc>::New(TestUtil::NewVmResourceDesc().Get());
+  TestUtil::AddStreamDescByInstrNames(vm_desc.Mutable(), {"Nop"});
+  auto vm = ObjectMsgPtr<VirtualMachine>::New(vm_desc.Get());
+  HashMap<ThreadCtx*, std::unique_ptr<ThreadPool>> thread_ctx2thread_pool;
+  std::vector<std::thread> loop_run_workers;
+  OBJECT_MSG_LIST_UNSAFE_FOR_EACH_PTR(vm->mut_thread_ctx_list(), thread_ctx) {
+    if (loop_run_worker) {
+      loop_run_workers.emplace_back([thread_ctx]() { thread_ctx->LoopRun(); });
+    } else {
+      thread_ctx2thread_pool.emplace(thread_ctx, std::make_unique<ThreadPool>(1));
+    }
+  }
+  InstructionMsgList list;
+  FOR_RANGE(int64_t, i, 0, instr_num) { list.EmplaceBack(NewInstruction("Nop")); }
+  const auto start = std::chrono::steady_clock::now();
+  vm->Receive(&list);
+  while (!vm->Empty()) {
+    vm->Schedule();
+    for (auto& pair : thread_ctx2thread_pool) {
+      ThreadCtx* thread_ctx = pair.first;
+      if (thread_ctx->mut_pending_instruction_list()->Empty()) { continue; }
+      pair.second->AddWork([thread_ctx]() { thread_ctx->TryReceiveAndRun(); });
+    }
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  OBJECT_MSG_LIST_UNSAFE_FOR_EACH_PTR(vm->mut_thread_ctx_list(), thread_ctx) {
+    thread_ctx->mut_pending_instruction_list()->Close();
+  }
+  for (auto& worker : loop_run_workers) { worker.join(); }
+  thread_ctx2thread_pool.clear();
+  return instr_num / std::max(elapsed.count(), 1e-9);
+}
+
+}  // namespace
+
+// not run by default, run it with
+// --gtest_also_run_disabled_tests --gtest_filter=ThreadCtxBenchmark.*
+TEST(ThreadCtxBenchmark, DISABLED_loop_run_instruction_throughput) {
+  const int64_t instr_num = 100000;
+  const double thread_pool_throughput = RunNopInstructions(false, instr_num);
+  const double loop_run_throughput = RunNopInstructions(true, instr_num);
+  LOG(INFO) << "eager nop instructions per second, thread pool: " << thread_pool_throughput
+            << ", loop run worker: " << loop_run_throughput;
+  ASSERT_GT(loop_run_throughput, 0);
+}
+
+}  // namespace test
+
+}  // namespace vm
+}  // namespace oneflow
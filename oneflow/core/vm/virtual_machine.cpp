@@ -328,12 +328,17 @@ void VirtualMachine::DispatchAndPrescheduleInstructions(
     if (stream_type.SharingVirtualMachineThread()) {
       stream_type.Run(this, instruction);
     } else {
-      stream->mut_thread_ctx()->mut_pending_instruction_list()->PushBack(instruction);
+      stream->mut_thread_ctx()->mut_dispatched_instruction_list()->PushBack(instruction);
     }
     TryMoveWaitingToReady(instruction, &prescheduled,
                           [stream](Instruction* dst) { return &dst->stream() == stream; });
   }
   prescheduled.MoveTo(ready_instruction_list);
+  OBJECT_MSG_LIST_UNSAFE_FOR_EACH_PTR(mut_thread_ctx_list(), thread_ctx) {
+    auto* dispatched_instruction_list = thread_ctx->mut_dispatched_instruction_list();
+    if (dispatched_instruction_list->empty()) { continue; }
+    thread_ctx->mut_pending_instruction_list()->MoveFrom(dispatched_instruction_list);
+  }
 }
 
 template<typename ReadyList, typename IsEdgeReadyT>
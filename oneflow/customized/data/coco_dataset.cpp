@@ -23,7 +23,7 @@ namespace data {
 
 COCODataset::LoadTargetShdPtrVec COCODataset::At(int64_t index) const {
   LoadTargetShdPtrVec ret;
-  LoadTargetShdPtr sample(new COCOImage());
+  LoadTargetShdPtr sample = MakePooledShared<COCOImage>();
   sample->index = index;
   sample->id = meta_->GetImageId(index);
   sample->height = meta_->GetImageHeight(index);
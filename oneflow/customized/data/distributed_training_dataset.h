@@ -36,6 +36,7 @@ class DistributedTrainingDataset final : public Dataset<LoadTarget> {
         stride_partition_(stride_partition),
         rnd_seed_(random_seed),
         num_shards_(parallel_num),
+        shard_id_(parallel_id),
         pos_(0),
         pos_in_shard_(0),
         epoch_cnt_(0) {
@@ -48,6 +49,7 @@ class DistributedTrainingDataset final : public Dataset<LoadTarget> {
     index_seq_.resize(base_dataset_->Size());
     std::iota(index_seq_.begin(), index_seq_.end(), 0);
     GenNewIndexSequence();
+    CheckRanOutOfSize();
   }
   virtual ~DistributedTrainingDataset() = default;
 
@@ -77,16 +79,36 @@ class DistributedTrainingDataset final : public Dataset<LoadTarget> {
     return ret;
   }
 
+  // Jumps to where this shard is after it has returned num_samples samples since construction,
+  // e.g. to resume a job. The index sequence of an epoch only depends on the epoch number, so no
+  // sample has to be loaded to get there.
+  void Seek(int64_t num_samples) {
+    CHECK_GE(num_samples, 0);
+    int64_t stream_pos = 0;
+    if (stride_partition_) {
+      stream_pos = shard_id_ + num_samples * num_shards_;
+    } else {
+      pos_in_shard_ = num_samples % shard_size_;
+      stream_pos = (shard_id_ + num_samples / shard_size_ * num_shards_) * shard_size_
+                   + pos_in_shard_;
+    }
+    const int64_t size = index_seq_.size();
+    epoch_cnt_ = stream_pos / size;
+    pos_ = stream_pos % size;
+    GenNewIndexSequence();
+  }
+
  private:
   void CheckRanOutOfSize() {
-    if (pos_ >= index_seq_.size()) {
+    while (pos_ >= index_seq_.size()) {
       GenNewIndexSequence();
-      pos_ %= index_seq_.size();
+      pos_ -= index_seq_.size();
     }
   }
 
   void GenNewIndexSequence() {
     if (shuffle_) {
+      std::iota(index_seq_.begin(), index_seq_.end(), 0);
       std::mt19937 engine(rnd_seed_ + epoch_cnt_);
       std::shuffle(index_seq_.begin(), index_seq_.end(), engine);
     }
@@ -98,6 +120,7 @@ class DistributedTrainingDataset final : public Dataset<LoadTarget> {
   bool stride_partition_;
   int64_t rnd_seed_;
   int64_t num_shards_;
+  int64_t shard_id_;
   int64_t shard_size_;
   int64_t pos_;
   int64_t pos_in_shard_;
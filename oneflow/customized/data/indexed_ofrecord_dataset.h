@@ -0,0 +1,67 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CUSTOMIZED_DATA_INDEXED_OFRECORD_DATASET_H_
+#define ONEFLOW_CUSTOMIZED_DATA_INDEXED_OFRECORD_DATASET_H_
+
+#include "oneflow/customized/data/dataset.h"
+#include "oneflow/customized/data/ofrecord_dataset.h"
+#include "oneflow/core/record/ofrecord_index.h"
+
+namespace oneflow {
+namespace data {
+
+// All records of all parts, addressed by a global sample index through the part indices
+class IndexedOFRecordDataset final : public RandomAccessDataset<TensorBuffer> {
+ public:
+  using LoadTargetShdPtr = std::shared_ptr<TensorBuffer>;
+  using LoadTargetShdPtrVec = std::vector<LoadTargetShdPtr>;
+  OF_DISALLOW_COPY_AND_MOVE(IndexedOFRecordDataset);
+  IndexedOFRecordDataset(user_op::KernelInitContext* ctx) {
+    const bool random_access = ctx->Attr<bool>("random_shuffle");
+    part_offsets_.push_back(0);
+    for (const std::string& path : GetOFRecordPartFilePaths(ctx)) {
+      parts_.emplace_back(new IndexedOFRecordPart(DataFS(), path, random_access));
+      part_offsets_.push_back(part_offsets_.back() + parts_.back()->record_num());
+    }
+    CHECK_GT(part_offsets_.back(), 0) << "no record found";
+  }
+  ~IndexedOFRecordDataset() = default;
+
+  LoadTargetShdPtrVec At(int64_t index) const override {
+    const int64_t part_id =
+        std::upper_bound(part_offsets_.begin(), part_offsets_.end(), index) - part_offsets_.begin()
+        - 1;
+    const IndexedOFRecordPart* part = parts_.at(part_id).get();
+    const int64_t record_id = index - part_offsets_.at(part_id);
+    LoadTargetShdPtr sample = MakePooledShared<TensorBuffer>();
+    sample->Resize(Shape({part->RecordSize(record_id)}), DataType::kChar);
+    part->ReadRecord(record_id, sample->mut_data<char>());
+    LoadTargetShdPtrVec ret;
+    ret.push_back(std::move(sample));
+    return ret;
+  }
+
+  size_t Size() const override { return part_offsets_.back(); }
+
+ private:
+  std::vector<std::unique_ptr<IndexedOFRecordPart>> parts_;
+  std::vector<int64_t> part_offsets_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CUSTOMIZED_DATA_INDEXED_OFRECORD_DATASET_H_
@@ -18,6 +18,8 @@ limitations under the License.
 
 #include "oneflow/customized/data/data_reader.h"
 #include "oneflow/customized/data/ofrecord_dataset.h"
+#include "oneflow/customized/data/indexed_ofrecord_dataset.h"
+#include "oneflow/customized/data/distributed_training_dataset.h"
 #include "oneflow/customized/data/ofrecord_parser.h"
 #include "oneflow/customized/data/random_shuffle_dataset.h"
 #include "oneflow/customized/data/batch_dataset.h"
@@ -29,11 +31,27 @@ namespace data {
 class OFRecordDataReader final : public DataReader<TensorBuffer> {
  public:
   OFRecordDataReader(user_op::KernelInitContext* ctx) : DataReader<TensorBuffer>(ctx) {
-    loader_.reset(new OFRecordDataset(ctx));
-    parser_.reset(new OFRecordParser());
-    if (ctx->Attr<bool>("random_shuffle")) {
-      loader_.reset(new RandomShuffleDataset<TensorBuffer>(ctx, std::move(loader_)));
+    if (ctx->Attr<bool>("indexed")) {
+      // random_shuffle reshuffles all records globally every epoch, no shuffle buffer needed
+      int64_t seed = ctx->Attr<int64_t>("seed");
+      if (seed == -1) { seed = kOneflowDatasetSeed; }
+      const int64_t parallel_num = ctx->parallel_ctx().parallel_num();
+      std::unique_ptr<RandomAccessDataset<TensorBuffer>> indexed_dataset(
+          new IndexedOFRecordDataset(ctx));
+      auto* dataset = new DistributedTrainingDataset<TensorBuffer>(
+          parallel_num, ctx->parallel_ctx().parallel_id(), false, ctx->Attr<bool>("random_shuffle"),
+          seed, std::move(indexed_dataset));
+      const int64_t resume_sample_count = ctx->Attr<int64_t>("resume_sample_count");
+      CHECK_EQ(resume_sample_count % parallel_num, 0);
+      dataset->Seek(resume_sample_count / parallel_num);
+      loader_.reset(dataset);
+    } else {
+      loader_.reset(new OFRecordDataset(ctx));
+      if (ctx->Attr<bool>("random_shuffle")) {
+        loader_.reset(new RandomShuffleDataset<TensorBuffer>(ctx, std::move(loader_)));
+      }
     }
+    parser_.reset(new OFRecordParser());
     int32_t batch_size = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape().elem_cnt();
     loader_.reset(new BatchDataset<TensorBuffer>(batch_size, std::move(loader_)));
     StartLoadThread();
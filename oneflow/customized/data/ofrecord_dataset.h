@@ -26,6 +26,22 @@ limitations under the License.
 namespace oneflow {
 namespace data {
 
+inline std::vector<std::string> GetOFRecordPartFilePaths(user_op::KernelInitContext* ctx) {
+  int32_t data_part_num = ctx->Attr<int32_t>("data_part_num");
+  std::string data_dir = ctx->Attr<std::string>("data_dir");
+  std::string part_name_prefix = ctx->Attr<std::string>("part_name_prefix");
+  int32_t part_name_suffix_length = ctx->Attr<int32_t>("part_name_suffix_length");
+
+  std::vector<std::string> data_file_paths;
+  for (int i = 0; i < data_part_num; ++i) {
+    std::string num = std::to_string(i);
+    int32_t zero_count = std::max(part_name_suffix_length - static_cast<int32_t>(num.length()), 0);
+    data_file_paths.push_back(
+        JoinPath(data_dir, part_name_prefix + std::string(zero_count, '0') + num));
+  }
+  return data_file_paths;
+}
+
 class OFRecordDataset final : public Dataset<TensorBuffer> {
  public:
   using LoadTargetPtr = std::shared_ptr<TensorBuffer>;
@@ -37,17 +53,7 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
 
     // in stream
     data_part_num_ = ctx->Attr<int32_t>("data_part_num");
-    std::string data_dir = ctx->Attr<std::string>("data_dir");
-    std::string part_name_prefix = ctx->Attr<std::string>("part_name_prefix");
-    int32_t part_name_suffix_length = ctx->Attr<int32_t>("part_name_suffix_length");
-
-    for (int i = 0; i < data_part_num_; ++i) {
-      std::string num = std::to_string(i);
-      int32_t zero_count =
-          std::max(part_name_suffix_length - static_cast<int32_t>(num.length()), 0);
-      data_file_paths_.push_back(
-          JoinPath(data_dir, part_name_prefix + std::string(zero_count, '0') + num));
-    }
+    data_file_paths_ = GetOFRecordPartFilePaths(ctx);
 
     parallel_id_ = ctx->parallel_ctx().parallel_id();
     parallel_num_ = ctx->parallel_ctx().parallel_num();
@@ -63,7 +69,7 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
 
   LoadTargetPtrList Next() override {
     LoadTargetPtrList ret;
-    LoadTargetPtr sample_ptr(new TensorBuffer());
+    LoadTargetPtr sample_ptr = MakePooledShared<TensorBuffer>();
     ReadSample(*sample_ptr);
     ret.push_back(std::move(sample_ptr));
     return ret;
@@ -0,0 +1,270 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/customized/image/crop_mirror_normalize.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OF_IMAGE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kMaxSimdChannels = 4;
+constexpr int64_t kMaxSimdLanes = 16;
+
+enum class SimdLevel {
+  kNone = 0,
+  kAvx2 = 1,
+  kAvx512 = 2,
+};
+
+SimdLevel GetSimdLevel() {
+  static const SimdLevel level = []() {
+#ifdef OF_IMAGE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) { return SimdLevel::kAvx512; }
+    if (__builtin_cpu_supports("avx2")) { return SimdLevel::kAvx2; }
+#endif
+    return SimdLevel::kNone;
+  }();
+  return level;
+}
+
+// mean and inv_std of the k-th element of a row of HWC pixels, one vector per channel long, so
+// that a SIMD loop stepping C vectors at a time stays aligned to channel 0
+struct ChannelPattern {
+  ChannelPattern(int64_t C, const float* mean_vec, const float* inv_std_vec)
+      : C(C), use_simd(C <= kMaxSimdChannels), mean_vec(mean_vec), inv_std_vec(inv_std_vec) {
+    if (!use_simd) { return; }
+    FOR_RANGE(int64_t, k, 0, C * kMaxSimdLanes) {
+      mean[k] = mean_vec[k % C];
+      inv_std[k] = inv_std_vec[k % C];
+    }
+  }
+
+  const int64_t C;
+  const bool use_simd;
+  const float* mean_vec;
+  const float* inv_std_vec;
+  alignas(64) float mean[kMaxSimdChannels * kMaxSimdLanes];
+  alignas(64) float inv_std[kMaxSimdChannels * kMaxSimdLanes];
+};
+
+template<typename T>
+void NormalizeRowScalar(const T* in, int64_t n, int64_t C, const float* mean,
+                        const float* inv_std, float* out) {
+  for (int64_t k = 0, c = 0; k < n; ++k) {
+    out[k] = (static_cast<float>(in[k]) - mean[c]) * inv_std[c];
+    if (++c == C) { c = 0; }
+  }
+}
+
+template<typename T>
+void MirrorPixels(const T* in, int64_t W, int64_t C, T* out) {
+  if (C == 1) {
+    std::reverse_copy(in, in + W, out);
+  } else if (C == 3) {
+    FOR_RANGE(int64_t, w, 0, W) {
+      const T* pixel = in + (W - 1 - w) * 3;
+      out[w * 3 + 0] = pixel[0];
+      out[w * 3 + 1] = pixel[1];
+      out[w * 3 + 2] = pixel[2];
+    }
+  } else {
+    FOR_RANGE(int64_t, w, 0, W) {
+      const T* pixel = in + (W - 1 - w) * C;
+      std::copy(pixel, pixel + C, out + w * C);
+    }
+  }
+}
+
+void GatherChannelScalar(const float* row, int64_t C, int64_t c, int64_t W, bool mirror,
+                         float* out) {
+  if (mirror) {
+    FOR_RANGE(int64_t, w, 0, W) { out[w] = row[(W - 1 - w) * C + c]; }
+  } else {
+    FOR_RANGE(int64_t, w, 0, W) { out[w] = row[w * C + c]; }
+  }
+}
+
+#ifdef OF_IMAGE_X86_SIMD
+
+__attribute__((target("avx2"))) inline __m256 LoadAsFloatAvx2(const uint8_t* in) {
+  const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in));
+  return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+}
+
+__attribute__((target("avx2"))) inline __m256 LoadAsFloatAvx2(const float* in) {
+  return _mm256_loadu_ps(in);
+}
+
+template<typename T>
+__attribute__((target("avx2"))) void NormalizeRowAvx2(const T* in, int64_t n,
+                                                      const ChannelPattern& pattern, float* out) {
+  constexpr int64_t kLanes = 8;
+  const int64_t C = pattern.C;
+  __m256 mean[kMaxSimdChannels];
+  __m256 inv_std[kMaxSimdChannels];
+  FOR_RANGE(int64_t, j, 0, C) {
+    mean[j] = _mm256_load_ps(pattern.mean + j * kLanes);
+    inv_std[j] = _mm256_load_ps(pattern.inv_std + j * kLanes);
+  }
+  const int64_t step = C * kLanes;
+  int64_t k = 0;
+  for (; k + step <= n; k += step) {
+    FOR_RANGE(int64_t, j, 0, C) {
+      const __m256 x = LoadAsFloatAvx2(in + k + j * kLanes);
+      _mm256_storeu_ps(out + k + j * kLanes, _mm256_mul_ps(_mm256_sub_ps(x, mean[j]), inv_std[j]));
+    }
+  }
+  NormalizeRowScalar(in + k, n - k, C, pattern.mean_vec, pattern.inv_std_vec, out + k);
+}
+
+__attribute__((target("avx2"))) void GatherChannelAvx2(const float* row, int64_t C, int64_t c,
+                                                       int64_t W, bool mirror, float* out) {
+  constexpr int64_t kLanes = 8;
+  const int64_t stride = mirror ? -C : C;
+  const float* first = row + (mirror ? (W - 1) * C : 0) + c;
+  const __m256i index = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                           _mm256_set1_epi32(static_cast<int32_t>(stride)));
+  int64_t w = 0;
+  for (; w + kLanes <= W; w += kLanes) {
+    _mm256_storeu_ps(out + w, _mm256_i32gather_ps(first + w * stride, index, sizeof(float)));
+  }
+  for (; w < W; ++w) { out[w] = first[w * stride]; }
+}
+
+__attribute__((target("avx512f"))) inline __m512 LoadAsFloatAvx512(const uint8_t* in) {
+  const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+  return _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(bytes));
+}
+
+__attribute__((target("avx512f"))) inline __m512 LoadAsFloatAvx512(const float* in) {
+  return _mm512_loadu_ps(in);
+}
+
+template<typename T>
+__attribute__((target("avx512f"))) void NormalizeRowAvx512(const T* in, int64_t n,
+                                                           const ChannelPattern& pattern,
+                                                           float* out) {
+  constexpr int64_t kLanes = 16;
+  const int64_t C = pattern.C;
+  __m512 mean[kMaxSimdChannels];
+  __m512 inv_std[kMaxSimdChannels];
+  FOR_RANGE(int64_t, j, 0, C) {
+    mean[j] = _mm512_load_ps(pattern.mean + j * kLanes);
+    inv_std[j] = _mm512_load_ps(pattern.inv_std + j * kLanes);
+  }
+  const int64_t step = C * kLanes;
+  int64_t k = 0;
+  for (; k + step <= n; k += step) {
+    FOR_RANGE(int64_t, j, 0, C) {
+      const __m512 x = LoadAsFloatAvx512(in + k + j * kLanes);
+      _mm512_storeu_ps(out + k + j * kLanes, _mm512_mul_ps(_mm512_sub_ps(x, mean[j]), inv_std[j]));
+    }
+  }
+  NormalizeRowScalar(in + k, n - k, C, pattern.mean_vec, pattern.inv_std_vec, out + k);
+}
+
+__attribute__((target("avx512f"))) void GatherChannelAvx512(const float* row, int64_t C,
+                                                            int64_t c, int64_t W, bool mirror,
+                                                            float* out) {
+  constexpr int64_t kLanes = 16;
+  const int64_t stride = mirror ? -C : C;
+  const float* first = row + (mirror ? (W - 1) * C : 0) + c;
+  const __m512i index =
+      _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+                         _mm512_set1_epi32(static_cast<int32_t>(stride)));
+  int64_t w = 0;
+  for (; w + kLanes <= W; w += kLanes) {
+    _mm512_storeu_ps(out + w, _mm512_i32gather_ps(index, first + w * stride, sizeof(float)));
+  }
+  for (; w < W; ++w) { out[w] = first[w * stride]; }
+}
+
+#endif  // OF_IMAGE_X86_SIMD
+
+template<typename T>
+void NormalizeRow(const T* in, int64_t n, const ChannelPattern& pattern, float* out) {
+#ifdef OF_IMAGE_X86_SIMD
+  if (pattern.use_simd) {
+    const SimdLevel level = GetSimdLevel();
+    if (level == SimdLevel::kAvx512) {
+      NormalizeRowAvx512(in, n, pattern, out);
+      return;
+    } else if (level == SimdLevel::kAvx2) {
+      NormalizeRowAvx2(in, n, pattern, out);
+      return;
+    }
+  }
+#endif
+  NormalizeRowScalar(in, n, pattern.C, pattern.mean_vec, pattern.inv_std_vec, out);
+}
+
+void GatherChannel(const float* row, int64_t C, int64_t c, int64_t W, bool mirror, float* out) {
+#ifdef OF_IMAGE_X86_SIMD
+  const SimdLevel level = GetSimdLevel();
+  if (level == SimdLevel::kAvx512) {
+    GatherChannelAvx512(row, C, c, W, mirror, out);
+    return;
+  } else if (level == SimdLevel::kAvx2) {
+    GatherChannelAvx2(row, C, c, W, mirror, out);
+    return;
+  }
+#endif
+  GatherChannelScalar(row, C, c, W, mirror, out);
+}
+
+}  // namespace
+
+void CropMirrorNormalize(const uint8_t* in, int64_t in_W, int64_t C, int64_t crop_y,
+                         int64_t crop_x, int64_t out_H, int64_t out_W, bool mirror, bool out_nchw,
+                         const float* mean, const float* inv_std, float* out) {
+  const ChannelPattern pattern(C, mean, inv_std);
+  const int64_t row_elem_cnt = out_W * C;
+  // NHWC output is normalized straight into the output, from the mirrored input bytes if asked.
+  // NCHW output goes through a float row buffer which stays in L1 and is gathered per channel
+  static thread_local std::vector<uint8_t> mirrored_row;
+  static thread_local std::vector<float> row_buf;
+  if (mirror && !out_nchw && mirrored_row.size() < row_elem_cnt) {
+    mirrored_row.resize(row_elem_cnt);
+  }
+  if (out_nchw && row_buf.size() < row_elem_cnt) { row_buf.resize(row_elem_cnt); }
+  FOR_RANGE(int64_t, h, 0, out_H) {
+    const uint8_t* in_row = in + ((crop_y + h) * in_W + crop_x) * C;
+    if (out_nchw) {
+      float* row = row_buf.data();
+      NormalizeRow(in_row, row_elem_cnt, pattern, row);
+      FOR_RANGE(int64_t, c, 0, C) {
+        GatherChannel(row, C, c, out_W, mirror, out + (c * out_H + h) * out_W);
+      }
+    } else if (mirror) {
+      MirrorPixels(in_row, out_W, C, mirrored_row.data());
+      NormalizeRow(mirrored_row.data(), row_elem_cnt, pattern, out + h * row_elem_cnt);
+    } else {
+      NormalizeRow(in_row, row_elem_cnt, pattern, out + h * row_elem_cnt);
+    }
+  }
+}
+
+void NormalizeHWC(const float* in, int64_t num_pixels, int64_t C, const float* mean,
+                  const float* inv_std, float* out) {
+  NormalizeRow(in, num_pixels * C, ChannelPattern(C, mean, inv_std), out);
+}
+
+}  // namespace oneflow
@@ -0,0 +1,36 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CUSTOMIZED_IMAGE_CROP_MIRROR_NORMALIZE_H_
+#define ONEFLOW_CUSTOMIZED_IMAGE_CROP_MIRROR_NORMALIZE_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// Crops the window [crop_y, crop_y + out_H) x [crop_x, crop_x + out_W) of an HWC uint8 image,
+// mirrors it horizontally if asked, computes (x - mean[c]) * inv_std[c] and writes it as NCHW or
+// NHWC float, all in one pass over the window. AVX-512 or AVX2 is used when the CPU supports it.
+void CropMirrorNormalize(const uint8_t* in, int64_t in_W, int64_t C, int64_t crop_y,
+                         int64_t crop_x, int64_t out_H, int64_t out_W, bool mirror, bool out_nchw,
+                         const float* mean, const float* inv_std, float* out);
+
+// (x - mean[c]) * inv_std[c] of num_pixels HWC float pixels, in and out may be the same buffer
+void NormalizeHWC(const float* in, int64_t num_pixels, int64_t C, const float* mean,
+                  const float* inv_std, float* out);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CUSTOMIZED_IMAGE_CROP_MIRROR_NORMALIZE_H_
@@ -0,0 +1,118 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/customized/image/crop_mirror_normalize.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <random>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+// the per pixel, per channel loop which crop_mirror_normalize_from_uint8 used before
+void NaiveCropMirrorNormalize(const uint8_t* in, int64_t in_W, int64_t C, int64_t crop_y,
+                              int64_t crop_x, int64_t out_H, int64_t out_W, bool mirror,
+                              bool out_nchw, const std::vector<float>& mean_vec,
+                              const std::vector<float>& inv_std_vec, float* out) {
+  FOR_RANGE(int64_t, c, 0, C) {
+    FOR_RANGE(int64_t, h, 0, out_H) {
+      FOR_RANGE(int64_t, w, 0, out_W) {
+        int64_t in_w = crop_x + (mirror ? out_W - 1 - w : w);
+        int64_t in_offset = ((crop_y + h) * in_W + in_w) * C + c;
+        int64_t out_offset = out_nchw ? (c * out_H + h) * out_W + w : (h * out_W + w) * C + c;
+        out[out_offset] = (static_cast<float>(in[in_offset]) - mean_vec.at(c)) * inv_std_vec.at(c);
+      }
+    }
+  }
+}
+
+template<typename F>
+double AverageMicroseconds(int32_t repeat, const F& f) {
+  auto start = std::chrono::steady_clock::now();
+  FOR_RANGE(int32_t, i, 0, repeat) { f(); }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() / repeat;
+}
+
+void TestCropMirrorNormalize(int64_t C, bool mirror, bool out_nchw) {
+  const int64_t in_H = 256;
+  const int64_t in_W = 259;
+  const int64_t out_H = 224;
+  const int64_t out_W = 227;
+  const int64_t crop_y = 13;
+  const int64_t crop_x = 17;
+  std::mt19937 gen(C);
+  std::vector<uint8_t> image(in_H * in_W * C);
+  for (uint8_t& pixel : image) { pixel = gen(); }
+  const std::vector<float> mean_vec{123.68f, 116.78f, 103.94f};
+  const std::vector<float> inv_std_vec{1.0f / 58.39f, 1.0f / 57.12f, 1.0f / 57.37f};
+  std::vector<float> expected(out_H * out_W * C);
+  std::vector<float> out(out_H * out_W * C);
+  NaiveCropMirrorNormalize(image.data(), in_W, C, crop_y, crop_x, out_H, out_W, mirror, out_nchw,
+                           mean_vec, inv_std_vec, expected.data());
+  CropMirrorNormalize(image.data(), in_W, C, crop_y, crop_x, out_H, out_W, mirror, out_nchw,
+                      mean_vec.data(), inv_std_vec.data(), out.data());
+  FOR_RANGE(size_t, i, 0, out.size()) { ASSERT_FLOAT_EQ(out.at(i), expected.at(i)); }
+
+  const int32_t repeat = 100;
+  double naive_us = AverageMicroseconds(repeat, [&]() {
+    NaiveCropMirrorNormalize(image.data(), in_W, C, crop_y, crop_x, out_H, out_W, mirror,
+                             out_nchw, mean_vec, inv_std_vec, expected.data());
+  });
+  double fused_us = AverageMicroseconds(repeat, [&]() {
+    CropMirrorNormalize(image.data(), in_W, C, crop_y, crop_x, out_H, out_W, mirror, out_nchw,
+                        mean_vec.data(), inv_std_vec.data(), out.data());
+  });
+  LOG(INFO) << "crop_mirror_normalize C: " << C << " mirror: " << mirror
+            << " layout: " << (out_nchw ? "NCHW" : "NHWC") << " naive: " << naive_us
+            << "us fused: " << fused_us << "us";
+}
+
+}  // namespace
+
+TEST(CropMirrorNormalize, gray_nhwc) { TestCropMirrorNormalize(1, false, false); }
+
+TEST(CropMirrorNormalize, gray_nchw_mirror) { TestCropMirrorNormalize(1, true, true); }
+
+TEST(CropMirrorNormalize, color_nhwc) { TestCropMirrorNormalize(3, false, false); }
+
+TEST(CropMirrorNormalize, color_nhwc_mirror) { TestCropMirrorNormalize(3, true, false); }
+
+TEST(CropMirrorNormalize, color_nchw) { TestCropMirrorNormalize(3, false, true); }
+
+TEST(CropMirrorNormalize, color_nchw_mirror) { TestCropMirrorNormalize(3, true, true); }
+
+TEST(NormalizeHWC, color_in_place) {
+  const int64_t num_pixels = 1001;
+  const int64_t C = 3;
+  std::mt19937 gen(0);
+  std::vector<float> image(num_pixels * C);
+  for (float& pixel : image) { pixel = gen() % 256; }
+  const std::vector<float> mean_vec{123.68f, 116.78f, 103.94f};
+  const std::vector<float> inv_std_vec{1.0f / 58.39f, 1.0f / 57.12f, 1.0f / 57.37f};
+  std::vector<float> expected(image.size());
+  FOR_RANGE(size_t, i, 0, image.size()) {
+    expected.at(i) = (image.at(i) - mean_vec.at(i % C)) * inv_std_vec.at(i % C);
+  }
+  NormalizeHWC(image.data(), num_pixels, C, mean_vec.data(), inv_std_vec.data(), image.data());
+  FOR_RANGE(size_t, i, 0, image.size()) { ASSERT_FLOAT_EQ(image.at(i), expected.at(i)); }
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -38,6 +38,19 @@ void ImageUtil::ConvertColor(const std::string& input_color, const cv::Mat& inpu
   }
 }
 
+int ImageUtil::GetOpencvInterp(const std::string& interp_type) {
+  if (interp_type == "Linear") {
+    return cv::INTER_LINEAR;
+  } else if (interp_type == "NN") {
+    return cv::INTER_NEAREST;
+  } else if (interp_type == "Cubic") {
+    return cv::INTER_CUBIC;
+  } else {
+    UNIMPLEMENTED();
+    return -1;
+  }
+}
+
 cv::Mat GenCvMat4ImageBuffer(const TensorBuffer& image_buffer) {
   CHECK_EQ(image_buffer.shape().NumAxes(), 3);
   int h = image_buffer.shape().At(0);
@@ -27,6 +27,8 @@ struct ImageUtil {
 
   static void ConvertColor(const std::string& input_color, const cv::Mat& input_img,
                            const std::string& output_color, cv::Mat& output_img);
+
+  static int GetOpencvInterp(const std::string& interp_type);
 };
 
 template<typename T>
@@ -0,0 +1,157 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/customized/image/jpeg_decoder.h"
+#include "oneflow/customized/image/image_util.h"
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+
+namespace oneflow {
+
+namespace {
+
+struct JpegErrorManager {
+  struct jpeg_error_mgr pub;
+  jmp_buf setjmp_buffer;
+};
+
+void JpegErrorExit(j_common_ptr cinfo) {
+  JpegErrorManager* err = reinterpret_cast<JpegErrorManager*>(cinfo->err);
+  longjmp(err->setjmp_buffer, 1);
+}
+
+// warnings of corrupt data are not fatal for libjpeg, keep them out of the log
+void JpegOutputMessage(j_common_ptr cinfo) {}
+
+J_COLOR_SPACE GetJpegColorSpace(const std::string& color_space) {
+  if (color_space == "BGR") {
+    return JCS_EXT_BGR;
+  } else if (color_space == "RGB") {
+    return JCS_RGB;
+  } else if (color_space == "GRAY") {
+    return JCS_GRAYSCALE;
+  } else {
+    UNIMPLEMENTED();
+    return JCS_UNKNOWN;
+  }
+}
+
+// every libjpeg call which may longjmp back lives in a method of this class without any local
+// object needing destruction, so that jumping out of libjpeg never skips a destructor
+class JpegDecompressor final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(JpegDecompressor);
+  JpegDecompressor(const unsigned char* data, size_t length) {
+    cinfo_.err = jpeg_std_error(&err_.pub);
+    err_.pub.error_exit = JpegErrorExit;
+    err_.pub.output_message = JpegOutputMessage;
+    jpeg_create_decompress(&cinfo_);
+    jpeg_mem_src(&cinfo_, const_cast<unsigned char*>(data), length);
+  }
+  ~JpegDecompressor() { jpeg_destroy_decompress(&cinfo_); }
+
+  int image_height() const { return cinfo_.image_height; }
+  int image_width() const { return cinfo_.image_width; }
+
+  bool ReadHeader() {
+    if (setjmp(err_.setjmp_buffer)) { return false; }
+    return jpeg_read_header(&cinfo_, TRUE) == JPEG_HEADER_OK;
+  }
+
+  // Decodes the scanlines of the crop [y, y + h) x [x, x + w) of the source image, scaled by
+  // 1 / scale_denom. The decoded rows start at the iMCU column boundary left of the crop and are
+  // rows_width pixels wide, roi is the scaled crop inside them.
+  bool DecodeCrop(J_COLOR_SPACE out_color_space, int scale_denom, int64_t x, int64_t y, int64_t w,
+                  int64_t h, std::vector<unsigned char>* rows, int* rows_width, cv::Rect* roi) {
+    if (setjmp(err_.setjmp_buffer)) {
+      jpeg_abort_decompress(&cinfo_);
+      return false;
+    }
+    cinfo_.out_color_space = out_color_space;
+    cinfo_.scale_num = 1;
+    cinfo_.scale_denom = scale_denom;
+    jpeg_start_decompress(&cinfo_);
+    const int64_t src_h = cinfo_.image_height;
+    const int64_t src_w = cinfo_.image_width;
+    const int64_t dst_h = cinfo_.output_height;
+    const int64_t dst_w = cinfo_.output_width;
+    const JDIMENSION x0 = x * dst_w / src_w;
+    const JDIMENSION y0 = y * dst_h / src_h;
+    const JDIMENSION x1 = std::min<int64_t>(
+        dst_w, std::max<int64_t>(x0 + 1, ((x + w) * dst_w + src_w - 1) / src_w));
+    const JDIMENSION y1 = std::min<int64_t>(
+        dst_h, std::max<int64_t>(y0 + 1, ((y + h) * dst_h + src_h - 1) / src_h));
+    JDIMENSION xoffset = x0;
+    JDIMENSION width = x1 - x0;
+    jpeg_crop_scanline(&cinfo_, &xoffset, &width);
+    const size_t row_bytes = static_cast<size_t>(cinfo_.output_width) * cinfo_.output_components;
+    rows->resize(row_bytes * (y1 - y0));
+    if (y0 > 0) { jpeg_skip_scanlines(&cinfo_, y0); }
+    while (cinfo_.output_scanline < y1) {
+      JSAMPROW row = rows->data() + row_bytes * (cinfo_.output_scanline - y0);
+      jpeg_read_scanlines(&cinfo_, &row, 1);
+    }
+    *rows_width = cinfo_.output_width;
+    *roi = cv::Rect(x0 - xoffset, 0, x1 - x0, y1 - y0);
+    jpeg_abort_decompress(&cinfo_);
+    return true;
+  }
+
+ private:
+  struct jpeg_decompress_struct cinfo_;
+  JpegErrorManager err_;
+};
+
+}  // namespace
+
+bool JpegGetImageSize(const unsigned char* data, size_t length, int* height, int* width) {
+  JpegDecompressor decompressor(data, length);
+  if (!decompressor.ReadHeader()) { return false; }
+  *height = decompressor.image_height();
+  *width = decompressor.image_width();
+  return true;
+}
+
+bool JpegDecodeCropResize(const unsigned char* data, size_t length, const std::string& color_space,
+                          const CropWindow& crop, int interp, cv::Mat* out_mat) {
+  const int64_t crop_h = crop.shape.At(0);
+  const int64_t crop_w = crop.shape.At(1);
+  const int channels = ImageUtil::IsColor(color_space) ? 3 : 1;
+  CHECK_EQ(out_mat->channels(), channels);
+  CHECK_EQ(out_mat->depth(), CV_8U);
+  // pick the largest IDCT downscale which keeps the crop at least as large as the target
+  int scale_denom = 8;
+  while (scale_denom > 1
+         && (crop_h < out_mat->rows * scale_denom || crop_w < out_mat->cols * scale_denom)) {
+    scale_denom /= 2;
+  }
+  JpegDecompressor decompressor(data, length);
+  if (!decompressor.ReadHeader()) { return false; }
+  // reused across the images a thread decodes, so the row buffer is allocated only when it grows
+  static thread_local std::vector<unsigned char> rows;
+  int rows_width = 0;
+  cv::Rect roi;
+  if (!decompressor.DecodeCrop(GetJpegColorSpace(color_space), scale_denom, crop.anchor.At(1),
+                               crop.anchor.At(0), crop_w, crop_h, &rows, &rows_width, &roi)) {
+    return false;
+  }
+  const cv::Mat rows_mat =
+      CreateMatWithPtr(roi.height, rows_width, CV_MAKETYPE(CV_8U, channels), rows.data());
+  cv::resize(rows_mat(roi), *out_mat, out_mat->size(), 0, 0, interp);
+  return true;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,36 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CUSTOMIZED_IMAGE_JPEG_DECODER_H_
+#define ONEFLOW_CUSTOMIZED_IMAGE_JPEG_DECODER_H_
+
+#include "oneflow/customized/image/crop_window.h"
+#include <opencv2/opencv.hpp>
+
+namespace oneflow {
+
+// Reads the image size from the JPEG header, returns false if data is not a JPEG image
+bool JpegGetImageSize(const unsigned char* data, size_t length, int* height, int* width);
+
+// Decodes the crop window of a JPEG image and resizes it into out_mat, whose size and type define
+// the target. Only the scanlines and iMCU columns covered by the crop are decoded, and when the
+// crop is at least twice as large as the target, libjpeg-turbo downscales by 1/2, 1/4 or 1/8 in
+// the IDCT. Returns false if libjpeg fails to decode the image.
+bool JpegDecodeCropResize(const unsigned char* data, size_t length, const std::string& color_space,
+                          const CropWindow& crop, int interp, cv::Mat* out_mat);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CUSTOMIZED_IMAGE_JPEG_DECODER_H_
@@ -0,0 +1,223 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/embedding/embedding_store.h"
+#include "oneflow/core/kernel/cpu_row_update_util.h"
+#include "oneflow/core/kernel/indexed_slices_reduce_sum_kernel_util.h"
+#include "oneflow/core/kernel/unique_kernel_util.h"
+#include "oneflow/customized/kernels/op_kernel_state_wrapper.h"
+
+namespace oneflow {
+
+namespace {
+
+std::shared_ptr<user_op::OpKernelState> CreateEmbeddingStoreState(
+    user_op::KernelInitContext* ctx) {
+  EmbeddingStoreOptions options;
+  options.name = ctx->Attr<std::string>("store_name");
+  options.embedding_dim = ctx->Attr<int64_t>("embedding_dim");
+  options.num_state_slots = ctx->Attr<std::string>("optimizer") == "adam" ? 2 : 0;
+  options.num_shards = ctx->Attr<int64_t>("num_shards");
+  options.cache_capacity = ctx->Attr<int64_t>("cache_capacity");
+  options.storage_dir = ctx->Attr<std::string>("storage_dir");
+  options.init_scale = ctx->Attr<float>("init_scale");
+  options.seed = ctx->Attr<int64_t>("seed");
+  return std::make_shared<OpKernelStateWrapper<EmbeddingStore*>>(
+      EmbeddingStoreMgr::Get()->GetOrCreate(options));
+}
+
+EmbeddingStore* GetEmbeddingStore(user_op::OpKernelState* state) {
+  return dynamic_cast<OpKernelStateWrapper<EmbeddingStore*>*>(state)->Get();
+}
+
+// tmp_buffer of both kernels: unique ids, their int64 copy and the per id rows, followed by the
+// workspace of the unique or reduce sum step
+template<typename K>
+class EmbeddingStoreTmpBuffer final {
+ public:
+  EmbeddingStoreTmpBuffer(int64_t n, int64_t embedding_dim, void* ptr)
+      : n_(n), embedding_dim_(embedding_dim), ptr_(static_cast<char*>(ptr)) {}
+  ~EmbeddingStoreTmpBuffer() = default;
+
+  static int64_t SizeInBytes(int64_t n, int64_t embedding_dim, int64_t workspace_size) {
+    return WorkspaceOffset(n, embedding_dim) + workspace_size;
+  }
+
+  K* unique_ids() const { return reinterpret_cast<K*>(ptr_); }
+  int64_t* unique_ids_int64() const {
+    return reinterpret_cast<int64_t*>(ptr_ + GetCudaAlignedSize(n_ * sizeof(K)));
+  }
+  int64_t* num_unique() const {
+    return reinterpret_cast<int64_t*>(ptr_ + GetCudaAlignedSize(n_ * sizeof(K))
+                                      + GetCudaAlignedSize(n_ * sizeof(int64_t)));
+  }
+  int64_t* idx() const { return num_unique() + 1; }
+  float* rows() const {
+    return reinterpret_cast<float*>(ptr_ + WorkspaceOffset(n_, embedding_dim_)
+                                    - GetCudaAlignedSize(n_ * embedding_dim_ * sizeof(float)));
+  }
+  void* workspace() const { return ptr_ + WorkspaceOffset(n_, embedding_dim_); }
+
+ private:
+  static int64_t WorkspaceOffset(int64_t n, int64_t embedding_dim) {
+    return GetCudaAlignedSize(n * sizeof(K)) + GetCudaAlignedSize(n * sizeof(int64_t))
+           + GetCudaAlignedSize((n + 1) * sizeof(int64_t))
+           + GetCudaAlignedSize(n * embedding_dim * sizeof(float));
+  }
+
+  const int64_t n_;
+  const int64_t embedding_dim_;
+  char* ptr_;
+};
+
+template<typename K>
+void CopyUniqueIdsToInt64(const EmbeddingStoreTmpBuffer<K>& buf) {
+  std::copy(buf.unique_ids(), buf.unique_ids() + *buf.num_unique(), buf.unique_ids_int64());
+}
+
+}  // namespace
+
+template<typename K>
+class EmbeddingStoreLookupKernel final : public user_op::OpKernel {
+ public:
+  EmbeddingStoreLookupKernel() = default;
+  ~EmbeddingStoreLookupKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return CreateEmbeddingStoreState(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* ids = ctx->Tensor4ArgNameAndIndex("ids", 0);
+    user_op::Tensor* embeddings = ctx->Tensor4ArgNameAndIndex("embeddings", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const int64_t n = ids->shape().elem_cnt();
+    const int64_t embedding_dim = ctx->Attr<int64_t>("embedding_dim");
+    EmbeddingStoreTmpBuffer<K> buf(n, embedding_dim, tmp_buffer->mut_dptr());
+    const int64_t workspace_size = tmp_buffer->shape().elem_cnt()
+                                   - EmbeddingStoreTmpBuffer<K>::SizeInBytes(n, embedding_dim, 0);
+    // only the unique ids of the batch are fetched from the store
+    UniqueKernelUtil<DeviceType::kCPU, K, int64_t>::Unique(
+        ctx->device_ctx(), n, ids->dptr<K>(), buf.num_unique(), buf.unique_ids(), buf.idx(),
+        buf.workspace(), workspace_size);
+    CopyUniqueIdsToInt64(buf);
+    GetEmbeddingStore(state)->Lookup(*buf.num_unique(), buf.unique_ids_int64(), buf.rows());
+    const float* rows = buf.rows();
+    const int64_t* idx = buf.idx();
+    float* out = embeddings->mut_dptr<float>();
+    ParallelForEachRowRange(n, n * embedding_dim, [&](int64_t begin, int64_t end) {
+      FOR_RANGE(int64_t, i, begin, end) {
+        std::copy(rows + idx[i] * embedding_dim, rows + (idx[i] + 1) * embedding_dim,
+                  out + i * embedding_dim);
+      }
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename K>
+class EmbeddingStoreUpdateKernel final : public user_op::OpKernel {
+ public:
+  EmbeddingStoreUpdateKernel() = default;
+  ~EmbeddingStoreUpdateKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return CreateEmbeddingStoreState(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* ids = ctx->Tensor4ArgNameAndIndex("ids", 0);
+    const user_op::Tensor* embedding_diff = ctx->Tensor4ArgNameAndIndex("embedding_diff", 0);
+    user_op::Tensor* shadow_diff = ctx->Tensor4ArgNameAndIndex("shadow_diff", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const int64_t n = ids->shape().elem_cnt();
+    const int64_t embedding_dim = ctx->Attr<int64_t>("embedding_dim");
+    EmbeddingStoreTmpBuffer<K> buf(n, embedding_dim, tmp_buffer->mut_dptr());
+    const int64_t workspace_size = tmp_buffer->shape().elem_cnt()
+                                   - EmbeddingStoreTmpBuffer<K>::SizeInBytes(n, embedding_dim, 0);
+    // the diffs of repeated ids are summed first, so every row of the store is updated once
+    IndexedSlicesReduceSumKernelUtil<DeviceType::kCPU, K, float, int64_t>::ReduceSum(
+        ctx->device_ctx(), n, embedding_dim, ids->dptr<K>(), embedding_diff->dptr<float>(),
+        buf.num_unique(), buf.unique_ids(), buf.rows(), buf.workspace(), workspace_size);
+    CopyUniqueIdsToInt64(buf);
+    const float* diff = buf.rows();
+    const user_op::Tensor* learning_rate = ctx->Tensor4ArgNameAndIndex("learning_rate", 0);
+    CHECK(learning_rate != nullptr)
+        << "embedding_store_update has no learning_rate, EmbeddingStoreOptimizerPass binds it";
+    const float lr = *learning_rate->dptr<float>();
+    EmbeddingStore* store = GetEmbeddingStore(state);
+    if (ctx->Attr<std::string>("optimizer") == "adam") {
+      const float beta1 = ctx->Attr<float>("beta1");
+      const float beta2 = ctx->Attr<float>("beta2");
+      const float epsilon = ctx->Attr<float>("epsilon");
+      const user_op::Tensor* train_step = ctx->Tensor4ArgNameAndIndex("train_step", 0);
+      CHECK(train_step != nullptr)
+          << "embedding_store_update has no train_step, EmbeddingStoreOptimizerPass binds it";
+      // bias correction of step t = train_step + 1, as lazy_adam does with its beta1_t and beta2_t
+      const float local_lr =
+          LazyAdamBiasCorrectedLearningRate(lr, beta1, beta2, *train_step->dptr<int64_t>() + 1);
+      store->ForEachRow(*buf.num_unique(), buf.unique_ids_int64(), [&](int64_t i, float* row) {
+        LazyAdamUpdateRow<float>(embedding_dim, beta1, beta2, epsilon, local_lr,
+                                 diff + i * embedding_dim, row, row + embedding_dim,
+                                 row + 2 * embedding_dim);
+      });
+    } else {
+      store->ForEachRow(*buf.num_unique(), buf.unique_ids_int64(), [&](int64_t i, float* row) {
+        AxpyRow<float>(embedding_dim, -lr, diff + i * embedding_dim, row);
+      });
+    }
+    std::fill(shadow_diff->mut_dptr<float>(),
+              shadow_diff->mut_dptr<float>() + shadow_diff->shape().elem_cnt(), 0.f);
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_EMBEDDING_STORE_KERNELS(ids_type_pair)                                        \
+  REGISTER_USER_KERNEL("embedding_store_lookup")                                               \
+      .SetCreateFn<EmbeddingStoreLookupKernel<OF_PP_PAIR_FIRST(ids_type_pair)>>()              \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                          \
+                       & (user_op::HobDataType("ids", 0) == OF_PP_PAIR_SECOND(ids_type_pair))) \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) {                                      \
+        const int64_t n = ctx->Shape4ArgNameAndIndex("ids", 0)->elem_cnt();                    \
+        int64_t workspace_size = 0;                                                            \
+        UniqueKernelUtil<DeviceType::kCPU, OF_PP_PAIR_FIRST(ids_type_pair),                    \
+                         int64_t>::GetUniqueWorkspaceSizeInBytes(nullptr, n, &workspace_size); \
+        return EmbeddingStoreTmpBuffer<OF_PP_PAIR_FIRST(ids_type_pair)>::SizeInBytes(          \
+            n, ctx->Attr<int64_t>("embedding_dim"), workspace_size);                           \
+      });                                                                                      \
+  REGISTER_USER_KERNEL("embedding_store_update")                                               \
+      .SetCreateFn<EmbeddingStoreUpdateKernel<OF_PP_PAIR_FIRST(ids_type_pair)>>()              \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                          \
+                       & (user_op::HobDataType("ids", 0) == OF_PP_PAIR_SECOND(ids_type_pair))) \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) {                                      \
+        const int64_t n = ctx->Shape4ArgNameAndIndex("ids", 0)->elem_cnt();                    \
+        const int64_t embedding_dim = ctx->Attr<int64_t>("embedding_dim");                     \
+        int64_t workspace_size = 0;                                                            \
+        IndexedSlicesReduceSumKernelUtil<DeviceType::kCPU, OF_PP_PAIR_FIRST(ids_type_pair),    \
+                                         float, int64_t>::                                     \
+            GetReduceSumWorkspaceSizeInBytes(nullptr, n, embedding_dim, &workspace_size);      \
+        return EmbeddingStoreTmpBuffer<OF_PP_PAIR_FIRST(ids_type_pair)>::SizeInBytes(          \
+            n, embedding_dim, workspace_size);                                                 \
+      });
+
+OF_PP_FOR_EACH_TUPLE(REGISTER_EMBEDDING_STORE_KERNELS, INDEX_DATA_TYPE_SEQ)
+#undef REGISTER_EMBEDDING_STORE_KERNELS
+
+}  // namespace oneflow
@@ -0,0 +1,132 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/core/kernel/variable_generation.h"
+
+namespace oneflow {
+
+namespace {
+
+// the folded weight and bias on host, valid for the variables of generation
+template<typename T>
+class FoldedBatchNormParams final : public user_op::OpKernelState {
+ public:
+  FoldedBatchNormParams() : generation(-1) {}
+  ~FoldedBatchNormParams() override = default;
+
+  int64_t generation;
+  std::vector<T> weight;
+  std::vector<T> bias;
+};
+
+template<typename T>
+std::vector<T> CopyToHost(DeviceCtx* device_ctx, const user_op::Tensor* tensor) {
+  std::vector<T> host(tensor->shape().elem_cnt());
+  MemoryCase host_mem_case;
+  host_mem_case.mutable_host_mem();
+  SyncAutoMemcpy(device_ctx, host.data(), tensor->dptr<T>(), host.size() * sizeof(T),
+                 host_mem_case, tensor->mem_case());
+  return host;
+}
+
+template<typename T>
+void CopyFromHost(DeviceCtx* device_ctx, const std::vector<T>& host, user_op::Tensor* tensor) {
+  CHECK_EQ(host.size(), tensor->shape().elem_cnt());
+  MemoryCase host_mem_case;
+  host_mem_case.mutable_host_mem();
+  AutoMemcpy(device_ctx, tensor->mut_dptr<T>(), host.data(), host.size() * sizeof(T),
+             tensor->mem_case(), host_mem_case);
+}
+
+// Folds an inference batch norm into the weight and bias of the conv or matmul before it:
+//   folded_weight = weight * scale along weight_channel_axis
+//   folded_bias = (bias - moving_mean) * scale + beta
+// with scale = gamma / sqrt(moving_variance + epsilon). Variables only change when they are
+// initialized, loaded or assigned, so the folding runs once per variable generation and every
+// other step just copies the cached result out.
+template<typename T>
+class FoldBatchNormParamsKernel final : public user_op::OpKernel {
+ public:
+  FoldBatchNormParamsKernel() = default;
+  ~FoldBatchNormParamsKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<FoldedBatchNormParams<T>>();
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    auto* folded = dynamic_cast<FoldedBatchNormParams<T>*>(state);
+    CHECK_NOTNULL(folded);
+    const int64_t generation = VariableGeneration();
+    if (folded->generation != generation) {
+      Fold(ctx, folded);
+      folded->generation = generation;
+    }
+    CopyFromHost(ctx->device_ctx(), folded->weight,
+                 ctx->Tensor4ArgNameAndIndex("folded_weight", 0));
+    CopyFromHost(ctx->device_ctx(), folded->bias, ctx->Tensor4ArgNameAndIndex("folded_bias", 0));
+  }
+
+  void Fold(user_op::KernelComputeContext* ctx, FoldedBatchNormParams<T>* folded) const {
+    DeviceCtx* device_ctx = ctx->device_ctx();
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const std::vector<T> moving_mean =
+        CopyToHost<T>(device_ctx, ctx->Tensor4ArgNameAndIndex("moving_mean", 0));
+    const std::vector<T> moving_variance =
+        CopyToHost<T>(device_ctx, ctx->Tensor4ArgNameAndIndex("moving_variance", 0));
+    const std::vector<T> gamma = CopyToHost<T>(device_ctx, ctx->Tensor4ArgNameAndIndex("gamma", 0));
+    const std::vector<T> beta = CopyToHost<T>(device_ctx, ctx->Tensor4ArgNameAndIndex("beta", 0));
+    std::vector<T> bias(moving_mean.size(), 0);
+    if (ctx->user_op_conf().has_input("bias", 0)) {
+      bias = CopyToHost<T>(device_ctx, ctx->Tensor4ArgNameAndIndex("bias", 0));
+    }
+    const T epsilon = static_cast<T>(ctx->Attr<float>("epsilon"));
+    const int64_t num_channels = moving_mean.size();
+    std::vector<T> scale(num_channels);
+    folded->bias.resize(num_channels);
+    FOR_RANGE(int64_t, c, 0, num_channels) {
+      scale.at(c) = gamma.at(c) / std::sqrt(moving_variance.at(c) + epsilon);
+      folded->bias.at(c) = (bias.at(c) - moving_mean.at(c)) * scale.at(c) + beta.at(c);
+    }
+    folded->weight = CopyToHost<T>(device_ctx, weight);
+    const int32_t weight_channel_axis = ctx->Attr<int32_t>("weight_channel_axis");
+    CHECK_EQ(weight->shape().At(weight_channel_axis), num_channels);
+    const int64_t inner_size = weight->shape().Count(weight_channel_axis + 1);
+    const int64_t outer_size = weight->shape().Count(0, weight_channel_axis);
+    T* weight_ptr = folded->weight.data();
+    FOR_RANGE(int64_t, i, 0, outer_size) {
+      FOR_RANGE(int64_t, c, 0, num_channels) {
+        FOR_RANGE(int64_t, j, 0, inner_size) { *weight_ptr++ *= scale.at(c); }
+      }
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+}  // namespace
+
+#define REGISTER_FOLD_BATCH_NORM_PARAMS_KERNEL(dtype)     \
+  REGISTER_USER_KERNEL("fold_batch_norm_params")          \
+      .SetCreateFn<FoldBatchNormParamsKernel<dtype>>()    \
+      .SetIsMatchedHob(user_op::HobDataType("weight", 0) == GetDataType<dtype>::value);
+
+REGISTER_FOLD_BATCH_NORM_PARAMS_KERNEL(float)
+REGISTER_FOLD_BATCH_NORM_PARAMS_KERNEL(double)
+
+}  // namespace oneflow
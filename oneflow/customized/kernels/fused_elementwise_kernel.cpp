@@ -0,0 +1,220 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/customized/kernels/math_unary_elementwise_func.h"
+#include "oneflow/customized/kernels/math_binary_elementwise_func.h"
+#include "oneflow/customized/kernels/op_kernel_state_wrapper.h"
+#include "oneflow/customized/utils/fused_elementwise_program.h"
+#include "oneflow/customized/utils/fused_elementwise_broadcast.h"
+
+namespace oneflow {
+
+namespace {
+
+// The program runs over blocks of elements with a block sized buffer per register, so that each
+// instruction is a tight loop over contiguous memory which the compiler vectorizes, while the
+// intermediate results stay in cache instead of being written out as blobs.
+constexpr int64_t kBlockSize = 1024;
+
+template<typename T>
+using InstructionFn = void (*)(int64_t n, const T* x, const T* y, T scalar, T* z);
+
+template<typename T, typename Functor>
+void UnaryInstruction(int64_t n, const T* x, const T* y, T scalar, T* z) {
+  for (int64_t i = 0; i < n; ++i) { z[i] = Functor::Forward(x[i]); }
+}
+
+template<typename T, typename Functor>
+void BinaryInstruction(int64_t n, const T* x, const T* y, T scalar, T* z) {
+  for (int64_t i = 0; i < n; ++i) { z[i] = Functor::Forward(x[i], y[i]); }
+}
+
+template<typename T, typename Functor>
+void ScalarInstruction(int64_t n, const T* x, const T* y, T scalar, T* z) {
+  for (int64_t i = 0; i < n; ++i) { z[i] = Functor::Forward(x[i], scalar); }
+}
+
+template<typename T>
+struct ReluInstructionFunctor {
+  static const T Forward(const T x) { return x > T(0) ? x : T(0); }
+};
+
+template<typename T>
+struct GeluInstructionFunctor {
+  static const T Forward(const T x) {
+    return static_cast<T>(0.5) * x * (static_cast<T>(1) + std::erf(static_cast<T>(M_SQRT1_2) * x));
+  }
+};
+
+template<typename T>
+struct SigmoidInstructionFunctor {
+  static const T Forward(const T x) {
+    return static_cast<T>(1) / (static_cast<T>(1) + std::exp(-x));
+  }
+};
+
+template<typename T>
+struct TanhInstructionFunctor {
+  static const T Forward(const T x) { return std::tanh(x); }
+};
+
+template<typename T>
+struct LeakyReluInstructionFunctor {
+  static const T Forward(const T x, const T alpha) { return x > T(0) ? x : x * alpha; }
+};
+
+#define DEFINE_BINARY_INSTRUCTION_FUNCTOR(name, expr)               \
+  template<typename T>                                              \
+  struct name##InstructionFunctor {                                 \
+    static const T Forward(const T x, const T y) { return (expr); } \
+  };
+
+DEFINE_BINARY_INSTRUCTION_FUNCTOR(Add, x + y)
+DEFINE_BINARY_INSTRUCTION_FUNCTOR(Sub, x - y)
+DEFINE_BINARY_INSTRUCTION_FUNCTOR(Mul, x* y)
+DEFINE_BINARY_INSTRUCTION_FUNCTOR(Div, x / y)
+DEFINE_BINARY_INSTRUCTION_FUNCTOR(Minimum, x < y ? x : y)
+DEFINE_BINARY_INSTRUCTION_FUNCTOR(Maximum, x > y ? x : y)
+
+#undef DEFINE_BINARY_INSTRUCTION_FUNCTOR
+
+template<typename T>
+const HashMap<std::string, InstructionFn<T>>& InstructionName2Fn() {
+  static const HashMap<std::string, InstructionFn<T>> name2fn = [] {
+    HashMap<std::string, InstructionFn<T>> name2fn = {
+        {"relu", &UnaryInstruction<T, ReluInstructionFunctor<T>>},
+        {"gelu", &UnaryInstruction<T, GeluInstructionFunctor<T>>},
+        {"sigmoid", &UnaryInstruction<T, SigmoidInstructionFunctor<T>>},
+        {"tanh", &UnaryInstruction<T, TanhInstructionFunctor<T>>},
+        {"leaky_relu", &ScalarInstruction<T, LeakyReluInstructionFunctor<T>>},
+        {"scalar_add", &ScalarInstruction<T, AddInstructionFunctor<T>>},
+        {"scalar_mul", &ScalarInstruction<T, MulInstructionFunctor<T>>},
+        {"add", &BinaryInstruction<T, AddInstructionFunctor<T>>},
+        {"sub", &BinaryInstruction<T, SubInstructionFunctor<T>>},
+        {"mul", &BinaryInstruction<T, MulInstructionFunctor<T>>},
+        {"div", &BinaryInstruction<T, DivInstructionFunctor<T>>},
+        {"minimum", &BinaryInstruction<T, MinimumInstructionFunctor<T>>},
+        {"maximum", &BinaryInstruction<T, MaximumInstructionFunctor<T>>},
+    };
+#define INSERT_UNARY_FN(op_type_name, func_prefix) \
+  name2fn.emplace(op_type_name, &UnaryInstruction<T, func_prefix##Functor<T>>);
+#define INSERT_BINARY_FN(op_type_name, func_prefix) \
+  name2fn.emplace(op_type_name, &BinaryInstruction<T, func_prefix##Functor<T>>);
+    OF_PP_FOR_EACH_TUPLE(INSERT_UNARY_FN, MATH_UNARY_ELEMENTWISE_FUNC_SEQ)
+    OF_PP_FOR_EACH_TUPLE(INSERT_BINARY_FN, MATH_BINARY_ELEMENTWISE_FUNC_SEQ)
+#undef INSERT_BINARY_FN
+#undef INSERT_UNARY_FN
+    return name2fn;
+  }();
+  return name2fn;
+}
+
+template<typename T>
+struct CompiledProgram {
+  FusedElementwiseProgram program;
+  std::vector<InstructionFn<T>> fns;
+};
+
+template<typename T>
+size_t InferTmpSize(user_op::InferContext* ctx) {
+  FusedElementwiseProgram program;
+  CHECK_JUST(ParseFusedElementwiseProgram(ctx->Attr<std::string>("program"), ctx->inputs().size(),
+                                          &program));
+  return (program.num_inputs + program.instructions.size()) * kBlockSize * sizeof(T);
+}
+
+template<typename T>
+class CpuFusedElementwiseKernel final : public user_op::OpKernel {
+ public:
+  CpuFusedElementwiseKernel() = default;
+  ~CpuFusedElementwiseKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    auto state = std::make_shared<OpKernelStateWrapper<CompiledProgram<T>>>();
+    CompiledProgram<T>* compiled = state->Mutable();
+    CHECK_JUST(ParseFusedElementwiseProgram(ctx->Attr<std::string>("program"),
+                                            ctx->inputs().size(), &compiled->program));
+    for (const FusedElementwiseInstruction& instruction : compiled->program.instructions) {
+      compiled->fns.push_back(InstructionName2Fn<T>().at(instruction.name));
+    }
+    return state;
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const auto& compiled = dynamic_cast<OpKernelStateWrapper<CompiledProgram<T>>*>(state)->Get();
+    const FusedElementwiseProgram& program = compiled.program;
+    const auto& in_axis_offsets = ctx->Attr<std::vector<int32_t>>("in_axis_offsets");
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const int64_t elem_cnt = out->shape().elem_cnt();
+    const int64_t num_instructions = program.instructions.size();
+    std::vector<const user_op::Tensor*> ins;
+    std::vector<std::unique_ptr<FusedElementwiseBroadcast>> broadcasts;
+    FOR_RANGE(int32_t, i, 0, program.num_inputs) {
+      ins.push_back(ctx->Tensor4ArgNameAndIndex("in", i));
+      if (ins.back()->shape().elem_cnt() == elem_cnt) {
+        broadcasts.emplace_back(nullptr);
+      } else {
+        broadcasts.emplace_back(new FusedElementwiseBroadcast(
+            out->shape(), ins.back()->shape(), in_axis_offsets.at(i)));
+      }
+    }
+    T* buffer = tmp_buffer->mut_dptr<T>();
+    std::vector<const T*> registers(program.num_inputs + num_instructions);
+    for (int64_t start = 0; start < elem_cnt; start += kBlockSize) {
+      const int64_t n = std::min(kBlockSize, elem_cnt - start);
+      FOR_RANGE(int32_t, i, 0, program.num_inputs) {
+        const T* in_ptr = ins.at(i)->dptr<T>();
+        if (!broadcasts.at(i)) {
+          registers.at(i) = in_ptr + start;
+          continue;
+        }
+        T* gathered = buffer + i * kBlockSize;
+        broadcasts.at(i)->Gather(in_ptr, start, n, gathered);
+        registers.at(i) = gathered;
+      }
+      FOR_RANGE(int64_t, k, 0, num_instructions) {
+        const FusedElementwiseInstruction& instruction = program.instructions.at(k);
+        T* result = k == num_instructions - 1
+                        ? out->mut_dptr<T>() + start
+                        : buffer + (program.num_inputs + k) * kBlockSize;
+        const T* x = registers.at(instruction.operands.at(0));
+        const T* y = instruction.operands.size() > 1 ? registers.at(instruction.operands.at(1))
+                                                     : nullptr;
+        compiled.fns.at(k)(n, x, y, static_cast<T>(instruction.scalar), result);
+        registers.at(program.num_inputs + k) = result;
+      }
+    }
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+}  // namespace
+
+#define REGISTER_CPU_FUSED_ELEMENTWISE_KERNEL(dtype)                                  \
+  REGISTER_USER_KERNEL("fused_elementwise")                                           \
+      .SetCreateFn<CpuFusedElementwiseKernel<dtype>>()                                \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                 \
+                       & (user_op::HobDataType("out", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn(InferTmpSize<dtype>);
+
+REGISTER_CPU_FUSED_ELEMENTWISE_KERNEL(float)
+REGISTER_CPU_FUSED_ELEMENTWISE_KERNEL(double)
+
+}  // namespace oneflow
@@ -16,6 +16,9 @@ limitations under the License.
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/customized/image/image_util.h"
+#include "oneflow/customized/image/jpeg_decoder.h"
+#include "oneflow/customized/image/random_crop_generator.h"
+#include "oneflow/customized/kernels/random_seed_util.h"
 #include <opencv2/opencv.hpp>
 
 namespace oneflow {
@@ -89,5 +92,108 @@ REGISTER_USER_KERNEL("image_decode")
     .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)
                      & (user_op::HobDataType("in", 0) == DataType::kTensorBuffer)
                      & (user_op::HobDataType("out", 0) == DataType::kTensorBuffer));
-;
+
+namespace {
+
+void DecodeRandomCropResize(const TensorBuffer& raw_bytes, const std::string& color_space,
+                            int interp, RandomCropGenerator* random_crop_gen, cv::Mat* out_mat) {
+  CHECK(raw_bytes.data_type() == DataType::kChar || raw_bytes.data_type() == DataType::kInt8
+        || raw_bytes.data_type() == DataType::kUInt8);
+  const unsigned char* data = static_cast<const unsigned char*>(raw_bytes.data());
+  const size_t length = raw_bytes.elem_cnt();
+  int H = 0;
+  int W = 0;
+  CropWindow crop;
+  if (JpegGetImageSize(data, length, &H, &W)) {
+    random_crop_gen->GenerateCropWindow({H, W}, &crop);
+    if (JpegDecodeCropResize(data, length, color_space, crop, interp, out_mat)) { return; }
+  }
+  // not a jpeg or libjpeg failed, decode the full image by opencv
+  cv::Mat image = cv::imdecode(
+      cv::Mat(1, length, CV_8UC1, const_cast<unsigned char*>(data)),
+      ImageUtil::IsColor(color_space) ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE);
+  CHECK(image.data != nullptr);
+  if (image.rows != H || image.cols != W) {
+    random_crop_gen->GenerateCropWindow({image.rows, image.cols}, &crop);
+  }
+  if (ImageUtil::IsColor(color_space) && color_space != "BGR") {
+    ImageUtil::ConvertColor("BGR", image, color_space, image);
+  }
+  cv::Rect roi(crop.anchor.At(1), crop.anchor.At(0), crop.shape.At(1), crop.shape.At(0));
+  cv::resize(image(roi), *out_mat, out_mat->size(), 0, 0, interp);
+}
+
+class RandomCropGenerators final : public user_op::OpKernelState {
+ public:
+  RandomCropGenerators(AspectRatioRange aspect_ratio_range, AreaRange area_range, int64_t seed,
+                       int32_t num_attempts, int64_t batch_size) {
+    std::seed_seq seq{seed};
+    std::vector<int> seeds(batch_size);
+    seq.generate(seeds.begin(), seeds.end());
+    for (int64_t i = 0; i < batch_size; ++i) {
+      gens_.emplace_back(new RandomCropGenerator(aspect_ratio_range, area_range, seeds.at(i),
+                                                 num_attempts));
+    }
+  }
+  ~RandomCropGenerators() = default;
+
+  RandomCropGenerator* Get(int64_t idx) { return gens_.at(idx).get(); }
+
+ private:
+  std::vector<std::unique_ptr<RandomCropGenerator>> gens_;
+};
+
+}  // namespace
+
+class ImageDecodeRandomCropResizeKernel final : public user_op::OpKernel {
+ public:
+  ImageDecodeRandomCropResizeKernel() = default;
+  ~ImageDecodeRandomCropResizeKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    const std::vector<float>& random_aspect_ratio =
+        ctx->Attr<std::vector<float>>("random_aspect_ratio");
+    const std::vector<float>& random_area = ctx->Attr<std::vector<float>>("random_area");
+    const user_op::TensorDesc* out_tensor_desc = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+    return std::make_shared<RandomCropGenerators>(
+        AspectRatioRange(random_aspect_ratio.at(0), random_aspect_ratio.at(1)),
+        AreaRange(random_area.at(0), random_area.at(1)), GetOpKernelRandomSeed(ctx),
+        ctx->Attr<int32_t>("num_attempts"), out_tensor_desc->shape().At(0));
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    auto* generators = dynamic_cast<RandomCropGenerators*>(state);
+    const user_op::Tensor* in_tensor = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* out_tensor = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const int64_t record_num = in_tensor->shape().At(0);
+    CHECK_GT(record_num, 0);
+    const ShapeView& out_shape = out_tensor->shape();
+    CHECK_EQ(out_shape.NumAxes(), 4);  // {N, H, W, C}
+    CHECK_EQ(out_shape.At(0), record_num);
+    const int target_h = out_shape.At(1);
+    const int target_w = out_shape.At(2);
+    const int C = out_shape.At(3);
+    const int64_t one_sample_elem_cnt = out_shape.Count(1);
+    const std::string& color_space = ctx->Attr<std::string>("color_space");
+    const int interp = ImageUtil::GetOpencvInterp(ctx->Attr<std::string>("interp_type"));
+    const TensorBuffer* in_img_buf = in_tensor->dptr<TensorBuffer>();
+    uint8_t* out_dptr = out_tensor->mut_dptr<uint8_t>();
+
+    MultiThreadLoop(record_num, [&](size_t i) {
+      cv::Mat out_mat = CreateMatWithPtr(target_h, target_w, CV_MAKETYPE(CV_8U, C),
+                                         out_dptr + one_sample_elem_cnt * i);
+      DecodeRandomCropResize(in_img_buf[i], color_space, interp, generators->Get(i), &out_mat);
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("image_decode_random_crop_resize")
+    .SetCreateFn<ImageDecodeRandomCropResizeKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)
+                     & (user_op::HobDataType("in", 0) == DataType::kTensorBuffer)
+                     & (user_op::HobDataType("out", 0) == DataType::kUInt8));
+
 }  // namespace oneflow
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/customized/image/crop_mirror_normalize.h"
 #include "oneflow/customized/image/image_util.h"
 #include <opencv2/opencv.hpp>
 #include <cfenv>
@@ -131,20 +132,42 @@ DEFINE_STATIC_SWITCH_FUNC(void, ScalePolygons, MAKE_SCALE_POLYGONS_SWITCH_ENTRY,
 #undef MAKE_SCALE_POLYGONS_SWITCH_ENTRY
 
 template<typename T>
-void ImageNormalizeByChannel(TensorBuffer* image_buffer, const std::vector<float>& std_vec,
+void ImageNormalizeByChannel(const TensorBuffer& in_buffer, TensorBuffer* out_buffer,
+                             const std::vector<float>& std_vec,
                              const std::vector<float>& mean_vec) {
-  CHECK_EQ(image_buffer->shape().NumAxes(), 3);
-  int h = image_buffer->shape().At(0);
-  int w = image_buffer->shape().At(1);
-  int c = image_buffer->shape().At(2);
+  CHECK_EQ(in_buffer.shape().NumAxes(), 3);
+  int h = in_buffer.shape().At(0);
+  int w = in_buffer.shape().At(1);
+  int c = in_buffer.shape().At(2);
   CHECK_EQ(std_vec.size(), c);
   CHECK_EQ(mean_vec.size(), c);
+  out_buffer->Resize(in_buffer.shape(), in_buffer.data_type());
+  const T* in_data = in_buffer.data<T>();
+  T* out_data = out_buffer->mut_data<T>();
   FOR_RANGE(int, i, 0, (h * w)) {
-    T* image_data = image_buffer->mut_data<T>() + i * c;
-    FOR_RANGE(int, j, 0, c) { image_data[j] = (image_data[j] - mean_vec.at(j)) / std_vec.at(j); }
+    FOR_RANGE(int, j, 0, c) {
+      out_data[i * c + j] = (in_data[i * c + j] - mean_vec[j]) / std_vec[j];
+    }
   }
 }
 
+template<>
+void ImageNormalizeByChannel<float>(const TensorBuffer& in_buffer, TensorBuffer* out_buffer,
+                                    const std::vector<float>& std_vec,
+                                    const std::vector<float>& mean_vec) {
+  CHECK_EQ(in_buffer.shape().NumAxes(), 3);
+  int h = in_buffer.shape().At(0);
+  int w = in_buffer.shape().At(1);
+  int c = in_buffer.shape().At(2);
+  CHECK_EQ(std_vec.size(), c);
+  CHECK_EQ(mean_vec.size(), c);
+  out_buffer->Resize(in_buffer.shape(), in_buffer.data_type());
+  std::vector<float> inv_std_vec(c);
+  FOR_RANGE(int, j, 0, c) { inv_std_vec[j] = 1.0f / std_vec[j]; }
+  NormalizeHWC(in_buffer.data<float>(), h * w, c, mean_vec.data(), inv_std_vec.data(),
+               out_buffer->mut_data<float>());
+}
+
 #define MAKE_IMAGE_NORMALIZE_SWITCH_ENTRY(func_name, T) func_name<T>
 DEFINE_STATIC_SWITCH_FUNC(void, ImageNormalizeByChannel, MAKE_IMAGE_NORMALIZE_SWITCH_ENTRY,
                           MAKE_DATA_TYPE_CTRV_SEQ(FLOATING_DATA_TYPE_SEQ));
@@ -387,9 +410,8 @@ class ImageNormalize final : public user_op::OpKernel {
       const TensorBuffer& in_buffer = in_tensor->dptr<TensorBuffer>()[i];
       CHECK_EQ(in_buffer.shape().NumAxes(), 3);
       TensorBuffer* out_buffer = out_tensor->mut_dptr<TensorBuffer>() + i;
-      out_buffer->CopyFrom(in_buffer);
-      SwitchImageNormalizeByChannel(SwitchCase(out_buffer->data_type()), out_buffer, std_vec,
-                                    mean_vec);
+      SwitchImageNormalizeByChannel(SwitchCase(in_buffer.data_type()), in_buffer, out_buffer,
+                                    std_vec, mean_vec);
     });
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
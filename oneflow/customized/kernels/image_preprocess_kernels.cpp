@@ -19,28 +19,12 @@ limitations under the License.
 #include "oneflow/core/common/tensor_buffer.h"
 #include "oneflow/core/kernel/new_kernel_util.h"
 #include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/customized/image/crop_mirror_normalize.h"
 #include "oneflow/customized/image/image_util.h"
 #include "oneflow/customized/kernels/random_seed_util.h"
 
 namespace oneflow {
 
-namespace {
-
-int GetOpencvInterp(const std::string& interp_type) {
-  if (interp_type == "Linear") {
-    return cv::INTER_LINEAR;
-  } else if (interp_type == "NN") {
-    return cv::INTER_NEAREST;
-  } else if (interp_type == "Cubic") {
-    return cv::INTER_CUBIC;
-  } else {
-    UNIMPLEMENTED();
-    return -1;
-  }
-}
-
-}  // namespace
-
 class ResizeToStaticShapeKernel final : public user_op::OpKernel {
  public:
   ResizeToStaticShapeKernel() = default;
@@ -64,7 +48,7 @@ class ResizeToStaticShapeKernel final : public user_op::OpKernel {
     int channel_flag = C == 3 ? CV_8UC3 : CV_8UC1;
     const std::string& interp_type = ctx->Attr<std::string>("interp_type");
     int64_t one_sample_elem_cnt = rsz_h * rsz_w * C;
-    int opencv_inter_type = GetOpencvInterp(interp_type);
+    int opencv_inter_type = ImageUtil::GetOpencvInterp(interp_type);
 
     MultiThreadLoop(record_num, [&](size_t i) {
       const TensorBuffer* buffer = buffers + i;
@@ -124,7 +108,7 @@ class ResizeShorterToTensorBufferKernel final : public user_op::OpKernel {
       out_buffer->Resize(out_shape, DataType::kUInt8);
       int channel_flag = C == 3 ? CV_8UC3 : CV_8UC1;
       const std::string& interp_type = ctx->Attr<std::string>("interp_type");
-      int opencv_inter_type = GetOpencvInterp(interp_type);
+      int opencv_inter_type = ImageUtil::GetOpencvInterp(interp_type);
 
       const cv::Mat image = CreateMatWithPtr(H, W, channel_flag, in_buffer->data<uint8_t>());
       cv::Mat rsz_image = CreateMatWithPtr(rsz_h, rsz_w, channel_flag, out_buffer->data<uint8_t>());
@@ -142,58 +126,18 @@ REGISTER_USER_KERNEL("image_resize")
 
 namespace {
 
-enum TensorLayout {
-  kNCHW = 0,
-  kNHWC = 1,
-};
-
-template<TensorLayout layout>
-inline int64_t GetOffset(int64_t h, int64_t w, int64_t c, int64_t H, int64_t W, int64_t C);
-
-template<>
-inline int64_t GetOffset<TensorLayout::kNCHW>(int64_t h, int64_t w, int64_t c, int64_t H, int64_t W,
-                                              int64_t C) {
-  return c * H * W + h * W + w;  // C, H, W
-}
-
-template<>
-inline int64_t GetOffset<TensorLayout::kNHWC>(int64_t h, int64_t w, int64_t c, int64_t H, int64_t W,
-                                              int64_t C) {
-  return h * W * C + w * C + c;  // H, W, C
-}
-
-template<bool mirror>
-inline int64_t GetInputW(int64_t out_w, int64_t out_W, int64_t in_W, float crop_pos_x);
-
-template<>
-inline int64_t GetInputW<true>(int64_t out_w, int64_t out_W, int64_t in_W, float crop_pos_x) {
-  return (in_W - out_W) * crop_pos_x + (out_W - 1 - out_w);
-}
-
-template<>
-inline int64_t GetInputW<false>(int64_t out_w, int64_t out_W, int64_t in_W, float crop_pos_x) {
-  return (in_W - out_W) * crop_pos_x + out_w;
-}
-
-template<TensorLayout output_layout, bool mirror>
 void CMN1Sample(int64_t C, int64_t in_H, int64_t in_W, int64_t out_H, int64_t out_W,
-                float crop_pos_y, float crop_pos_x, const uint8_t* in_dptr, float* out_dptr,
-                const std::vector<float>& mean_vec, const std::vector<float>& inv_std_vec) {
+                float crop_pos_y, float crop_pos_x, bool mirror, bool out_nchw,
+                const uint8_t* in_dptr, float* out_dptr, const std::vector<float>& mean_vec,
+                const std::vector<float>& inv_std_vec) {
   CHECK_LE(out_H, in_H);
   CHECK_LE(out_W, in_W);
-  for (int64_t c = 0; c < C; ++c) {
-    float mean = mean_vec.at(c);
-    float inv_std = inv_std_vec.at(c);
-    for (int64_t out_h = 0; out_h < out_H; ++out_h) {
-      int64_t in_h = (in_H - out_H) * crop_pos_y + out_h;
-      for (int64_t out_w = 0; out_w < out_W; ++out_w) {
-        int64_t in_w = GetInputW<mirror>(out_w, out_W, in_W, crop_pos_x);
-        int64_t in_offset = GetOffset<TensorLayout::kNHWC>(in_h, in_w, c, in_H, in_W, C);
-        int64_t out_offset = GetOffset<output_layout>(out_h, out_w, c, out_H, out_W, C);
-        out_dptr[out_offset] = (static_cast<float>(in_dptr[in_offset]) - mean) * inv_std;
-      }
-    }
-  }
+  CHECK_EQ(mean_vec.size(), C);
+  CHECK_EQ(inv_std_vec.size(), C);
+  const int64_t crop_y = (in_H - out_H) * crop_pos_y;
+  const int64_t crop_x = (in_W - out_W) * crop_pos_x;
+  CropMirrorNormalize(in_dptr, in_W, C, crop_y, crop_x, out_H, out_W, mirror, out_nchw,
+                      mean_vec.data(), inv_std_vec.data(), out_dptr);
 }
 
 std::vector<int8_t> GetMirrorVec(user_op::KernelComputeContext* ctx) {
@@ -278,15 +222,9 @@ class CropMirrorNormalizeFromStaticShapeToFloatKernel final : public user_op::Op
       int64_t out_W = out_shape.At(3);
       int64_t out_image_elem_cnt = C * out_H * out_W;
       MultiThreadLoop(record_num, [&](size_t i) {
-        if (mirror.at(i)) {
-          CMN1Sample<TensorLayout::kNCHW, true>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_dptr + in_image_elem_cnt * i,
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        } else {
-          CMN1Sample<TensorLayout::kNCHW, false>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_dptr + in_image_elem_cnt * i,
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        }
+        CMN1Sample(C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, mirror.at(i), true,
+                   in_dptr + in_image_elem_cnt * i, out_dptr + out_image_elem_cnt * i, mean_vec,
+                   inv_std_vec);
       });
     } else if (output_layout == "NHWC") {
       CHECK_EQ(out_shape.At(3), C);
@@ -294,15 +232,9 @@ class CropMirrorNormalizeFromStaticShapeToFloatKernel final : public user_op::Op
       int64_t out_W = out_shape.At(2);
       int64_t out_image_elem_cnt = C * out_H * out_W;
       MultiThreadLoop(record_num, [&](size_t i) {
-        if (mirror.at(i)) {
-          CMN1Sample<TensorLayout::kNHWC, true>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_dptr + in_image_elem_cnt * i,
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        } else {
-          CMN1Sample<TensorLayout::kNHWC, false>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_dptr + in_image_elem_cnt * i,
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        }
+        CMN1Sample(C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, mirror.at(i), false,
+                   in_dptr + in_image_elem_cnt * i, out_dptr + out_image_elem_cnt * i, mean_vec,
+                   inv_std_vec);
       });
     } else {
       UNIMPLEMENTED();
@@ -362,15 +294,9 @@ class CropMirrorNormalizeFromTensorBufferToFloatKernel final : public user_op::O
         int64_t in_H = in_shape.At(0);
         int64_t in_W = in_shape.At(1);
         CHECK_EQ(C, in_shape.At(2));
-        if (mirror.at(i)) {
-          CMN1Sample<TensorLayout::kNCHW, true>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_buffer->data<uint8_t>(),
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        } else {
-          CMN1Sample<TensorLayout::kNCHW, false>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_buffer->data<uint8_t>(),
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        }
+        CMN1Sample(C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, mirror.at(i), true,
+                   in_buffer->data<uint8_t>(), out_dptr + out_image_elem_cnt * i, mean_vec,
+                   inv_std_vec);
       });
     } else if (output_layout == "NHWC") {
       CHECK_EQ(out_shape.At(3), C);
@@ -384,15 +310,9 @@ class CropMirrorNormalizeFromTensorBufferToFloatKernel final : public user_op::O
         int64_t in_H = in_shape.At(0);
         int64_t in_W = in_shape.At(1);
         CHECK_EQ(C, in_shape.At(2));
-        if (mirror.at(i)) {
-          CMN1Sample<TensorLayout::kNHWC, true>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_buffer->data<uint8_t>(),
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        } else {
-          CMN1Sample<TensorLayout::kNHWC, false>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_buffer->data<uint8_t>(),
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        }
+        CMN1Sample(C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, mirror.at(i), false,
+                   in_buffer->data<uint8_t>(), out_dptr + out_image_elem_cnt * i, mean_vec,
+                   inv_std_vec);
       });
     } else {
       UNIMPLEMENTED();
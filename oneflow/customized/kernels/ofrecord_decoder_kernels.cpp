@@ -19,6 +19,7 @@ limitations under the License.
 #include "oneflow/core/common/tensor_buffer.h"
 #include "oneflow/core/kernel/new_kernel_util.h"
 #include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/core/record/ofrecord_view.h"
 #include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/customized/image/random_crop_generator.h"
 #include "oneflow/customized/image/image_util.h"
@@ -67,6 +68,45 @@ void DecodeOneRawOFRecord(const Feature& feature, T* dptr, int64_t sample_elem_c
   }
 }
 
+template<typename T>
+void DecodeOneRawOFRecord(const FeatureView& feature, T* dptr, int64_t sample_elem_cnt,
+                          bool dim1_varying_length, bool auto_zero_padding) {
+  if (feature.has_bytes_list()) {
+    CHECK_EQ(feature.value_size(), 1);
+    const char* value0 = nullptr;
+    size_t value0_size = 0;
+    feature.GetBytesValue(0, &value0, &value0_size);
+    auto in_dptr = reinterpret_cast<const int8_t*>(value0);
+    sample_elem_cnt = std::min<int64_t>(sample_elem_cnt, value0_size);
+    CopyElem<int8_t, T>(in_dptr, dptr, sample_elem_cnt);
+  } else if (feature.kind_case() != FeatureView::kKindNotSet) {
+    const int64_t value_size = feature.value_size();
+    const int64_t padding_elem_num = auto_zero_padding ? sample_elem_cnt - value_size : 0;
+    if (dim1_varying_length || auto_zero_padding) {
+      CHECK_LE(value_size, sample_elem_cnt);
+      sample_elem_cnt = value_size;
+    } else {
+      CHECK_EQ(sample_elem_cnt, value_size);
+    }
+    feature.CopyValues<T>(dptr, sample_elem_cnt);
+    if (padding_elem_num > 0) {
+      std::memset(dptr + sample_elem_cnt, 0, padding_elem_num * sizeof(T));
+    }
+  } else {
+    UNIMPLEMENTED();
+  }
+}
+
+// Serialized records come in as kTensorBuffer when the reader runs with lazy_parse. Only the
+// requested feature is indexed and its bytes are read in place.
+const FeatureView& FindFeatureInSerializedRecord(const TensorBuffer& record, OFRecordView* view,
+                                                const std::string& name) {
+  CHECK(view->Parse(record.data<char>(), record.nbytes()));
+  const FeatureView* feature = view->Find(name);
+  CHECK(feature != nullptr) << "Field " << name << " not found";
+  return *feature;
+}
+
 }  // namespace
 
 template<typename T>
@@ -83,30 +123,43 @@ class OFRecordRawDecoderKernel final : public user_op::OpKernel {
     int64_t record_num = in_blob->shape().At(0);
     int64_t sample_elem_cnt = out_blob->shape().Count(1);
     CHECK(record_num > 0);
-    const OFRecord* records = in_blob->dptr<OFRecord>();
     T* out_dptr = out_blob->mut_dptr<T>();
     const std::string& name = ctx->Attr<std::string>("name");
 
     bool auto_zero_padding = ctx->Attr<bool>("auto_zero_padding");
     bool dim1_varying_length = ctx->Attr<bool>("dim1_varying_length");
 
+    if (in_blob->data_type() == DataType::kTensorBuffer) {
+      const TensorBuffer* records = in_blob->dptr<TensorBuffer>();
+      const std::vector<std::string> keys{name};
+      MultiThreadLoop(record_num, [&](size_t i) {
+        OFRecordView view(keys);
+        const FeatureView& feature = FindFeatureInSerializedRecord(records[i], &view, name);
+        T* dptr = out_dptr + i * sample_elem_cnt;
+        DecodeOneRawOFRecord(feature, dptr, sample_elem_cnt, dim1_varying_length,
+                             auto_zero_padding);
+      });
+      return;
+    }
+    const OFRecord* records = in_blob->dptr<OFRecord>();
     MultiThreadLoop(record_num, [&](size_t i) {
       const OFRecord& record = *(records + i);
       T* dptr = out_dptr + i * sample_elem_cnt;
       CHECK(record.feature().find(name) != record.feature().end())
           << "Field " << name << " not found";
       const Feature& feature = record.feature().at(name);
-      DecodeOneRawOFRecord(feature, dptr, sample_elem_cnt, auto_zero_padding, dim1_varying_length);
+      DecodeOneRawOFRecord(feature, dptr, sample_elem_cnt, dim1_varying_length, auto_zero_padding);
     });
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
 
-#define REGISTER_RAW_DECODER_KERNEL(dtype)                                      \
-  REGISTER_USER_KERNEL("ofrecord_raw_decoder")                                  \
-      .SetCreateFn<OFRecordRawDecoderKernel<dtype>>()                           \
-      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)           \
-                       & (user_op::HobDataType("in", 0) == DataType::kOFRecord) \
+#define REGISTER_RAW_DECODER_KERNEL(dtype)                                              \
+  REGISTER_USER_KERNEL("ofrecord_raw_decoder")                                          \
+      .SetCreateFn<OFRecordRawDecoderKernel<dtype>>()                                   \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                   \
+                       & ((user_op::HobDataType("in", 0) == DataType::kOFRecord)        \
+                          | (user_op::HobDataType("in", 0) == DataType::kTensorBuffer)) \
                        & (user_op::HobDataType("out", 0) == GetDataType<dtype>::value));
 
 REGISTER_RAW_DECODER_KERNEL(char)
@@ -119,19 +172,12 @@ REGISTER_RAW_DECODER_KERNEL(uint8_t)
 
 namespace {
 
-void DecodeRandomCropImageFromOneRecord(const OFRecord& record, TensorBuffer* buffer,
-                                        const std::string& name, const std::string& color_space,
-                                        RandomCropGenerator* random_crop_gen) {
-  CHECK(record.feature().find(name) != record.feature().end()) << "Field " << name << " not found";
-  const Feature& feature = record.feature().at(name);
-  CHECK(feature.has_bytes_list());
-  CHECK(feature.bytes_list().value_size() == 1);
-  const std::string& src_data = feature.bytes_list().value(0);
-
-  // cv::_InputArray image_data(src_data.data(), src_data.size());
+void DecodeRandomCropImage(const char* src_data, size_t src_size, TensorBuffer* buffer,
+                           const std::string& color_space, RandomCropGenerator* random_crop_gen) {
+  // cv::_InputArray image_data(src_data, src_size);
   // cv::Mat image = cv::imdecode(image_data, cv::IMREAD_ANYCOLOR);
   cv::Mat image =
-      cv::imdecode(cv::Mat(1, src_data.size(), CV_8UC1, (void*)(src_data.data())),  // NOLINT
+      cv::imdecode(cv::Mat(1, src_size, CV_8UC1, (void*)(src_data)),  // NOLINT
                    ImageUtil::IsColor(color_space) ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE);
   int W = image.cols;
   int H = image.rows;
@@ -172,6 +218,31 @@ void DecodeRandomCropImageFromOneRecord(const OFRecord& record, TensorBuffer* bu
   memcpy(buffer->mut_data<uint8_t>(), image.ptr(), image_shape.elem_cnt());
 }
 
+void DecodeRandomCropImageFromOneRecord(const OFRecord& record, TensorBuffer* buffer,
+                                        const std::string& name, const std::string& color_space,
+                                        RandomCropGenerator* random_crop_gen) {
+  CHECK(record.feature().find(name) != record.feature().end()) << "Field " << name << " not found";
+  const Feature& feature = record.feature().at(name);
+  CHECK(feature.has_bytes_list());
+  CHECK(feature.bytes_list().value_size() == 1);
+  const std::string& src_data = feature.bytes_list().value(0);
+  DecodeRandomCropImage(src_data.data(), src_data.size(), buffer, color_space, random_crop_gen);
+}
+
+void DecodeRandomCropImageFromOneRecord(const TensorBuffer& record, TensorBuffer* buffer,
+                                        const std::string& name, const std::string& color_space,
+                                        RandomCropGenerator* random_crop_gen) {
+  const std::vector<std::string> keys{name};
+  OFRecordView view(keys);
+  const FeatureView& feature = FindFeatureInSerializedRecord(record, &view, name);
+  CHECK(feature.has_bytes_list());
+  CHECK(feature.value_size() == 1);
+  const char* src_data = nullptr;
+  size_t src_size = 0;
+  feature.GetBytesValue(0, &src_data, &src_size);
+  DecodeRandomCropImage(src_data, src_size, buffer, color_space, random_crop_gen);
+}
+
 class RandCropGens final : public user_op::OpKernelState {
  public:
   explicit RandCropGens(int32_t size) : gens_(size) {}
@@ -190,6 +261,33 @@ class RandCropGens final : public user_op::OpKernelState {
   std::vector<std::shared_ptr<RandomCropGenerator>> gens_;
 };
 
+template<typename RecordT>
+void DecodeRandomCropImagesFromRecords(const user_op::Tensor* in_blob,
+                                       user_op::Tensor* out_blob, const std::string& name,
+                                       const std::string& color_space,
+                                       RandCropGens* crop_window_generators) {
+  const int64_t record_num = out_blob->shape().At(0);
+  const RecordT* records = in_blob->dptr<RecordT>();
+  TensorBuffer* buffers = out_blob->mut_dptr<TensorBuffer>();
+  MultiThreadLoop(record_num, [&](size_t i) {
+    RandomCropGenerator* gen =
+        crop_window_generators == nullptr ? nullptr : crop_window_generators->Get(i);
+    DecodeRandomCropImageFromOneRecord(records[i], buffers + i, name, color_space, gen);
+  });
+}
+
+void DecodeRandomCropImages(const user_op::Tensor* in_blob, user_op::Tensor* out_blob,
+                            const std::string& name, const std::string& color_space,
+                            RandCropGens* crop_window_generators) {
+  if (in_blob->data_type() == DataType::kTensorBuffer) {
+    DecodeRandomCropImagesFromRecords<TensorBuffer>(in_blob, out_blob, name, color_space,
+                                                    crop_window_generators);
+  } else {
+    DecodeRandomCropImagesFromRecords<OFRecord>(in_blob, out_blob, name, color_space,
+                                                crop_window_generators);
+  }
+}
+
 }  // namespace
 
 class OFRecordImageDecoderRandomCropKernel final : public user_op::OpKernel {
@@ -234,17 +332,9 @@ class OFRecordImageDecoderRandomCropKernel final : public user_op::OpKernel {
     CHECK(record_num > 0);
     user_op::Tensor* in_blob = ctx->Tensor4ArgNameAndIndex("in", 0);
     CHECK_EQ(out_blob->shape(), in_blob->shape());
-    const OFRecord* records = in_blob->dptr<OFRecord>();
-    TensorBuffer* buffers = out_blob->mut_dptr<TensorBuffer>();
     const std::string& name = ctx->Attr<std::string>("name");
     const std::string& color_space = ctx->Attr<std::string>("color_space");
-
-    MultiThreadLoop(record_num, [&](size_t i) {
-      const OFRecord& record = *(records + i);
-      TensorBuffer* buffer = buffers + i;
-      RandomCropGenerator* gen = crop_window_generators->Get(i);
-      DecodeRandomCropImageFromOneRecord(record, buffer, name, color_space, gen);
-    });
+    DecodeRandomCropImages(in_blob, out_blob, name, color_space, crop_window_generators);
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -252,7 +342,8 @@ class OFRecordImageDecoderRandomCropKernel final : public user_op::OpKernel {
 REGISTER_USER_KERNEL("ofrecord_image_decoder_random_crop")
     .SetCreateFn<OFRecordImageDecoderRandomCropKernel>()
     .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)
-                     & (user_op::HobDataType("in", 0) == DataType::kOFRecord)
+                     & ((user_op::HobDataType("in", 0) == DataType::kOFRecord)
+                        | (user_op::HobDataType("in", 0) == DataType::kTensorBuffer))
                      & (user_op::HobDataType("out", 0) == DataType::kTensorBuffer));
 
 class OFRecordImageDecoderKernel final : public user_op::OpKernel {
@@ -267,16 +358,9 @@ class OFRecordImageDecoderKernel final : public user_op::OpKernel {
     CHECK(record_num > 0);
     user_op::Tensor* in_blob = ctx->Tensor4ArgNameAndIndex("in", 0);
     CHECK_EQ(out_blob->shape(), in_blob->shape());
-    const OFRecord* records = in_blob->dptr<OFRecord>();
-    TensorBuffer* buffers = out_blob->mut_dptr<TensorBuffer>();
     const std::string& name = ctx->Attr<std::string>("name");
     const std::string& color_space = ctx->Attr<std::string>("color_space");
-
-    MultiThreadLoop(record_num, [&](size_t i) {
-      const OFRecord& record = *(records + i);
-      TensorBuffer* buffer = buffers + i;
-      DecodeRandomCropImageFromOneRecord(record, buffer, name, color_space, nullptr);
-    });
+    DecodeRandomCropImages(in_blob, out_blob, name, color_space, nullptr);
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -284,7 +368,8 @@ class OFRecordImageDecoderKernel final : public user_op::OpKernel {
 REGISTER_USER_KERNEL("ofrecord_image_decoder")
     .SetCreateFn<OFRecordImageDecoderKernel>()
     .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)
-                     & (user_op::HobDataType("in", 0) == DataType::kOFRecord)
+                     & ((user_op::HobDataType("in", 0) == DataType::kOFRecord)
+                        | (user_op::HobDataType("in", 0) == DataType::kTensorBuffer))
                      & (user_op::HobDataType("out", 0) == DataType::kTensorBuffer));
 
 }  // namespace oneflow
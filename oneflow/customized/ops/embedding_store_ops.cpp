@@ -0,0 +1,158 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+// store_name is the name of the "shadow" variable that stands for the store in the job: it
+// makes the lookup part of the backward pass, orders the update of step i before the lookup of
+// step i + 1 like any other model update, and is the key the store is saved and loaded under
+#define EMBEDDING_STORE_ATTRS                                                 \
+  Attr("store_name", UserOpAttrType::kAtString)                               \
+      .Attr("embedding_dim", UserOpAttrType::kAtInt64)                        \
+      .Attr<std::string>("optimizer", UserOpAttrType::kAtString, "sgd")       \
+      .Attr<float>("beta1", UserOpAttrType::kAtFloat, 0.9)                    \
+      .Attr<float>("beta2", UserOpAttrType::kAtFloat, 0.999)                  \
+      .Attr<float>("epsilon", UserOpAttrType::kAtFloat, 1e-8)                 \
+      .Attr<int64_t>("num_shards", UserOpAttrType::kAtInt64, 16)              \
+      .Attr<int64_t>("cache_capacity", UserOpAttrType::kAtInt64, 0)           \
+      .Attr<std::string>("storage_dir", UserOpAttrType::kAtString, "")        \
+      .Attr<float>("init_scale", UserOpAttrType::kAtFloat, 0.05)              \
+      .Attr<int64_t>("seed", UserOpAttrType::kAtInt64, 0)
+
+namespace {
+
+Maybe<void> CheckEmbeddingStoreAttrs(user_op::InferContext* ctx) {
+  CHECK_GT_OR_RETURN(ctx->Attr<int64_t>("embedding_dim"), 0);
+  CHECK_GT_OR_RETURN(ctx->Attr<int64_t>("num_shards"), 0);
+  const std::string& optimizer = ctx->Attr<std::string>("optimizer");
+  CHECK_OR_RETURN(optimizer == "sgd" || optimizer == "adam")
+      << "embedding store optimizer must be sgd or adam, got " << optimizer;
+  const user_op::TensorDesc* shadow = ctx->TensorDesc4ArgNameAndIndex("shadow", 0);
+  CHECK_EQ_OR_RETURN(shadow->data_type(), DataType::kFloat);
+  CHECK_OR_RETURN(IsIndexDataType(ctx->TensorDesc4ArgNameAndIndex("ids", 0)->data_type()));
+  // the store lives in one process, the ids are not routed between devices
+  CHECK_EQ_OR_RETURN(ctx->parallel_ctx().parallel_num(), 1);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_CPU_ONLY_USER_OP("embedding_store_lookup")
+    .Input("shadow")
+    .Input("ids")
+    .Output("embeddings")
+    .EMBEDDING_STORE_ATTRS
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      JUST(CheckEmbeddingStoreAttrs(ctx));
+      const user_op::TensorDesc* ids = ctx->TensorDesc4ArgNameAndIndex("ids", 0);
+      user_op::TensorDesc* embeddings = ctx->TensorDesc4ArgNameAndIndex("embeddings", 0);
+      DimVector dim_vec = ids->shape().dim_vec();
+      dim_vec.push_back(ctx->Attr<int64_t>("embedding_dim"));
+      *embeddings->mut_shape() = Shape(dim_vec);
+      *embeddings->mut_data_type() = DataType::kFloat;
+      embeddings->set_is_dynamic(ids->is_dynamic());
+      return Maybe<void>::Ok();
+    })
+    .SetInputArgModifyFn([](user_op::GetInputArgModifier GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper&) {
+      user_op::InputArgModifier* ids_modifier = GetInputArgModifierFn("ids", 0);
+      CHECK(ids_modifier != nullptr);
+      ids_modifier->set_requires_grad(false);
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      *ctx->BatchAxis4ArgNameAndIndex("embeddings", 0) = *ctx->BatchAxis4ArgNameAndIndex("ids", 0);
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder().Broadcast(ctx->inputs()).Broadcast(ctx->outputs()).Build();
+      return Maybe<void>::Ok();
+    });
+
+// applies the summed embedding_diff of every unique id to the store and outputs a zero
+// shadow_diff, so that the optimizer of the shadow variable leaves it alone; learning_rate and
+// train_step are those of the model update op of the shadow variable, bound by
+// EmbeddingStoreOptimizerPass once the optimizer ops are generated
+REGISTER_CPU_ONLY_USER_OP("embedding_store_update")
+    .Input("shadow")
+    .Input("ids")
+    .Input("embedding_diff")
+    .OptionalInput("learning_rate")
+    .OptionalInput("train_step")
+    .Output("shadow_diff")
+    .EMBEDDING_STORE_ATTRS
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      JUST(CheckEmbeddingStoreAttrs(ctx));
+      const user_op::TensorDesc* ids = ctx->TensorDesc4ArgNameAndIndex("ids", 0);
+      const user_op::TensorDesc* embedding_diff =
+          ctx->TensorDesc4ArgNameAndIndex("embedding_diff", 0);
+      CHECK_EQ_OR_RETURN(embedding_diff->data_type(), DataType::kFloat);
+      CHECK_EQ_OR_RETURN(embedding_diff->shape().elem_cnt(),
+                         ids->shape().elem_cnt() * ctx->Attr<int64_t>("embedding_dim"));
+      if (ctx->user_op_conf().has_input("learning_rate", 0)) {
+        const user_op::TensorDesc* learning_rate =
+            ctx->TensorDesc4ArgNameAndIndex("learning_rate", 0);
+        CHECK_EQ_OR_RETURN(learning_rate->data_type(), DataType::kFloat);
+        CHECK_EQ_OR_RETURN(learning_rate->shape().elem_cnt(), 1);
+      }
+      if (ctx->user_op_conf().has_input("train_step", 0)) {
+        const user_op::TensorDesc* train_step = ctx->TensorDesc4ArgNameAndIndex("train_step", 0);
+        CHECK_EQ_OR_RETURN(train_step->data_type(), DataType::kInt64);
+        CHECK_EQ_OR_RETURN(train_step->shape().elem_cnt(), 1);
+      }
+      *ctx->TensorDesc4ArgNameAndIndex("shadow_diff", 0) =
+          *ctx->TensorDesc4ArgNameAndIndex("shadow", 0);
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      *ctx->BatchAxis4ArgNameAndIndex("shadow_diff", 0) =
+          *ctx->BatchAxis4ArgNameAndIndex("shadow", 0);
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder().Broadcast(ctx->inputs()).Broadcast(ctx->outputs()).Build();
+      return Maybe<void>::Ok();
+    });
+
+#undef EMBEDDING_STORE_ATTRS
+
+REGISTER_USER_OP_GRAD("embedding_store_lookup")
+    .SetGenBackwardOpConfFn([](const user_op::UserOpWrapper& op, user_op::AddOpFn AddOp) {
+      if (!op.NeedGenGradTensor4OpInput("shadow", 0)) { return; }
+      user_op::UserOpConfWrapper update_op =
+          user_op::UserOpConfWrapperBuilder(op.op_name() + "_update")
+              .Op("embedding_store_update")
+              .Input("shadow", op.input("shadow", 0))
+              .Input("ids", op.input("ids", 0))
+              .Input("embedding_diff", op.GetGradTensorWithOpOutput("embeddings", 0))
+              .Output("shadow_diff")
+              .Attr("store_name", op.attr<std::string>("store_name"))
+              .Attr("embedding_dim", op.attr<int64_t>("embedding_dim"))
+              .Attr("optimizer", op.attr<std::string>("optimizer"))
+              .Attr("beta1", op.attr<float>("beta1"))
+              .Attr("beta2", op.attr<float>("beta2"))
+              .Attr("epsilon", op.attr<float>("epsilon"))
+              .Attr("num_shards", op.attr<int64_t>("num_shards"))
+              .Attr("cache_capacity", op.attr<int64_t>("cache_capacity"))
+              .Attr("storage_dir", op.attr<std::string>("storage_dir"))
+              .Attr("init_scale", op.attr<float>("init_scale"))
+              .Attr("seed", op.attr<int64_t>("seed"))
+              .Build();
+      op.BindGradTensorWithOpInput(update_op.output("shadow_diff", 0), "shadow", 0);
+      AddOp(update_op);
+    });
+
+}  // namespace oneflow
@@ -0,0 +1,61 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+REGISTER_USER_OP("fold_batch_norm_params")
+    .Input("weight")
+    .OptionalInput("bias")
+    .Input("moving_mean")
+    .Input("moving_variance")
+    .Input("gamma")
+    .Input("beta")
+    .Output("folded_weight")
+    .Output("folded_bias")
+    .Attr("weight_channel_axis", UserOpAttrType::kAtInt32)
+    .Attr("epsilon", UserOpAttrType::kAtFloat)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* weight = ctx->TensorDesc4ArgNameAndIndex("weight", 0);
+      const user_op::TensorDesc* moving_mean = ctx->TensorDesc4ArgNameAndIndex("moving_mean", 0);
+      const int32_t weight_channel_axis = ctx->Attr<int32_t>("weight_channel_axis");
+      CHECK_GE_OR_RETURN(weight_channel_axis, 0);
+      CHECK_LT_OR_RETURN(weight_channel_axis, weight->shape().NumAxes());
+      CHECK_OR_RETURN(!weight->is_dynamic());
+      const Shape channel_shape({weight->shape().At(weight_channel_axis)});
+      std::vector<std::string> param_arg_names = {"moving_mean", "moving_variance", "gamma",
+                                                  "beta"};
+      if (ctx->user_op_conf().has_input("bias", 0)) { param_arg_names.push_back("bias"); }
+      for (const std::string& arg_name : param_arg_names) {
+        const user_op::TensorDesc* param = ctx->TensorDesc4ArgNameAndIndex(arg_name, 0);
+        CHECK_OR_RETURN(param->shape() == channel_shape) << arg_name;
+        CHECK_EQ_OR_RETURN(param->data_type(), weight->data_type()) << arg_name;
+      }
+      *ctx->TensorDesc4ArgNameAndIndex("folded_weight", 0) = *weight;
+      *ctx->TensorDesc4ArgNameAndIndex("folded_bias", 0) = *moving_mean;
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      ctx->BatchAxis4ArgNameAndIndex("folded_weight", 0)->clear_value();
+      ctx->BatchAxis4ArgNameAndIndex("folded_bias", 0)->clear_value();
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder().Broadcast(ctx->inputs()).Broadcast(ctx->outputs()).Build();
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
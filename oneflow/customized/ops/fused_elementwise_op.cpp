@@ -0,0 +1,113 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/customized/utils/fused_elementwise_program.h"
+
+namespace oneflow {
+
+namespace {
+
+// input i covers the axes [in_axis_offsets[i], in_axis_offsets[i] + num_axes) of out and is
+// broadcast along the others and along its axes of size 1
+Maybe<void> InferOutShape(const std::vector<const Shape*>& in_shapes,
+                          const std::vector<int32_t>& in_axis_offsets, Shape* out_shape) {
+  CHECK_EQ_OR_RETURN(in_shapes.size(), in_axis_offsets.size());
+  int64_t num_axes = 0;
+  FOR_RANGE(int64_t, i, 0, in_shapes.size()) {
+    CHECK_GE_OR_RETURN(in_axis_offsets.at(i), 0);
+    num_axes = std::max(num_axes, in_axis_offsets.at(i) + in_shapes.at(i)->NumAxes());
+  }
+  DimVector dim_vec(num_axes, 1);
+  FOR_RANGE(int64_t, i, 0, in_shapes.size()) {
+    FOR_RANGE(int64_t, axis, 0, in_shapes.at(i)->NumAxes()) {
+      const int64_t dim = in_shapes.at(i)->At(axis);
+      int64_t* out_dim = &dim_vec.at(in_axis_offsets.at(i) + axis);
+      if (dim == 1) { continue; }
+      CHECK_OR_RETURN(*out_dim == 1 || *out_dim == dim);
+      *out_dim = dim;
+    }
+  }
+  *out_shape = Shape(dim_vec);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_USER_OP("fused_elementwise")
+    .InputWithMinimum("in", 1)
+    .Output("out")
+    .Attr("program", UserOpAttrType::kAtString)
+    .Attr("in_axis_offsets", UserOpAttrType::kAtListInt32)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const int32_t num_inputs = ctx->inputs().size();
+      FusedElementwiseProgram program;
+      JUST(ParseFusedElementwiseProgram(ctx->Attr<std::string>("program"), num_inputs, &program));
+      const user_op::TensorDesc* in_0 = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      std::vector<const Shape*> in_shapes;
+      FOR_RANGE(int32_t, i, 0, num_inputs) {
+        const user_op::TensorDesc* in = ctx->TensorDesc4ArgNameAndIndex("in", i);
+        CHECK_EQ_OR_RETURN(in->data_type(), in_0->data_type());
+        CHECK_OR_RETURN(!in->is_dynamic());
+        in_shapes.push_back(&in->shape());
+      }
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *in_0;
+      JUST(InferOutShape(in_shapes, ctx->Attr<std::vector<int32_t>>("in_axis_offsets"),
+                         out->mut_shape()));
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn(user_op::BatchAxisInferFnUtil::NaiveInferBatchAxis)
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      const int32_t num_inputs = ctx->inputs().size();
+      const auto& in_axis_offsets = ctx->Attr<std::vector<int32_t>>("in_axis_offsets");
+      std::vector<const Shape*> in_shapes;
+      FOR_RANGE(int32_t, i, 0, num_inputs) {
+        in_shapes.push_back(&ctx->LogicalTensorDesc4InputArgNameAndIndex("in", i).shape());
+      }
+      Shape out_shape;
+      JUST(InferOutShape(in_shapes, in_axis_offsets, &out_shape));
+      FOR_RANGE(int64_t, axis, 0, out_shape.NumAxes()) {
+        if (out_shape.At(axis) == 1) { continue; }
+        auto builder = ctx->NewBuilder();
+        FOR_RANGE(int32_t, i, 0, num_inputs) {
+          const int64_t in_axis = axis - in_axis_offsets.at(i);
+          if (in_axis >= 0 && in_axis < in_shapes.at(i)->NumAxes()
+              && in_shapes.at(i)->At(in_axis) != 1) {
+            builder.Split(user_op::OpArg("in", i), in_axis);
+          } else {
+            builder.Broadcast(user_op::OpArg("in", i));
+          }
+        }
+        builder.Split(user_op::OpArg("out", 0), axis).Build();
+      }
+      ctx->NewBuilder().Broadcast(ctx->inputs()).Broadcast(user_op::OpArg("out", 0)).Build();
+      FusedElementwiseProgram program;
+      JUST(ParseFusedElementwiseProgram(ctx->Attr<std::string>("program"), num_inputs, &program));
+      ForEachPartialSumInputs(program, [&](const std::vector<bool>& is_partial_sum_input) {
+        auto builder = ctx->NewBuilder();
+        FOR_RANGE(int32_t, i, 0, num_inputs) {
+          if (is_partial_sum_input.at(i)) {
+            builder.PartialSum(user_op::OpArg("in", i));
+          } else {
+            builder.Broadcast(user_op::OpArg("in", i));
+          }
+        }
+        builder.PartialSum(user_op::OpArg("out", 0)).Build();
+      });
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
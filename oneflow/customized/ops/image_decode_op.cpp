@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
+#include "oneflow/customized/image/image_util.h"
 
 namespace oneflow {
 
@@ -60,4 +61,57 @@ REGISTER_CPU_ONLY_USER_OP("image_decode")
       return Maybe<void>::Ok();
     });
 
+REGISTER_CPU_ONLY_USER_OP("image_decode_random_crop_resize")
+    .Input("in")
+    .Output("out")
+    .Attr("target_width", UserOpAttrType::kAtInt64)
+    .Attr("target_height", UserOpAttrType::kAtInt64)
+    .Attr<std::string>("color_space", UserOpAttrType::kAtString, "BGR")
+    .Attr<std::string>("interp_type", UserOpAttrType::kAtString, "Linear")
+    .Attr<int32_t>("num_attempts", UserOpAttrType::kAtInt32, 10)
+    .Attr<int64_t>("seed", UserOpAttrType::kAtInt64, -1)
+    .Attr<bool>("has_seed", UserOpAttrType::kAtBool, false)
+    .Attr<std::vector<float>>("random_area", UserOpAttrType::kAtListFloat, {0.08, 1.0})
+    .Attr<std::vector<float>>("random_aspect_ratio", UserOpAttrType::kAtListFloat, {0.75, 1.333333})
+    .SetCheckAttrFn([](const user_op::UserOpDefWrapper& def,
+                       const user_op::UserOpConfWrapper& conf) -> Maybe<void> {
+      const std::string& color_space = conf.attr<std::string>("color_space");
+      CHECK_OR_RETURN(color_space == "BGR" || color_space == "RGB" || color_space == "GRAY")
+          << "color_space: " << color_space << " (can only be one of BGR, RGB and GRAY)";
+      const std::string& interp_type = conf.attr<std::string>("interp_type");
+      CHECK_OR_RETURN(interp_type == "Linear" || interp_type == "NN" || interp_type == "Cubic")
+          << "interp_type: " << interp_type << " (can only be one of Linear, NN and Cubic)";
+      CHECK_GT_OR_RETURN(conf.attr<int64_t>("target_width"), 0);
+      CHECK_GT_OR_RETURN(conf.attr<int64_t>("target_height"), 0);
+      CHECK_GE_OR_RETURN(conf.attr<int32_t>("num_attempts"), 1);
+      const std::vector<float>& random_area = conf.attr<std::vector<float>>("random_area");
+      CHECK_OR_RETURN(random_area.size() == 2 && 0 < random_area.at(0)
+                      && random_area.at(0) <= random_area.at(1));
+      const std::vector<float>& random_aspect_ratio =
+          conf.attr<std::vector<float>>("random_aspect_ratio");
+      CHECK_OR_RETURN(random_aspect_ratio.size() == 2 && 0 < random_aspect_ratio.at(0)
+                      && random_aspect_ratio.at(0) <= random_aspect_ratio.at(1));
+      return Maybe<void>::Ok();
+    })
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* in_desc = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      CHECK_OR_RETURN(in_desc->data_type() == DataType::kTensorBuffer);
+      CHECK_OR_RETURN(in_desc->shape().NumAxes() == 1 && in_desc->shape().At(0) >= 1);
+      const int64_t c = ImageUtil::IsColor(ctx->Attr<std::string>("color_space")) ? 3 : 1;
+      user_op::TensorDesc* out_desc = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out_desc->mut_shape() = Shape({in_desc->shape().At(0), ctx->Attr<int64_t>("target_height"),
+                                      ctx->Attr<int64_t>("target_width"), c});
+      *out_desc->mut_data_type() = DataType::kUInt8;
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder().Split(ctx->inputs(), 0).Split(ctx->outputs(), 0).Build();
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      CHECK_EQ_OR_RETURN(ctx->BatchAxis4ArgNameAndIndex("in", 0)->value(), 0);
+      ctx->BatchAxis4ArgNameAndIndex("out", 0)->set_value(0);
+      return Maybe<void>::Ok();
+    });
+
 }  // namespace oneflow
@@ -28,6 +28,12 @@ REGISTER_CPU_ONLY_USER_OP("OFRecordReader")
     .Attr<int64_t>("seed", UserOpAttrType::kAtInt64, -1)
     .Attr<int32_t>("shuffle_buffer_size", UserOpAttrType::kAtInt32, 1024)
     .Attr<bool>("shuffle_after_epoch", UserOpAttrType::kAtBool, false)
+    // output the serialized records as kTensorBuffer and let the decoders index them lazily
+    .Attr<bool>("lazy_parse", UserOpAttrType::kAtBool, false)
+    // read through the "<part>.index" files: random_shuffle becomes a global shuffle and
+    // resume_sample_count (samples consumed by the whole job so far) is reached without scanning
+    .Attr<bool>("indexed", UserOpAttrType::kAtBool, false)
+    .Attr<int64_t>("resume_sample_count", UserOpAttrType::kAtInt64, 0)
     .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
       user_op::TensorDesc* out_tensor = ctx->TensorDesc4ArgNameAndIndex("out", 0);
       int32_t local_batch_size = ctx->Attr<int32_t>("batch_size");
@@ -38,7 +44,8 @@ REGISTER_CPU_ONLY_USER_OP("OFRecordReader")
         local_batch_size /= parallel_num;
       }
       *out_tensor->mut_shape() = Shape({local_batch_size});
-      *out_tensor->mut_data_type() = DataType::kOFRecord;
+      *out_tensor->mut_data_type() =
+          ctx->Attr<bool>("lazy_parse") ? DataType::kTensorBuffer : DataType::kOFRecord;
       return Maybe<void>::Ok();
     })
     .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
@@ -52,7 +52,7 @@ Maybe<void> FillScalarInSummary(const float& value, const std::string& tag, Summ
 }
 
 template<typename T>
-Maybe<void> FillHistogramInSummary(const user_op::Tensor& value, const std::string& tag,
+Maybe<void> FillHistogramInSummary(const T* values, int64_t num, const std::string& tag,
                                    Summary* s) {
   SummaryMetadata metadata;
   SetPluginData(&metadata, kHistogramPluginName);
@@ -60,10 +60,7 @@ Maybe<void> FillHistogramInSummary(const user_op::Tensor& value, const std::stri
   v->set_tag(tag);
   *v->mutable_metadata() = metadata;
   summary::Histogram histo;
-  for (int64_t i = 0; i < value.shape().elem_cnt(); i++) {
-    double double_val = value.dptr<T>()[i];
-    histo.AppendValue(double_val);
-  }
+  histo.AppendValues<T>(values, num);
   histo.AppendToProto(v->mutable_histo());
   return Maybe<void>::Ok();
 }
@@ -114,30 +111,24 @@ bool WriteImageToBuffer(const uint8_t* image, int width, int height, int depth,
   return true;
 }
 
-Maybe<void> FillImageInSummary(const user_op::Tensor& tensor, const std::string& tag, Summary* s) {
+Maybe<void> FillImageInSummary(const Shape& shape, DataType data_type, const uint8_t* images,
+                               const std::string& tag, Summary* s) {
   SummaryMetadata metadata;
   SetPluginData(&metadata, kImagePluginName);
-  if (!(tensor.shape().NumAxes() == 4
-        && (tensor.shape().At(3) == 1 || tensor.shape().At(3) == 3 || tensor.shape().At(3) == 4))) {
+  if (!(shape.NumAxes() == 4 && (shape.At(3) == 1 || shape.At(3) == 3 || shape.At(3) == 4))) {
     UNIMPLEMENTED();
   }
-  if (!(tensor.shape().At(0) < (1LL << 31) && tensor.shape().At(1) < (1LL << 31)
-        && tensor.shape().At(2) < (1LL << 31)
-        && (tensor.shape().At(1) * tensor.shape().At(2)) < (1LL << 29))) {
+  if (!(shape.At(0) < (1LL << 31) && shape.At(1) < (1LL << 31) && shape.At(2) < (1LL << 31)
+        && (shape.At(1) * shape.At(2)) < (1LL << 29))) {
     UNIMPLEMENTED();
   }
-  const int64_t batch_size = static_cast<int64_t>(tensor.shape().At(0));
-  const int64_t h = static_cast<int64_t>(tensor.shape().At(1));
-  const int64_t w = static_cast<int64_t>(tensor.shape().At(2));
+  const int64_t batch_size = static_cast<int64_t>(shape.At(0));
+  const int64_t h = static_cast<int64_t>(shape.At(1));
+  const int64_t w = static_cast<int64_t>(shape.At(2));
   const int64_t hw = h * w;
-  const int64_t depth = static_cast<int64_t>(tensor.shape().At(3));
-  if (tensor.data_type() == DataType::kUInt8) {
-    auto ith_image = [tensor, hw, depth](int i) {
-      auto images = tensor.dptr<uint8_t>();
-      uint8_t* image_i = (uint8_t*)malloc(sizeof(uint8_t) * hw * depth);
-      memcpy(image_i, images + i * hw * depth, hw * depth);
-      return image_i;
-    };
+  const int64_t depth = static_cast<int64_t>(shape.At(3));
+  if (data_type == DataType::kUInt8) {
+    auto ith_image = [images, hw, depth](int i) { return images + i * hw * depth; };
     for (int i = 0; i < batch_size; ++i) {
       Summary::Value* v = s->add_value();
       *v->mutable_metadata() = metadata;
@@ -178,22 +169,43 @@ struct EventWriterHelper<DeviceType::kCPU, T> {
     Global<EventsWriter>::Get()->AppendQueue(std::move(e));
   }
 
+  // the values are copied out and bucketed on the writer thread
   static void WriteHistogramToFile(int64_t step, const user_op::Tensor& value,
                                    const std::string& tag) {
+    const int64_t num = value.shape().elem_cnt();
+    if (Global<EventsWriter>::Get()->DropIfQueueFull(num * sizeof(T))) { return; }
+    std::shared_ptr<std::vector<T>> values =
+        std::make_shared<std::vector<T>>(value.dptr<T>(), value.dptr<T>() + num);
     std::unique_ptr<Event> e{new Event};
     e->set_step(step);
     e->set_wall_time(GetWallTime());
-    FillHistogramInSummary<T>(value, tag, e->mutable_summary());
-    Global<EventsWriter>::Get()->AppendQueue(std::move(e));
+    Global<EventsWriter>::Get()->AppendQueue(
+        std::move(e),
+        [values, tag](Event* event) {
+          FillHistogramInSummary<T>(values->data(), values->size(), tag, event->mutable_summary());
+        },
+        num * sizeof(T));
   }
 
+  // the images are copied out and encoded to png on the writer thread
   static void WriteImageToFile(int64_t step, const user_op::Tensor& tensor,
                                const std::string& tag) {
+    const int64_t byte_size = tensor.shape().elem_cnt() * GetSizeOfDataType(tensor.data_type());
+    if (Global<EventsWriter>::Get()->DropIfQueueFull(byte_size)) { return; }
+    Shape shape;
+    tensor.shape().ToShape(&shape);
+    const DataType data_type = tensor.data_type();
+    std::shared_ptr<std::vector<uint8_t>> images = std::make_shared<std::vector<uint8_t>>(
+        tensor.dptr<uint8_t>(), tensor.dptr<uint8_t>() + byte_size);
     std::unique_ptr<Event> e{new Event};
     e->set_step(step);
     e->set_wall_time(GetWallTime());
-    FillImageInSummary(tensor, tag, e->mutable_summary());
-    Global<EventsWriter>::Get()->AppendQueue(std::move(e));
+    Global<EventsWriter>::Get()->AppendQueue(
+        std::move(e),
+        [shape, data_type, images, tag](Event* event) {
+          FillImageInSummary(shape, data_type, images->data(), tag, event->mutable_summary());
+        },
+        byte_size);
   }
 };
 
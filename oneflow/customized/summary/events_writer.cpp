@@ -21,17 +21,25 @@ namespace oneflow {
 
 namespace summary {
 
-EventsWriter::EventsWriter() : is_inited_(false) {}
+EventsWriter::EventsWriter()
+    : is_inited_(false),
+      pending_staged_byte_size_(0),
+      dropped_event_num_(0),
+      flush_requested_(false),
+      closed_(false) {}
 
 EventsWriter::~EventsWriter() { Close(); }
 
 Maybe<void> EventsWriter::Init(const std::string& logdir) {
+  Close();
   file_system_ = std::make_unique<fs::PosixFileSystem>();
   log_dir_ = logdir + "/event";
   file_system_->RecursivelyCreateDirIfNotExist(log_dir_);
+  filename_.clear();
   TryToInit();
   is_inited_ = true;
-  last_flush_time_ = CurrentMircoTime();
+  closed_ = false;
+  writer_thread_ = std::thread(&EventsWriter::WriterLoop, this);
   return Maybe<void>::Ok();
 }
 
@@ -56,27 +64,80 @@ Maybe<void> EventsWriter::TryToInit() {
     event.set_wall_time(current_time);
     event.set_file_version(FILE_VERSION);
     WriteEvent(event);
-    Flush();
+    FileFlush();
   }
   return Maybe<void>::Ok();
 }
 
 void EventsWriter::AppendQueue(std::unique_ptr<Event> event) {
-  queue_mutex.lock();
-  event_queue_.emplace_back(std::move(event));
-  queue_mutex.unlock();
-  if (event_queue_.size() > MAX_QUEUE_NUM || CurrentMircoTime() - last_flush_time_ > FLUSH_TIME) {
-    Flush();
+  AppendQueue(std::move(event), std::function<void(Event*)>(), 0);
+}
+
+bool EventsWriter::AppendQueue(std::unique_ptr<Event> event, std::function<void(Event*)> Fill,
+                               size_t staged_byte_size) {
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    if (IsQueueFullUnlocked(staged_byte_size)) {
+      dropped_event_num_ += 1;
+      LOG_EVERY_N(WARNING, 100) << "summary event queue is full, " << dropped_event_num_
+                                << " events dropped so far";
+      return false;
+    }
+    pending_staged_byte_size_ += staged_byte_size;
+    event_queue_.emplace_back(PendingEvent{std::move(event), std::move(Fill), staged_byte_size});
   }
+  queue_cond_.notify_one();
+  return true;
+}
+
+bool EventsWriter::DropIfQueueFull(size_t staged_byte_size) {
+  std::unique_lock<std::mutex> lock(queue_mutex);
+  if (!IsQueueFullUnlocked(staged_byte_size)) { return false; }
+  dropped_event_num_ += 1;
+  LOG_EVERY_N(WARNING, 100) << "summary event queue is full, " << dropped_event_num_
+                            << " events dropped so far";
+  return true;
+}
+
+bool EventsWriter::IsQueueFullUnlocked(size_t staged_byte_size) const {
+  if (event_queue_.size() >= kMaxPendingEventNum) { return true; }
+  // a single event larger than the limit still goes through when nothing else is staged
+  return pending_staged_byte_size_ > 0
+         && pending_staged_byte_size_ + staged_byte_size > kMaxPendingStagedByteSize;
 }
 
 void EventsWriter::Flush() {
-  queue_mutex.lock();
-  for (const std::unique_ptr<Event>& e : event_queue_) { WriteEvent(*e); }
-  event_queue_.clear();
-  queue_mutex.unlock();
-  FileFlush();
-  last_flush_time_ = CurrentMircoTime();
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    flush_requested_ = true;
+  }
+  queue_cond_.notify_one();
+}
+
+void EventsWriter::WriterLoop() {
+  while (true) {
+    std::deque<PendingEvent> events;
+    bool flush_requested = false;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex);
+      queue_cond_.wait(lock, [this]() {
+        return !event_queue_.empty() || flush_requested_ || closed_;
+      });
+      if (event_queue_.empty() && !flush_requested_ && closed_) { break; }
+      events.swap(event_queue_);
+      flush_requested = flush_requested_;
+      flush_requested_ = false;
+    }
+    for (PendingEvent& pending : events) {
+      if (pending.Fill) { pending.Fill(pending.event.get()); }
+      WriteEvent(*pending.event);
+      pending.Fill = std::function<void(Event*)>();
+      pending.event.reset();
+      std::unique_lock<std::mutex> lock(queue_mutex);
+      pending_staged_byte_size_ -= pending.staged_byte_size;
+    }
+    if (!events.empty() || flush_requested) { FileFlush(); }
+  }
 }
 
 void EventsWriter::WriteEvent(const Event& event) {
@@ -98,7 +159,6 @@ void EventsWriter::WriteEvent(const Event& event) {
   writable_file_->Append(head, sizeof(head));
   writable_file_->Append(event_str.data(), event_str.size());
   writable_file_->Append(tail, sizeof(tail));
-  FileFlush();
 }
 
 void EventsWriter::FileFlush() {
@@ -108,12 +168,18 @@ void EventsWriter::FileFlush() {
 
 void EventsWriter::Close() {
   if (!is_inited_) { return; }
-  queue_mutex.unlock();
-  Flush();
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    closed_ = true;
+  }
+  queue_cond_.notify_one();
+  // the writer thread drains the queue before it exits
+  if (writer_thread_.joinable()) { writer_thread_.join(); }
   if (writable_file_ != nullptr) {
     writable_file_->Close();
     writable_file_.reset(nullptr);
   }
+  is_inited_ = false;
 }
 
 }  // namespace summary
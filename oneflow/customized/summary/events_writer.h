@@ -23,16 +23,18 @@ limitations under the License.
 
 #include <time.h>
 #include <mutex>
+#include <deque>
 
 namespace oneflow {
 
 namespace summary {
 
-#define MAX_QUEUE_NUM 10
-#define FLUSH_TIME 3 * 60 * 1000 * 1000
 #define FILE_VERSION "brain.Event:3"
 const size_t kHeadSize = sizeof(uint64_t) + sizeof(uint32_t);
 const size_t kTailSize = sizeof(uint32_t);
+// events beyond these are dropped instead of blocking the actor thread
+const size_t kMaxPendingEventNum = 1024;
+const size_t kMaxPendingStagedByteSize = 256 * 1024 * 1024;
 
 class EventsWriter {
  public:
@@ -45,10 +47,25 @@ class EventsWriter {
   void Close();
 
   void AppendQueue(std::unique_ptr<Event> event);
+  // Fill runs on the writer thread right before the event is encoded, staged_byte_size is the
+  // size of the data it holds. Returns false if the event is dropped because the queue is full.
+  bool AppendQueue(std::unique_ptr<Event> event, std::function<void(Event*)> Fill,
+                   size_t staged_byte_size);
+  // returns true and counts the event as dropped if it would not fit into the queue, so that
+  // callers can skip staging its data
+  bool DropIfQueueFull(size_t staged_byte_size);
   void FileFlush();
 
  private:
+  struct PendingEvent {
+    std::unique_ptr<Event> event;
+    std::function<void(Event*)> Fill;
+    size_t staged_byte_size;
+  };
+
   Maybe<void> TryToInit();
+  void WriterLoop();
+  bool IsQueueFullUnlocked(size_t staged_byte_size) const;
   inline static void EncodeHead(char* head, size_t size);
   inline static void EncodeTail(char* tail, const char* data, size_t size);
 
@@ -57,9 +74,14 @@ class EventsWriter {
   std::string filename_;
   std::unique_ptr<fs::FileSystem> file_system_;
   std::unique_ptr<fs::WritableFile> writable_file_;
-  uint64_t last_flush_time_;
-  std::vector<std::unique_ptr<Event>> event_queue_;
+  std::deque<PendingEvent> event_queue_;
+  size_t pending_staged_byte_size_;
+  int64_t dropped_event_num_;
+  bool flush_requested_;
+  bool closed_;
   std::mutex queue_mutex;
+  std::condition_variable queue_cond_;
+  std::thread writer_thread_;
   OF_DISALLOW_COPY(EventsWriter);
 };
 
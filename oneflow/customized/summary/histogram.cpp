@@ -15,7 +15,10 @@ limitations under the License.
 */
 #include "oneflow/customized/summary/histogram.h"
 #include "oneflow/core/common/maybe.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/thread/thread_manager.h"
 #include <cfloat>
+#include <cmath>
 #include <algorithm>
 
 namespace oneflow {
@@ -698,6 +701,34 @@ static std::vector<double> defalut_container = {-DBL_MAX,
                                                 451872326.521804,
                                                 DBL_MAX};
 
+namespace {
+
+constexpr int64_t kMinValueNumPerChunk = 64 * 1024;
+
+// the positive limits of defalut_container grow geometrically from the one after 0.0, so the
+// bucket of a value is guessed with a log and then fixed up against the limits
+struct ContainerLayout {
+  ContainerLayout() {
+    zero_idx = std::find(defalut_container.begin(), defalut_container.end(), 0.0)
+               - defalut_container.begin();
+    CHECK_LT(zero_idx + 2, defalut_container.size());
+    positive_num = defalut_container.size() - zero_idx - 2;
+    min_positive = defalut_container.at(zero_idx + 1);
+    log_ratio = std::log(defalut_container.at(zero_idx + 2) / min_positive);
+  }
+  int64_t zero_idx;
+  int64_t positive_num;
+  double min_positive;
+  double log_ratio;
+};
+
+const ContainerLayout& GetContainerLayout() {
+  static const ContainerLayout layout;
+  return layout;
+}
+
+}  // namespace
+
 Histogram::Histogram() {
   max_constainers_ = defalut_container;
   containers_.resize(max_constainers_.size());
@@ -715,12 +746,79 @@ void Histogram::AppendValue(double value) {
   sum_value_squares_ += value * value;
   if (max_value_ < value) { max_value_ = value; }
   if (min_value_ > value) { min_value_ = value; }
-  int idx = std::upper_bound(max_constainers_.begin(), max_constainers_.end(), value)
-            - max_constainers_.begin();
+  const int64_t idx = BucketIndex(value);
   CHECK_GT(containers_.size(), idx);
   containers_.at(idx) += 1.0;
 }
 
+int64_t Histogram::BucketIndex(double value) const {
+  // returns what std::upper_bound over max_constainers_ does, except that values not below the
+  // last limit, +inf and NaN fall into the last bucket
+  const int64_t size = max_constainers_.size();
+  if (std::isnan(value)) { return size - 1; }
+  const ContainerLayout& layout = GetContainerLayout();
+  const double abs_value = std::abs(value);
+  // number of positive limits not greater than abs_value, roughly
+  int64_t le_cnt = 0;
+  if (abs_value >= layout.min_positive) {
+    const double guess = std::log(abs_value / layout.min_positive) / layout.log_ratio + 1;
+    le_cnt = guess >= layout.positive_num ? layout.positive_num : static_cast<int64_t>(guess);
+  }
+  int64_t idx = layout.zero_idx + 1;
+  if (value > 0) {
+    idx += le_cnt;
+  } else if (value < 0) {
+    idx -= le_cnt + 1;
+  }
+  idx = std::max<int64_t>(0, std::min(idx, size));
+  while (idx < size && max_constainers_.at(idx) <= value) { ++idx; }
+  while (idx > 0 && max_constainers_.at(idx - 1) > value) { --idx; }
+  return std::min(idx, size - 1);
+}
+
+void Histogram::Merge(const Histogram& other) {
+  value_count_ += other.value_count_;
+  value_sum_ += other.value_sum_;
+  sum_value_squares_ += other.sum_value_squares_;
+  min_value_ = std::min(min_value_, other.min_value_);
+  max_value_ = std::max(max_value_, other.max_value_);
+  FOR_RANGE(size_t, i, 0, containers_.size()) { containers_.at(i) += other.containers_.at(i); }
+}
+
+template<typename T>
+void Histogram::AppendValues(const T* values, int64_t num) {
+  int64_t chunk_num = (num + kMinValueNumPerChunk - 1) / kMinValueNumPerChunk;
+  if (Global<ThreadPool>::Get() == nullptr) {
+    chunk_num = std::min<int64_t>(chunk_num, 1);
+  } else {
+    chunk_num = std::min<int64_t>(chunk_num, Global<ThreadPool>::Get()->thread_num());
+  }
+  if (chunk_num <= 1) {
+    FOR_RANGE(int64_t, i, 0, num) { AppendValue(static_cast<double>(values[i])); }
+    return;
+  }
+  const BalancedSplitter bs(num, chunk_num);
+  std::vector<Histogram> chunk_histograms(chunk_num);
+  MultiThreadLoop(chunk_num, [&](size_t chunk_id) {
+    Histogram* histogram = &chunk_histograms.at(chunk_id);
+    const Range range = bs.At(chunk_id);
+    FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+      histogram->AppendValue(static_cast<double>(values[i]));
+    }
+  });
+  for (const Histogram& histogram : chunk_histograms) { Merge(histogram); }
+}
+
+#define INSTANTIATE_HISTOGRAM_APPEND_VALUES(T) \
+  template void Histogram::AppendValues<T>(const T* values, int64_t num);
+INSTANTIATE_HISTOGRAM_APPEND_VALUES(double)
+INSTANTIATE_HISTOGRAM_APPEND_VALUES(float)
+INSTANTIATE_HISTOGRAM_APPEND_VALUES(int64_t)
+INSTANTIATE_HISTOGRAM_APPEND_VALUES(int32_t)
+INSTANTIATE_HISTOGRAM_APPEND_VALUES(int8_t)
+INSTANTIATE_HISTOGRAM_APPEND_VALUES(uint8_t)
+#undef INSTANTIATE_HISTOGRAM_APPEND_VALUES
+
 void Histogram::AppendToProto(HistogramProto* hist_proto) {
   hist_proto->Clear();
   hist_proto->set_num(value_count_);
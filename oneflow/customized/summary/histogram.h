@@ -29,9 +29,17 @@ class Histogram {
   ~Histogram() {}
 
   void AppendValue(double value);
+  // same as AppendValue on each of the values, chunks of them are bucketed concurrently
+  template<typename T>
+  void AppendValues(const T* values, int64_t num);
   void AppendToProto(HistogramProto* proto);
 
+  const std::vector<double>& bucket_limits() const { return max_constainers_; }
+
  private:
+  int64_t BucketIndex(double value) const;
+  void Merge(const Histogram& other);
+
   double value_count_;
   double value_sum_;
   double sum_value_squares_;
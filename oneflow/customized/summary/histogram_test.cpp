@@ -0,0 +1,147 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/customized/summary/histogram.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <random>
+
+namespace oneflow {
+
+namespace summary {
+
+namespace test {
+
+namespace {
+
+// the bucket of each value by std::upper_bound over the limits, with the values past the last
+// limit and NaN in the last bucket
+std::vector<double> ReferenceBuckets(const std::vector<double>& limits,
+                                     const std::vector<double>& values) {
+  std::vector<double> buckets(limits.size(), 0);
+  for (const double value : values) {
+    const int64_t idx = std::upper_bound(limits.begin(), limits.end(), value) - limits.begin();
+    buckets.at(std::min<int64_t>(idx, limits.size() - 1)) += 1;
+  }
+  return buckets;
+}
+
+template<typename T>
+void TestAppendValues(const std::vector<T>& values) {
+  Histogram histogram;
+  histogram.AppendValues<T>(values.data(), values.size());
+  HistogramProto proto;
+  histogram.AppendToProto(&proto);
+
+  std::vector<double> double_values;
+  double expected_sum = 0;
+  double expected_min = DBL_MAX;
+  double expected_max = -DBL_MAX;
+  for (const T value : values) {
+    const double double_value = static_cast<double>(value);
+    double_values.push_back(double_value);
+    expected_sum += double_value;
+    if (double_value < expected_min) { expected_min = double_value; }
+    if (double_value > expected_max) { expected_max = double_value; }
+  }
+  ASSERT_EQ(proto.num(), values.size());
+  ASSERT_EQ(proto.min(), expected_min);
+  ASSERT_EQ(proto.max(), expected_max);
+  if (std::isnan(expected_sum)) {
+    ASSERT_TRUE(std::isnan(proto.sum()));
+  } else if (std::isinf(expected_sum)) {
+    ASSERT_EQ(proto.sum(), expected_sum);
+  } else {
+    ASSERT_NEAR(proto.sum(), expected_sum, std::abs(expected_sum) * 1e-9);
+  }
+
+  // empty buckets are merged into the next one by AppendToProto, so each non-empty reference
+  // bucket shows up with its own limit and nothing else has a count
+  const std::vector<double>& limits = histogram.bucket_limits();
+  const std::vector<double> expected_buckets = ReferenceBuckets(limits, double_values);
+  std::map<double, double> limit2bucket;
+  FOR_RANGE(int64_t, i, 0, proto.bucket_limit_size()) {
+    if (proto.bucket(i) > 0) { limit2bucket[proto.bucket_limit(i)] = proto.bucket(i); }
+  }
+  size_t non_empty_cnt = 0;
+  FOR_RANGE(int64_t, i, 0, limits.size()) {
+    if (expected_buckets.at(i) == 0) { continue; }
+    ++non_empty_cnt;
+    ASSERT_TRUE(limit2bucket.find(limits.at(i)) != limit2bucket.end()) << limits.at(i);
+    ASSERT_EQ(limit2bucket.at(limits.at(i)), expected_buckets.at(i)) << limits.at(i);
+  }
+  ASSERT_EQ(limit2bucket.size(), non_empty_cnt);
+}
+
+std::vector<float> RandomFloats(int64_t num) {
+  std::mt19937 gen(0);
+  std::normal_distribution<float> dis(0, 1);
+  std::vector<float> values(num);
+  for (float& value : values) { value = dis(gen); }
+  return values;
+}
+
+}  // namespace
+
+TEST(Histogram, append_values_serial) {
+  std::vector<float> values = RandomFloats(1000);
+  values.push_back(0);
+  values.push_back(FLT_MAX);
+  values.push_back(-FLT_MAX);
+  values.push_back(1e-30);
+  TestAppendValues(values);
+  TestAppendValues(std::vector<int32_t>{-7, 0, 3, 1000000, -1000000});
+}
+
+TEST(Histogram, append_values_on_limits) {
+  const Histogram histogram;
+  std::vector<double> values;
+  for (const double limit : histogram.bucket_limits()) {
+    values.push_back(limit);
+    values.push_back(std::nextafter(limit, -DBL_MAX));
+    values.push_back(std::nextafter(limit, DBL_MAX));
+  }
+  TestAppendValues(values);
+}
+
+TEST(Histogram, append_special_values) {
+  const double inf = std::numeric_limits<double>::infinity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const double denorm_min = std::numeric_limits<double>::denorm_min();
+  TestAppendValues(std::vector<double>{denorm_min, -denorm_min, DBL_MIN / 4, -DBL_MIN / 4, 0.0,
+                                       -0.0, DBL_MAX, -DBL_MAX});
+  TestAppendValues(std::vector<double>{1.5, inf, -inf});
+  TestAppendValues(std::vector<double>{nan, -2.5, 3.0, nan});
+  TestAppendValues(std::vector<float>{std::numeric_limits<float>::denorm_min(),
+                                      -std::numeric_limits<float>::denorm_min(),
+                                      std::numeric_limits<float>::infinity(),
+                                      std::numeric_limits<float>::quiet_NaN()});
+}
+
+TEST(Histogram, append_values_parallel) {
+  Global<ThreadPool>::New(4);
+  TestAppendValues(RandomFloats(1000 * 1000));
+  Global<ThreadPool>::Delete();
+}
+
+}  // namespace test
+
+}  // namespace summary
+
+}  // namespace oneflow
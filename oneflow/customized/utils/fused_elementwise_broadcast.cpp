@@ -0,0 +1,50 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/customized/utils/fused_elementwise_broadcast.h"
+
+namespace oneflow {
+
+FusedElementwiseBroadcast::FusedElementwiseBroadcast(const ShapeView& out_shape,
+                                                     const ShapeView& in_shape,
+                                                     int64_t in_axis_offset) {
+  int64_t in_stride = 1;
+  for (int64_t axis = out_shape.NumAxes() - 1; axis >= 0; --axis) {
+    const int64_t out_dim = out_shape.At(axis);
+    const int64_t in_axis = axis - in_axis_offset;
+    int64_t axis_in_stride = 0;
+    if (in_axis >= 0 && in_axis < in_shape.NumAxes()) {
+      const int64_t in_dim = in_shape.At(in_axis);
+      CHECK(in_dim == out_dim || in_dim == 1);
+      if (in_dim != 1) { axis_in_stride = in_stride; }
+      in_stride *= in_dim;
+    }
+    if (out_dim == 1) { continue; }
+    if (!dims_.empty() && axis_in_stride == in_strides_.back() * dims_.back()) {
+      dims_.back() *= out_dim;
+    } else {
+      dims_.push_back(out_dim);
+      in_strides_.push_back(axis_in_stride);
+    }
+  }
+  if (dims_.empty()) {
+    dims_.push_back(1);
+    in_strides_.push_back(0);
+  }
+  // the innermost input axis present has stride one, so rows are either contiguous or broadcast
+  CHECK(in_strides_.front() == 0 || in_strides_.front() == 1);
+}
+
+}  // namespace oneflow
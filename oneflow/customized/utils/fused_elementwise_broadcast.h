@@ -0,0 +1,83 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CUSTOMIZED_UTILS_FUSED_ELEMENTWISE_BROADCAST_H_
+#define ONEFLOW_CUSTOMIZED_UTILS_FUSED_ELEMENTWISE_BROADCAST_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/shape_view.h"
+
+namespace oneflow {
+
+// How an input of a fused_elementwise op, whose axes start at out axis in_axis_offset, is
+// broadcast to the out shape. Out axes of size one are dropped and adjacent axes along which the
+// input is laid out contiguously, or broadcast, are merged, so an input broadcast over the outer
+// axes is gathered by block copies and one broadcast over the inner axes by filling rows.
+class FusedElementwiseBroadcast final {
+ public:
+  FusedElementwiseBroadcast(const ShapeView& out_shape, const ShapeView& in_shape,
+                            int64_t in_axis_offset);
+  ~FusedElementwiseBroadcast() = default;
+
+  // out[j] = the input element broadcast to the out element start + j, for j in [0, n)
+  template<typename T>
+  void Gather(const T* in, int64_t start, int64_t n, T* out) const;
+
+  // the merged axes, innermost first
+  const DimVector& dims() const { return dims_; }
+  // the stride of the input along each of dims(), 0 where it is broadcast
+  const DimVector& in_strides() const { return in_strides_; }
+
+ private:
+  DimVector dims_;
+  DimVector in_strides_;
+};
+
+template<typename T>
+void FusedElementwiseBroadcast::Gather(const T* in, int64_t start, int64_t n, T* out) const {
+  const int64_t num_axes = dims_.size();
+  // the index of start along each merged axis, the only divisions of the gather
+  DimVector index(num_axes);
+  int64_t in_offset = 0;
+  int64_t remainder = start;
+  FOR_RANGE(int64_t, axis, 0, num_axes) {
+    index.at(axis) = remainder % dims_.at(axis);
+    remainder /= dims_.at(axis);
+    in_offset += index.at(axis) * in_strides_.at(axis);
+  }
+  const int64_t row_size = dims_.at(0);
+  const int64_t row_stride = in_strides_.at(0);
+  int64_t done = 0;
+  while (done < n) {
+    const int64_t row_n = std::min(row_size - index.at(0), n - done);
+    if (row_stride == 0) {
+      std::fill(out + done, out + done + row_n, in[in_offset]);
+    } else {
+      std::copy(in + in_offset, in + in_offset + row_n, out + done);
+    }
+    done += row_n;
+    index.at(0) += row_n;
+    in_offset += row_n * row_stride;
+    for (int64_t axis = 0; axis + 1 < num_axes && index.at(axis) == dims_.at(axis); ++axis) {
+      in_offset += in_strides_.at(axis + 1) - dims_.at(axis) * in_strides_.at(axis);
+      index.at(axis) = 0;
+      index.at(axis + 1) += 1;
+    }
+  }
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CUSTOMIZED_UTILS_FUSED_ELEMENTWISE_BROADCAST_H_
@@ -0,0 +1,96 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/customized/utils/fused_elementwise_broadcast.h"
+#include "oneflow/core/common/shape.h"
+#include <numeric>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+// the per element index mapping the fused_elementwise kernel used before
+int64_t NaiveInIndex4OutIndex(const Shape& out_shape, const Shape& in_shape,
+                              int64_t in_axis_offset, int64_t out_index) {
+  int64_t in_index = 0;
+  int64_t in_stride = 1;
+  for (int64_t axis = out_shape.NumAxes() - 1; axis >= 0; --axis) {
+    const int64_t out_dim = out_shape.At(axis);
+    const int64_t in_axis = axis - in_axis_offset;
+    if (in_axis >= 0 && in_axis < in_shape.NumAxes()) {
+      const int64_t in_dim = in_shape.At(in_axis);
+      if (in_dim != 1) { in_index += (out_index % out_dim) * in_stride; }
+      in_stride *= in_dim;
+    }
+    out_index /= out_dim;
+  }
+  return in_index;
+}
+
+void TestGather(const Shape& out_shape, const Shape& in_shape, int64_t in_axis_offset) {
+  const FusedElementwiseBroadcast broadcast(out_shape, in_shape, in_axis_offset);
+  std::vector<int32_t> in(in_shape.elem_cnt());
+  std::iota(in.begin(), in.end(), 0);
+  const int64_t elem_cnt = out_shape.elem_cnt();
+  // blocks which start and end in the middle of rows, as well as the whole out at once
+  for (const int64_t block_size : {int64_t(1), int64_t(7), int64_t(64), elem_cnt}) {
+    std::vector<int32_t> out(block_size);
+    for (int64_t start = 0; start < elem_cnt; start += block_size) {
+      const int64_t n = std::min(block_size, elem_cnt - start);
+      broadcast.Gather(in.data(), start, n, out.data());
+      FOR_RANGE(int64_t, j, 0, n) {
+        ASSERT_EQ(out.at(j),
+                  in.at(NaiveInIndex4OutIndex(out_shape, in_shape, in_axis_offset, start + j)))
+            << out_shape.ToString() << " " << in_shape.ToString() << " " << in_axis_offset
+            << " at " << start + j;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST(FusedElementwiseBroadcast, merge_axes) {
+  // a bias at axis 1 of NCHW is a row of H * W copies of each value, repeated N times
+  const FusedElementwiseBroadcast bias(Shape({2, 3, 4, 5}), Shape({3}), 1);
+  ASSERT_EQ(bias.dims(), DimVector({20, 3, 2}));
+  ASSERT_EQ(bias.in_strides(), DimVector({0, 1, 0}));
+  // broadcast over the outer axes, the inner axes are one contiguous row
+  const FusedElementwiseBroadcast outer(Shape({6, 4, 5}), Shape({1, 4, 5}), 0);
+  ASSERT_EQ(outer.dims(), DimVector({20, 6}));
+  ASSERT_EQ(outer.in_strides(), DimVector({1, 0}));
+  // axes of size one are dropped
+  const FusedElementwiseBroadcast scalar(Shape({1, 8, 1}), Shape({1}), 0);
+  ASSERT_EQ(scalar.dims(), DimVector({8}));
+  ASSERT_EQ(scalar.in_strides(), DimVector({0}));
+}
+
+TEST(FusedElementwiseBroadcast, gather) {
+  TestGather(Shape({2, 3, 4, 5}), Shape({3}), 1);
+  TestGather(Shape({2, 3, 4, 5}), Shape({3, 1, 1}), 1);
+  TestGather(Shape({6, 4, 5}), Shape({1, 4, 5}), 0);
+  TestGather(Shape({6, 4, 5}), Shape({4, 5}), 1);
+  TestGather(Shape({6, 4, 5}), Shape({6, 1, 5}), 0);
+  TestGather(Shape({6, 4, 5}), Shape({6, 4, 1}), 0);
+  TestGather(Shape({3, 1, 4, 2, 5}), Shape({1, 1, 4, 1, 5}), 0);
+  TestGather(Shape({7, 9}), Shape({1}), 1);
+  TestGather(Shape({1}), Shape({1}), 0);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -0,0 +1,233 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <sstream>
+#include "oneflow/customized/utils/fused_elementwise_program.h"
+#include "oneflow/customized/ops/math_unary_elementwise_seq.h"
+#include "oneflow/customized/ops/math_binary_elementwise_seq.h"
+#include "oneflow/core/framework/user_op_conf.h"
+
+namespace oneflow {
+
+namespace {
+
+struct InstructionSignature {
+  int32_t num_operands;
+  bool has_scalar;
+};
+
+HashMap<std::string, InstructionSignature> MakeInstructionName2Signature() {
+  HashMap<std::string, InstructionSignature> name2signature = {
+      {"relu", {1, false}},      {"gelu", {1, false}},       {"sigmoid", {1, false}},
+      {"tanh", {1, false}},      {"leaky_relu", {1, true}},  {"scalar_add", {1, true}},
+      {"scalar_mul", {1, true}}, {"add", {2, false}},        {"sub", {2, false}},
+      {"mul", {2, false}},       {"div", {2, false}},        {"minimum", {2, false}},
+      {"maximum", {2, false}},
+  };
+#define INSERT_UNARY_SIGNATURE(op_type_name, func_prefix) \
+  name2signature.emplace(op_type_name, InstructionSignature{1, false});
+#define INSERT_BINARY_SIGNATURE(op_type_name, func_prefix) \
+  name2signature.emplace(op_type_name, InstructionSignature{2, false});
+  OF_PP_FOR_EACH_TUPLE(INSERT_UNARY_SIGNATURE, MATH_UNARY_ELEMENTWISE_FUNC_SEQ)
+  OF_PP_FOR_EACH_TUPLE(INSERT_BINARY_SIGNATURE, MATH_BINARY_ELEMENTWISE_FUNC_SEQ)
+#undef INSERT_BINARY_SIGNATURE
+#undef INSERT_UNARY_SIGNATURE
+  return name2signature;
+}
+
+const HashMap<std::string, InstructionSignature>& InstructionName2Signature() {
+  static const HashMap<std::string, InstructionSignature> name2signature =
+      MakeInstructionName2Signature();
+  return name2signature;
+}
+
+bool IsOpTypeNameInSeq(const std::string& op_type_name, bool is_unary) {
+#define MAKE_NAME_ENTRY(op_type_name, func_prefix) op_type_name,
+  static const HashSet<std::string> unary_op_type_names = {
+      OF_PP_FOR_EACH_TUPLE(MAKE_NAME_ENTRY, MATH_UNARY_ELEMENTWISE_FUNC_SEQ)};
+  static const HashSet<std::string> binary_op_type_names = {
+      OF_PP_FOR_EACH_TUPLE(MAKE_NAME_ENTRY, MATH_BINARY_ELEMENTWISE_FUNC_SEQ)};
+#undef MAKE_NAME_ENTRY
+  const auto& op_type_names = is_unary ? unary_op_type_names : binary_op_type_names;
+  return op_type_names.find(op_type_name) != op_type_names.end();
+}
+
+const int32_t kMaxNumInputsOfAllPartialSumInputs = 4;
+
+enum class Linearity { kConstant, kLinear, kNonlinear };
+
+Linearity Linearity4Instruction(const FusedElementwiseInstruction& instruction,
+                                const std::vector<Linearity>& register2linearity) {
+  std::vector<Linearity> operands;
+  bool is_all_constant = true;
+  for (int32_t operand : instruction.operands) {
+    operands.push_back(register2linearity.at(operand));
+    if (operands.back() != Linearity::kConstant) { is_all_constant = false; }
+  }
+  if (is_all_constant) { return Linearity::kConstant; }
+  const std::string& name = instruction.name;
+  if (name == "scalar_mul" || name == "negative") { return operands.at(0); }
+  // a linear term plus a constant one is affine, which summing the partial values breaks
+  if (name == "add" || name == "sub") {
+    return operands.at(0) == operands.at(1) ? operands.at(0) : Linearity::kNonlinear;
+  }
+  if (name == "mul") {
+    if (operands.at(0) == Linearity::kConstant) { return operands.at(1); }
+    if (operands.at(1) == Linearity::kConstant) { return operands.at(0); }
+    return Linearity::kNonlinear;
+  }
+  if (name == "div" && operands.at(1) == Linearity::kConstant) { return operands.at(0); }
+  return Linearity::kNonlinear;
+}
+
+}  // namespace
+
+bool IsFusedElementwiseProgramLinear(const FusedElementwiseProgram& program,
+                                     const std::vector<bool>& is_partial_sum_input) {
+  CHECK_EQ(is_partial_sum_input.size(), program.num_inputs);
+  std::vector<Linearity> register2linearity;
+  for (bool is_partial_sum : is_partial_sum_input) {
+    register2linearity.push_back(is_partial_sum ? Linearity::kLinear : Linearity::kConstant);
+  }
+  for (const FusedElementwiseInstruction& instruction : program.instructions) {
+    register2linearity.push_back(Linearity4Instruction(instruction, register2linearity));
+  }
+  return register2linearity.back() == Linearity::kLinear;
+}
+
+void ForEachPartialSumInputs(const FusedElementwiseProgram& program,
+                             const std::function<void(const std::vector<bool>&)>& Handler) {
+  const int32_t num_inputs = program.num_inputs;
+  std::vector<std::vector<bool>> candidates;
+  if (num_inputs <= kMaxNumInputsOfAllPartialSumInputs) {
+    FOR_RANGE(int32_t, mask, 1, 1 << num_inputs) {
+      std::vector<bool> is_partial_sum_input(num_inputs, false);
+      FOR_RANGE(int32_t, i, 0, num_inputs) { is_partial_sum_input.at(i) = (mask >> i) & 1; }
+      candidates.push_back(is_partial_sum_input);
+    }
+  } else {
+    FOR_RANGE(int32_t, i, 0, num_inputs) {
+      candidates.emplace_back(num_inputs, false);
+      candidates.back().at(i) = true;
+    }
+    candidates.emplace_back(num_inputs, true);
+  }
+  for (const std::vector<bool>& is_partial_sum_input : candidates) {
+    if (IsFusedElementwiseProgramLinear(program, is_partial_sum_input)) {
+      Handler(is_partial_sum_input);
+    }
+  }
+}
+
+std::string SerializeFusedElementwiseProgram(const FusedElementwiseProgram& program) {
+  std::ostringstream oss;
+  for (const FusedElementwiseInstruction& instruction : program.instructions) {
+    const InstructionSignature& signature = InstructionName2Signature().at(instruction.name);
+    if (&instruction != &program.instructions.front()) { oss << ";"; }
+    oss << instruction.name;
+    for (int32_t operand : instruction.operands) { oss << " " << operand; }
+    if (signature.has_scalar) { oss << " " << std::hexfloat << instruction.scalar; }
+  }
+  return oss.str();
+}
+
+Maybe<void> ParseFusedElementwiseProgram(const std::string& text, int32_t num_inputs,
+                                         FusedElementwiseProgram* program) {
+  program->num_inputs = num_inputs;
+  program->instructions.clear();
+  std::istringstream text_iss(text);
+  std::string instruction_text;
+  while (std::getline(text_iss, instruction_text, ';')) {
+    std::istringstream iss(instruction_text);
+    FusedElementwiseInstruction instruction;
+    instruction.scalar = 0;
+    CHECK_OR_RETURN(static_cast<bool>(iss >> instruction.name)) << instruction_text;
+    const auto it = InstructionName2Signature().find(instruction.name);
+    CHECK_OR_RETURN(it != InstructionName2Signature().end())
+        << "unknown fused elementwise instruction " << instruction.name;
+    const int32_t num_registers = num_inputs + program->instructions.size();
+    FOR_RANGE(int32_t, i, 0, it->second.num_operands) {
+      int32_t operand = -1;
+      CHECK_OR_RETURN(static_cast<bool>(iss >> operand)) << instruction_text;
+      // operands are inputs or results of earlier instructions
+      CHECK_OR_RETURN(operand >= 0 && operand < num_registers) << instruction_text;
+      instruction.operands.push_back(operand);
+    }
+    if (it->second.has_scalar) {
+      std::string scalar_text;
+      CHECK_OR_RETURN(static_cast<bool>(iss >> scalar_text)) << instruction_text;
+      instruction.scalar = std::strtod(scalar_text.c_str(), nullptr);
+    }
+    std::string rest;
+    CHECK_OR_RETURN(!(iss >> rest)) << instruction_text;
+    program->instructions.push_back(instruction);
+  }
+  CHECK_GT_OR_RETURN(program->instructions.size(), 0);
+  return Maybe<void>::Ok();
+}
+
+bool GetFusibleElementwiseOp(const OperatorConf& op_conf, FusibleElementwiseOp* fusible_op) {
+  if (!op_conf.has_user_conf()) { return false; }
+  const user_op::UserOpConfWrapper op(op_conf);
+  const std::string& op_type_name = op.op_type_name();
+  FusedElementwiseInstruction* instruction = &fusible_op->instruction;
+  instruction->scalar = 0;
+  if (IsOpTypeNameInSeq(op_type_name, true)) {
+    instruction->name = op_type_name;
+    fusible_op->ibns = {"x_0"};
+    fusible_op->obn = "y_0";
+  } else if (IsOpTypeNameInSeq(op_type_name, false)) {
+    instruction->name = op_type_name;
+    fusible_op->ibns = {"x_0", "y_0"};
+    fusible_op->obn = "z_0";
+  } else if (op_type_name == "relu" || op_type_name == "gelu" || op_type_name == "sigmoid"
+             || op_type_name == "tanh") {
+    instruction->name = op_type_name;
+    fusible_op->ibns = {"in_0"};
+    fusible_op->obn = "out_0";
+  } else if (op_type_name == "leaky_relu") {
+    instruction->name = op_type_name;
+    instruction->scalar = op.attr<float>("alpha");
+    fusible_op->ibns = {"x_0"};
+    fusible_op->obn = "y_0";
+  } else if (op_type_name == "scalar_add" || op_type_name == "scalar_mul") {
+    instruction->name = op_type_name;
+    instruction->scalar = op.attr<bool>("has_float_operand")
+                              ? op.attr<double>("float_operand")
+                              : static_cast<double>(op.attr<int64_t>("int_operand"));
+    fusible_op->ibns = {"in_0"};
+    fusible_op->obn = "out_0";
+  } else if (op_type_name == "broadcast_add" || op_type_name == "broadcast_sub"
+             || op_type_name == "broadcast_mul" || op_type_name == "broadcast_div"
+             || op_type_name == "broadcast_minimum" || op_type_name == "broadcast_maximum") {
+    instruction->name = op_type_name.substr(std::string("broadcast_").size());
+    fusible_op->ibns = {"x_0", "y_0"};
+    fusible_op->obn = "z_0";
+  } else if (op_type_name == "multiply") {
+    instruction->name = "mul";
+    fusible_op->ibns = {"x_0", "y_0"};
+    fusible_op->obn = "out_0";
+  } else if (op_type_name == "bias_add") {
+    instruction->name = "add";
+    fusible_op->ibns = {"a_0", "b_0"};
+    fusible_op->obn = "out_0";
+  } else {
+    return false;
+  }
+  instruction->operands.clear();
+  return true;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,65 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CUSTOMIZED_UTILS_FUSED_ELEMENTWISE_PROGRAM_H_
+#define ONEFLOW_CUSTOMIZED_UTILS_FUSED_ELEMENTWISE_PROGRAM_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/operator/op_conf.pb.h"
+
+namespace oneflow {
+
+// The straight line program a fused_elementwise op evaluates per element. Register i holds the
+// i-th input for i < num_inputs, instruction k writes register num_inputs + k and the register
+// of the last instruction is the output. It is kept in the "program" attr as
+// "name operand [operand] [scalar];..." with scalars in hexadecimal floating point.
+struct FusedElementwiseInstruction {
+  std::string name;
+  std::vector<int32_t> operands;
+  double scalar;
+};
+
+struct FusedElementwiseProgram {
+  int32_t num_inputs;
+  std::vector<FusedElementwiseInstruction> instructions;
+};
+
+std::string SerializeFusedElementwiseProgram(const FusedElementwiseProgram& program);
+Maybe<void> ParseFusedElementwiseProgram(const std::string& text, int32_t num_inputs,
+                                         FusedElementwiseProgram* program);
+
+// Whether the output of program is linear in the inputs marked in is_partial_sum_input with the
+// other inputs held constant, so that the output of the sum of partial values of these inputs is
+// the sum of the outputs of each partial value
+bool IsFusedElementwiseProgramLinear(const FusedElementwiseProgram& program,
+                                     const std::vector<bool>& is_partial_sum_input);
+// the sets of partial sum inputs the fused_elementwise op has a PartialSum signature for, all the
+// linear ones of a few inputs or the single inputs and all the inputs otherwise
+void ForEachPartialSumInputs(const FusedElementwiseProgram& program,
+                             const std::function<void(const std::vector<bool>&)>& Handler);
+
+// How a user op is evaluated as one instruction: the ibns of its operands in order and its obn
+struct FusibleElementwiseOp {
+  FusedElementwiseInstruction instruction;
+  std::vector<std::string> ibns;
+  std::string obn;
+};
+
+bool GetFusibleElementwiseOp(const OperatorConf& op_conf, FusibleElementwiseOp* fusible_op);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CUSTOMIZED_UTILS_FUSED_ELEMENTWISE_PROGRAM_H_
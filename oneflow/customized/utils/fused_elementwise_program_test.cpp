@@ -0,0 +1,68 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/customized/utils/fused_elementwise_program.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+FusedElementwiseProgram ParseProgram(const std::string& text, int32_t num_inputs) {
+  FusedElementwiseProgram program;
+  CHECK_JUST(ParseFusedElementwiseProgram(text, num_inputs, &program));
+  return program;
+}
+
+std::vector<std::vector<bool>> PartialSumInputsList(const FusedElementwiseProgram& program) {
+  std::vector<std::vector<bool>> partial_sum_inputs_list;
+  ForEachPartialSumInputs(program, [&](const std::vector<bool>& is_partial_sum_input) {
+    partial_sum_inputs_list.push_back(is_partial_sum_input);
+  });
+  return partial_sum_inputs_list;
+}
+
+}  // namespace
+
+TEST(FusedElementwiseProgram, linear) {
+  // (x + y) * w
+  const FusedElementwiseProgram add_mul = ParseProgram("add 0 1;mul 3 2", 3);
+  ASSERT_TRUE(IsFusedElementwiseProgramLinear(add_mul, {true, true, false}));
+  ASSERT_FALSE(IsFusedElementwiseProgramLinear(add_mul, {true, false, false}));
+  ASSERT_FALSE(IsFusedElementwiseProgramLinear(add_mul, {true, true, true}));
+  ASSERT_FALSE(IsFusedElementwiseProgramLinear(add_mul, {false, false, false}));
+  // -(x / w) * 2
+  const FusedElementwiseProgram div_scale =
+      ParseProgram("div 0 1;negative 2;scalar_mul 3 0x1p+1", 2);
+  ASSERT_TRUE(IsFusedElementwiseProgramLinear(div_scale, {true, false}));
+  ASSERT_FALSE(IsFusedElementwiseProgramLinear(div_scale, {false, true}));
+  // relu(x) and x + 1 sum partial values wrongly
+  ASSERT_FALSE(IsFusedElementwiseProgramLinear(ParseProgram("relu 0", 1), {true}));
+  ASSERT_FALSE(IsFusedElementwiseProgramLinear(ParseProgram("scalar_add 0 0x1p+0", 1), {true}));
+  // relu(w) * x only depends on the partial input linearly
+  ASSERT_TRUE(IsFusedElementwiseProgramLinear(ParseProgram("relu 1;mul 0 2", 2), {true, false}));
+}
+
+TEST(FusedElementwiseProgram, partial_sum_inputs) {
+  // (x + y) * w is linear in x and y together or in w alone
+  const std::vector<std::vector<bool>> expected = {{true, true, false}, {false, false, true}};
+  ASSERT_EQ(PartialSumInputsList(ParseProgram("add 0 1;mul 3 2", 3)), expected);
+  ASSERT_TRUE(PartialSumInputsList(ParseProgram("scalar_add 0 0x1p+0", 1)).empty());
+}
+
+}  // namespace test
+
+}  // namespace oneflow
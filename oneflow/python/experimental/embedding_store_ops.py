@@ -0,0 +1,81 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+from __future__ import absolute_import
+
+from typing import Optional
+
+import oneflow as flow
+import oneflow.python.framework.id_util as id_util
+import oneflow.python.framework.input_blob_def as input_blob_util
+import oneflow.python.framework.remote_blob as remote_blob_util
+from oneflow.python.oneflow_export import oneflow_export
+
+
+@oneflow_export("experimental.embedding_store_lookup")
+def embedding_store_lookup(
+    ids: input_blob_util.ArgBlobDef,
+    embedding_dim: int,
+    optimizer: str = "sgd",
+    beta1: float = 0.9,
+    beta2: float = 0.999,
+    epsilon: float = 1e-8,
+    num_shards: int = 16,
+    cache_capacity: int = 0,
+    storage_dir: str = "",
+    init_scale: float = 0.05,
+    seed: int = 0,
+    trainable: bool = True,
+    name: Optional[str] = None,
+) -> remote_blob_util.BlobDef:
+    r"""Looks up the rows of `ids` in a host side embedding store.
+
+    The table lives in a sharded in-memory store instead of a variable blob, so it can hold
+    more rows than a device. Rows are created on first lookup, updated in place by the
+    `optimizer` on backward with the learning rate of the job, and kept in a LRU cache of `cache_capacity` rows whose evicted
+    rows spill to files in `storage_dir` (no limit when either is unset). A [1] shaped
+    "shadow" variable stands for the store in the job: it is saved and loaded together with
+    the store by checkpointing and receives an all-zero diff.
+    """
+    if name is None:
+        name = id_util.UniqueStr("EmbeddingStore_")
+    shadow = flow.get_variable(
+        name=name + "-shadow",
+        shape=(1,),
+        dtype=flow.float,
+        initializer=flow.zeros_initializer(),
+        trainable=trainable,
+    )
+    return (
+        flow.user_op_builder(name)
+        .Op("embedding_store_lookup")
+        .Input("shadow", [shadow])
+        .Input("ids", [ids])
+        .Output("embeddings")
+        .Attr("store_name", shadow.op_name)
+        .Attr("embedding_dim", embedding_dim)
+        .Attr("optimizer", optimizer)
+        .Attr("beta1", float(beta1))
+        .Attr("beta2", float(beta2))
+        .Attr("epsilon", float(epsilon))
+        .Attr("num_shards", num_shards)
+        .Attr("cache_capacity", cache_capacity)
+        .Attr("storage_dir", storage_dir)
+        .Attr("init_scale", float(init_scale))
+        .Attr("seed", seed)
+        .Build()
+        .InferAndTryRun()
+        .SoleOutputBlob()
+    )
@@ -125,6 +125,134 @@ def max_mdsave_worker_num(val):
     sess.config_proto.resource.max_mdsave_worker_num = val
 
 
+@oneflow_export("config.enable_async_checkpoint")
+def api_enable_async_checkpoint(val: bool = True) -> None:
+    r"""Whether or not write checkpoints in background. The variables are copied to host memory
+    when saving and training goes on while the files are written. A checkpoint is complete once
+    its snapshot_done file exists.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_async_checkpoint, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_async_checkpoint(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.enable_async_checkpoint = val
+
+
+@oneflow_export("config.async_checkpoint_writer_num")
+def api_async_checkpoint_writer_num(val: int) -> None:
+    r"""Set up number of threads writing checkpoint files in background.
+
+    Args:
+        val (int):  number of threads
+    """
+    return enable_if.unique([async_checkpoint_writer_num, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def async_checkpoint_writer_num(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.async_checkpoint_writer_num = val
+
+
+@oneflow_export("config.async_checkpoint_max_staging_mbyte")
+def api_async_checkpoint_max_staging_mbyte(val: int) -> None:
+    r"""Set up the host memory in MiB holding variables copied for background checkpoint writing.
+    Saving a variable waits for earlier files to be written when it would exceed this size.
+
+    Args:
+        val (int): memory size in MiB
+    """
+    return enable_if.unique([async_checkpoint_max_staging_mbyte, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def async_checkpoint_max_staging_mbyte(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.async_checkpoint_max_staging_mbyte = val
+
+
+@oneflow_export("config.enable_sharded_checkpoint")
+def api_enable_sharded_checkpoint(val: bool = True) -> None:
+    r"""Whether or not save each part of a split variable to its own shard file with a manifest
+    instead of merging the parts into one file. Loading reads only the overlapping parts of the
+    shards.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_sharded_checkpoint, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_sharded_checkpoint(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.enable_sharded_checkpoint = val
+
+
+@oneflow_export("config.enable_vm_loop_run_worker")
+def api_enable_vm_loop_run_worker(val: bool = True) -> None:
+    r"""Whether or not run each virtual machine thread as a persistent worker which waits for
+    the instructions handed over by the scheduler, instead of posting a task to a thread pool
+    on every scheduling tick.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_vm_loop_run_worker, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_vm_loop_run_worker(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.enable_vm_loop_run_worker = val
+
+
+@oneflow_export("config.op_kernel_infer_cache_size")
+def api_op_kernel_infer_cache_size(val: int) -> None:
+    r"""Set the maximum number of runtime shapes whose inference results are cached by each user
+    op kernel. The least recently used one is evicted when the cache is full.
+
+    Args:
+        val (int): number of cached shapes
+    """
+    return enable_if.unique([op_kernel_infer_cache_size, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def op_kernel_infer_cache_size(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.op_kernel_infer_cache_size = val
+
+
+@oneflow_export("config.enable_shared_op_kernel_infer_cache")
+def api_enable_shared_op_kernel_infer_cache(val: bool = True) -> None:
+    r"""Whether or not share the shape inference cache among the user op kernels running on the
+    same thread which have the same op conf and data types.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_shared_op_kernel_infer_cache, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_shared_op_kernel_infer_cache(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.enable_shared_op_kernel_infer_cache = val
+
+
 @oneflow_export("config.enable_numa_aware_cuda_malloc_host")
 def api_numa_aware_cuda_malloc_host(val: bool = True) -> None:
     r"""Whether or not let numa know  that  cuda allocated host's memory.
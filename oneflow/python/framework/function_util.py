@@ -342,10 +342,36 @@ def policy_time_line(func_desc):
     return "use_time_line_algo"
 
 
+@oneflow_function_config("static_mem_alloc_policy_white_list.policy_local_search")
+def policy_local_search(func_desc):
+    r"""A static memory allocation policy called: local_search
+
+    Args:
+        func_desc ([type]): [description]
+
+    Returns:
+        [type]: [description]
+    """
+    return "use_local_search_algo"
+
+
+@oneflow_function_config("static_mem_alloc_local_search_max_iterations")
+def set_static_mem_alloc_local_search_max_iterations(func_desc, value):
+    r"""Set the number of search steps of the local_search static memory allocation policy for each memory block
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    conf = func_desc.job_config_proto.memory_allocation_algorithm_conf
+    conf.local_search_max_iterations = value
+
+
 @oneflow_function_config("static_mem_alloc_algo_white_list.show")
 def show_static_mem_alloc_algo_white_list(func_desc):
     r"""Show configuration of  static memory allocation policy,
-          including: "use_mem_size_first_algo", "use_mutual_exclusion_first_algo", "use_time_line_algo"
+          including: "use_mem_size_first_algo", "use_mutual_exclusion_first_algo", "use_time_line_algo",
+          "use_local_search_algo"
 
     Args:
         func_desc ([type]): [description]
@@ -357,6 +383,7 @@ def show_static_mem_alloc_algo_white_list(func_desc):
         "use_mem_size_first_algo",
         "use_mutual_exclusion_first_algo",
         "use_time_line_algo",
+        "use_local_search_algo",
     ]
 
 
@@ -765,6 +792,17 @@ def set_use_tensorrt(func_desc, value=True):
     func_desc.job_config_proto.xrt_config.use_tensorrt = value
 
 
+@oneflow_function_config("use_native_jit")
+def set_use_native_jit(func_desc, value=True):
+    r"""Whether use the native cpu fusion engine of xrt or not
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.xrt_config.use_native_jit = value
+
+
 @oneflow_function_config("tensorrt.use_fp16")
 def set_tensorrt_use_fp16(func_desc, value=True):
     r"""Whether use tensorrt fp16  or not
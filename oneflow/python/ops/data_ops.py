@@ -288,6 +288,9 @@ def ofrecord_reader(
     random_shuffle: bool = False,
     shuffle_buffer_size: int = 1024,
     shuffle_after_epoch: bool = False,
+    lazy_parse: bool = False,
+    indexed: bool = False,
+    resume_sample_count: int = 0,
     name: Optional[str] = None,
 ) -> remote_blob_util.BlobDef:
     if name is None:
@@ -305,6 +308,9 @@ def ofrecord_reader(
         .Attr("shuffle_buffer_size", shuffle_buffer_size)
         .Attr("shuffle_after_epoch", shuffle_after_epoch)
         .Attr("part_name_suffix_length", part_name_suffix_length)
+        .Attr("lazy_parse", lazy_parse)
+        .Attr("indexed", indexed)
+        .Attr("resume_sample_count", resume_sample_count)
         .Build()
         .InferAndTryRun()
         .RemoteBlobList()[0]
@@ -306,6 +306,88 @@ def image_decode(
     return op.InferAndTryRun().SoleOutputBlob()
 
 
+@oneflow_export(
+    "image.decode_random_crop_resize", "image_decode_random_crop_resize"
+)
+def api_image_decode_random_crop_resize(
+    images_bytes_buffer: BlobDef,
+    target_width: int,
+    target_height: int,
+    color_space: str = "BGR",
+    interp_type: str = "Linear",
+    num_attempts: int = 10,
+    seed: Optional[int] = None,
+    random_area: Sequence[float] = [0.08, 1.0],
+    random_aspect_ratio: Sequence[float] = [0.75, 1.333333],
+    name: str = "ImageDecodeRandomCropResize",
+) -> BlobDef:
+    assert isinstance(name, str)
+    if seed is not None:
+        assert name is not None
+    module = flow.find_or_create_module(
+        name,
+        lambda: ImageDecodeRandomCropResizeModule(
+            target_width=target_width,
+            target_height=target_height,
+            color_space=color_space,
+            interp_type=interp_type,
+            num_attempts=num_attempts,
+            random_seed=seed,
+            random_area=random_area,
+            random_aspect_ratio=random_aspect_ratio,
+            name=name,
+        ),
+    )
+    return module(images_bytes_buffer)
+
+
+class ImageDecodeRandomCropResizeModule(module_util.Module):
+    def __init__(
+        self,
+        target_width: int,
+        target_height: int,
+        color_space: str,
+        interp_type: str,
+        num_attempts: int,
+        random_seed: Optional[int],
+        random_area: Sequence[float],
+        random_aspect_ratio: Sequence[float],
+        name: str,
+    ):
+        module_util.Module.__init__(self, name)
+        seed, has_seed = flow.random.gen_seed(random_seed)
+        self.op_module_builder = (
+            flow.user_op_module_builder("image_decode_random_crop_resize")
+            .InputSize("in", 1)
+            .Output("out")
+            .Attr("target_width", target_width)
+            .Attr("target_height", target_height)
+            .Attr("color_space", color_space)
+            .Attr("interp_type", interp_type)
+            .Attr("num_attempts", num_attempts)
+            .Attr("random_area", random_area)
+            .Attr("random_aspect_ratio", random_aspect_ratio)
+            .Attr("has_seed", has_seed)
+            .Attr("seed", seed)
+            .CheckAndComplete()
+        )
+        self.op_module_builder.user_op_module.InitOpKernel()
+
+    def forward(self, input: BlobDef):
+        if self.call_seq_no == 0:
+            name = self.module_name
+        else:
+            name = id_util.UniqueStr("ImageDecodeRandomCropResize_")
+
+        return (
+            self.op_module_builder.OpName(name)
+            .Input("in", [input])
+            .Build()
+            .InferAndTryRun()
+            .SoleOutputBlob()
+        )
+
+
 @oneflow_export("image.target_resize", "image_target_resize")
 def image_target_resize(
     images: BlobDef, target_size: int, max_size: int, name: Optional[str] = None
@@ -0,0 +1,51 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+
+def _make_job(enable_fuse_elementwise_ops):
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.enable_fuse_elementwise_ops(enable_fuse_elementwise_ops)
+
+    def ElementwiseJob(
+        x: oft.Numpy.Placeholder((4, 8, 6, 6)),
+        bias: oft.Numpy.Placeholder((8,)),
+        scale: oft.Numpy.Placeholder((1, 8, 1, 1)),
+    ):
+        with flow.scope.placement("cpu", "0:0"):
+            y = flow.math.gelu(flow.nn.bias_add(x, bias, data_format="NCHW"))
+            y = flow.math.relu(y * 2.0 + 1.0)
+            z = flow.math.exp(flow.math.multiply(x, scale))
+            return flow.math.add(y, z)
+
+    ElementwiseJob.__name__ = "ElementwiseJob_{}".format(enable_fuse_elementwise_ops)
+    return flow.global_function(func_config)(ElementwiseJob)
+
+
+def test_fuse_elementwise_ops(test_case):
+    flow.clear_default_session()
+    baseline_job = _make_job(False)
+    fused_job = _make_job(True)
+    x = np.random.uniform(-1, 1, (4, 8, 6, 6)).astype(np.float32)
+    bias = np.random.uniform(-1, 1, (8,)).astype(np.float32)
+    scale = np.random.uniform(-1, 1, (1, 8, 1, 1)).astype(np.float32)
+    baseline_out = baseline_job(x, bias, scale).get().numpy()
+    fused_out = fused_job(x, bias, scale).get().numpy()
+    test_case.assertTrue(np.allclose(baseline_out, fused_out, rtol=1e-5, atol=1e-5))
@@ -97,3 +97,58 @@ def test_image_decode(test_case):
         ],
         # True,
     )
+
+
+def _of_image_decode_random_crop_resize(images, target_width, target_height):
+    image_files = [open(im, "rb") for im in images]
+    images_bytes = [imf.read() for imf in image_files]
+    static_shape = (len(images_bytes), max([len(bys) for bys in images_bytes]))
+    for imf in image_files:
+        imf.close()
+
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.mirrored_view())
+
+    @flow.global_function(func_config)
+    def image_decode_random_crop_resize_job(
+        images_def: oft.ListListNumpy.Placeholder(shape=static_shape, dtype=flow.int8)
+    ):
+        images_buffer = flow.tensor_list_to_tensor_buffer(images_def)
+        fused_images = flow.image.decode_random_crop_resize(
+            images_buffer,
+            target_width=target_width,
+            target_height=target_height,
+            random_area=[1.0, 1.0],
+            random_aspect_ratio=[0.01, 100.0],
+            seed=1,
+        )
+        decoded_images_buffer = flow.image_decode(images_buffer)
+        resized_images = flow.image.resize(
+            decoded_images_buffer, resize_x=target_width, resize_y=target_height
+        )
+        return fused_images, resized_images
+
+    images_np_arr = [
+        np.frombuffer(bys, dtype=np.byte).reshape(1, -1) for bys in images_bytes
+    ]
+    fused_images, resized_images = image_decode_random_crop_resize_job([images_np_arr])
+    return fused_images.get().numpy_list()[0], resized_images.get().numpy_list()[0]
+
+
+def test_image_decode_random_crop_resize(test_case):
+    # random_area of [1.0, 1.0] makes the crop window the whole image, so the fused op should
+    # match decode + resize up to the error of DCT domain downscaling
+    fused_images, resized_images = _of_image_decode_random_crop_resize(
+        [
+            "/dataset/mscoco_2017/val2017/000000000139.jpg",
+            "/dataset/mscoco_2017/val2017/000000000632.jpg",
+        ],
+        target_width=112,
+        target_height=112,
+    )
+    test_case.assertEqual(fused_images.shape, (2, 112, 112, 3))
+    test_case.assertEqual(fused_images.shape, resized_images.shape)
+    diff = np.abs(fused_images.astype(np.float32) - resized_images.astype(np.float32))
+    test_case.assertTrue(diff.mean() < 8.0)
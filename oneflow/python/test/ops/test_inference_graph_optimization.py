@@ -0,0 +1,131 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+
+def _make_predict_job(x_shape, data_format, enable_inference_graph_optimization):
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.enable_inference_graph_optimization(enable_inference_graph_optimization)
+    channel_axis = 1 if data_format == "NCHW" else 3
+
+    def PredictJob(x: oft.Numpy.Placeholder(x_shape)):
+        y = flow.layers.conv2d(
+            x,
+            8,
+            kernel_size=3,
+            padding="SAME",
+            data_format=data_format,
+            name="conv0",
+        )
+        y = flow.layers.batch_normalization(
+            y,
+            axis=channel_axis,
+            moving_mean_initializer=flow.random_uniform_initializer(-1, 1),
+            moving_variance_initializer=flow.random_uniform_initializer(0.5, 2),
+            gamma_initializer=flow.random_uniform_initializer(0.5, 2),
+            beta_initializer=flow.random_uniform_initializer(-1, 1),
+            name="bn0",
+        )
+        y = flow.layers.conv2d(
+            y,
+            8,
+            kernel_size=3,
+            padding="SAME",
+            data_format=data_format,
+            use_bias=False,
+            name="conv1",
+        )
+        y = flow.layers.batch_normalization(
+            y, axis=channel_axis, center=False, scale=False, name="bn1"
+        )
+        y = flow.transpose(flow.transpose(y, perm=[0, 2, 3, 1]), perm=[0, 3, 1, 2])
+        y = flow.reshape(flow.reshape(y, shape=(x_shape[0], -1)), shape=y.shape)
+        y = flow.cast(flow.cast(y, dtype=flow.double), dtype=flow.float)
+        bias = flow.math.sqrt(
+            flow.constant(4.0, dtype=flow.float, shape=(1,)) * 0.25 + 3.0
+        )
+        return y + bias
+
+    PredictJob.__name__ = "PredictJob_{}_{}".format(
+        data_format, enable_inference_graph_optimization
+    )
+    return flow.global_function(func_config)(PredictJob)
+
+
+def _make_dense_predict_job(x_shape, enable_inference_graph_optimization):
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.enable_inference_graph_optimization(enable_inference_graph_optimization)
+
+    def DensePredictJob(x: oft.Numpy.Placeholder(x_shape)):
+        y = flow.layers.dense(x, 16, name="dense0")
+        y = flow.layers.batch_normalization(
+            y,
+            axis=1,
+            moving_mean_initializer=flow.random_uniform_initializer(-1, 1),
+            moving_variance_initializer=flow.random_uniform_initializer(0.5, 2),
+            gamma_initializer=flow.random_uniform_initializer(0.5, 2),
+            beta_initializer=flow.random_uniform_initializer(-1, 1),
+            name="bn0",
+        )
+        return flow.math.relu(y)
+
+    DensePredictJob.__name__ = "DensePredictJob_{}".format(
+        enable_inference_graph_optimization
+    )
+    return flow.global_function(func_config)(DensePredictJob)
+
+
+def _compare_outputs(test_case, baseline_job, optimized_job, x_shape):
+    check_point = flow.train.CheckPoint()
+    x = np.random.uniform(-1, 1, x_shape).astype(np.float32)
+    # the folded parameters are cached, so re-initializing the variables must refold them
+    for _ in range(2):
+        check_point.init()
+        baseline_out = baseline_job(x).get().numpy()
+        optimized_out = optimized_job(x).get().numpy()
+        test_case.assertTrue(
+            np.allclose(baseline_out, optimized_out, rtol=1e-4, atol=1e-4)
+        )
+
+
+def _compare_with_and_without_optimization(test_case, data_format):
+    flow.clear_default_session()
+    x_shape = (4, 3, 32, 32) if data_format == "NCHW" else (4, 32, 32, 3)
+    baseline_job = _make_predict_job(x_shape, data_format, False)
+    optimized_job = _make_predict_job(x_shape, data_format, True)
+    _compare_outputs(test_case, baseline_job, optimized_job, x_shape)
+
+
+def test_inference_graph_optimization_nchw(test_case):
+    _compare_with_and_without_optimization(test_case, "NCHW")
+
+
+def test_inference_graph_optimization_nhwc(test_case):
+    _compare_with_and_without_optimization(test_case, "NHWC")
+
+
+def test_inference_graph_optimization_dense(test_case):
+    flow.clear_default_session()
+    x_shape = (4, 32)
+    baseline_job = _make_dense_predict_job(x_shape, False)
+    optimized_job = _make_dense_predict_job(x_shape, True)
+    _compare_outputs(test_case, baseline_job, optimized_job, x_shape)
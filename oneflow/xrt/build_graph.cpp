@@ -131,6 +131,10 @@ void GraphBuilder::SetupGraphEdges() {
     sbp_policy.push_back(BlobSbpPolicy(src, name));
     sbp_policy.push_back(BlobSbpPolicy(dst, name));
     edge->Attr("sbp_policy", sbp_policy);
+    // Set data type, which is checked by the engines supporting only some of them
+    if (!edge->IsControlEdge()) {
+      edge->Attr("data_type", src->LogicalBlobDesc4Lbi(BlobNameToId(name)).data_type());
+    }
   }
 }
 
@@ -15,9 +15,23 @@ limitations under the License.
 */
 #include "oneflow/xrt/compilation_cache.h"
 
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "oneflow/core/persistence/file_system.h"
+
 namespace oneflow {
 namespace xrt {
 
+namespace {
+
+constexpr char kPersistentMagic[] = "XRTEXEC1";
+
+}  // namespace
+
 bool operator==(const Signature &lhs, const Signature &rhs) {
   return lhs.builder_name == rhs.builder_name && lhs.device_ordinal == rhs.device_ordinal
          && lhs.entry_shapes == rhs.entry_shapes;
@@ -42,25 +56,186 @@ Signature ComputeSignature(const std::string &name, const int device_ordinal,
   return std::move(signature);
 }
 
-Executable *CompilationCache::GetRecord(const Signature &signature) const {
+ShapeBucketOptions MakeShapeBucketOptions(const std::string &policy, int64_t granularity) {
+  ShapeBucketOptions options;
+  if (policy == "static") {
+    options.policy = ShapeBucketPolicy::kStatic;
+  } else if (policy == "exact") {
+    options.policy = ShapeBucketPolicy::kExact;
+  } else if (policy == "pow2") {
+    options.policy = ShapeBucketPolicy::kPowerOfTwo;
+  } else if (policy == "multiple") {
+    CHECK_GT(granularity, 0) << "Shape bucket granularity should be positive.";
+    options.policy = ShapeBucketPolicy::kMultiple;
+    options.granularity = granularity;
+  } else {
+    LOG(FATAL) << "Unknown shape bucket policy: " << policy;
+  }
+  return options;
+}
+
+int64_t BucketDimension(const ShapeBucketOptions &options, int64_t dim, int64_t capacity) {
+  CHECK_LE(dim, capacity);
+  int64_t bucket = dim;
+  switch (options.policy) {
+    case ShapeBucketPolicy::kStatic: bucket = capacity; break;
+    case ShapeBucketPolicy::kExact: break;
+    case ShapeBucketPolicy::kPowerOfTwo: {
+      bucket = 1;
+      while (bucket < dim) { bucket <<= 1; }
+      break;
+    }
+    case ShapeBucketPolicy::kMultiple: {
+      bucket = (dim + options.granularity - 1) / options.granularity * options.granularity;
+      break;
+    }
+  }
+  return std::min(bucket, capacity);
+}
+
+Executable *CompilationCache::GetRecord(const Signature &signature) {
   Executable *record = nullptr;
   // std::shared_lock<std::shared_mutex> lock(mutex_);
   std::lock_guard<std::mutex> lock(mutex_);
   const auto &it = records_.find(signature);
-  if (it != records_.end()) { record = it->second.get(); }
+  if (it != records_.end()) {
+    lru_list_.splice(lru_list_.begin(), lru_list_, it->second.lru_iter);
+    record = it->second.executable.get();
+    ++stats_.hits;
+  } else {
+    ++stats_.misses;
+  }
   return record;
 }
 
 void CompilationCache::Record(const Signature &signature,
-                              const std::shared_ptr<Executable> &result) {
+                              const std::shared_ptr<Executable> &result, int64_t compile_time_us,
+                              std::vector<std::shared_ptr<Executable>> *evicted) {
   // std::unique_lock<std::shared_mutex> lock(mutex_);
   std::lock_guard<std::mutex> lock(mutex_);
-  records_.emplace(signature, result);
+  stats_.compile_time_us += compile_time_us;
+  auto it = records_.find(signature);
+  if (it != records_.end()) {
+    evicted->push_back(it->second.executable);
+    it->second.executable = result;
+    it->second.persisted = false;
+    lru_list_.splice(lru_list_.begin(), lru_list_, it->second.lru_iter);
+  } else {
+    lru_list_.push_front(signature);
+    CachedRecord record;
+    record.executable = result;
+    record.lru_iter = lru_list_.begin();
+    records_.emplace(signature, record);
+  }
+  EvictRecords(evicted);
+}
+
+void CompilationCache::EvictRecords(std::vector<std::shared_ptr<Executable>> *evicted) {
+  const auto OutOfBounds = [&]() -> bool {
+    if (options_.capacity >= 0 && records_.size() > options_.capacity) { return true; }
+    if (options_.max_bytes < 0) { return false; }
+    int64_t footprint_bytes = 0;
+    for (const auto &pair : records_) {
+      footprint_bytes += pair.second.executable->FootprintBytes();
+    }
+    return footprint_bytes > options_.max_bytes;
+  };
+  // The most recently used record is always kept.
+  while (records_.size() > 1 && OutOfBounds()) {
+    auto it = records_.find(lru_list_.back());
+    evicted->push_back(it->second.executable);
+    records_.erase(it);
+    lru_list_.pop_back();
+    ++stats_.evictions;
+  }
+}
+
+std::string CompilationCache::PersistentPath(const std::string &key) const {
+  std::ostringstream path;
+  path << options_.persistent_dir << "/" << std::hex << std::hash<std::string>()(key) << ".xrt";
+  return path.str();
+}
+
+Executable *CompilationCache::LoadPersistentRecord(
+    const Signature &signature, const XrtEngine &engine, const std::string &key,
+    const std::vector<Parameter> &entry_params, std::vector<std::shared_ptr<Executable>> *evicted) {
+  if (!persistent() || !ExecutableLoaderRegistry()->IsRegistered(engine)) { return nullptr; }
+  std::ifstream infile(PersistentPath(key), std::ios::in | std::ios::binary);
+  if (!infile.good()) { return nullptr; }
+  std::stringstream buffer;
+  buffer << infile.rdbuf();
+  const std::string content = buffer.str();
+
+  // The layout is the magic, the key size, the key and the serialized executable.
+  const size_t magic_size = sizeof(kPersistentMagic) - 1;
+  uint64_t key_size = 0;
+  const size_t header_size = magic_size + sizeof(key_size);
+  if (content.size() < header_size || content.compare(0, magic_size, kPersistentMagic) != 0) {
+    return nullptr;
+  }
+  std::memcpy(&key_size, content.data() + magic_size, sizeof(key_size));
+  // Different keys may be hashed into the same file.
+  if (content.size() < header_size + key_size
+      || content.compare(header_size, key_size, key) != 0) {
+    return nullptr;
+  }
+  const std::string serialized = content.substr(header_size + key_size);
+  auto executable =
+      ExecutableLoaderRegistry()->Lookup(engine)(signature.builder_name, serialized, entry_params);
+  if (!executable) { return nullptr; }
+
+  Record(signature, executable, 0 /*compile_time_us*/, evicted);
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.persistent_hits;
+  auto it = records_.find(signature);
+  it->second.persisted = true;
+  return it->second.executable.get();
+}
+
+void CompilationCache::PersistRecord(const Signature &signature, const std::string &key) {
+  if (!persistent()) { return; }
+  std::shared_ptr<Executable> executable;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = records_.find(signature);
+    if (it == records_.end() || it->second.persisted) { return; }
+    it->second.persisted = true;
+    executable = it->second.executable;
+  }
+  std::string serialized;
+  if (!executable->SerializeToString(&serialized)) { return; }
+
+  LocalFS()->RecursivelyCreateDirIfNotExist(options_.persistent_dir);
+  const std::string path = PersistentPath(key);
+  // Write to a temporary file first, so that other processes never read a
+  // partially written executable.
+  const std::string temp_path = path + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream outfile(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    const uint64_t key_size = key.size();
+    outfile.write(kPersistentMagic, sizeof(kPersistentMagic) - 1);
+    outfile.write(reinterpret_cast<const char *>(&key_size), sizeof(key_size));
+    outfile.write(key.data(), key.size());
+    outfile.write(serialized.data(), serialized.size());
+    if (!outfile.good()) {
+      LOG(WARNING) << "Failed to persist executable " << executable->name() << " to " << path;
+      std::remove(temp_path.c_str());
+      return;
+    }
+  }
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) { std::remove(temp_path.c_str()); }
+}
+
+CompilationCacheStats CompilationCache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
 }
 
 void CompilationCache::Release() {
-  util::Map<Signature, std::shared_ptr<Executable>, SignatureHash> empty_records;
+  std::lock_guard<std::mutex> lock(mutex_);
+  util::Map<Signature, CachedRecord, SignatureHash> empty_records;
   records_.swap(empty_records);
+  lru_list_.clear();
 }
 
 }  // namespace xrt
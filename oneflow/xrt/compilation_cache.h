@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef ONEFLOW_XRT_COMPILATION_CACHE_H_
 #define ONEFLOW_XRT_COMPILATION_CACHE_H_
 
+#include <functional>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -25,6 +27,8 @@ limitations under the License.
 #include "oneflow/core/common/shape.h"
 #include "oneflow/xrt/executable.h"
 #include "oneflow/xrt/parameter.h"
+#include "oneflow/xrt/types.h"
+#include "oneflow/xrt/utility/registry.h"
 #include "oneflow/xrt/utility/stl.h"
 
 namespace oneflow {
@@ -49,18 +53,116 @@ struct SignatureHash {
 Signature ComputeSignature(const std::string &name, const int device_ordinal,
                            const std::vector<xrt::Parameter> &entry_params);
 
+// Policy to bucket the leading dimension of the dynamic entry shapes, so that
+// one executable is compiled for all the shapes falling into the same bucket.
+enum class ShapeBucketPolicy {
+  // Always use the static shapes of the blobs.
+  kStatic = 0,
+  // Use the runtime shapes of the blobs without padding.
+  kExact = 1,
+  // Pad the leading dimension to the nearest power of two.
+  kPowerOfTwo = 2,
+  // Pad the leading dimension to the nearest multiple of the granularity.
+  kMultiple = 3,
+};
+
+struct ShapeBucketOptions {
+  ShapeBucketPolicy policy = ShapeBucketPolicy::kStatic;
+  int64_t granularity = 1;
+};
+
+// `policy` should be one of "static", "exact", "pow2" and "multiple".
+ShapeBucketOptions MakeShapeBucketOptions(const std::string &policy, int64_t granularity);
+
+// Returns the bucket of `dim`, which is never larger than `capacity`.
+int64_t BucketDimension(const ShapeBucketOptions &options, int64_t dim, int64_t capacity);
+
+struct CompilationCacheOptions {
+  // Maximum number of the recorded executables, -1 means unlimited.
+  int64_t capacity = -1;
+  // Maximum footprint bytes of the recorded executables, -1 means unlimited.
+  int64_t max_bytes = -1;
+  // Directory of the persistent executables, empty means no persistence.
+  std::string persistent_dir = "";
+};
+
+struct CompilationCacheStats {
+  int64_t hits = 0;
+  int64_t misses = 0;
+  int64_t evictions = 0;
+  // Misses which are restored from the persistent directory.
+  int64_t persistent_hits = 0;
+  int64_t compile_time_us = 0;
+};
+
+// Restores the executable serialized by `Executable::SerializeToString`.
+// It should return nullptr if the executable does not match the entry params.
+using ExecutableLoader = std::function<std::shared_ptr<Executable>(
+    const std::string & /*name*/, const std::string & /*serialized*/,
+    const std::vector<Parameter> & /*entry_params*/)>;
+
+inline util::Registry<XrtEngine, ExecutableLoader> *ExecutableLoaderRegistry() {
+  return util::Registry<XrtEngine, ExecutableLoader>::Global();
+}
+
+#define REGISTER_EXECUTABLE_LOADER(Engine, Loader)                                   \
+  namespace {                                                                        \
+  struct _XrtExecutableLoader {                                                      \
+    _XrtExecutableLoader() { ExecutableLoaderRegistry()->Register(Engine, Loader); } \
+  };                                                                                 \
+  static _XrtExecutableLoader _xrt_executable_loader_ __attribute__((unused));       \
+  }  // namespace
+
 class CompilationCache {
  public:
-  Executable *GetRecord(const Signature &signature) const;
+  CompilationCache() = default;
+  explicit CompilationCache(const CompilationCacheOptions &options) : options_(options) {}
+
+  // Returns nullptr if there is no record, otherwise the record becomes the
+  // most recently used one.
+  Executable *GetRecord(const Signature &signature);
+
+  // The least recently used records are evicted if the cache is out of bounds
+  // after recording. They are moved into `evicted` since the caller may have to
+  // wait for their asynchronous runs before releasing them.
+  void Record(const Signature &signature, const std::shared_ptr<Executable> &result,
+              int64_t compile_time_us, std::vector<std::shared_ptr<Executable>> *evicted);
+
+  // Restores and records the executable persisted with `key`, returns nullptr
+  // if it is not found or does not match the entry params.
+  Executable *LoadPersistentRecord(const Signature &signature, const XrtEngine &engine,
+                                   const std::string &key,
+                                   const std::vector<Parameter> &entry_params,
+                                   std::vector<std::shared_ptr<Executable>> *evicted);
 
-  void Record(const Signature &signature, const std::shared_ptr<Executable> &result);
+  // Writes the recorded executable into the persistent directory if its
+  // engine supports serialization. Each record is persisted at most once.
+  void PersistRecord(const Signature &signature, const std::string &key);
+
+  bool persistent() const { return !options_.persistent_dir.empty(); }
+
+  CompilationCacheStats stats() const;
 
   void Release();
 
  private:
+  struct CachedRecord {
+    std::shared_ptr<Executable> executable;
+    std::list<Signature>::iterator lru_iter;
+    bool persisted = false;
+  };
+
+  void EvictRecords(std::vector<std::shared_ptr<Executable>> *evicted);
+
+  std::string PersistentPath(const std::string &key) const;
+
+  CompilationCacheOptions options_;
   // static std::shared_mutex mutex_;
   mutable std::mutex mutex_;
-  util::Map<Signature, std::shared_ptr<Executable>, SignatureHash> records_;
+  // The most recently used signature is at the front.
+  std::list<Signature> lru_list_;
+  util::Map<Signature, CachedRecord, SignatureHash> records_;
+  CompilationCacheStats stats_;
 };
 
 }  // namespace xrt
@@ -0,0 +1,143 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/compilation_cache.h"
+
+namespace oneflow {
+namespace xrt {
+
+namespace {
+
+class FakeExecutable : public Executable {
+ public:
+  explicit FakeExecutable(int64_t footprint_bytes)
+      : Executable("fake", XrtEngine::XLA), footprint_bytes_(footprint_bytes) {}
+
+  bool Run(const std::vector<Parameter> &inputs, const ExecutableRunOptions &run_options,
+           bool block_until_done) override {
+    return true;
+  }
+
+  int64_t FootprintBytes() const override { return footprint_bytes_; }
+
+ private:
+  int64_t footprint_bytes_;
+};
+
+Signature MakeSignature(int64_t dim) {
+  Signature signature;
+  signature.builder_name = "launch";
+  signature.device_ordinal = 0;
+  signature.entry_shapes.push_back(Shape({dim, 16}));
+  return signature;
+}
+
+std::shared_ptr<Executable> RecordFake(CompilationCache *cache, int64_t dim,
+                                       int64_t footprint_bytes,
+                                       std::vector<std::shared_ptr<Executable>> *evicted) {
+  auto executable = std::make_shared<FakeExecutable>(footprint_bytes);
+  cache->Record(MakeSignature(dim), executable, 10 /*compile_time_us*/, evicted);
+  return executable;
+}
+
+}  // namespace
+
+TEST(BucketDimension, static_and_exact) {
+  const ShapeBucketOptions static_options = MakeShapeBucketOptions("static", 8);
+  ASSERT_EQ(BucketDimension(static_options, 3, 64), 64);
+  ASSERT_EQ(BucketDimension(static_options, 64, 64), 64);
+  const ShapeBucketOptions exact_options = MakeShapeBucketOptions("exact", 8);
+  ASSERT_EQ(BucketDimension(exact_options, 1, 64), 1);
+  ASSERT_EQ(BucketDimension(exact_options, 37, 64), 37);
+}
+
+TEST(BucketDimension, power_of_two) {
+  const ShapeBucketOptions options = MakeShapeBucketOptions("pow2", 8);
+  ASSERT_EQ(BucketDimension(options, 1, 100), 1);
+  ASSERT_EQ(BucketDimension(options, 2, 100), 2);
+  ASSERT_EQ(BucketDimension(options, 3, 100), 4);
+  ASSERT_EQ(BucketDimension(options, 33, 100), 64);
+  ASSERT_EQ(BucketDimension(options, 64, 100), 64);
+  // never larger than the capacity
+  ASSERT_EQ(BucketDimension(options, 65, 100), 100);
+}
+
+TEST(BucketDimension, multiple) {
+  const ShapeBucketOptions options = MakeShapeBucketOptions("multiple", 8);
+  ASSERT_EQ(BucketDimension(options, 1, 30), 8);
+  ASSERT_EQ(BucketDimension(options, 8, 30), 8);
+  ASSERT_EQ(BucketDimension(options, 9, 30), 16);
+  ASSERT_EQ(BucketDimension(options, 25, 30), 30);
+  ASSERT_EQ(BucketDimension(options, 30, 30), 30);
+}
+
+TEST(CompilationCache, lru_eviction_by_capacity) {
+  CompilationCacheOptions options;
+  options.capacity = 2;
+  CompilationCache cache(options);
+  std::vector<std::shared_ptr<Executable>> evicted;
+  RecordFake(&cache, 1, 0, &evicted);
+  RecordFake(&cache, 2, 0, &evicted);
+  ASSERT_TRUE(evicted.empty());
+  // 1 becomes the most recently used one, so 2 is evicted by 3
+  ASSERT_NE(cache.GetRecord(MakeSignature(1)), nullptr);
+  auto third = RecordFake(&cache, 3, 0, &evicted);
+  ASSERT_EQ(evicted.size(), 1);
+  ASSERT_EQ(cache.GetRecord(MakeSignature(2)), nullptr);
+  ASSERT_NE(cache.GetRecord(MakeSignature(1)), nullptr);
+  ASSERT_EQ(cache.GetRecord(MakeSignature(3)), third.get());
+
+  const CompilationCacheStats stats = cache.stats();
+  ASSERT_EQ(stats.hits, 3);
+  ASSERT_EQ(stats.misses, 1);
+  ASSERT_EQ(stats.evictions, 1);
+  ASSERT_EQ(stats.compile_time_us, 30);
+}
+
+TEST(CompilationCache, lru_eviction_by_bytes) {
+  CompilationCacheOptions options;
+  options.max_bytes = 100;
+  CompilationCache cache(options);
+  std::vector<std::shared_ptr<Executable>> evicted;
+  auto first = RecordFake(&cache, 1, 40, &evicted);
+  RecordFake(&cache, 2, 40, &evicted);
+  ASSERT_TRUE(evicted.empty());
+  // 120 bytes in total, the least recently used one is evicted
+  RecordFake(&cache, 3, 40, &evicted);
+  ASSERT_EQ(evicted.size(), 1);
+  ASSERT_EQ(evicted.front(), first);
+  ASSERT_EQ(cache.GetRecord(MakeSignature(1)), nullptr);
+  ASSERT_NE(cache.GetRecord(MakeSignature(2)), nullptr);
+  // the most recently used record is kept even if it is over the bound alone
+  evicted.clear();
+  auto huge = RecordFake(&cache, 4, 1000, &evicted);
+  ASSERT_EQ(evicted.size(), 2);
+  ASSERT_EQ(cache.GetRecord(MakeSignature(4)), huge.get());
+  ASSERT_EQ(cache.stats().evictions, 3);
+}
+
+TEST(CompilationCache, rerecord_replaces_executable) {
+  CompilationCache cache;
+  std::vector<std::shared_ptr<Executable>> evicted;
+  auto first = RecordFake(&cache, 1, 0, &evicted);
+  auto second = RecordFake(&cache, 1, 0, &evicted);
+  ASSERT_EQ(evicted.size(), 1);
+  ASSERT_EQ(evicted.front(), first);
+  ASSERT_EQ(cache.GetRecord(MakeSignature(1)), second.get());
+  ASSERT_EQ(cache.stats().evictions, 0);
+}
+
+}  // namespace xrt
+}  // namespace oneflow
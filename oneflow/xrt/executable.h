@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef ONEFLOW_XRT_EXECUTABLE_H_
 #define ONEFLOW_XRT_EXECUTABLE_H_
 
+#include <string>
 #include <vector>
 
 #include "oneflow/xrt/parameter.h"
@@ -78,6 +79,14 @@ class Executable {
 
   const std::vector<Parameter> &Results() const { return results_; }
 
+  // Bytes of the memory held by the executable, which is charged to the
+  // compilation cache. Returns 0 if the engine can not tell it.
+  virtual int64_t FootprintBytes() const { return 0; }
+
+  // Serializes the executable so that it can be restored by the executable
+  // loader registered for its engine. Returns false if it is not supported.
+  virtual bool SerializeToString(std::string *serialized) const { return false; }
+
  protected:
   // Executable name.
   std::string name_;
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef ONEFLOW_XRT_KERNEL_OP_KERNEL_H_
 #define ONEFLOW_XRT_KERNEL_OP_KERNEL_H_
 
+#include "oneflow/core/common/data_type.pb.h"
 #include "oneflow/xrt/kernel/op_context.h"
 #include "oneflow/xrt/types.h"
 #include "oneflow/xrt/utility/registry.h"
@@ -47,6 +48,8 @@ class OpKernelRegistrar {
   bool train_phase_enabled_ = false;
   bool is_optimizer_op_ = false;
   util::Set<std::string> mutable_variables_ = {};
+  // Empty means all the data types are supported.
+  util::Set<DataType> supported_data_types_ = {};
 
  public:
   explicit OpKernelRegistrar(const std::string &name) : op_name_(name) {}
@@ -82,6 +85,11 @@ class OpKernelRegistrar {
     return *this;
   }
 
+  OpKernelRegistrar &SetSupportedDataTypes(const util::Set<DataType> &data_types) {
+    supported_data_types_ = data_types;
+    return *this;
+  }
+
   OpKernelRegistrar &EnableTrainPhase() {
     train_phase_enabled_ = true;
     return *this;
@@ -92,6 +100,7 @@ class OpKernelRegistrar {
     attributes[TrainPhaseEnabledAttrName] = train_phase_enabled_;
     attributes[IsOptimizerOpAttrName] = is_optimizer_op_;
     attributes[MutableVariablesAttrName] = mutable_variables_;
+    attributes[SupportedDataTypesAttrName] = supported_data_types_;
 
     for (const auto &device : device_) {
       XrtField field = MakeXrtField(device, engine_field_);
@@ -134,6 +143,11 @@ inline const util::Set<std::string> &MutableVariables(const std::string &op_type
   return LookupOpKernelAttr<util::Set<std::string>>(op_type, field, MutableVariablesAttrName);
 }
 
+inline const util::Set<DataType> &SupportedDataTypes(const std::string &op_type,
+                                                    const XrtField &field) {
+  return LookupOpKernelAttr<util::Set<DataType>>(op_type, field, SupportedDataTypesAttrName);
+}
+
 inline const bool &TrainPhaseEnabled(const std::string &op_type, const XrtField &field) {
   return LookupOpKernelAttr<bool>(op_type, field, TrainPhaseEnabledAttrName);
 }
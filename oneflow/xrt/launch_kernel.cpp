@@ -14,6 +14,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/xrt/launch_kernel.h"
+#include <chrono>
+#include <sstream>
+#include "oneflow/core/common/protobuf.h"
 #include "oneflow/xrt/api.h"
 #include "oneflow/xrt/compilation_cache.h"
 #include "oneflow/xrt/executable.h"
@@ -24,6 +27,21 @@ limitations under the License.
 // General executable setup.
 DEFINE_int64(max_workspace_bytes, EnvToInt64(FLAGS_max_workspace_bytes, -1),
              "Maximum temporary workspace bytes.");
+// Compilation cache setup.
+DEFINE_string(xrt_shape_bucket_policy, EnvToString(FLAGS_xrt_shape_bucket_policy, "static"),
+              "Policy to bucket the leading dimension of dynamic entry shapes, which is one of "
+              "static, exact, pow2 and multiple.");
+DEFINE_int64(xrt_shape_bucket_granularity, EnvToInt64(FLAGS_xrt_shape_bucket_granularity, 8),
+             "Granularity of the shape buckets for the multiple policy.");
+DEFINE_int64(xrt_compilation_cache_capacity, EnvToInt64(FLAGS_xrt_compilation_cache_capacity, -1),
+             "Maximum executables cached by each launch kernel, -1 means unlimited.");
+DEFINE_int64(xrt_compilation_cache_max_bytes,
+             EnvToInt64(FLAGS_xrt_compilation_cache_max_bytes, -1),
+             "Maximum footprint bytes of the executables cached by each launch kernel, "
+             "-1 means unlimited.");
+DEFINE_string(xrt_compilation_cache_dir, EnvToString(FLAGS_xrt_compilation_cache_dir, ""),
+              "Directory to persist the serialized executables across processes, "
+              "empty means no persistence.");
 // TENSORRT executable setup.
 DEFINE_int32(max_batch_size, EnvToInt(FLAGS_max_batch_size, 1),
              "Maximum batch size for builder of TENSORRT engine.");
@@ -34,10 +52,159 @@ DECLARE_string(int8_calibration);
 
 namespace oneflow {
 namespace xrt {
-static Parameter BuildParameter(const Blob &blob, const std::string &name) {
-  const auto &desc = blob.blob_desc();
-  return Parameter(name, const_cast<void *>(blob.dptr<void>()), desc.body_shape(),
-                   desc.data_type());
+static Parameter BuildParameter(const Blob &blob, const Shape &shape, const std::string &name) {
+  return Parameter(name, const_cast<void *>(blob.dptr<void>()), shape,
+                   blob.blob_desc().data_type());
+}
+
+static std::vector<std::string> UserOpBlobNames(
+    const PbMap<std::string, UserOpConf::ListString> &args, const std::string &arg_name) {
+  std::vector<std::string> names;
+  const auto &it = args.find(arg_name);
+  if (it != args.end()) { names.assign(it->second.s().begin(), it->second.s().end()); }
+  return names;
+}
+
+static bool UserOpBoolAttr(const UserOpConf &user_conf, const std::string &attr_name) {
+  const auto &it = user_conf.attr().find(attr_name);
+  return it != user_conf.attr().end() && it->second.at_bool();
+}
+
+// Returns false if the node is neither a user op nor an identity op.
+static bool NodeBlobNames(const OperatorConf &node_conf, std::vector<std::string> *inputs,
+                          std::vector<std::string> *outputs) {
+  if (node_conf.has_user_conf()) {
+    for (const auto &pair : node_conf.user_conf().input()) {
+      for (const std::string &name : pair.second.s()) { inputs->push_back(name); }
+    }
+    for (const auto &pair : node_conf.user_conf().output()) {
+      for (const std::string &name : pair.second.s()) { outputs->push_back(name); }
+    }
+    return true;
+  } else if (node_conf.has_identity_conf()) {
+    inputs->push_back(node_conf.identity_conf().in());
+    outputs->push_back(node_conf.name() + "/" + node_conf.identity_conf().out());
+    return true;
+  }
+  return false;
+}
+
+// Returns true if each row of the blobs derived from the `batched` entries is
+// computed from the same row of the batched entries only, so that the garbage
+// rows padded by bucketing never reach the valid rows. The derived blobs are
+// added into `batched`. Ops mixing rows such as reductions, softmax and
+// normalization over the batch are rejected.
+static bool IsRowIndependentFunction(const XrtLaunchOpConf::Function &function,
+                                     util::Set<std::string> *batched) {
+  static const util::Set<std::string> elementwise_ops = {
+      "Identity", "Cast",      "Relu",      "LeakyRelu", "Sigmoid", "Tanh",     "TanhGrad",
+      "Gelu",     "GeluGrad",  "ScalarAdd", "ScalarMul", "Add",     "Multiply",
+  };
+  static const util::Set<std::string> broadcast_ops = {"BcastAdd", "BcastMul", "BcastDiv"};
+  const int num_nodes = function.node_size();
+  std::vector<std::vector<std::string>> node_inputs(num_nodes), node_outputs(num_nodes);
+  util::Map<std::string, int> producers;
+  for (int i = 0; i < num_nodes; ++i) {
+    if (!NodeBlobNames(function.node(i), &node_inputs[i], &node_outputs[i])) { return false; }
+    for (const std::string &name : node_outputs[i]) { producers[name] = i; }
+  }
+  // The function nodes are not in topological order, so a node is visited
+  // after all the nodes producing its inputs.
+  std::vector<bool> visited(num_nodes, false);
+  for (int num_visited = 0; num_visited < num_nodes;) {
+    const int last_num_visited = num_visited;
+    for (int i = 0; i < num_nodes; ++i) {
+      if (visited[i]) { continue; }
+      bool ready = true;
+      for (const std::string &name : node_inputs[i]) {
+        const auto &it = producers.find(name);
+        if (it != producers.end() && !visited[it->second]) { ready = false; }
+      }
+      if (!ready) { continue; }
+      visited[i] = true;
+      ++num_visited;
+
+      const OperatorConf &node_conf = function.node(i);
+      int batched_inputs = 0;
+      for (const std::string &name : node_inputs[i]) { batched_inputs += batched->count(name); }
+      if (batched_inputs == 0) { continue; }
+      const std::string op_type = ExtractOpTypeAsString(node_conf);
+      bool row_independent = false;
+      if (elementwise_ops.count(op_type) > 0) {
+        row_independent = (batched_inputs == node_inputs[i].size());
+      } else if (broadcast_ops.count(op_type) > 0) {
+        row_independent = true;
+      } else if (op_type == "BiasAdd") {
+        const UserOpConf &user_conf = node_conf.user_conf();
+        const auto &b = UserOpBlobNames(user_conf.input(), "b");
+        row_independent = user_conf.attr().at("axis").at_int32() != 0 && b.size() == 1
+                          && batched->count(b[0]) == 0;
+      } else if (op_type == "MatMul") {
+        const UserOpConf &user_conf = node_conf.user_conf();
+        const auto &b = UserOpBlobNames(user_conf.input(), "b");
+        row_independent = !UserOpBoolAttr(user_conf, "transpose_a") && b.size() == 1
+                          && batched->count(b[0]) == 0;
+      }
+      if (!row_independent) { return false; }
+      batched->insert(node_outputs[i].begin(), node_outputs[i].end());
+    }
+    CHECK_GT(num_visited, last_num_visited) << "The launch function has a cycle.";
+  }
+  return true;
+}
+
+// Returns the runtime leading dimension shared by the dynamic inputs, and sets
+// `shapes` to the shapes of the inputs followed by the outputs to compile and
+// run with. The leading dimension of the dynamic blobs is bucketed only if
+// `bucketable` and it is the only dynamic dimension of the inputs, otherwise
+// the static shapes are used and -1 is returned. The runtime shapes of the
+// outputs are left over from the previous run, so only their static shapes
+// are used. The padded rows are within the static capacity of the blobs.
+static int64_t BucketBlobShapes(const ShapeBucketOptions &options, bool bucketable,
+                                const std::vector<const Blob *> &inputs,
+                                const std::vector<const Blob *> &outputs,
+                                std::vector<Shape> *shapes) {
+  shapes->clear();
+  for (const Blob *blob : inputs) { shapes->push_back(blob->static_shape()); }
+  for (const Blob *blob : outputs) { shapes->push_back(blob->static_shape()); }
+  if (options.policy == ShapeBucketPolicy::kStatic || !bucketable) { return -1; }
+
+  int64_t dim = -1;
+  int64_t capacity = GetMaxVal<int64_t>();
+  for (const Blob *blob : inputs) {
+    if (!blob->blob_desc().is_dynamic()) { continue; }
+    const Shape &static_shape = blob->static_shape();
+    const ShapeView &shape = blob->shape();
+    if (shape.NumAxes() == 0 || shape.NumAxes() != static_shape.NumAxes()) { return -1; }
+    for (int i = 1; i < shape.NumAxes(); ++i) {
+      if (shape.At(i) != static_shape.At(i)) { return -1; }
+    }
+    if (dim >= 0 && dim != shape.At(0)) { return -1; }
+    dim = shape.At(0);
+    capacity = std::min(capacity, static_shape.At(0));
+  }
+  if (dim < 0) { return -1; }
+  for (const Blob *blob : outputs) {
+    if (!blob->blob_desc().is_dynamic()) { continue; }
+    if (blob->static_shape().NumAxes() == 0) { return -1; }
+    capacity = std::min(capacity, blob->static_shape().At(0));
+  }
+  if (dim > capacity) { return -1; }
+  const int64_t bucket = BucketDimension(options, dim, capacity);
+  const int64_t num_inputs = inputs.size();
+  for (int i = 0; i < shapes->size(); ++i) {
+    const Blob *blob = i < num_inputs ? inputs[i] : outputs[i - num_inputs];
+    if (blob->blob_desc().is_dynamic()) { (*shapes)[i].Set(0, bucket); }
+  }
+  return dim;
+}
+
+static CompilationCacheOptions MakeCompilationCacheOptions() {
+  CompilationCacheOptions options;
+  options.capacity = FLAGS_xrt_compilation_cache_capacity;
+  options.max_bytes = FLAGS_xrt_compilation_cache_max_bytes;
+  options.persistent_dir = FLAGS_xrt_compilation_cache_dir;
+  return options;
 }
 }  // namespace xrt
 
@@ -50,6 +217,7 @@ void BlobDescGetter<device_type>::DumpEntryBlobDescTo(
   for (const auto &bn : kernel_->op_attribute().input_bns()) {
     const RtBlobDesc &runtime_desc = get_blob_fn_(bn)->blob_desc();
     BlobDesc blob_desc(kernel_->job_desc().DefaultDataType());
+    // The shape is overwritten by the bucketed shape of the entry parameter.
     blob_desc.mut_shape() = runtime_desc.body_shape();
     blob_desc.set_data_type(runtime_desc.data_type());
     blob_desc.set_is_dynamic(runtime_desc.is_dynamic());
@@ -61,45 +229,91 @@ void BlobDescGetter<device_type>::DumpEntryBlobDescTo(
   }
 }
 
+template<DeviceType device_type>
+XrtLaunchKernel<device_type>::~XrtLaunchKernel() {
+  if (!compilation_cache_) { return; }
+  const xrt::CompilationCacheStats stats = compilation_cache_->stats();
+  VLOG(1) << "Compilation cache of launch op " << this->op_conf().name() << ": " << stats.hits
+          << " hits, " << stats.misses << " misses (" << stats.persistent_hits
+          << " restored from disk), " << stats.evictions << " evictions, "
+          << stats.compile_time_us << " us compiling.";
+}
+
+template<DeviceType device_type>
+std::string XrtLaunchKernel<device_type>::ComputePersistentKey(
+    const std::vector<xrt::Parameter> &entry_params) const {
+  const auto &launch_conf = this->op_conf().xrt_launch_conf();
+  std::ostringstream key;
+  key << launch_conf.engine() << ";" << device_type << ";" << FLAGS_tensorrt_fp16 << ";"
+      << FLAGS_tensorrt_int8 << ";" << FLAGS_max_batch_size << ";" << FLAGS_max_workspace_bytes;
+  for (const xrt::Parameter &param : entry_params) {
+    key << ";" << param.name() << ":" << param.shape().ToString() << ":" << param.data_type();
+  }
+  key << ";" << PbMessage2TxtString(launch_conf.function());
+  return key.str();
+}
+
 template<DeviceType device_type>
 xrt::Executable *XrtLaunchKernel<device_type>::BuildExecutable(
+    const KernelCtx &ctx, const xrt::Signature &signature,
     const std::vector<xrt::Parameter> &entry_params,
     const std::vector<xrt::Parameter> &return_params,
-    const std::vector<xrt::InputOutputAlias> &aliases, const int device_ordinal) const {
-  if (!compilation_cache_) { compilation_cache_.reset(new xrt::CompilationCache); }
+    const std::vector<xrt::InputOutputAlias> &aliases, const int device_ordinal,
+    std::string *persistent_key) const {
+  if (!compilation_cache_) {
+    compilation_cache_.reset(new xrt::CompilationCache(xrt::MakeCompilationCacheOptions()));
+  }
 
   xrt::Executable *executable = nullptr;
-  xrt::Signature signature =
-      xrt::ComputeSignature(this->op_conf().name(), device_ordinal, entry_params);
   bool force_compile = false;
   if (!force_compile) { executable = compilation_cache_->GetRecord(signature); }
 
   if (!executable) {
-    VLOG(2) << "Build executable for launch op " << this->op_conf().name();
     const auto &launch_conf = this->op_conf().xrt_launch_conf();
-    auto graph = xrt::BuildXrtGraph(launch_conf.function(), device_type, this->job_desc());
-    {
-      // Run InferShape pass
-      const auto &parallel_ctx = this->kernel_conf().xrt_launch_conf().parallel_ctx();
-      const auto &sbp_signatures = launch_conf.sbp_signatures();
-
-      std::unordered_map<std::string, BlobDesc> entry_blob_descs;
-      desc_getter_.DumpEntryBlobDescTo(&entry_blob_descs);
-      auto options = xrt::CreateDefaultXrtPassOptions();
-      xrt::RunXrtPass("InferShape", graph.get(), options, &this->job_desc(), &parallel_ctx,
-                      &sbp_signatures, &entry_blob_descs);
-      // Update argument meta data
-      // xrt::RunXrtPass("UpdateArgMetaData", graph.get(), options,
-      //                 &this->job_desc());
-    }
     xrt::XrtEngine engine = xrt::StringToXrtEngine(launch_conf.engine());
-    xrt::XrtDevice device = xrt::DeviceTypeToXrtDevice(device_type);
-    xrt::GraphCompiler compiler(this->op_conf().name(), engine, device, device_ordinal);
-    auto result = compiler.Compile(graph.get(), entry_params, return_params, aliases);
-    // Record new compilation result
-    compilation_cache_->Record(signature, result);
-    // Get compilation result from cache
-    executable = compilation_cache_->GetRecord(signature);
+    std::vector<std::shared_ptr<xrt::Executable>> evicted;
+    std::string key;
+    if (compilation_cache_->persistent()) {
+      key = ComputePersistentKey(entry_params);
+      executable = compilation_cache_->LoadPersistentRecord(signature, engine, key, entry_params,
+                                                            &evicted);
+    }
+    if (!executable) {
+      VLOG(2) << "Build executable for launch op " << this->op_conf().name();
+      const auto start = std::chrono::steady_clock::now();
+      auto graph = xrt::BuildXrtGraph(launch_conf.function(), device_type, this->job_desc());
+      {
+        // Run InferShape pass
+        const auto &parallel_ctx = this->kernel_conf().xrt_launch_conf().parallel_ctx();
+        const auto &sbp_signatures = launch_conf.sbp_signatures();
+
+        std::unordered_map<std::string, BlobDesc> entry_blob_descs;
+        desc_getter_.DumpEntryBlobDescTo(&entry_blob_descs);
+        for (const xrt::Parameter &param : entry_params) {
+          entry_blob_descs.at(param.name()).mut_shape() = param.shape();
+        }
+        auto options = xrt::CreateDefaultXrtPassOptions();
+        xrt::RunXrtPass("InferShape", graph.get(), options, &this->job_desc(), &parallel_ctx,
+                        &sbp_signatures, &entry_blob_descs);
+        // Update argument meta data
+        // xrt::RunXrtPass("UpdateArgMetaData", graph.get(), options,
+        //                 &this->job_desc());
+      }
+      xrt::XrtDevice device = xrt::DeviceTypeToXrtDevice(device_type);
+      xrt::GraphCompiler compiler(this->op_conf().name(), engine, device, device_ordinal);
+      auto result = compiler.Compile(graph.get(), entry_params, return_params, aliases);
+      const int64_t compile_time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                          std::chrono::steady_clock::now() - start)
+                                          .count();
+      VLOG(2) << "Compiled launch op " << this->op_conf().name() << " in " << compile_time_us
+              << " us";
+      // Record new compilation result
+      compilation_cache_->Record(signature, result, compile_time_us, &evicted);
+      executable = result.get();
+      *persistent_key = key;
+    }
+    // The evicted executables may still be running on the stream.
+    if (!evicted.empty() && device_type == DeviceType::kGPU) { ctx.device_ctx->SyncDevice(); }
   }
 
   return std::move(executable);
@@ -144,17 +358,36 @@ void XrtLaunchKernel<device_type>::ForwardDataContent(
     const KernelCtx &ctx, std::function<Blob *(const std::string &)> BnInOp2Blob) const {
   desc_getter_ = BlobDescGetter<device_type>(this, BnInOp2Blob);
   // Prepare input and output parameters
+  std::vector<const Blob *> inputs, outputs;
+  for (const std::string &bn : this->op_attribute().input_bns()) {
+    inputs.push_back(BnInOp2Blob(bn));
+  }
+  for (const std::string &bn : this->op_attribute().output_bns()) {
+    outputs.push_back(BnInOp2Blob(bn));
+  }
+  const auto bucket_options = xrt::MakeShapeBucketOptions(FLAGS_xrt_shape_bucket_policy,
+                                                          FLAGS_xrt_shape_bucket_granularity);
+  if (bucket_options.policy != xrt::ShapeBucketPolicy::kStatic && !bucketable_) {
+    bucketable_.reset(new bool(IsBucketable(BnInOp2Blob)));
+  }
+  std::vector<Shape> shapes;
+  const int64_t dim = xrt::BucketBlobShapes(bucket_options, bucketable_ && *bucketable_, inputs,
+                                            outputs, &shapes);
+
   std::vector<xrt::Parameter> entry_params, return_params;
+  int blob_index = 0;
   for (const std::string &bn : this->op_attribute().input_bns()) {
     const LogicalBlobId &lbi = this->BnInOp2Lbi(bn);
     std::string blob_name = xrt::BlobIdToName(lbi);
-    xrt::Parameter input = xrt::BuildParameter(*BnInOp2Blob(bn), blob_name);
+    xrt::Parameter input =
+        xrt::BuildParameter(*BnInOp2Blob(bn), shapes[blob_index++], blob_name);
     entry_params.push_back(input);
   }
   for (const std::string &bn : this->op_attribute().output_bns()) {
     const LogicalBlobId &lbi = this->BnInOp2Lbi(bn);
     std::string blob_name = xrt::BlobIdToName(lbi);
-    xrt::Parameter output = xrt::BuildParameter(*BnInOp2Blob(bn), blob_name);
+    xrt::Parameter output =
+        xrt::BuildParameter(*BnInOp2Blob(bn), shapes[blob_index++], blob_name);
     return_params.push_back(output);
   }
 
@@ -165,7 +398,11 @@ void XrtLaunchKernel<device_type>::ForwardDataContent(
   // Mapping parameter names to function input and output names.
   MappingParamsToFunctionNames(&entry_params, &return_params);
   // Build executable.
-  auto executable = BuildExecutable(entry_params, return_params, aliases, device_ordinal);
+  xrt::Signature signature =
+      xrt::ComputeSignature(this->op_conf().name(), device_ordinal, entry_params);
+  std::string persistent_key;
+  auto executable = BuildExecutable(ctx, signature, entry_params, return_params, aliases,
+                                    device_ordinal, &persistent_key);
   if (!executable) { LOG(FATAL) << "Executable is built failed."; }
   // Run executable.
   xrt::ExecutableRunOptions run_options;
@@ -186,10 +423,47 @@ void XrtLaunchKernel<device_type>::ForwardDataContent(
   }
   bool status = executable->Run(entry_params, run_options, block_until_done);
   CHECK(status) << "Executable is running failed.";
+  // Some engines finish building the executable in its first run. The int8
+  // calibration keeps changing the TensorRT engine, so it is not persisted.
+  if (!persistent_key.empty() && !FLAGS_tensorrt_int8) {
+    compilation_cache_->PersistRecord(signature, persistent_key);
+  }
 
   const std::vector<xrt::Parameter> &results = executable->Results();
   CHECK_EQ(results.size(), return_params.size());
   for (int i = 0; i < results.size(); ++i) { CHECK_EQ(results[i].data(), return_params[i].data()); }
+  // Only the leading `dim` rows of the bucketed outputs are valid.
+  if (dim >= 0) {
+    for (const std::string &bn : this->op_attribute().output_bns()) {
+      Blob *blob = BnInOp2Blob(bn);
+      if (!blob->blob_desc().is_dynamic()) { continue; }
+      Shape shape = blob->static_shape();
+      shape.Set(0, dim);
+      blob->mut_shape_view()->set_shape(shape);
+    }
+  }
+}
+
+template<DeviceType device_type>
+bool XrtLaunchKernel<device_type>::IsBucketable(
+    std::function<Blob *(const std::string &)> BnInOp2Blob) const {
+  const auto &launch_conf = this->op_conf().xrt_launch_conf();
+  const auto &io_mapping = launch_conf.input_output_mapping();
+  xrt::util::Set<std::string> batched;
+  for (const std::string &bn : this->op_attribute().input_bns()) {
+    if (!BnInOp2Blob(bn)->blob_desc().is_dynamic()) { continue; }
+    batched.insert(io_mapping.at(xrt::BlobIdToName(this->BnInOp2Lbi(bn))));
+  }
+  if (batched.empty() || !xrt::IsRowIndependentFunction(launch_conf.function(), &batched)) {
+    return false;
+  }
+  // The dynamic outputs are exactly the batched ones, so that their padded
+  // shapes match the ones inferred from the padded inputs.
+  for (const std::string &bn : this->op_attribute().output_bns()) {
+    const std::string &name = io_mapping.at(xrt::BlobIdToName(this->BnInOp2Lbi(bn)));
+    if (BnInOp2Blob(bn)->blob_desc().is_dynamic() != (batched.count(name) > 0)) { return false; }
+  }
+  return true;
 }
 
 // ADD_DEFAULT_KERNEL_CREATOR(OperatorConf::kXrtLaunchConf, XrtLaunchKernel,
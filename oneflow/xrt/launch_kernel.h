@@ -46,16 +46,22 @@ template<DeviceType device_type>
 class XrtLaunchKernel : public KernelIf<device_type> {
  public:
   XrtLaunchKernel() = default;
-  virtual ~XrtLaunchKernel() {}
+  virtual ~XrtLaunchKernel();
 
  private:
   void ForwardDataContent(const KernelCtx &ctx,
                           std::function<Blob *(const std::string &)> BnInOp2Blob) const override;
 
-  xrt::Executable *BuildExecutable(const std::vector<xrt::Parameter> &entry_params,
+  // Looks up the executable in the compilation cache, or restores it from the
+  // persistent directory, or compiles it. `persistent_key` is set only if the
+  // executable is newly compiled and should be persisted after it runs.
+  xrt::Executable *BuildExecutable(const KernelCtx &ctx, const xrt::Signature &signature,
+                                   const std::vector<xrt::Parameter> &entry_params,
                                    const std::vector<xrt::Parameter> &return_params,
                                    const std::vector<xrt::InputOutputAlias> &aliases,
-                                   const int device_ordinal) const;
+                                   const int device_ordinal, std::string *persistent_key) const;
+
+  std::string ComputePersistentKey(const std::vector<xrt::Parameter> &entry_params) const;
 
   void MakeInputOutputAlias(                            // NOLINT
       const std::vector<xrt::Parameter> &entry_params,  // NOLINT
@@ -65,11 +71,17 @@ class XrtLaunchKernel : public KernelIf<device_type> {
   void MappingParamsToFunctionNames(std::vector<xrt::Parameter> *entry_params,
                                     std::vector<xrt::Parameter> *return_params) const;
 
+  // Returns true if the padded rows of the bucketed dynamic blobs never reach
+  // the valid rows of the outputs.
+  bool IsBucketable(std::function<Blob *(const std::string &)> BnInOp2Blob) const;
+
   bool IsStateless() const override { return false; }
 
  private:
   mutable BlobDescGetter<device_type> desc_getter_;
   mutable std::shared_ptr<xrt::CompilationCache> compilation_cache_;
+  // Checked at the first run with a non-static shape bucket policy.
+  mutable std::unique_ptr<bool> bucketable_;
 };
 
 }  // namespace oneflow
@@ -0,0 +1,484 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/native_builder.h"
+
+#include "glog/logging.h"
+
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+namespace {
+
+constexpr int64_t kTempBufferAlignment = 64;
+
+std::vector<int64_t> ContiguousStrides(const Shape &shape) {
+  std::vector<int64_t> strides(shape.NumAxes(), 1);
+  for (int64_t i = shape.NumAxes() - 2; i >= 0; --i) {
+    strides[i] = strides[i + 1] * shape.At(i + 1);
+  }
+  return strides;
+}
+
+Shape LeftExtendedShape(const Shape &shape, int64_t num_axes) {
+  CHECK_LE(shape.NumAxes(), num_axes);
+  DimVector dim_vec(num_axes - shape.NumAxes(), 1);
+  dim_vec.insert(dim_vec.end(), shape.dim_vec().begin(), shape.dim_vec().end());
+  return Shape(dim_vec);
+}
+
+// Broadcasts `src` into the iteration space `dst`.
+NativeIndexMapping BroadcastMapping(const Shape &src, const Shape &dst) {
+  const Shape extended = LeftExtendedShape(src, dst.NumAxes());
+  NativeIndexMapping mapping;
+  mapping.dst_strides = ContiguousStrides(dst);
+  mapping.src_strides = ContiguousStrides(extended);
+  FOR_RANGE(int64_t, i, 0, dst.NumAxes()) {
+    if (extended.At(i) == 1 && dst.At(i) != 1) {
+      mapping.src_strides[i] = 0;
+    } else {
+      CHECK_EQ(extended.At(i), dst.At(i));
+    }
+  }
+  return mapping;
+}
+
+int64_t AlignedByteSize(int64_t elem_cnt, const DataType &data_type) {
+  const int64_t byte_size = elem_cnt * GetSizeOfDataType(data_type);
+  return RoundUp(byte_size, kTempBufferAlignment);
+}
+
+}  // namespace
+
+NativeValue NativeBuilder::AddNode(Node node) {
+  nodes_.push_back(std::move(node));
+  return NativeValue(nodes_.size() - 1, nodes_.back().shape);
+}
+
+NativeValue NativeBuilder::Parameter(int64_t index, const Shape &shape) {
+  Node node;
+  node.kind = Node::kParameter;
+  node.shape = shape;
+  node.param_index = index;
+  return AddNode(std::move(node));
+}
+
+NativeValue NativeBuilder::Unary(NativeOpCode op, const NativeValue &x, double scalar) {
+  CHECK(op >= NativeOpCode::kIdentity && op <= NativeOpCode::kGelu) << "Not an unary op.";
+  Node node;
+  node.op = op;
+  node.operands = {x.handle()};
+  node.shape = x.shape();
+  node.scalar = scalar;
+  return AddNode(std::move(node));
+}
+
+NativeValue NativeBuilder::Binary(NativeOpCode op, const NativeValue &a, const NativeValue &b) {
+  CHECK(op >= NativeOpCode::kAdd) << "Not a binary op.";
+  const int64_t num_axes = std::max(a.shape().NumAxes(), b.shape().NumAxes());
+  const Shape a_shape = LeftExtendedShape(a.shape(), num_axes);
+  const Shape b_shape = LeftExtendedShape(b.shape(), num_axes);
+  DimVector dim_vec(num_axes);
+  FOR_RANGE(int64_t, i, 0, num_axes) {
+    CHECK(a_shape.At(i) == b_shape.At(i) || a_shape.At(i) == 1 || b_shape.At(i) == 1)
+        << "Shapes " << a.shape().ToString() << " and " << b.shape().ToString()
+        << " could not be broadcast.";
+    dim_vec[i] = std::max(a_shape.At(i), b_shape.At(i));
+  }
+  Node node;
+  node.op = op;
+  node.operands = {a.handle(), b.handle()};
+  node.shape = Shape(dim_vec);
+  return AddNode(std::move(node));
+}
+
+NativeValue NativeBuilder::BinaryScalar(NativeOpCode op, const NativeValue &x, double scalar) {
+  CHECK(op >= NativeOpCode::kAdd) << "Not a binary op.";
+  Node node;
+  node.op = op;
+  node.operands = {x.handle()};
+  node.shape = x.shape();
+  node.has_scalar = true;
+  node.scalar = scalar;
+  return AddNode(std::move(node));
+}
+
+NativeValue NativeBuilder::MatMul(const NativeValue &a, const NativeValue &b, bool transpose_a,
+                                  bool transpose_b) {
+  const Shape &a_shape = a.shape();
+  const Shape &b_shape = b.shape();
+  const int64_t num_axes = a_shape.NumAxes();
+  CHECK_GE(num_axes, 2);
+  CHECK_EQ(num_axes, b_shape.NumAxes());
+  FOR_RANGE(int64_t, i, 0, num_axes - 2) { CHECK_EQ(a_shape.At(i), b_shape.At(i)); }
+  const int64_t m = transpose_a ? a_shape.At(num_axes - 1) : a_shape.At(num_axes - 2);
+  const int64_t k = transpose_a ? a_shape.At(num_axes - 2) : a_shape.At(num_axes - 1);
+  const int64_t n = transpose_b ? b_shape.At(num_axes - 2) : b_shape.At(num_axes - 1);
+  CHECK_EQ(k, transpose_b ? b_shape.At(num_axes - 1) : b_shape.At(num_axes - 2));
+  DimVector dim_vec(a_shape.dim_vec().begin(), a_shape.dim_vec().end() - 2);
+  dim_vec.push_back(m);
+  dim_vec.push_back(n);
+  Node node;
+  node.kind = Node::kMatMul;
+  node.operands = {a.handle(), b.handle()};
+  node.shape = Shape(dim_vec);
+  node.transpose_a = transpose_a;
+  node.transpose_b = transpose_b;
+  return AddNode(std::move(node));
+}
+
+NativeValue NativeBuilder::Reduce(const NativeValue &x, const std::vector<int32_t> &axis,
+                                  bool mean) {
+  DimVector dim_vec = x.shape().dim_vec();
+  for (int32_t i : axis) {
+    CHECK_GE(i, 0);
+    CHECK_LT(i, dim_vec.size());
+    dim_vec[i] = 1;
+  }
+  Node node;
+  node.kind = Node::kReduce;
+  node.operands = {x.handle()};
+  node.shape = Shape(dim_vec);
+  if (mean && x.shape().elem_cnt() > 0) {
+    node.reduce_scale = static_cast<double>(node.shape.elem_cnt()) / x.shape().elem_cnt();
+  }
+  return AddNode(std::move(node));
+}
+
+NativeValue NativeBuilder::ReduceSum(const NativeValue &x, const std::vector<int32_t> &axis) {
+  return Reduce(x, axis, false);
+}
+
+NativeValue NativeBuilder::ReduceMean(const NativeValue &x, const std::vector<int32_t> &axis) {
+  return Reduce(x, axis, true);
+}
+
+NativeValue NativeBuilder::Reshape(const NativeValue &x, const Shape &shape) {
+  CHECK_EQ(x.shape().elem_cnt(), shape.elem_cnt());
+  Node node;
+  node.kind = Node::kReshape;
+  node.operands = {x.handle()};
+  node.shape = shape;
+  return AddNode(std::move(node));
+}
+
+class NativeProgramLowering {
+ public:
+  using Node = NativeBuilder::Node;
+
+  explicit NativeProgramLowering(const NativeBuilder &builder)
+      : data_type_(builder.data_type()), nodes_(builder.nodes_) {}
+
+  NativeProgram Lower(const std::vector<NativeValue> &returns);
+
+ private:
+  int64_t Strip(int64_t handle) const {
+    while (nodes_[handle].kind == Node::kReshape) { handle = nodes_[handle].operands.front(); }
+    return handle;
+  }
+
+  void MarkLiveNodes(const std::vector<NativeValue> &returns);
+  void AnalyzeUses(const std::vector<NativeValue> &returns);
+  NativeBuffer NewTempBuffer(int64_t elem_cnt);
+
+  int32_t EmitNode(int64_t handle, NativeStage *stage);
+  int32_t EmitOperand(int64_t handle, const Shape &iteration_shape, NativeStage *stage);
+  void AddLoopStage(int64_t handle, NativeProgram *program);
+  void AddMatMulStage(int64_t handle, NativeProgram *program);
+
+  void AllocateTempBuffers(NativeProgram *program);
+
+  DataType data_type_;
+  const std::vector<Node> &nodes_;
+
+  std::vector<bool> live_;
+  std::vector<int64_t> use_cnt_;
+  std::vector<bool> need_buffer_;
+  std::vector<bool> materialized_;
+  std::vector<bool> has_buffer_;
+  std::vector<NativeBuffer> buffers_;
+  int64_t current_stage_ = 0;
+
+  // Indexed by temp buffer id.
+  std::vector<int64_t> temp_byte_sizes_;
+  std::vector<int64_t> temp_def_stages_;
+  std::vector<int64_t> temp_last_use_stages_;
+};
+
+void NativeProgramLowering::MarkLiveNodes(const std::vector<NativeValue> &returns) {
+  live_.assign(nodes_.size(), false);
+  std::vector<int64_t> stack;
+  for (const NativeValue &value : returns) { stack.push_back(value.handle()); }
+  while (!stack.empty()) {
+    const int64_t handle = stack.back();
+    stack.pop_back();
+    if (live_[handle]) { continue; }
+    live_[handle] = true;
+    for (int64_t operand : nodes_[handle].operands) { stack.push_back(operand); }
+  }
+}
+
+void NativeProgramLowering::AnalyzeUses(const std::vector<NativeValue> &returns) {
+  use_cnt_.assign(nodes_.size(), 0);
+  need_buffer_.assign(nodes_.size(), false);
+  FOR_RANGE(int64_t, handle, 0, nodes_.size()) {
+    const Node &node = nodes_[handle];
+    if (!live_[handle] || node.kind == Node::kReshape) { continue; }
+    for (int64_t operand : node.operands) {
+      const int64_t producer = Strip(operand);
+      ++use_cnt_[producer];
+      if (node.kind == Node::kMatMul) { need_buffer_[producer] = true; }
+      // Operands which are broadcast are loaded from memory.
+      if (node.kind == Node::kElementwise
+          && nodes_[operand].shape.elem_cnt() != node.shape.elem_cnt()) {
+        need_buffer_[producer] = true;
+      }
+    }
+  }
+  for (const NativeValue &value : returns) {
+    const int64_t producer = Strip(value.handle());
+    ++use_cnt_[producer];
+    need_buffer_[producer] = true;
+  }
+  materialized_.assign(nodes_.size(), false);
+  FOR_RANGE(int64_t, handle, 0, nodes_.size()) {
+    const Node &node = nodes_[handle];
+    if (!live_[handle] || node.kind == Node::kReshape) { continue; }
+    materialized_[handle] =
+        node.kind != Node::kElementwise || need_buffer_[handle] || use_cnt_[handle] > 1;
+  }
+}
+
+NativeBuffer NativeProgramLowering::NewTempBuffer(int64_t elem_cnt) {
+  NativeBuffer buffer;
+  buffer.kind = NativeBuffer::kTemp;
+  buffer.index = temp_byte_sizes_.size();
+  temp_byte_sizes_.push_back(AlignedByteSize(elem_cnt, data_type_));
+  temp_def_stages_.push_back(-1);
+  temp_last_use_stages_.push_back(-1);
+  return buffer;
+}
+
+int32_t NativeProgramLowering::EmitNode(int64_t handle, NativeStage *stage) {
+  const Node &node = nodes_[handle];
+  CHECK_EQ(node.kind, Node::kElementwise);
+  NativeInstr instr;
+  instr.op = node.op;
+  instr.scalar = node.scalar;
+  instr.lhs = EmitOperand(node.operands.at(0), node.shape, stage);
+  if (node.operands.size() > 1) { instr.rhs = EmitOperand(node.operands.at(1), node.shape, stage); }
+  stage->instrs.push_back(instr);
+  return stage->instrs.size() - 1;
+}
+
+int32_t NativeProgramLowering::EmitOperand(int64_t handle, const Shape &iteration_shape,
+                                           NativeStage *stage) {
+  const int64_t producer = Strip(handle);
+  const Shape &shape = nodes_[handle].shape;
+  if (!materialized_[producer]) {
+    // Inline the sole consumed elementwise producer.
+    CHECK_EQ(shape.elem_cnt(), iteration_shape.elem_cnt());
+    return EmitNode(producer, stage);
+  }
+  CHECK(has_buffer_[producer]);
+  NativeLoad load;
+  load.buffer = buffers_[producer];
+  load.contiguous = shape.elem_cnt() == iteration_shape.elem_cnt();
+  if (!load.contiguous) { load.mapping = BroadcastMapping(shape, iteration_shape); }
+  if (load.buffer.kind == NativeBuffer::kTemp) {
+    temp_last_use_stages_[load.buffer.index] = current_stage_;
+  }
+  stage->loads.push_back(load);
+  NativeInstr instr;
+  instr.op = NativeOpCode::kLoad;
+  instr.load = stage->loads.size() - 1;
+  stage->instrs.push_back(instr);
+  return stage->instrs.size() - 1;
+}
+
+void NativeProgramLowering::AddLoopStage(int64_t handle, NativeProgram *program) {
+  const Node &node = nodes_[handle];
+  NativeStage stage;
+  stage.kind = NativeStage::kLoop;
+  stage.out = buffers_[handle];
+  current_stage_ = program->stages.size();
+  if (node.kind == Node::kReduce) {
+    const int64_t operand = node.operands.front();
+    const Shape &iteration_shape = nodes_[operand].shape;
+    stage.elem_cnt = iteration_shape.elem_cnt();
+    EmitOperand(operand, iteration_shape, &stage);
+    stage.reduce = true;
+    stage.reduce_mapping = BroadcastMapping(node.shape, iteration_shape);
+    stage.reduce_out_elem_cnt = node.shape.elem_cnt();
+    stage.reduce_scale = node.reduce_scale;
+  } else {
+    stage.elem_cnt = node.shape.elem_cnt();
+    EmitNode(handle, &stage);
+  }
+  program->stages.push_back(std::move(stage));
+}
+
+void NativeProgramLowering::AddMatMulStage(int64_t handle, NativeProgram *program) {
+  const Node &node = nodes_[handle];
+  const Shape &a_shape = nodes_[node.operands.at(0)].shape;
+  const int64_t num_axes = a_shape.NumAxes();
+  NativeStage stage;
+  stage.kind = NativeStage::kMatMul;
+  stage.out = buffers_[handle];
+  stage.a = buffers_[Strip(node.operands.at(0))];
+  stage.b = buffers_[Strip(node.operands.at(1))];
+  stage.batch_size = a_shape.Count(0, num_axes - 2);
+  stage.m = node.shape.At(num_axes - 2);
+  stage.n = node.shape.At(num_axes - 1);
+  stage.k = node.transpose_a ? a_shape.At(num_axes - 2) : a_shape.At(num_axes - 1);
+  stage.transpose_a = node.transpose_a;
+  stage.transpose_b = node.transpose_b;
+  for (const NativeBuffer *buffer : {&stage.a, &stage.b}) {
+    if (buffer->kind == NativeBuffer::kTemp) {
+      temp_last_use_stages_[buffer->index] = program->stages.size();
+    }
+  }
+  program->stages.push_back(std::move(stage));
+}
+
+void NativeProgramLowering::AllocateTempBuffers(NativeProgram *program) {
+  // Greedy slot assignment in stage order, a slot is reused once the live range
+  // of its previous value ends. Slots grow to fit the largest value they hold.
+  std::vector<int64_t> slot_sizes;
+  std::vector<bool> slot_free;
+  std::vector<int64_t> temp2slot(temp_byte_sizes_.size(), -1);
+  std::vector<std::vector<int64_t>> stage2defs(program->stages.size());
+  std::vector<std::vector<int64_t>> stage2frees(program->stages.size());
+  FOR_RANGE(int64_t, temp, 0, temp_byte_sizes_.size()) {
+    stage2defs.at(temp_def_stages_[temp]).push_back(temp);
+    const int64_t last_use = std::max(temp_last_use_stages_[temp], temp_def_stages_[temp]);
+    stage2frees.at(last_use).push_back(temp);
+  }
+  FOR_RANGE(int64_t, stage, 0, program->stages.size()) {
+    for (int64_t temp : stage2defs[stage]) {
+      const int64_t byte_size = temp_byte_sizes_[temp];
+      int64_t best = -1;
+      FOR_RANGE(int64_t, slot, 0, slot_sizes.size()) {
+        if (!slot_free[slot]) { continue; }
+        if (best == -1) {
+          best = slot;
+        } else if (slot_sizes[best] < byte_size) {
+          // Prefer the largest slot if none fits.
+          if (slot_sizes[slot] > slot_sizes[best]) { best = slot; }
+        } else if (slot_sizes[slot] >= byte_size && slot_sizes[slot] < slot_sizes[best]) {
+          // Otherwise prefer the smallest one which fits.
+          best = slot;
+        }
+      }
+      if (best == -1) {
+        best = slot_sizes.size();
+        slot_sizes.push_back(0);
+        slot_free.push_back(true);
+      }
+      slot_sizes[best] = std::max(slot_sizes[best], byte_size);
+      slot_free[best] = false;
+      temp2slot[temp] = best;
+    }
+    for (int64_t temp : stage2frees[stage]) { slot_free[temp2slot[temp]] = true; }
+  }
+  std::vector<int64_t> slot_offsets(slot_sizes.size(), 0);
+  int64_t offset = 0;
+  FOR_RANGE(int64_t, slot, 0, slot_sizes.size()) {
+    slot_offsets[slot] = offset;
+    offset += slot_sizes[slot];
+  }
+  program->temp_byte_size = offset;
+  auto ResolveOffset = [&](NativeBuffer *buffer) {
+    if (buffer->kind == NativeBuffer::kTemp && buffer->index >= 0) {
+      buffer->index = slot_offsets[temp2slot[buffer->index]];
+    }
+  };
+  for (NativeStage &stage : program->stages) {
+    for (NativeBuffer *buffer : {&stage.out, &stage.a, &stage.b, &stage.src}) {
+      ResolveOffset(buffer);
+    }
+    for (NativeLoad &load : stage.loads) { ResolveOffset(&load.buffer); }
+  }
+}
+
+NativeProgram NativeProgramLowering::Lower(const std::vector<NativeValue> &returns) {
+  MarkLiveNodes(returns);
+  AnalyzeUses(returns);
+  has_buffer_.assign(nodes_.size(), false);
+  buffers_.assign(nodes_.size(), NativeBuffer());
+  FOR_RANGE(int64_t, handle, 0, nodes_.size()) {
+    if (live_[handle] && nodes_[handle].kind == Node::kParameter) {
+      buffers_[handle].kind = NativeBuffer::kEntry;
+      buffers_[handle].index = nodes_[handle].param_index;
+      has_buffer_[handle] = true;
+    }
+  }
+  // Write the returned values into the return parameters directly, the others
+  // (parameters and values returned more than once) are copied at the end.
+  std::vector<std::pair<int64_t, int64_t>> copies;
+  FOR_RANGE(int64_t, i, 0, returns.size()) {
+    const int64_t producer = Strip(returns[i].handle());
+    if (has_buffer_[producer]) {
+      copies.emplace_back(i, producer);
+    } else {
+      buffers_[producer].kind = NativeBuffer::kReturn;
+      buffers_[producer].index = i;
+      has_buffer_[producer] = true;
+    }
+  }
+
+  NativeProgram program;
+  program.data_type = data_type_;
+  FOR_RANGE(int64_t, handle, 0, nodes_.size()) {
+    const Node &node = nodes_[handle];
+    if (!materialized_[handle] || node.kind == Node::kParameter) { continue; }
+    if (!has_buffer_[handle]) {
+      buffers_[handle] = NewTempBuffer(node.shape.elem_cnt());
+      has_buffer_[handle] = true;
+      temp_def_stages_[buffers_[handle].index] = program.stages.size();
+    }
+    if (node.kind == Node::kMatMul) {
+      AddMatMulStage(handle, &program);
+    } else {
+      AddLoopStage(handle, &program);
+    }
+  }
+  for (const auto &pair : copies) {
+    NativeStage stage;
+    stage.kind = NativeStage::kCopy;
+    stage.out.kind = NativeBuffer::kReturn;
+    stage.out.index = pair.first;
+    stage.src = buffers_[pair.second];
+    stage.byte_size = nodes_[pair.second].shape.elem_cnt() * GetSizeOfDataType(data_type_);
+    if (stage.src.kind == NativeBuffer::kTemp) {
+      temp_last_use_stages_[stage.src.index] = program.stages.size();
+    }
+    program.stages.push_back(std::move(stage));
+  }
+  AllocateTempBuffers(&program);
+  return program;
+}
+
+NativeProgram NativeBuilder::Build(const std::vector<NativeValue> &returns) const {
+  return NativeProgramLowering(*this).Lower(returns);
+}
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
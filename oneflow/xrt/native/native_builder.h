@@ -0,0 +1,105 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_NATIVE_NATIVE_BUILDER_H_
+#define ONEFLOW_XRT_NATIVE_NATIVE_BUILDER_H_
+
+#include <string>
+#include <vector>
+
+#include "oneflow/core/common/shape.h"
+#include "oneflow/xrt/native/native_program.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+class NativeValue {
+ public:
+  NativeValue() = default;
+  NativeValue(int64_t handle, const Shape &shape) : handle_(handle), shape_(shape) {}
+
+  int64_t handle() const { return handle_; }
+  const Shape &shape() const { return shape_; }
+  bool initialized() const { return handle_ >= 0; }
+
+ private:
+  int64_t handle_ = -1;
+  Shape shape_;
+};
+
+// Records the operations of a cluster and lowers them to a `NativeProgram`.
+// Elementwise operations are not materialized by default, they are inlined into
+// the loop of their consumer if they have a sole consumer which iterates over the
+// same elements. Reductions accumulate straight from the loop of their input.
+class NativeBuilder {
+ public:
+  NativeBuilder(const std::string &name, const DataType &data_type)
+      : name_(name), data_type_(data_type) {}
+
+  const std::string &name() const { return name_; }
+  const DataType &data_type() const { return data_type_; }
+
+  NativeValue Parameter(int64_t index, const Shape &shape);
+
+  NativeValue Unary(NativeOpCode op, const NativeValue &x, double scalar = 0);
+  // Numpy style broadcasting binary operation.
+  NativeValue Binary(NativeOpCode op, const NativeValue &a, const NativeValue &b);
+  NativeValue BinaryScalar(NativeOpCode op, const NativeValue &x, double scalar);
+
+  // Batched if the operands have more than 2 axes.
+  NativeValue MatMul(const NativeValue &a, const NativeValue &b, bool transpose_a,
+                     bool transpose_b);
+  // `axis` should be sorted and non-negative. The output keeps the reduced
+  // axes as 1 and could be reshaped by the caller.
+  NativeValue ReduceSum(const NativeValue &x, const std::vector<int32_t> &axis);
+  NativeValue ReduceMean(const NativeValue &x, const std::vector<int32_t> &axis);
+
+  NativeValue Reshape(const NativeValue &x, const Shape &shape);
+
+  // Lowers the operations which the `returns` depend on, the i-th return value
+  // is written into the i-th return parameter.
+  NativeProgram Build(const std::vector<NativeValue> &returns) const;
+
+ private:
+  struct Node {
+    enum Kind { kParameter = 0, kElementwise, kMatMul, kReduce, kReshape };
+    Kind kind = kElementwise;
+    NativeOpCode op = NativeOpCode::kIdentity;
+    std::vector<int64_t> operands;
+    Shape shape;
+    bool has_scalar = false;
+    double scalar = 0;
+    int64_t param_index = -1;
+    bool transpose_a = false;
+    bool transpose_b = false;
+    double reduce_scale = 1.0;
+  };
+
+  NativeValue AddNode(Node node);
+  NativeValue Reduce(const NativeValue &x, const std::vector<int32_t> &axis, bool mean);
+
+  std::string name_;
+  DataType data_type_;
+  std::vector<Node> nodes_;
+
+  friend class NativeProgramLowering;
+};
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_NATIVE_NATIVE_BUILDER_H_
@@ -0,0 +1,141 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/native_builder.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+TEST(NativeBuilder, inline_elementwise_chain) {
+  NativeBuilder builder("test", DataType::kFloat);
+  NativeValue x = builder.Parameter(0, Shape({4, 8}));
+  NativeValue y = builder.Parameter(1, Shape({4, 8}));
+  NativeValue sum = builder.Binary(NativeOpCode::kAdd, x, y);
+  NativeValue scaled = builder.BinaryScalar(NativeOpCode::kMul, sum, 0.5);
+  NativeValue out = builder.Unary(NativeOpCode::kRelu, scaled);
+  const NativeProgram program = builder.Build({out});
+
+  // the whole chain is a single loop writing the return parameter
+  ASSERT_EQ(program.stages.size(), 1);
+  const NativeStage &stage = program.stages.front();
+  ASSERT_EQ(stage.kind, NativeStage::kLoop);
+  ASSERT_EQ(stage.elem_cnt, 32);
+  ASSERT_FALSE(stage.reduce);
+  ASSERT_EQ(stage.out.kind, NativeBuffer::kReturn);
+  ASSERT_EQ(stage.out.index, 0);
+  ASSERT_EQ(stage.loads.size(), 2);
+  for (const NativeLoad &load : stage.loads) {
+    ASSERT_TRUE(load.contiguous);
+    ASSERT_EQ(load.buffer.kind, NativeBuffer::kEntry);
+  }
+  // load x, load y, add, mul, relu
+  ASSERT_EQ(stage.instrs.size(), 5);
+  ASSERT_EQ(stage.instrs.back().op, NativeOpCode::kRelu);
+  ASSERT_EQ(program.temp_byte_size, 0);
+}
+
+TEST(NativeBuilder, materialize_shared_values) {
+  NativeBuilder builder("test", DataType::kFloat);
+  NativeValue x = builder.Parameter(0, Shape({16}));
+  NativeValue t = builder.Unary(NativeOpCode::kTanh, x);
+  // `t` has two consumers, so it is computed once into a temp buffer
+  NativeValue out = builder.Binary(NativeOpCode::kMul, t, t);
+  const NativeProgram program = builder.Build({out});
+  ASSERT_EQ(program.stages.size(), 2);
+  ASSERT_EQ(program.stages[0].out.kind, NativeBuffer::kTemp);
+  ASSERT_EQ(program.stages[1].out.kind, NativeBuffer::kReturn);
+  ASSERT_EQ(program.stages[1].loads.size(), 2);
+  ASSERT_EQ(program.temp_byte_size, 64);
+}
+
+TEST(NativeBuilder, reuse_temp_buffers) {
+  NativeBuilder builder("test", DataType::kFloat);
+  NativeValue x = builder.Parameter(0, Shape({4, 16}));
+  NativeValue w = builder.Parameter(1, Shape({16, 16}));
+  NativeValue h = x;
+  FOR_RANGE(int, i, 0, 4) { h = builder.MatMul(h, w, false, false); }
+  const NativeProgram program = builder.Build({h});
+
+  ASSERT_EQ(program.stages.size(), 4);
+  for (const NativeStage &stage : program.stages) { ASSERT_EQ(stage.kind, NativeStage::kMatMul); }
+  // three 256 bytes temporaries, but at most two of them are alive at a time
+  ASSERT_EQ(program.temp_byte_size, 2 * 256);
+  ASSERT_EQ(program.stages[0].out.index, program.stages[2].out.index);
+  ASSERT_NE(program.stages[0].out.index, program.stages[1].out.index);
+  ASSERT_EQ(program.stages[3].out.kind, NativeBuffer::kReturn);
+}
+
+TEST(NativeBuilder, broadcast_mapping) {
+  NativeBuilder builder("test", DataType::kFloat);
+  NativeValue x = builder.Parameter(0, Shape({2, 3}));
+  NativeValue b = builder.Parameter(1, Shape({3}));
+  NativeValue out = builder.Binary(NativeOpCode::kAdd, x, b);
+  ASSERT_EQ(out.shape(), Shape({2, 3}));
+  const NativeProgram program = builder.Build({out});
+
+  ASSERT_EQ(program.stages.size(), 1);
+  const NativeStage &stage = program.stages.front();
+  ASSERT_EQ(stage.loads.size(), 2);
+  ASSERT_TRUE(stage.loads[0].contiguous);
+  const NativeLoad &bias = stage.loads[1];
+  ASSERT_FALSE(bias.contiguous);
+  ASSERT_EQ(bias.mapping.dst_strides, std::vector<int64_t>({3, 1}));
+  ASSERT_EQ(bias.mapping.src_strides, std::vector<int64_t>({0, 1}));
+}
+
+TEST(NativeBuilder, reduce_mapping) {
+  NativeBuilder builder("test", DataType::kFloat);
+  NativeValue x = builder.Parameter(0, Shape({2, 3, 4}));
+  NativeValue y = builder.Unary(NativeOpCode::kSigmoid, x);
+  NativeValue mean = builder.ReduceMean(y, {1});
+  ASSERT_EQ(mean.shape(), Shape({2, 1, 4}));
+  const NativeProgram program = builder.Build({builder.Reshape(mean, Shape({2, 4}))});
+
+  // the sigmoid is accumulated straight into the output
+  ASSERT_EQ(program.stages.size(), 1);
+  const NativeStage &stage = program.stages.front();
+  ASSERT_TRUE(stage.reduce);
+  ASSERT_EQ(stage.elem_cnt, 24);
+  ASSERT_EQ(stage.reduce_out_elem_cnt, 8);
+  ASSERT_DOUBLE_EQ(stage.reduce_scale, 1.0 / 3);
+  ASSERT_EQ(stage.reduce_mapping.dst_strides, std::vector<int64_t>({12, 4, 1}));
+  ASSERT_EQ(stage.reduce_mapping.src_strides, std::vector<int64_t>({4, 0, 1}));
+  ASSERT_EQ(stage.instrs.back().op, NativeOpCode::kSigmoid);
+}
+
+TEST(NativeBuilder, copy_parameters_and_duplicated_returns) {
+  NativeBuilder builder("test", DataType::kDouble);
+  NativeValue x = builder.Parameter(0, Shape({5}));
+  NativeValue y = builder.Unary(NativeOpCode::kGelu, x);
+  const NativeProgram program = builder.Build({y, x, y});
+
+  ASSERT_EQ(program.data_type, DataType::kDouble);
+  ASSERT_EQ(program.stages.size(), 3);
+  ASSERT_EQ(program.stages[0].out.kind, NativeBuffer::kReturn);
+  ASSERT_EQ(program.stages[0].out.index, 0);
+  FOR_RANGE(int, i, 1, 3) {
+    const NativeStage &copy = program.stages[i];
+    ASSERT_EQ(copy.kind, NativeStage::kCopy);
+    ASSERT_EQ(copy.out.index, i);
+    ASSERT_EQ(copy.byte_size, 5 * sizeof(double));
+  }
+  ASSERT_EQ(program.stages[1].src.kind, NativeBuffer::kEntry);
+  ASSERT_EQ(program.stages[2].src.kind, NativeBuffer::kReturn);
+}
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
@@ -0,0 +1,232 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/native_executable.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "glog/logging.h"
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/kernel/util/host_blas_interface.h"
+#include "oneflow/xrt/compilation_cache.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+namespace {
+
+// Number of elements evaluated by each instruction at a time. The blocks of all
+// the instructions of a loop stay in the L1 cache.
+constexpr int64_t kBlockSize = 256;
+constexpr int64_t kTempStorageAlignment = 64;
+
+struct BufferResolver {
+  const std::vector<Parameter> *inputs;
+  const std::vector<Parameter> *results;
+  char *temp;
+
+  char *Resolve(const NativeBuffer &buffer) const {
+    switch (buffer.kind) {
+      case NativeBuffer::kEntry: return reinterpret_cast<char *>(inputs->at(buffer.index).data());
+      case NativeBuffer::kReturn:
+        return reinterpret_cast<char *>(results->at(buffer.index).data());
+      default: return temp + buffer.index;
+    }
+  }
+};
+
+inline int64_t MapOffset(const NativeIndexMapping &mapping, int64_t index) {
+  int64_t offset = 0;
+  FOR_RANGE(size_t, i, 0, mapping.dst_strides.size()) {
+    const int64_t idx = index / mapping.dst_strides[i];
+    index -= idx * mapping.dst_strides[i];
+    offset += idx * mapping.src_strides[i];
+  }
+  return offset;
+}
+
+template<typename T>
+void RunUnary(NativeOpCode op, const T *x, T alpha, int64_t n, T *y) {
+  switch (op) {
+    case NativeOpCode::kIdentity: std::copy(x, x + n, y); break;
+    case NativeOpCode::kRelu:
+      FOR_RANGE(int64_t, i, 0, n) { y[i] = x[i] > 0 ? x[i] : static_cast<T>(0); }
+      break;
+    case NativeOpCode::kLeakyRelu:
+      FOR_RANGE(int64_t, i, 0, n) { y[i] = x[i] > 0 ? x[i] : alpha * x[i]; }
+      break;
+    case NativeOpCode::kSigmoid:
+      FOR_RANGE(int64_t, i, 0, n) { y[i] = 1 / (1 + std::exp(-x[i])); }
+      break;
+    case NativeOpCode::kTanh:
+      FOR_RANGE(int64_t, i, 0, n) { y[i] = std::tanh(x[i]); }
+      break;
+    case NativeOpCode::kGelu:
+      FOR_RANGE(int64_t, i, 0, n) {
+        y[i] = static_cast<T>(0.5) * x[i] * (1 + std::erf(x[i] * static_cast<T>(M_SQRT1_2)));
+      }
+      break;
+    default: LOG(FATAL) << "Unsupported unary op " << static_cast<int32_t>(op);
+  }
+}
+
+template<typename T, typename BinaryFunc>
+void RunBinary(const T *x, const T *y, T scalar, int64_t n, T *z, BinaryFunc func) {
+  if (y) {
+    FOR_RANGE(int64_t, i, 0, n) { z[i] = func(x[i], y[i]); }
+  } else {
+    FOR_RANGE(int64_t, i, 0, n) { z[i] = func(x[i], scalar); }
+  }
+}
+
+template<typename T>
+void RunBinary(NativeOpCode op, const T *x, const T *y, T scalar, int64_t n, T *z) {
+  switch (op) {
+    case NativeOpCode::kAdd: RunBinary(x, y, scalar, n, z, [](T a, T b) { return a + b; }); break;
+    case NativeOpCode::kSub: RunBinary(x, y, scalar, n, z, [](T a, T b) { return a - b; }); break;
+    case NativeOpCode::kMul: RunBinary(x, y, scalar, n, z, [](T a, T b) { return a * b; }); break;
+    case NativeOpCode::kDiv: RunBinary(x, y, scalar, n, z, [](T a, T b) { return a / b; }); break;
+    default: LOG(FATAL) << "Unsupported binary op " << static_cast<int32_t>(op);
+  }
+}
+
+template<typename T>
+void RunLoopStage(const NativeStage &stage, const BufferResolver &resolver) {
+  const int64_t num_instrs = stage.instrs.size();
+  CHECK_GT(num_instrs, 0);
+  std::vector<T> blocks(num_instrs * kBlockSize);
+  // Contiguous loads are read in place, the others are gathered into blocks.
+  std::vector<const T *> values(num_instrs);
+  std::vector<const T *> loads(stage.loads.size());
+  FOR_RANGE(size_t, i, 0, stage.loads.size()) {
+    loads[i] = reinterpret_cast<const T *>(resolver.Resolve(stage.loads[i].buffer));
+  }
+  T *out = reinterpret_cast<T *>(resolver.Resolve(stage.out));
+  if (stage.reduce) { std::fill(out, out + stage.reduce_out_elem_cnt, static_cast<T>(0)); }
+
+  for (int64_t start = 0; start < stage.elem_cnt; start += kBlockSize) {
+    const int64_t n = std::min(kBlockSize, stage.elem_cnt - start);
+    FOR_RANGE(int64_t, k, 0, num_instrs) {
+      const NativeInstr &instr = stage.instrs[k];
+      T *block = blocks.data() + k * kBlockSize;
+      values[k] = block;
+      if (instr.op == NativeOpCode::kLoad) {
+        const NativeLoad &load = stage.loads[instr.load];
+        const T *src = loads[instr.load];
+        if (load.contiguous) {
+          values[k] = src + start;
+        } else {
+          FOR_RANGE(int64_t, i, 0, n) { block[i] = src[MapOffset(load.mapping, start + i)]; }
+        }
+      } else if (instr.op < NativeOpCode::kAdd) {
+        RunUnary<T>(instr.op, values[instr.lhs], static_cast<T>(instr.scalar), n, block);
+      } else {
+        const T *rhs = instr.rhs >= 0 ? values[instr.rhs] : nullptr;
+        RunBinary<T>(instr.op, values[instr.lhs], rhs, static_cast<T>(instr.scalar), n, block);
+      }
+    }
+    const T *result = values[num_instrs - 1];
+    if (stage.reduce) {
+      FOR_RANGE(int64_t, i, 0, n) { out[MapOffset(stage.reduce_mapping, start + i)] += result[i]; }
+    } else {
+      std::copy(result, result + n, out + start);
+    }
+  }
+  if (stage.reduce && stage.reduce_scale != 1.0) {
+    const T scale = static_cast<T>(stage.reduce_scale);
+    FOR_RANGE(int64_t, i, 0, stage.reduce_out_elem_cnt) { out[i] *= scale; }
+  }
+}
+
+template<typename T>
+void RunMatMulStage(const NativeStage &stage, const BufferResolver &resolver) {
+  const T *a = reinterpret_cast<const T *>(resolver.Resolve(stage.a));
+  const T *b = reinterpret_cast<const T *>(resolver.Resolve(stage.b));
+  T *c = reinterpret_cast<T *>(resolver.Resolve(stage.out));
+  const enum CBLAS_TRANSPOSE trans_a = stage.transpose_a ? CblasTrans : CblasNoTrans;
+  const enum CBLAS_TRANSPOSE trans_b = stage.transpose_b ? CblasTrans : CblasNoTrans;
+  FOR_RANGE(int64_t, i, 0, stage.batch_size) {
+    BlasIf<DeviceType::kCPU>::OFGemm(nullptr, trans_a, trans_b, stage.m, stage.n, stage.k,
+                                     static_cast<T>(1), a + i * stage.m * stage.k,
+                                     b + i * stage.k * stage.n, static_cast<T>(0),
+                                     c + i * stage.m * stage.n);
+  }
+}
+
+template<typename T>
+void RunProgram(const NativeProgram &program, const BufferResolver &resolver) {
+  for (const NativeStage &stage : program.stages) {
+    switch (stage.kind) {
+      case NativeStage::kLoop: RunLoopStage<T>(stage, resolver); break;
+      case NativeStage::kMatMul: RunMatMulStage<T>(stage, resolver); break;
+      case NativeStage::kCopy:
+        std::memcpy(resolver.Resolve(stage.out), resolver.Resolve(stage.src), stage.byte_size);
+        break;
+      default: LOG(FATAL) << "Unknown stage kind " << stage.kind;
+    }
+  }
+}
+
+}  // namespace
+
+bool NativeExecutable::Run(const std::vector<Parameter> &inputs,
+                           const ExecutableRunOptions &run_options, bool block_until_done) {
+  this->results_ = run_options.return_params;
+  const int64_t temp_storage_size = program_.temp_byte_size + kTempStorageAlignment;
+  if (temp_storage_.size() < temp_storage_size) { temp_storage_.resize(temp_storage_size); }
+  const uintptr_t temp_addr = reinterpret_cast<uintptr_t>(temp_storage_.data());
+  BufferResolver resolver;
+  resolver.inputs = &inputs;
+  resolver.results = &this->results_;
+  resolver.temp = reinterpret_cast<char *>(RoundUp(temp_addr, kTempStorageAlignment));
+  switch (program_.data_type) {
+    case DataType::kFloat: RunProgram<float>(program_, resolver); break;
+    case DataType::kDouble: RunProgram<double>(program_, resolver); break;
+    default: LOG(FATAL) << "Native engine does not support data type " << program_.data_type;
+  }
+  // Computation is done on the calling thread, so it is always blocking.
+  return true;
+}
+
+int64_t NativeExecutable::FootprintBytes() const {
+  int64_t footprint_bytes = program_.temp_byte_size;
+  for (const NativeStage &stage : program_.stages) {
+    footprint_bytes += sizeof(NativeStage) + stage.instrs.size() * sizeof(NativeInstr)
+                       + stage.loads.size() * sizeof(NativeLoad);
+  }
+  return footprint_bytes;
+}
+
+bool NativeExecutable::SerializeToString(std::string *serialized) const {
+  SerializeNativeProgram(program_, serialized);
+  return true;
+}
+
+std::shared_ptr<Executable> LoadNativeExecutable(const std::string &name,
+                                                 const std::string &serialized,
+                                                 const std::vector<Parameter> &entry_params) {
+  NativeProgram program;
+  if (!DeserializeNativeProgram(serialized, &program)) { return nullptr; }
+  return std::make_shared<NativeExecutable>(name, std::move(program));
+}
+
+REGISTER_EXECUTABLE_LOADER(XrtEngine::NATIVE, LoadNativeExecutable);
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
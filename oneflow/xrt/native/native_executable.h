@@ -0,0 +1,53 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_NATIVE_NATIVE_EXECUTABLE_H_
+#define ONEFLOW_XRT_NATIVE_NATIVE_EXECUTABLE_H_
+
+#include <vector>
+
+#include "oneflow/xrt/executable.h"
+#include "oneflow/xrt/native/native_program.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+class NativeExecutable : public Executable {
+ public:
+  NativeExecutable(const std::string &name, NativeProgram &&program)
+      : Executable(name, XrtEngine::NATIVE), program_(std::move(program)) {}
+  virtual ~NativeExecutable() = default;
+
+  bool Run(const std::vector<Parameter> &inputs, const ExecutableRunOptions &run_options,
+           bool block_until_done = true) override;
+
+  int64_t FootprintBytes() const override;
+
+  bool SerializeToString(std::string *serialized) const override;
+
+  const NativeProgram &program() const { return program_; }
+
+ private:
+  NativeProgram program_;
+  // Scratch memory of the temporary buffers, which is kept across runs.
+  std::vector<char> temp_storage_;
+};
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_NATIVE_NATIVE_EXECUTABLE_H_
@@ -0,0 +1,171 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cmath>
+#include <random>
+
+#include "oneflow/xrt/native/native_builder.h"
+#include "oneflow/xrt/native/native_executable.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+namespace {
+
+template<typename T>
+std::vector<T> RandomVector(int64_t size, std::mt19937 *gen) {
+  std::uniform_real_distribution<T> dis(-2, 2);
+  std::vector<T> vec(size);
+  for (T &val : vec) { val = dis(*gen); }
+  return vec;
+}
+
+template<typename T>
+Parameter MakeParameter(std::vector<T> *data, const Shape &shape) {
+  CHECK_EQ(data->size(), shape.elem_cnt());
+  return Parameter(data->data(), shape, GetDataType<T>::value);
+}
+
+void RunExecutable(NativeExecutable *executable, const std::vector<Parameter> &inputs,
+                   const std::vector<Parameter> &outputs) {
+  ExecutableRunOptions run_options;
+  run_options.return_params = outputs;
+  ASSERT_TRUE(executable->Run(inputs, run_options));
+}
+
+template<typename T>
+void CheckNear(const std::vector<T> &out, const std::vector<T> &expected) {
+  ASSERT_EQ(out.size(), expected.size());
+  FOR_RANGE(size_t, i, 0, out.size()) { ASSERT_NEAR(out[i], expected[i], 1e-4) << i; }
+}
+
+template<typename T>
+T Gelu(T x) {
+  return static_cast<T>(0.5) * x * (1 + std::erf(x / std::sqrt(static_cast<T>(2))));
+}
+
+// gelu(x * w + bias) with x: (m, k), w: (k, n) and bias: (n), the large m
+// spans several loop blocks.
+template<typename T>
+void TestDenseGelu() {
+  const int64_t m = 67, k = 13, n = 9;
+  std::mt19937 gen(0);
+  std::vector<T> x = RandomVector<T>(m * k, &gen);
+  std::vector<T> w = RandomVector<T>(k * n, &gen);
+  std::vector<T> bias = RandomVector<T>(n, &gen);
+  std::vector<T> expected(m * n);
+  FOR_RANGE(int64_t, i, 0, m) {
+    FOR_RANGE(int64_t, j, 0, n) {
+      T sum = 0;
+      FOR_RANGE(int64_t, p, 0, k) { sum += x[i * k + p] * w[p * n + j]; }
+      expected[i * n + j] = Gelu(sum + bias[j]);
+    }
+  }
+
+  NativeBuilder builder("dense_gelu", GetDataType<T>::value);
+  NativeValue h = builder.MatMul(builder.Parameter(0, Shape({m, k})),
+                                 builder.Parameter(1, Shape({k, n})), false, false);
+  h = builder.Binary(NativeOpCode::kAdd, h, builder.Parameter(2, Shape({n})));
+  h = builder.Unary(NativeOpCode::kGelu, h);
+  NativeExecutable executable("dense_gelu", builder.Build({h}));
+
+  std::vector<T> out(m * n);
+  RunExecutable(&executable,
+                {MakeParameter(&x, Shape({m, k})), MakeParameter(&w, Shape({k, n})),
+                 MakeParameter(&bias, Shape({n}))},
+                {MakeParameter(&out, Shape({m, n}))});
+  CheckNear(out, expected);
+}
+
+}  // namespace
+
+TEST(NativeExecutable, dense_gelu_float) { TestDenseGelu<float>(); }
+
+TEST(NativeExecutable, dense_gelu_double) { TestDenseGelu<double>(); }
+
+TEST(NativeExecutable, broadcast_and_reduce) {
+  // sum over axis 0 and mean over axis 2 of leaky_relu(x / y) * 3 with
+  // x: (4, 5, 6) and y: (5, 1)
+  const int64_t d0 = 4, d1 = 5, d2 = 6;
+  std::mt19937 gen(1);
+  std::vector<float> x = RandomVector<float>(d0 * d1 * d2, &gen);
+  std::vector<float> y = RandomVector<float>(d1, &gen);
+  for (float &val : y) { val = std::abs(val) + 0.5f; }
+  std::vector<float> expected_sum(d1 * d2, 0), expected_mean(d0 * d1, 0);
+  FOR_RANGE(int64_t, i, 0, d0) {
+    FOR_RANGE(int64_t, j, 0, d1) {
+      FOR_RANGE(int64_t, l, 0, d2) {
+        float val = x[(i * d1 + j) * d2 + l] / y[j];
+        val = (val > 0 ? val : val * 0.1f) * 3;
+        expected_sum[j * d2 + l] += val;
+        expected_mean[i * d1 + j] += val / d2;
+      }
+    }
+  }
+
+  NativeBuilder builder("broadcast_and_reduce", DataType::kFloat);
+  NativeValue v = builder.Binary(NativeOpCode::kDiv, builder.Parameter(0, Shape({d0, d1, d2})),
+                                 builder.Parameter(1, Shape({d1, 1})));
+  v = builder.Unary(NativeOpCode::kLeakyRelu, v, 0.1);
+  v = builder.BinaryScalar(NativeOpCode::kMul, v, 3);
+  NativeValue sum = builder.Reshape(builder.ReduceSum(v, {0}), Shape({d1, d2}));
+  NativeValue mean = builder.Reshape(builder.ReduceMean(v, {2}), Shape({d0, d1}));
+  NativeExecutable executable("broadcast_and_reduce", builder.Build({sum, mean}));
+
+  std::vector<float> out_sum(d1 * d2), out_mean(d0 * d1);
+  // the temporaries are kept across runs, so the second run must not see the first one
+  FOR_RANGE(int, run, 0, 2) {
+    RunExecutable(&executable,
+                  {MakeParameter(&x, Shape({d0, d1, d2})), MakeParameter(&y, Shape({d1, 1}))},
+                  {MakeParameter(&out_sum, Shape({d1, d2})),
+                   MakeParameter(&out_mean, Shape({d0, d1}))});
+    CheckNear(out_sum, expected_sum);
+    CheckNear(out_mean, expected_mean);
+  }
+}
+
+TEST(NativeExecutable, serialize_round_trip) {
+  const int64_t m = 8, n = 4;
+  std::mt19937 gen(2);
+  std::vector<float> a = RandomVector<float>(m * n, &gen);
+  std::vector<float> b = RandomVector<float>(m * n, &gen);
+
+  NativeBuilder builder("round_trip", DataType::kFloat);
+  NativeValue p = builder.Parameter(0, Shape({m, n}));
+  NativeValue q = builder.Parameter(1, Shape({n, m}));
+  NativeValue t = builder.Unary(NativeOpCode::kTanh, builder.MatMul(p, q, false, false));
+  NativeValue s = builder.Unary(NativeOpCode::kSigmoid, t);
+  NativeValue out = builder.Binary(NativeOpCode::kSub, t, s);
+  NativeExecutable executable("round_trip", builder.Build({out}));
+  std::string serialized;
+  ASSERT_TRUE(executable.SerializeToString(&serialized));
+  NativeProgram program;
+  ASSERT_TRUE(DeserializeNativeProgram(serialized, &program));
+  ASSERT_FALSE(DeserializeNativeProgram(serialized.substr(0, serialized.size() / 2), &program));
+  ASSERT_TRUE(DeserializeNativeProgram(serialized, &program));
+  NativeExecutable restored("round_trip", std::move(program));
+
+  std::vector<float> expected(m * m), out_restored(m * m);
+  const std::vector<Parameter> inputs = {MakeParameter(&a, Shape({m, n})),
+                                         MakeParameter(&b, Shape({n, m}))};
+  RunExecutable(&executable, inputs, {MakeParameter(&expected, Shape({m, m}))});
+  RunExecutable(&restored, inputs, {MakeParameter(&out_restored, Shape({m, m}))});
+  ASSERT_EQ(out_restored, expected);
+}
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
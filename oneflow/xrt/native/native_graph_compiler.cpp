@@ -0,0 +1,117 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/native_graph_compiler.h"
+#include "oneflow/xrt/node_util.h"
+#include "oneflow/xrt/native/ops/op_kernel.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+void NativeGraphCompiler::PopulateEntryParams(const std::vector<Parameter> &entry_params) {
+  for (int i = 0; i < entry_params.size(); ++i) {
+    Argument arg = ArgFromParameter(entry_params[i]);
+    operands_[arg] = builder_->Parameter(i, entry_params[i].shape());
+  }
+}
+
+Argument NativeGraphCompiler::ArgFromParameter(const Parameter &param) {
+  return Argument(param.name(), param.shape(), param.data_type());
+}
+
+void NativeGraphCompiler::SetupKernelContextParam(const XrtNode *node,
+                                                  NativeOpContext::Param *context_param) {
+  util::Map<Argument, NativeValue> input_ops;
+  util::Map<std::string /* produce/consume key */, Argument> input_output_args;
+  std::vector<std::string> output_names;
+  for (const XrtEdge *edge : node->in_edges()) {
+    if (!edge->IsControlEdge()) {
+      const Argument &arg = edge->argument();
+      CHECK_GT(operands_.count(arg), 0);
+      input_ops.emplace(arg, operands_.at(arg));
+      const std::string &k = arg.meta_data().consume_key;
+      input_output_args.emplace(k, arg);
+    }
+  }
+  for (const XrtEdge *edge : node->out_edges()) {
+    if (!edge->IsControlEdge()) {
+      const Argument &arg = edge->argument();
+      const std::string &k = arg.meta_data().produce_key;
+      input_output_args.emplace(k, arg);
+      output_names.push_back(k);
+    }
+  }
+
+  size_t num_outputs = input_output_args.size() - input_ops.size();
+  CHECK_GE(num_outputs, 0) << "Outputs number should >= 0.";
+  context_param->builder = builder_.get();
+  context_param->message = OpMessage(node);
+  context_param->arguments = std::move(input_output_args);
+  context_param->inputs = std::move(input_ops);
+  context_param->output_names = std::move(output_names);
+  context_param->num_outputs = num_outputs;
+}
+
+std::shared_ptr<Executable> NativeGraphCompiler::Compile(
+    const XrtGraph *graph, const std::vector<Parameter> &entry_params,
+    const std::vector<Parameter> &return_params, const std::vector<InputOutputAlias> &aliases) {
+  CHECK_EQ(this->device_, XrtDevice::CPU_X86) << "Native engine only runs on host.";
+  // Return buffers are written before all the entries are read. No native op
+  // kernel registers mutable variables, so there are no aliases.
+  CHECK(aliases.empty()) << "Native engine does not support mutable inputs.";
+  CHECK(!entry_params.empty() || !return_params.empty());
+  const DataType data_type =
+      entry_params.empty() ? return_params.front().data_type() : entry_params.front().data_type();
+  // The clustering only folds nodes of one supported data type.
+  for (const auto *params : {&entry_params, &return_params}) {
+    for (const Parameter &param : *params) {
+      CHECK_EQ(param.data_type(), data_type)
+          << "Native engine requires all the parameters of " << this->name_
+          << " to have the same data type.";
+    }
+  }
+  builder_ = std::make_shared<NativeBuilder>(this->name_, data_type);
+  PopulateEntryParams(entry_params);
+
+  algorithm::TopologyVisit(*graph, [&](const XrtNode *node) {
+    NativeOpContext::Param param;
+    SetupKernelContextParam(node, &param);
+    NativeOpContext op_context(param);
+    // Do compile
+    auto op_kernel = BuildOpKernel(node->type());
+    op_kernel->Compile(&op_context);
+
+    // Always insert the new output into `operands_`.
+    const auto &outputs = op_context.outputs();
+    for (auto it = outputs.begin(); it != outputs.end(); ++it) {
+      operands_[it->first] = it->second;
+    }
+  });
+
+  std::vector<NativeValue> returns(return_params.size());
+  for (int i = 0; i < return_params.size(); ++i) {
+    Argument arg = ArgFromParameter(return_params[i]);
+    CHECK_GT(operands_.count(arg), 0);
+    returns[i] = operands_.at(arg);
+  }
+  return std::make_shared<NativeExecutable>(builder_->name(), builder_->Build(returns));
+}
+
+REGISTER_GRAPH_COMPILER(XrtEngine::NATIVE, NativeGraphCompiler);
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
@@ -0,0 +1,169 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/native_program.h"
+
+#include <cstring>
+#include <type_traits>
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+namespace {
+
+class ProgramWriter {
+ public:
+  explicit ProgramWriter(std::string *out) : out_(out) {}
+
+  template<typename T>
+  void Write(const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value, "");
+    out_->append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  template<typename T>
+  void WriteVector(const std::vector<T> &values) {
+    Write<int64_t>(values.size());
+    for (const T &value : values) { Write(value); }
+  }
+
+  void Write(const NativeIndexMapping &mapping) {
+    WriteVector(mapping.dst_strides);
+    WriteVector(mapping.src_strides);
+  }
+
+  void Write(const NativeLoad &load) {
+    Write(load.buffer);
+    Write(load.contiguous);
+    Write(load.mapping);
+  }
+
+  void Write(const NativeStage &stage) {
+    Write(stage.kind);
+    Write(stage.out);
+    Write(stage.elem_cnt);
+    WriteVector(stage.instrs);
+    WriteVector(stage.loads);
+    Write(stage.reduce);
+    Write(stage.reduce_mapping);
+    Write(stage.reduce_out_elem_cnt);
+    Write(stage.reduce_scale);
+    Write(stage.a);
+    Write(stage.b);
+    Write(stage.batch_size);
+    Write(stage.m);
+    Write(stage.n);
+    Write(stage.k);
+    Write(stage.transpose_a);
+    Write(stage.transpose_b);
+    Write(stage.src);
+    Write(stage.byte_size);
+  }
+
+ private:
+  std::string *out_;
+};
+
+class ProgramReader {
+ public:
+  explicit ProgramReader(const std::string &in) : in_(in) {}
+
+  bool ok() const { return ok_ && offset_ == in_.size(); }
+
+  template<typename T>
+  void Read(T *value) {
+    static_assert(std::is_trivially_copyable<T>::value, "");
+    if (!ok_ || offset_ + sizeof(T) > in_.size()) {
+      ok_ = false;
+      return;
+    }
+    std::memcpy(value, in_.data() + offset_, sizeof(T));
+    offset_ += sizeof(T);
+  }
+
+  template<typename T>
+  void ReadVector(std::vector<T> *values) {
+    int64_t size = 0;
+    Read(&size);
+    // Every element takes at least one byte.
+    if (!ok_ || size < 0 || size > in_.size() - offset_) {
+      ok_ = false;
+      return;
+    }
+    values->resize(size);
+    for (T &value : *values) { Read(&value); }
+  }
+
+  void Read(NativeIndexMapping *mapping) {
+    ReadVector(&mapping->dst_strides);
+    ReadVector(&mapping->src_strides);
+  }
+
+  void Read(NativeLoad *load) {
+    Read(&load->buffer);
+    Read(&load->contiguous);
+    Read(&load->mapping);
+  }
+
+  void Read(NativeStage *stage) {
+    Read(&stage->kind);
+    Read(&stage->out);
+    Read(&stage->elem_cnt);
+    ReadVector(&stage->instrs);
+    ReadVector(&stage->loads);
+    Read(&stage->reduce);
+    Read(&stage->reduce_mapping);
+    Read(&stage->reduce_out_elem_cnt);
+    Read(&stage->reduce_scale);
+    Read(&stage->a);
+    Read(&stage->b);
+    Read(&stage->batch_size);
+    Read(&stage->m);
+    Read(&stage->n);
+    Read(&stage->k);
+    Read(&stage->transpose_a);
+    Read(&stage->transpose_b);
+    Read(&stage->src);
+    Read(&stage->byte_size);
+  }
+
+ private:
+  const std::string &in_;
+  size_t offset_ = 0;
+  bool ok_ = true;
+};
+
+}  // namespace
+
+void SerializeNativeProgram(const NativeProgram &program, std::string *serialized) {
+  serialized->clear();
+  ProgramWriter writer(serialized);
+  writer.Write(program.data_type);
+  writer.WriteVector(program.stages);
+  writer.Write(program.temp_byte_size);
+}
+
+bool DeserializeNativeProgram(const std::string &serialized, NativeProgram *program) {
+  ProgramReader reader(serialized);
+  reader.Read(&program->data_type);
+  reader.ReadVector(&program->stages);
+  reader.Read(&program->temp_byte_size);
+  return reader.ok();
+}
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
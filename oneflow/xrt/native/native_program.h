@@ -0,0 +1,122 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_NATIVE_NATIVE_PROGRAM_H_
+#define ONEFLOW_XRT_NATIVE_NATIVE_PROGRAM_H_
+
+#include <string>
+#include <vector>
+
+#include "oneflow/core/common/data_type.pb.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+enum class NativeOpCode : int32_t {
+  kLoad = 0,
+  // Unary operations, `scalar` is the alpha of kLeakyRelu.
+  kIdentity,
+  kRelu,
+  kLeakyRelu,
+  kSigmoid,
+  kTanh,
+  kGelu,
+  // Binary operations, the right hand side is `scalar` if `rhs` is negative.
+  kAdd,
+  kSub,
+  kMul,
+  kDiv,
+};
+
+// Where a buffer lives at runtime. Entry and return buffers are the parameters
+// of `Executable::Run`, temporary buffers are slices of the executable scratch
+// memory which are reused by the values whose live ranges do not overlap.
+struct NativeBuffer {
+  enum Kind { kEntry = 0, kReturn, kTemp };
+  Kind kind = kTemp;
+  // Parameter index for kEntry and kReturn, byte offset for kTemp.
+  int64_t index = -1;
+};
+
+// Maps the linear index of the loop iteration space to the linear index of a
+// buffer. Broadcast axes have zero `src_strides`.
+struct NativeIndexMapping {
+  std::vector<int64_t> dst_strides;
+  std::vector<int64_t> src_strides;
+};
+
+struct NativeLoad {
+  NativeBuffer buffer;
+  bool contiguous = true;
+  NativeIndexMapping mapping;
+};
+
+struct NativeInstr {
+  NativeOpCode op = NativeOpCode::kIdentity;
+  int32_t lhs = -1;
+  int32_t rhs = -1;
+  int32_t load = -1;
+  double scalar = 0;
+};
+
+struct NativeStage {
+  enum Kind { kLoop = 0, kMatMul, kCopy };
+  Kind kind = kLoop;
+  NativeBuffer out;
+
+  // kLoop. The instructions are evaluated block by block over `elem_cnt` elements
+  // and the result of the last one is stored to `out`, or accumulated into it
+  // through `reduce_mapping` if `reduce` is set.
+  int64_t elem_cnt = 0;
+  std::vector<NativeInstr> instrs;
+  std::vector<NativeLoad> loads;
+  bool reduce = false;
+  NativeIndexMapping reduce_mapping;
+  int64_t reduce_out_elem_cnt = 0;
+  double reduce_scale = 1.0;
+
+  // kMatMul
+  NativeBuffer a;
+  NativeBuffer b;
+  int64_t batch_size = 1;
+  int64_t m = 0;
+  int64_t n = 0;
+  int64_t k = 0;
+  bool transpose_a = false;
+  bool transpose_b = false;
+
+  // kCopy
+  NativeBuffer src;
+  int64_t byte_size = 0;
+};
+
+struct NativeProgram {
+  DataType data_type = DataType::kFloat;
+  std::vector<NativeStage> stages;
+  int64_t temp_byte_size = 0;
+};
+
+// Binary serialization for the persistent compilation cache. The layout is
+// only meant to be read by the same build.
+void SerializeNativeProgram(const NativeProgram &program, std::string *serialized);
+// Returns false if `serialized` is malformed.
+bool DeserializeNativeProgram(const std::string &serialized, NativeProgram *program);
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_NATIVE_NATIVE_PROGRAM_H_
@@ -0,0 +1,128 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/ops/op_context.h"
+#include "oneflow/xrt/native/ops/op_kernel.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+template<NativeOpCode op>
+class UnaryOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    ctx->SetSoleOutput(ctx->builder()->Unary(op, ctx->SoleInput()));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(Identity, UnaryOp<NativeOpCode::kIdentity>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(Relu, UnaryOp<NativeOpCode::kRelu>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(Sigmoid, UnaryOp<NativeOpCode::kSigmoid>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(Tanh, UnaryOp<NativeOpCode::kTanh>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(Gelu, UnaryOp<NativeOpCode::kGelu>).Finalize();
+
+class LeakyReluOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    const float alpha = ctx->Attr<float>("alpha");
+    ctx->SetSoleOutput(ctx->builder()->Unary(NativeOpCode::kLeakyRelu, ctx->SoleInput(), alpha));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(LeakyRelu, LeakyReluOp).Finalize();
+
+template<NativeOpCode op>
+class ScalarBinaryOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    double scalar = 0;
+    if (ctx->Attr<bool>("has_int_operand")) {
+      scalar = static_cast<double>(ctx->Attr<int64_t>("int_operand"));
+    } else if (ctx->Attr<bool>("has_float_operand")) {
+      scalar = ctx->Attr<double>("float_operand");
+    }
+    ctx->SetSoleOutput(ctx->builder()->BinaryScalar(op, ctx->SoleInput(), scalar));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(ScalarAdd, ScalarBinaryOp<NativeOpCode::kAdd>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(ScalarMul, ScalarBinaryOp<NativeOpCode::kMul>).Finalize();
+
+template<NativeOpCode op>
+class BcastBinaryOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    ctx->SetOutput("z_0", ctx->builder()->Binary(op, ctx->Input("x_0"), ctx->Input("y_0")));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(BcastAdd, BcastBinaryOp<NativeOpCode::kAdd>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(BcastMul, BcastBinaryOp<NativeOpCode::kMul>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(BcastDiv, BcastBinaryOp<NativeOpCode::kDiv>).Finalize();
+
+class MultiplyOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    CHECK_EQ(ctx->InputShape("x_0"), ctx->InputShape("y_0"));
+    ctx->SetOutput("out_0", ctx->builder()->Binary(NativeOpCode::kMul, ctx->Input("x_0"),
+                                                   ctx->Input("y_0")));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(Multiply, MultiplyOp).Finalize();
+
+class AddOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    int num_inputs = ctx->num_inputs();
+    CHECK_GT(num_inputs, 0);
+    Shape shape = ctx->InputShape("in_0");
+    NativeValue sum = ctx->Input("in_0");
+    for (int i = 1; i < num_inputs; ++i) {
+      std::string name = "in_" + std::to_string(i);
+      CHECK_EQ(shape, ctx->InputShape(name));
+      sum = ctx->builder()->Binary(NativeOpCode::kAdd, sum, ctx->Input(name));
+    }
+    ctx->SetSoleOutput(sum);
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(Add, AddOp).Finalize();
+
+class BiasAddOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    Shape in_shape = ctx->InputShape("a_0");
+    Shape bias_shape = ctx->InputShape("b_0");
+    CHECK_EQ(bias_shape.NumAxes(), 1);
+    CHECK_EQ(ctx->InputType("a_0"), ctx->InputType("b_0"));
+    int32_t axis = ctx->Attr<int32_t>("axis");
+    if (axis < 0) { axis += in_shape.NumAxes(); }
+    CHECK_EQ(in_shape.At(axis), bias_shape.At(0));
+    // View the bias as [1, ..., C, ..., 1] to broadcast it along `axis`.
+    DimVector dim_vec(in_shape.NumAxes(), 1);
+    dim_vec[axis] = bias_shape.At(0);
+    NativeValue bias = ctx->builder()->Reshape(ctx->Input("b_0"), Shape(dim_vec));
+    ctx->SetOutput("out_0",
+                   ctx->builder()->Binary(NativeOpCode::kAdd, ctx->Input("a_0"), bias));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(BiasAdd, BiasAddOp).Finalize();
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
@@ -0,0 +1,42 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/ops/op_context.h"
+#include "oneflow/xrt/native/ops/op_kernel.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+class MatMulOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    Shape a_shape = ctx->InputShape("a_0");
+    Shape b_shape = ctx->InputShape("b_0");
+    CHECK_GE(a_shape.NumAxes(), 2);
+    CHECK_EQ(a_shape.NumAxes(), b_shape.NumAxes());
+
+    bool transpose_a = ctx->Attr<bool>("transpose_a");
+    bool transpose_b = ctx->Attr<bool>("transpose_b");
+    ctx->SetOutput("out_0", ctx->builder()->MatMul(ctx->Input("a_0"), ctx->Input("b_0"),
+                                                   transpose_a, transpose_b));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(MatMul, MatMulOp).Finalize();
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
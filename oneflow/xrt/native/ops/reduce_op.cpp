@@ -0,0 +1,54 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <numeric>
+
+#include "oneflow/xrt/native/ops/op_context.h"
+#include "oneflow/xrt/native/ops/op_kernel.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+template<bool mean>
+class ReduceOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    std::vector<int32_t> axis = ctx->Attr<std::vector<int32_t>>("axis");
+    Shape in_shape = ctx->SoleInputShape();
+    for (int i = 0; i < axis.size(); ++i) {
+      if (axis[i] < 0) { axis[i] += in_shape.NumAxes(); }
+    }
+    if (axis.empty()) {
+      axis.resize(in_shape.NumAxes());
+      std::iota(axis.begin(), axis.end(), 0);
+    }
+    std::sort(axis.begin(), axis.end());
+    axis.erase(std::unique(axis.begin(), axis.end()), axis.end());
+
+    NativeBuilder *builder = ctx->builder();
+    NativeValue output = mean ? builder->ReduceMean(ctx->SoleInput(), axis)
+                              : builder->ReduceSum(ctx->SoleInput(), axis);
+    // The reduced axes are kept as 1, reshape to the shape with or without them.
+    ctx->SetSoleOutput(builder->Reshape(output, ctx->SoleOutputShape()));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(ReduceSum, ReduceOp<false>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(ReduceMean, ReduceOp<true>).Finalize();
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
@@ -0,0 +1,51 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/ops/op_context.h"
+#include "oneflow/xrt/native/ops/op_kernel.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+class ReshapeOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    Shape in_shape = ctx->SoleInputShape();
+    Shape shape = ctx->SoleOutputShape();
+    CHECK_EQ(shape.Count(0), in_shape.Count(0));
+
+    ctx->SetSoleOutput(ctx->builder()->Reshape(ctx->SoleInput(), shape));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(Reshape, ReshapeOp).Finalize();
+
+class ReshapeLikeOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    Shape x_shape = ctx->InputShape("in_0");
+    Shape like_shape = ctx->InputShape("like_0");
+    CHECK_EQ(x_shape.Count(0), like_shape.Count(0));
+
+    ctx->SetOutput("out_0", ctx->builder()->Reshape(ctx->Input("in_0"), like_shape));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(ReshapeLike, ReshapeLikeOp).Finalize();
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
@@ -31,10 +31,29 @@ const PbMessage *OpMessage(const XrtNode *node) {
   return message;
 }
 
+// Returns true if all the data flows of the node share one of `data_types`,
+// which is empty if the op kernel supports any data type.
+static bool IsSupportedDataTypes(const XrtNode *node, const util::Set<DataType> &data_types) {
+  if (data_types.empty()) { return true; }
+  int num_data_types = 0;
+  DataType data_type = DataType::kInvalidDataType;
+  for (const auto *edges : {&node->in_edges(), &node->out_edges()}) {
+    for (const XrtEdge *edge : *edges) {
+      if (edge->IsControlEdge() || !edge->HasAttr("data_type")) { continue; }
+      const DataType &edge_data_type = edge->Attr<DataType>("data_type");
+      if (data_types.count(edge_data_type) == 0) { return false; }
+      if (num_data_types++ > 0 && edge_data_type != data_type) { return false; }
+      data_type = edge_data_type;
+    }
+  }
+  return true;
+}
+
 bool IsCompiledNode(const XrtNode *node, const XrtEngine &engine, const bool train_phase) {
   auto field = MakeXrtField(node->device(), engine);
   return OpKernelRegistered(node->type(), field)
-         && (!train_phase || TrainPhaseEnabled(node->type(), field));
+         && (!train_phase || TrainPhaseEnabled(node->type(), field))
+         && IsSupportedDataTypes(node, SupportedDataTypes(node->type(), field));
 }
 
 bool IsOptimizerNode(const XrtNode *node, const XrtEngine &engine) {
@@ -199,9 +199,11 @@ void MarkClusterIdPass::Run(XrtGraph *graph, const XrtPassOptions &options) {
   if (clustering_options.train_phase) {
     ClusteringSubgraphs(clustering_options, XrtEngine::XLA);
     ClusteringSubgraphs(clustering_options, XrtEngine::TENSORRT);
+    ClusteringSubgraphs(clustering_options, XrtEngine::NATIVE);
   } else {
     ClusteringSubgraphs(clustering_options, XrtEngine::TENSORRT);
     ClusteringSubgraphs(clustering_options, XrtEngine::XLA);
+    ClusteringSubgraphs(clustering_options, XrtEngine::NATIVE);
   }
 
   RemoveInvalidClusterNodes(clustering_options);
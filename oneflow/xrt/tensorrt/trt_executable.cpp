@@ -15,8 +15,12 @@ limitations under the License.
 */
 #include "oneflow/xrt/tensorrt/trt_executable.h"
 #include "oneflow/xrt/tensorrt/trt_int8_calibrator.h"
+#include "oneflow/xrt/tensorrt/trt_logger.h"
+#include "oneflow/xrt/compilation_cache.h"
 #include "oneflow/xrt/platform.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include "cuda_runtime.h"
@@ -27,6 +31,33 @@ namespace xrt {
 
 namespace tensorrt {
 
+namespace {
+
+uint64_t WeightDigest(const uint8_t *data, size_t size) {
+  // FNV-1a
+  uint64_t digest = 14695981039346656037ULL;
+  for (size_t i = 0; i < size; ++i) {
+    digest ^= data[i];
+    digest *= 1099511628211ULL;
+  }
+  return digest;
+}
+
+template<typename T>
+void AppendValue(const T &value, std::string *out) {
+  out->append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template<typename T>
+bool ConsumeValue(const std::string &in, size_t *offset, T *value) {
+  if (*offset + sizeof(T) > in.size()) { return false; }
+  std::memcpy(value, in.data() + *offset, sizeof(T));
+  *offset += sizeof(T);
+  return true;
+}
+
+}  // namespace
+
 nvinfer1::ICudaEngine *TrtExecutable::CreateExecutableEngine(
     const ExecutableRunOptions &run_options, const int batch_size /*= 1*/,
     TRTInt8Calibrator *calibrator /*= nullptr*/) {
@@ -142,7 +173,8 @@ bool TrtExecutable::Run(const std::vector<Parameter> &inputs,
   }
   // TODO(hjchen2): Check batch size is same for all binding parameters.
   const int batch_size = binding_params[0]->shape().At(0);
-  if (batch_size > engine_->getMaxBatchSize()) {
+  // The engine restored from the compilation cache can not be rebuilt.
+  if (builder_ && batch_size > engine_->getMaxBatchSize()) {
     LOG(WARNING) << "Rebuild engine since the maximum batch size "  // NOLINT
                  << engine_->getMaxBatchSize()                      // NOLINT
                  << " is less than the input batch size " << batch_size;
@@ -186,6 +218,64 @@ bool TrtExecutable::Run(const std::vector<Parameter> &inputs,
                        block_until_done);
 }
 
+int64_t TrtExecutable::FootprintBytes() const {
+  int64_t footprint_bytes = engine_ ? engine_->getDeviceMemorySize() : 0;
+  for (const auto &pair : host_weights_) { footprint_bytes += pair.second->size(); }
+  return footprint_bytes;
+}
+
+bool TrtExecutable::SerializeToString(std::string *serialized) const {
+  if (!engine_) { return false; }
+  auto engine_data = nv::unique_ptr<nvinfer1::IHostMemory>(engine_->serialize());
+  if (!engine_data) { return false; }
+  serialized->clear();
+  AppendValue<int64_t>(host_weights_.size(), serialized);
+  for (const auto &pair : host_weights_) {
+    AppendValue<int64_t>(pair.first.size(), serialized);
+    serialized->append(pair.first);
+    AppendValue(WeightDigest(pair.second->data(), pair.second->size()), serialized);
+  }
+  serialized->append(static_cast<const char *>(engine_data->data()), engine_data->size());
+  return true;
+}
+
+std::shared_ptr<Executable> LoadTrtExecutable(const std::string &name,
+                                              const std::string &serialized,
+                                              const std::vector<Parameter> &entry_params) {
+  size_t offset = 0;
+  int64_t num_weights = 0;
+  if (!ConsumeValue(serialized, &offset, &num_weights)) { return nullptr; }
+  for (int64_t i = 0; i < num_weights; ++i) {
+    int64_t name_size = 0;
+    uint64_t digest = 0;
+    if (!ConsumeValue(serialized, &offset, &name_size)
+        || offset + name_size > serialized.size()) {
+      return nullptr;
+    }
+    const std::string weight_name = serialized.substr(offset, name_size);
+    offset += name_size;
+    if (!ConsumeValue(serialized, &offset, &digest)) { return nullptr; }
+    // The engine is stale if any weight has been changed.
+    auto it = std::find_if(entry_params.begin(), entry_params.end(),
+                           [&](const Parameter &param) { return param.name() == weight_name; });
+    if (it == entry_params.end()) { return nullptr; }
+    std::vector<uint8_t> host_data(it->byte_size());
+    CHECK_EQ(cudaSuccess,
+             cudaMemcpy(host_data.data(), it->data(), host_data.size(), cudaMemcpyDefault));
+    if (WeightDigest(host_data.data(), host_data.size()) != digest) { return nullptr; }
+  }
+
+  static nv::Logger logger;
+  static nv::unique_ptr<nvinfer1::IRuntime> runtime(nvinfer1::createInferRuntime(logger));
+  nv::unique_ptr<nvinfer1::ICudaEngine> engine(runtime->deserializeCudaEngine(
+      serialized.data() + offset, serialized.size() - offset, nullptr));
+  if (!engine) { return nullptr; }
+  return std::make_shared<TrtExecutable>(
+      name, std::move(engine), util::Map<std::string, std::shared_ptr<std::vector<uint8_t>>>{});
+}
+
+REGISTER_EXECUTABLE_LOADER(XrtEngine::TENSORRT, LoadTrtExecutable);
+
 }  // namespace tensorrt
 
 }  // namespace xrt
@@ -53,6 +53,12 @@ class TrtExecutable : public Executable {
   bool Run(const std::vector<Parameter> &inputs, const ExecutableRunOptions &run_options,
            bool block_until_done = true) override;
 
+  int64_t FootprintBytes() const override;
+
+  // The digests of the weights are serialized along with the engine, since the
+  // weights are built into the engine.
+  bool SerializeToString(std::string *serialized) const override;
+
  private:
   nvinfer1::ICudaEngine *CreateExecutableEngine(const ExecutableRunOptions &run_options,
                                                 const int batch_size = 1,
@@ -56,6 +56,7 @@ constexpr char _XrtOutArgumentPrefix[] = "_output_argument_";
 constexpr char MutableVariablesAttrName[] = "MutableVariables";
 constexpr char IsOptimizerOpAttrName[] = "IsOptimizerOp";
 constexpr char TrainPhaseEnabledAttrName[] = "TrainPhaseEnabled";
+constexpr char SupportedDataTypesAttrName[] = "SupportedDataTypes";
 
 inline XrtField MakeXrtField(const XrtDevice &device, const XrtEngine &engine) {
   XrtField field;
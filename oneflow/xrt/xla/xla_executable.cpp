@@ -67,6 +67,11 @@ bool XlaExecutable::Run(const std::vector<Parameter> &inputs,
   return true /*Success*/;
 }
 
+int64_t XlaExecutable::FootprintBytes() const {
+  // It returns -1 if the size of the generated code is unknown.
+  return std::max<int64_t>(executable_->executable()->SizeOfGeneratedCodeInBytes(), 0);
+}
+
 }  // namespace mola
 }  // namespace xrt
 }  // namespace oneflow
@@ -39,6 +39,8 @@ class XlaExecutable : public Executable {
   bool Run(const std::vector<Parameter> &inputs, const ExecutableRunOptions &run_options,
            bool block_until_done = true) override;
 
+  int64_t FootprintBytes() const override;
+
  private:
   XrtDevice device_;
 